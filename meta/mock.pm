@@ -0,0 +1,524 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2024 Microsoft Open Technologies, Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+#    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+#    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+#    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+#    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+#
+#    See the Apache Version 2.0 License for specific language governing
+#    permissions and limitations under the License.
+#
+#    Microsoft would like to thank the following companies for their review and
+#    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+#    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+#
+# @file    mock.pm
+#
+# @brief   This module defines SAI Metadata Mock Library Generator
+#
+
+package mock;
+
+use strict;
+use warnings;
+use diagnostics;
+use Data::Dumper;
+use utils;
+use xmlutils;
+
+require Exporter;
+
+#
+# Global functions implemented by hand in saimockutils.c, they keep object
+# store, configuration and dump.
+#
+
+my %MOCK_MANUAL_GLOBAL_APIS = map { $_ => 1 } qw/
+    sai_api_initialize
+    sai_api_query
+    sai_api_uninitialize
+    sai_bulk_get_attribute
+    sai_bulk_object_clear_stats
+    sai_bulk_object_get_stats
+    sai_dbg_generate_dump
+    sai_get_maximum_attribute_count
+    sai_get_object_count
+    sai_get_object_key
+    sai_log_set
+    sai_object_type_get_availability
+    sai_object_type_query
+    sai_query_api_version
+    sai_switch_id_query
+    /;
+
+my %MOCK_OBJECT_TYPE_API = ();
+
+sub GetMockArgs
+{
+    my $params = shift;
+
+    $params =~ s/^\s*\(//;
+    $params =~ s/\)\s*$//;
+    $params = Trim($params);
+
+    return () if $params eq "void" or $params eq "";
+
+    my @args = ();
+
+    for my $param (split/,/, $params)
+    {
+        if (not $param =~ /(\w+)\s*(\[\w*\])?\s*$/)
+        {
+            LogError "failed to extract argument name from '$param'";
+            next;
+        }
+
+        push @args, { decl => Trim($param), name => $1 };
+    }
+
+    return @args;
+}
+
+sub WriteMockFunctionHeader
+{
+    my ($function, @args) = @_;
+
+    if (scalar @args == 0)
+    {
+        WriteMock "$function(void)";
+        return;
+    }
+
+    WriteMock "$function(";
+
+    my @decls = map { "    $_->{decl}" } @args;
+
+    WriteMock "$_," for @decls[0 .. $#decls - 1];
+    WriteMock "$decls[-1])";
+}
+
+sub GetMockObjectType
+{
+    my ($name, $params) = @_;
+
+    return "object_type" if $params =~ /\bsai_object_type_t object_type\b/;
+
+    return "SAI_OBJECT_TYPE_NULL" if not $name =~ /^(?:create|remove|set|get|clear)_(\w+?)(?:_attribute|_stats_ext|_stats)?$/;
+
+    my $ot = $1;
+
+    my $single = $ot;
+
+    $single =~ s/ies$/y/;
+
+    my $plural = $ot;
+
+    $plural =~ s/s$//;
+
+    for my $candidate ($ot, $single, $plural)
+    {
+        my $OT = "SAI_OBJECT_TYPE_" . uc($candidate);
+
+        return $OT if defined $main::OBJECT_TYPE_MAP{$OT};
+    }
+
+    return "SAI_OBJECT_TYPE_NULL";
+}
+
+#
+# Returns body of method table function, create/remove/set/get (single and
+# bulk) go to object store, statistics return zeros, everything else only
+# gets latency and failures injected. Object key is built the same way as
+# in trace.pm, methods not recognized there are handled as other.
+#
+
+sub GetMockBody
+{
+    my ($name, $params, $ot) = @_;
+
+    my @args = map { { name => $_->{name}, decl => ($_->{decl} =~ s/^_\w+_\s+//r) } } GetMockArgs($params);
+
+    my %args = map { $_->{name} => $_->{decl} } @args;
+
+    my $other = "return sai_mock_other($ot);";
+
+    return ($other) if $ot eq "SAI_OBJECT_TYPE_NULL" or not $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+    my $member = lc($1);
+
+    if ($name =~ /^get_\w+_stats(_ext)?$/ and defined $args{number_of_counters} and defined $args{counters})
+    {
+        return ("return sai_mock_stats($ot, number_of_counters, counters);");
+    }
+
+    if ($name =~ /^clear_\w+_stats$/)
+    {
+        return ("return sai_mock_stats($ot, 0, NULL);");
+    }
+
+    return ($other) if not $name =~ /^(create|remove|set|get)_/;
+
+    my $op = $1;
+
+    my $bulk = (defined $args{object_count} and defined $args{object_statuses});
+
+    my $switch = (($args{switch_id} // "") eq "sai_object_id_t switch_id") ? "switch_id" : "SAI_NULL_OBJECT_ID";
+
+    my @guard = ();
+
+    my $key;
+    my $out;
+
+    if (defined $main::NON_OBJECT_ID_STRUCTS{$ot})
+    {
+        my @entries = grep { $_->{decl} =~ /^const sai_${member}_t \*\w+$/ } @args;
+
+        if (scalar @entries != 1)
+        {
+            LogDebug "mocking $name as other, entry argument not found";
+            return ($other);
+        }
+
+        my $entry = $entries[0]->{name};
+
+        push @guard, "$entry == NULL";
+
+        $key = "objectkey.key.$member = " . ($bulk ? "$entry\[idx\]" : "*$entry") . ";";
+    }
+    elsif ($bulk)
+    {
+        if (not ($args{object_id} // "") =~ /^(const )?sai_object_id_t \*object_id$/)
+        {
+            LogDebug "mocking $name as other, object_id argument not found";
+            return ($other);
+        }
+
+        push @guard, "object_id == NULL";
+
+        $key = "objectkey.key.object_id = object_id[idx];" if $op ne "create";
+
+        $out = "object_id[idx]" if $op eq "create";
+    }
+    else
+    {
+        my $decl = $args[0]->{decl} // "";
+        my $oid = $args[0]->{name} // "";
+
+        if ($op eq "create" and $decl =~ /^sai_object_id_t \*\w+$/)
+        {
+            push @guard, "$oid == NULL";
+
+            $out = "*$oid";
+        }
+        elsif ($op ne "create" and $decl =~ /^sai_object_id_t \w+$/)
+        {
+            $key = "objectkey.key.object_id = $oid;";
+        }
+        else
+        {
+            LogDebug "mocking $name as other, object id argument not found";
+            return ($other);
+        }
+    }
+
+    my $call;
+
+    if ($op eq "create")
+    {
+        $call = $bulk
+            ? "sai_mock_bulk_create($switch, object_count, meta_key, attr_count, attr_list, mode, object_statuses)"
+            : "sai_mock_create(&meta_key, $switch, attr_count, attr_list)";
+    }
+    elsif ($op eq "remove")
+    {
+        $call = $bulk
+            ? "sai_mock_bulk_remove(object_count, meta_key, mode, object_statuses)"
+            : "sai_mock_remove(&meta_key)";
+    }
+    elsif ($op eq "set")
+    {
+        $call = $bulk
+            ? "sai_mock_bulk_set(object_count, meta_key, attr_list, mode, object_statuses)"
+            : "sai_mock_set(&meta_key, attr)";
+    }
+    else
+    {
+        $call = $bulk
+            ? "sai_mock_bulk_get(object_count, meta_key, attr_count, attr_list, mode, object_statuses)"
+            : "sai_mock_get(&meta_key, attr_count, attr_list)";
+    }
+
+    my @code = ();
+
+    if (not $bulk)
+    {
+        push @code, "sai_object_meta_key_t meta_key;";
+        push @code, "sai_status_t status;" if defined $out;
+        push @code, "";
+
+        if (scalar @guard)
+        {
+            push @code, "if (" . join(" || ", @guard) . ")";
+            push @code, "{";
+            push @code, "return SAI_STATUS_INVALID_PARAMETER;";
+            push @code, "}";
+            push @code, "";
+        }
+
+        push @code, "memset(&meta_key, 0, sizeof(meta_key));";
+        push @code, "meta_key.objecttype = $ot;";
+        push @code, "meta_key.$key" if defined $key;
+        push @code, "";
+
+        if (not defined $out)
+        {
+            push @code, "return $call;";
+            return @code;
+        }
+
+        push @code, "status = $call;";
+        push @code, "";
+        push @code, "if (status == SAI_STATUS_SUCCESS)";
+        push @code, "{";
+        push @code, "$out = meta_key.objectkey.key.object_id;";
+        push @code, "}";
+        push @code, "";
+        push @code, "return status;";
+
+        return @code;
+    }
+
+    push @guard, "object_count == 0", "object_statuses == NULL";
+
+    push @code, "sai_object_meta_key_t *meta_key;";
+    push @code, "sai_status_t status;";
+    push @code, "uint32_t idx;";
+    push @code, "";
+    push @code, "if (" . join(" || ", @guard) . ")";
+    push @code, "{";
+    push @code, "return SAI_STATUS_INVALID_PARAMETER;";
+    push @code, "}";
+    push @code, "";
+    push @code, "meta_key = (sai_object_meta_key_t*)calloc(object_count, sizeof(sai_object_meta_key_t));";
+    push @code, "";
+    push @code, "if (meta_key == NULL)";
+    push @code, "{";
+    push @code, "return SAI_STATUS_NO_MEMORY;";
+    push @code, "}";
+    push @code, "";
+    push @code, "for (idx = 0; idx < object_count; idx++)";
+    push @code, "{";
+    push @code, "meta_key[idx].objecttype = $ot;";
+    push @code, "meta_key[idx].$key" if defined $key;
+    push @code, "}";
+    push @code, "";
+    push @code, "status = $call;";
+    push @code, "";
+
+    if (defined $out)
+    {
+        push @code, "for (idx = 0; idx < object_count; idx++)";
+        push @code, "{";
+        push @code, "$out = meta_key[idx].objectkey.key.object_id;";
+        push @code, "}";
+        push @code, "";
+    }
+
+    push @code, "free(meta_key);";
+    push @code, "";
+    push @code, "return status;";
+
+    return @code;
+}
+
+sub CreateMockGlobalApis
+{
+    WriteMock "/* Global functions */";
+    WriteMock "";
+
+    for my $name (sort keys %main::GLOBAL_APIS)
+    {
+        next if defined $MOCK_MANUAL_GLOBAL_APIS{$name};
+
+        my $type = $main::GLOBAL_APIS{$name}{type};
+        my $params = $main::GLOBAL_APIS{$name}{args};
+
+        my @args = GetMockArgs($params);
+
+        WriteMockFunctionHeader("$type $name", @args);
+        WriteMock "{";
+
+        if ($type eq "sai_status_t")
+        {
+            my $ot = ($params =~ /\bsai_object_type_t object_type\b/) ? "object_type" : "SAI_OBJECT_TYPE_NULL";
+
+            WriteMock "return sai_mock_other($ot);";
+        }
+        else
+        {
+            WriteMock "return ($type)0;";
+        }
+
+        WriteMock "}";
+        WriteMock "";
+    }
+}
+
+sub CreateMockApis
+{
+    my @apis = @{ $main::SAI_ENUMS{sai_api_t}{values} };
+
+    my @tables = ();
+
+    for my $Api (@apis)
+    {
+        next if not $Api =~ /^SAI_API_(\w+)/;
+
+        my $api = lc($1);
+
+        next if $api =~ /unspecified/;
+
+        my $structname = "sai_${api}_api_t";
+
+        my %struct = ExtractStructInfo($structname, "struct_");
+
+        WriteMock "/* $structname */";
+        WriteMock "";
+
+        my @members = ();
+
+        for my $member (GetStructKeysInOrder(\%struct))
+        {
+            my $type = $struct{$member}{type};
+            my $name = $struct{$member}{name};
+
+            if (not defined $main::FUNCTION_DEF{$type})
+            {
+                LogError "function type $type is not defined for $api.$name";
+                next;
+            }
+
+            my $prototype = $main::FUNCTION_DEF{$type};
+
+            if (not $prototype =~ /^typedef (\S+)\(\* $type\) \((.+)\)$/)
+            {
+                LogError "failed to match function proto type $type is not defined for $api.$name";
+                next;
+            }
+
+            my $returntype = $1;
+            my $params = $2;
+
+            my $ot = GetMockObjectType($name, $params);
+
+            $MOCK_OBJECT_TYPE_API{$ot} //= $Api if $ot =~ /^SAI_OBJECT_TYPE_/ and $ot ne "SAI_OBJECT_TYPE_NULL";
+
+            WriteMockFunctionHeader("static $returntype sai_mock_${api}_$name", GetMockArgs($params));
+            WriteMock "{";
+
+            if ($returntype eq "sai_status_t")
+            {
+                WriteMock $_ for GetMockBody($name, $params, $ot);
+            }
+            else
+            {
+                WriteMock "return ($returntype)0;";
+            }
+
+            WriteMock "}";
+            WriteMock "";
+
+            push @members, "sai_mock_${api}_$name";
+        }
+
+        WriteMock "static $structname sai_mock_${api}_api = {";
+        WriteMock "    $_," for @members;
+        WriteMock "};";
+        WriteMock "";
+
+        push @tables, { api => $Api, short => $api };
+    }
+
+    WriteMock "sai_status_t sai_mock_api_query(";
+    WriteMock "    _In_ sai_api_t api,";
+    WriteMock "    _Out_ void **api_method_table)";
+    WriteMock "{";
+    WriteMock "switch ((int)api)";
+    WriteMock "{";
+
+    for my $t (@tables)
+    {
+        WriteMock "case $t->{api}:";
+        WriteMock "    *api_method_table = &sai_mock_$t->{short}_api;";
+        WriteMock "    return SAI_STATUS_SUCCESS;";
+    }
+
+    WriteMock "default:";
+    WriteMock "    return SAI_STATUS_NOT_SUPPORTED;";
+    WriteMock "}";
+    WriteMock "}";
+    WriteMock "";
+}
+
+sub CreateMockObjectTypeApi
+{
+    WriteMock "sai_api_t sai_mock_object_type_api(";
+    WriteMock "    _In_ sai_object_type_t object_type)";
+    WriteMock "{";
+    WriteMock "switch ((int)object_type)";
+    WriteMock "{";
+
+    for my $ot (sort keys %MOCK_OBJECT_TYPE_API)
+    {
+        WriteMock "case $ot:";
+        WriteMock "    return $MOCK_OBJECT_TYPE_API{$ot};";
+    }
+
+    WriteMock "default:";
+    WriteMock "    return SAI_API_UNSPECIFIED;";
+    WriteMock "}";
+    WriteMock "}";
+}
+
+sub CreateMockLibrary
+{
+    WriteMock "/* AUTOGENERATED FILE! DO NOT EDIT */";
+    WriteMock "";
+    WriteMock "#include <stdio.h>";
+    WriteMock "#include <stdlib.h>";
+    WriteMock "#include <string.h>";
+    WriteMock "#include \"saimetadata.h\"";
+    WriteMock "#include \"saimock.h\"";
+    WriteMock "";
+    WriteMock "#pragma GCC diagnostic push";
+    WriteMock "#pragma GCC diagnostic ignored \"-Wpragmas\"";
+    WriteMock "#pragma GCC diagnostic ignored \"-Wenum-conversion\"";
+    WriteMock "";
+
+    %MOCK_OBJECT_TYPE_API = ();
+
+    CreateMockGlobalApis();
+
+    CreateMockApis();
+
+    CreateMockObjectTypeApi();
+
+    WriteMock "";
+    WriteMock "#pragma GCC diagnostic pop";
+}
+
+BEGIN
+{
+    our @ISA    = qw(Exporter);
+    our @EXPORT = qw/
+    CreateMockLibrary
+    /;
+}
+
+1;
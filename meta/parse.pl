@@ -39,6 +39,9 @@ use style;
 use test;
 use serialize;
 use cap;
+use trace;
+use mock;
+use traits;
 
 our $XMLDIR = "xml";
 our $INCLUDE_DIR = "../inc/";
@@ -115,12 +118,12 @@ $SIG{__DIE__} = sub
     exit 1;
 };
 
-my %ACL_FIELD_TYPES = ();
+our %ACL_FIELD_TYPES = ();
 my %ACL_FIELD_TYPES_TO_VT = ();
-my %ACL_ACTION_TYPES = ();
+our %ACL_ACTION_TYPES = ();
 my %ACL_ACTION_TYPES_TO_VT = ();
 
-my %VALUE_TYPES = ();
+our %VALUE_TYPES = ();
 my %VALUE_TYPES_TO_VT = ();
 
 my %CAPABILITIES = ();
@@ -3920,6 +3923,536 @@ sub CreateApisQuery
     WriteHeader "_Inout_ sai_apis_t *apis);";
 }
 
+sub CreateObjectTypeApi
+{
+    WriteSectionComment "Object type API";
+
+    WriteHeader "extern sai_api_t sai_metadata_get_object_type_api(";
+    WriteHeader "    _In_ sai_object_type_t object_type);";
+
+    WriteSource "sai_api_t sai_metadata_get_object_type_api(";
+    WriteSource "    _In_ sai_object_type_t object_type)";
+    WriteSource "{";
+    WriteSource "switch((int)object_type)";
+    WriteSource "{";
+
+    my @objects = @{ $SAI_ENUMS{sai_object_type_t}{values} };
+
+    for my $ot (@objects)
+    {
+        next if $ot =~ /^SAI_OBJECT_TYPE_(NULL|MAX)$/;
+
+        next if not defined $OBJTOAPIMAP{$ot};
+
+        my $api = uc("SAI_API_$OBJTOAPIMAP{$ot}");
+
+        WriteSource "case $ot:";
+        WriteSource "    return $api;";
+    }
+
+    WriteSource "default:";
+    WriteSource "    return SAI_API_UNSPECIFIED;";
+    WriteSource "}";
+    WriteSource "}";
+}
+
+sub GetHashScalarBits
+{
+    my $type = shift;
+
+    return 8  if $type eq "sai_uint8_t";
+    return 16 if $type =~ /^sai_(uint16|vlan_id)_t$/;
+    return 32 if $type =~ /^(sai_uint32_t|uint32_t|sai_label_id_t)$/;
+    return 32 if $type =~ /^sai_\w+_type_t$/ or defined $SAI_ENUMS{$type}; # enum
+
+    return 0;
+}
+
+sub GetHashMembers
+{
+    #
+    # Purpose is to flatten entry struct members into list of [name, type],
+    # range is split into its min and max, so they can be packed as scalars
+    #
+
+    my $struct = shift;
+
+    my @members = ();
+
+    for my $key (GetStructKeysInOrder($struct))
+    {
+        my $type = $struct->{$key}{type};
+
+        if ($type eq "sai_u32_range_t")
+        {
+            push @members, [ "$key.min", "sai_uint32_t" ], [ "$key.max", "sai_uint32_t" ];
+            next;
+        }
+
+        push @members, [ $key, $type ];
+    }
+
+    return @members;
+}
+
+sub CreateNonObjectIdHashEntry
+{
+    my ($rawname, $struct) = @_;
+
+    my $name = "sai_metadata_hash_$rawname";
+
+    WriteHeader "extern uint64_t $name(";
+    WriteHeader "    _In_ const sai_${rawname}_t *$rawname);";
+
+    WriteSource "uint64_t $name(";
+    WriteSource "    _In_ const sai_${rawname}_t *$rawname)";
+    WriteSource "{";
+    WriteSource "uint64_t hash = 0;";
+
+    # members are mixed one by one, so padding bytes are never read, small
+    # scalar members are packed into single 64 bit word before mixing
+
+    my @packed = ();
+    my $shift = 0;
+
+    for my $member (GetHashMembers($struct))
+    {
+        my ($key, $type) = @$member;
+
+        my $bits = GetHashScalarBits($type);
+
+        if ($bits == 0 or $shift + $bits > 64)
+        {
+            WriteSource "hash = sai_metadata_hash_mix(hash, " . join(" | ", @packed) . ");" if scalar @packed;
+
+            @packed = ();
+            $shift = 0;
+        }
+
+        if ($bits > 0)
+        {
+            my $value = "(uint64_t)(uint${bits}_t)$rawname->$key";
+
+            push @packed, ($shift == 0) ? $value : "($value << $shift)";
+
+            $shift += $bits;
+        }
+        elsif ($type eq "sai_object_id_t")
+        {
+            WriteSource "hash = sai_metadata_hash_mix(hash, $rawname->$key);";
+        }
+        elsif ($type eq "sai_ip6_t")
+        {
+            WriteSource "hash = sai_metadata_hash_bytes(hash, $rawname->$key, sizeof($type));";
+        }
+        elsif ($type eq "sai_mac_t")
+        {
+            WriteSource "hash = sai_metadata_hash_mac(hash, $rawname->$key);";
+        }
+        elsif ($type =~ /^sai_(ip_address|ip_prefix|nat_entry_data)_t$/)
+        {
+            WriteSource "hash = sai_metadata_hash_$1(hash, &$rawname->$key);";
+        }
+        else
+        {
+            LogError "can't hash member $key of type $type in sai_${rawname}_t";
+        }
+    }
+
+    WriteSource "hash = sai_metadata_hash_mix(hash, " . join(" | ", @packed) . ");" if scalar @packed;
+
+    WriteSource "return sai_metadata_hash_finalize(hash);";
+    WriteSource "}";
+}
+
+sub CreateNonObjectIdEqualEntry
+{
+    my ($rawname, $struct) = @_;
+
+    my $name = "sai_metadata_equal_$rawname";
+
+    WriteHeader "extern bool $name(";
+    WriteHeader "    _In_ const sai_${rawname}_t *a,";
+    WriteHeader "    _In_ const sai_${rawname}_t *b);";
+
+    WriteSource "bool $name(";
+    WriteSource "    _In_ const sai_${rawname}_t *a,";
+    WriteSource "    _In_ const sai_${rawname}_t *b)";
+    WriteSource "{";
+
+    # object ids first, they differ most often
+
+    my @members = sort { ($b->[1] eq "sai_object_id_t") <=> ($a->[1] eq "sai_object_id_t") } GetHashMembers($struct);
+
+    for my $member (@members)
+    {
+        my ($key, $type) = @$member;
+
+        my $cond;
+
+        if ($type eq "sai_object_id_t" or GetHashScalarBits($type) > 0)
+        {
+            $cond = "a->$key != b->$key";
+        }
+        elsif ($type =~ /^sai_(mac|ip6)_t$/)
+        {
+            $cond = "memcmp(a->$key, b->$key, sizeof($type)) != 0";
+        }
+        elsif ($type =~ /^sai_(ip_address|ip_prefix|nat_entry_data)_t$/)
+        {
+            $cond = "!sai_metadata_equal_$1(&a->$key, &b->$key)";
+        }
+        else
+        {
+            LogError "can't compare member $key of type $type in sai_${rawname}_t";
+            next;
+        }
+
+        WriteSource "if ($cond)";
+        WriteSource "    return false;";
+    }
+
+    WriteSource "return true;";
+    WriteSource "}";
+}
+
+sub CreateNonObjectIdHash
+{
+    WriteSectionComment "Non object id entries hash and equality";
+
+    my @objecttypes = sort keys %NON_OBJECT_ID_STRUCTS;
+
+    for my $ot (@objecttypes)
+    {
+        my $rawname = lc($1) if $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        CreateNonObjectIdHashEntry($rawname, $NON_OBJECT_ID_STRUCTS{$ot});
+
+        CreateNonObjectIdEqualEntry($rawname, $NON_OBJECT_ID_STRUCTS{$ot});
+    }
+
+    WriteHeader "extern uint64_t sai_metadata_hash_object_meta_key(";
+    WriteHeader "    _In_ const sai_object_meta_key_t *meta_key);";
+
+    WriteSource "uint64_t sai_metadata_hash_object_meta_key(";
+    WriteSource "    _In_ const sai_object_meta_key_t *meta_key)";
+    WriteSource "{";
+    WriteSource "switch((int)meta_key->objecttype)";
+    WriteSource "{";
+
+    for my $ot (@objecttypes)
+    {
+        my $rawname = lc($1) if $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        WriteSource "case $ot:";
+        WriteSource "    return sai_metadata_hash_$rawname(&meta_key->objectkey.key.$rawname);";
+    }
+
+    # object id carries object type, so object type is not mixed in, and
+    # object id can be looked up without knowing its type
+
+    WriteSource "default:";
+    WriteSource "    return sai_metadata_hash_finalize(sai_metadata_hash_mix(0, meta_key->objectkey.key.object_id));";
+    WriteSource "}";
+    WriteSource "}";
+
+    WriteHeader "extern bool sai_metadata_equal_object_meta_key(";
+    WriteHeader "    _In_ const sai_object_meta_key_t *a,";
+    WriteHeader "    _In_ const sai_object_meta_key_t *b);";
+
+    WriteSource "bool sai_metadata_equal_object_meta_key(";
+    WriteSource "    _In_ const sai_object_meta_key_t *a,";
+    WriteSource "    _In_ const sai_object_meta_key_t *b)";
+    WriteSource "{";
+    WriteSource "if (a->objecttype != b->objecttype)";
+    WriteSource "    return false;";
+    WriteSource "switch((int)a->objecttype)";
+    WriteSource "{";
+
+    for my $ot (@objecttypes)
+    {
+        my $rawname = lc($1) if $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        WriteSource "case $ot:";
+        WriteSource "    return sai_metadata_equal_$rawname(&a->objectkey.key.$rawname, &b->objectkey.key.$rawname);";
+    }
+
+    WriteSource "default:";
+    WriteSource "    return a->objectkey.key.object_id == b->objectkey.key.object_id;";
+    WriteSource "}";
+    WriteSource "}";
+}
+
+#
+# Object struct holds every attribute of object type as native type member,
+# members are ordered by alignment so struct has as little padding as
+# possible. Alignment is only estimated from type name, wrong estimate
+# costs padding, not correctness.
+#
+
+sub GetObjectStructAttrs
+{
+    my $ot = shift;
+
+    return () if not $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+    my $type = "sai_" . lc($1) . "_attr_t";
+
+    return () if not defined $SAI_ENUMS{$type};
+
+    return grep { defined $METADATA{$type}{$_} and not defined $METADATA{$type}{$_}{ignore} } @{ $SAI_ENUMS{$type}{values} };
+}
+
+sub GetObjectStructMemberType
+{
+    my ($attr, $type) = @_;
+
+    return "bool" if $type eq "bool";
+
+    return "char" if $type eq "char";
+
+    return "sai_pointer_t" if $type =~ /^sai_pointer_t sai_\w+_fn$/;
+
+    return $1 if $type =~ /^(sai_acl_field_data_t|sai_acl_field_data_mask_t|sai_acl_action_data_t|sai_s32_list_t) (bool|sai_\w+_t)$/;
+
+    return $type if $type =~ /^sai_\w+_t$/;
+
+    LogError "unsupported object struct member type '$type' on $attr";
+
+    return "";
+}
+
+sub GetObjectStructMemberAlign
+{
+    my $type = shift;
+
+    return 1 if $type =~ /^(bool|char|sai_u?int8_t|sai_mac_t|sai_ip6_t)$/;
+
+    return 2 if $type =~ /^sai_u?int16_t$/;
+
+    return 4 if $type =~ /^(sai_u?int32_t|sai_ip4_t|sai_ip_address_t|sai_ip_prefix_t|sai_[us]32_range_t)$/;
+
+    return 4 if not defined $VALUE_TYPES{$type} and defined $SAI_ENUMS{$type};
+
+    return 8;
+}
+
+sub CreateObjectStruct
+{
+    my ($ot, $rawname, $prefix, @attrs) = @_;
+
+    my $typedef = "sai_" . $rawname . "_attr_t";
+
+    my @members = ();
+
+    for my $attr (@attrs)
+    {
+        my $type = GetObjectStructMemberType($attr, $METADATA{$typedef}{$attr}{type});
+
+        my $name = lc($1) if $attr =~ /^${prefix}_(\w+)$/;
+
+        if (not defined $name)
+        {
+            LogError "attribute $attr does not start with ${prefix}_";
+            next;
+        }
+
+        # member can't start with digit or be C/C++ keyword (like "inline")
+
+        $name = "_$name" if $name =~ /^\d/ or $name =~ /^(auto|bool|break|case|char|class|const|continue|default|delete|do|double|else|enum|extern|float|for|goto|if|inline|int|long|new|operator|private|protected|public|register|restrict|return|short|signed|sizeof|static|struct|switch|template|this|typedef|union|unsigned|virtual|void|volatile|while)$/;
+
+        push @members, { attr => $attr, type => $type, name => $name, align => GetObjectStructMemberAlign($type) };
+    }
+
+    my @layout = sort { $b->{align} <=> $a->{align} } @members;
+
+    my $count = scalar @members;
+
+    my $bytes = int(($count + 7) / 8);
+
+    WriteHeader "typedef enum _sai_object_struct_${rawname}_field_t";
+    WriteHeader "{";
+
+    for my $member (@members)
+    {
+        my $field = $member->{attr};
+
+        $field =~ s/^SAI_/SAI_OBJECT_STRUCT_FIELD_/;
+
+        WriteHeader "$field,";
+    }
+
+    WriteHeader "} sai_object_struct_${rawname}_field_t;";
+    WriteHeader "";
+
+    WriteHeader "typedef struct _sai_object_struct_${rawname}_t";
+    WriteHeader "{";
+
+    for my $member (@layout)
+    {
+        my $suffix = ($member->{type} eq "char") ? "[32]" : "";
+
+        WriteHeader "$member->{type} $member->{name}$suffix;";
+    }
+
+    WriteHeader "uint8_t present[$bytes];";
+    WriteHeader "} sai_object_struct_${rawname}_t;";
+    WriteHeader "";
+
+    WriteSource "static int sai_metadata_object_struct_${rawname}_field_index(";
+    WriteSource "_In_ sai_attr_id_t attr_id)";
+    WriteSource "{";
+    WriteSource "switch (attr_id)";
+    WriteSource "{";
+
+    my $index = 0;
+
+    for my $member (@members)
+    {
+        WriteSource "case $member->{attr}: return $index;";
+
+        $index++;
+    }
+
+    WriteSource "default: return -1;";
+    WriteSource "}";
+    WriteSource "}";
+
+    my $struct = "sai_object_struct_${rawname}_t";
+
+    WriteSource "const sai_object_struct_field_t sai_metadata_object_struct_fields_${rawname}[] = {";
+
+    for my $member (@members)
+    {
+        my $name = $member->{name};
+
+        WriteSource "{ &sai_metadata_attr_$member->{attr}, offsetof($struct, $name), sizeof((($struct*)0)->$name) },";
+    }
+
+    WriteSource "};";
+
+    WriteHeader "extern const sai_object_struct_info_t sai_metadata_object_struct_info_$ot;";
+
+    WriteSource "const sai_object_struct_info_t sai_metadata_object_struct_info_$ot = {";
+    WriteSource ".size          = sizeof($struct),";
+    WriteSource ".presentoffset = offsetof($struct, present),";
+    WriteSource ".fields        = sai_metadata_object_struct_fields_${rawname},";
+    WriteSource ".fieldscount   = $count,";
+    WriteSource ".fieldindex    = sai_metadata_object_struct_${rawname}_field_index,";
+    WriteSource "};";
+}
+
+sub CreateObjectStructs
+{
+    WriteSectionComment "Object structs";
+
+    my @objects = @{ $SAI_ENUMS{sai_object_type_t}{values} };
+
+    for my $ot (@objects)
+    {
+        my @attrs = GetObjectStructAttrs($ot);
+
+        next if scalar @attrs == 0;
+
+        my $rawname = lc($1) if $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        CreateObjectStruct($ot, $rawname, "SAI_" . uc($rawname) . "_ATTR", @attrs);
+    }
+}
+
+sub ProcessObjectStructInfo
+{
+    my $ot = shift;
+
+    my @attrs = GetObjectStructAttrs($ot);
+
+    return "NULL" if scalar @attrs == 0;
+
+    return "&sai_metadata_object_struct_info_$ot";
+}
+
+sub CreateVendorCapabilities
+{
+    #
+    # Purpose is to index capabilities from capability files by vendor,
+    # object type and field index of object struct, so single capability
+    # query does not need to search attribute metadata.
+    #
+
+    WriteSectionComment "Vendor capabilities";
+
+    my %VENDORS = ();
+
+    for my $attr (keys %CAPABILITIES)
+    {
+        my @vids = sort keys %{ $CAPABILITIES{$attr} };
+
+        # index is the same as in sai_metadata_attr_capability_<attr>_<index>
+
+        for my $index (0..$#vids)
+        {
+            $VENDORS{$vids[$index]}{$attr} = $index;
+        }
+    }
+
+    my @objects = @{ $SAI_ENUMS{sai_object_type_t}{values} };
+
+    my @vendors = sort keys %VENDORS;
+
+    for my $vindex (0..$#vendors)
+    {
+        my $vid = $vendors[$vindex];
+
+        my @table = ();
+
+        for my $ot (@objects)
+        {
+            my @attrs = GetObjectStructAttrs($ot);
+
+            if (not grep { defined $VENDORS{$vid}{$_} } @attrs)
+            {
+                push @table, "NULL";
+                next;
+            }
+
+            WriteSource "const sai_attr_capability_metadata_t* const sai_metadata_vendor_capability_${vindex}_$ot\[\] = {";
+
+            for my $attr (@attrs)
+            {
+                my $index = $VENDORS{$vid}{$attr};
+
+                WriteSource (defined $index ? "&sai_metadata_attr_capability_${attr}_$index," : "NULL,");
+            }
+
+            WriteSource "};";
+
+            push @table, "sai_metadata_vendor_capability_${vindex}_$ot";
+        }
+
+        WriteSource "const sai_attr_capability_metadata_t* const* const sai_metadata_vendor_capability_objects_$vindex\[\] = {";
+
+        WriteSource "$_," for @table;
+
+        WriteSource "};";
+
+        my $count = scalar @table;
+
+        WriteSource "const sai_vendor_capability_metadata_t sai_metadata_vendor_capability_$vindex = {";
+        WriteSource ".vendorid = $vid,";
+        WriteSource ".objecttypes = sai_metadata_vendor_capability_objects_$vindex,";
+        WriteSource ".objecttypescount = $count,";
+        WriteSource "};";
+    }
+
+    WriteHeader "extern const sai_vendor_capability_metadata_t* const sai_metadata_vendor_capabilities[];";
+    WriteSource "const sai_vendor_capability_metadata_t* const sai_metadata_vendor_capabilities[] = {";
+
+    WriteSource "&sai_metadata_vendor_capability_$_," for (0..$#vendors);
+
+    WriteSource "NULL";
+    WriteSource "};";
+}
+
 sub CreateGlobalApisQuery
 {
     WriteSectionComment "SAI global API query";
@@ -4048,6 +4581,7 @@ sub CreateObjectInfo
         my $isexperimental      = ProcessIsExperimental($ot);
         my $statenum            = ProcessStatEnum($shortot);
         my $iscustom            = ProcessIsCustom($ot);
+        my $structinfo          = ProcessObjectStructInfo($ot);
         my $attrmetalength      = @{ $SAI_ENUMS{$type}{values} };
 
         my $create      = ProcessCreate($struct, $ot);
@@ -4086,6 +4620,7 @@ sub CreateObjectInfo
         WriteSource ".isexperimental       = $isexperimental,";
         WriteSource ".statenum             = $statenum,";
         WriteSource ".iscustom             = $iscustom,";
+        WriteSource ".structinfo           = $structinfo,";
 
         WriteSource "};";
     }
@@ -5658,6 +6193,13 @@ sub CreateSaiSwigApiStructs
     my @exheaders = GetExperimentalHeaderFiles();
     my @cuheaders = GetCustomHeaderFiles();
 
+    # tracing library, recorder, mock, bulker, reference counter, apply
+    # scheduler, diff, capability cache, object id allocator, resource
+    # monitor, counter poller and counter history headers are not part of
+    # metadata api, their functions are not in libsaimetadata.so
+
+    @metaheaders = grep { not /^sai(trace|recorder|mock|bulker|refcount|apply|diff|capcache|oid|crm|poller|history)\.h$/ } @metaheaders;
+
     push(@metaheaders, "saimetadata.h");
 
     my @merged = (@headers, @metaheaders, @exheaders, @cuheaders);
@@ -5759,6 +6301,14 @@ CreateGenericQuadBulkApi();
 
 CreateApisQuery();
 
+CreateObjectTypeApi();
+
+CreateNonObjectIdHash();
+
+CreateObjectStructs();
+
+CreateVendorCapabilities();
+
 CreateGlobalApisQuery();
 
 CreateObjectInfo();
@@ -5801,6 +6351,12 @@ CreateSaiSwigGetApiHelperFunctions();
 
 CreateSaiSwigApiStructs();
 
+CreateTraceInterposer();
+
+CreateMockLibrary();
+
+CreateAttrTraits();
+
 WriteHeaderFotter();
 
 CreateSourcePragmaPop();
@@ -23,6 +23,7 @@
  */
 
 #include <arpa/inet.h>
+#include <unistd.h>
 
 #include "sai_rpc.h"
 
@@ -31,7 +32,11 @@ extern "C" {
 }
 
 #include <iostream>
+#include <fstream>
 #include <cstring>
+#include <thread>
+
+#include "sai_rpc_stats.hpp"
 
 using namespace ::sai;
 
@@ -892,6 +897,307 @@ static void sai_thrift_nat_type_t_parse(
 // including it here we never have to modify the generated file
 #include "sai_rpc_server.cpp"
 
+/**
+ * @brief Substitute batch placeholders with object ids created earlier
+ *
+ * Each reference points to an already executed create operation of the
+ * same batch and replaces either the object key (object id or entry struct
+ * member) or an object id inside one of the attribute values.
+ */
+static sai_status_t sai_thrift_batch_resolve_refs(
+        const std::vector<sai_thrift_batch_ref_t> &refs,
+        const std::vector<sai_thrift_batch_result_t> &results,
+        sai_object_meta_key_t &meta_key,
+        std::vector<sai_attribute_t> &attrs)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    for (const auto &ref: refs)
+    {
+        if (ref.op_index < 0 || (size_t)ref.op_index >= results.size())
+        {
+            SAI_META_LOG_ERROR("batch reference to operation %d which is not executed yet", ref.op_index);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        sai_object_id_t oid = results[ref.op_index].object_id;
+
+        if (results[ref.op_index].status != SAI_STATUS_SUCCESS || oid == SAI_NULL_OBJECT_ID)
+        {
+            SAI_META_LOG_ERROR("batch operation %d did not create an object", ref.op_index);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        if (ref.attr_index < 0)
+        {
+            if (!info->isnonobjectid)
+            {
+                meta_key.objectkey.key.object_id = oid;
+                continue;
+            }
+
+            const sai_struct_member_info_t *member = NULL;
+
+            for (size_t idx = 0; idx < info->structmemberscount; idx++)
+            {
+                if (ref.member == info->structmembers[idx]->membername &&
+                        info->structmembers[idx]->membervaluetype == SAI_ATTR_VALUE_TYPE_OBJECT_ID)
+                {
+                    member = info->structmembers[idx];
+                    break;
+                }
+            }
+
+            if (member == NULL)
+            {
+                SAI_META_LOG_ERROR("%s has no object id member '%s'", info->objecttypename, ref.member.c_str());
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            member->setoid(&meta_key, oid);
+            continue;
+        }
+
+        if ((size_t)ref.attr_index >= attrs.size())
+        {
+            SAI_META_LOG_ERROR("batch reference to attribute %d out of %zu", ref.attr_index, attrs.size());
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        sai_attribute_t &attr = attrs[ref.attr_index];
+
+        // metadata presence was already checked by attribute conversion
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key.objecttype, attr.id);
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+                attr.value.oid = oid;
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+
+                if (ref.list_index < 0 || (uint32_t)ref.list_index >= attr.value.objlist.count)
+                {
+                    SAI_META_LOG_ERROR("batch reference to %s[%d] out of list range", md->attridname, ref.list_index);
+                    return SAI_STATUS_INVALID_PARAMETER;
+                }
+
+                attr.value.objlist.list[ref.list_index] = oid;
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+                attr.value.aclfield.data.oid = oid;
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+                attr.value.aclaction.parameter.oid = oid;
+                break;
+
+            default:
+                SAI_META_LOG_ERROR("batch reference to %s which is not an object id", md->attridname);
+                return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Release lists allocated by convert_attr_thrift_to_sai
+ *
+ * Attributes must be zero initialized before conversion, so attributes which
+ * were not converted hold NULL lists.
+ */
+static void sai_thrift_batch_free_attrs(
+        const sai_object_type_t ot,
+        std::vector<sai_attribute_t> &attrs)
+{
+    for (auto &attr: attrs)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(ot, attr.id);
+
+        if (md == NULL)
+        {
+            continue;
+        }
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+                free(attr.value.objlist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
+                free(attr.value.u8list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_INT8_LIST:
+                free(attr.value.s8list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
+                free(attr.value.u16list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_INT16_LIST:
+                free(attr.value.s16list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
+                free(attr.value.u32list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+                free(attr.value.s32list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_UINT16_RANGE_LIST:
+                free(attr.value.u16rangelist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+                free(attr.value.aclfield.data.objlist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT8_LIST:
+                free(attr.value.aclfield.data.u8list.list);
+                free(attr.value.aclfield.mask.u8list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+                free(attr.value.aclaction.parameter.objlist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
+                free(attr.value.aclcapability.action_list.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
+                free(attr.value.aclresource.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
+                free(attr.value.ipaddrlist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
+                free(attr.value.ipprefixlist.list);
+                break;
+            case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
+                free(attr.value.qosmap.list);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Execute single batch operation
+ */
+static void sai_thrift_batch_execute_operation(
+        const sai_apis_t &apis,
+        const sai_thrift_batch_operation_t &op,
+        const std::vector<sai_thrift_batch_result_t> &results,
+        sai_thrift_batch_result_t &result)
+{
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = (sai_object_type_t)op.object_type;
+
+    result.object_id = SAI_NULL_OBJECT_ID;
+
+    if (!sai_metadata_is_object_type_valid(meta_key.objecttype) ||
+            meta_key.objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        // switch is tracked by the server itself, use sai_thrift_create_switch
+        result.status = SAI_STATUS_NOT_SUPPORTED;
+        return;
+    }
+
+    std::vector<sai_attribute_t> attrs(op.attr_list.size());
+
+    try
+    {
+        sai_thrift_parse_batch_key(op.key, &meta_key);
+
+        for (size_t idx = 0; idx < op.attr_list.size(); idx++)
+        {
+            convert_attr_thrift_to_sai(meta_key.objecttype, op.attr_list[idx], &attrs[idx]);
+        }
+    }
+    catch (const sai_thrift_exception &e)
+    {
+        sai_thrift_batch_free_attrs(meta_key.objecttype, attrs);
+        result.status = e.status;
+        return;
+    }
+
+    result.status = sai_thrift_batch_resolve_refs(op.refs, results, meta_key, attrs);
+
+    if (result.status != SAI_STATUS_SUCCESS)
+    {
+        sai_thrift_batch_free_attrs(meta_key.objecttype, attrs);
+        return;
+    }
+
+    uint32_t attr_count = (uint32_t)attrs.size();
+
+    size_t converted = 0;
+
+    switch (op.operation)
+    {
+        case SAI_COMMON_API_CREATE:
+            result.status = sai_metadata_generic_create(&apis, &meta_key, switch_id, attr_count, attrs.data());
+
+            if (result.status == SAI_STATUS_SUCCESS && !sai_metadata_get_object_type_info(meta_key.objecttype)->isnonobjectid)
+            {
+                result.object_id = meta_key.objectkey.key.object_id;
+            }
+            break;
+
+        case SAI_COMMON_API_REMOVE:
+            result.status = sai_metadata_generic_remove(&apis, &meta_key);
+            break;
+
+        case SAI_COMMON_API_SET:
+
+            if (attr_count != 1)
+            {
+                result.status = SAI_STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            result.status = sai_metadata_generic_set(&apis, &meta_key, attrs.data());
+            break;
+
+        case SAI_COMMON_API_GET:
+
+            result.status = sai_metadata_generic_get(&apis, &meta_key, attr_count, attrs.data());
+
+            if (result.status != SAI_STATUS_SUCCESS)
+            {
+                break;
+            }
+
+            try
+            {
+                // conversion to thrift releases the lists
+                for (; converted < attrs.size(); converted++)
+                {
+                    sai_thrift_attribute_t thrift_attr;
+                    convert_attr_sai_to_thrift(meta_key.objecttype, attrs[converted], thrift_attr);
+                    result.attr_list.push_back(thrift_attr);
+                }
+            }
+            catch (const sai_thrift_exception &e)
+            {
+                // value type not supported by thrift, lists of attributes
+                // not converted yet are released below
+                attrs.erase(attrs.begin(), attrs.begin() + converted);
+                result.attr_list.clear();
+                result.status = e.status;
+                break;
+            }
+            return;
+
+        default:
+            result.status = SAI_STATUS_INVALID_PARAMETER;
+            break;
+    }
+
+    sai_thrift_batch_free_attrs(meta_key.objecttype, attrs);
+}
+
 class sai_rpcHandlerFrontend:
     virtual public sai_rpcHandler
 {
@@ -975,22 +1281,180 @@ class sai_rpcHandlerFrontend:
             }
         }
     }
+
+    /**
+     * @brief Return per method RPC call statistics
+     */
+    void sai_thrift_get_rpc_stats(
+            std::vector<sai_thrift_rpc_method_stats_t> &thrift_stats) override
+    {
+        for (auto &s: sai_rpc_stats_t::instance().snapshot())
+        {
+            if (s.calls == 0)
+            {
+                continue;
+            }
+
+            sai_thrift_rpc_method_stats_t stats;
+
+            stats.name = s.name;
+            stats.calls = (int64_t)s.calls;
+            stats.errors = (int64_t)s.errors;
+            stats.conversion_sum = (int64_t)s.conversion_sum;
+            stats.conversion_p50 = (int64_t)s.percentile(s.conversion_buckets, 0.50);
+            stats.conversion_p99 = (int64_t)s.percentile(s.conversion_buckets, 0.99);
+            stats.conversion_max = (int64_t)s.conversion_max;
+            stats.sai_sum = (int64_t)s.sai_sum;
+            stats.sai_p50 = (int64_t)s.percentile(s.sai_buckets, 0.50);
+            stats.sai_p99 = (int64_t)s.percentile(s.sai_buckets, 0.99);
+            stats.sai_max = (int64_t)s.sai_max;
+
+            thrift_stats.push_back(stats);
+        }
+    }
+
+    /**
+     * @brief Execute ordered list of create/remove/set/get operations
+     *
+     * Operations can reference objects created by earlier operations of the
+     * same batch (see sai_thrift_batch_ref_t), so dependent setup like VLAN,
+     * members, RIF, neighbor, next hop and route takes single round trip.
+     * Every operation gets its own result, operations following a failure
+     * are reported as SAI_STATUS_NOT_EXECUTED if stop_on_error is set.
+     */
+    void sai_thrift_execute_batch(
+            std::vector<sai_thrift_batch_result_t> &results,
+            const std::vector<sai_thrift_batch_operation_t> &operations,
+            const bool stop_on_error) override
+    {
+        static sai_apis_t apis;
+        static bool apis_queried = false;
+
+        if (!apis_queried)
+        {
+            // some apis may be not implemented, their operations will fail
+            sai_metadata_apis_query(sai_api_query, &apis);
+
+            apis_queried = true;
+        }
+
+        results.reserve(operations.size());
+
+        bool failed = false;
+
+        for (const auto &op: operations)
+        {
+            sai_thrift_batch_result_t result;
+
+            if (failed && stop_on_error)
+            {
+                result.status = SAI_STATUS_NOT_EXECUTED;
+                result.object_id = SAI_NULL_OBJECT_ID;
+            }
+            else
+            {
+                sai_thrift_batch_execute_operation(apis, op, results, result);
+            }
+
+            failed = failed || (result.status != SAI_STATUS_SUCCESS);
+
+            results.push_back(result);
+        }
+    }
 };
 
+/**
+ * @brief Write RPC statistics snapshot to file
+ *
+ * File is rewritten as a whole (via temporary file and rename), so readers
+ * always see a complete snapshot. Times are in nanoseconds.
+ */
+static void sai_rpc_stats_dump(
+        const std::string &path)
+{
+    std::string tmp = path + ".tmp";
+
+    std::ofstream out(tmp.c_str(), std::ios::trunc);
+
+    if (!out)
+    {
+        std::cerr << "Failed to open RPC stats file " << tmp << std::endl;
+        return;
+    }
+
+    out << "# method calls errors conversion_sum conversion_p50 conversion_p90 conversion_p99 conversion_max"
+        << " sai_sum sai_p50 sai_p90 sai_p99 sai_max" << std::endl;
+
+    for (auto &s: sai_rpc_stats_t::instance().snapshot())
+    {
+        if (s.calls == 0)
+        {
+            continue;
+        }
+
+        out << s.name << " " << s.calls << " " << s.errors
+            << " " << s.conversion_sum
+            << " " << s.percentile(s.conversion_buckets, 0.50)
+            << " " << s.percentile(s.conversion_buckets, 0.90)
+            << " " << s.percentile(s.conversion_buckets, 0.99)
+            << " " << s.conversion_max
+            << " " << s.sai_sum
+            << " " << s.percentile(s.sai_buckets, 0.50)
+            << " " << s.percentile(s.sai_buckets, 0.90)
+            << " " << s.percentile(s.sai_buckets, 0.99)
+            << " " << s.sai_max << std::endl;
+    }
+
+    out.close();
+
+    if (rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Failed to rename RPC stats file " << tmp << " to " << path << std::endl;
+    }
+}
+
 static pthread_mutex_t cookie_mutex;
 static pthread_cond_t cookie_cv;
 static void *cookie;
 
+/**
+ * @brief Thrift RPC server listening address
+ *
+ * If unix_socket is not empty, server listens on AF_UNIX socket at that
+ * path instead of TCP port, this avoids TCP loopback overhead for clients
+ * running on the same host.
+ */
+typedef struct _sai_thrift_rpc_server_param_t
+{
+    int port;
+    std::string unix_socket;
+
+} sai_thrift_rpc_server_param_t;
+
 /**
  * @brief Create a Thrift RPC server thread
  */
 static void *sai_thrift_rpc_server_thread(void *arg)
 {
-    int port = *(int *)arg;
+    const sai_thrift_rpc_server_param_t *param = (const sai_thrift_rpc_server_param_t *)arg;
+
+    std::shared_ptr<TServerSocket> socket;
+
+    if (param->unix_socket.empty())
+    {
+        socket.reset(new TServerSocket(param->port));
+    }
+    else
+    {
+        // remove stale socket left by previous server instance
+        unlink(param->unix_socket.c_str());
+
+        socket.reset(new TServerSocket(param->unix_socket));
+    }
 
     std::shared_ptr<sai_rpcHandlerFrontend> handler(new sai_rpcHandlerFrontend());
     std::shared_ptr<TProcessor> processor(new sai_rpcProcessor(handler));
-    std::shared_ptr<TServerTransport> serverTransport(new TServerSocket(port));
+    std::shared_ptr<TServerTransport> serverTransport(socket);
     std::shared_ptr<TTransportFactory> transportFactory(new TBufferedTransportFactory());
     std::shared_ptr<TProtocolFactory> protocolFactory(new TBinaryProtocolFactory());
 
@@ -1005,6 +1469,33 @@ static void *sai_thrift_rpc_server_thread(void *arg)
 
 static pthread_t sai_thrift_rpc_thread;
 
+/**
+ * @brief Start Thrift RPC server thread and wait until it is ready
+ */
+static int sai_thrift_rpc_server_start(
+        const sai_thrift_rpc_server_param_t *param)
+{
+    cookie = NULL;
+    int status = pthread_create(&sai_thrift_rpc_thread, NULL, sai_thrift_rpc_server_thread, (void *)param);
+
+    if (status)
+    {
+        return status;
+    }
+
+    pthread_mutex_lock(&cookie_mutex);
+
+    while (!cookie)
+    {
+        pthread_cond_wait(&cookie_cv, &cookie_mutex);
+    }
+
+    pthread_mutex_unlock(&cookie_mutex);
+    pthread_mutex_destroy(&cookie_mutex);
+    pthread_cond_destroy(&cookie_cv);
+    return status;
+}
+
 extern "C" {
 
     /**
@@ -1012,29 +1503,11 @@ extern "C" {
      */
     int start_p4_sai_thrift_rpc_server(char *port)
     {
-        static int *param = (int *)malloc(sizeof(int));
-        *param = atoi(port);
+        static sai_thrift_rpc_server_param_t param;
+        param.port = atoi(port);
         std::cerr << "Starting SAI RPC server on port " << port << std::endl;
 
-        cookie = NULL;
-        int status = pthread_create(&sai_thrift_rpc_thread, NULL, sai_thrift_rpc_server_thread, param);
-
-        if (status)
-        {
-            return status;
-        }
-
-        pthread_mutex_lock(&cookie_mutex);
-
-        while (!cookie)
-        {
-            pthread_cond_wait(&cookie_cv, &cookie_mutex);
-        }
-
-        pthread_mutex_unlock(&cookie_mutex);
-        pthread_mutex_destroy(&cookie_mutex);
-        pthread_cond_destroy(&cookie_cv);
-        return status;
+        return sai_thrift_rpc_server_start(&param);
     }
 
     /**
@@ -1047,6 +1520,46 @@ extern "C" {
         return start_p4_sai_thrift_rpc_server(port_str);
     }
 
+    /**
+     * @brief Start Thrift RPC server on Unix domain socket
+     */
+    int start_sai_thrift_rpc_server_unix(const char *path)
+    {
+        static sai_thrift_rpc_server_param_t param;
+        param.port = 0;
+        param.unix_socket = path;
+        std::cerr << "Starting SAI RPC server on unix socket " << path << std::endl;
+
+        return sai_thrift_rpc_server_start(&param);
+    }
+
+    /**
+     * @brief Periodically dump RPC statistics to file
+     */
+    int start_sai_rpc_stats_dump(const char *path, int interval_sec)
+    {
+        if (path == NULL || interval_sec <= 0)
+        {
+            return -1;
+        }
+
+        std::string file(path);
+
+        std::cerr << "Dumping SAI RPC stats to " << file << " every " << interval_sec << "s" << std::endl;
+
+        std::thread([file, interval_sec]()
+        {
+            while (true)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(interval_sec));
+
+                sai_rpc_stats_dump(file);
+            }
+        }).detach();
+
+        return 0;
+    }
+
     /**
      * @brief Stop Thrift RPC server
      */
@@ -0,0 +1,386 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sai_rpc_stats.hpp
+ *
+ * @brief   This module defines RPC server per method call statistics
+ */
+
+#ifndef __SAI_RPC_STATS_HPP_
+#define __SAI_RPC_STATS_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Latency histogram uses log-linear buckets: values below
+ * SAI_RPC_STATS_SUB_BUCKETS nanoseconds have their own bucket, each following
+ * power of two range is split into SAI_RPC_STATS_SUB_BUCKETS equal buckets,
+ * which gives about 12% relative precision, enough to tell where time goes.
+ */
+
+#define SAI_RPC_STATS_SUB_BUCKET_BITS 3
+#define SAI_RPC_STATS_SUB_BUCKETS (1 << SAI_RPC_STATS_SUB_BUCKET_BITS)
+#define SAI_RPC_STATS_MAX_EXPONENT 40
+#define SAI_RPC_STATS_BUCKETS \
+    (SAI_RPC_STATS_SUB_BUCKETS * (SAI_RPC_STATS_MAX_EXPONENT - SAI_RPC_STATS_SUB_BUCKET_BITS + 2))
+
+/**
+ * @brief Single writer latency histogram
+ *
+ * Only owning thread updates the counters, so plain relaxed load and store
+ * are used instead of read-modify-write atomics, readers from other threads
+ * may observe slightly stale values but never torn ones.
+ */
+struct sai_rpc_histogram_t
+{
+    std::atomic<uint64_t> buckets[SAI_RPC_STATS_BUCKETS];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+
+    sai_rpc_histogram_t()
+    {
+        for (auto &b: buckets)
+        {
+            b.store(0, std::memory_order_relaxed);
+        }
+
+        sum.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    static inline size_t bucket_index(
+            uint64_t value)
+    {
+        if (value < SAI_RPC_STATS_SUB_BUCKETS)
+        {
+            return (size_t)value;
+        }
+
+        int exp = 63 - __builtin_clzll(value);
+
+        if (exp > SAI_RPC_STATS_MAX_EXPONENT)
+        {
+            return SAI_RPC_STATS_BUCKETS - 1;
+        }
+
+        size_t sub = (size_t)(value >> (exp - SAI_RPC_STATS_SUB_BUCKET_BITS)) & (SAI_RPC_STATS_SUB_BUCKETS - 1);
+
+        return SAI_RPC_STATS_SUB_BUCKETS * (size_t)(exp - SAI_RPC_STATS_SUB_BUCKET_BITS + 1) + sub;
+    }
+
+    static inline uint64_t bucket_value(
+            size_t index)
+    {
+        if (index < SAI_RPC_STATS_SUB_BUCKETS)
+        {
+            return index;
+        }
+
+        int exp = (int)(index / SAI_RPC_STATS_SUB_BUCKETS) + SAI_RPC_STATS_SUB_BUCKET_BITS - 1;
+
+        uint64_t sub = index % SAI_RPC_STATS_SUB_BUCKETS;
+
+        return (SAI_RPC_STATS_SUB_BUCKETS + sub) << (exp - SAI_RPC_STATS_SUB_BUCKET_BITS);
+    }
+
+    inline void record(
+            uint64_t value)
+    {
+        auto &b = buckets[bucket_index(value)];
+
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+
+        if (value > max.load(std::memory_order_relaxed))
+        {
+            max.store(value, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief Per thread, per RPC method counters
+ */
+struct sai_rpc_method_counters_t
+{
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+
+    sai_rpc_histogram_t conversion;  // thrift <-> SAI conversion and RPC glue
+    sai_rpc_histogram_t sai;         // time spent inside vendor SAI call
+
+    sai_rpc_method_counters_t()
+    {
+        calls.store(0, std::memory_order_relaxed);
+        errors.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Aggregated view of a single RPC method
+ */
+struct sai_rpc_method_summary_t
+{
+    std::string name;
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t conversion_sum;
+    uint64_t sai_sum;
+    uint64_t conversion_max;
+    uint64_t sai_max;
+    std::vector<uint64_t> conversion_buckets;
+    std::vector<uint64_t> sai_buckets;
+
+    uint64_t percentile(
+            const std::vector<uint64_t> &buckets,
+            double p) const
+    {
+        uint64_t total = 0;
+
+        for (auto b: buckets)
+        {
+            total += b;
+        }
+
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        uint64_t rank = (uint64_t)((double)total * p);
+        uint64_t seen = 0;
+
+        for (size_t i = 0; i < buckets.size(); i++)
+        {
+            seen += buckets[i];
+
+            if (seen > rank)
+            {
+                return sai_rpc_histogram_t::bucket_value(i);
+            }
+        }
+
+        return sai_rpc_histogram_t::bucket_value(buckets.size() - 1);
+    }
+};
+
+/**
+ * @brief RPC statistics registry
+ *
+ * Methods register themselves once (function local static in generated
+ * code) and receive an index. Each server thread lazily allocates counters
+ * for methods it executes, hot path takes no lock.
+ */
+class sai_rpc_stats_t
+{
+    private:
+
+        struct thread_block_t
+        {
+            std::vector<std::unique_ptr<sai_rpc_method_counters_t>> methods;
+            std::mutex grow_mutex; // guards vector growth against readers
+        };
+
+    public:
+
+        static sai_rpc_stats_t& instance()
+        {
+            static sai_rpc_stats_t stats;
+
+            return stats;
+        }
+
+        size_t register_method(
+                const char *name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_names.push_back(name);
+
+            return m_names.size() - 1;
+        }
+
+        sai_rpc_method_counters_t& counters(
+                size_t method)
+        {
+            static thread_local thread_block_t *block = nullptr;
+
+            if (block == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                m_blocks.emplace_back(new thread_block_t());
+
+                block = m_blocks.back().get();
+            }
+
+            if (method >= block->methods.size() || !block->methods[method])
+            {
+                std::lock_guard<std::mutex> lock(block->grow_mutex);
+
+                if (method >= block->methods.size())
+                {
+                    block->methods.resize(method + 1);
+                }
+
+                block->methods[method].reset(new sai_rpc_method_counters_t());
+            }
+
+            return *block->methods[method];
+        }
+
+        std::vector<sai_rpc_method_summary_t> snapshot()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<sai_rpc_method_summary_t> result(m_names.size());
+
+            for (size_t i = 0; i < m_names.size(); i++)
+            {
+                auto &s = result[i];
+
+                s.name = m_names[i];
+                s.calls = s.errors = 0;
+                s.conversion_sum = s.sai_sum = 0;
+                s.conversion_max = s.sai_max = 0;
+                s.conversion_buckets.assign(SAI_RPC_STATS_BUCKETS, 0);
+                s.sai_buckets.assign(SAI_RPC_STATS_BUCKETS, 0);
+            }
+
+            for (auto &block: m_blocks)
+            {
+                std::lock_guard<std::mutex> glock(block->grow_mutex);
+
+                for (size_t i = 0; i < block->methods.size() && i < result.size(); i++)
+                {
+                    const sai_rpc_method_counters_t *c = block->methods[i].get();
+
+                    if (c == nullptr)
+                    {
+                        continue;
+                    }
+
+                    auto &s = result[i];
+
+                    s.calls += c->calls.load(std::memory_order_relaxed);
+                    s.errors += c->errors.load(std::memory_order_relaxed);
+
+                    merge(c->conversion, s.conversion_buckets, s.conversion_sum, s.conversion_max);
+                    merge(c->sai, s.sai_buckets, s.sai_sum, s.sai_max);
+                }
+            }
+
+            return result;
+        }
+
+    private:
+
+        static void merge(
+                const sai_rpc_histogram_t &h,
+                std::vector<uint64_t> &buckets,
+                uint64_t &sum,
+                uint64_t &max)
+        {
+            for (size_t b = 0; b < SAI_RPC_STATS_BUCKETS; b++)
+            {
+                buckets[b] += h.buckets[b].load(std::memory_order_relaxed);
+            }
+
+            sum += h.sum.load(std::memory_order_relaxed);
+
+            uint64_t m = h.max.load(std::memory_order_relaxed);
+
+            max = (m > max) ? m : max;
+        }
+
+        std::mutex m_mutex;
+
+        std::vector<std::string> m_names;
+
+        std::vector<std::unique_ptr<thread_block_t>> m_blocks;
+};
+
+/**
+ * @brief Measures a single RPC call
+ *
+ * Constructed at the beginning of generated handler body. Time between
+ * sai_call_begin() and sai_call_end() is accounted as SAI call time,
+ * everything else as conversion time. Generated handlers report failures
+ * by throwing sai_thrift_exception, so scope left by an exception is counted
+ * as an error.
+ */
+class sai_rpc_stats_scope_t
+{
+    public:
+
+        explicit sai_rpc_stats_scope_t(
+                size_t method):
+            m_counters(sai_rpc_stats_t::instance().counters(method)),
+            m_start(clock::now()),
+            m_sai_ns(0)
+        {
+        }
+
+        ~sai_rpc_stats_scope_t()
+        {
+            uint64_t total = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count();
+
+            m_counters.calls.store(m_counters.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            if (std::uncaught_exception())
+            {
+                m_counters.errors.store(m_counters.errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            m_counters.sai.record(m_sai_ns);
+            m_counters.conversion.record(total > m_sai_ns ? total - m_sai_ns : 0);
+        }
+
+        inline void sai_call_begin()
+        {
+            m_sai_start = clock::now();
+        }
+
+        inline void sai_call_end()
+        {
+            m_sai_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_sai_start).count();
+        }
+
+    private:
+
+        typedef std::chrono::steady_clock clock;
+
+        sai_rpc_method_counters_t &m_counters;
+
+        clock::time_point m_start;
+
+        clock::time_point m_sai_start;
+
+        uint64_t m_sai_ns;
+};
+
+#endif /* __SAI_RPC_STATS_HPP_ */
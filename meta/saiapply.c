@@ -0,0 +1,1431 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saiapply.c
+ *
+ * @brief   This module implements SAI dependency level apply scheduler
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saiapply.h"
+
+/*
+ * Extension APIs share last slot of per API arrays.
+ */
+
+#define SAI_APPLY_APIS ((size_t)SAI_API_MAX + 1)
+
+#define SAI_APPLY_OP_CREATE 0
+#define SAI_APPLY_OP_REMOVE 1
+#define SAI_APPLY_OPS 2
+
+#define SAI_APPLY_STATE_PENDING 0
+#define SAI_APPLY_STATE_CREATED 1
+#define SAI_APPLY_STATE_FAILED 2
+#define SAI_APPLY_STATE_REMOVED 3
+
+#define SAI_APPLY_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_APPLY_BLOCK_SIZE (64 * 1024)
+
+#define SAI_APPLY_PLACEHOLDERS_MIN_SIZE 64
+
+#define SAI_APPLY_STAT_ADD(var, value) \
+    __atomic_fetch_add(&(var), (value), __ATOMIC_RELAXED)
+
+/*
+ * Arena block holding attribute copies, data follows the header.
+ */
+
+typedef struct _sai_apply_block_t
+{
+    struct _sai_apply_block_t *next;
+
+    size_t size;
+
+    size_t used;
+
+} sai_apply_block_t;
+
+/*
+ * Added object. Placeholders in key, switch id and attribute copy are
+ * replaced by created object ids right before create call.
+ */
+
+typedef struct _sai_apply_object_t
+{
+    sai_object_meta_key_t meta_key;
+
+    sai_object_id_t placeholder;
+
+    sai_object_id_t switch_id;
+
+    uint32_t attr_count;
+
+    sai_attribute_t *attr_list;
+
+    sai_apply_future_t *future;
+
+    uint32_t level;
+
+    int state;
+
+} sai_apply_object_t;
+
+/*
+ * Sort key of object in execution order.
+ */
+
+typedef struct _sai_apply_rank_t
+{
+    uint32_t rank;
+
+    sai_object_type_t object_type;
+
+    sai_object_id_t switch_id;
+
+    uint32_t index;
+
+} sai_apply_rank_t;
+
+/*
+ * Task is slice of execution order with objects of single level, object
+ * type and switch.
+ */
+
+typedef struct _sai_apply_task_t
+{
+    uint32_t start;
+
+    uint32_t count;
+
+} sai_apply_task_t;
+
+struct _sai_apply_t
+{
+    sai_apply_config_t config;
+
+    bool thread_safe[SAI_APPLY_APIS];
+
+    pthread_mutex_t locks[SAI_APPLY_APIS];
+
+    int bulk_unsupported[SAI_APPLY_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+    sai_apply_object_t *objects;
+
+    uint32_t count;
+
+    uint32_t capacity;
+
+    /* objects from this index on were not executed yet */
+
+    uint32_t first_pending;
+
+    /* open addressing table of object index + 1 keyed by placeholder */
+
+    uint32_t *placeholders;
+
+    size_t placeholders_size;
+
+    size_t placeholders_used;
+
+    sai_apply_block_t *blocks;
+
+    /*
+     * Worker threads live as long as scheduler, each level is started by
+     * incrementing generation and is done when no worker is busy.
+     */
+
+    pthread_t *workers;
+
+    uint32_t worker_count;
+
+    pthread_mutex_t pool_lock;
+
+    pthread_cond_t pool_start;
+
+    pthread_cond_t pool_done;
+
+    uint64_t generation;
+
+    uint32_t busy;
+
+    int shutdown;
+
+    /* state of running execution, shared with workers */
+
+    int op;
+
+    uint32_t *order;
+
+    sai_object_meta_key_t *meta_keys;
+
+    uint32_t *attr_counts;
+
+    const sai_attribute_t **attr_lists;
+
+    sai_status_t *statuses;
+
+    uint32_t *ready;
+
+    sai_apply_task_t *tasks;
+
+    uint32_t next_task;
+
+    uint32_t level_end;
+
+    int failed;
+
+    sai_apply_stats_t stats;
+};
+
+/*
+ * Visitor of object id in key, switch id or attribute of object, returns
+ * nonzero to stop visiting.
+ */
+
+typedef int (*sai_apply_visit_fn)(
+        _In_ sai_apply_t *apply,
+        _Inout_ void *ctx,
+        _Inout_ sai_object_id_t *object_id);
+
+/*
+ * Dependency graph of pending objects in compressed form, users of
+ * pending object i are users[offsets[i]] .. users[offsets[i + 1] - 1].
+ */
+
+typedef struct _sai_apply_graph_t
+{
+    uint32_t user;
+
+    uint32_t *indegree;
+
+    uint32_t *offsets;
+
+    uint32_t *users;
+
+    int fill;
+
+} sai_apply_graph_t;
+
+static size_t sai_apply_api_index(
+        _In_ sai_api_t api)
+{
+    return (api < SAI_API_MAX) ? (size_t)api : (size_t)SAI_API_MAX;
+}
+
+/*
+ * Returns index of object with placeholder or UINT32_MAX.
+ */
+
+static uint32_t sai_apply_find(
+        _In_ const sai_apply_t *apply,
+        _In_ sai_object_id_t placeholder)
+{
+    size_t mask = apply->placeholders_size - 1;
+    size_t idx;
+
+    if (placeholder == SAI_NULL_OBJECT_ID || apply->placeholders_size == 0)
+    {
+        return UINT32_MAX;
+    }
+
+    for (idx = sai_metadata_hash_finalize(placeholder) & mask; apply->placeholders[idx] != 0; idx = (idx + 1) & mask)
+    {
+        uint32_t index = apply->placeholders[idx] - 1;
+
+        if (apply->objects[index].placeholder == placeholder)
+        {
+            return index;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+static sai_status_t sai_apply_insert(
+        _Inout_ sai_apply_t *apply,
+        _In_ uint32_t index)
+{
+    size_t mask;
+    size_t idx;
+
+    if ((apply->placeholders_used + 1) * 2 > apply->placeholders_size)
+    {
+        size_t size = apply->placeholders_size ? apply->placeholders_size * 2 : SAI_APPLY_PLACEHOLDERS_MIN_SIZE;
+        uint32_t *placeholders = calloc(size, sizeof(uint32_t));
+
+        if (placeholders == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        for (idx = 0; idx < apply->placeholders_size; idx++)
+        {
+            uint32_t value = apply->placeholders[idx];
+            size_t pos;
+
+            if (value == 0)
+            {
+                continue;
+            }
+
+            for (pos = sai_metadata_hash_finalize(apply->objects[value - 1].placeholder) & (size - 1);
+                    placeholders[pos] != 0;
+                    pos = (pos + 1) & (size - 1))
+            {
+            }
+
+            placeholders[pos] = value;
+        }
+
+        free(apply->placeholders);
+
+        apply->placeholders = placeholders;
+        apply->placeholders_size = size;
+    }
+
+    mask = apply->placeholders_size - 1;
+
+    for (idx = sai_metadata_hash_finalize(apply->objects[index].placeholder) & mask;
+            apply->placeholders[idx] != 0;
+            idx = (idx + 1) & mask)
+    {
+    }
+
+    apply->placeholders[idx] = index + 1;
+    apply->placeholders_used++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void* sai_apply_alloc(
+        _Inout_ sai_apply_t *apply,
+        _In_ size_t size)
+{
+    sai_apply_block_t *block = apply->blocks;
+    void *ptr;
+
+    size = SAI_APPLY_ALIGN(size);
+
+    if (block == NULL || block->used + size > block->size)
+    {
+        size_t block_size = (size > SAI_APPLY_BLOCK_SIZE) ? size : SAI_APPLY_BLOCK_SIZE;
+
+        block = malloc(SAI_APPLY_ALIGN(sizeof(sai_apply_block_t)) + block_size);
+
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        block->next = apply->blocks;
+        block->size = block_size;
+        block->used = 0;
+
+        apply->blocks = block;
+    }
+
+    ptr = (uint8_t*)block + SAI_APPLY_ALIGN(sizeof(sai_apply_block_t)) + block->used;
+
+    block->used += size;
+
+    return ptr;
+}
+
+/*
+ * Copies attributes into arena, list contents included, with single
+ * allocation per attribute list.
+ */
+
+static sai_status_t sai_apply_copy_attrs(
+        _Inout_ sai_apply_t *apply,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_attribute_t **copy)
+{
+    sai_status_t status;
+    void *buffer;
+    size_t size;
+
+    *copy = NULL;
+
+    if (attr_count == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    status = sai_metadata_get_attr_list_copy_size(object_type, attr_count, attr_list, &size);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    buffer = sai_apply_alloc(apply, size);
+
+    if (buffer == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    return sai_metadata_deep_copy_attr_list(object_type, attr_count, attr_list, buffer, copy);
+}
+
+static int sai_apply_visit_list(
+        _In_ sai_apply_t *apply,
+        _Inout_ void *ctx,
+        _In_ sai_apply_visit_fn fn,
+        _Inout_ sai_object_list_t *list)
+{
+    uint32_t idx;
+
+    if (list->list == NULL)
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < list->count; idx++)
+    {
+        if (fn(apply, ctx, &list->list[idx]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Visits every object id object depends on: switch id, object id entry key
+ * members and object id attribute values.
+ */
+
+static int sai_apply_visit(
+        _In_ sai_apply_t *apply,
+        _Inout_ sai_apply_object_t *object,
+        _In_ sai_apply_visit_fn fn,
+        _Inout_ void *ctx)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object->meta_key.objecttype);
+    uint32_t idx;
+
+    if (info->isobjectid && object->meta_key.objecttype != SAI_OBJECT_TYPE_SWITCH && fn(apply, ctx, &object->switch_id))
+    {
+        return 1;
+    }
+
+    for (idx = 0; info->isnonobjectid && idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+        sai_object_id_t object_id;
+
+        if (m->membervaluetype != SAI_ATTR_VALUE_TYPE_OBJECT_ID || m->getoid == NULL || m->setoid == NULL)
+        {
+            continue;
+        }
+
+        object_id = m->getoid(&object->meta_key);
+
+        if (fn(apply, ctx, &object_id))
+        {
+            return 1;
+        }
+
+        m->setoid(&object->meta_key, object_id);
+    }
+
+    for (idx = 0; idx < object->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object->meta_key.objecttype, object->attr_list[idx].id);
+        sai_attribute_value_t *value = &object->attr_list[idx].value;
+        int stop = 0;
+
+        if (md == NULL)
+        {
+            continue;
+        }
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+                stop = fn(apply, ctx, &value->oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+                stop = sai_apply_visit_list(apply, ctx, fn, &value->objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+                stop = value->aclfield.enable && fn(apply, ctx, &value->aclfield.data.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+                stop = value->aclfield.enable && sai_apply_visit_list(apply, ctx, fn, &value->aclfield.data.objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+                stop = value->aclaction.enable && fn(apply, ctx, &value->aclaction.parameter.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+                stop = value->aclaction.enable && sai_apply_visit_list(apply, ctx, fn, &value->aclaction.parameter.objlist);
+                break;
+
+            default:
+                break;
+        }
+
+        if (stop)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Counts (first pass) or stores (second pass) dependency edges between
+ * pending objects. Dependency created by previous execution only raises
+ * level of its user.
+ */
+
+static int sai_apply_visit_graph(
+        _In_ sai_apply_t *apply,
+        _Inout_ void *ctx,
+        _Inout_ sai_object_id_t *object_id)
+{
+    sai_apply_graph_t *graph = (sai_apply_graph_t*)ctx;
+    uint32_t first = apply->first_pending;
+    uint32_t index = sai_apply_find(apply, *object_id);
+
+    if (index == UINT32_MAX)
+    {
+        return 0;
+    }
+
+    if (index < first)
+    {
+        sai_apply_object_t *user = &apply->objects[graph->user];
+        uint32_t level = apply->objects[index].level + 1;
+
+        if (!graph->fill && apply->objects[index].state == SAI_APPLY_STATE_CREATED && user->level < level)
+        {
+            user->level = level;
+        }
+
+        return 0;
+    }
+
+    if (graph->fill)
+    {
+        graph->users[graph->offsets[index - first]++] = graph->user;
+    }
+    else
+    {
+        graph->offsets[index - first]++;
+        graph->indegree[graph->user - first]++;
+    }
+
+    return 0;
+}
+
+/*
+ * Assigns levels to pending objects by topological sort, object gets
+ * level one above its highest dependency. Fails on dependency cycle.
+ */
+
+static sai_status_t sai_apply_compute_levels(
+        _Inout_ sai_apply_t *apply)
+{
+    uint32_t first = apply->first_pending;
+    uint32_t count = apply->count - first;
+    sai_apply_graph_t graph;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t *queue;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t total = 0;
+    uint32_t idx;
+
+    memset(&graph, 0, sizeof(graph));
+
+    graph.indegree = calloc(count + 1, sizeof(uint32_t));
+    graph.offsets = calloc(count + 1, sizeof(uint32_t));
+    queue = calloc(count + 1, sizeof(uint32_t));
+
+    if (graph.indegree == NULL || graph.offsets == NULL || queue == NULL)
+    {
+        status = SAI_STATUS_NO_MEMORY;
+        goto out;
+    }
+
+    for (idx = first; idx < apply->count; idx++)
+    {
+        apply->objects[idx].level = 0;
+
+        graph.user = idx;
+
+        sai_apply_visit(apply, &apply->objects[idx], sai_apply_visit_graph, &graph);
+    }
+
+    /* offsets become start of each users range, fill advances them to end */
+
+    for (idx = 0; idx < count; idx++)
+    {
+        uint32_t edges = graph.offsets[idx];
+
+        graph.offsets[idx] = total;
+
+        total += edges;
+    }
+
+    graph.offsets[count] = total;
+
+    graph.users = malloc((total + 1) * sizeof(uint32_t));
+
+    if (graph.users == NULL)
+    {
+        status = SAI_STATUS_NO_MEMORY;
+        goto out;
+    }
+
+    graph.fill = 1;
+
+    for (idx = first; idx < apply->count; idx++)
+    {
+        graph.user = idx;
+
+        sai_apply_visit(apply, &apply->objects[idx], sai_apply_visit_graph, &graph);
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        if (graph.indegree[idx] == 0)
+        {
+            queue[tail++] = idx;
+        }
+    }
+
+    while (head < tail)
+    {
+        uint32_t dep = queue[head++];
+        uint32_t start = (dep == 0) ? 0 : graph.offsets[dep - 1];
+        uint32_t level = apply->objects[first + dep].level + 1;
+
+        for (idx = start; idx < graph.offsets[dep]; idx++)
+        {
+            sai_apply_object_t *user = &apply->objects[graph.users[idx]];
+            uint32_t u = graph.users[idx] - first;
+
+            if (user->level < level)
+            {
+                user->level = level;
+            }
+
+            if (--graph.indegree[u] == 0)
+            {
+                queue[tail++] = u;
+            }
+        }
+    }
+
+    if (tail != count)
+    {
+        SAI_META_LOG_ERROR("dependency cycle among %u objects", count - tail);
+
+        status = SAI_STATUS_INVALID_PARAMETER;
+    }
+
+out:
+
+    free(graph.indegree);
+    free(graph.offsets);
+    free(graph.users);
+    free(queue);
+
+    return status;
+}
+
+static int sai_apply_rank_cmp(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    const sai_apply_rank_t *ra = (const sai_apply_rank_t*)a;
+    const sai_apply_rank_t *rb = (const sai_apply_rank_t*)b;
+
+    if (ra->rank != rb->rank)
+    {
+        return (ra->rank < rb->rank) ? -1 : 1;
+    }
+
+    if (ra->object_type != rb->object_type)
+    {
+        return (ra->object_type < rb->object_type) ? -1 : 1;
+    }
+
+    if (ra->switch_id != rb->switch_id)
+    {
+        return (ra->switch_id < rb->switch_id) ? -1 : 1;
+    }
+
+    return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+/*
+ * Replaces placeholder by object id of created object, stops when
+ * dependency was not created.
+ */
+
+static int sai_apply_visit_resolve(
+        _In_ sai_apply_t *apply,
+        _Inout_ void *ctx,
+        _Inout_ sai_object_id_t *object_id)
+{
+    uint32_t index = sai_apply_find(apply, *object_id);
+
+    if (index == UINT32_MAX)
+    {
+        return 0;
+    }
+
+    if (apply->objects[index].state != SAI_APPLY_STATE_CREATED)
+    {
+        return 1;
+    }
+
+    *object_id = apply->objects[index].meta_key.objectkey.key.object_id;
+
+    return 0;
+}
+
+static sai_status_t sai_apply_call_bulk(
+        _In_ sai_apply_t *apply,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t start,
+        _In_ uint32_t count)
+{
+    const sai_apis_t *apis = apply->config.apis;
+
+    if (apply->op == SAI_APPLY_OP_CREATE)
+    {
+        return sai_metadata_generic_bulk_create(apis, switch_id, count, &apply->meta_keys[start],
+                &apply->attr_counts[start], &apply->attr_lists[start], apply->config.mode,
+                &apply->statuses[start]);
+    }
+
+    return sai_metadata_generic_bulk_remove(apis, count, &apply->meta_keys[start],
+            apply->config.mode, &apply->statuses[start]);
+}
+
+static sai_status_t sai_apply_call_single(
+        _In_ sai_apply_t *apply,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t idx)
+{
+    const sai_apis_t *apis = apply->config.apis;
+
+    if (apply->op == SAI_APPLY_OP_CREATE)
+    {
+        return sai_metadata_generic_create(apis, &apply->meta_keys[idx], switch_id,
+                apply->attr_counts[idx], apply->attr_lists[idx]);
+    }
+
+    return sai_metadata_generic_remove(apis, &apply->meta_keys[idx]);
+}
+
+/*
+ * Executes ready objects of task, slice start .. start + count of call
+ * arrays. Statuses are set for all of them.
+ */
+
+static void sai_apply_call(
+        _Inout_ sai_apply_t *apply,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t start,
+        _In_ uint32_t count)
+{
+    int *unsupported = &apply->bulk_unsupported[apply->op][sai_metadata_object_type_index(object_type)];
+    int stop = (apply->config.mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR);
+    uint32_t idx;
+
+    for (idx = start; idx < start + count; idx++)
+    {
+        apply->statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+    }
+
+    if (count > 1 && !__atomic_load_n(unsupported, __ATOMIC_RELAXED))
+    {
+        sai_status_t status = sai_apply_call_bulk(apply, switch_id, start, count);
+
+        if (status != SAI_STATUS_NOT_SUPPORTED && status != SAI_STATUS_NOT_IMPLEMENTED)
+        {
+            SAI_APPLY_STAT_ADD(apply->stats.bulk_calls, 1);
+
+            for (idx = start; idx < start + count; idx++)
+            {
+                /* call rejected as whole leaves object statuses untouched */
+
+                if (status != SAI_STATUS_SUCCESS && status != SAI_STATUS_FAILURE &&
+                        apply->statuses[idx] == SAI_STATUS_NOT_EXECUTED)
+                {
+                    apply->statuses[idx] = status;
+                }
+            }
+
+            return;
+        }
+
+        __atomic_store_n(unsupported, 1, __ATOMIC_RELAXED);
+    }
+
+    for (idx = start; idx < start + count; idx++)
+    {
+        apply->statuses[idx] = sai_apply_call_single(apply, switch_id, idx);
+
+        SAI_APPLY_STAT_ADD(apply->stats.single_calls, 1);
+
+        if (apply->statuses[idx] != SAI_STATUS_SUCCESS && stop)
+        {
+            break;
+        }
+    }
+}
+
+static void sai_apply_complete(
+        _Inout_ sai_apply_t *apply,
+        _Inout_ sai_apply_object_t *object,
+        _In_ sai_status_t status)
+{
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        object->state = (apply->op == SAI_APPLY_OP_CREATE) ? SAI_APPLY_STATE_CREATED : SAI_APPLY_STATE_REMOVED;
+    }
+    else
+    {
+        if (apply->op == SAI_APPLY_OP_CREATE)
+        {
+            object->state = SAI_APPLY_STATE_FAILED;
+        }
+
+        if (status == SAI_STATUS_NOT_EXECUTED)
+        {
+            SAI_APPLY_STAT_ADD(apply->stats.skipped, 1);
+        }
+        else
+        {
+            SAI_APPLY_STAT_ADD(apply->stats.failures, 1);
+        }
+
+        __atomic_store_n(&apply->failed, 1, __ATOMIC_RELAXED);
+    }
+
+    if (object->future != NULL)
+    {
+        object->future->status = status;
+        object->future->object_id = (object->state == SAI_APPLY_STATE_CREATED) ? object->meta_key.objectkey.key.object_id : SAI_NULL_OBJECT_ID;
+    }
+}
+
+static void sai_apply_execute_task(
+        _Inout_ sai_apply_t *apply,
+        _In_ const sai_apply_task_t *task)
+{
+    sai_object_type_t object_type = apply->objects[apply->order[task->start]].meta_key.objecttype;
+    size_t api = sai_apply_api_index(sai_metadata_get_object_type_api(object_type));
+    sai_object_id_t switch_id = SAI_NULL_OBJECT_ID;
+    uint32_t start = task->start;
+    uint32_t count = 0;
+    uint32_t idx;
+
+    for (idx = start; idx < start + task->count; idx++)
+    {
+        sai_apply_object_t *object = &apply->objects[apply->order[idx]];
+
+        if (apply->op == SAI_APPLY_OP_CREATE &&
+                sai_apply_visit(apply, object, sai_apply_visit_resolve, NULL))
+        {
+            /* dependency was not created */
+
+            sai_apply_complete(apply, object, SAI_STATUS_NOT_EXECUTED);
+            continue;
+        }
+
+        switch_id = object->switch_id;
+
+        apply->ready[start + count] = apply->order[idx];
+        apply->meta_keys[start + count] = object->meta_key;
+        apply->attr_counts[start + count] = object->attr_count;
+        apply->attr_lists[start + count] = object->attr_list;
+
+        count++;
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (!apply->thread_safe[api])
+    {
+        pthread_mutex_lock(&apply->locks[api]);
+    }
+
+    sai_apply_call(apply, object_type, switch_id, start, count);
+
+    if (!apply->thread_safe[api])
+    {
+        pthread_mutex_unlock(&apply->locks[api]);
+    }
+
+    for (idx = start; idx < start + count; idx++)
+    {
+        sai_apply_object_t *object = &apply->objects[apply->ready[idx]];
+
+        if (apply->statuses[idx] == SAI_STATUS_SUCCESS)
+        {
+            object->meta_key = apply->meta_keys[idx];
+        }
+
+        sai_apply_complete(apply, object, apply->statuses[idx]);
+    }
+}
+
+static void sai_apply_run_tasks(
+        _Inout_ sai_apply_t *apply)
+{
+    while (true)
+    {
+        uint32_t idx = __atomic_fetch_add(&apply->next_task, 1, __ATOMIC_RELAXED);
+
+        if (idx >= apply->level_end)
+        {
+            break;
+        }
+
+        sai_apply_execute_task(apply, &apply->tasks[idx]);
+    }
+}
+
+static void* sai_apply_worker(
+        _Inout_ void *arg)
+{
+    sai_apply_t *apply = (sai_apply_t*)arg;
+    uint64_t generation = 0;
+
+    pthread_mutex_lock(&apply->pool_lock);
+
+    while (true)
+    {
+        while (!apply->shutdown && apply->generation == generation)
+        {
+            pthread_cond_wait(&apply->pool_start, &apply->pool_lock);
+        }
+
+        if (apply->shutdown)
+        {
+            break;
+        }
+
+        generation = apply->generation;
+
+        pthread_mutex_unlock(&apply->pool_lock);
+
+        sai_apply_run_tasks(apply);
+
+        pthread_mutex_lock(&apply->pool_lock);
+
+        if (--apply->busy == 0)
+        {
+            pthread_cond_signal(&apply->pool_done);
+        }
+    }
+
+    pthread_mutex_unlock(&apply->pool_lock);
+
+    return NULL;
+}
+
+/*
+ * Starts worker threads, caller thread is one of the workers. Scheduler
+ * works with fewer workers when thread can't be created.
+ */
+
+static void sai_apply_start_pool(
+        _Inout_ sai_apply_t *apply)
+{
+    uint32_t threads = apply->config.threads ? apply->config.threads : 1;
+
+    pthread_mutex_init(&apply->pool_lock, NULL);
+    pthread_cond_init(&apply->pool_start, NULL);
+    pthread_cond_init(&apply->pool_done, NULL);
+
+    if (threads > 1)
+    {
+        apply->workers = malloc((threads - 1) * sizeof(pthread_t));
+    }
+
+    while (apply->workers != NULL && apply->worker_count < threads - 1)
+    {
+        if (pthread_create(&apply->workers[apply->worker_count], NULL, sai_apply_worker, apply) != 0)
+        {
+            SAI_META_LOG_WARN("failed to create worker thread, using %u threads", apply->worker_count + 1);
+            break;
+        }
+
+        apply->worker_count++;
+    }
+}
+
+static void sai_apply_stop_pool(
+        _Inout_ sai_apply_t *apply)
+{
+    uint32_t idx;
+
+    pthread_mutex_lock(&apply->pool_lock);
+
+    apply->shutdown = 1;
+
+    pthread_cond_broadcast(&apply->pool_start);
+
+    pthread_mutex_unlock(&apply->pool_lock);
+
+    for (idx = 0; idx < apply->worker_count; idx++)
+    {
+        pthread_join(apply->workers[idx], NULL);
+    }
+
+    free(apply->workers);
+
+    pthread_cond_destroy(&apply->pool_done);
+    pthread_cond_destroy(&apply->pool_start);
+    pthread_mutex_destroy(&apply->pool_lock);
+}
+
+/*
+ * Runs tasks first .. last - 1 on pool workers and caller thread, level
+ * with single task runs on caller thread only.
+ */
+
+static void sai_apply_run_level(
+        _Inout_ sai_apply_t *apply,
+        _In_ uint32_t first,
+        _In_ uint32_t last)
+{
+    apply->next_task = first;
+    apply->level_end = last;
+
+    if (apply->worker_count == 0 || last - first == 1)
+    {
+        sai_apply_run_tasks(apply);
+        return;
+    }
+
+    pthread_mutex_lock(&apply->pool_lock);
+
+    apply->busy = apply->worker_count;
+    apply->generation++;
+
+    pthread_cond_broadcast(&apply->pool_start);
+
+    pthread_mutex_unlock(&apply->pool_lock);
+
+    sai_apply_run_tasks(apply);
+
+    pthread_mutex_lock(&apply->pool_lock);
+
+    while (apply->busy != 0)
+    {
+        pthread_cond_wait(&apply->pool_done, &apply->pool_lock);
+    }
+
+    pthread_mutex_unlock(&apply->pool_lock);
+}
+
+static void sai_apply_free_execution(
+        _Inout_ sai_apply_t *apply)
+{
+    free(apply->order);
+    free(apply->meta_keys);
+    free(apply->attr_counts);
+    free(apply->attr_lists);
+    free(apply->statuses);
+    free(apply->ready);
+    free(apply->tasks);
+
+    apply->order = NULL;
+    apply->meta_keys = NULL;
+    apply->attr_counts = NULL;
+    apply->attr_lists = NULL;
+    apply->statuses = NULL;
+    apply->ready = NULL;
+    apply->tasks = NULL;
+}
+
+/*
+ * Executes objects first .. last - 1 which are in given state, ordered by
+ * level (descending for remove), split into tasks.
+ */
+
+static sai_status_t sai_apply_execute(
+        _Inout_ sai_apply_t *apply,
+        _In_ int op,
+        _In_ uint32_t first,
+        _In_ uint32_t last,
+        _In_ int state)
+{
+    uint32_t max_bulk_size = apply->config.max_bulk_size ? apply->config.max_bulk_size : SAI_APPLY_DEFAULT_MAX_BULK_SIZE;
+    sai_apply_rank_t *ranks;
+    uint32_t task_count = 0;
+    uint32_t levels = 0;
+    uint32_t count = 0;
+    uint32_t level_start;
+    uint32_t idx;
+
+    ranks = malloc((last - first + 1) * sizeof(sai_apply_rank_t));
+
+    apply->order = malloc((last - first + 1) * sizeof(uint32_t));
+    apply->meta_keys = malloc((last - first + 1) * sizeof(sai_object_meta_key_t));
+    apply->attr_counts = malloc((last - first + 1) * sizeof(uint32_t));
+    apply->attr_lists = malloc((last - first + 1) * sizeof(sai_attribute_t*));
+    apply->statuses = malloc((last - first + 1) * sizeof(sai_status_t));
+    apply->ready = malloc((last - first + 1) * sizeof(uint32_t));
+    apply->tasks = malloc((last - first + 1) * sizeof(sai_apply_task_t));
+
+    if (ranks == NULL || apply->order == NULL || apply->meta_keys == NULL || apply->attr_counts == NULL ||
+            apply->attr_lists == NULL || apply->statuses == NULL || apply->ready == NULL || apply->tasks == NULL)
+    {
+        free(ranks);
+        sai_apply_free_execution(apply);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = first; idx < last; idx++)
+    {
+        const sai_apply_object_t *object = &apply->objects[idx];
+
+        if (object->state != state)
+        {
+            continue;
+        }
+
+        ranks[count].rank = (op == SAI_APPLY_OP_CREATE) ? object->level : UINT32_MAX - object->level;
+        ranks[count].object_type = object->meta_key.objecttype;
+        ranks[count].switch_id = (op == SAI_APPLY_OP_CREATE) ? object->switch_id : SAI_NULL_OBJECT_ID;
+        ranks[count].index = idx;
+
+        count++;
+    }
+
+    qsort(ranks, count, sizeof(sai_apply_rank_t), sai_apply_rank_cmp);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        const sai_apply_rank_t *prev = (idx == 0) ? NULL : &ranks[idx - 1];
+
+        apply->order[idx] = ranks[idx].index;
+
+        if (prev == NULL || prev->rank != ranks[idx].rank || prev->object_type != ranks[idx].object_type ||
+                prev->switch_id != ranks[idx].switch_id || apply->tasks[task_count - 1].count == max_bulk_size)
+        {
+            apply->tasks[task_count].start = idx;
+            apply->tasks[task_count].count = 0;
+
+            task_count++;
+        }
+
+        apply->tasks[task_count - 1].count++;
+    }
+
+    apply->op = op;
+    apply->failed = 0;
+
+    for (level_start = 0; level_start < task_count; )
+    {
+        uint32_t rank = ranks[apply->tasks[level_start].start].rank;
+        uint32_t level_end = level_start;
+
+        while (level_end < task_count && ranks[apply->tasks[level_end].start].rank == rank)
+        {
+            level_end++;
+        }
+
+        if (apply->failed && apply->config.mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+        {
+            for (idx = apply->tasks[level_start].start; idx < count; idx++)
+            {
+                sai_apply_complete(apply, &apply->objects[apply->order[idx]], SAI_STATUS_NOT_EXECUTED);
+            }
+
+            break;
+        }
+
+        sai_apply_run_level(apply, level_start, level_end);
+
+        levels++;
+
+        level_start = level_end;
+    }
+
+    apply->stats.levels = levels;
+    apply->stats.tasks = task_count;
+
+    free(ranks);
+    sai_apply_free_execution(apply);
+
+    return apply->failed ? SAI_STATUS_FAILURE : SAI_STATUS_SUCCESS;
+}
+
+sai_apply_t* sai_apply_open(
+        _In_ const sai_apply_config_t *config)
+{
+    sai_apply_t *apply;
+    size_t idx;
+
+    if (config == NULL || config->apis == NULL)
+    {
+        SAI_META_LOG_ERROR("invalid apply scheduler config");
+        return NULL;
+    }
+
+    apply = calloc(1, sizeof(sai_apply_t));
+
+    if (apply == NULL)
+    {
+        return NULL;
+    }
+
+    apply->config = *config;
+
+    for (idx = 0; idx < SAI_APPLY_APIS; idx++)
+    {
+        apply->thread_safe[idx] = config->thread_safe;
+
+        pthread_mutex_init(&apply->locks[idx], NULL);
+    }
+
+    sai_apply_start_pool(apply);
+
+    return apply;
+}
+
+void sai_apply_close(
+        _Inout_ sai_apply_t *apply)
+{
+    size_t idx;
+
+    if (apply == NULL)
+    {
+        return;
+    }
+
+    sai_apply_stop_pool(apply);
+
+    while (apply->blocks != NULL)
+    {
+        sai_apply_block_t *block = apply->blocks;
+
+        apply->blocks = block->next;
+        free(block);
+    }
+
+    for (idx = 0; idx < SAI_APPLY_APIS; idx++)
+    {
+        pthread_mutex_destroy(&apply->locks[idx]);
+    }
+
+    free(apply->placeholders);
+    free(apply->objects);
+    free(apply);
+}
+
+sai_status_t sai_apply_set_thread_safe(
+        _Inout_ sai_apply_t *apply,
+        _In_ sai_api_t api,
+        _In_ bool thread_safe)
+{
+    size_t idx;
+
+    if (apply == NULL || (api >= SAI_API_MAX && (api < (sai_api_t)SAI_API_EXTENSIONS_RANGE_START || api >= (sai_api_t)SAI_API_EXTENSIONS_RANGE_END)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (api != SAI_API_UNSPECIFIED)
+    {
+        apply->thread_safe[sai_apply_api_index(api)] = thread_safe;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < SAI_APPLY_APIS; idx++)
+    {
+        apply->thread_safe[idx] = thread_safe;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_apply_add(
+        _Inout_ sai_apply_t *apply,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_apply_future_t *future)
+{
+    const sai_object_type_info_t *info;
+    sai_apply_object_t *object;
+    sai_status_t status;
+
+    if (apply == NULL || meta_key == NULL || (attr_count != 0 && attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = sai_metadata_get_object_type_info(meta_key->objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (info->isobjectid && sai_apply_find(apply, meta_key->objectkey.key.object_id) != UINT32_MAX)
+    {
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    if (apply->count == UINT32_MAX - 1)
+    {
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (apply->count == apply->capacity)
+    {
+        uint32_t capacity = apply->capacity ? apply->capacity * 2 : 64;
+        sai_apply_object_t *objects = realloc(apply->objects, capacity * sizeof(sai_apply_object_t));
+
+        if (objects == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        apply->objects = objects;
+        apply->capacity = capacity;
+    }
+
+    object = &apply->objects[apply->count];
+
+    memset(object, 0, sizeof(*object));
+
+    status = sai_apply_copy_attrs(apply, meta_key->objecttype, attr_count, attr_list, &object->attr_list);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    sai_metadata_normalize_object_meta_key(meta_key, &object->meta_key);
+
+    object->placeholder = info->isobjectid ? meta_key->objectkey.key.object_id : SAI_NULL_OBJECT_ID;
+    object->switch_id = switch_id;
+    object->attr_count = attr_count;
+    object->future = future;
+    object->state = SAI_APPLY_STATE_PENDING;
+
+    if (object->placeholder != SAI_NULL_OBJECT_ID)
+    {
+        status = sai_apply_insert(apply, apply->count);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    if (future != NULL)
+    {
+        future->status = SAI_STATUS_NOT_EXECUTED;
+        future->object_id = SAI_NULL_OBJECT_ID;
+    }
+
+    apply->count++;
+    apply->stats.objects++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_apply_create(
+        _Inout_ sai_apply_t *apply)
+{
+    sai_status_t status;
+
+    if (apply == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = sai_apply_compute_levels(apply);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    status = sai_apply_execute(apply, SAI_APPLY_OP_CREATE, apply->first_pending, apply->count, SAI_APPLY_STATE_PENDING);
+
+    if (status != SAI_STATUS_NO_MEMORY)
+    {
+        apply->first_pending = apply->count;
+    }
+
+    return status;
+}
+
+sai_status_t sai_apply_remove(
+        _Inout_ sai_apply_t *apply)
+{
+    if (apply == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_apply_execute(apply, SAI_APPLY_OP_REMOVE, 0, apply->first_pending, SAI_APPLY_STATE_CREATED);
+}
+
+void sai_apply_get_stats(
+        _In_ const sai_apply_t *apply,
+        _Out_ sai_apply_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (apply != NULL)
+    {
+        *stats = apply->stats;
+    }
+}
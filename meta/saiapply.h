@@ -0,0 +1,264 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saiapply.h
+ *
+ * @brief   This module defines SAI dependency level apply scheduler
+ */
+
+#ifndef __SAIAPPLY_H_
+#define __SAIAPPLY_H_
+
+/**
+ * @defgroup SAIAPPLY SAI - Dependency level apply scheduler
+ *
+ * Apply scheduler takes desired set of objects, whose attributes and entry
+ * key members can reference other objects of the set by placeholder object
+ * ids, and creates it level by level. Object with object id is added with
+ * placeholder object id chosen by caller, which must not collide with
+ * object id of existing object. Attribute value (object id, object list,
+ * ACL field and action data), entry key member or switch id equal to
+ * placeholder of added object is dependency, any other object id is passed
+ * as is.
+ *
+ * Object without dependencies has level 0, other object has level one
+ * above its highest dependency. Objects of one level do not depend on each
+ * other, so each level is split into tasks (objects of the same object type
+ * and switch, up to maximum bulk size) which worker threads execute in
+ * parallel through sai_metadata_generic_bulk_create. Worker threads are
+ * kept for the life of scheduler and wait for next level between levels. Next level starts when
+ * all tasks of previous level are done, placeholders are replaced by
+ * object ids created so far just before the call. Object whose dependency
+ * was not created is not executed. Removal of created objects runs the same
+ * way in reverse level order. Dependency cycle fails before anything is
+ * executed.
+ *
+ * API which is not thread safe is called by one worker at a time, other
+ * APIs are called concurrently. Object types without bulk support fall back
+ * to single calls.
+ *
+ * Functions of apply scheduler must be called from single thread.
+ *
+ * @{
+ */
+
+/**
+ * @brief Default maximum number of objects in single bulk call
+ */
+#define SAI_APPLY_DEFAULT_MAX_BULK_SIZE     1024
+
+/**
+ * @brief Apply scheduler configuration
+ */
+typedef struct _sai_apply_config_t
+{
+    /**
+     * @brief Method tables used for calls
+     */
+    const sai_apis_t *apis;
+
+    /**
+     * @brief Number of worker threads including caller, 0 for 1
+     *
+     * Threads are started by sai_apply_open and stopped by sai_apply_close.
+     */
+    uint32_t threads;
+
+    /**
+     * @brief Maximum number of objects in single bulk call, 0 for default
+     */
+    uint32_t max_bulk_size;
+
+    /**
+     * @brief Bulk error mode
+     *
+     * In stop on error mode level with failed object is the last executed
+     * level, objects of next levels complete with SAI_STATUS_NOT_EXECUTED.
+     */
+    sai_bulk_op_error_mode_t mode;
+
+    /**
+     * @brief All APIs are thread safe, can be changed per API later
+     */
+    bool thread_safe;
+
+} sai_apply_config_t;
+
+/**
+ * @brief Result of scheduled object
+ */
+typedef struct _sai_apply_future_t
+{
+    /**
+     * @brief Status of last executed create or remove
+     */
+    sai_status_t status;
+
+    /**
+     * @brief Object id of created object
+     */
+    sai_object_id_t object_id;
+
+} sai_apply_future_t;
+
+/**
+ * @brief Apply scheduler statistics
+ */
+typedef struct _sai_apply_stats_t
+{
+    /**
+     * @brief Number of added objects
+     */
+    uint64_t objects;
+
+    /**
+     * @brief Number of levels of last execution
+     */
+    uint32_t levels;
+
+    /**
+     * @brief Number of tasks of last execution
+     */
+    uint32_t tasks;
+
+    /**
+     * @brief Number of failed objects
+     */
+    uint64_t failures;
+
+    /**
+     * @brief Number of objects completed with SAI_STATUS_NOT_EXECUTED
+     *
+     * Object is not executed when its dependency was not created or, in
+     * stop on error mode, after failure.
+     */
+    uint64_t skipped;
+
+    /**
+     * @brief Number of bulk calls
+     */
+    uint64_t bulk_calls;
+
+    /**
+     * @brief Number of single calls
+     */
+    uint64_t single_calls;
+
+} sai_apply_stats_t;
+
+/**
+ * @brief Opaque apply scheduler
+ */
+typedef struct _sai_apply_t sai_apply_t;
+
+/**
+ * @brief Create apply scheduler
+ *
+ * @param[in] config Configuration
+ *
+ * @return Apply scheduler or NULL on error
+ */
+extern sai_apply_t* sai_apply_open(
+        _In_ const sai_apply_config_t *config);
+
+/**
+ * @brief Destroy apply scheduler, created objects are not removed
+ *
+ * @param[inout] apply Apply scheduler
+ */
+extern void sai_apply_close(
+        _Inout_ sai_apply_t *apply);
+
+/**
+ * @brief Set thread safety of API
+ *
+ * @param[inout] apply Apply scheduler
+ * @param[in] api API, SAI_API_UNSPECIFIED for all APIs
+ * @param[in] thread_safe API can be called concurrently
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_apply_set_thread_safe(
+        _Inout_ sai_apply_t *apply,
+        _In_ sai_api_t api,
+        _In_ bool thread_safe);
+
+/**
+ * @brief Add object to desired set
+ *
+ * Attributes are copied including list contents.
+ *
+ * @param[inout] apply Apply scheduler
+ * @param[in] meta_key Object type and key, placeholder object id for object
+ * with object id, SAI_NULL_OBJECT_ID when object is not referenced
+ * @param[in] switch_id Switch id or its placeholder, ignored for switch
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ * @param[out] future Optional result, valid after execution
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_ALREADY_EXISTS
+ * when placeholder is already used, failure status code on error
+ */
+extern sai_status_t sai_apply_add(
+        _Inout_ sai_apply_t *apply,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_apply_future_t *future);
+
+/**
+ * @brief Create objects added since last create
+ *
+ * Objects may depend on objects created by previous create.
+ *
+ * @param[inout] apply Apply scheduler
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects were created,
+ * #SAI_STATUS_INVALID_PARAMETER on dependency cycle,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_apply_create(
+        _Inout_ sai_apply_t *apply);
+
+/**
+ * @brief Remove all created objects in reverse level order
+ *
+ * @param[inout] apply Apply scheduler
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects were removed,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_apply_remove(
+        _Inout_ sai_apply_t *apply);
+
+/**
+ * @brief Get apply scheduler statistics
+ *
+ * @param[in] apply Apply scheduler
+ * @param[out] stats Statistics
+ */
+extern void sai_apply_get_stats(
+        _In_ const sai_apply_t *apply,
+        _Out_ sai_apply_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAIAPPLY_H_ */
@@ -0,0 +1,728 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saiapplytest.c
+ *
+ * @brief   This module implements SAI dependency level apply scheduler tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saiapply.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_MAX_CALLS 1024
+
+#define TEST_SWITCH_ID 0x21000000000000ULL
+
+/*
+ * Object ids created by fake method tables carry object type in high bits,
+ * placeholders are marked by top byte, so fake methods can check that no
+ * placeholder reaches them.
+ */
+
+#define TEST_OID(ot, idx) (((sai_object_id_t)(ot) << 48) | (sai_object_id_t)(idx))
+
+#define TEST_PLACEHOLDER(ot, idx) (0xff00000000000000ULL | TEST_OID(ot, idx))
+
+typedef struct _test_call_t
+{
+    char op;
+
+    sai_object_type_t object_type;
+
+    uint32_t count;
+
+} test_call_t;
+
+static pthread_mutex_t test_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static test_call_t test_calls[TEST_MAX_CALLS];
+
+static uint32_t test_call_count = 0;
+
+static uint32_t test_created[SAI_OBJECT_TYPE_MAX];
+
+static uint32_t test_removed[SAI_OBJECT_TYPE_MAX];
+
+static uint32_t test_fail_index = UINT32_MAX;
+
+static uint32_t test_inflight = 0;
+
+static uint32_t test_max_inflight = 0;
+
+static int test_slow = 0;
+
+static sai_route_api_t test_route_api;
+
+static sai_next_hop_api_t test_next_hop_api;
+
+static sai_router_interface_api_t test_router_interface_api;
+
+static sai_virtual_router_api_t test_virtual_router_api;
+
+static sai_apis_t test_apis;
+
+static void test_record(
+        _In_ char op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t count,
+        _In_ uint32_t done)
+{
+    pthread_mutex_lock(&test_mutex);
+
+    ASSERT_TRUE(test_call_count < TEST_MAX_CALLS, "too many calls");
+
+    test_calls[test_call_count].op = op;
+    test_calls[test_call_count].object_type = object_type;
+    test_calls[test_call_count].count = count;
+
+    test_call_count++;
+
+    if (op == 'c')
+    {
+        test_created[object_type] += done;
+    }
+    else
+    {
+        test_removed[object_type] += done;
+    }
+
+    pthread_mutex_unlock(&test_mutex);
+}
+
+static void test_check_oid(
+        _In_ sai_object_id_t object_id,
+        _In_ sai_object_type_t object_type)
+{
+    ASSERT_TRUE((object_id >> 48) == (sai_object_id_t)object_type, "0x%lx is not created %d", (unsigned long)object_id, object_type);
+}
+
+static sai_object_id_t test_new_oid(
+        _In_ sai_object_type_t object_type)
+{
+    static uint32_t next = 0;
+
+    return TEST_OID(object_type, __atomic_add_fetch(&next, 1, __ATOMIC_RELAXED));
+}
+
+static sai_status_t test_bulk_statuses(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t idx;
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (status != SAI_STATUS_SUCCESS && mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+        {
+            object_statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+            continue;
+        }
+
+        object_statuses[idx] = (object_type == SAI_OBJECT_TYPE_NEXT_HOP && idx == test_fail_index) ? SAI_STATUS_INVALID_PARAMETER : SAI_STATUS_SUCCESS;
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+static sai_status_t test_create_route_entries(
+        _In_ uint32_t object_count,
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    uint32_t inflight = __atomic_add_fetch(&test_inflight, 1, __ATOMIC_SEQ_CST);
+    uint32_t idx;
+
+    pthread_mutex_lock(&test_mutex);
+
+    if (inflight > test_max_inflight)
+    {
+        test_max_inflight = inflight;
+    }
+
+    pthread_mutex_unlock(&test_mutex);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        test_check_oid(route_entry[idx].vr_id, SAI_OBJECT_TYPE_VIRTUAL_ROUTER);
+        test_check_oid(attr_list[idx][0].value.oid, SAI_OBJECT_TYPE_NEXT_HOP);
+
+        ASSERT_TRUE(route_entry[idx].switch_id == TEST_SWITCH_ID, "switch id passed as is");
+    }
+
+    if (test_slow)
+    {
+        struct timespec ts = { 0, 1000000 };
+
+        nanosleep(&ts, NULL);
+    }
+
+    __atomic_sub_fetch(&test_inflight, 1, __ATOMIC_SEQ_CST);
+
+    test_record('c', SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count, object_count);
+
+    return test_bulk_statuses(SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count, mode, object_statuses);
+}
+
+static sai_status_t test_remove_route_entries(
+        _In_ uint32_t object_count,
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    test_record('r', SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count, object_count);
+
+    return test_bulk_statuses(SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count, mode, object_statuses);
+}
+
+static sai_status_t test_create_next_hops(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t object_count,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_object_id_t *object_id,
+        _Out_ sai_status_t *object_statuses)
+{
+    sai_status_t status = test_bulk_statuses(SAI_OBJECT_TYPE_NEXT_HOP, object_count, mode, object_statuses);
+    uint32_t done = 0;
+    uint32_t idx;
+
+    test_check_oid(switch_id, SAI_OBJECT_TYPE_SWITCH);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_id[idx] = SAI_NULL_OBJECT_ID;
+
+        test_check_oid(attr_list[idx][0].value.oid, SAI_OBJECT_TYPE_ROUTER_INTERFACE);
+
+        if (object_statuses[idx] == SAI_STATUS_SUCCESS)
+        {
+            object_id[idx] = test_new_oid(SAI_OBJECT_TYPE_NEXT_HOP);
+            done++;
+        }
+    }
+
+    test_record('c', SAI_OBJECT_TYPE_NEXT_HOP, object_count, done);
+
+    return status;
+}
+
+static sai_status_t test_remove_next_hops(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_id_t *object_id,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    test_record('r', SAI_OBJECT_TYPE_NEXT_HOP, object_count, object_count);
+
+    return test_bulk_statuses(SAI_OBJECT_TYPE_NEXT_HOP, object_count, mode, object_statuses);
+}
+
+static sai_status_t test_create_router_interface(
+        _Out_ sai_object_id_t *router_interface_id,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    test_check_oid(attr_list[0].value.oid, SAI_OBJECT_TYPE_VIRTUAL_ROUTER);
+
+    *router_interface_id = test_new_oid(SAI_OBJECT_TYPE_ROUTER_INTERFACE);
+
+    test_record('c', SAI_OBJECT_TYPE_ROUTER_INTERFACE, 1, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_remove_router_interface(
+        _In_ sai_object_id_t router_interface_id)
+{
+    test_check_oid(router_interface_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE);
+
+    test_record('r', SAI_OBJECT_TYPE_ROUTER_INTERFACE, 1, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_create_virtual_router(
+        _Out_ sai_object_id_t *virtual_router_id,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    *virtual_router_id = test_new_oid(SAI_OBJECT_TYPE_VIRTUAL_ROUTER);
+
+    test_record('c', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_remove_virtual_router(
+        _In_ sai_object_id_t virtual_router_id)
+{
+    test_check_oid(virtual_router_id, SAI_OBJECT_TYPE_VIRTUAL_ROUTER);
+
+    test_record('r', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void test_init()
+{
+    memset(&test_route_api, 0, sizeof(test_route_api));
+    memset(&test_next_hop_api, 0, sizeof(test_next_hop_api));
+    memset(&test_router_interface_api, 0, sizeof(test_router_interface_api));
+    memset(&test_virtual_router_api, 0, sizeof(test_virtual_router_api));
+    memset(&test_apis, 0, sizeof(test_apis));
+
+    test_route_api.create_route_entries = test_create_route_entries;
+    test_route_api.remove_route_entries = test_remove_route_entries;
+
+    test_next_hop_api.create_next_hops = test_create_next_hops;
+    test_next_hop_api.remove_next_hops = test_remove_next_hops;
+
+    test_router_interface_api.create_router_interface = test_create_router_interface;
+    test_router_interface_api.remove_router_interface = test_remove_router_interface;
+
+    test_virtual_router_api.create_virtual_router = test_create_virtual_router;
+    test_virtual_router_api.remove_virtual_router = test_remove_virtual_router;
+
+    test_apis.route_api = &test_route_api;
+    test_apis.next_hop_api = &test_next_hop_api;
+    test_apis.router_interface_api = &test_router_interface_api;
+    test_apis.virtual_router_api = &test_virtual_router_api;
+
+    memset(test_created, 0, sizeof(test_created));
+    memset(test_removed, 0, sizeof(test_removed));
+
+    test_call_count = 0;
+    test_fail_index = UINT32_MAX;
+    test_max_inflight = 0;
+    test_slow = 0;
+}
+
+static sai_apply_t* test_open(
+        _In_ uint32_t threads,
+        _In_ uint32_t max_bulk_size,
+        _In_ sai_bulk_op_error_mode_t mode)
+{
+    sai_apply_config_t config;
+    sai_apply_t *apply;
+
+    config.apis = &test_apis;
+    config.threads = threads;
+    config.max_bulk_size = max_bulk_size;
+    config.mode = mode;
+    config.thread_safe = true;
+
+    apply = sai_apply_open(&config);
+
+    ASSERT_TRUE(apply != NULL, "open failed");
+
+    return apply;
+}
+
+static uint32_t test_level(
+        _In_ sai_object_type_t object_type)
+{
+    switch (object_type)
+    {
+        case SAI_OBJECT_TYPE_VIRTUAL_ROUTER:
+            return 0;
+
+        case SAI_OBJECT_TYPE_ROUTER_INTERFACE:
+            return 1;
+
+        case SAI_OBJECT_TYPE_NEXT_HOP:
+            return 2;
+
+        default:
+            return 3;
+    }
+}
+
+/*
+ * Checks that recorded calls of operation are in ascending (create) or
+ * descending (remove) level order.
+ */
+
+static void test_check_order(
+        _In_ char op)
+{
+    uint32_t prev = (op == 'c') ? 0 : UINT32_MAX;
+    uint32_t idx;
+
+    for (idx = 0; idx < test_call_count; idx++)
+    {
+        uint32_t level = test_level(test_calls[idx].object_type);
+
+        if (test_calls[idx].op != op)
+        {
+            continue;
+        }
+
+        ASSERT_TRUE((op == 'c') ? (level >= prev) : (level <= prev), "call %u %c of %d out of order", idx, op, test_calls[idx].object_type);
+
+        prev = level;
+    }
+}
+
+static void test_add_oid(
+        _In_ sai_apply_t *apply,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t idx,
+        _In_ sai_attr_id_t attr_id,
+        _In_ sai_object_id_t ref,
+        _Out_ sai_apply_future_t *future)
+{
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attr;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = object_type;
+    meta_key.objectkey.key.object_id = TEST_PLACEHOLDER(object_type, idx);
+
+    attr.id = attr_id;
+    attr.value.oid = ref;
+
+    ASSERT_TRUE(sai_apply_add(apply, &meta_key, TEST_SWITCH_ID, (ref == SAI_NULL_OBJECT_ID) ? 0 : 1, &attr, future) == SAI_STATUS_SUCCESS,
+            "add %d %u", object_type, idx);
+}
+
+static void test_add_route(
+        _In_ sai_apply_t *apply,
+        _In_ uint32_t idx,
+        _In_ sai_object_id_t vr_id,
+        _In_ sai_object_id_t next_hop_id,
+        _Out_ sai_apply_future_t *future)
+{
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attr;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+    meta_key.objectkey.key.route_entry.switch_id = TEST_SWITCH_ID;
+    meta_key.objectkey.key.route_entry.vr_id = vr_id;
+    meta_key.objectkey.key.route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    meta_key.objectkey.key.route_entry.destination.addr.ip4 = 0x0a000000 + (idx << 8);
+    meta_key.objectkey.key.route_entry.destination.mask.ip4 = 0xffffff00;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attr.value.oid = next_hop_id;
+
+    ASSERT_TRUE(sai_apply_add(apply, &meta_key, TEST_SWITCH_ID, 1, &attr, future) == SAI_STATUS_SUCCESS, "add route %u", idx);
+}
+
+/*
+ * Adds 2 virtual routers, 2 router interfaces, 4 next hops and routes, in
+ * reverse of dependency order.
+ */
+
+static void test_add_topology(
+        _In_ sai_apply_t *apply,
+        _In_ uint32_t routes,
+        _Out_ sai_apply_future_t *futures)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < routes; idx++)
+    {
+        test_add_route(apply, idx, TEST_PLACEHOLDER(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, idx % 2),
+                TEST_PLACEHOLDER(SAI_OBJECT_TYPE_NEXT_HOP, idx % 4), futures ? &futures[8 + idx] : NULL);
+    }
+
+    for (idx = 0; idx < 4; idx++)
+    {
+        test_add_oid(apply, SAI_OBJECT_TYPE_NEXT_HOP, idx, SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID,
+                TEST_PLACEHOLDER(SAI_OBJECT_TYPE_ROUTER_INTERFACE, idx % 2), futures ? &futures[4 + idx] : NULL);
+    }
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        test_add_oid(apply, SAI_OBJECT_TYPE_ROUTER_INTERFACE, idx, SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID,
+                TEST_PLACEHOLDER(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, idx), futures ? &futures[2 + idx] : NULL);
+
+        test_add_oid(apply, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, idx, 0, SAI_NULL_OBJECT_ID, futures ? &futures[idx] : NULL);
+    }
+}
+
+static void test_levels()
+{
+    sai_apply_future_t futures[8 + 300];
+    sai_apply_stats_t stats;
+    sai_apply_t *apply;
+    uint32_t idx;
+
+    test_init();
+
+    apply = test_open(4, 64, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_add_topology(apply, 300, futures);
+
+    ASSERT_TRUE(test_call_count == 0, "nothing executed before create");
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_SUCCESS, "create");
+
+    test_check_order('c');
+
+    for (idx = 0; idx < 8 + 300; idx++)
+    {
+        ASSERT_TRUE(futures[idx].status == SAI_STATUS_SUCCESS, "object %u status %d", idx, futures[idx].status);
+    }
+
+    test_check_oid(futures[0].object_id, SAI_OBJECT_TYPE_VIRTUAL_ROUTER);
+    test_check_oid(futures[7].object_id, SAI_OBJECT_TYPE_NEXT_HOP);
+
+    ASSERT_TRUE(test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY] == 300, "routes %u", test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY]);
+    ASSERT_TRUE(test_created[SAI_OBJECT_TYPE_NEXT_HOP] == 4, "next hops");
+
+    sai_apply_get_stats(apply, &stats);
+
+    /* virtual routers, router interfaces, next hops, 5 route chunks */
+
+    ASSERT_TRUE(stats.levels == 4, "levels %u", stats.levels);
+    ASSERT_TRUE(stats.tasks == 8, "tasks %u", stats.tasks);
+    ASSERT_TRUE(stats.objects == 308, "objects");
+    ASSERT_TRUE(stats.bulk_calls == 6, "bulk calls %lu", (unsigned long)stats.bulk_calls);
+    ASSERT_TRUE(stats.single_calls == 4, "single calls %lu", (unsigned long)stats.single_calls);
+
+    ASSERT_TRUE(sai_apply_remove(apply) == SAI_STATUS_SUCCESS, "remove");
+
+    test_check_order('r');
+
+    ASSERT_TRUE(test_removed[SAI_OBJECT_TYPE_ROUTE_ENTRY] == 300, "routes removed");
+    ASSERT_TRUE(test_removed[SAI_OBJECT_TYPE_VIRTUAL_ROUTER] == 2, "virtual routers removed");
+
+    /* nothing left to remove */
+
+    test_call_count = 0;
+
+    ASSERT_TRUE(sai_apply_remove(apply) == SAI_STATUS_SUCCESS, "remove again");
+    ASSERT_TRUE(test_call_count == 0, "no calls");
+
+    sai_apply_close(apply);
+}
+
+static void test_thread_safety()
+{
+    sai_apply_t *apply;
+
+    test_init();
+
+    test_slow = 1;
+
+    apply = test_open(8, 10, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    ASSERT_TRUE(sai_apply_set_thread_safe(apply, SAI_API_ROUTE, false) == SAI_STATUS_SUCCESS, "route api not thread safe");
+
+    test_add_topology(apply, 200, NULL);
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_SUCCESS, "create");
+    ASSERT_TRUE(test_max_inflight == 1, "route api called concurrently %u", test_max_inflight);
+    ASSERT_TRUE(test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY] == 200, "routes");
+
+    sai_apply_close(apply);
+}
+
+static void test_failure()
+{
+    sai_apply_future_t futures[8 + 8];
+    sai_apply_stats_t stats;
+    sai_apply_t *apply;
+    uint32_t idx;
+
+    test_init();
+
+    apply = test_open(2, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_add_topology(apply, 8, futures);
+
+    /* second next hop fails, routes using it are not executed */
+
+    test_fail_index = 1;
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_FAILURE, "create");
+
+    ASSERT_TRUE(futures[5].status == SAI_STATUS_INVALID_PARAMETER, "next hop status %d", futures[5].status);
+    ASSERT_TRUE(futures[5].object_id == SAI_NULL_OBJECT_ID, "failed next hop has no object id");
+
+    for (idx = 0; idx < 8; idx++)
+    {
+        sai_status_t expected = (idx % 4 == 1) ? SAI_STATUS_NOT_EXECUTED : SAI_STATUS_SUCCESS;
+
+        ASSERT_TRUE(futures[8 + idx].status == expected, "route %u status %d", idx, futures[8 + idx].status);
+    }
+
+    ASSERT_TRUE(test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY] == 6, "routes %u", test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY]);
+
+    sai_apply_get_stats(apply, &stats);
+
+    ASSERT_TRUE(stats.failures == 1, "failures %lu", (unsigned long)stats.failures);
+    ASSERT_TRUE(stats.skipped == 2, "skipped %lu", (unsigned long)stats.skipped);
+
+    sai_apply_close(apply);
+
+    /* stop on error does not start next level */
+
+    test_init();
+
+    apply = test_open(2, 0, SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR);
+
+    test_add_topology(apply, 8, futures);
+
+    test_fail_index = 1;
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_FAILURE, "create");
+    ASSERT_TRUE(futures[6].status == SAI_STATUS_NOT_EXECUTED, "rest of bulk not executed");
+    ASSERT_TRUE(futures[8].status == SAI_STATUS_NOT_EXECUTED, "next level not executed");
+    ASSERT_TRUE(test_created[SAI_OBJECT_TYPE_ROUTE_ENTRY] == 0, "no routes");
+
+    sai_apply_close(apply);
+}
+
+static void test_cycle()
+{
+    sai_apply_t *apply;
+
+    test_init();
+
+    apply = test_open(1, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_add_oid(apply, SAI_OBJECT_TYPE_ROUTER_INTERFACE, 0, SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID,
+            TEST_PLACEHOLDER(SAI_OBJECT_TYPE_NEXT_HOP, 0), NULL);
+    test_add_oid(apply, SAI_OBJECT_TYPE_NEXT_HOP, 0, SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID,
+            TEST_PLACEHOLDER(SAI_OBJECT_TYPE_ROUTER_INTERFACE, 0), NULL);
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_INVALID_PARAMETER, "cycle");
+    ASSERT_TRUE(test_call_count == 0, "nothing executed");
+
+    sai_apply_close(apply);
+}
+
+static void test_incremental()
+{
+    sai_apply_future_t futures[2];
+    sai_apply_stats_t stats;
+    sai_apply_t *apply;
+
+    test_init();
+
+    apply = test_open(2, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_add_oid(apply, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0, 0, SAI_NULL_OBJECT_ID, &futures[0]);
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_SUCCESS, "create virtual router");
+
+    /* second round references object created by the first one */
+
+    test_add_oid(apply, SAI_OBJECT_TYPE_ROUTER_INTERFACE, 0, SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID,
+            TEST_PLACEHOLDER(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0), &futures[1]);
+
+    ASSERT_TRUE(sai_apply_create(apply) == SAI_STATUS_SUCCESS, "create router interface");
+    ASSERT_TRUE(futures[1].status == SAI_STATUS_SUCCESS, "router interface created");
+
+    sai_apply_get_stats(apply, &stats);
+
+    ASSERT_TRUE(stats.levels == 1, "single level executed");
+
+    test_call_count = 0;
+
+    ASSERT_TRUE(sai_apply_remove(apply) == SAI_STATUS_SUCCESS, "remove");
+    ASSERT_TRUE(test_call_count == 2, "calls %u", test_call_count);
+    ASSERT_TRUE(test_calls[0].object_type == SAI_OBJECT_TYPE_ROUTER_INTERFACE, "router interface removed first");
+
+    sai_apply_close(apply);
+}
+
+static void test_invalid()
+{
+    sai_apply_config_t config;
+    sai_apply_t *apply;
+    sai_object_meta_key_t meta_key;
+
+    test_init();
+
+    memset(&config, 0, sizeof(config));
+
+    ASSERT_TRUE(sai_apply_open(&config) == NULL, "open without apis");
+    ASSERT_TRUE(sai_apply_open(NULL) == NULL, "open without config");
+
+    apply = test_open(1, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_add_oid(apply, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0, 0, SAI_NULL_OBJECT_ID, NULL);
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = SAI_OBJECT_TYPE_VIRTUAL_ROUTER;
+    meta_key.objectkey.key.object_id = TEST_PLACEHOLDER(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0);
+
+    ASSERT_TRUE(sai_apply_add(apply, &meta_key, TEST_SWITCH_ID, 0, NULL, NULL) == SAI_STATUS_ITEM_ALREADY_EXISTS, "duplicate placeholder");
+
+    meta_key.objecttype = SAI_OBJECT_TYPE_NULL;
+
+    ASSERT_TRUE(sai_apply_add(apply, &meta_key, TEST_SWITCH_ID, 0, NULL, NULL) == SAI_STATUS_INVALID_OBJECT_TYPE, "invalid object type");
+    ASSERT_TRUE(sai_apply_add(apply, NULL, TEST_SWITCH_ID, 0, NULL, NULL) == SAI_STATUS_INVALID_PARAMETER, "null meta key");
+    ASSERT_TRUE(sai_apply_set_thread_safe(apply, (sai_api_t)(SAI_API_MAX + 1), true) == SAI_STATUS_INVALID_PARAMETER, "invalid api");
+
+    sai_apply_close(apply);
+}
+
+int main()
+{
+    test_levels();
+
+    test_thread_safety();
+
+    test_failure();
+
+    test_cycle();
+
+    test_incremental();
+
+    test_invalid();
+
+    return 0;
+}
@@ -0,0 +1,1518 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saibulker.c
+ *
+ * @brief   This module implements SAI cross object type bulker
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saibulker.h"
+
+/*
+ * Operations are numbered in flush phase order, so operation on key with
+ * queued operation of greater number must flush first.
+ */
+
+#define SAI_BULKER_OP_CREATE 0
+#define SAI_BULKER_OP_SET 1
+#define SAI_BULKER_OP_REMOVE 2
+#define SAI_BULKER_OPS 3
+
+#define SAI_BULKER_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_BULKER_BLOCK_SIZE (64 * 1024)
+
+#define SAI_BULKER_KEYS_MIN_SIZE 64
+
+#define SAI_BULKER_PLACEHOLDERS_MIN_SIZE 64
+
+#define SAI_BULKER_UNSCHEDULED UINT32_MAX
+
+/*
+ * Arena block holding attribute copies of queued operations, data follows
+ * the header.
+ */
+
+typedef struct _sai_bulker_block_t
+{
+    struct _sai_bulker_block_t *next;
+
+    size_t size;
+
+    size_t used;
+
+} sai_bulker_block_t;
+
+typedef struct _sai_bulker_queue_t
+{
+    sai_object_type_t object_type;
+
+    int op;
+
+    uint32_t position;
+
+    uint32_t count;
+
+    size_t key_size;
+
+    sai_object_id_t switch_id;
+
+    uint64_t first_time;
+
+    int bulk_unsupported;
+
+    sai_object_meta_key_t *meta_keys;
+
+    uint32_t *attr_counts;
+
+    const sai_attribute_t **attr_lists;
+
+    /* the same lists as attr_lists, placeholders are resolved through them */
+
+    sai_attribute_t **attr_copies;
+
+    sai_attribute_t *set_attrs;
+
+    sai_status_t *statuses;
+
+    sai_bulker_future_t **futures;
+
+    /* placeholder of each queued create, SAI_NULL_OBJECT_ID when none */
+
+    sai_object_id_t *placeholders;
+
+    sai_bulker_block_t *blocks;
+
+} sai_bulker_queue_t;
+
+/*
+ * Open addressing set of keys of queued operations with linear probing.
+ * Key points to normalized key stored in queue, op is the latest phase
+ * queued for the key and position is schedule position of its queue.
+ */
+
+typedef struct _sai_bulker_key_t
+{
+    uint64_t hash;
+
+    const sai_object_meta_key_t *key;
+
+    uint32_t position;
+
+    int op;
+
+} sai_bulker_key_t;
+
+/*
+ * Open addressing table of placeholders of queued creates with linear
+ * probing. Object id is set when create succeeds.
+ */
+
+#define SAI_BULKER_PLACEHOLDER_PENDING 0
+#define SAI_BULKER_PLACEHOLDER_CREATED 1
+#define SAI_BULKER_PLACEHOLDER_FAILED 2
+
+typedef struct _sai_bulker_placeholder_t
+{
+    sai_object_id_t placeholder;
+
+    sai_object_id_t object_id;
+
+    int state;
+
+} sai_bulker_placeholder_t;
+
+struct _sai_bulker_t
+{
+    sai_bulker_config_t config;
+
+    sai_bulker_queue_t queues[SAI_BULKER_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+    /*
+     * Queues in flush order, creates by ascending dependency level, sets,
+     * removes by descending dependency level.
+     */
+
+    sai_bulker_queue_t *schedule[SAI_BULKER_OPS * SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+    uint32_t schedule_count;
+
+    sai_bulker_key_t *keys;
+
+    size_t keys_size;
+
+    size_t keys_used;
+
+    sai_bulker_placeholder_t *placeholders;
+
+    size_t placeholders_size;
+
+    size_t placeholders_used;
+
+    uint32_t pending;
+
+    uint64_t oldest;
+
+    sai_bulker_stats_t stats;
+};
+
+/*
+ * Dependency level of object type, 0 for types which use no other type.
+ * Object type used by key member or by create or set attribute of other
+ * type gets lower level than its user. Read only attributes are ignored,
+ * they are filled by switch. Edge closing dependency cycle (including self
+ * reference) is ignored as well, so levels are defined for any graph.
+ */
+
+#define SAI_BULKER_LEVEL_NEW 0
+#define SAI_BULKER_LEVEL_VISITING 1
+#define SAI_BULKER_LEVEL_DONE 2
+
+static uint32_t sai_bulker_compute_level(
+        _In_ size_t index,
+        _Inout_ uint32_t *levels,
+        _Inout_ uint8_t *states)
+{
+    sai_object_type_t object_type = sai_metadata_object_type_from_index(index);
+    uint32_t level = 0;
+    size_t used;
+    size_t idx;
+
+    if (states[index] == SAI_BULKER_LEVEL_DONE)
+    {
+        return levels[index];
+    }
+
+    states[index] = SAI_BULKER_LEVEL_VISITING;
+
+    for (used = 1; used < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; used++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(sai_metadata_object_type_from_index(used));
+
+        if (info == NULL || info->revgraphmembers == NULL || states[used] == SAI_BULKER_LEVEL_VISITING)
+        {
+            continue;
+        }
+
+        for (idx = 0; idx < info->revgraphmemberscount; idx++)
+        {
+            const sai_rev_graph_member_t *m = info->revgraphmembers[idx];
+
+            if (m == NULL || m->depobjecttype != object_type ||
+                    (m->attrmetadata != NULL && m->attrmetadata->isreadonly))
+            {
+                continue;
+            }
+
+            if (sai_bulker_compute_level(used, levels, states) + 1 > level)
+            {
+                level = levels[used] + 1;
+            }
+
+            break;
+        }
+    }
+
+    levels[index] = level;
+    states[index] = SAI_BULKER_LEVEL_DONE;
+
+    return level;
+}
+
+static void sai_bulker_schedule_add(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ int op,
+        _In_ size_t index)
+{
+    sai_bulker_queue_t *q = &bulker->queues[op][index];
+
+    q->position = bulker->schedule_count;
+
+    bulker->schedule[bulker->schedule_count++] = q;
+}
+
+static sai_status_t sai_bulker_build_schedule(
+        _Inout_ sai_bulker_t *bulker)
+{
+    uint32_t *levels = calloc(SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, sizeof(uint32_t));
+    uint8_t *states = calloc(SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, sizeof(uint8_t));
+    uint32_t max_level = 0;
+    uint32_t level;
+    size_t index;
+    int op;
+
+    if (levels == NULL || states == NULL)
+    {
+        free(levels);
+        free(states);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (op = 0; op < SAI_BULKER_OPS; op++)
+    {
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            sai_bulker_queue_t *q = &bulker->queues[op][index];
+
+            q->object_type = sai_metadata_object_type_from_index(index);
+            q->op = op;
+            q->position = SAI_BULKER_UNSCHEDULED;
+        }
+    }
+
+    for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        if (sai_metadata_get_object_type_info(sai_metadata_object_type_from_index(index)) == NULL)
+        {
+            continue;
+        }
+
+        sai_bulker_compute_level(index, levels, states);
+
+        bulker->queues[SAI_BULKER_OP_CREATE][index].key_size = sai_metadata_get_object_key_size(sai_metadata_object_type_from_index(index));
+        bulker->queues[SAI_BULKER_OP_SET][index].key_size = bulker->queues[SAI_BULKER_OP_CREATE][index].key_size;
+        bulker->queues[SAI_BULKER_OP_REMOVE][index].key_size = bulker->queues[SAI_BULKER_OP_CREATE][index].key_size;
+
+        if (levels[index] > max_level)
+        {
+            max_level = levels[index];
+        }
+    }
+
+    for (level = 0; level <= max_level; level++)
+    {
+        for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            if (bulker->queues[SAI_BULKER_OP_CREATE][index].key_size != 0 && levels[index] == level)
+            {
+                sai_bulker_schedule_add(bulker, SAI_BULKER_OP_CREATE, index);
+            }
+        }
+    }
+
+    for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        if (bulker->queues[SAI_BULKER_OP_SET][index].key_size != 0)
+        {
+            sai_bulker_schedule_add(bulker, SAI_BULKER_OP_SET, index);
+        }
+    }
+
+    for (level = max_level + 1; level-- > 0; )
+    {
+        for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            if (bulker->queues[SAI_BULKER_OP_REMOVE][index].key_size != 0 && levels[index] == level)
+            {
+                sai_bulker_schedule_add(bulker, SAI_BULKER_OP_REMOVE, index);
+            }
+        }
+    }
+
+    free(levels);
+    free(states);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_bulker_queue_init(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q)
+{
+    size_t size = bulker->config.max_bulk_size;
+
+    q->meta_keys = calloc(size, sizeof(sai_object_meta_key_t));
+    q->attr_counts = calloc(size, sizeof(uint32_t));
+    q->attr_lists = calloc(size, sizeof(sai_attribute_t*));
+    q->attr_copies = calloc(size, sizeof(sai_attribute_t*));
+    q->set_attrs = calloc(size, sizeof(sai_attribute_t));
+    q->statuses = calloc(size, sizeof(sai_status_t));
+    q->futures = calloc(size, sizeof(sai_bulker_future_t*));
+    q->placeholders = calloc(size, sizeof(sai_object_id_t));
+
+    if (q->meta_keys == NULL || q->attr_counts == NULL || q->attr_lists == NULL || q->attr_copies == NULL ||
+            q->set_attrs == NULL || q->statuses == NULL || q->futures == NULL || q->placeholders == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Queue arena, memory is released all at once when queue is flushed. The
+ * newest block is kept for reuse.
+ */
+
+static void* sai_bulker_alloc(
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ size_t size)
+{
+    sai_bulker_block_t *block = q->blocks;
+    void *ptr;
+
+    size = SAI_BULKER_ALIGN(size);
+
+    if (block == NULL || block->used + size > block->size)
+    {
+        size_t block_size = (size > SAI_BULKER_BLOCK_SIZE) ? size : SAI_BULKER_BLOCK_SIZE;
+
+        block = malloc(SAI_BULKER_ALIGN(sizeof(sai_bulker_block_t)) + block_size);
+
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        block->next = q->blocks;
+        block->size = block_size;
+        block->used = 0;
+
+        q->blocks = block;
+    }
+
+    ptr = (uint8_t*)block + SAI_BULKER_ALIGN(sizeof(sai_bulker_block_t)) + block->used;
+
+    block->used += size;
+
+    return ptr;
+}
+
+static void sai_bulker_reset_arena(
+        _Inout_ sai_bulker_queue_t *q)
+{
+    sai_bulker_block_t *block;
+
+    if (q->blocks == NULL)
+    {
+        return;
+    }
+
+    while ((block = q->blocks->next) != NULL)
+    {
+        q->blocks->next = block->next;
+        free(block);
+    }
+
+    q->blocks->used = 0;
+}
+
+/*
+ * Copies attributes into queue arena, list contents included, with single
+ * allocation per attribute list.
+ */
+
+static sai_status_t sai_bulker_copy_attrs(
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_attribute_t **copy)
+{
+    sai_status_t status;
+    void *buffer;
+    size_t size;
+
+    *copy = NULL;
+
+    if (attr_count == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    status = sai_metadata_get_attr_list_copy_size(q->object_type, attr_count, attr_list, &size);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    buffer = sai_bulker_alloc(q, size);
+
+    if (buffer == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    return sai_metadata_deep_copy_attr_list(q->object_type, attr_count, attr_list, buffer, copy);
+}
+
+static sai_bulker_key_t* sai_bulker_find_key(
+        _In_ const sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *key,
+        _In_ size_t key_size,
+        _In_ uint64_t hash)
+{
+    size_t mask = bulker->keys_size - 1;
+    size_t idx;
+
+    if (bulker->keys_size == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = hash & mask; bulker->keys[idx].key != NULL; idx = (idx + 1) & mask)
+    {
+        const sai_bulker_key_t *entry = &bulker->keys[idx];
+
+        if (entry->hash == hash && entry->key->objecttype == key->objecttype &&
+                memcmp(&entry->key->objectkey.key, &key->objectkey.key, key_size) == 0)
+        {
+            return &bulker->keys[idx];
+        }
+    }
+
+    return &bulker->keys[idx];
+}
+
+static sai_status_t sai_bulker_grow_keys(
+        _Inout_ sai_bulker_t *bulker)
+{
+    size_t size = (bulker->keys_size == 0) ? SAI_BULKER_KEYS_MIN_SIZE : bulker->keys_size * 2;
+    sai_bulker_key_t *old = bulker->keys;
+    size_t old_size = bulker->keys_size;
+    size_t idx;
+
+    bulker->keys = calloc(size, sizeof(sai_bulker_key_t));
+
+    if (bulker->keys == NULL)
+    {
+        bulker->keys = old;
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    bulker->keys_size = size;
+
+    for (idx = 0; idx < old_size; idx++)
+    {
+        size_t pos;
+
+        if (old[idx].key == NULL)
+        {
+            continue;
+        }
+
+        for (pos = old[idx].hash & (size - 1); bulker->keys[pos].key != NULL; pos = (pos + 1) & (size - 1))
+        {
+        }
+
+        bulker->keys[pos] = old[idx];
+    }
+
+    free(old);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_bulker_insert_key(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_bulker_queue_t *q,
+        _In_ uint32_t idx)
+{
+    const sai_object_meta_key_t *key = &q->meta_keys[idx];
+    uint64_t hash = sai_metadata_hash_object_meta_key(key);
+    sai_bulker_key_t *entry;
+
+    if ((bulker->keys_used + 1) * 2 > bulker->keys_size)
+    {
+        sai_status_t status = sai_bulker_grow_keys(bulker);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    entry = sai_bulker_find_key(bulker, key, q->key_size, hash);
+
+    if (entry->key == NULL)
+    {
+        entry->hash = hash;
+        entry->key = key;
+        entry->op = q->op;
+        entry->position = q->position;
+
+        bulker->keys_used++;
+    }
+    else if (q->op >= entry->op)
+    {
+        entry->key = key;
+        entry->op = q->op;
+        entry->position = q->position;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Returns entry of placeholder, or empty slot where it would be inserted.
+ */
+
+static sai_bulker_placeholder_t* sai_bulker_find_placeholder(
+        _In_ const sai_bulker_t *bulker,
+        _In_ sai_object_id_t placeholder)
+{
+    size_t mask = bulker->placeholders_size - 1;
+    size_t idx;
+
+    if (bulker->placeholders_size == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = sai_metadata_hash_finalize(placeholder) & mask;
+            bulker->placeholders[idx].placeholder != SAI_NULL_OBJECT_ID;
+            idx = (idx + 1) & mask)
+    {
+        if (bulker->placeholders[idx].placeholder == placeholder)
+        {
+            break;
+        }
+    }
+
+    return &bulker->placeholders[idx];
+}
+
+/*
+ * Makes room for one more placeholder and checks that it is not queued
+ * already, so adding it after enqueue can't fail.
+ */
+
+static sai_status_t sai_bulker_reserve_placeholder(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ sai_object_id_t placeholder)
+{
+    const sai_bulker_placeholder_t *entry;
+
+    if ((bulker->placeholders_used + 1) * 2 > bulker->placeholders_size)
+    {
+        size_t size = bulker->placeholders_size ? bulker->placeholders_size * 2 : SAI_BULKER_PLACEHOLDERS_MIN_SIZE;
+        sai_bulker_placeholder_t *old = bulker->placeholders;
+        size_t old_size = bulker->placeholders_size;
+        size_t idx;
+
+        bulker->placeholders = calloc(size, sizeof(sai_bulker_placeholder_t));
+
+        if (bulker->placeholders == NULL)
+        {
+            bulker->placeholders = old;
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        bulker->placeholders_size = size;
+
+        for (idx = 0; idx < old_size; idx++)
+        {
+            if (old[idx].placeholder != SAI_NULL_OBJECT_ID)
+            {
+                *sai_bulker_find_placeholder(bulker, old[idx].placeholder) = old[idx];
+            }
+        }
+
+        free(old);
+    }
+
+    entry = sai_bulker_find_placeholder(bulker, placeholder);
+
+    return (entry->placeholder == placeholder) ? SAI_STATUS_INVALID_PARAMETER : SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Releases placeholders once nothing is queued, so no queued operation can
+ * reference them anymore. Not called by flushes inside enqueue, operation
+ * being queued may reference placeholder of create they execute.
+ */
+
+static void sai_bulker_clear_placeholders(
+        _Inout_ sai_bulker_t *bulker)
+{
+    if (bulker->pending != 0)
+    {
+        return;
+    }
+
+    if (bulker->placeholders_used != 0)
+    {
+        memset(bulker->placeholders, 0, bulker->placeholders_size * sizeof(sai_bulker_placeholder_t));
+    }
+
+    bulker->placeholders_used = 0;
+}
+
+/*
+ * Replaces placeholder by object id of created object. Returns true when
+ * placeholder create was not executed yet or failed.
+ */
+
+static int sai_bulker_resolve(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_object_id_t *object_id)
+{
+    const sai_bulker_placeholder_t *entry;
+
+    if (*object_id == SAI_NULL_OBJECT_ID)
+    {
+        return 0;
+    }
+
+    entry = sai_bulker_find_placeholder(bulker, *object_id);
+
+    if (entry->placeholder != *object_id)
+    {
+        return 0;
+    }
+
+    if (entry->state != SAI_BULKER_PLACEHOLDER_CREATED)
+    {
+        return 1;
+    }
+
+    *object_id = entry->object_id;
+
+    return 0;
+}
+
+static int sai_bulker_resolve_list(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_object_list_t *list)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < list->count; idx++)
+    {
+        if (sai_bulker_resolve(bulker, &list->list[idx]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Resolves placeholders in attribute values, same values as apply
+ * scheduler: object id, object list, ACL field and action data.
+ */
+
+static int sai_bulker_resolve_attrs(
+        _In_ const sai_bulker_t *bulker,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+        sai_attribute_value_t *value = &attr_list[idx].value;
+        int stop = 0;
+
+        if (md == NULL)
+        {
+            continue;
+        }
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+                stop = sai_bulker_resolve(bulker, &value->oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+                stop = sai_bulker_resolve_list(bulker, &value->objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+                stop = value->aclfield.enable && sai_bulker_resolve(bulker, &value->aclfield.data.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+                stop = value->aclfield.enable && sai_bulker_resolve_list(bulker, &value->aclfield.data.objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+                stop = value->aclaction.enable && sai_bulker_resolve(bulker, &value->aclaction.parameter.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+                stop = value->aclaction.enable && sai_bulker_resolve_list(bulker, &value->aclaction.parameter.objlist);
+                break;
+
+            default:
+                break;
+        }
+
+        if (stop)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Resolves placeholders in key and attributes of queued operation.
+ * Attributes are queue copies, so they are resolved in place.
+ */
+
+static int sai_bulker_resolve_operation(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ uint32_t idx)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(q->object_type);
+    sai_object_meta_key_t *meta_key = &q->meta_keys[idx];
+    size_t member;
+
+    if (info->isobjectid && q->op != SAI_BULKER_OP_CREATE && sai_bulker_resolve(bulker, &meta_key->objectkey.key.object_id))
+    {
+        return 1;
+    }
+
+    for (member = 0; info->isnonobjectid && member < info->structmemberscount; member++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[member];
+        sai_object_id_t object_id;
+
+        if (m->membervaluetype != SAI_ATTR_VALUE_TYPE_OBJECT_ID || m->getoid == NULL || m->setoid == NULL)
+        {
+            continue;
+        }
+
+        object_id = m->getoid(meta_key);
+
+        if (sai_bulker_resolve(bulker, &object_id))
+        {
+            return 1;
+        }
+
+        m->setoid(meta_key, object_id);
+    }
+
+    if (q->op == SAI_BULKER_OP_SET)
+    {
+        return sai_bulker_resolve_attrs(bulker, q->object_type, 1, &q->set_attrs[idx]);
+    }
+
+    return sai_bulker_resolve_attrs(bulker, q->object_type, q->attr_counts[idx], q->attr_copies[idx]);
+}
+
+static void sai_bulker_swap(
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ uint32_t a,
+        _In_ uint32_t b)
+{
+    sai_object_meta_key_t meta_key = q->meta_keys[a];
+    uint32_t attr_count = q->attr_counts[a];
+    const sai_attribute_t *attr_list = q->attr_lists[a];
+    sai_attribute_t *attr_copy = q->attr_copies[a];
+    sai_attribute_t set_attr = q->set_attrs[a];
+    sai_bulker_future_t *future = q->futures[a];
+    sai_object_id_t placeholder = q->placeholders[a];
+
+    q->meta_keys[a] = q->meta_keys[b];
+    q->attr_counts[a] = q->attr_counts[b];
+    q->attr_lists[a] = q->attr_lists[b];
+    q->attr_copies[a] = q->attr_copies[b];
+    q->set_attrs[a] = q->set_attrs[b];
+    q->futures[a] = q->futures[b];
+    q->placeholders[a] = q->placeholders[b];
+
+    q->meta_keys[b] = meta_key;
+    q->attr_counts[b] = attr_count;
+    q->attr_lists[b] = attr_list;
+    q->attr_copies[b] = attr_copy;
+    q->set_attrs[b] = set_attr;
+    q->futures[b] = future;
+    q->placeholders[b] = placeholder;
+}
+
+/*
+ * Resolves placeholders of queue and moves operations whose placeholder
+ * object was not created behind the others, keeping order of the rest.
+ * In stop on error mode first such operation also stops the rest. Returns
+ * number of operations ready for the call.
+ */
+
+static uint32_t sai_bulker_resolve_queue(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q)
+{
+    uint32_t ready = 0;
+    uint32_t idx;
+
+    if (bulker->placeholders_used == 0)
+    {
+        return q->count;
+    }
+
+    if (q->op == SAI_BULKER_OP_CREATE && sai_bulker_resolve(bulker, &q->switch_id))
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < q->count; idx++)
+    {
+        if (sai_bulker_resolve_operation(bulker, q, idx))
+        {
+            if (bulker->config.mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (idx != ready)
+        {
+            sai_bulker_swap(q, idx, ready);
+        }
+
+        ready++;
+    }
+
+    return ready;
+}
+
+static int sai_bulker_is_tracked(
+        _In_ const sai_bulker_queue_t *q,
+        _In_ const sai_object_meta_key_t *key)
+{
+    /* object id of queued create is not known yet */
+
+    return q->op != SAI_BULKER_OP_CREATE || sai_metadata_get_object_type_info(key->objecttype)->isnonobjectid;
+}
+
+/*
+ * Rebuilds key set and oldest enqueue time from queues which are still
+ * pending after flush. Key pointers of flushed queues are no longer valid.
+ */
+
+static void sai_bulker_rebuild_keys(
+        _Inout_ sai_bulker_t *bulker)
+{
+    uint32_t pos;
+    uint32_t idx;
+
+    if (bulker->keys_used != 0)
+    {
+        memset(bulker->keys, 0, bulker->keys_size * sizeof(sai_bulker_key_t));
+    }
+
+    bulker->keys_used = 0;
+    bulker->oldest = UINT64_MAX;
+
+    for (pos = 0; bulker->pending != 0 && pos < bulker->schedule_count; pos++)
+    {
+        const sai_bulker_queue_t *q = bulker->schedule[pos];
+
+        if (q->count == 0)
+        {
+            continue;
+        }
+
+        if (q->first_time < bulker->oldest)
+        {
+            bulker->oldest = q->first_time;
+        }
+
+        for (idx = 0; idx < q->count; idx++)
+        {
+            /* table was large enough for them before flush */
+
+            if (sai_bulker_is_tracked(q, &q->meta_keys[idx]))
+            {
+                sai_bulker_insert_key(bulker, q, idx);
+            }
+        }
+    }
+}
+
+static sai_status_t sai_bulker_call_single(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ uint32_t idx)
+{
+    const sai_apis_t *apis = bulker->config.apis;
+
+    switch (q->op)
+    {
+        case SAI_BULKER_OP_CREATE:
+            return sai_metadata_generic_create(apis, &q->meta_keys[idx], q->switch_id, q->attr_counts[idx], q->attr_lists[idx]);
+
+        case SAI_BULKER_OP_SET:
+            return sai_metadata_generic_set(apis, &q->meta_keys[idx], &q->set_attrs[idx]);
+
+        default:
+            return sai_metadata_generic_remove(apis, &q->meta_keys[idx]);
+    }
+}
+
+static sai_status_t sai_bulker_call_bulk(
+        _In_ const sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q,
+        _In_ uint32_t count)
+{
+    const sai_apis_t *apis = bulker->config.apis;
+
+    switch (q->op)
+    {
+        case SAI_BULKER_OP_CREATE:
+            return sai_metadata_generic_bulk_create(apis, q->switch_id, count, q->meta_keys,
+                    q->attr_counts, q->attr_lists, bulker->config.mode, q->statuses);
+
+        case SAI_BULKER_OP_SET:
+            return sai_metadata_generic_bulk_set(apis, count, q->meta_keys, q->set_attrs,
+                    bulker->config.mode, q->statuses);
+
+        default:
+            return sai_metadata_generic_bulk_remove(apis, count, q->meta_keys,
+                    bulker->config.mode, q->statuses);
+    }
+}
+
+/*
+ * Executes single queue, statuses are set for all queued objects. Object
+ * whose placeholder dependency was not created is not executed. Returns
+ * true when any object failed.
+ */
+
+static int sai_bulker_execute(
+        _Inout_ sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q)
+{
+    int stop = (bulker->config.mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR);
+    uint32_t count;
+    int failed;
+    uint32_t idx;
+
+    for (idx = 0; idx < q->count; idx++)
+    {
+        q->statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+    }
+
+    count = sai_bulker_resolve_queue(bulker, q);
+
+    failed = (count != q->count);
+
+    if (count == 0)
+    {
+        return failed;
+    }
+
+    if (count > 1 && !q->bulk_unsupported)
+    {
+        sai_status_t status = sai_bulker_call_bulk(bulker, q, count);
+
+        if (status != SAI_STATUS_NOT_SUPPORTED && status != SAI_STATUS_NOT_IMPLEMENTED)
+        {
+            bulker->stats.bulk_calls++;
+
+            for (idx = 0; idx < count; idx++)
+            {
+                /* call rejected as whole, like invalid parameter, leaves object statuses untouched */
+
+                if (status != SAI_STATUS_SUCCESS && status != SAI_STATUS_FAILURE &&
+                        q->statuses[idx] == SAI_STATUS_NOT_EXECUTED)
+                {
+                    q->statuses[idx] = status;
+                }
+
+                failed |= (q->statuses[idx] != SAI_STATUS_SUCCESS);
+            }
+
+            return failed;
+        }
+
+        q->bulk_unsupported = 1;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        q->statuses[idx] = sai_bulker_call_single(bulker, q, idx);
+
+        bulker->stats.single_calls++;
+
+        if (q->statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            failed = 1;
+
+            if (stop)
+            {
+                break;
+            }
+        }
+    }
+
+    return failed;
+}
+
+static void sai_bulker_complete(
+        _Inout_ sai_bulker_t *bulker,
+        _Inout_ sai_bulker_queue_t *q)
+{
+    int oid_create = (q->op == SAI_BULKER_OP_CREATE && !sai_metadata_get_object_type_info(q->object_type)->isnonobjectid);
+    uint32_t idx;
+
+    for (idx = 0; idx < q->count; idx++)
+    {
+        sai_bulker_future_t *future = q->futures[idx];
+
+        if (q->statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            bulker->stats.failures++;
+        }
+
+        if (q->op == SAI_BULKER_OP_CREATE && q->placeholders[idx] != SAI_NULL_OBJECT_ID)
+        {
+            sai_bulker_placeholder_t *entry = sai_bulker_find_placeholder(bulker, q->placeholders[idx]);
+
+            if (oid_create && q->statuses[idx] == SAI_STATUS_SUCCESS)
+            {
+                entry->state = SAI_BULKER_PLACEHOLDER_CREATED;
+                entry->object_id = q->meta_keys[idx].objectkey.key.object_id;
+            }
+            else
+            {
+                entry->state = SAI_BULKER_PLACEHOLDER_FAILED;
+            }
+        }
+
+        if (future == NULL)
+        {
+            continue;
+        }
+
+        future->status = q->statuses[idx];
+        future->object_id = (oid_create && q->statuses[idx] == SAI_STATUS_SUCCESS) ? q->meta_keys[idx].objectkey.key.object_id : SAI_NULL_OBJECT_ID;
+        future->done = true;
+    }
+
+    bulker->pending -= q->count;
+
+    q->count = 0;
+
+    sai_bulker_reset_arena(q);
+}
+
+/*
+ * Flushes queues at schedule positions up to and including last, so every
+ * operation which queued operations of those queues may depend on is done
+ * first.
+ */
+
+static sai_status_t sai_bulker_flush_until(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ uint32_t last)
+{
+    int stop = (bulker->config.mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR);
+    int failed = 0;
+    uint32_t pos;
+
+    if (bulker->pending == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    bulker->stats.flushes++;
+
+    for (pos = 0; pos <= last && pos < bulker->schedule_count; pos++)
+    {
+        sai_bulker_queue_t *q = bulker->schedule[pos];
+        uint32_t idx;
+
+        if (q->count == 0)
+        {
+            continue;
+        }
+
+        if (failed && stop)
+        {
+            for (idx = 0; idx < q->count; idx++)
+            {
+                q->statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+            }
+        }
+        else
+        {
+            failed |= sai_bulker_execute(bulker, q);
+        }
+
+        sai_bulker_complete(bulker, q);
+    }
+
+    sai_bulker_rebuild_keys(bulker);
+
+    return failed ? SAI_STATUS_FAILURE : SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_bulker_enqueue(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ int op,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_bulker_future_t *future)
+{
+    sai_object_id_t placeholder = SAI_NULL_OBJECT_ID;
+    sai_bulker_queue_t *q;
+    sai_attribute_t *copy;
+    sai_status_t status;
+    uint64_t now = 0;
+    uint32_t idx;
+    int tracked;
+
+    if (bulker == NULL || meta_key == NULL || (attr_count != 0 && attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    q = &bulker->queues[op][sai_metadata_object_type_index(meta_key->objecttype)];
+
+    if (q->position == SAI_BULKER_UNSCHEDULED || q->object_type != meta_key->objecttype)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (q->meta_keys == NULL)
+    {
+        status = sai_bulker_queue_init(bulker, q);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    if (bulker->config.max_delay != 0)
+    {
+        now = sai_metadata_now();
+
+        if (bulker->pending != 0 && now - bulker->oldest >= bulker->config.max_delay)
+        {
+            sai_bulker_flush_until(bulker, UINT32_MAX);
+        }
+    }
+
+    if (op == SAI_BULKER_OP_CREATE && meta_key->objectkey.key.object_id != SAI_NULL_OBJECT_ID &&
+            sai_metadata_get_object_type_info(meta_key->objecttype)->isobjectid)
+    {
+        placeholder = meta_key->objectkey.key.object_id;
+
+        status = sai_bulker_reserve_placeholder(bulker, placeholder);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    idx = q->count;
+
+    sai_metadata_normalize_object_meta_key(meta_key, &q->meta_keys[idx]);
+
+    tracked = sai_bulker_is_tracked(q, meta_key);
+
+    if (tracked)
+    {
+        const sai_bulker_key_t *entry = sai_bulker_find_key(bulker, &q->meta_keys[idx], q->key_size,
+                sai_metadata_hash_object_meta_key(&q->meta_keys[idx]));
+
+        /* bulk set of the same object twice has no defined order */
+
+        if (entry != NULL && entry->key != NULL &&
+                (entry->op > op || (entry->op == op && op == SAI_BULKER_OP_SET)))
+        {
+            sai_bulker_flush_until(bulker, entry->position);
+        }
+    }
+    else
+    {
+        q->meta_keys[idx].objectkey.key.object_id = SAI_NULL_OBJECT_ID;
+
+        if (q->count != 0 && q->switch_id != switch_id)
+        {
+            sai_bulker_flush_until(bulker, q->position);
+        }
+    }
+
+    /* flush may have emptied the queue, key was normalized into slot idx */
+
+    if (q->count != idx)
+    {
+        q->meta_keys[q->count] = q->meta_keys[idx];
+        idx = q->count;
+    }
+
+    if (op == SAI_BULKER_OP_SET)
+    {
+        status = sai_bulker_copy_attrs(q, 1, attr_list, &copy);
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            q->set_attrs[idx] = *copy;
+        }
+    }
+    else
+    {
+        status = sai_bulker_copy_attrs(q, attr_count, attr_list, &copy);
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (tracked)
+    {
+        status = sai_bulker_insert_key(bulker, q, idx);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    if (placeholder != SAI_NULL_OBJECT_ID)
+    {
+        sai_bulker_placeholder_t *entry = sai_bulker_find_placeholder(bulker, placeholder);
+
+        entry->placeholder = placeholder;
+        entry->object_id = SAI_NULL_OBJECT_ID;
+        entry->state = SAI_BULKER_PLACEHOLDER_PENDING;
+
+        bulker->placeholders_used++;
+    }
+
+    q->attr_counts[idx] = attr_count;
+    q->attr_lists[idx] = copy;
+    q->attr_copies[idx] = copy;
+    q->futures[idx] = future;
+    q->placeholders[idx] = placeholder;
+    q->switch_id = switch_id;
+
+    if (future != NULL)
+    {
+        future->done = false;
+        future->status = SAI_STATUS_NOT_EXECUTED;
+        future->object_id = SAI_NULL_OBJECT_ID;
+    }
+
+    if (q->count++ == 0)
+    {
+        q->first_time = now;
+    }
+
+    if (bulker->pending++ == 0)
+    {
+        bulker->oldest = now;
+    }
+
+    bulker->stats.operations++;
+
+    if (q->count == bulker->config.max_bulk_size)
+    {
+        sai_bulker_flush_until(bulker, q->position);
+
+        sai_bulker_clear_placeholders(bulker);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_bulker_t* sai_bulker_open(
+        _In_ const sai_bulker_config_t *config)
+{
+    sai_bulker_t *bulker;
+
+    if (config == NULL || config->apis == NULL)
+    {
+        return NULL;
+    }
+
+    bulker = calloc(1, sizeof(sai_bulker_t));
+
+    if (bulker == NULL)
+    {
+        return NULL;
+    }
+
+    bulker->config = *config;
+
+    if (bulker->config.max_bulk_size == 0)
+    {
+        bulker->config.max_bulk_size = SAI_BULKER_DEFAULT_MAX_BULK_SIZE;
+    }
+
+    if (sai_bulker_build_schedule(bulker) != SAI_STATUS_SUCCESS)
+    {
+        free(bulker);
+        return NULL;
+    }
+
+    return bulker;
+}
+
+void sai_bulker_close(
+        _Inout_ sai_bulker_t *bulker)
+{
+    uint32_t pos;
+
+    if (bulker == NULL)
+    {
+        return;
+    }
+
+    sai_bulker_flush(bulker);
+
+    for (pos = 0; pos < bulker->schedule_count; pos++)
+    {
+        sai_bulker_queue_t *q = bulker->schedule[pos];
+
+        sai_bulker_reset_arena(q);
+
+        free(q->blocks);
+        free(q->meta_keys);
+        free(q->attr_counts);
+        free(q->attr_lists);
+        free(q->attr_copies);
+        free(q->set_attrs);
+        free(q->statuses);
+        free(q->futures);
+        free(q->placeholders);
+    }
+
+    free(bulker->keys);
+    free(bulker->placeholders);
+    free(bulker);
+}
+
+sai_status_t sai_bulker_create(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_bulker_future_t *future)
+{
+    return sai_bulker_enqueue(bulker, SAI_BULKER_OP_CREATE, meta_key, switch_id, attr_count, attr_list, future);
+}
+
+sai_status_t sai_bulker_remove(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Out_ sai_bulker_future_t *future)
+{
+    return sai_bulker_enqueue(bulker, SAI_BULKER_OP_REMOVE, meta_key, SAI_NULL_OBJECT_ID, 0, NULL, future);
+}
+
+sai_status_t sai_bulker_set(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr,
+        _Out_ sai_bulker_future_t *future)
+{
+    if (attr == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_bulker_enqueue(bulker, SAI_BULKER_OP_SET, meta_key, SAI_NULL_OBJECT_ID, 1, attr, future);
+}
+
+sai_status_t sai_bulker_flush(
+        _Inout_ sai_bulker_t *bulker)
+{
+    sai_status_t status;
+
+    if (bulker == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = sai_bulker_flush_until(bulker, UINT32_MAX);
+
+    /* caller takes object ids from futures from now on */
+
+    sai_bulker_clear_placeholders(bulker);
+
+    return status;
+}
+
+sai_status_t sai_bulker_poll(
+        _Inout_ sai_bulker_t *bulker,
+        _Out_ uint64_t *timeout)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t now;
+
+    if (bulker == NULL || timeout == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *timeout = UINT64_MAX;
+
+    if (bulker->pending == 0 || bulker->config.max_delay == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    now = sai_metadata_now();
+
+    if (now - bulker->oldest >= bulker->config.max_delay)
+    {
+        status = sai_bulker_flush_until(bulker, UINT32_MAX);
+
+        sai_bulker_clear_placeholders(bulker);
+    }
+
+    if (bulker->pending != 0)
+    {
+        *timeout = bulker->oldest + bulker->config.max_delay - now;
+    }
+
+    return status;
+}
+
+uint32_t sai_bulker_get_pending(
+        _In_ const sai_bulker_t *bulker)
+{
+    return (bulker == NULL) ? 0 : bulker->pending;
+}
+
+void sai_bulker_get_stats(
+        _In_ const sai_bulker_t *bulker,
+        _Out_ sai_bulker_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (bulker != NULL)
+    {
+        *stats = bulker->stats;
+    }
+}
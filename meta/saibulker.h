@@ -0,0 +1,292 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saibulker.h
+ *
+ * @brief   This module defines SAI cross object type bulker
+ */
+
+#ifndef __SAIBULKER_H_
+#define __SAIBULKER_H_
+
+/**
+ * @defgroup SAIBULKER SAI - Cross object type bulker
+ *
+ * Bulker queues create, remove and set operations of any object type and
+ * executes them as bulk calls through sai_metadata_generic_bulk_create,
+ * sai_metadata_generic_bulk_remove and sai_metadata_generic_bulk_set. There
+ * is one queue per operation and object type. Queues are flushed when one
+ * of them reaches maximum bulk size, when oldest queued operation is older
+ * than maximum delay (checked on enqueue and by sai_bulker_poll) and on
+ * explicit sai_bulker_flush.
+ *
+ * Flush executes creates first, ordered by dependency level of object type,
+ * then sets, then removes in reverse dependency level order. Level comes
+ * from reverse dependency graph of metadata, object type which can be used
+ * by attribute or key member of other object type has lower level than the
+ * user, so next hop is created before route entry and route entry is
+ * removed before next hop. Queue reaching maximum bulk size flushes itself
+ * and every queue ordered before it. Operation on object key which has
+ * queued operation of later phase (like create after remove of the same
+ * route entry) flushes all queues first, so such sequences keep caller
+ * order. Other operations are reordered to the phase order above, caller
+ * which needs strict order across object types calls sai_bulker_flush.
+ *
+ * Result of each operation is written to optional caller owned future
+ * during flush, object id of created object is known only then. Create of
+ * object with object id can be queued with placeholder object id chosen by
+ * caller, which must not collide with object id of existing object. Later
+ * queued operations reference the object by placeholder in attribute value
+ * (object id, object list, ACL field and action data), entry key member,
+ * switch id or object id of set and remove, so route entry can use next hop
+ * queued in the same bulker. Placeholders are replaced by created object
+ * ids during flush, just before the call, operation whose placeholder
+ * object was not created completes with SAI_STATUS_NOT_EXECUTED.
+ * Placeholder can be referenced until its create is executed (future is
+ * done), after that caller uses object id from future. Placeholders are
+ * released, and can be used again, when sai_bulker_flush, sai_bulker_poll
+ * or flush of full queue leaves nothing queued. Attributes
+ * are copied on enqueue including list contents, so caller buffers can be
+ * reused right away. Object types without bulk support, detected by
+ * SAI_STATUS_NOT_SUPPORTED or SAI_STATUS_NOT_IMPLEMENTED of bulk call, are
+ * executed as single calls from then on.
+ *
+ * Bulker is not thread safe, each thread should use its own bulker.
+ *
+ * @{
+ */
+
+/**
+ * @brief Default maximum number of objects in single bulk call
+ */
+#define SAI_BULKER_DEFAULT_MAX_BULK_SIZE    1024
+
+/**
+ * @brief Bulker configuration
+ */
+typedef struct _sai_bulker_config_t
+{
+    /**
+     * @brief Method tables used for calls
+     */
+    const sai_apis_t *apis;
+
+    /**
+     * @brief Maximum number of objects in single bulk call, 0 for default
+     */
+    uint32_t max_bulk_size;
+
+    /**
+     * @brief Maximum time in nanoseconds operation stays queued, 0 disables
+     */
+    uint64_t max_delay;
+
+    /**
+     * @brief Bulk error mode
+     *
+     * In stop on error mode first failed operation also stops the rest of
+     * flush, remaining operations complete with SAI_STATUS_NOT_EXECUTED.
+     */
+    sai_bulk_op_error_mode_t mode;
+
+} sai_bulker_config_t;
+
+/**
+ * @brief Result of queued operation
+ */
+typedef struct _sai_bulker_future_t
+{
+    /**
+     * @brief Operation was executed or dropped, status is valid
+     */
+    bool done;
+
+    /**
+     * @brief Operation status
+     */
+    sai_status_t status;
+
+    /**
+     * @brief Object id of created object
+     */
+    sai_object_id_t object_id;
+
+} sai_bulker_future_t;
+
+/**
+ * @brief Bulker statistics
+ */
+typedef struct _sai_bulker_stats_t
+{
+    /**
+     * @brief Number of queued operations
+     */
+    uint64_t operations;
+
+    /**
+     * @brief Number of failed operations
+     */
+    uint64_t failures;
+
+    /**
+     * @brief Number of bulk calls
+     */
+    uint64_t bulk_calls;
+
+    /**
+     * @brief Number of single calls
+     */
+    uint64_t single_calls;
+
+    /**
+     * @brief Number of flushes
+     */
+    uint64_t flushes;
+
+} sai_bulker_stats_t;
+
+/**
+ * @brief Opaque bulker
+ */
+typedef struct _sai_bulker_t sai_bulker_t;
+
+/**
+ * @brief Create bulker
+ *
+ * @param[in] config Configuration, apis must stay valid while bulker exists
+ *
+ * @return Bulker or NULL on error
+ */
+extern sai_bulker_t* sai_bulker_open(
+        _In_ const sai_bulker_config_t *config);
+
+/**
+ * @brief Flush queued operations and destroy bulker
+ *
+ * @param[inout] bulker Bulker
+ */
+extern void sai_bulker_close(
+        _Inout_ sai_bulker_t *bulker);
+
+/**
+ * @brief Queue object create
+ *
+ * @param[inout] bulker Bulker
+ * @param[in] meta_key Object type and key, object id is placeholder or
+ * SAI_NULL_OBJECT_ID
+ * @param[in] switch_id Switch id, ignored for entries
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ * @param[out] future Result, may be NULL, must stay valid until flush
+ *
+ * @return #SAI_STATUS_SUCCESS when operation was queued,
+ * #SAI_STATUS_INVALID_PARAMETER when placeholder is already used, failure
+ * status code on error
+ */
+extern sai_status_t sai_bulker_create(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_bulker_future_t *future);
+
+/**
+ * @brief Queue object remove
+ *
+ * @param[inout] bulker Bulker
+ * @param[in] meta_key Object type and key
+ * @param[out] future Result, may be NULL, must stay valid until flush
+ *
+ * @return #SAI_STATUS_SUCCESS when operation was queued, failure status
+ * code on error
+ */
+extern sai_status_t sai_bulker_remove(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Out_ sai_bulker_future_t *future);
+
+/**
+ * @brief Queue object attribute set
+ *
+ * @param[inout] bulker Bulker
+ * @param[in] meta_key Object type and key
+ * @param[in] attr Attribute
+ * @param[out] future Result, may be NULL, must stay valid until flush
+ *
+ * @return #SAI_STATUS_SUCCESS when operation was queued, failure status
+ * code on error
+ */
+extern sai_status_t sai_bulker_set(
+        _Inout_ sai_bulker_t *bulker,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr,
+        _Out_ sai_bulker_future_t *future);
+
+/**
+ * @brief Execute all queued operations
+ *
+ * Placeholders of executed creates are released.
+ *
+ * @param[inout] bulker Bulker
+ *
+ * @return #SAI_STATUS_SUCCESS when all operations succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_bulker_flush(
+        _Inout_ sai_bulker_t *bulker);
+
+/**
+ * @brief Flush queued operations older than maximum delay
+ *
+ * @param[inout] bulker Bulker
+ * @param[out] timeout Nanoseconds until next flush is due, UINT64_MAX when
+ * nothing is queued or maximum delay is disabled
+ *
+ * @return #SAI_STATUS_SUCCESS when nothing was flushed or all operations
+ * succeeded, #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_bulker_poll(
+        _Inout_ sai_bulker_t *bulker,
+        _Out_ uint64_t *timeout);
+
+/**
+ * @brief Get number of queued operations
+ *
+ * @param[in] bulker Bulker
+ *
+ * @return Number of operations waiting for flush
+ */
+extern uint32_t sai_bulker_get_pending(
+        _In_ const sai_bulker_t *bulker);
+
+/**
+ * @brief Get bulker statistics
+ *
+ * @param[in] bulker Bulker
+ * @param[out] stats Statistics
+ */
+extern void sai_bulker_get_stats(
+        _In_ const sai_bulker_t *bulker,
+        _Out_ sai_bulker_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAIBULKER_H_ */
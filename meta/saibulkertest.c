@@ -0,0 +1,851 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saibulkertest.c
+ *
+ * @brief   This module implements SAI bulker tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saibulker.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_MAX_CALLS 64
+
+#define TEST_NEXT_HOP_BASE 0x1000
+
+/*
+ * Fake method tables record every call, so tests can check what bulker
+ * executed and in which order.
+ */
+
+typedef struct _test_call_t
+{
+    char op;
+
+    sai_object_type_t object_type;
+
+    uint32_t count;
+
+} test_call_t;
+
+static test_call_t test_calls[TEST_MAX_CALLS];
+
+static uint32_t test_call_count = 0;
+
+static uint32_t test_next_hop_index = 0;
+
+static uint32_t test_fail_index = UINT32_MAX;
+
+static uint32_t test_labels[4];
+
+static sai_object_id_t test_route_next_hop = SAI_NULL_OBJECT_ID;
+
+static sai_route_api_t test_route_api;
+
+static sai_next_hop_api_t test_next_hop_api;
+
+static sai_virtual_router_api_t test_virtual_router_api;
+
+static sai_apis_t test_apis;
+
+static void test_record(
+        _In_ char op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t count)
+{
+    ASSERT_TRUE(test_call_count < TEST_MAX_CALLS, "too many calls");
+
+    test_calls[test_call_count].op = op;
+    test_calls[test_call_count].object_type = object_type;
+    test_calls[test_call_count].count = count;
+
+    test_call_count++;
+}
+
+static void test_check_call(
+        _In_ uint32_t idx,
+        _In_ char op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t count)
+{
+    ASSERT_TRUE(idx < test_call_count, "missing call %u", idx);
+
+    ASSERT_TRUE(test_calls[idx].op == op, "call %u op %c, expected %c", idx, test_calls[idx].op, op);
+    ASSERT_TRUE(test_calls[idx].object_type == object_type, "call %u object type %d, expected %d",
+            idx, test_calls[idx].object_type, object_type);
+    ASSERT_TRUE(test_calls[idx].count == count, "call %u count %u, expected %u", idx, test_calls[idx].count, count);
+}
+
+/*
+ * Bulk calls fail object test_fail_index and honor error mode.
+ */
+
+static sai_status_t test_bulk_statuses(
+        _In_ uint32_t object_count,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t idx;
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (status != SAI_STATUS_SUCCESS && mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+        {
+            object_statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+            continue;
+        }
+
+        object_statuses[idx] = (idx == test_fail_index) ? SAI_STATUS_ITEM_NOT_FOUND : SAI_STATUS_SUCCESS;
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+static sai_status_t test_create_route_entries(
+        _In_ uint32_t object_count,
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    uint32_t idx;
+
+    test_record('c', SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (attr_count[idx] != 0 && attr_list[idx][0].id == SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)
+        {
+            test_route_next_hop = attr_list[idx][0].value.oid;
+        }
+    }
+
+    return test_bulk_statuses(object_count, mode, object_statuses);
+}
+
+static sai_status_t test_remove_route_entries(
+        _In_ uint32_t object_count,
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    test_record('r', SAI_OBJECT_TYPE_ROUTE_ENTRY, object_count);
+
+    return test_bulk_statuses(object_count, mode, object_statuses);
+}
+
+static sai_status_t test_create_route_entry(
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    test_record('c', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+
+    if (attr_count != 0 && attr_list[0].id == SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)
+    {
+        test_route_next_hop = attr_list[0].value.oid;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_remove_route_entry(
+        _In_ const sai_route_entry_t *route_entry)
+{
+    test_record('r', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_set_route_entry_attribute(
+        _In_ const sai_route_entry_t *route_entry,
+        _In_ const sai_attribute_t *attr)
+{
+    test_record('s', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_create_next_hops(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t object_count,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_object_id_t *object_id,
+        _Out_ sai_status_t *object_statuses)
+{
+    sai_status_t status;
+    uint32_t idx;
+
+    test_record('c', SAI_OBJECT_TYPE_NEXT_HOP, object_count);
+
+    status = test_bulk_statuses(object_count, mode, object_statuses);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_id[idx] = SAI_NULL_OBJECT_ID;
+
+        if (object_statuses[idx] == SAI_STATUS_SUCCESS)
+        {
+            object_id[idx] = TEST_NEXT_HOP_BASE + test_next_hop_index++;
+        }
+
+        if (attr_count[idx] != 0 && attr_list[idx][0].id == SAI_NEXT_HOP_ATTR_LABELSTACK)
+        {
+            memcpy(test_labels, attr_list[idx][0].value.u32list.list, sizeof(test_labels));
+        }
+    }
+
+    return status;
+}
+
+static sai_status_t test_remove_next_hops(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_id_t *object_id,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    test_record('r', SAI_OBJECT_TYPE_NEXT_HOP, object_count);
+
+    return test_bulk_statuses(object_count, mode, object_statuses);
+}
+
+static sai_status_t test_create_virtual_router(
+        _Out_ sai_object_id_t *virtual_router_id,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    test_record('c', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1);
+
+    *virtual_router_id = 0x2000;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_remove_virtual_router(
+        _In_ sai_object_id_t virtual_router_id)
+{
+    test_record('r', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void test_init()
+{
+    memset(&test_route_api, 0, sizeof(test_route_api));
+    memset(&test_next_hop_api, 0, sizeof(test_next_hop_api));
+    memset(&test_virtual_router_api, 0, sizeof(test_virtual_router_api));
+    memset(&test_apis, 0, sizeof(test_apis));
+
+    /* virtual router has only single calls, route entry has no bulk set */
+
+    test_route_api.create_route_entry = test_create_route_entry;
+    test_route_api.remove_route_entry = test_remove_route_entry;
+    test_route_api.create_route_entries = test_create_route_entries;
+    test_route_api.remove_route_entries = test_remove_route_entries;
+    test_route_api.set_route_entry_attribute = test_set_route_entry_attribute;
+
+    test_next_hop_api.create_next_hops = test_create_next_hops;
+    test_next_hop_api.remove_next_hops = test_remove_next_hops;
+
+    test_virtual_router_api.create_virtual_router = test_create_virtual_router;
+    test_virtual_router_api.remove_virtual_router = test_remove_virtual_router;
+
+    test_apis.route_api = &test_route_api;
+    test_apis.next_hop_api = &test_next_hop_api;
+    test_apis.virtual_router_api = &test_virtual_router_api;
+
+    test_call_count = 0;
+    test_fail_index = UINT32_MAX;
+}
+
+static sai_bulker_t* test_open(
+        _In_ uint32_t max_bulk_size,
+        _In_ uint64_t max_delay,
+        _In_ sai_bulk_op_error_mode_t mode)
+{
+    sai_bulker_config_t config;
+    sai_bulker_t *bulker;
+
+    config.apis = &test_apis;
+    config.max_bulk_size = max_bulk_size;
+    config.max_delay = max_delay;
+    config.mode = mode;
+
+    bulker = sai_bulker_open(&config);
+
+    ASSERT_TRUE(bulker != NULL, "open failed");
+
+    return bulker;
+}
+
+static void test_route(
+        _Out_ sai_object_meta_key_t *meta_key,
+        _In_ uint32_t idx)
+{
+    sai_route_entry_t *route = &meta_key->objectkey.key.route_entry;
+
+    /* garbage in bytes which are not part of key must not matter */
+
+    memset(meta_key, (int)(0x5a + idx), sizeof(*meta_key));
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+
+    route->switch_id = 0x100;
+    route->vr_id = 0x2000;
+    route->destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    route->destination.addr.ip4 = 0x0a000000 + (idx << 8);
+    route->destination.mask.ip4 = 0xffffff00;
+}
+
+static void test_oid(
+        _Out_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = object_type;
+    meta_key->objectkey.key.object_id = object_id;
+}
+
+static void test_dependency_order()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t futures[9];
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attr;
+    uint32_t labels[4] = { 100, 200, 300, 400 };
+    uint32_t idx;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    /* queued in reverse of dependency order */
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0x2000);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[0]) == SAI_STATUS_SUCCESS, "remove virtual router");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0x1);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[1]) == SAI_STATUS_SUCCESS, "remove next hop");
+
+    test_route(&meta_key, 0);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[2]) == SAI_STATUS_SUCCESS, "remove route");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0x2);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[3]) == SAI_STATUS_SUCCESS, "remove next hop");
+
+    test_route(&meta_key, 1);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[4]) == SAI_STATUS_SUCCESS, "remove route");
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    test_route(&meta_key, 2);
+    ASSERT_TRUE(sai_bulker_set(bulker, &meta_key, &attr, &futures[5]) == SAI_STATUS_SUCCESS, "set route");
+
+    test_route(&meta_key, 3);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, &futures[6]) == SAI_STATUS_SUCCESS, "create route");
+
+    test_route(&meta_key, 4);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, &futures[7]) == SAI_STATUS_SUCCESS, "create route");
+
+    attr.id = SAI_NEXT_HOP_ATTR_LABELSTACK;
+    attr.value.u32list.count = 4;
+    attr.value.u32list.list = labels;
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, SAI_NULL_OBJECT_ID);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, &futures[8]) == SAI_STATUS_SUCCESS, "create next hop");
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, NULL) == SAI_STATUS_SUCCESS, "create next hop");
+
+    /* list was copied on enqueue */
+
+    labels[0] = 0;
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 10, "pending %u", sai_bulker_get_pending(bulker));
+    ASSERT_TRUE(test_call_count == 0, "nothing executed before flush");
+    ASSERT_TRUE(!futures[0].done, "future not done before flush");
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_SUCCESS, "flush failed");
+
+    ASSERT_TRUE(test_call_count == 6, "calls %u", test_call_count);
+
+    test_check_call(0, 'c', SAI_OBJECT_TYPE_NEXT_HOP, 2);
+    test_check_call(1, 'c', SAI_OBJECT_TYPE_ROUTE_ENTRY, 2);
+    test_check_call(2, 's', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+    test_check_call(3, 'r', SAI_OBJECT_TYPE_ROUTE_ENTRY, 2);
+    test_check_call(4, 'r', SAI_OBJECT_TYPE_NEXT_HOP, 2);
+    test_check_call(5, 'r', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1);
+
+    ASSERT_TRUE(test_labels[0] == 100 && test_labels[3] == 400, "labels %u %u", test_labels[0], test_labels[3]);
+
+    for (idx = 0; idx < 9; idx++)
+    {
+        ASSERT_TRUE(futures[idx].done && futures[idx].status == SAI_STATUS_SUCCESS, "future %u", idx);
+    }
+
+    ASSERT_TRUE(futures[8].object_id == TEST_NEXT_HOP_BASE + test_next_hop_index - 2, "next hop object id");
+    ASSERT_TRUE(futures[6].object_id == SAI_NULL_OBJECT_ID, "route entry has no object id");
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 0, "pending after flush");
+
+    sai_bulker_close(bulker);
+}
+
+static void test_size_limit()
+{
+    sai_bulker_t *bulker;
+    sai_object_meta_key_t meta_key;
+    sai_bulker_stats_t stats;
+    uint32_t idx;
+
+    test_init();
+
+    bulker = test_open(4, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0x1);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_SUCCESS, "remove next hop");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0x2);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_SUCCESS, "remove next hop");
+
+    for (idx = 0; idx < 4; idx++)
+    {
+        test_route(&meta_key, idx);
+        ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "create route");
+    }
+
+    /* full queue flushes itself, removes are ordered after it and wait */
+
+    ASSERT_TRUE(test_call_count == 1, "calls %u", test_call_count);
+    test_check_call(0, 'c', SAI_OBJECT_TYPE_ROUTE_ENTRY, 4);
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 2, "pending %u", sai_bulker_get_pending(bulker));
+
+    /* route entry removes are ordered before next hop removes, which keep waiting */
+
+    for (idx = 0; idx < 4; idx++)
+    {
+        test_route(&meta_key, idx);
+        ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_SUCCESS, "remove route");
+    }
+
+    ASSERT_TRUE(test_call_count == 2, "calls %u", test_call_count);
+    test_check_call(1, 'r', SAI_OBJECT_TYPE_ROUTE_ENTRY, 4);
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 2, "pending %u", sai_bulker_get_pending(bulker));
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_SUCCESS, "flush failed");
+    test_check_call(2, 'r', SAI_OBJECT_TYPE_NEXT_HOP, 2);
+
+    sai_bulker_get_stats(bulker, &stats);
+
+    ASSERT_TRUE(stats.operations == 10, "operations %" PRIu64, stats.operations);
+    ASSERT_TRUE(stats.bulk_calls == 3, "bulk calls %" PRIu64, stats.bulk_calls);
+    ASSERT_TRUE(stats.flushes == 3, "flushes %" PRIu64, stats.flushes);
+
+    sai_bulker_close(bulker);
+}
+
+static void test_same_key()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t futures[3];
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attr;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_route(&meta_key, 0);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[0]) == SAI_STATUS_SUCCESS, "remove route");
+
+    test_route(&meta_key, 1);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_SUCCESS, "remove route");
+
+    /* create after remove of the same route must not be reordered */
+
+    test_route(&meta_key, 0);
+
+    ASSERT_TRUE(test_call_count == 0, "calls %u", test_call_count);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &futures[1]) == SAI_STATUS_SUCCESS, "create route");
+    ASSERT_TRUE(test_call_count == 1, "calls %u", test_call_count);
+
+    test_check_call(0, 'r', SAI_OBJECT_TYPE_ROUTE_ENTRY, 2);
+
+    ASSERT_TRUE(futures[0].done && !futures[1].done, "remove done before create");
+
+    /* second set of the same object waits for first one */
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    ASSERT_TRUE(sai_bulker_set(bulker, &meta_key, &attr, &futures[2]) == SAI_STATUS_SUCCESS, "set route");
+    ASSERT_TRUE(test_call_count == 1, "calls %u", test_call_count);
+
+    ASSERT_TRUE(sai_bulker_set(bulker, &meta_key, &attr, NULL) == SAI_STATUS_SUCCESS, "set route");
+    ASSERT_TRUE(test_call_count == 3, "calls %u", test_call_count);
+
+    test_check_call(1, 'c', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+    test_check_call(2, 's', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+
+    ASSERT_TRUE(futures[1].done && futures[2].done, "create and set done");
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 1, "pending %u", sai_bulker_get_pending(bulker));
+
+    sai_bulker_close(bulker);
+
+    ASSERT_TRUE(test_call_count == 4, "close flushes, calls %u", test_call_count);
+}
+
+static void test_error_mode()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t futures[5];
+    sai_object_meta_key_t meta_key;
+    sai_bulker_stats_t stats;
+    uint32_t idx;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR);
+
+    test_fail_index = 1;
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, SAI_NULL_OBJECT_ID);
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &futures[idx]) == SAI_STATUS_SUCCESS, "create next hop");
+    }
+
+    for (idx = 3; idx < 5; idx++)
+    {
+        test_route(&meta_key, idx);
+        ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[idx]) == SAI_STATUS_SUCCESS, "remove route");
+    }
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_FAILURE, "flush should fail");
+
+    ASSERT_TRUE(test_call_count == 1, "calls %u", test_call_count);
+
+    ASSERT_TRUE(futures[0].status == SAI_STATUS_SUCCESS && futures[0].object_id != SAI_NULL_OBJECT_ID, "first created");
+    ASSERT_TRUE(futures[1].status == SAI_STATUS_ITEM_NOT_FOUND && futures[1].object_id == SAI_NULL_OBJECT_ID, "second failed");
+
+    for (idx = 2; idx < 5; idx++)
+    {
+        ASSERT_TRUE(futures[idx].done && futures[idx].status == SAI_STATUS_NOT_EXECUTED, "future %u not executed", idx);
+    }
+
+    sai_bulker_get_stats(bulker, &stats);
+
+    ASSERT_TRUE(stats.failures == 4, "failures %" PRIu64, stats.failures);
+
+    sai_bulker_close(bulker);
+
+    /* ignore error mode executes everything */
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    test_fail_index = 1;
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, SAI_NULL_OBJECT_ID);
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &futures[idx]) == SAI_STATUS_SUCCESS, "create next hop");
+    }
+
+    for (idx = 3; idx < 5; idx++)
+    {
+        test_route(&meta_key, idx);
+        ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, &futures[idx]) == SAI_STATUS_SUCCESS, "remove route");
+    }
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_FAILURE, "flush should fail");
+
+    ASSERT_TRUE(test_call_count == 2, "calls %u", test_call_count);
+
+    ASSERT_TRUE(futures[1].status == SAI_STATUS_ITEM_NOT_FOUND, "second failed");
+    ASSERT_TRUE(futures[2].status == SAI_STATUS_SUCCESS, "third created");
+    ASSERT_TRUE(futures[3].status == SAI_STATUS_SUCCESS, "route removed");
+    ASSERT_TRUE(futures[4].status == SAI_STATUS_ITEM_NOT_FOUND, "route failed");
+
+    sai_bulker_close(bulker);
+}
+
+static void test_single_fallback()
+{
+    sai_bulker_t *bulker;
+    sai_object_meta_key_t meta_key;
+    sai_bulker_stats_t stats;
+    sai_attribute_t attr;
+    uint32_t idx;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        test_oid(&meta_key, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 0x2000 + idx);
+        ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_SUCCESS, "remove virtual router");
+
+        test_route(&meta_key, idx);
+        ASSERT_TRUE(sai_bulker_set(bulker, &meta_key, &attr, NULL) == SAI_STATUS_SUCCESS, "set route");
+    }
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_SUCCESS, "flush failed");
+
+    ASSERT_TRUE(test_call_count == 6, "calls %u", test_call_count);
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        test_check_call(idx, 's', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+        test_check_call(3 + idx, 'r', SAI_OBJECT_TYPE_VIRTUAL_ROUTER, 1);
+    }
+
+    sai_bulker_get_stats(bulker, &stats);
+
+    ASSERT_TRUE(stats.single_calls == 6 && stats.bulk_calls == 0, "single %" PRIu64 " bulk %" PRIu64,
+            stats.single_calls, stats.bulk_calls);
+
+    sai_bulker_close(bulker);
+}
+
+static void test_delay()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t future;
+    sai_object_meta_key_t meta_key;
+    struct timespec ts;
+    uint64_t timeout;
+
+    test_init();
+
+    bulker = test_open(0, 20000000, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    ASSERT_TRUE(sai_bulker_poll(bulker, &timeout) == SAI_STATUS_SUCCESS && timeout == UINT64_MAX, "nothing queued");
+
+    test_route(&meta_key, 0);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &future) == SAI_STATUS_SUCCESS, "create route");
+
+    ASSERT_TRUE(sai_bulker_poll(bulker, &timeout) == SAI_STATUS_SUCCESS, "poll failed");
+    ASSERT_TRUE(timeout != 0 && timeout <= 20000000, "timeout %" PRIu64, timeout);
+    ASSERT_TRUE(!future.done, "flushed too early");
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = 30000000;
+
+    nanosleep(&ts, NULL);
+
+    ASSERT_TRUE(sai_bulker_poll(bulker, &timeout) == SAI_STATUS_SUCCESS && timeout == UINT64_MAX, "poll failed");
+    ASSERT_TRUE(future.done && future.status == SAI_STATUS_SUCCESS, "not flushed after delay");
+
+    sai_bulker_close(bulker);
+}
+
+static void test_placeholders()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t futures[4];
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attr;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    /* routes are queued before next hops they use */
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attr.value.oid = 0xf001;
+
+    test_route(&meta_key, 0);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, &futures[0]) == SAI_STATUS_SUCCESS, "create route");
+
+    attr.value.oid = 0xf002;
+
+    test_route(&meta_key, 1);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, &attr, &futures[1]) == SAI_STATUS_SUCCESS, "create route");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf001);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &futures[2]) == SAI_STATUS_SUCCESS, "create next hop");
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_INVALID_PARAMETER, "placeholder used twice");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf002);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &futures[3]) == SAI_STATUS_SUCCESS, "create next hop");
+
+    /* second next hop fails, route using it is not executed */
+
+    test_fail_index = 1;
+
+    ASSERT_TRUE(sai_bulker_flush(bulker) == SAI_STATUS_FAILURE, "flush succeeded");
+
+    ASSERT_TRUE(test_call_count == 2, "calls %u", test_call_count);
+
+    test_check_call(0, 'c', SAI_OBJECT_TYPE_NEXT_HOP, 2);
+    test_check_call(1, 'c', SAI_OBJECT_TYPE_ROUTE_ENTRY, 1);
+
+    ASSERT_TRUE(futures[2].status == SAI_STATUS_SUCCESS && futures[3].status == SAI_STATUS_ITEM_NOT_FOUND, "next hop statuses");
+    ASSERT_TRUE(futures[0].status == SAI_STATUS_SUCCESS, "status %d", futures[0].status);
+    ASSERT_TRUE(futures[1].done && futures[1].status == SAI_STATUS_NOT_EXECUTED, "status %d", futures[1].status);
+    ASSERT_TRUE(test_route_next_hop == futures[2].object_id, "next hop 0x%" PRIx64 " not resolved", test_route_next_hop);
+
+    /* flush released placeholders */
+
+    test_fail_index = UINT32_MAX;
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf001);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "placeholder reused");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf002);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "placeholder reused");
+
+    sai_bulker_close(bulker);
+}
+
+static void test_placeholders_reuse()
+{
+    sai_bulker_t *bulker;
+    sai_bulker_future_t future;
+    sai_object_meta_key_t meta_key;
+    struct timespec ts;
+    uint64_t timeout;
+    uint32_t idx;
+
+    test_init();
+
+    bulker = test_open(3, 20000000, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    /* full queue flush leaves nothing queued and releases placeholders */
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf001 + idx);
+        ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "create next hop");
+    }
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 0, "pending %u", sai_bulker_get_pending(bulker));
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf001);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, &future) == SAI_STATUS_SUCCESS, "placeholder reused");
+
+    /* the same after flush by poll */
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf002);
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "placeholder reused");
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = 30000000;
+
+    nanosleep(&ts, NULL);
+
+    ASSERT_TRUE(sai_bulker_poll(bulker, &timeout) == SAI_STATUS_SUCCESS && timeout == UINT64_MAX, "poll failed");
+    ASSERT_TRUE(future.done && future.status == SAI_STATUS_SUCCESS, "not flushed after delay");
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        test_oid(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP, 0xf001 + idx);
+        ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 0, NULL, NULL) == SAI_STATUS_SUCCESS, "placeholder reused");
+    }
+
+    ASSERT_TRUE(test_call_count == 2, "calls %u", test_call_count);
+    test_check_call(0, 'c', SAI_OBJECT_TYPE_NEXT_HOP, 3);
+    test_check_call(1, 'c', SAI_OBJECT_TYPE_NEXT_HOP, 2);
+
+    sai_bulker_close(bulker);
+}
+
+static void test_invalid()
+{
+    sai_bulker_t *bulker;
+    sai_object_meta_key_t meta_key;
+
+    test_init();
+
+    bulker = test_open(0, 0, SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR);
+
+    ASSERT_TRUE(sai_bulker_remove(bulker, NULL, NULL) == SAI_STATUS_INVALID_PARAMETER, "NULL key");
+
+    test_oid(&meta_key, SAI_OBJECT_TYPE_NULL, 0x1);
+    ASSERT_TRUE(sai_bulker_remove(bulker, &meta_key, NULL) == SAI_STATUS_INVALID_OBJECT_TYPE, "NULL object type");
+
+    test_route(&meta_key, 0);
+    ASSERT_TRUE(sai_bulker_set(bulker, &meta_key, NULL, NULL) == SAI_STATUS_INVALID_PARAMETER, "NULL attribute");
+    ASSERT_TRUE(sai_bulker_create(bulker, &meta_key, 0x100, 1, NULL, NULL) == SAI_STATUS_INVALID_PARAMETER, "NULL attributes");
+
+    ASSERT_TRUE(sai_bulker_get_pending(bulker) == 0, "nothing queued");
+
+    sai_bulker_close(bulker);
+}
+
+int main()
+{
+    test_dependency_order();
+
+    test_size_limit();
+
+    test_same_key();
+
+    test_error_mode();
+
+    test_single_fallback();
+
+    test_delay();
+
+    test_placeholders();
+
+    test_placeholders_reuse();
+
+    test_invalid();
+
+    return 0;
+}
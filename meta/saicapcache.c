@@ -0,0 +1,1309 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicapcache.c
+ *
+ * @brief   This module implements SAI capability query cache
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "saimetadata.h"
+#include "saiversion.h"
+#include "saicapcache.h"
+
+#define SAI_CAPCACHE_MAGIC "SAICAPC"
+
+#define SAI_CAPCACHE_VERSION 1
+
+#define SAI_CAPCACHE_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_CAPCACHE_KIND_ATTR 1
+#define SAI_CAPCACHE_KIND_ENUM 2
+#define SAI_CAPCACHE_KIND_STATS 3
+
+#define SAI_CAPCACHE_FLAG_CREATE 1
+#define SAI_CAPCACHE_FLAG_SET 2
+#define SAI_CAPCACHE_FLAG_GET 4
+
+#define SAI_CAPCACHE_TABLE_MIN_SIZE 256
+
+/*
+ * Vendor list query is repeated with list size it asked for, this many
+ * times at most, in case list grows between calls.
+ */
+
+#define SAI_CAPCACHE_LIST_RETRIES 4
+
+#define SAI_CAPCACHE_STAT_ADD(var, value) \
+    __atomic_fetch_add(&(var), (value), __ATOMIC_RELAXED)
+
+/*
+ * Cache file header, followed by hardware info padded to 8 bytes, then by
+ * entries sorted by key, then by 32 bit data words of entries. File is
+ * used as mapped, so all members have fixed size.
+ */
+
+typedef struct _sai_capcache_file_header_t
+{
+    char magic[8];
+
+    uint32_t version;
+
+    uint32_t hardware_info_size;
+
+    uint64_t header_api_version;
+
+    uint64_t api_version;
+
+    uint32_t entry_count;
+
+    uint32_t data_count;
+
+} sai_capcache_file_header_t;
+
+/*
+ * Cached result. Attribute capability keeps flags only, enum values are
+ * one data word per value, stats are two words (stat enum, stat modes)
+ * per statistic.
+ */
+
+typedef struct _sai_capcache_entry_t
+{
+    uint32_t kind;
+
+    int32_t object_type;
+
+    uint32_t attr_id;
+
+    int32_t status;
+
+    uint32_t flags;
+
+    uint32_t count;
+
+    uint32_t offset;
+
+    uint32_t reserved;
+
+} sai_capcache_entry_t;
+
+/*
+ * Result cached since cache file was loaded, data is owned by table.
+ */
+
+typedef struct _sai_capcache_slot_t
+{
+    sai_capcache_entry_t entry;
+
+    uint32_t *data;
+
+    bool used;
+
+} sai_capcache_slot_t;
+
+typedef struct _sai_capcache_availability_t
+{
+    sai_object_type_t object_type;
+
+    uint32_t attr_count;
+
+    sai_attribute_t *attr_list;
+
+    uint64_t count;
+
+    uint64_t expires;
+
+} sai_capcache_availability_t;
+
+struct _sai_capcache_t
+{
+    sai_capcache_config_t config;
+
+    int8_t *hardware_info;
+
+    char *path;
+
+    pthread_mutex_t mutex;
+
+    /* mapped cache file, entries are sorted and never change */
+
+    void *map;
+
+    size_t map_size;
+
+    const sai_capcache_entry_t *file_entries;
+
+    uint32_t file_entry_count;
+
+    const uint32_t *file_data;
+
+    /* results cached since load, open addressing by key */
+
+    sai_capcache_slot_t *slots;
+
+    size_t size;
+
+    size_t used;
+
+    sai_capcache_availability_t *availability;
+
+    size_t availability_count;
+
+    size_t availability_size;
+
+    bool dirty;
+
+    sai_capcache_stats_t stats;
+};
+
+static int sai_capcache_compare_key(
+        _In_ const sai_capcache_entry_t *first,
+        _In_ const sai_capcache_entry_t *second)
+{
+    if (first->kind != second->kind)
+    {
+        return first->kind < second->kind ? -1 : 1;
+    }
+
+    if (first->object_type != second->object_type)
+    {
+        return first->object_type < second->object_type ? -1 : 1;
+    }
+
+    if (first->attr_id != second->attr_id)
+    {
+        return first->attr_id < second->attr_id ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static int sai_capcache_compare_entries(
+        _In_ const void *first,
+        _In_ const void *second)
+{
+    return sai_capcache_compare_key((const sai_capcache_entry_t*)first, (const sai_capcache_entry_t*)second);
+}
+
+static size_t sai_capcache_hash(
+        _In_ const sai_capcache_entry_t *key)
+{
+    uint64_t hash = ((uint64_t)(uint32_t)key->object_type << 32) | key->attr_id;
+
+    hash ^= (uint64_t)key->kind << 61;
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return (size_t)hash;
+}
+
+/*
+ * Results are cached only when vendor answer is final. Failures like no
+ * memory or uninitialized switch are not, next query asks vendor again.
+ */
+
+static bool sai_capcache_is_cacheable(
+        _In_ sai_status_t status)
+{
+    return status == SAI_STATUS_SUCCESS ||
+        status == SAI_STATUS_NOT_SUPPORTED ||
+        status == SAI_STATUS_NOT_IMPLEMENTED ||
+        SAI_STATUS_IS_ATTR_NOT_SUPPORTED(status) ||
+        SAI_STATUS_IS_ATTR_NOT_IMPLEMENTED(status);
+}
+
+/*
+ * Finds result in mapped file first, then in results cached since load.
+ * Data points to file or to slot, both stay valid while lock is held.
+ */
+
+static const sai_capcache_entry_t* sai_capcache_find(
+        _In_ const sai_capcache_t *cache,
+        _In_ const sai_capcache_entry_t *key,
+        _Out_ const uint32_t **data)
+{
+    size_t low = 0;
+    size_t high = cache->file_entry_count;
+    size_t idx;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        int cmp = sai_capcache_compare_key(&cache->file_entries[mid], key);
+
+        if (cmp == 0)
+        {
+            *data = cache->file_data + cache->file_entries[mid].offset;
+
+            return &cache->file_entries[mid];
+        }
+
+        if (cmp < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (cache->size == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = sai_capcache_hash(key) & (cache->size - 1); cache->slots[idx].used; idx = (idx + 1) & (cache->size - 1))
+    {
+        if (sai_capcache_compare_key(&cache->slots[idx].entry, key) == 0)
+        {
+            *data = cache->slots[idx].data;
+
+            return &cache->slots[idx].entry;
+        }
+    }
+
+    return NULL;
+}
+
+static bool sai_capcache_grow(
+        _Inout_ sai_capcache_t *cache)
+{
+    size_t size = cache->size ? cache->size * 2 : SAI_CAPCACHE_TABLE_MIN_SIZE;
+    sai_capcache_slot_t *slots;
+    size_t idx;
+
+    slots = (sai_capcache_slot_t*)calloc(size, sizeof(sai_capcache_slot_t));
+
+    if (slots == NULL)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < cache->size; idx++)
+    {
+        size_t pos;
+
+        if (!cache->slots[idx].used)
+        {
+            continue;
+        }
+
+        for (pos = sai_capcache_hash(&cache->slots[idx].entry) & (size - 1); slots[pos].used; pos = (pos + 1) & (size - 1))
+        {
+        }
+
+        slots[pos] = cache->slots[idx];
+    }
+
+    free(cache->slots);
+
+    cache->slots = slots;
+    cache->size = size;
+
+    return true;
+}
+
+/*
+ * Adds result unless other thread added the same key while vendor was
+ * queried without lock. Data words are copied.
+ */
+
+static void sai_capcache_insert(
+        _Inout_ sai_capcache_t *cache,
+        _In_ const sai_capcache_entry_t *entry,
+        _In_ const uint32_t *data)
+{
+    const uint32_t *found;
+    uint32_t *copy = NULL;
+    size_t idx;
+
+    if (sai_capcache_find(cache, entry, &found) != NULL)
+    {
+        return;
+    }
+
+    if (2 * (cache->used + 1) > cache->size && !sai_capcache_grow(cache))
+    {
+        return;
+    }
+
+    if (entry->count)
+    {
+        copy = (uint32_t*)malloc(entry->count * sizeof(uint32_t));
+
+        if (copy == NULL)
+        {
+            return;
+        }
+
+        memcpy(copy, data, entry->count * sizeof(uint32_t));
+    }
+
+    for (idx = sai_capcache_hash(entry) & (cache->size - 1); cache->slots[idx].used; idx = (idx + 1) & (cache->size - 1))
+    {
+    }
+
+    cache->slots[idx].entry = *entry;
+    cache->slots[idx].entry.offset = 0;
+    cache->slots[idx].data = copy;
+    cache->slots[idx].used = true;
+
+    cache->used++;
+    cache->dirty = true;
+
+    SAI_CAPCACHE_STAT_ADD(cache->stats.entries, 1);
+}
+
+static void sai_capcache_unmap(
+        _Inout_ sai_capcache_t *cache)
+{
+    if (cache->map != NULL)
+    {
+        munmap(cache->map, cache->map_size);
+    }
+
+    cache->map = NULL;
+    cache->map_size = 0;
+    cache->file_entries = NULL;
+    cache->file_entry_count = 0;
+    cache->file_data = NULL;
+}
+
+static void sai_capcache_free_results(
+        _Inout_ sai_capcache_t *cache)
+{
+    size_t idx;
+
+    for (idx = 0; idx < cache->size; idx++)
+    {
+        free(cache->slots[idx].data);
+    }
+
+    free(cache->slots);
+
+    cache->slots = NULL;
+    cache->size = 0;
+    cache->used = 0;
+
+    for (idx = 0; idx < cache->availability_count; idx++)
+    {
+        free(cache->availability[idx].attr_list);
+    }
+
+    cache->availability_count = 0;
+}
+
+/*
+ * Validates whole file before it is used, so lookups need no checks.
+ * File with other key is expected after upgrade and is only logged.
+ */
+
+static void sai_capcache_load(
+        _Inout_ sai_capcache_t *cache)
+{
+    const sai_capcache_file_header_t *header;
+    const sai_capcache_entry_t *entries;
+    struct stat st;
+    size_t offset;
+    uint32_t idx;
+    void *map;
+    int fd;
+
+    fd = open(cache->config.path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+        {
+            SAI_META_LOG_WARN("failed to open %s: %s", cache->config.path, strerror(errno));
+        }
+
+        return;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(sai_capcache_file_header_t))
+    {
+        SAI_META_LOG_WARN("%s is not capability cache file", cache->config.path);
+
+        close(fd);
+        return;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        SAI_META_LOG_WARN("failed to map %s: %s", cache->config.path, strerror(errno));
+
+        return;
+    }
+
+    cache->map = map;
+    cache->map_size = (size_t)st.st_size;
+
+    header = (const sai_capcache_file_header_t*)map;
+
+    if (memcmp(header->magic, SAI_CAPCACHE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != SAI_CAPCACHE_VERSION ||
+            header->header_api_version != SAI_API_VERSION)
+    {
+        SAI_META_LOG_NOTICE("%s was written by other build, ignored", cache->config.path);
+
+        sai_capcache_unmap(cache);
+        return;
+    }
+
+    if (header->api_version != cache->config.api_version ||
+            header->hardware_info_size != cache->config.hardware_info.count ||
+            cache->map_size < sizeof(sai_capcache_file_header_t) + header->hardware_info_size ||
+            memcmp((const uint8_t*)map + sizeof(sai_capcache_file_header_t), cache->hardware_info, header->hardware_info_size) != 0)
+    {
+        SAI_META_LOG_NOTICE("%s belongs to other switch or SAI version, ignored", cache->config.path);
+
+        sai_capcache_unmap(cache);
+        return;
+    }
+
+    offset = sizeof(sai_capcache_file_header_t) + SAI_CAPCACHE_ALIGN(header->hardware_info_size);
+
+    if (cache->map_size != offset + (size_t)header->entry_count * sizeof(sai_capcache_entry_t) + (size_t)header->data_count * sizeof(uint32_t))
+    {
+        SAI_META_LOG_WARN("%s is truncated or corrupted", cache->config.path);
+
+        sai_capcache_unmap(cache);
+        return;
+    }
+
+    entries = (const sai_capcache_entry_t*)((const uint8_t*)map + offset);
+
+    for (idx = 0; idx < header->entry_count; idx++)
+    {
+        if ((uint64_t)entries[idx].offset + entries[idx].count > header->data_count ||
+                (idx > 0 && sai_capcache_compare_key(&entries[idx - 1], &entries[idx]) >= 0))
+        {
+            SAI_META_LOG_WARN("%s is corrupted", cache->config.path);
+
+            sai_capcache_unmap(cache);
+            return;
+        }
+    }
+
+    cache->file_entries = entries;
+    cache->file_entry_count = header->entry_count;
+    cache->file_data = (const uint32_t*)(entries + header->entry_count);
+
+    cache->stats.loaded = header->entry_count;
+    cache->stats.entries = header->entry_count;
+}
+
+sai_capcache_t* sai_capcache_open(
+        _In_ const sai_capcache_config_t *config)
+{
+    sai_capcache_t *cache;
+
+    if (config == NULL || (config->hardware_info.count && config->hardware_info.list == NULL))
+    {
+        SAI_META_LOG_ERROR("invalid capability cache config");
+
+        return NULL;
+    }
+
+    cache = (sai_capcache_t*)calloc(1, sizeof(sai_capcache_t));
+
+    if (cache == NULL)
+    {
+        return NULL;
+    }
+
+    cache->config = *config;
+
+    if (config->hardware_info.count)
+    {
+        cache->hardware_info = (int8_t*)malloc(config->hardware_info.count);
+
+        if (cache->hardware_info == NULL)
+        {
+            free(cache);
+            return NULL;
+        }
+
+        memcpy(cache->hardware_info, config->hardware_info.list, config->hardware_info.count);
+    }
+
+    cache->config.hardware_info.list = cache->hardware_info;
+
+    if (config->path != NULL)
+    {
+        cache->path = strdup(config->path);
+
+        if (cache->path == NULL)
+        {
+            free(cache->hardware_info);
+            free(cache);
+            return NULL;
+        }
+
+        cache->config.path = cache->path;
+
+        sai_capcache_load(cache);
+    }
+
+    pthread_mutex_init(&cache->mutex, NULL);
+
+    return cache;
+}
+
+void sai_capcache_close(
+        _Inout_ sai_capcache_t *cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    sai_capcache_sync(cache);
+
+    sai_capcache_free_results(cache);
+    sai_capcache_unmap(cache);
+
+    pthread_mutex_destroy(&cache->mutex);
+
+    free(cache->availability);
+    free(cache->hardware_info);
+    free(cache->path);
+    free(cache);
+}
+
+static sai_status_t sai_capcache_write(
+        _In_ FILE *file,
+        _In_ const void *data,
+        _In_ size_t size)
+{
+    if (size && fwrite(data, 1, size, file) != size)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Merges file and cached results into sorted entries with data offsets
+ * renumbered, writes them next to cache file and renames.
+ */
+
+static sai_status_t sai_capcache_write_file(
+        _In_ const sai_capcache_t *cache)
+{
+    static const uint8_t padding[8];
+
+    sai_capcache_file_header_t header;
+    sai_capcache_entry_t *entries;
+    const uint32_t **data;
+    char *tmp;
+    size_t count = 0;
+    size_t words = 0;
+    size_t idx;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    FILE *file;
+
+    count = cache->file_entry_count + cache->used;
+
+    entries = (sai_capcache_entry_t*)calloc(count + 1, sizeof(sai_capcache_entry_t));
+    data = (const uint32_t**)calloc(count + 1, sizeof(const uint32_t*));
+    tmp = (char*)malloc(strlen(cache->config.path) + 32);
+
+    if (entries == NULL || data == NULL || tmp == NULL)
+    {
+        free(entries);
+        free(data);
+        free(tmp);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    count = 0;
+
+    for (idx = 0; idx < cache->file_entry_count; idx++)
+    {
+        entries[count++] = cache->file_entries[idx];
+    }
+
+    for (idx = 0; idx < cache->size; idx++)
+    {
+        if (cache->slots[idx].used)
+        {
+            entries[count++] = cache->slots[idx].entry;
+        }
+    }
+
+    qsort(entries, count, sizeof(sai_capcache_entry_t), sai_capcache_compare_entries);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_capcache_find(cache, &entries[idx], &data[idx]);
+
+        entries[idx].offset = (uint32_t)words;
+
+        words += entries[idx].count;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAI_CAPCACHE_MAGIC, sizeof(header.magic));
+
+    header.version = SAI_CAPCACHE_VERSION;
+    header.hardware_info_size = cache->config.hardware_info.count;
+    header.header_api_version = SAI_API_VERSION;
+    header.api_version = cache->config.api_version;
+    header.entry_count = (uint32_t)count;
+    header.data_count = (uint32_t)words;
+
+    snprintf(tmp, strlen(cache->config.path) + 32, "%s.tmp.%d", cache->config.path, (int)getpid());
+
+    file = fopen(tmp, "wb");
+
+    if (file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", tmp, strerror(errno));
+
+        status = SAI_STATUS_FAILURE;
+    }
+    else
+    {
+        status = sai_capcache_write(file, &header, sizeof(header));
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            status = sai_capcache_write(file, cache->hardware_info, header.hardware_info_size);
+        }
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            status = sai_capcache_write(file, padding, SAI_CAPCACHE_ALIGN(header.hardware_info_size) - header.hardware_info_size);
+        }
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            status = sai_capcache_write(file, entries, count * sizeof(sai_capcache_entry_t));
+        }
+
+        for (idx = 0; idx < count && status == SAI_STATUS_SUCCESS; idx++)
+        {
+            status = sai_capcache_write(file, data[idx], entries[idx].count * sizeof(uint32_t));
+        }
+
+        if (fclose(file) != 0)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+
+        if (status == SAI_STATUS_SUCCESS && rename(tmp, cache->config.path) != 0)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            SAI_META_LOG_ERROR("failed to write %s: %s", cache->config.path, strerror(errno));
+
+            unlink(tmp);
+        }
+    }
+
+    free(entries);
+    free(data);
+    free(tmp);
+
+    return status;
+}
+
+sai_status_t sai_capcache_sync(
+        _Inout_ sai_capcache_t *cache)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+
+    if (cache == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+
+    if (cache->config.path != NULL && cache->dirty)
+    {
+        status = sai_capcache_write_file(cache);
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            cache->dirty = false;
+        }
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    return status;
+}
+
+void sai_capcache_clear(
+        _Inout_ sai_capcache_t *cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+
+    sai_capcache_free_results(cache);
+    sai_capcache_unmap(cache);
+
+    cache->dirty = true;
+
+    __atomic_store_n(&cache->stats.entries, 0, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+void sai_capcache_get_stats(
+        _In_ const sai_capcache_t *cache,
+        _Out_ sai_capcache_stats_t *stats)
+{
+    stats->hits = __atomic_load_n(&cache->stats.hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&cache->stats.misses, __ATOMIC_RELAXED);
+    stats->loaded = __atomic_load_n(&cache->stats.loaded, __ATOMIC_RELAXED);
+    stats->entries = __atomic_load_n(&cache->stats.entries, __ATOMIC_RELAXED);
+}
+
+/*
+ * Copies cached list into caller list with usual overflow rules, count is
+ * number of list elements of given number of data words each.
+ */
+
+static sai_status_t sai_capcache_copy_list(
+        _In_ const sai_capcache_entry_t *entry,
+        _In_ const uint32_t *data,
+        _In_ uint32_t words,
+        _Inout_ uint32_t *count,
+        _Out_ void *list)
+{
+    uint32_t elements = entry->count / words;
+
+    if (entry->status != SAI_STATUS_SUCCESS)
+    {
+        return entry->status;
+    }
+
+    if (elements > *count)
+    {
+        *count = elements;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    *count = elements;
+
+    if (elements && list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (elements)
+    {
+        memcpy(list, data, (size_t)elements * words * sizeof(uint32_t));
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_capcache_query_attribute_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability)
+{
+    sai_capcache_entry_t key;
+    const sai_capcache_entry_t *entry;
+    const uint32_t *data;
+    sai_status_t status;
+
+    if (cache == NULL || attr_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(&key, 0, sizeof(key));
+
+    key.kind = SAI_CAPCACHE_KIND_ATTR;
+    key.object_type = object_type;
+    key.attr_id = attr_id;
+
+    pthread_mutex_lock(&cache->mutex);
+
+    entry = sai_capcache_find(cache, &key, &data);
+
+    if (entry != NULL)
+    {
+        status = entry->status;
+
+        attr_capability->create_implemented = (entry->flags & SAI_CAPCACHE_FLAG_CREATE) != 0;
+        attr_capability->set_implemented = (entry->flags & SAI_CAPCACHE_FLAG_SET) != 0;
+        attr_capability->get_implemented = (entry->flags & SAI_CAPCACHE_FLAG_GET) != 0;
+
+        pthread_mutex_unlock(&cache->mutex);
+
+        SAI_CAPCACHE_STAT_ADD(cache->stats.hits, 1);
+
+        return status;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    SAI_CAPCACHE_STAT_ADD(cache->stats.misses, 1);
+
+    if (cache->config.query_attribute_capability == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    status = cache->config.query_attribute_capability(switch_id, object_type, attr_id, attr_capability);
+
+    if (!sai_capcache_is_cacheable(status))
+    {
+        return status;
+    }
+
+    key.status = status;
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        key.flags = (attr_capability->create_implemented ? SAI_CAPCACHE_FLAG_CREATE : 0) |
+            (attr_capability->set_implemented ? SAI_CAPCACHE_FLAG_SET : 0) |
+            (attr_capability->get_implemented ? SAI_CAPCACHE_FLAG_GET : 0);
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+
+    sai_capcache_insert(cache, &key, NULL);
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    return status;
+}
+
+/*
+ * Whole list is fetched from vendor into own buffer, starting with size
+ * known from metadata, so cached list never depends on caller list size.
+ */
+
+static sai_status_t sai_capcache_fetch_enum_values(
+        _In_ const sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ int32_t **values,
+        _Out_ uint32_t *count)
+{
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_id);
+    sai_s32_list_t list;
+    uint32_t size = (md != NULL && md->enummetadata != NULL) ? (uint32_t)md->enummetadata->valuescount : 0;
+    sai_status_t status = SAI_STATUS_BUFFER_OVERFLOW;
+    int retry;
+
+    *values = NULL;
+    *count = 0;
+
+    for (retry = 0; retry < SAI_CAPCACHE_LIST_RETRIES && status == SAI_STATUS_BUFFER_OVERFLOW; retry++)
+    {
+        free(*values);
+
+        *values = (int32_t*)malloc(((size_t)size + 1) * sizeof(int32_t));
+
+        if (*values == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        list.count = size;
+        list.list = *values;
+
+        status = cache->config.query_attribute_enum_values_capability(switch_id, object_type, attr_id, &list);
+
+        size = list.count;
+    }
+
+    *count = (status == SAI_STATUS_SUCCESS) ? list.count : 0;
+
+    return status;
+}
+
+sai_status_t sai_capcache_query_attribute_enum_values_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability)
+{
+    sai_capcache_entry_t key;
+    const sai_capcache_entry_t *entry;
+    const uint32_t *data;
+    int32_t *values;
+    uint32_t count;
+    sai_status_t status;
+
+    if (cache == NULL || enum_values_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(&key, 0, sizeof(key));
+
+    key.kind = SAI_CAPCACHE_KIND_ENUM;
+    key.object_type = object_type;
+    key.attr_id = attr_id;
+
+    pthread_mutex_lock(&cache->mutex);
+
+    entry = sai_capcache_find(cache, &key, &data);
+
+    if (entry != NULL)
+    {
+        status = sai_capcache_copy_list(entry, data, 1, &enum_values_capability->count, enum_values_capability->list);
+
+        pthread_mutex_unlock(&cache->mutex);
+
+        SAI_CAPCACHE_STAT_ADD(cache->stats.hits, 1);
+
+        return status;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    SAI_CAPCACHE_STAT_ADD(cache->stats.misses, 1);
+
+    if (cache->config.query_attribute_enum_values_capability == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    status = sai_capcache_fetch_enum_values(cache, switch_id, object_type, attr_id, &values, &count);
+
+    if (sai_capcache_is_cacheable(status))
+    {
+        key.status = status;
+        key.count = count;
+
+        pthread_mutex_lock(&cache->mutex);
+
+        sai_capcache_insert(cache, &key, (const uint32_t*)values);
+
+        status = sai_capcache_copy_list(&key, (const uint32_t*)values, 1, &enum_values_capability->count, enum_values_capability->list);
+
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    free(values);
+
+    return status;
+}
+
+static sai_status_t sai_capcache_fetch_stats(
+        _In_ const sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Out_ sai_stat_capability_t **stats,
+        _Out_ uint32_t *count)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+    sai_stat_capability_list_t list;
+    uint32_t size = (info != NULL && info->statenum != NULL) ? (uint32_t)info->statenum->valuescount : 0;
+    sai_status_t status = SAI_STATUS_BUFFER_OVERFLOW;
+    int retry;
+
+    *stats = NULL;
+    *count = 0;
+
+    for (retry = 0; retry < SAI_CAPCACHE_LIST_RETRIES && status == SAI_STATUS_BUFFER_OVERFLOW; retry++)
+    {
+        free(*stats);
+
+        *stats = (sai_stat_capability_t*)malloc(((size_t)size + 1) * sizeof(sai_stat_capability_t));
+
+        if (*stats == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        list.count = size;
+        list.list = *stats;
+
+        status = cache->config.query_stats_capability(switch_id, object_type, &list);
+
+        size = list.count;
+    }
+
+    *count = (status == SAI_STATUS_SUCCESS) ? list.count : 0;
+
+    return status;
+}
+
+sai_status_t sai_capcache_query_stats_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability)
+{
+    sai_capcache_entry_t key;
+    const sai_capcache_entry_t *entry;
+    const uint32_t *data;
+    sai_stat_capability_t *stats;
+    uint32_t count;
+    sai_status_t status;
+
+    if (cache == NULL || stats_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(&key, 0, sizeof(key));
+
+    key.kind = SAI_CAPCACHE_KIND_STATS;
+    key.object_type = object_type;
+
+    pthread_mutex_lock(&cache->mutex);
+
+    entry = sai_capcache_find(cache, &key, &data);
+
+    if (entry != NULL)
+    {
+        status = sai_capcache_copy_list(entry, data, 2, &stats_capability->count, stats_capability->list);
+
+        pthread_mutex_unlock(&cache->mutex);
+
+        SAI_CAPCACHE_STAT_ADD(cache->stats.hits, 1);
+
+        return status;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    SAI_CAPCACHE_STAT_ADD(cache->stats.misses, 1);
+
+    if (cache->config.query_stats_capability == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    status = sai_capcache_fetch_stats(cache, switch_id, object_type, &stats, &count);
+
+    if (sai_capcache_is_cacheable(status))
+    {
+        /* stat capability is two 32 bit words, stat enum and stat modes */
+
+        key.status = status;
+        key.count = 2 * count;
+
+        pthread_mutex_lock(&cache->mutex);
+
+        sai_capcache_insert(cache, &key, (const uint32_t*)stats);
+
+        status = sai_capcache_copy_list(&key, (const uint32_t*)stats, 2, &stats_capability->count, stats_capability->list);
+
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    free(stats);
+
+    return status;
+}
+
+static bool sai_capcache_availability_match(
+        _In_ const sai_capcache_availability_t *entry,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    if (entry->object_type != object_type || entry->attr_count != attr_count)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        if (md == NULL ||
+                entry->attr_list[idx].id != attr_list[idx].id ||
+                sai_metadata_compare_attribute_value(md, &entry->attr_list[idx].value, &attr_list[idx].value) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Availability is queried for a handful of object types and attribute
+ * lists (resource monitoring), so entries are kept in array.
+ */
+
+static sai_capcache_availability_t* sai_capcache_availability_find(
+        _In_ const sai_capcache_t *cache,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    size_t idx;
+
+    for (idx = 0; idx < cache->availability_count; idx++)
+    {
+        if (sai_capcache_availability_match(&cache->availability[idx], object_type, attr_count, attr_list))
+        {
+            return &cache->availability[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static void sai_capcache_availability_store(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ uint64_t count,
+        _In_ uint64_t expires)
+{
+    sai_capcache_availability_t *entry = sai_capcache_availability_find(cache, object_type, attr_count, attr_list);
+    sai_attribute_t *copy = NULL;
+
+    if (entry == NULL)
+    {
+        if (attr_count && sai_metadata_deep_copy_attr_list(object_type, attr_count, attr_list, NULL, &copy) != SAI_STATUS_SUCCESS)
+        {
+            return;
+        }
+
+        if (cache->availability_count == cache->availability_size)
+        {
+            size_t size = cache->availability_size ? 2 * cache->availability_size : 16;
+
+            sai_capcache_availability_t *availability = (sai_capcache_availability_t*)realloc(cache->availability,
+                    size * sizeof(sai_capcache_availability_t));
+
+            if (availability == NULL)
+            {
+                free(copy);
+                return;
+            }
+
+            cache->availability = availability;
+            cache->availability_size = size;
+        }
+
+        entry = &cache->availability[cache->availability_count++];
+
+        entry->object_type = object_type;
+        entry->attr_count = attr_count;
+        entry->attr_list = copy;
+    }
+
+    entry->count = count;
+    entry->expires = expires;
+}
+
+sai_status_t sai_capcache_object_type_get_availability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count)
+{
+    const sai_capcache_availability_t *entry;
+    uint64_t now;
+    sai_status_t status;
+
+    if (cache == NULL || count == NULL || (attr_count && attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (cache->config.availability_ttl)
+    {
+        now = sai_metadata_now();
+
+        pthread_mutex_lock(&cache->mutex);
+
+        entry = sai_capcache_availability_find(cache, object_type, attr_count, attr_list);
+
+        if (entry != NULL && entry->expires > now)
+        {
+            *count = entry->count;
+
+            pthread_mutex_unlock(&cache->mutex);
+
+            SAI_CAPCACHE_STAT_ADD(cache->stats.hits, 1);
+
+            return SAI_STATUS_SUCCESS;
+        }
+
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    SAI_CAPCACHE_STAT_ADD(cache->stats.misses, 1);
+
+    if (cache->config.object_type_get_availability == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    status = cache->config.object_type_get_availability(switch_id, object_type, attr_count, attr_list, count);
+
+    if (status == SAI_STATUS_SUCCESS && cache->config.availability_ttl)
+    {
+        now = sai_metadata_now();
+
+        pthread_mutex_lock(&cache->mutex);
+
+        sai_capcache_availability_store(cache, object_type, attr_count, attr_list, *count, now + cache->config.availability_ttl);
+
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    return status;
+}
@@ -0,0 +1,283 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicapcache.h
+ *
+ * @brief   This module defines SAI capability query cache
+ */
+
+#ifndef __SAICAPCACHE_H_
+#define __SAICAPCACHE_H_
+
+/**
+ * @defgroup SAICAPCACHE SAI - Capability query cache
+ *
+ * Cache wraps sai_query_attribute_capability,
+ * sai_query_attribute_enum_values_capability, sai_query_stats_capability
+ * and sai_object_type_get_availability of single switch. First query of a
+ * key calls the vendor, later queries are answered from memory.
+ *
+ * Capability results are persisted to cache file, which is mapped into
+ * memory when cache is opened, so process restart skips capability
+ * discovery. File is keyed by hardware info of switch
+ * (SAI_SWITCH_ATTR_SWITCH_HARDWARE_INFO) and SAI API version of vendor
+ * library (sai_query_api_version), file with other key or written by build
+ * with other SAI headers is ignored and rewritten on sync. Results are
+ * cached when query succeeds or when it reports attribute or query not
+ * supported or not implemented, other failures are passed to caller and
+ * the next query calls vendor again.
+ *
+ * Availability changes with resource usage, so it is cached only in memory,
+ * for configured time to live, per object type and attribute list.
+ *
+ * Switch id argument is passed to vendor only, cache keys ignore it. Cache
+ * is thread safe, vendor is called without cache lock held.
+ *
+ * @{
+ */
+
+/**
+ * @brief Cache configuration
+ */
+typedef struct _sai_capcache_config_t
+{
+    /**
+     * @brief Vendor sai_query_attribute_capability, NULL when not supported
+     */
+    sai_status_t (*query_attribute_capability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability);
+
+    /**
+     * @brief Vendor sai_query_attribute_enum_values_capability, NULL when not supported
+     */
+    sai_status_t (*query_attribute_enum_values_capability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability);
+
+    /**
+     * @brief Vendor sai_query_stats_capability, NULL when not supported
+     */
+    sai_status_t (*query_stats_capability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability);
+
+    /**
+     * @brief Vendor sai_object_type_get_availability, NULL when not supported
+     */
+    sai_status_t (*object_type_get_availability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count);
+
+    /**
+     * @brief Cache file path, NULL for memory only cache
+     */
+    const char *path;
+
+    /**
+     * @brief Switch hardware info, part of cache file key
+     */
+    sai_s8_list_t hardware_info;
+
+    /**
+     * @brief Vendor SAI API version, part of cache file key
+     */
+    sai_api_version_t api_version;
+
+    /**
+     * @brief Availability time to live in nanoseconds, 0 disables caching
+     */
+    uint64_t availability_ttl;
+
+} sai_capcache_config_t;
+
+/**
+ * @brief Cache statistics
+ */
+typedef struct _sai_capcache_stats_t
+{
+    /**
+     * @brief Number of queries answered from cache
+     */
+    uint64_t hits;
+
+    /**
+     * @brief Number of queries passed to vendor
+     */
+    uint64_t misses;
+
+    /**
+     * @brief Number of capability results loaded from cache file
+     */
+    uint64_t loaded;
+
+    /**
+     * @brief Number of capability results cached in total
+     */
+    uint64_t entries;
+
+} sai_capcache_stats_t;
+
+/**
+ * @brief Opaque cache
+ */
+typedef struct _sai_capcache_t sai_capcache_t;
+
+/**
+ * @brief Create cache and load cache file
+ *
+ * Missing cache file or file with other key is not an error, cache starts
+ * empty then.
+ *
+ * @param[in] config Configuration, hardware info is copied
+ *
+ * @return Cache or NULL on error
+ */
+extern sai_capcache_t* sai_capcache_open(
+        _In_ const sai_capcache_config_t *config);
+
+/**
+ * @brief Sync cache file and destroy cache
+ *
+ * @param[inout] cache Cache
+ */
+extern void sai_capcache_close(
+        _Inout_ sai_capcache_t *cache);
+
+/**
+ * @brief Write cache file when new results were cached since last sync
+ *
+ * File is written to temporary file and renamed, so readers never see
+ * partial file.
+ *
+ * @param[inout] cache Cache
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_capcache_sync(
+        _Inout_ sai_capcache_t *cache);
+
+/**
+ * @brief Drop all cached results, cache file is rewritten on next sync
+ *
+ * @param[inout] cache Cache
+ */
+extern void sai_capcache_clear(
+        _Inout_ sai_capcache_t *cache);
+
+/**
+ * @brief Get cache statistics
+ *
+ * @param[in] cache Cache
+ * @param[out] stats Statistics
+ */
+extern void sai_capcache_get_stats(
+        _In_ const sai_capcache_t *cache,
+        _Out_ sai_capcache_stats_t *stats);
+
+/**
+ * @brief Cached sai_query_attribute_capability
+ *
+ * @param[inout] cache Cache
+ * @param[in] switch_id Switch id passed to vendor
+ * @param[in] object_type Object type
+ * @param[in] attr_id Attribute id
+ * @param[out] attr_capability Capability
+ *
+ * @return Status of vendor query
+ */
+extern sai_status_t sai_capcache_query_attribute_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability);
+
+/**
+ * @brief Cached sai_query_attribute_enum_values_capability
+ *
+ * Whole list is cached on first query regardless of caller list size.
+ *
+ * @param[inout] cache Cache
+ * @param[in] switch_id Switch id passed to vendor
+ * @param[in] object_type Object type
+ * @param[in] attr_id Attribute id
+ * @param[inout] enum_values_capability List of supported enum values
+ *
+ * @return Status of vendor query, #SAI_STATUS_BUFFER_OVERFLOW when list is
+ * too small
+ */
+extern sai_status_t sai_capcache_query_attribute_enum_values_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability);
+
+/**
+ * @brief Cached sai_query_stats_capability
+ *
+ * Whole list is cached on first query regardless of caller list size.
+ *
+ * @param[inout] cache Cache
+ * @param[in] switch_id Switch id passed to vendor
+ * @param[in] object_type Object type
+ * @param[inout] stats_capability List of supported statistics
+ *
+ * @return Status of vendor query, #SAI_STATUS_BUFFER_OVERFLOW when list is
+ * too small
+ */
+extern sai_status_t sai_capcache_query_stats_capability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability);
+
+/**
+ * @brief Cached sai_object_type_get_availability
+ *
+ * @param[inout] cache Cache
+ * @param[in] switch_id Switch id passed to vendor
+ * @param[in] object_type Object type
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ * @param[out] count Number of objects which can be created
+ *
+ * @return Status of vendor query
+ */
+extern sai_status_t sai_capcache_object_type_get_availability(
+        _Inout_ sai_capcache_t *cache,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count);
+
+/**
+ * @}
+ */
+#endif /** __SAICAPCACHE_H_ */
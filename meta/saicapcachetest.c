@@ -0,0 +1,443 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicapcachetest.c
+ *
+ * @brief   This module implements SAI capability query cache tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saicapcache.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_FILE "saicapcachetest.cache"
+
+#define TEST_SWITCH_ID 0x21000000000000ULL
+
+#define TEST_API_VERSION SAI_VERSION(1, 14, 0)
+
+static uint32_t test_vendor_calls = 0;
+
+static uint64_t test_available = 100;
+
+static int8_t test_hardware_info[] = { 'a', 's', 'i', 'c', '0' };
+
+static int8_t test_other_hardware_info[] = { 'a', 's', 'i', 'c', '1' };
+
+/*
+ * Vendor implementing MTU and admin state of port, packet action of route
+ * entry (forward and drop) and two port statistics.
+ */
+
+static sai_status_t test_query_attribute_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability)
+{
+    test_vendor_calls++;
+
+    if (object_type == SAI_OBJECT_TYPE_PORT && attr_id == SAI_PORT_ATTR_MTU)
+    {
+        attr_capability->create_implemented = true;
+        attr_capability->set_implemented = true;
+        attr_capability->get_implemented = true;
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (object_type == SAI_OBJECT_TYPE_PORT && attr_id == SAI_PORT_ATTR_ADMIN_STATE)
+    {
+        attr_capability->create_implemented = false;
+        attr_capability->set_implemented = true;
+        attr_capability->get_implemented = false;
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (object_type == SAI_OBJECT_TYPE_PORT)
+    {
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    return SAI_STATUS_UNINITIALIZED;
+}
+
+static sai_status_t test_query_attribute_enum_values_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability)
+{
+    test_vendor_calls++;
+
+    if (object_type != SAI_OBJECT_TYPE_ROUTE_ENTRY || attr_id != SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)
+    {
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (enum_values_capability->count < 2)
+    {
+        enum_values_capability->count = 2;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    enum_values_capability->count = 2;
+    enum_values_capability->list[0] = SAI_PACKET_ACTION_FORWARD;
+    enum_values_capability->list[1] = SAI_PACKET_ACTION_DROP;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_query_stats_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability)
+{
+    test_vendor_calls++;
+
+    if (object_type != SAI_OBJECT_TYPE_PORT)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    if (stats_capability->count < 2)
+    {
+        stats_capability->count = 2;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    stats_capability->count = 2;
+    stats_capability->list[0].stat_enum = SAI_PORT_STAT_IF_IN_OCTETS;
+    stats_capability->list[0].stat_modes = SAI_STATS_MODE_READ | SAI_STATS_MODE_READ_AND_CLEAR;
+    stats_capability->list[1].stat_enum = SAI_PORT_STAT_IF_OUT_OCTETS;
+    stats_capability->list[1].stat_modes = SAI_STATS_MODE_READ;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_object_type_get_availability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count)
+{
+    test_vendor_calls++;
+
+    *count = test_available + attr_count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_capcache_config_t test_config(
+        _In_ const char *path)
+{
+    sai_capcache_config_t config;
+
+    memset(&config, 0, sizeof(config));
+
+    config.query_attribute_capability = test_query_attribute_capability;
+    config.query_attribute_enum_values_capability = test_query_attribute_enum_values_capability;
+    config.query_stats_capability = test_query_stats_capability;
+    config.object_type_get_availability = test_object_type_get_availability;
+    config.path = path;
+    config.hardware_info.count = sizeof(test_hardware_info);
+    config.hardware_info.list = test_hardware_info;
+    config.api_version = TEST_API_VERSION;
+
+    return config;
+}
+
+/*
+ * Queries every cached key, checks results and returns number of vendor
+ * calls made by queries.
+ */
+
+static uint32_t test_query_all(
+        _Inout_ sai_capcache_t *cache)
+{
+    uint32_t calls = test_vendor_calls;
+    sai_attr_capability_t cap;
+    int32_t values[4];
+    sai_s32_list_t list;
+    sai_stat_capability_t stats[4];
+    sai_stat_capability_list_t stats_list;
+
+    memset(&cap, 0, sizeof(cap));
+
+    ASSERT_TRUE(sai_capcache_query_attribute_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_MTU, &cap) == SAI_STATUS_SUCCESS, "mtu");
+    ASSERT_TRUE(cap.create_implemented && cap.set_implemented && cap.get_implemented, "mtu capability");
+
+    ASSERT_TRUE(sai_capcache_query_attribute_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_ADMIN_STATE, &cap) == SAI_STATUS_SUCCESS, "admin state");
+    ASSERT_TRUE(!cap.create_implemented && cap.set_implemented && !cap.get_implemented, "admin state capability");
+
+    ASSERT_TRUE(sai_capcache_query_attribute_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_SPEED, &cap) == SAI_STATUS_NOT_SUPPORTED, "speed");
+
+    list.count = 4;
+    list.list = values;
+
+    ASSERT_TRUE(sai_capcache_query_attribute_enum_values_capability(cache, TEST_SWITCH_ID,
+                SAI_OBJECT_TYPE_ROUTE_ENTRY, SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION, &list) == SAI_STATUS_SUCCESS, "enum values");
+    ASSERT_TRUE(list.count == 2 && values[0] == SAI_PACKET_ACTION_FORWARD && values[1] == SAI_PACKET_ACTION_DROP, "enum values");
+
+    list.count = 1;
+
+    ASSERT_TRUE(sai_capcache_query_attribute_enum_values_capability(cache, TEST_SWITCH_ID,
+                SAI_OBJECT_TYPE_ROUTE_ENTRY, SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION, &list) == SAI_STATUS_BUFFER_OVERFLOW, "small list");
+    ASSERT_TRUE(list.count == 2, "required count");
+
+    stats_list.count = 4;
+    stats_list.list = stats;
+
+    ASSERT_TRUE(sai_capcache_query_stats_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_PORT, &stats_list) == SAI_STATUS_SUCCESS, "stats");
+    ASSERT_TRUE(stats_list.count == 2, "stats count");
+    ASSERT_TRUE(stats[0].stat_enum == SAI_PORT_STAT_IF_IN_OCTETS, "stat enum");
+    ASSERT_TRUE(stats[0].stat_modes == (SAI_STATS_MODE_READ | SAI_STATS_MODE_READ_AND_CLEAR), "stat modes");
+    ASSERT_TRUE(stats[1].stat_enum == SAI_PORT_STAT_IF_OUT_OCTETS && stats[1].stat_modes == SAI_STATS_MODE_READ, "stat");
+
+    stats_list.count = 0;
+
+    ASSERT_TRUE(sai_capcache_query_stats_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_PORT, &stats_list) == SAI_STATUS_BUFFER_OVERFLOW, "stats overflow");
+    ASSERT_TRUE(stats_list.count == 2, "stats required count");
+
+    ASSERT_TRUE(sai_capcache_query_stats_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_QUEUE, &stats_list) == SAI_STATUS_NOT_IMPLEMENTED, "queue stats");
+
+    return test_vendor_calls - calls;
+}
+
+static void test_memory()
+{
+    sai_capcache_config_t config = test_config(NULL);
+    sai_capcache_stats_t stats;
+    sai_attr_capability_t cap;
+    sai_capcache_t *cache;
+
+    cache = sai_capcache_open(&config);
+
+    ASSERT_TRUE(cache != NULL, "open");
+
+    ASSERT_TRUE(test_query_all(cache) > 0, "vendor not called");
+    ASSERT_TRUE(test_query_all(cache) == 0, "vendor called for cached results");
+
+    /* transient failure is not cached */
+
+    ASSERT_TRUE(sai_capcache_query_attribute_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY,
+                SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION, &cap) == SAI_STATUS_UNINITIALIZED, "failure");
+
+    test_vendor_calls = 0;
+
+    ASSERT_TRUE(sai_capcache_query_attribute_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY,
+                SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION, &cap) == SAI_STATUS_UNINITIALIZED, "failure");
+    ASSERT_TRUE(test_vendor_calls == 1, "failure was cached");
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.entries == 6, "entries %u", (uint32_t)stats.entries);
+    ASSERT_TRUE(stats.loaded == 0, "loaded");
+    ASSERT_TRUE(stats.hits == 10, "hits %u", (uint32_t)stats.hits);
+
+    ASSERT_TRUE(sai_capcache_sync(cache) == SAI_STATUS_SUCCESS, "memory only sync");
+
+    sai_capcache_clear(cache);
+
+    ASSERT_TRUE(test_query_all(cache) > 0, "vendor not called after clear");
+
+    sai_capcache_close(cache);
+}
+
+static void test_persist()
+{
+    sai_capcache_config_t config = test_config(TEST_FILE);
+    sai_capcache_stats_t stats;
+    sai_stat_capability_list_t empty;
+    sai_capcache_t *cache;
+    FILE *file;
+
+    unlink(TEST_FILE);
+
+    cache = sai_capcache_open(&config);
+
+    ASSERT_TRUE(cache != NULL, "open");
+    ASSERT_TRUE(test_query_all(cache) > 0, "vendor not called");
+
+    sai_capcache_close(cache);
+
+    ASSERT_TRUE(access(TEST_FILE, F_OK) == 0, "file not written");
+
+    /* restart with the same switch answers from file */
+
+    cache = sai_capcache_open(&config);
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.loaded == 6, "loaded %u", (uint32_t)stats.loaded);
+    ASSERT_TRUE(test_query_all(cache) == 0, "vendor called after restart");
+
+    /* new result is merged into file on sync */
+
+    empty.count = 0;
+    empty.list = NULL;
+
+    ASSERT_TRUE(sai_capcache_query_stats_capability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTER_INTERFACE,
+                &empty) == SAI_STATUS_NOT_IMPLEMENTED, "rif stats");
+    ASSERT_TRUE(sai_capcache_sync(cache) == SAI_STATUS_SUCCESS, "sync");
+    ASSERT_TRUE(test_query_all(cache) == 0, "vendor called after sync");
+
+    sai_capcache_close(cache);
+
+    cache = sai_capcache_open(&config);
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.loaded == 7, "loaded %u", (uint32_t)stats.loaded);
+
+    sai_capcache_close(cache);
+
+    /* upgrade of vendor library invalidates file */
+
+    config.api_version = SAI_VERSION(1, 15, 0);
+
+    cache = sai_capcache_open(&config);
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.loaded == 0, "file of other version loaded");
+    ASSERT_TRUE(test_query_all(cache) > 0, "vendor not called after upgrade");
+
+    sai_capcache_close(cache);
+
+    /* other hardware */
+
+    config.hardware_info.list = test_other_hardware_info;
+
+    cache = sai_capcache_open(&config);
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.loaded == 0, "file of other hardware loaded");
+
+    sai_capcache_close(cache);
+
+    /* truncated file is ignored */
+
+    file = fopen(TEST_FILE, "r+b");
+
+    ASSERT_TRUE(file != NULL && ftruncate(fileno(file), 100) == 0, "truncate");
+
+    fclose(file);
+
+    cache = sai_capcache_open(&config);
+
+    sai_capcache_get_stats(cache, &stats);
+
+    ASSERT_TRUE(stats.loaded == 0, "truncated file loaded");
+    ASSERT_TRUE(test_query_all(cache) > 0, "vendor not called");
+
+    sai_capcache_close(cache);
+
+    unlink(TEST_FILE);
+}
+
+static void test_availability()
+{
+    sai_capcache_config_t config = test_config(NULL);
+    sai_attribute_t attr;
+    struct timespec delay = { 0, 1000000 };
+    sai_capcache_t *cache;
+    uint64_t count = 0;
+
+    attr.id = SAI_ACL_TABLE_ATTR_ACL_STAGE;
+    attr.value.s32 = SAI_ACL_STAGE_INGRESS;
+
+    config.availability_ttl = 3600ULL * 1000000000ULL;
+
+    cache = sai_capcache_open(&config);
+
+    test_vendor_calls = 0;
+    test_available = 100;
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, &count) == SAI_STATUS_SUCCESS, "route");
+    ASSERT_TRUE(count == 100, "route count");
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ACL_TABLE, 1, &attr, &count) == SAI_STATUS_SUCCESS, "acl");
+    ASSERT_TRUE(count == 101, "acl count");
+
+    test_available = 50;
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, &count) == SAI_STATUS_SUCCESS, "route");
+    ASSERT_TRUE(count == 100, "cached route count");
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ACL_TABLE, 1, &attr, &count) == SAI_STATUS_SUCCESS, "acl");
+    ASSERT_TRUE(count == 101, "cached acl count");
+
+    ASSERT_TRUE(test_vendor_calls == 2, "vendor calls %u", test_vendor_calls);
+
+    /* other attribute value is other key */
+
+    attr.value.s32 = SAI_ACL_STAGE_EGRESS;
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ACL_TABLE, 1, &attr, &count) == SAI_STATUS_SUCCESS, "acl");
+    ASSERT_TRUE(count == 51, "egress acl count");
+
+    sai_capcache_close(cache);
+
+    /* expired */
+
+    config.availability_ttl = 1;
+
+    cache = sai_capcache_open(&config);
+
+    test_vendor_calls = 0;
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, &count) == SAI_STATUS_SUCCESS, "route");
+
+    nanosleep(&delay, NULL);
+
+    ASSERT_TRUE(sai_capcache_object_type_get_availability(cache, TEST_SWITCH_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, &count) == SAI_STATUS_SUCCESS, "route");
+    ASSERT_TRUE(test_vendor_calls == 2, "expired availability used");
+
+    sai_capcache_close(cache);
+}
+
+int main()
+{
+    test_memory();
+
+    test_persist();
+
+    test_availability();
+
+    return 0;
+}
@@ -0,0 +1,1002 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicrm.c
+ *
+ * @brief   This module implements SAI CRM resource accounting
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saicrm.h"
+
+#define SAI_CRM_MEMO_MIN_SIZE 256
+
+#define SAI_CRM_DEFAULT_HIGH_THRESHOLD 85
+
+#define SAI_CRM_DEFAULT_LOW_THRESHOLD 70
+
+typedef struct _sai_crm_entry_t
+{
+    char *name;
+
+    sai_object_type_t object_type;
+
+    uint32_t attr_count;
+
+    sai_attribute_t *attr_list;
+
+    const sai_attr_metadata_t **attr_metadata;
+
+    /* index of attribute matched against key address family, attr_count for none */
+
+    uint32_t family_index;
+
+    size_t family_offset;
+
+    sai_attr_id_t available_attr_id;
+
+    sai_crm_threshold_type_t threshold_type;
+
+    uint64_t high_threshold;
+
+    uint64_t low_threshold;
+
+    uint64_t used;
+
+    uint64_t available;
+
+    int64_t drift;
+
+    uint64_t synced_at;
+
+    uint64_t polled_at;
+
+    bool polled;
+
+    bool synced;
+
+    bool exceeded;
+
+    bool due;
+
+} sai_crm_entry_t;
+
+/*
+ * Resources matched by attributes of created object, by object id.
+ */
+
+typedef struct _sai_crm_memo_t
+{
+    sai_object_id_t object_id;
+
+    uint64_t resources;
+
+} sai_crm_memo_t;
+
+struct _sai_crm_t
+{
+    sai_crm_config_t config;
+
+    sai_crm_entry_t entries[SAI_CRM_MAX_RESOURCES];
+
+    size_t count;
+
+    /* resources which need attributes of created object to match */
+
+    uint64_t memo_resources;
+
+    sai_crm_memo_t *memo;
+
+    size_t memo_size;
+
+    size_t memo_used;
+
+    /* threshold events, taken from head */
+
+    sai_crm_event_t *events;
+
+    size_t events_head;
+
+    size_t events_count;
+
+    size_t events_size;
+
+    bool reported;
+
+    sai_crm_stats_t stats;
+};
+
+sai_crm_t* sai_crm_open(
+        _In_ const sai_crm_config_t *config)
+{
+    sai_crm_t *crm;
+
+    if (config == NULL)
+    {
+        SAI_META_LOG_ERROR("invalid crm config");
+
+        return NULL;
+    }
+
+    crm = (sai_crm_t*)calloc(1, sizeof(sai_crm_t));
+
+    if (crm == NULL)
+    {
+        return NULL;
+    }
+
+    crm->config = *config;
+
+    return crm;
+}
+
+void sai_crm_close(
+        _Inout_ sai_crm_t *crm)
+{
+    size_t idx;
+
+    if (crm == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        free(crm->entries[idx].name);
+        free(crm->entries[idx].attr_list);
+        free((void*)crm->entries[idx].attr_metadata);
+    }
+
+    free(crm->events);
+    free(crm->memo);
+    free(crm);
+}
+
+/*
+ * Read only IP address family attribute of non object id type is matched
+ * against first IP address or prefix member of object key.
+ */
+
+static bool sai_crm_key_family_offset(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_attr_metadata_t *md,
+        _Out_ size_t *offset)
+{
+    size_t idx;
+
+    if (!info->isnonobjectid || !SAI_HAS_FLAG_READ_ONLY(md->flags) ||
+            md->enummetadata != &sai_metadata_enum_sai_ip_addr_family_t)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_ADDRESS ||
+                m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_PREFIX)
+        {
+            /* address family is first member of both */
+
+            *offset = m->offset;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static sai_status_t sai_crm_check_available_attr(
+        _In_ sai_attr_id_t attr_id)
+{
+    const sai_attr_metadata_t *md;
+
+    if (attr_id == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_SWITCH, attr_id);
+
+    if (md == NULL || !SAI_HAS_FLAG_READ_ONLY(md->flags) ||
+            (md->attrvaluetype != SAI_ATTR_VALUE_TYPE_UINT32 && md->attrvaluetype != SAI_ATTR_VALUE_TYPE_UINT64))
+    {
+        SAI_META_LOG_ERROR("attribute %d is not available count of switch", attr_id);
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_crm_add_resource(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_crm_resource_t *resource,
+        _Out_ size_t *index)
+{
+    const sai_object_type_info_t *info;
+    sai_crm_entry_t *entry;
+    sai_status_t status;
+    bool memo = false;
+    uint32_t idx;
+
+    if (crm == NULL || resource == NULL || index == NULL || resource->name == NULL ||
+            (resource->attr_count && resource->attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (crm->count == SAI_CRM_MAX_RESOURCES || crm->reported)
+    {
+        SAI_META_LOG_ERROR("can't add crm resource %s", resource->name);
+
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    info = sai_metadata_get_object_type_info(resource->object_type);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    status = sai_crm_check_available_attr(resource->available_attr_id);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    entry = &crm->entries[crm->count];
+
+    memset(entry, 0, sizeof(*entry));
+
+    entry->family_index = resource->attr_count;
+
+    if (resource->attr_count)
+    {
+        entry->attr_metadata = (const sai_attr_metadata_t**)calloc(resource->attr_count, sizeof(sai_attr_metadata_t*));
+
+        if (entry->attr_metadata == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+    }
+
+    for (idx = 0; idx < resource->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(resource->object_type, resource->attr_list[idx].id);
+
+        if (md == NULL || !md->isresourcetype)
+        {
+            SAI_META_LOG_ERROR("attribute %d of %s is not resource type", resource->attr_list[idx].id, resource->name);
+
+            status = SAI_STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        entry->attr_metadata[idx] = md;
+
+        if (sai_crm_key_family_offset(info, md, &entry->family_offset))
+        {
+            entry->family_index = idx;
+            continue;
+        }
+
+        if (!info->isobjectid || SAI_HAS_FLAG_READ_ONLY(md->flags))
+        {
+            SAI_META_LOG_ERROR("%s can't be matched on create and remove", md->attridname);
+
+            status = SAI_STATUS_NOT_SUPPORTED;
+            break;
+        }
+
+        memo = true;
+    }
+
+    if (status == SAI_STATUS_SUCCESS && resource->attr_count)
+    {
+        status = sai_metadata_deep_copy_attr_list(resource->object_type, resource->attr_count,
+                resource->attr_list, NULL, &entry->attr_list);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        entry->name = strdup(resource->name);
+
+        status = entry->name == NULL ? SAI_STATUS_NO_MEMORY : SAI_STATUS_SUCCESS;
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        free(entry->attr_list);
+        free((void*)entry->attr_metadata);
+        memset(entry, 0, sizeof(*entry));
+
+        return status;
+    }
+
+    entry->object_type = resource->object_type;
+    entry->attr_count = resource->attr_count;
+    entry->available_attr_id = resource->available_attr_id;
+    entry->threshold_type = resource->threshold_type;
+    entry->high_threshold = resource->high_threshold;
+    entry->low_threshold = resource->low_threshold;
+
+    if (memo)
+    {
+        crm->memo_resources |= 1ULL << crm->count;
+    }
+
+    *index = crm->count++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+typedef struct _sai_crm_default_resource_t
+{
+    const char *name;
+
+    sai_object_type_t object_type;
+
+    sai_attr_id_t family_attr_id;
+
+    sai_ip_addr_family_t family;
+
+    sai_attr_id_t available_attr_id;
+
+} sai_crm_default_resource_t;
+
+/*
+ * Resources with legacy available attribute of switch, family attribute 0
+ * for none.
+ */
+
+static const sai_crm_default_resource_t sai_crm_default_resources[] = {
+    { "ipv4_route", SAI_OBJECT_TYPE_ROUTE_ENTRY, SAI_ROUTE_ENTRY_ATTR_IP_ADDR_FAMILY, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_IPV4_ROUTE_ENTRY },
+    { "ipv6_route", SAI_OBJECT_TYPE_ROUTE_ENTRY, SAI_ROUTE_ENTRY_ATTR_IP_ADDR_FAMILY, SAI_IP_ADDR_FAMILY_IPV6, SAI_SWITCH_ATTR_AVAILABLE_IPV6_ROUTE_ENTRY },
+    { "ipv4_neighbor", SAI_OBJECT_TYPE_NEIGHBOR_ENTRY, SAI_NEIGHBOR_ENTRY_ATTR_IP_ADDR_FAMILY, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_IPV4_NEIGHBOR_ENTRY },
+    { "ipv6_neighbor", SAI_OBJECT_TYPE_NEIGHBOR_ENTRY, SAI_NEIGHBOR_ENTRY_ATTR_IP_ADDR_FAMILY, SAI_IP_ADDR_FAMILY_IPV6, SAI_SWITCH_ATTR_AVAILABLE_IPV6_NEIGHBOR_ENTRY },
+    { "nexthop_group", SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_NEXT_HOP_GROUP_ENTRY },
+    { "nexthop_group_member", SAI_OBJECT_TYPE_NEXT_HOP_GROUP_MEMBER, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_NEXT_HOP_GROUP_MEMBER_ENTRY },
+    { "fdb_entry", SAI_OBJECT_TYPE_FDB_ENTRY, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_FDB_ENTRY },
+    { "l2mc_entry", SAI_OBJECT_TYPE_L2MC_ENTRY, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_L2MC_ENTRY },
+    { "ipmc_entry", SAI_OBJECT_TYPE_IPMC_ENTRY, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_IPMC_ENTRY },
+    { "my_sid_entry", SAI_OBJECT_TYPE_MY_SID_ENTRY, 0, SAI_IP_ADDR_FAMILY_IPV4, SAI_SWITCH_ATTR_AVAILABLE_MY_SID_ENTRY },
+};
+
+sai_status_t sai_crm_add_default_resources(
+        _Inout_ sai_crm_t *crm)
+{
+    size_t idx;
+
+    for (idx = 0; idx < sizeof(sai_crm_default_resources) / sizeof(sai_crm_default_resources[0]); idx++)
+    {
+        const sai_crm_default_resource_t *def = &sai_crm_default_resources[idx];
+        sai_crm_resource_t resource;
+        sai_attribute_t attr;
+        sai_status_t status;
+        size_t index;
+
+        memset(&resource, 0, sizeof(resource));
+
+        attr.id = def->family_attr_id;
+        attr.value.s32 = def->family;
+
+        resource.name = def->name;
+        resource.object_type = def->object_type;
+        resource.attr_count = def->family_attr_id ? 1 : 0;
+        resource.attr_list = &attr;
+        resource.available_attr_id = def->available_attr_id;
+        resource.threshold_type = SAI_CRM_THRESHOLD_TYPE_PERCENTAGE;
+        resource.high_threshold = SAI_CRM_DEFAULT_HIGH_THRESHOLD;
+        resource.low_threshold = SAI_CRM_DEFAULT_LOW_THRESHOLD;
+
+        status = sai_crm_add_resource(crm, &resource, &index);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void sai_crm_fill_usage(
+        _In_ const sai_crm_entry_t *entry,
+        _Out_ sai_crm_usage_t *usage)
+{
+    usage->name = entry->name;
+    usage->used = entry->used;
+    usage->available = entry->available;
+    usage->drift = entry->drift;
+    usage->synced_at = entry->synced_at;
+    usage->synced = entry->synced;
+    usage->exceeded = entry->exceeded;
+}
+
+/*
+ * Event is dropped when queue can't grow, resource state still changes.
+ */
+
+static void sai_crm_queue_event(
+        _Inout_ sai_crm_t *crm,
+        _In_ size_t index,
+        _In_ sai_crm_event_type_t type)
+{
+    sai_crm_event_t *event;
+
+    if (crm->events_head == crm->events_count)
+    {
+        crm->events_head = 0;
+        crm->events_count = 0;
+    }
+
+    if (crm->events_count == crm->events_size)
+    {
+        size_t size = crm->events_size ? crm->events_size * 2 : SAI_CRM_MAX_RESOURCES;
+        sai_crm_event_t *events = (sai_crm_event_t*)realloc(crm->events, size * sizeof(sai_crm_event_t));
+
+        if (events == NULL)
+        {
+            SAI_META_LOG_ERROR("crm event of %s dropped", crm->entries[index].name);
+            return;
+        }
+
+        crm->events = events;
+        crm->events_size = size;
+    }
+
+    event = &crm->events[crm->events_count++];
+
+    event->index = index;
+    event->type = type;
+
+    sai_crm_fill_usage(&crm->entries[index], &event->usage);
+
+    crm->stats.events++;
+}
+
+/*
+ * Percentage needs capacity, so it is not evaluated until first re-sync.
+ * Crossing marks resource due, so event raised on estimate is confirmed by
+ * vendor on next poll.
+ */
+
+static void sai_crm_check_threshold(
+        _Inout_ sai_crm_t *crm,
+        _In_ size_t index)
+{
+    sai_crm_entry_t *entry = &crm->entries[index];
+    sai_crm_event_type_t type;
+    uint64_t value;
+
+    if (entry->threshold_type == SAI_CRM_THRESHOLD_TYPE_PERCENTAGE)
+    {
+        uint64_t total = entry->used + entry->available;
+
+        if (!entry->synced)
+        {
+            return;
+        }
+
+        value = total ? entry->used * 100 / total : 0;
+    }
+    else
+    {
+        value = entry->used;
+    }
+
+    if (!entry->exceeded && value >= entry->high_threshold)
+    {
+        type = SAI_CRM_EVENT_TYPE_EXCEEDED;
+    }
+    else if (entry->exceeded && value <= entry->low_threshold)
+    {
+        type = SAI_CRM_EVENT_TYPE_CLEARED;
+    }
+    else
+    {
+        return;
+    }
+
+    entry->exceeded = (type == SAI_CRM_EVENT_TYPE_EXCEEDED);
+    entry->due = true;
+
+    sai_crm_queue_event(crm, index, type);
+}
+
+static bool sai_crm_match(
+        _In_ const sai_crm_entry_t *entry,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    if (entry->object_type != meta_key->objecttype)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < entry->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = entry->attr_metadata[idx];
+        const sai_attribute_value_t *value;
+        const sai_attribute_t *attr;
+
+        if (idx == entry->family_index)
+        {
+            sai_ip_addr_family_t family;
+
+            memcpy(&family, (const uint8_t*)&meta_key->objectkey.key + entry->family_offset, sizeof(family));
+
+            if ((int32_t)family != entry->attr_list[idx].value.s32)
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        attr = sai_metadata_get_attr_by_id(md->attrid, attr_count, attr_list);
+
+        if (attr != NULL)
+        {
+            value = &attr->value;
+        }
+        else if (md->defaultvaluetype == SAI_DEFAULT_VALUE_TYPE_CONST)
+        {
+            value = md->defaultvalue;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (sai_metadata_compare_attribute_value(md, value, &entry->attr_list[idx].value) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static size_t sai_crm_memo_hash(
+        _In_ sai_object_id_t object_id)
+{
+    return (size_t)sai_metadata_hash_finalize(sai_metadata_hash_mix(0, object_id));
+}
+
+static sai_crm_memo_t* sai_crm_memo_find(
+        _In_ const sai_crm_t *crm,
+        _In_ sai_object_id_t object_id)
+{
+    size_t mask = crm->memo_size - 1;
+    size_t idx;
+
+    if (crm->memo_size == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = sai_crm_memo_hash(object_id) & mask; crm->memo[idx].object_id != SAI_NULL_OBJECT_ID; idx = (idx + 1) & mask)
+    {
+        if (crm->memo[idx].object_id == object_id)
+        {
+            return &crm->memo[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static void sai_crm_memo_place(
+        _Inout_ sai_crm_memo_t *memo,
+        _In_ size_t size,
+        _In_ const sai_crm_memo_t *item)
+{
+    size_t idx;
+
+    for (idx = sai_crm_memo_hash(item->object_id) & (size - 1); memo[idx].object_id != SAI_NULL_OBJECT_ID; idx = (idx + 1) & (size - 1))
+    {
+    }
+
+    memo[idx] = *item;
+}
+
+static bool sai_crm_memo_insert(
+        _Inout_ sai_crm_t *crm,
+        _In_ sai_object_id_t object_id,
+        _In_ uint64_t resources)
+{
+    sai_crm_memo_t item;
+
+    if (2 * (crm->memo_used + 1) > crm->memo_size)
+    {
+        size_t size = crm->memo_size ? crm->memo_size * 2 : SAI_CRM_MEMO_MIN_SIZE;
+        sai_crm_memo_t *memo;
+        size_t idx;
+
+        memo = (sai_crm_memo_t*)calloc(size, sizeof(sai_crm_memo_t));
+
+        if (memo == NULL)
+        {
+            return false;
+        }
+
+        for (idx = 0; idx < crm->memo_size; idx++)
+        {
+            if (crm->memo[idx].object_id != SAI_NULL_OBJECT_ID)
+            {
+                sai_crm_memo_place(memo, size, &crm->memo[idx]);
+            }
+        }
+
+        free(crm->memo);
+
+        crm->memo = memo;
+        crm->memo_size = size;
+    }
+
+    item.object_id = object_id;
+    item.resources = resources;
+
+    sai_crm_memo_place(crm->memo, crm->memo_size, &item);
+
+    crm->memo_used++;
+
+    return true;
+}
+
+/*
+ * Removes item and shifts following items of its probe run back, so table
+ * never has tombstones.
+ */
+
+static void sai_crm_memo_erase(
+        _Inout_ sai_crm_t *crm,
+        _Inout_ sai_crm_memo_t *item)
+{
+    size_t mask = crm->memo_size - 1;
+    size_t hole = (size_t)(item - crm->memo);
+    size_t idx = hole;
+
+    while (true)
+    {
+        size_t home;
+
+        idx = (idx + 1) & mask;
+
+        if (crm->memo[idx].object_id == SAI_NULL_OBJECT_ID)
+        {
+            break;
+        }
+
+        home = sai_crm_memo_hash(crm->memo[idx].object_id) & mask;
+
+        /* item can move to hole when hole lies between its home and its slot */
+
+        if (((idx - home) & mask) >= ((idx - hole) & mask))
+        {
+            crm->memo[hole] = crm->memo[idx];
+            hole = idx;
+        }
+    }
+
+    crm->memo[hole].object_id = SAI_NULL_OBJECT_ID;
+    crm->memo[hole].resources = 0;
+
+    crm->memo_used--;
+}
+
+sai_status_t sai_crm_object_created(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_object_type_info_t *info;
+    uint64_t resources = 0;
+    size_t idx;
+
+    if (crm == NULL || meta_key == NULL || (attr_count && attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = sai_metadata_get_object_type_info(meta_key->objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    crm->reported = true;
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        if (sai_crm_match(&crm->entries[idx], meta_key, attr_count, attr_list))
+        {
+            resources |= 1ULL << idx;
+        }
+    }
+
+    if (resources & crm->memo_resources)
+    {
+        if (sai_crm_memo_find(crm, meta_key->objectkey.key.object_id) != NULL)
+        {
+            return SAI_STATUS_ITEM_ALREADY_EXISTS;
+        }
+
+        if (!sai_crm_memo_insert(crm, meta_key->objectkey.key.object_id, resources & crm->memo_resources))
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+    }
+
+    crm->stats.created++;
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        sai_crm_entry_t *entry = &crm->entries[idx];
+
+        if (resources & (1ULL << idx))
+        {
+            entry->used++;
+            entry->available -= entry->available ? 1 : 0;
+
+            sai_crm_check_threshold(crm, idx);
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_crm_object_removed(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    const sai_object_type_info_t *info;
+    uint64_t resources = 0;
+    size_t idx;
+
+    if (crm == NULL || meta_key == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = sai_metadata_get_object_type_info(meta_key->objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    crm->reported = true;
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        if (!(crm->memo_resources & (1ULL << idx)) && sai_crm_match(&crm->entries[idx], meta_key, 0, NULL))
+        {
+            resources |= 1ULL << idx;
+        }
+    }
+
+    if (info->isobjectid)
+    {
+        sai_crm_memo_t *memo = sai_crm_memo_find(crm, meta_key->objectkey.key.object_id);
+
+        if (memo != NULL)
+        {
+            resources |= memo->resources;
+
+            sai_crm_memo_erase(crm, memo);
+        }
+    }
+
+    crm->stats.removed++;
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        sai_crm_entry_t *entry = &crm->entries[idx];
+
+        if (resources & (1ULL << idx))
+        {
+            entry->used -= entry->used ? 1 : 0;
+            entry->available++;
+
+            sai_crm_check_threshold(crm, idx);
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_crm_query_vendor(
+        _In_ const sai_crm_t *crm,
+        _In_ const sai_crm_entry_t *entry,
+        _Out_ uint64_t *count)
+{
+    sai_status_t status = SAI_STATUS_NOT_SUPPORTED;
+    const sai_attr_metadata_t *md;
+    sai_attribute_t attr;
+
+    if (crm->config.object_type_get_availability != NULL)
+    {
+        status = crm->config.object_type_get_availability(crm->config.switch_id,
+                entry->object_type, entry->attr_count, entry->attr_list, count);
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    if (entry->available_attr_id == 0 || crm->config.get_switch_attribute == NULL)
+    {
+        return status;
+    }
+
+    md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_SWITCH, entry->available_attr_id);
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.id = entry->available_attr_id;
+
+    status = crm->config.get_switch_attribute(crm->config.switch_id, 1, &attr);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        *count = md->attrvaluetype == SAI_ATTR_VALUE_TYPE_UINT64 ? attr.value.u64 : attr.value.u32;
+    }
+
+    return status;
+}
+
+sai_status_t sai_crm_sync_resource(
+        _Inout_ sai_crm_t *crm,
+        _In_ size_t index,
+        _In_ uint64_t now)
+{
+    sai_crm_entry_t *entry;
+    sai_status_t status;
+    uint64_t count = 0;
+
+    if (crm == NULL || index >= crm->count)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    entry = &crm->entries[index];
+
+    entry->polled = true;
+    entry->polled_at = now;
+    entry->due = false;
+
+    status = sai_crm_query_vendor(crm, entry, &count);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        crm->stats.sync_failures++;
+
+        return status;
+    }
+
+    entry->drift = entry->synced ? (int64_t)(entry->available - count) : 0;
+    entry->available = count;
+    entry->synced = true;
+    entry->synced_at = now;
+
+    crm->stats.syncs++;
+
+    sai_crm_check_threshold(crm, index);
+
+    /* re-sync itself never makes resource due again */
+
+    entry->due = false;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+uint32_t sai_crm_poll(
+        _Inout_ sai_crm_t *crm,
+        _In_ uint64_t now)
+{
+    uint32_t synced = 0;
+    size_t idx;
+
+    if (crm == NULL)
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < crm->count; idx++)
+    {
+        const sai_crm_entry_t *entry = &crm->entries[idx];
+
+        if (entry->polled && !entry->due && now - entry->polled_at < crm->config.sync_interval)
+        {
+            continue;
+        }
+
+        if (sai_crm_sync_resource(crm, idx, now) == SAI_STATUS_SUCCESS)
+        {
+            synced++;
+        }
+    }
+
+    return synced;
+}
+
+bool sai_crm_pop_event(
+        _Inout_ sai_crm_t *crm,
+        _Out_ sai_crm_event_t *event)
+{
+    if (crm == NULL || event == NULL || crm->events_head == crm->events_count)
+    {
+        return false;
+    }
+
+    *event = crm->events[crm->events_head++];
+
+    return true;
+}
+
+size_t sai_crm_get_resource_count(
+        _In_ const sai_crm_t *crm)
+{
+    return crm == NULL ? 0 : crm->count;
+}
+
+sai_status_t sai_crm_get_usage(
+        _In_ const sai_crm_t *crm,
+        _In_ size_t index,
+        _Out_ sai_crm_usage_t *usage)
+{
+    if (crm == NULL || usage == NULL || index >= crm->count)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    sai_crm_fill_usage(&crm->entries[index], usage);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_crm_get_stats(
+        _In_ const sai_crm_t *crm,
+        _Out_ sai_crm_stats_t *stats)
+{
+    if (crm == NULL || stats == NULL)
+    {
+        return;
+    }
+
+    *stats = crm->stats;
+}
@@ -0,0 +1,446 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicrm.h
+ *
+ * @brief   This module defines SAI CRM resource accounting
+ */
+
+#ifndef __SAICRM_H_
+#define __SAICRM_H_
+
+/**
+ * @defgroup SAICRM SAI - CRM resource accounting
+ *
+ * Accounting keeps used and available count of resources of single switch
+ * without querying vendor on every change. Resource is object type with
+ * optional list of resource type attributes (@isresourcetype), the same
+ * granular query as sai_object_type_get_availability takes, see
+ * doc/SAI-CRM-Workflow.md. Caller reports every created and removed object,
+ * object is counted by each resource it matches: resource attribute matches
+ * when created object has it with equal value, or has not it and attribute
+ * default value is equal. Read only IP address family attributes of route
+ * and neighbor entries are matched against address family of object key.
+ *
+ * Create increments used and decrements available count of matched
+ * resources, remove does the opposite, so threshold events are raised as
+ * soon as table fills up. Available count is re-synced with vendor by
+ * sai_crm_poll, by sai_object_type_get_availability or, when it fails, by
+ * legacy SAI_SWITCH_ATTR_AVAILABLE_* attribute. Re-sync also corrects
+ * resources which share hardware table with other resources. Resource whose
+ * estimate crossed threshold is re-synced on next poll regardless of
+ * interval.
+ *
+ * Created object with attribute matched resources is remembered by object
+ * id until it is removed, so matching attributes of non object id types
+ * must be derived from object key. Functions of accounting must be called
+ * from single thread.
+ *
+ * @{
+ */
+
+/**
+ * @brief Maximum number of resources
+ */
+#define SAI_CRM_MAX_RESOURCES 64
+
+/**
+ * @brief Threshold type
+ */
+typedef enum _sai_crm_threshold_type_t
+{
+    /**
+     * @brief Used count in percent of used plus available count
+     */
+    SAI_CRM_THRESHOLD_TYPE_PERCENTAGE,
+
+    /**
+     * @brief Used count
+     */
+    SAI_CRM_THRESHOLD_TYPE_USED,
+
+} sai_crm_threshold_type_t;
+
+/**
+ * @brief Threshold event type
+ */
+typedef enum _sai_crm_event_type_t
+{
+    /**
+     * @brief Usage reached high threshold
+     */
+    SAI_CRM_EVENT_TYPE_EXCEEDED,
+
+    /**
+     * @brief Usage dropped to low threshold after it was exceeded
+     */
+    SAI_CRM_EVENT_TYPE_CLEARED,
+
+} sai_crm_event_type_t;
+
+/**
+ * @brief Resource definition
+ */
+typedef struct _sai_crm_resource_t
+{
+    /**
+     * @brief Resource name, copied
+     */
+    const char *name;
+
+    /**
+     * @brief Object type
+     */
+    sai_object_type_t object_type;
+
+    /**
+     * @brief Number of resource type attributes
+     */
+    uint32_t attr_count;
+
+    /**
+     * @brief Resource type attributes, copied
+     */
+    const sai_attribute_t *attr_list;
+
+    /**
+     * @brief Legacy SAI_SWITCH_ATTR_AVAILABLE_* attribute, 0 for none
+     */
+    sai_attr_id_t available_attr_id;
+
+    /**
+     * @brief Threshold type
+     */
+    sai_crm_threshold_type_t threshold_type;
+
+    /**
+     * @brief Usage at which exceeded event is raised
+     */
+    uint64_t high_threshold;
+
+    /**
+     * @brief Usage at which cleared event is raised
+     */
+    uint64_t low_threshold;
+
+} sai_crm_resource_t;
+
+/**
+ * @brief Resource usage
+ */
+typedef struct _sai_crm_usage_t
+{
+    /**
+     * @brief Resource name
+     */
+    const char *name;
+
+    /**
+     * @brief Number of created objects counted by resource
+     */
+    uint64_t used;
+
+    /**
+     * @brief Estimated number of objects which can be created
+     */
+    uint64_t available;
+
+    /**
+     * @brief Estimated minus vendor available count at last re-sync
+     */
+    int64_t drift;
+
+    /**
+     * @brief Time of last successful re-sync in nanoseconds
+     */
+    uint64_t synced_at;
+
+    /**
+     * @brief Available count was synced with vendor at least once
+     */
+    bool synced;
+
+    /**
+     * @brief High threshold was reached and usage was not cleared since
+     */
+    bool exceeded;
+
+} sai_crm_usage_t;
+
+/**
+ * @brief Threshold event
+ */
+typedef struct _sai_crm_event_t
+{
+    /**
+     * @brief Resource index
+     */
+    size_t index;
+
+    /**
+     * @brief Event type
+     */
+    sai_crm_event_type_t type;
+
+    /**
+     * @brief Usage when event was raised
+     */
+    sai_crm_usage_t usage;
+
+} sai_crm_event_t;
+
+/**
+ * @brief Accounting configuration
+ */
+typedef struct _sai_crm_config_t
+{
+    /**
+     * @brief Switch id
+     */
+    sai_object_id_t switch_id;
+
+    /**
+     * @brief Vendor sai_object_type_get_availability, NULL when not supported
+     */
+    sai_status_t (*object_type_get_availability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count);
+
+    /**
+     * @brief Vendor get switch attribute, NULL when not supported
+     */
+    sai_status_t (*get_switch_attribute)(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list);
+
+    /**
+     * @brief Re-sync interval in nanoseconds
+     */
+    uint64_t sync_interval;
+
+} sai_crm_config_t;
+
+/**
+ * @brief Accounting statistics
+ */
+typedef struct _sai_crm_stats_t
+{
+    /**
+     * @brief Number of reported created objects
+     */
+    uint64_t created;
+
+    /**
+     * @brief Number of reported removed objects
+     */
+    uint64_t removed;
+
+    /**
+     * @brief Number of successful re-syncs
+     */
+    uint64_t syncs;
+
+    /**
+     * @brief Number of re-syncs where vendor failed
+     */
+    uint64_t sync_failures;
+
+    /**
+     * @brief Number of threshold events queued
+     */
+    uint64_t events;
+
+} sai_crm_stats_t;
+
+/**
+ * @brief Opaque accounting
+ */
+typedef struct _sai_crm_t sai_crm_t;
+
+/**
+ * @brief Create accounting without resources
+ *
+ * @param[in] config Configuration
+ *
+ * @return Accounting or NULL on error
+ */
+extern sai_crm_t* sai_crm_open(
+        _In_ const sai_crm_config_t *config);
+
+/**
+ * @brief Destroy accounting
+ *
+ * @param[inout] crm Accounting
+ */
+extern void sai_crm_close(
+        _Inout_ sai_crm_t *crm);
+
+/**
+ * @brief Add resource
+ *
+ * Resources must be added before first object is reported.
+ *
+ * @param[inout] crm Accounting
+ * @param[in] resource Resource definition
+ * @param[out] index Resource index
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER when
+ * attribute is not resource type attribute or available attribute is not
+ * read only counter of switch, #SAI_STATUS_NOT_SUPPORTED when attribute of
+ * non object id type can't be derived from object key,
+ * #SAI_STATUS_INSUFFICIENT_RESOURCES when SAI_CRM_MAX_RESOURCES resources
+ * were added or objects were already reported, failure status code on error
+ */
+extern sai_status_t sai_crm_add_resource(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_crm_resource_t *resource,
+        _Out_ size_t *index);
+
+/**
+ * @brief Add resources with legacy SAI_SWITCH_ATTR_AVAILABLE_* attribute
+ *
+ * Adds IPv4 and IPv6 routes and neighbors, next hop groups and their
+ * members, FDB, L2MC, IPMC and my SID entries, with percentage threshold
+ * 85 high and 70 low.
+ *
+ * @param[inout] crm Accounting
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_crm_add_default_resources(
+        _Inout_ sai_crm_t *crm);
+
+/**
+ * @brief Account created object
+ *
+ * @param[inout] crm Accounting
+ * @param[in] meta_key Object key
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attribute list object was created with
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_ALREADY_EXISTS
+ * when object id matched by attributes was reported already, failure status
+ * code on error
+ */
+extern sai_status_t sai_crm_object_created(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list);
+
+/**
+ * @brief Account removed object
+ *
+ * @param[inout] crm Accounting
+ * @param[in] meta_key Object key
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_crm_object_removed(
+        _Inout_ sai_crm_t *crm,
+        _In_ const sai_object_meta_key_t *meta_key);
+
+/**
+ * @brief Re-sync resources which are due
+ *
+ * Resource is due when it was never synced, when sync interval elapsed
+ * since its last re-sync or when its estimate crossed threshold.
+ *
+ * @param[inout] crm Accounting
+ * @param[in] now Current time in nanoseconds
+ *
+ * @return Number of resources re-synced
+ */
+extern uint32_t sai_crm_poll(
+        _Inout_ sai_crm_t *crm,
+        _In_ uint64_t now);
+
+/**
+ * @brief Re-sync resource now
+ *
+ * @param[inout] crm Accounting
+ * @param[in] index Resource index
+ * @param[in] now Current time in nanoseconds
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code of vendor on
+ * error
+ */
+extern sai_status_t sai_crm_sync_resource(
+        _Inout_ sai_crm_t *crm,
+        _In_ size_t index,
+        _In_ uint64_t now);
+
+/**
+ * @brief Take oldest threshold event
+ *
+ * Events are queued when usage crosses threshold, on create, remove or
+ * re-sync.
+ *
+ * @param[inout] crm Accounting
+ * @param[out] event Event
+ *
+ * @return True when event was taken, false when queue is empty
+ */
+extern bool sai_crm_pop_event(
+        _Inout_ sai_crm_t *crm,
+        _Out_ sai_crm_event_t *event);
+
+/**
+ * @brief Get number of resources
+ *
+ * @param[in] crm Accounting
+ *
+ * @return Number of resources
+ */
+extern size_t sai_crm_get_resource_count(
+        _In_ const sai_crm_t *crm);
+
+/**
+ * @brief Get resource usage
+ *
+ * @param[in] crm Accounting
+ * @param[in] index Resource index
+ * @param[out] usage Usage, name is valid until accounting is closed
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER for
+ * unknown index
+ */
+extern sai_status_t sai_crm_get_usage(
+        _In_ const sai_crm_t *crm,
+        _In_ size_t index,
+        _Out_ sai_crm_usage_t *usage);
+
+/**
+ * @brief Get accounting statistics
+ *
+ * @param[in] crm Accounting
+ * @param[out] stats Statistics
+ */
+extern void sai_crm_get_stats(
+        _In_ const sai_crm_t *crm,
+        _Out_ sai_crm_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAICRM_H_ */
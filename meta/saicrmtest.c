@@ -0,0 +1,457 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saicrmtest.c
+ *
+ * @brief   This module implements SAI CRM resource accounting test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saicrm.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_SWITCH_ID 0x21000000000000ULL
+
+#define TEST_INTERVAL 1000
+
+/*
+ * Vendor tables. Availability is answered for next hop groups only, other
+ * resources use legacy switch attributes.
+ */
+
+static uint64_t test_route_available[2] = { 1000, 100 };
+
+static uint64_t test_group_available = 50;
+
+static bool test_vendor_fails = false;
+
+static uint32_t test_events[2];
+
+static sai_status_t test_get_availability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count)
+{
+    if (object_type != SAI_OBJECT_TYPE_NEXT_HOP_GROUP || test_vendor_fails)
+    {
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    *count = test_group_available;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_get_switch_attribute(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    if (test_vendor_fails)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    switch (attr_list[0].id)
+    {
+        case SAI_SWITCH_ATTR_AVAILABLE_IPV4_ROUTE_ENTRY:
+            attr_list[0].value.u32 = (uint32_t)test_route_available[0];
+            return SAI_STATUS_SUCCESS;
+
+        case SAI_SWITCH_ATTR_AVAILABLE_IPV6_ROUTE_ENTRY:
+            attr_list[0].value.u32 = (uint32_t)test_route_available[1];
+            return SAI_STATUS_SUCCESS;
+
+        case SAI_SWITCH_ATTR_AVAILABLE_NEXT_HOP_GROUP_ENTRY:
+            attr_list[0].value.u32 = (uint32_t)test_group_available;
+            return SAI_STATUS_SUCCESS;
+
+        default:
+            return SAI_STATUS_NOT_SUPPORTED;
+    }
+}
+
+static void test_take_events(
+        _Inout_ sai_crm_t *crm)
+{
+    sai_crm_event_t event;
+
+    while (sai_crm_pop_event(crm, &event))
+    {
+        ASSERT_TRUE(event.usage.name != NULL, "event usage");
+
+        test_events[event.type]++;
+    }
+}
+
+static sai_crm_t* test_open(void)
+{
+    sai_crm_config_t config;
+
+    memset(&config, 0, sizeof(config));
+
+    config.switch_id = TEST_SWITCH_ID;
+    config.object_type_get_availability = test_get_availability;
+    config.get_switch_attribute = test_get_switch_attribute;
+    config.sync_interval = TEST_INTERVAL;
+
+    test_events[SAI_CRM_EVENT_TYPE_EXCEEDED] = 0;
+    test_events[SAI_CRM_EVENT_TYPE_CLEARED] = 0;
+    test_vendor_fails = false;
+
+    return sai_crm_open(&config);
+}
+
+static size_t test_find(
+        _In_ const sai_crm_t *crm,
+        _In_ const char *name)
+{
+    sai_crm_usage_t usage;
+    size_t idx;
+
+    for (idx = 0; idx < sai_crm_get_resource_count(crm); idx++)
+    {
+        sai_crm_get_usage(crm, idx, &usage);
+
+        if (strcmp(usage.name, name) == 0)
+        {
+            return idx;
+        }
+    }
+
+    ASSERT_TRUE(false, "resource %s not found", name);
+
+    return 0;
+}
+
+static void test_route_key(
+        _Out_ sai_object_meta_key_t *meta_key,
+        _In_ bool ipv6,
+        _In_ uint32_t index)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+    meta_key->objectkey.key.route_entry.switch_id = TEST_SWITCH_ID;
+    meta_key->objectkey.key.route_entry.destination.addr_family = ipv6 ? SAI_IP_ADDR_FAMILY_IPV6 : SAI_IP_ADDR_FAMILY_IPV4;
+    meta_key->objectkey.key.route_entry.destination.addr.ip4 = index;
+}
+
+static void test_oid_key(
+        _Out_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = object_type;
+    meta_key->objectkey.key.object_id = object_id;
+}
+
+static void test_expect(
+        _In_ const sai_crm_t *crm,
+        _In_ size_t index,
+        _In_ uint64_t used,
+        _In_ uint64_t available)
+{
+    sai_crm_usage_t usage;
+
+    ASSERT_TRUE(sai_crm_get_usage(crm, index, &usage) == SAI_STATUS_SUCCESS, "usage");
+    ASSERT_TRUE(usage.used == used, "%s used %lu, expected %lu", usage.name, (unsigned long)usage.used, (unsigned long)used);
+    ASSERT_TRUE(usage.available == available, "%s available %lu, expected %lu", usage.name, (unsigned long)usage.available, (unsigned long)available);
+}
+
+static void test_routes(void)
+{
+    sai_object_meta_key_t meta_key;
+    sai_crm_usage_t usage;
+    sai_crm_stats_t stats;
+    sai_crm_t *crm = test_open();
+    size_t ipv4;
+    size_t ipv6;
+    uint32_t idx;
+
+    ASSERT_TRUE(crm != NULL, "open");
+    ASSERT_TRUE(sai_crm_add_default_resources(crm) == SAI_STATUS_SUCCESS, "default resources");
+
+    ipv4 = test_find(crm, "ipv4_route");
+    ipv6 = test_find(crm, "ipv6_route");
+
+    /* resources without vendor answer stay unsynced */
+
+    ASSERT_TRUE(sai_crm_poll(crm, 0) == 3, "first poll syncs routes and groups");
+
+    test_expect(crm, ipv4, 0, 1000);
+    test_expect(crm, ipv6, 0, 100);
+
+    for (idx = 0; idx < 30; idx++)
+    {
+        test_route_key(&meta_key, idx % 3 == 0, idx);
+
+        ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 0, NULL) == SAI_STATUS_SUCCESS, "create route %u", idx);
+    }
+
+    test_expect(crm, ipv4, 20, 980);
+    test_expect(crm, ipv6, 10, 90);
+
+    test_route_key(&meta_key, true, 0);
+
+    ASSERT_TRUE(sai_crm_object_removed(crm, &meta_key) == SAI_STATUS_SUCCESS, "remove route");
+
+    test_expect(crm, ipv6, 9, 91);
+
+    ASSERT_TRUE(sai_crm_poll(crm, TEST_INTERVAL / 2) == 0, "nothing due");
+
+    /* vendor counts routes installed by other component too */
+
+    test_route_available[0] = 970;
+
+    ASSERT_TRUE(sai_crm_poll(crm, TEST_INTERVAL) == 3, "interval elapsed");
+
+    sai_crm_get_usage(crm, ipv4, &usage);
+
+    ASSERT_TRUE(usage.available == 970 && usage.drift == 10, "drift %ld", (long)usage.drift);
+
+    sai_crm_get_stats(crm, &stats);
+
+    ASSERT_TRUE(stats.created == 30 && stats.removed == 1 && stats.syncs == 6, "stats %lu", (unsigned long)stats.syncs);
+
+    ASSERT_TRUE(sai_crm_sync_resource(crm, test_find(crm, "fdb_entry"), 0) == SAI_STATUS_NOT_SUPPORTED, "fdb not supported");
+
+    test_route_available[0] = 1000;
+
+    sai_crm_close(crm);
+}
+
+static void test_attributes(void)
+{
+    sai_object_meta_key_t meta_key;
+    sai_crm_resource_t resource;
+    sai_attribute_t attrs[2];
+    sai_crm_t *crm = test_open();
+    size_t hierarchical;
+    size_t groups;
+
+    memset(&resource, 0, sizeof(resource));
+
+    resource.name = "nexthop_group";
+    resource.object_type = SAI_OBJECT_TYPE_NEXT_HOP_GROUP;
+    resource.available_attr_id = SAI_SWITCH_ATTR_AVAILABLE_NEXT_HOP_GROUP_ENTRY;
+    resource.threshold_type = SAI_CRM_THRESHOLD_TYPE_PERCENTAGE;
+    resource.high_threshold = 100;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &groups) == SAI_STATUS_SUCCESS, "add groups");
+
+    attrs[0].id = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    attrs[0].value.s32 = SAI_NEXT_HOP_GROUP_TYPE_DYNAMIC_UNORDERED_ECMP;
+    attrs[1].id = SAI_NEXT_HOP_GROUP_ATTR_HIERARCHICAL_NEXTHOP;
+    attrs[1].value.booldata = true;
+
+    resource.name = "overlay_nexthop_group";
+    resource.attr_count = 2;
+    resource.attr_list = attrs;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &hierarchical) == SAI_STATUS_SUCCESS, "add overlay groups");
+
+    /* resource must use resource type attributes of switch counters */
+
+    attrs[1].id = SAI_NEXT_HOP_GROUP_ATTR_SET_SWITCHOVER;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &groups) == SAI_STATUS_INVALID_PARAMETER, "not resource type");
+
+    attrs[1].id = SAI_NEXT_HOP_GROUP_ATTR_HIERARCHICAL_NEXTHOP;
+    resource.available_attr_id = SAI_SWITCH_ATTR_SRC_MAC_ADDRESS;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &groups) == SAI_STATUS_INVALID_PARAMETER, "not counter");
+
+    ASSERT_TRUE(sai_crm_poll(crm, 0) == 2, "sync");
+
+    test_expect(crm, hierarchical, 0, 50);
+
+    /* hierarchical next hop defaults to true */
+
+    test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x1001);
+
+    ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 1, attrs) == SAI_STATUS_SUCCESS, "create default");
+    ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 1, attrs) == SAI_STATUS_ITEM_ALREADY_EXISTS, "create twice");
+
+    attrs[1].value.booldata = false;
+
+    test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x1002);
+
+    ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 2, attrs) == SAI_STATUS_SUCCESS, "create underlay");
+
+    attrs[0].value.s32 = SAI_NEXT_HOP_GROUP_TYPE_DYNAMIC_ORDERED_ECMP;
+
+    test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x1003);
+
+    ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 1, attrs) == SAI_STATUS_SUCCESS, "create ordered");
+
+    test_expect(crm, groups, 3, 47);
+    test_expect(crm, hierarchical, 1, 49);
+
+    /* remove recalls resources matched on create */
+
+    test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x1001);
+
+    ASSERT_TRUE(sai_crm_object_removed(crm, &meta_key) == SAI_STATUS_SUCCESS, "remove");
+
+    test_expect(crm, groups, 2, 48);
+    test_expect(crm, hierarchical, 0, 50);
+
+    test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x1002);
+
+    ASSERT_TRUE(sai_crm_object_removed(crm, &meta_key) == SAI_STATUS_SUCCESS, "remove");
+
+    test_expect(crm, groups, 1, 49);
+    test_expect(crm, hierarchical, 0, 50);
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &groups) == SAI_STATUS_INSUFFICIENT_RESOURCES, "add after report");
+
+    sai_crm_close(crm);
+}
+
+static void test_thresholds(void)
+{
+    sai_object_meta_key_t meta_key;
+    sai_crm_resource_t resource;
+    sai_crm_usage_t usage;
+    sai_crm_t *crm = test_open();
+    size_t percent;
+    size_t used;
+    uint32_t idx;
+
+    memset(&resource, 0, sizeof(resource));
+
+    resource.name = "used";
+    resource.object_type = SAI_OBJECT_TYPE_NEXT_HOP_GROUP;
+    resource.threshold_type = SAI_CRM_THRESHOLD_TYPE_USED;
+    resource.high_threshold = 3;
+    resource.low_threshold = 1;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &used) == SAI_STATUS_SUCCESS, "add used");
+
+    resource.name = "percent";
+    resource.threshold_type = SAI_CRM_THRESHOLD_TYPE_PERCENTAGE;
+    resource.high_threshold = 80;
+    resource.low_threshold = 50;
+
+    ASSERT_TRUE(sai_crm_add_resource(crm, &resource, &percent) == SAI_STATUS_SUCCESS, "add percent");
+
+    test_group_available = 10;
+
+    for (idx = 0; idx < 4; idx++)
+    {
+        test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x2000 + idx);
+
+        ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 0, NULL) == SAI_STATUS_SUCCESS, "create");
+    }
+
+    /* used count crossed, percentage waits for capacity */
+
+    test_take_events(crm);
+
+    ASSERT_TRUE(test_events[SAI_CRM_EVENT_TYPE_EXCEEDED] == 1, "used exceeded once");
+
+    sai_crm_get_usage(crm, percent, &usage);
+
+    ASSERT_TRUE(!usage.synced && !usage.exceeded, "percent unsynced");
+
+    /* vendor has 10 free, 4 used of 14 is 28 percent */
+
+    ASSERT_TRUE(sai_crm_poll(crm, 0) == 2, "sync");
+
+    test_take_events(crm);
+
+    ASSERT_TRUE(test_events[SAI_CRM_EVENT_TYPE_EXCEEDED] == 1, "below percentage");
+
+    for (idx = 4; idx < 12; idx++)
+    {
+        test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x2000 + idx);
+
+        ASSERT_TRUE(sai_crm_object_created(crm, &meta_key, 0, NULL) == SAI_STATUS_SUCCESS, "create");
+    }
+
+    /* 12 used of 14 is 85 percent, raised on estimate before next poll */
+
+    test_take_events(crm);
+
+    ASSERT_TRUE(test_events[SAI_CRM_EVENT_TYPE_EXCEEDED] == 2, "percent exceeded");
+
+    test_expect(crm, percent, 12, 2);
+
+    /* crossing makes resource due before interval */
+
+    test_group_available = 2;
+
+    ASSERT_TRUE(sai_crm_poll(crm, 1) == 1, "due resource synced");
+    ASSERT_TRUE(sai_crm_poll(crm, 2) == 0, "nothing due");
+
+    for (idx = 0; idx < 11; idx++)
+    {
+        test_oid_key(&meta_key, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, 0x2000 + idx);
+
+        ASSERT_TRUE(sai_crm_object_removed(crm, &meta_key) == SAI_STATUS_SUCCESS, "remove");
+    }
+
+    test_take_events(crm);
+
+    ASSERT_TRUE(test_events[SAI_CRM_EVENT_TYPE_CLEARED] == 2, "both cleared");
+
+    test_expect(crm, used, 1, 13);
+    test_expect(crm, percent, 1, 13);
+
+    /* vendor failure keeps estimate */
+
+    test_vendor_fails = true;
+
+    ASSERT_TRUE(sai_crm_poll(crm, TEST_INTERVAL * 2) == 0, "failed sync");
+
+    test_expect(crm, percent, 1, 13);
+
+    test_group_available = 50;
+
+    sai_crm_close(crm);
+}
+
+int main()
+{
+    test_routes();
+
+    test_attributes();
+
+    test_thresholds();
+
+    return 0;
+}
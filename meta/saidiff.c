@@ -0,0 +1,525 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saidiff.c
+ *
+ * @brief   This module implements SAI attribute list diff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saidiff.h"
+
+/*
+ * Number of entries taken by worker at once.
+ */
+
+#define SAI_DIFF_BULK_CHUNK 64
+
+/*
+ * Attributes of current and desired list by field index of object struct.
+ * Only slots of processed lists are used, they are cleared after each
+ * entry, so scratch is reused without clearing all of it.
+ */
+
+typedef struct _sai_diff_scratch_t
+{
+    const sai_attribute_t **current;
+
+    const sai_attribute_t **desired;
+
+    size_t size;
+
+} sai_diff_scratch_t;
+
+typedef struct _sai_diff_bulk_t
+{
+    uint32_t count;
+
+    sai_diff_entry_t *entries;
+
+    uint32_t next;
+
+    uint32_t failures;
+
+} sai_diff_bulk_t;
+
+static const sai_attribute_value_t sai_diff_empty_value;
+
+static bool sai_diff_scratch_reserve(
+        _Inout_ sai_diff_scratch_t *scratch,
+        _In_ size_t size)
+{
+    const sai_attribute_t **current;
+    const sai_attribute_t **desired;
+
+    if (size <= scratch->size)
+    {
+        return true;
+    }
+
+    current = calloc(size, sizeof(sai_attribute_t*));
+    desired = calloc(size, sizeof(sai_attribute_t*));
+
+    if (current == NULL || desired == NULL)
+    {
+        free(current);
+        free(desired);
+
+        return false;
+    }
+
+    free(scratch->current);
+    free(scratch->desired);
+
+    scratch->current = current;
+    scratch->desired = desired;
+    scratch->size = size;
+
+    return true;
+}
+
+static void sai_diff_scratch_free(
+        _Inout_ sai_diff_scratch_t *scratch)
+{
+    free(scratch->current);
+    free(scratch->desired);
+
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+static void sai_diff_scratch_clear(
+        _In_ const sai_object_struct_info_t *info,
+        _Inout_ sai_diff_scratch_t *scratch,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        int field = info->fieldindex(attr_list[idx].id);
+
+        if (field >= 0)
+        {
+            scratch->current[field] = NULL;
+            scratch->desired[field] = NULL;
+        }
+    }
+}
+
+/*
+ * Puts attributes of list into slots, on error slots of attributes before
+ * the wrong one are already set.
+ */
+
+static sai_status_t sai_diff_index_list(
+        _In_ const sai_object_struct_info_t *info,
+        _Inout_ const sai_attribute_t **slots,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ bool desired)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        int field = info->fieldindex(attr_list[idx].id);
+
+        if (field < 0)
+        {
+            return SAI_STATUS_UNKNOWN_ATTRIBUTE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+
+        if (slots[field] != NULL)
+        {
+            return SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+
+        if (desired && SAI_HAS_FLAG_READ_ONLY(info->fields[field].attrmetadata->flags))
+        {
+            return SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+
+        slots[field] = &attr_list[idx];
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Returns value of attribute which is not on the list, NULL when it is not
+ * known.
+ */
+
+static const sai_attribute_value_t* sai_diff_get_default_value(
+        _In_ const sai_attr_metadata_t *md)
+{
+    switch (md->defaultvaluetype)
+    {
+        case SAI_DEFAULT_VALUE_TYPE_CONST:
+            return md->defaultvalue;
+
+        case SAI_DEFAULT_VALUE_TYPE_EMPTY_LIST:
+            return &sai_diff_empty_value;
+
+        default:
+            return NULL;
+    }
+}
+
+static bool sai_diff_is_prerequisite(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ sai_attr_id_t attr_id)
+{
+    size_t idx;
+
+    for (idx = 0; idx < md->conditionslength; idx++)
+    {
+        if (md->conditions[idx]->attrid == attr_id)
+        {
+            return true;
+        }
+    }
+
+    for (idx = 0; idx < md->validonlylength; idx++)
+    {
+        if (md->validonly[idx]->attrid == attr_id)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int sai_diff_compare_attr_id(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    const sai_attribute_t *first = (const sai_attribute_t*)a;
+    const sai_attribute_t *second = (const sai_attribute_t*)b;
+
+    return (first->id > second->id) - (first->id < second->id);
+}
+
+/*
+ * Orders set operations by attribute id and moves attributes which other
+ * set attributes depend on to the front, keeping their order.
+ */
+
+static void sai_diff_order(
+        _In_ const sai_object_struct_info_t *info,
+        _Inout_ sai_diff_entry_t *entry)
+{
+    uint32_t front = 0;
+    uint32_t idx;
+    uint32_t other;
+
+    qsort(entry->set_list, entry->set_count, sizeof(sai_attribute_t), sai_diff_compare_attr_id);
+
+    for (idx = 0; idx < entry->set_count; idx++)
+    {
+        sai_attribute_t attr = entry->set_list[idx];
+
+        for (other = 0; other < entry->set_count; other++)
+        {
+            const sai_attr_metadata_t *md = info->fields[info->fieldindex(entry->set_list[other].id)].attrmetadata;
+
+            if (other != idx && sai_diff_is_prerequisite(md, attr.id))
+            {
+                break;
+            }
+        }
+
+        if (other == entry->set_count)
+        {
+            continue;
+        }
+
+        memmove(&entry->set_list[front + 1], &entry->set_list[front], (idx - front) * sizeof(sai_attribute_t));
+
+        entry->set_list[front++] = attr;
+    }
+}
+
+/*
+ * Decides attribute present in at least one of lists, returns false when
+ * object must be recreated.
+ */
+
+static bool sai_diff_attr(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_t *current,
+        _In_ const sai_attribute_t *desired,
+        _Inout_ sai_diff_entry_t *entry)
+{
+    const sai_attribute_value_t *current_value;
+    const sai_attribute_value_t *desired_value;
+
+    if (SAI_HAS_FLAG_READ_ONLY(md->flags))
+    {
+        return true;
+    }
+
+    if (desired == NULL)
+    {
+        if (md->isconditional && !sai_metadata_is_condition_met(md, entry->desired_count, entry->desired_list))
+        {
+            return true;
+        }
+
+        if (md->isvalidonly && !sai_metadata_is_validonly_met(md, entry->desired_count, entry->desired_list))
+        {
+            return true;
+        }
+    }
+
+    current_value = (current != NULL) ? &current->value : sai_diff_get_default_value(md);
+    desired_value = (desired != NULL) ? &desired->value : sai_diff_get_default_value(md);
+
+    if (desired_value == NULL)
+    {
+        return false;
+    }
+
+    if (current_value != NULL && sai_metadata_compare_attribute_value(md, current_value, desired_value) == 0)
+    {
+        return true;
+    }
+
+    if (!SAI_HAS_FLAG_CREATE_AND_SET(md->flags))
+    {
+        return false;
+    }
+
+    entry->set_list[entry->set_count].id = md->attrid;
+    entry->set_list[entry->set_count].value = *desired_value;
+    entry->set_count++;
+
+    return true;
+}
+
+static sai_status_t sai_diff_entry(
+        _Inout_ sai_diff_entry_t *entry,
+        _Inout_ sai_diff_scratch_t *scratch)
+{
+    const sai_object_type_info_t *oi = sai_metadata_get_object_type_info(entry->object_type);
+    const sai_object_struct_info_t *info;
+    const sai_attribute_t *attr;
+    const sai_attr_metadata_t *md;
+    sai_status_t status;
+    uint32_t idx;
+    int field;
+
+    entry->set_count = 0;
+    entry->verdict = SAI_DIFF_VERDICT_EQUAL;
+    entry->recreate_attr_id = 0;
+
+    if (oi == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if ((entry->current_count && entry->current_list == NULL) ||
+            (entry->desired_count && entry->desired_list == NULL) ||
+            (entry->current_count + entry->desired_count && entry->set_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = oi->structinfo;
+
+    if (info == NULL)
+    {
+        /* object type without attributes */
+
+        return (entry->current_count || entry->desired_count) ? SAI_STATUS_UNKNOWN_ATTRIBUTE_0 : SAI_STATUS_SUCCESS;
+    }
+
+    if (!sai_diff_scratch_reserve(scratch, info->fieldscount))
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    status = sai_diff_index_list(info, scratch->current, entry->current_count, entry->current_list, false);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_diff_index_list(info, scratch->desired, entry->desired_count, entry->desired_list, true);
+    }
+
+    for (idx = 0; status == SAI_STATUS_SUCCESS && idx < entry->current_count + entry->desired_count; idx++)
+    {
+        /* each attribute once, desired ones only when not in current list */
+
+        attr = (idx < entry->current_count) ? &entry->current_list[idx] : &entry->desired_list[idx - entry->current_count];
+
+        field = info->fieldindex(attr->id);
+
+        if (idx >= entry->current_count && scratch->current[field] != NULL)
+        {
+            continue;
+        }
+
+        md = info->fields[field].attrmetadata;
+
+        if (!sai_diff_attr(md, scratch->current[field], scratch->desired[field], entry))
+        {
+            entry->verdict = SAI_DIFF_VERDICT_RECREATE;
+            entry->recreate_attr_id = md->attrid;
+            entry->set_count = 0;
+            break;
+        }
+    }
+
+    sai_diff_scratch_clear(info, scratch, entry->current_count, entry->current_list);
+    sai_diff_scratch_clear(info, scratch, entry->desired_count, entry->desired_list);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        entry->set_count = 0;
+
+        return status;
+    }
+
+    if (entry->set_count)
+    {
+        entry->verdict = SAI_DIFF_VERDICT_SET;
+
+        sai_diff_order(info, entry);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_diff(
+        _Inout_ sai_diff_entry_t *entry)
+{
+    sai_diff_scratch_t scratch;
+
+    if (entry == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(&scratch, 0, sizeof(scratch));
+
+    entry->status = sai_diff_entry(entry, &scratch);
+
+    sai_diff_scratch_free(&scratch);
+
+    return entry->status;
+}
+
+static void* sai_diff_bulk_worker(
+        _Inout_ void *arg)
+{
+    sai_diff_bulk_t *bulk = (sai_diff_bulk_t*)arg;
+    sai_diff_scratch_t scratch;
+    uint32_t failures = 0;
+
+    memset(&scratch, 0, sizeof(scratch));
+
+    while (true)
+    {
+        uint32_t start = __atomic_fetch_add(&bulk->next, SAI_DIFF_BULK_CHUNK, __ATOMIC_RELAXED);
+        uint32_t idx;
+
+        if (start >= bulk->count)
+        {
+            break;
+        }
+
+        for (idx = start; idx < bulk->count && idx - start < SAI_DIFF_BULK_CHUNK; idx++)
+        {
+            bulk->entries[idx].status = sai_diff_entry(&bulk->entries[idx], &scratch);
+
+            failures += (bulk->entries[idx].status != SAI_STATUS_SUCCESS);
+        }
+    }
+
+    sai_diff_scratch_free(&scratch);
+
+    __atomic_fetch_add(&bulk->failures, failures, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+sai_status_t sai_diff_bulk(
+        _In_ const sai_diff_bulk_config_t *config,
+        _In_ uint32_t count,
+        _Inout_ sai_diff_entry_t *entries)
+{
+    sai_diff_bulk_t bulk;
+    pthread_t *workers = NULL;
+    uint32_t chunks = (count + SAI_DIFF_BULK_CHUNK - 1) / SAI_DIFF_BULK_CHUNK;
+    uint32_t started = 0;
+    uint32_t threads;
+    uint32_t idx;
+
+    if (config == NULL || (count && entries == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    threads = config->threads;
+
+    bulk.count = count;
+    bulk.entries = entries;
+    bulk.next = 0;
+    bulk.failures = 0;
+
+    if (threads > chunks)
+    {
+        threads = chunks;
+    }
+
+    if (threads > 1)
+    {
+        workers = malloc((threads - 1) * sizeof(pthread_t));
+    }
+
+    for (idx = 0; workers != NULL && idx < threads - 1; idx++)
+    {
+        if (pthread_create(&workers[started], NULL, sai_diff_bulk_worker, &bulk) != 0)
+        {
+            break;
+        }
+
+        started++;
+    }
+
+    sai_diff_bulk_worker(&bulk);
+
+    for (idx = 0; idx < started; idx++)
+    {
+        pthread_join(workers[idx], NULL);
+    }
+
+    free(workers);
+
+    return bulk.failures ? SAI_STATUS_FAILURE : SAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saidiff.h
+ *
+ * @brief   This module defines SAI attribute list diff
+ */
+
+#ifndef __SAIDIFF_H_
+#define __SAIDIFF_H_
+
+/**
+ * @defgroup SAIDIFF SAI - Attribute list diff
+ *
+ * Diff compares current attribute list of object (what was created and set
+ * before, or what was read back from switch) with desired attribute list of
+ * the same object type, and computes set attribute calls which turn current
+ * state into desired one, or tells that object must be removed and created
+ * again.
+ *
+ * Attributes are matched through field index of object struct, so diff is
+ * linear in length of both lists, and values are compared in binary form by
+ * sai_metadata_compare_attribute_value. Attribute missing in a list has its
+ * default value when default is constant or empty list. Read only
+ * attributes of current list are ignored.
+ *
+ * Changed attribute which is create only, or attribute which is only in
+ * current list and has no known default value (it can't be restored by set)
+ * makes object recreated. Conditional and valid only attribute which is
+ * only in current list is ignored when its condition is not met by desired
+ * list. Other changed attributes become set operations, attributes which
+ * are condition or valid only condition of other set attribute go first,
+ * then in order of attribute ids.
+ *
+ * @{
+ */
+
+/**
+ * @brief Diff verdict
+ */
+typedef enum _sai_diff_verdict_t
+{
+    /**
+     * @brief Lists are equal, nothing to do
+     */
+    SAI_DIFF_VERDICT_EQUAL,
+
+    /**
+     * @brief Set operations turn current state into desired one
+     */
+    SAI_DIFF_VERDICT_SET,
+
+    /**
+     * @brief Object must be removed and created with desired list
+     */
+    SAI_DIFF_VERDICT_RECREATE,
+
+} sai_diff_verdict_t;
+
+/**
+ * @brief Diff of single object
+ */
+typedef struct _sai_diff_entry_t
+{
+    /**
+     * @brief Object type of both lists
+     */
+    sai_object_type_t object_type;
+
+    /**
+     * @brief Number of current attributes
+     */
+    uint32_t current_count;
+
+    /**
+     * @brief Current attributes
+     */
+    const sai_attribute_t *current_list;
+
+    /**
+     * @brief Number of desired attributes
+     */
+    uint32_t desired_count;
+
+    /**
+     * @brief Desired attributes
+     */
+    const sai_attribute_t *desired_list;
+
+    /**
+     * @brief Set operations, room for current_count + desired_count
+     * attributes provided by caller
+     *
+     * Values are shallow copies of desired attributes or of default values,
+     * lists point to their memory.
+     */
+    sai_attribute_t *set_list;
+
+    /**
+     * @brief Number of set operations
+     */
+    uint32_t set_count;
+
+    /**
+     * @brief Verdict
+     */
+    sai_diff_verdict_t verdict;
+
+    /**
+     * @brief Attribute which forces recreate
+     */
+    sai_attr_id_t recreate_attr_id;
+
+    /**
+     * @brief Status of diff
+     */
+    sai_status_t status;
+
+} sai_diff_entry_t;
+
+/**
+ * @brief Diff attribute lists of single object
+ *
+ * @param[inout] entry Object type and lists on input, verdict and set
+ * operations on output
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_UNKNOWN_ATTRIBUTE_0
+ * plus index when attribute does not belong to object type,
+ * #SAI_STATUS_INVALID_ATTRIBUTE_0 plus index when attribute is repeated or
+ * desired attribute is read only, index is in current list when it is
+ * wrong, otherwise in desired list
+ */
+extern sai_status_t sai_diff(
+        _Inout_ sai_diff_entry_t *entry);
+
+/**
+ * @brief Bulk diff configuration
+ */
+typedef struct _sai_diff_bulk_config_t
+{
+    /**
+     * @brief Number of threads including caller, 0 for 1
+     */
+    uint32_t threads;
+
+} sai_diff_bulk_config_t;
+
+/**
+ * @brief Diff attribute lists of many objects in parallel
+ *
+ * Entries are split between threads, status of each entry is set.
+ *
+ * @param[in] config Configuration
+ * @param[in] count Number of entries
+ * @param[inout] entries Entries
+ *
+ * @return #SAI_STATUS_SUCCESS when all entries succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_diff_bulk(
+        _In_ const sai_diff_bulk_config_t *config,
+        _In_ uint32_t count,
+        _Inout_ sai_diff_entry_t *entries);
+
+/**
+ * @}
+ */
+#endif /** __SAIDIFF_H_ */
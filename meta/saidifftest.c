@@ -0,0 +1,402 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saidifftest.c
+ *
+ * @brief   This module implements SAI attribute list diff tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saidiff.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_NEXT_HOP_ID        0x4000000000001ULL
+
+#define TEST_MIRROR_SESSION_ID  0xe000000000001ULL
+
+#define TEST_BUFFER_POOL_ID     0x18000000000001ULL
+
+#define TEST_BULK_COUNT         10000
+
+static uint32_t test_lanes[4] = { 1, 2, 3, 4 };
+
+static uint32_t test_other_lanes[4] = { 5, 6, 7, 8 };
+
+/*
+ * Port with lanes, speed and optional attributes, returns attribute count.
+ */
+
+static uint32_t test_port_attrs(
+        _Inout_ uint32_t *lanes,
+        _In_ uint32_t speed,
+        _Inout_ sai_attribute_t *attrs)
+{
+    attrs[0].id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attrs[0].value.u32list.count = 4;
+    attrs[0].value.u32list.list = lanes;
+
+    attrs[1].id = SAI_PORT_ATTR_SPEED;
+    attrs[1].value.u32 = speed;
+
+    return 2;
+}
+
+static void test_entry(
+        _Out_ sai_diff_entry_t *entry,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t current_count,
+        _In_ const sai_attribute_t *current_list,
+        _In_ uint32_t desired_count,
+        _In_ const sai_attribute_t *desired_list,
+        _Inout_ sai_attribute_t *set_list)
+{
+    memset(entry, 0, sizeof(*entry));
+
+    entry->object_type = object_type;
+    entry->current_count = current_count;
+    entry->current_list = current_list;
+    entry->desired_count = desired_count;
+    entry->desired_list = desired_list;
+    entry->set_list = set_list;
+}
+
+static void test_equal()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+    uint32_t lanes[4] = { 1, 2, 3, 4 };
+
+    uint32_t cc = test_port_attrs(test_lanes, 100000, current);
+    uint32_t dc = test_port_attrs(lanes, 100000, desired);
+
+    /* equal list in other memory, default values and read only attribute */
+
+    current[cc].id = SAI_PORT_ATTR_ADMIN_STATE;
+    current[cc++].value.booldata = false;
+
+    current[cc].id = SAI_PORT_ATTR_OPER_STATUS;
+    current[cc++].value.s32 = SAI_PORT_OPER_STATUS_UP;
+
+    current[cc].id = SAI_PORT_ATTR_EGRESS_MIRROR_SESSION;
+    current[cc].value.objlist.count = 0;
+    current[cc++].value.objlist.list = NULL;
+
+    desired[dc].id = SAI_PORT_ATTR_MTU;
+    desired[dc++].value.u32 = 1514;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_EQUAL && entry.set_count == 0, "not equal");
+
+    test_entry(&entry, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, 0, NULL, NULL);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS && entry.verdict == SAI_DIFF_VERDICT_EQUAL, "empty lists");
+}
+
+static void test_set()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+    sai_object_id_t sessions[1] = { TEST_MIRROR_SESSION_ID };
+
+    uint32_t cc = test_port_attrs(test_lanes, 100000, current);
+    uint32_t dc = test_port_attrs(test_lanes, 400000, desired);
+
+    /* changed, added with default value, removed list, added */
+
+    current[cc].id = SAI_PORT_ATTR_EGRESS_MIRROR_SESSION;
+    current[cc].value.objlist.count = 1;
+    current[cc++].value.objlist.list = sessions;
+
+    current[cc].id = SAI_PORT_ATTR_MTU;
+    current[cc++].value.u32 = 9100;
+
+    desired[dc].id = SAI_PORT_ATTR_ADMIN_STATE;
+    desired[dc++].value.booldata = false;
+
+    desired[dc].id = SAI_PORT_ATTR_INGRESS_MIRROR_SESSION;
+    desired[dc].value.objlist.count = 1;
+    desired[dc++].value.objlist.list = sessions;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_SET && entry.set_count == 4, "set count %u", entry.set_count);
+
+    ASSERT_TRUE(set[0].id == SAI_PORT_ATTR_SPEED && set[0].value.u32 == 400000, "speed");
+    ASSERT_TRUE(set[1].id == SAI_PORT_ATTR_MTU && set[1].value.u32 == 1514, "mtu default");
+    ASSERT_TRUE(set[2].id == SAI_PORT_ATTR_INGRESS_MIRROR_SESSION && set[2].value.objlist.list == sessions, "ingress mirror");
+    ASSERT_TRUE(set[3].id == SAI_PORT_ATTR_EGRESS_MIRROR_SESSION && set[3].value.objlist.count == 0, "egress mirror empty");
+}
+
+static void test_order()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+
+    uint32_t cc = test_port_attrs(test_lanes, 100000, current);
+    uint32_t dc = test_port_attrs(test_lanes, 100000, desired);
+
+    /*
+     * Combined PFC is not valid in separate mode, so it is not restored,
+     * mode goes before RX and TX which are valid only in separate mode.
+     */
+
+    current[cc].id = SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL;
+    current[cc++].value.u8 = 0x08;
+
+    desired[dc].id = SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_TX;
+    desired[dc++].value.u8 = 0x08;
+
+    desired[dc].id = SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_RX;
+    desired[dc++].value.u8 = 0x08;
+
+    desired[dc].id = SAI_PORT_ATTR_MTU;
+    desired[dc++].value.u32 = 9100;
+
+    desired[dc].id = SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_MODE;
+    desired[dc++].value.s32 = SAI_PORT_PRIORITY_FLOW_CONTROL_MODE_SEPARATE;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_SET && entry.set_count == 4, "set count %u", entry.set_count);
+
+    ASSERT_TRUE(set[0].id == SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_MODE, "mode first");
+    ASSERT_TRUE(set[1].id == SAI_PORT_ATTR_MTU, "mtu");
+    ASSERT_TRUE(set[2].id == SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_RX, "rx");
+    ASSERT_TRUE(set[3].id == SAI_PORT_ATTR_PRIORITY_FLOW_CONTROL_TX, "tx");
+}
+
+static void test_recreate()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+
+    uint32_t cc = test_port_attrs(test_lanes, 100000, current);
+    uint32_t dc = test_port_attrs(test_other_lanes, 400000, desired);
+
+    /* create only list changed */
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_RECREATE, "lanes changed");
+    ASSERT_TRUE(entry.recreate_attr_id == SAI_PORT_ATTR_HW_LANE_LIST && entry.set_count == 0, "recreate attribute");
+
+    /* attribute without default value can't be restored */
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, 1, current, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_RECREATE && entry.recreate_attr_id == SAI_PORT_ATTR_SPEED, "speed removed");
+}
+
+static void test_condition()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+
+    desired[0].id = SAI_BUFFER_PROFILE_ATTR_POOL_ID;
+    desired[0].value.oid = TEST_BUFFER_POOL_ID;
+    desired[1].id = SAI_BUFFER_PROFILE_ATTR_RESERVED_BUFFER_SIZE;
+    desired[1].value.u64 = 1024;
+    desired[2].id = SAI_BUFFER_PROFILE_ATTR_THRESHOLD_MODE;
+    desired[2].value.s32 = SAI_BUFFER_PROFILE_THRESHOLD_MODE_STATIC;
+    desired[3].id = SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH;
+    desired[3].value.u64 = 4096;
+
+    memcpy(current, desired, 4 * sizeof(sai_attribute_t));
+
+    /* dynamic threshold has no default, but it is not used in static mode */
+
+    current[4].id = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+    current[4].value.s8 = 1;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_BUFFER_PROFILE, 5, current, 4, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_EQUAL, "condition not met");
+
+    desired[2].value.s32 = SAI_BUFFER_PROFILE_THRESHOLD_MODE_DYNAMIC;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_BUFFER_PROFILE, 5, current, 4, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS, "diff failed");
+    ASSERT_TRUE(entry.verdict == SAI_DIFF_VERDICT_RECREATE, "create only mode changed");
+    ASSERT_TRUE(entry.recreate_attr_id == SAI_BUFFER_PROFILE_ATTR_THRESHOLD_MODE, "mode");
+}
+
+static void test_invalid()
+{
+    sai_attribute_t current[8];
+    sai_attribute_t desired[8];
+    sai_attribute_t set[16];
+    sai_diff_entry_t entry;
+
+    uint32_t cc = test_port_attrs(test_lanes, 100000, current);
+    uint32_t dc = test_port_attrs(test_lanes, 100000, desired);
+
+    desired[dc].id = SAI_PORT_ATTR_OPER_STATUS;
+    desired[dc].value.s32 = SAI_PORT_OPER_STATUS_UP;
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc + 1, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE(2), "read only desired");
+
+    desired[dc].id = SAI_PORT_ATTR_SPEED;
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE(2), "repeated");
+
+    desired[dc].id = SAI_PORT_ATTR_END;
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_UNKNOWN_ATTRIBUTE_0 + SAI_STATUS_CODE(2), "unknown");
+    ASSERT_TRUE(entry.set_count == 0, "set count on error");
+
+    /* scratch is clean after errors */
+
+    test_entry(&entry, SAI_OBJECT_TYPE_PORT, cc, current, dc, desired, set);
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_SUCCESS && entry.verdict == SAI_DIFF_VERDICT_EQUAL, "valid after error");
+
+    entry.object_type = SAI_OBJECT_TYPE_NULL;
+
+    ASSERT_TRUE(sai_diff(&entry) == SAI_STATUS_INVALID_OBJECT_TYPE, "null object type");
+    ASSERT_TRUE(sai_diff(NULL) == SAI_STATUS_INVALID_PARAMETER, "null entry");
+}
+
+static void test_bulk()
+{
+    sai_attribute_t *current = calloc(TEST_BULK_COUNT * 2, sizeof(sai_attribute_t));
+    sai_attribute_t *desired = calloc(TEST_BULK_COUNT * 2, sizeof(sai_attribute_t));
+    sai_attribute_t *set = calloc(TEST_BULK_COUNT * 4, sizeof(sai_attribute_t));
+    sai_diff_entry_t *entries = calloc(TEST_BULK_COUNT, sizeof(sai_diff_entry_t));
+    sai_diff_bulk_config_t config;
+    uint32_t idx;
+
+    ASSERT_TRUE(current && desired && set && entries, "no memory");
+
+    /* every third route changes next hop, every fifth one has invalid list */
+
+    for (idx = 0; idx < TEST_BULK_COUNT; idx++)
+    {
+        sai_attribute_t *c = &current[idx * 2];
+        sai_attribute_t *d = &desired[idx * 2];
+
+        c[0].id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+        c[0].value.s32 = SAI_PACKET_ACTION_FORWARD;
+        c[1].id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+        c[1].value.oid = TEST_NEXT_HOP_ID;
+
+        d[0] = c[0];
+        d[1] = c[1];
+
+        if (idx % 3 == 0)
+        {
+            d[1].value.oid = TEST_NEXT_HOP_ID + 1;
+        }
+
+        if (idx % 5 == 0)
+        {
+            d[0].id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+        }
+
+        test_entry(&entries[idx], SAI_OBJECT_TYPE_ROUTE_ENTRY, 2, c, 2, d, &set[idx * 4]);
+    }
+
+    config.threads = 4;
+
+    ASSERT_TRUE(sai_diff_bulk(&config, TEST_BULK_COUNT, entries) == SAI_STATUS_FAILURE, "bulk with invalid entries");
+
+    for (idx = 0; idx < TEST_BULK_COUNT; idx++)
+    {
+        if (idx % 5 == 0)
+        {
+            ASSERT_TRUE(entries[idx].status == SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE(1), "entry %u status", idx);
+            continue;
+        }
+
+        ASSERT_TRUE(entries[idx].status == SAI_STATUS_SUCCESS, "entry %u status", idx);
+
+        if (idx % 3 == 0)
+        {
+            ASSERT_TRUE(entries[idx].verdict == SAI_DIFF_VERDICT_SET && entries[idx].set_count == 1, "entry %u", idx);
+            ASSERT_TRUE(entries[idx].set_list[0].value.oid == TEST_NEXT_HOP_ID + 1, "entry %u next hop", idx);
+        }
+        else
+        {
+            ASSERT_TRUE(entries[idx].verdict == SAI_DIFF_VERDICT_EQUAL, "entry %u", idx);
+        }
+    }
+
+    ASSERT_TRUE(sai_diff_bulk(&config, 0, NULL) == SAI_STATUS_SUCCESS, "no entries");
+    ASSERT_TRUE(sai_diff_bulk(NULL, 3, &entries[1]) == SAI_STATUS_INVALID_PARAMETER, "NULL config");
+
+    config.threads = 0;
+
+    ASSERT_TRUE(sai_diff_bulk(&config, 3, &entries[1]) == SAI_STATUS_SUCCESS, "single thread");
+
+    free(current);
+    free(desired);
+    free(set);
+    free(entries);
+}
+
+int main()
+{
+    test_equal();
+
+    test_set();
+
+    test_order();
+
+    test_recreate();
+
+    test_condition();
+
+    test_invalid();
+
+    test_bulk();
+
+    return 0;
+}
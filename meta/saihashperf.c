@@ -0,0 +1,381 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saihashperf.c
+ *
+ * @brief   This module defines SAI entry hash benchmark
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+
+#define PERF_KEYS (1 << 20)
+
+#define PERF_ROUNDS 8
+
+/*
+ * Measures generated entry hash and equality against hashing normalized
+ * keys as bytes, and quality of generated hash on sequential keys (worst
+ * case for weak hashes): full 64 bit collisions and bucket occupancy of
+ * power of two table indexed by low bits. Keys are built over garbage, so
+ * every key is also checked to hash the same as its zeroed copy.
+ */
+
+typedef void (*perf_key_fn)(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key);
+
+static sai_object_meta_key_t *perf_keys;
+
+static sai_object_meta_key_t *perf_copies;
+
+static uint64_t *perf_hashes;
+
+static uint32_t *perf_buckets;
+
+static void perf_route_ipv4(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key)
+{
+    sai_route_entry_t *route_entry = &meta_key->objectkey.key.route_entry;
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+
+    route_entry->switch_id = 0x21000000000000ULL;
+    route_entry->vr_id = 0x3000000000022ULL;
+    route_entry->destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    route_entry->destination.addr.ip4 = 0x0a000000 + (idx << 8);
+    route_entry->destination.mask.ip4 = 0xffffff00;
+}
+
+static void perf_route_ipv6(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key)
+{
+    sai_route_entry_t *route_entry = &meta_key->objectkey.key.route_entry;
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+
+    route_entry->switch_id = 0x21000000000000ULL;
+    route_entry->vr_id = 0x3000000000022ULL;
+    route_entry->destination.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+
+    memset(route_entry->destination.addr.ip6, 0, sizeof(sai_ip6_t));
+    memset(route_entry->destination.mask.ip6, 0, sizeof(sai_ip6_t));
+    memset(route_entry->destination.mask.ip6, 0xff, 8);
+
+    route_entry->destination.addr.ip6[0] = 0x20;
+    route_entry->destination.addr.ip6[1] = 0x01;
+    route_entry->destination.addr.ip6[2] = 0x0d;
+    route_entry->destination.addr.ip6[3] = 0xb8;
+    route_entry->destination.addr.ip6[5] = (uint8_t)(idx >> 16);
+    route_entry->destination.addr.ip6[6] = (uint8_t)(idx >> 8);
+    route_entry->destination.addr.ip6[7] = (uint8_t)idx;
+}
+
+static void perf_neighbor(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key)
+{
+    sai_neighbor_entry_t *neighbor_entry = &meta_key->objectkey.key.neighbor_entry;
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_NEIGHBOR_ENTRY;
+
+    neighbor_entry->switch_id = 0x21000000000000ULL;
+    neighbor_entry->rif_id = 0x6000000000000ULL + (idx & 0xff);
+    neighbor_entry->ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    neighbor_entry->ip_address.addr.ip4 = 0x0a000000 + (idx >> 8);
+}
+
+static void perf_fdb(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key)
+{
+    sai_fdb_entry_t *fdb_entry = &meta_key->objectkey.key.fdb_entry;
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_FDB_ENTRY;
+
+    fdb_entry->switch_id = 0x21000000000000ULL;
+    fdb_entry->bv_id = 0x26000000000000ULL + (idx & 0xf);
+    fdb_entry->mac_address[0] = 0x00;
+    fdb_entry->mac_address[1] = 0x11;
+    fdb_entry->mac_address[2] = 0x22;
+    fdb_entry->mac_address[3] = (uint8_t)(idx >> 20);
+    fdb_entry->mac_address[4] = (uint8_t)(idx >> 12);
+    fdb_entry->mac_address[5] = (uint8_t)(idx >> 4);
+}
+
+static void perf_nat(
+        _In_ uint32_t idx,
+        _Inout_ sai_object_meta_key_t *meta_key)
+{
+    sai_nat_entry_t *nat_entry = &meta_key->objectkey.key.nat_entry;
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_NAT_ENTRY;
+
+    nat_entry->switch_id = 0x21000000000000ULL;
+    nat_entry->vr_id = 0x3000000000022ULL;
+    nat_entry->nat_type = SAI_NAT_TYPE_SOURCE_NAT;
+    nat_entry->data.key.src_ip = 0xc0a80000 + (idx >> 6);
+    nat_entry->data.key.dst_ip = 0;
+    nat_entry->data.key.proto = 6;
+    nat_entry->data.key.l4_src_port = (uint16_t)(1024 + (idx & 0x3f));
+    nat_entry->data.key.l4_dst_port = 0;
+    nat_entry->data.mask.src_ip = 0xffffffff;
+    nat_entry->data.mask.dst_ip = 0;
+    nat_entry->data.mask.proto = 0xff;
+    nat_entry->data.mask.l4_src_port = 0xffff;
+    nat_entry->data.mask.l4_dst_port = 0;
+}
+
+/*
+ * Previous way of hashing entries: normalize key, then hash its bytes.
+ */
+
+static uint64_t perf_hash_normalized(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_object_meta_key_t key;
+    const uint8_t *data = (const uint8_t*)&key.objectkey.key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t size;
+    size_t idx;
+
+    sai_metadata_normalize_object_meta_key(meta_key, &key);
+
+    size = sai_metadata_get_object_key_size(meta_key->objecttype);
+
+    for (idx = 0; idx < size; idx++)
+    {
+        hash = (hash ^ data[idx]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static bool perf_equal_normalized(
+        _In_ const sai_object_meta_key_t *a,
+        _In_ const sai_object_meta_key_t *b)
+{
+    sai_object_meta_key_t ka;
+    sai_object_meta_key_t kb;
+
+    sai_metadata_normalize_object_meta_key(a, &ka);
+    sai_metadata_normalize_object_meta_key(b, &kb);
+
+    return memcmp(&ka, &kb, offsetof(sai_object_meta_key_t, objectkey) + sai_metadata_get_object_key_size(a->objecttype)) == 0;
+}
+
+static int perf_compare_hashes(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    uint64_t ha = *(const uint64_t*)a;
+    uint64_t hb = *(const uint64_t*)b;
+
+    return (ha > hb) - (ha < hb);
+}
+
+static int perf_quality(
+        _In_ const char *name)
+{
+    uint32_t collisions = 0;
+    uint32_t max_load = 0;
+    uint32_t empty = 0;
+    uint32_t idx;
+
+    for (idx = 0; idx < PERF_KEYS; idx++)
+    {
+        uint64_t hash = sai_metadata_hash_object_meta_key(&perf_keys[idx]);
+
+        if (hash != sai_metadata_hash_object_meta_key(&perf_copies[idx]) ||
+                !sai_metadata_equal_object_meta_key(&perf_keys[idx], &perf_copies[idx]))
+        {
+            fprintf(stderr, "%s: key %u differs from its zeroed copy\n", name, idx);
+            return 1;
+        }
+
+        perf_hashes[idx] = hash;
+    }
+
+    /* table of PERF_KEYS buckets indexed by low bits, load factor 1 */
+
+    memset(perf_buckets, 0, PERF_KEYS * sizeof(uint32_t));
+
+    for (idx = 0; idx < PERF_KEYS; idx++)
+    {
+        uint32_t *bucket = &perf_buckets[perf_hashes[idx] & (PERF_KEYS - 1)];
+
+        if (++*bucket > max_load)
+        {
+            max_load = *bucket;
+        }
+    }
+
+    for (idx = 0; idx < PERF_KEYS; idx++)
+    {
+        empty += (perf_buckets[idx] == 0);
+    }
+
+    qsort(perf_hashes, PERF_KEYS, sizeof(uint64_t), perf_compare_hashes);
+
+    for (idx = 1; idx < PERF_KEYS; idx++)
+    {
+        collisions += (perf_hashes[idx] == perf_hashes[idx - 1]);
+    }
+
+    /* random hash leaves 1/e = 36.8% buckets empty */
+
+    printf("%-16s %8u collisions %8.2f%% empty buckets %4u max bucket\n",
+            name,
+            collisions,
+            100.0 * empty / PERF_KEYS,
+            max_load);
+
+    return collisions != 0 || max_load > 16;
+}
+
+static void perf_throughput(
+        _In_ const char *name)
+{
+    volatile uint64_t sink = 0;
+    uint64_t start;
+    uint64_t generated;
+    uint64_t normalized;
+    uint64_t equal;
+    uint64_t equal_normalized;
+    uint32_t round;
+    uint32_t idx;
+
+    start = sai_metadata_now();
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_KEYS; idx++)
+        {
+            sink += sai_metadata_hash_object_meta_key(&perf_keys[idx]);
+        }
+    }
+
+    generated = sai_metadata_now() - start;
+    start = sai_metadata_now();
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_KEYS; idx++)
+        {
+            sink += perf_hash_normalized(&perf_keys[idx]);
+        }
+    }
+
+    normalized = sai_metadata_now() - start;
+    start = sai_metadata_now();
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_KEYS; idx++)
+        {
+            sink += sai_metadata_equal_object_meta_key(&perf_keys[idx], &perf_copies[idx]);
+        }
+    }
+
+    equal = sai_metadata_now() - start;
+    start = sai_metadata_now();
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_KEYS; idx++)
+        {
+            sink += perf_equal_normalized(&perf_keys[idx], &perf_copies[idx]);
+        }
+    }
+
+    equal_normalized = sai_metadata_now() - start;
+
+    printf("%-16s hash %6.1f ns (normalized %6.1f ns) equal %6.1f ns (normalized %6.1f ns)\n",
+            name,
+            (double)generated / (PERF_KEYS * PERF_ROUNDS),
+            (double)normalized / (PERF_KEYS * PERF_ROUNDS),
+            (double)equal / (PERF_KEYS * PERF_ROUNDS),
+            (double)equal_normalized / (PERF_KEYS * PERF_ROUNDS));
+}
+
+static int perf_run(
+        _In_ const char *name,
+        _In_ perf_key_fn fn)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < PERF_KEYS; idx++)
+    {
+        /* padding and unused bytes of union are garbage in keys, zero in copies */
+
+        memset(&perf_keys[idx], 0xa5 ^ (int)(idx & 0x5a), sizeof(sai_object_meta_key_t));
+        memset(&perf_copies[idx], 0, sizeof(sai_object_meta_key_t));
+
+        fn(idx, &perf_keys[idx]);
+        fn(idx, &perf_copies[idx]);
+    }
+
+    if (perf_quality(name))
+    {
+        return 1;
+    }
+
+    perf_throughput(name);
+
+    return 0;
+}
+
+int main()
+{
+    int failed = 0;
+
+    perf_keys = (sai_object_meta_key_t*)calloc(PERF_KEYS, sizeof(sai_object_meta_key_t));
+    perf_copies = (sai_object_meta_key_t*)calloc(PERF_KEYS, sizeof(sai_object_meta_key_t));
+    perf_hashes = (uint64_t*)calloc(PERF_KEYS, sizeof(uint64_t));
+    perf_buckets = (uint32_t*)calloc(PERF_KEYS, sizeof(uint32_t));
+
+    if (perf_keys == NULL || perf_copies == NULL || perf_hashes == NULL || perf_buckets == NULL)
+    {
+        fprintf(stderr, "failed to allocate %u keys\n", PERF_KEYS);
+        return 1;
+    }
+
+    failed |= perf_run("route ipv4", perf_route_ipv4);
+    failed |= perf_run("route ipv6", perf_route_ipv6);
+    failed |= perf_run("neighbor", perf_neighbor);
+    failed |= perf_run("fdb", perf_fdb);
+    failed |= perf_run("nat", perf_nat);
+
+    free(perf_keys);
+    free(perf_copies);
+    free(perf_hashes);
+    free(perf_buckets);
+
+    return failed;
+}
@@ -0,0 +1,754 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saihistory.c
+ *
+ * @brief   This module implements SAI counter history store
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "saimetadata.h"
+#include "saihistory.h"
+
+#define SAI_HISTORY_DEFAULT_BLOCK_SIZE 256
+
+#define SAI_HISTORY_MIN_BLOCK_SIZE 32
+
+#define SAI_HISTORY_SERIES_MIN_SIZE 16
+
+/* timestamp and value varint, 10 bytes each at most */
+
+#define SAI_HISTORY_MAX_SAMPLE_SIZE 20
+
+/* first sample of block is kept in block header */
+
+#define SAI_HISTORY_HEADER_SAMPLE_SIZE (2 * sizeof(uint64_t))
+
+#define SAI_HISTORY_VARINT_CONTINUE 0x8080808080808080ULL
+
+#define SAI_HISTORY_NS_PER_SEC 1000000000.0
+
+typedef struct _sai_history_block_t
+{
+    struct _sai_history_block_t *next;
+
+    uint64_t first_timestamp;
+
+    uint64_t first_value;
+
+    uint64_t last_timestamp;
+
+    uint64_t last_value;
+
+    uint64_t last_interval;
+
+    uint32_t count;
+
+    uint32_t used;
+
+    uint8_t *data;
+
+} sai_history_block_t;
+
+typedef struct _sai_history_series_t
+{
+    sai_object_type_t object_type;
+
+    sai_object_id_t object_id;
+
+    sai_stat_id_t stat_id;
+
+    sai_history_block_t *head;
+
+    sai_history_block_t *tail;
+
+} sai_history_series_t;
+
+/*
+ * Decode buffers hold one block, timestamps, values and rates have one
+ * extra leading element for last sample of previous block.
+ */
+
+struct _sai_history_t
+{
+    sai_history_config_t config;
+
+    sai_history_series_t *series;
+
+    size_t count;
+
+    size_t size;
+
+    uint32_t max_samples;
+
+    uint64_t *codes;
+
+    uint64_t *timestamps;
+
+    uint64_t *values;
+
+    double *rates;
+
+    sai_history_stats_t stats;
+};
+
+sai_history_t* sai_history_open(
+        _In_ const sai_history_config_t *config)
+{
+    sai_history_t *history;
+
+    if (config == NULL || (config->block_size && config->block_size < SAI_HISTORY_MIN_BLOCK_SIZE))
+    {
+        SAI_META_LOG_ERROR("invalid history config");
+
+        return NULL;
+    }
+
+    history = (sai_history_t*)calloc(1, sizeof(sai_history_t));
+
+    if (history == NULL)
+    {
+        return NULL;
+    }
+
+    history->config = *config;
+
+    if (history->config.block_size == 0)
+    {
+        history->config.block_size = SAI_HISTORY_DEFAULT_BLOCK_SIZE;
+    }
+
+    /* every sample after first takes at least two bytes */
+
+    history->max_samples = 1 + history->config.block_size / 2;
+
+    history->codes = (uint64_t*)calloc(history->config.block_size, sizeof(uint64_t));
+    history->timestamps = (uint64_t*)calloc(history->max_samples + 1, sizeof(uint64_t));
+    history->values = (uint64_t*)calloc(history->max_samples + 1, sizeof(uint64_t));
+    history->rates = (double*)calloc(history->max_samples + 1, sizeof(double));
+
+    if (history->codes == NULL || history->timestamps == NULL || history->values == NULL || history->rates == NULL)
+    {
+        sai_history_close(history);
+        return NULL;
+    }
+
+    return history;
+}
+
+void sai_history_close(
+        _Inout_ sai_history_t *history)
+{
+    size_t idx;
+
+    if (history == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < history->count; idx++)
+    {
+        sai_history_block_t *block = history->series[idx].head;
+
+        while (block != NULL)
+        {
+            sai_history_block_t *next = block->next;
+
+            free(block);
+
+            block = next;
+        }
+    }
+
+    free(history->series);
+    free(history->codes);
+    free(history->timestamps);
+    free(history->values);
+    free(history->rates);
+    free(history);
+}
+
+sai_status_t sai_history_add_series(
+        _Inout_ sai_history_t *history,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id,
+        _In_ sai_stat_id_t stat_id,
+        _Out_ size_t *index)
+{
+    const sai_object_type_info_t *info;
+    sai_history_series_t *series;
+
+    if (history == NULL || index == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = sai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL || info->statenum == NULL || sai_metadata_get_enum_value_name(info->statenum, (int)stat_id) == NULL)
+    {
+        SAI_META_LOG_ERROR("stat %d is not stat of object type %d", stat_id, object_type);
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (history->count == history->size)
+    {
+        size_t size = history->size ? history->size * 2 : SAI_HISTORY_SERIES_MIN_SIZE;
+
+        series = (sai_history_series_t*)realloc(history->series, size * sizeof(sai_history_series_t));
+
+        if (series == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        history->series = series;
+        history->size = size;
+    }
+
+    series = &history->series[history->count];
+
+    memset(series, 0, sizeof(sai_history_series_t));
+
+    series->object_type = object_type;
+    series->object_id = object_id;
+    series->stat_id = stat_id;
+
+    *index = history->count++;
+
+    history->stats.series++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static uint64_t sai_history_zigzag(
+        _In_ uint64_t delta)
+{
+    /* delta is two's complement difference, small negative becomes small */
+
+    return (delta << 1) ^ ((uint64_t)0 - (delta >> 63));
+}
+
+static uint32_t sai_history_put_varint(
+        _Out_ uint8_t *buffer,
+        _In_ uint64_t u64)
+{
+    uint32_t size = 0;
+
+    while (u64 >= 0x80)
+    {
+        buffer[size++] = (uint8_t)(u64 | 0x80);
+
+        u64 >>= 7;
+    }
+
+    buffer[size++] = (uint8_t)u64;
+
+    return size;
+}
+
+static sai_history_block_t* sai_history_new_block(
+        _Inout_ sai_history_t *history,
+        _Inout_ sai_history_series_t *series,
+        _In_ uint64_t timestamp,
+        _In_ uint64_t value)
+{
+    sai_history_block_t *block;
+
+    block = (sai_history_block_t*)malloc(sizeof(sai_history_block_t) + history->config.block_size);
+
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->next = NULL;
+    block->first_timestamp = timestamp;
+    block->first_value = value;
+    block->last_timestamp = timestamp;
+    block->last_value = value;
+    block->last_interval = 0;
+    block->count = 1;
+    block->used = 0;
+    block->data = (uint8_t*)(block + 1);
+
+    if (series->tail != NULL)
+    {
+        series->tail->next = block;
+    }
+    else
+    {
+        series->head = block;
+    }
+
+    series->tail = block;
+
+    history->stats.blocks++;
+    history->stats.bytes += SAI_HISTORY_HEADER_SAMPLE_SIZE;
+
+    return block;
+}
+
+static void sai_history_expire(
+        _Inout_ sai_history_t *history,
+        _Inout_ sai_history_series_t *series,
+        _In_ uint64_t timestamp)
+{
+    if (history->config.retention == 0 || timestamp <= history->config.retention)
+    {
+        return;
+    }
+
+    /* block is dropped once its newest sample is older than retention */
+
+    while (series->head != series->tail && series->head->last_timestamp < timestamp - history->config.retention)
+    {
+        sai_history_block_t *block = series->head;
+
+        series->head = block->next;
+
+        history->stats.samples -= block->count;
+        history->stats.dropped += block->count;
+        history->stats.blocks--;
+        history->stats.bytes -= SAI_HISTORY_HEADER_SAMPLE_SIZE + block->used;
+
+        free(block);
+    }
+}
+
+sai_status_t sai_history_append(
+        _Inout_ sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t timestamp,
+        _In_ uint64_t value)
+{
+    uint8_t sample[SAI_HISTORY_MAX_SAMPLE_SIZE];
+    sai_history_series_t *series;
+    sai_history_block_t *block;
+    uint64_t interval;
+    uint32_t size;
+
+    if (history == NULL || index >= history->count)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    series = &history->series[index];
+    block = series->tail;
+
+    if (block != NULL && timestamp <= block->last_timestamp)
+    {
+        SAI_META_LOG_ERROR("sample time %" PRIu64 " is not later than last sample", timestamp);
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (block != NULL)
+    {
+        interval = timestamp - block->last_timestamp;
+
+        size = sai_history_put_varint(sample, sai_history_zigzag(interval - block->last_interval));
+        size += sai_history_put_varint(sample + size, sai_history_zigzag(value - block->last_value));
+
+        if (block->used + size <= history->config.block_size)
+        {
+            memcpy(block->data + block->used, sample, size);
+
+            block->used += size;
+            block->count++;
+            block->last_timestamp = timestamp;
+            block->last_value = value;
+            block->last_interval = interval;
+
+            history->stats.samples++;
+            history->stats.bytes += size;
+
+            sai_history_expire(history, series, timestamp);
+
+            return SAI_STATUS_SUCCESS;
+        }
+    }
+
+    if (sai_history_new_block(history, series, timestamp, value) == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    history->stats.samples++;
+
+    sai_history_expire(history, series, timestamp);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_history_append_list(
+        _Inout_ sai_history_t *history,
+        _In_ uint32_t count,
+        _In_ const size_t *index_list,
+        _In_ uint64_t timestamp,
+        _In_ const uint64_t *values)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    uint32_t idx;
+
+    if (history == NULL || (count && (index_list == NULL || values == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_status_t status = sai_history_append(history, index_list[idx], timestamp, values[idx]);
+
+        if (status != SAI_STATUS_SUCCESS && result == SAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Splits block data into varints. When next eight bytes have no
+ * continuation bit they are eight single byte varints, checked by single
+ * load and copied without branch per byte, regular polling produces such
+ * runs most of the time. Copy is scalar, bytes are widened one by one.
+ */
+
+static uint32_t sai_history_get_varints(
+        _In_ const uint8_t *data,
+        _In_ uint32_t count,
+        _Out_ uint64_t *codes)
+{
+    uint32_t pos = 0;
+    uint32_t size = 0;
+
+    while (pos < count)
+    {
+        uint64_t u64 = 0;
+        uint32_t shift = 0;
+        uint8_t byte;
+
+        if (pos + sizeof(uint64_t) <= count)
+        {
+            uint64_t word;
+
+            memcpy(&word, data + pos, sizeof(uint64_t));
+
+            if ((word & SAI_HISTORY_VARINT_CONTINUE) == 0)
+            {
+                uint32_t idx;
+
+                for (idx = 0; idx < sizeof(uint64_t); idx++)
+                {
+                    codes[size + idx] = data[pos + idx];
+                }
+
+                size += (uint32_t)sizeof(uint64_t);
+                pos += (uint32_t)sizeof(uint64_t);
+
+                continue;
+            }
+        }
+
+        do
+        {
+            byte = data[pos++];
+
+            u64 |= (uint64_t)(byte & 0x7f) << shift;
+
+            shift += 7;
+        }
+        while ((byte & 0x80) && pos < count);
+
+        codes[size++] = u64;
+    }
+
+    return size;
+}
+
+/*
+ * Decodes block into timestamps and values, returns number of samples.
+ * Only zigzag loop is vectorized by compiler at -O3, timestamps and values
+ * are prefix sums, each depends on previous one.
+ */
+
+static uint32_t sai_history_decode_block(
+        _In_ const sai_history_t *history,
+        _In_ const sai_history_block_t *block,
+        _Out_ uint64_t *timestamps,
+        _Out_ uint64_t *values)
+{
+    uint64_t *codes = history->codes;
+    uint64_t interval = 0;
+    uint32_t size;
+    uint32_t idx;
+
+    size = sai_history_get_varints(block->data, block->used, codes);
+
+    for (idx = 0; idx < size; idx++)
+    {
+        codes[idx] = (codes[idx] >> 1) ^ ((uint64_t)0 - (codes[idx] & 1));
+    }
+
+    timestamps[0] = block->first_timestamp;
+    values[0] = block->first_value;
+
+    for (idx = 1; idx < block->count; idx++)
+    {
+        interval += codes[2 * idx - 2];
+
+        timestamps[idx] = timestamps[idx - 1] + interval;
+        values[idx] = values[idx - 1] + codes[2 * idx - 1];
+    }
+
+    return block->count;
+}
+
+sai_status_t sai_history_query(
+        _In_ const sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t start,
+        _In_ uint64_t end,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ uint64_t *values)
+{
+    const sai_history_block_t *block;
+    uint32_t size;
+    uint32_t total = 0;
+
+    if (history == NULL || index >= history->count || count == NULL || (*count && (timestamps == NULL || values == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size = *count;
+
+    for (block = history->series[index].head; block != NULL && block->first_timestamp <= end; block = block->next)
+    {
+        uint32_t first = 0;
+        uint32_t last;
+        uint32_t n;
+
+        if (block->last_timestamp < start)
+        {
+            continue;
+        }
+
+        if (total >= size && block->first_timestamp >= start && block->last_timestamp <= end)
+        {
+            total += block->count;
+            continue;
+        }
+
+        n = sai_history_decode_block(history, block, history->timestamps, history->values);
+
+        while (history->timestamps[first] < start)
+        {
+            first++;
+        }
+
+        for (last = first; last < n && history->timestamps[last] <= end; last++)
+        {
+        }
+
+        if (total < size)
+        {
+            uint32_t copy = last - first < size - total ? last - first : size - total;
+
+            memcpy(&timestamps[total], &history->timestamps[first], copy * sizeof(uint64_t));
+            memcpy(&values[total], &history->values[first], copy * sizeof(uint64_t));
+        }
+
+        total += last - first;
+    }
+
+    *count = total;
+
+    return total > size ? SAI_STATUS_BUFFER_OVERFLOW : SAI_STATUS_SUCCESS;
+}
+
+static void sai_history_rate(
+        _In_ uint32_t count,
+        _In_ const uint64_t *timestamps,
+        _In_ const uint64_t *values,
+        _Out_ double *rates)
+{
+    uint32_t idx;
+
+    for (idx = 1; idx < count; idx++)
+    {
+        rates[idx] = (double)(values[idx] - values[idx - 1]) * SAI_HISTORY_NS_PER_SEC /
+            (double)(timestamps[idx] - timestamps[idx - 1]);
+    }
+}
+
+sai_status_t sai_history_query_rates(
+        _In_ const sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t start,
+        _In_ uint64_t end,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ double *rates)
+{
+    const sai_history_block_t *block;
+    bool previous = false;
+    uint32_t size;
+    uint32_t total = 0;
+
+    if (history == NULL || index >= history->count || count == NULL || (*count && (timestamps == NULL || rates == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size = *count;
+
+    for (block = history->series[index].head; block != NULL && block->first_timestamp <= end; block = block->next)
+    {
+        uint32_t first;
+        uint32_t last;
+        uint32_t n;
+
+        if (block->last_timestamp < start)
+        {
+            previous = false;
+            continue;
+        }
+
+        /* element 0 is last sample of previous block */
+
+        n = 1 + sai_history_decode_block(history, block, &history->timestamps[1], &history->values[1]);
+
+        sai_history_rate(n, history->timestamps, history->values, history->rates);
+
+        first = previous ? 1 : 2;
+
+        while (first < n && history->timestamps[first - 1] < start)
+        {
+            first++;
+        }
+
+        for (last = first; last < n && history->timestamps[last] <= end; last++)
+        {
+        }
+
+        if (total < size && last > first)
+        {
+            uint32_t copy = last - first < size - total ? last - first : size - total;
+
+            memcpy(&timestamps[total], &history->timestamps[first], copy * sizeof(uint64_t));
+            memcpy(&rates[total], &history->rates[first], copy * sizeof(double));
+        }
+
+        total += last > first ? last - first : 0;
+
+        history->timestamps[0] = history->timestamps[n - 1];
+        history->values[0] = history->values[n - 1];
+
+        previous = true;
+    }
+
+    *count = total;
+
+    return total > size ? SAI_STATUS_BUFFER_OVERFLOW : SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_history_export(
+        _In_ const sai_history_t *history,
+        _In_ const char *path)
+{
+    FILE *file;
+    size_t idx;
+    int failed = 0;
+
+    if (history == NULL || path == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s", path);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    for (idx = 0; idx < history->count; idx++)
+    {
+        const sai_history_series_t *series = &history->series[idx];
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(series->object_type);
+        const sai_history_block_t *block;
+
+        if (fprintf(file, "%s:oid:0x%" PRIx64 ":%s\n",
+                    sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t, series->object_type),
+                    series->object_id,
+                    sai_metadata_get_enum_value_name(info->statenum, (int)series->stat_id)) < 0)
+        {
+            failed = 1;
+        }
+
+        for (block = series->head; block != NULL && !failed; block = block->next)
+        {
+            uint32_t n = sai_history_decode_block(history, block, history->timestamps, history->values);
+            uint32_t sample;
+
+            for (sample = 0; sample < n; sample++)
+            {
+                if (fprintf(file, "%" PRIu64 " %" PRIu64 "\n", history->timestamps[sample], history->values[sample]) < 0)
+                {
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (fclose(file) != 0 || failed)
+    {
+        SAI_META_LOG_ERROR("failed to write %s", path);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_history_get_stats(
+        _In_ const sai_history_t *history,
+        _Out_ sai_history_stats_t *stats)
+{
+    if (history == NULL || stats == NULL)
+    {
+        return;
+    }
+
+    *stats = history->stats;
+}
@@ -0,0 +1,263 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saihistory.h
+ *
+ * @brief   This module defines SAI counter history store
+ */
+
+#ifndef __SAIHISTORY_H_
+#define __SAIHISTORY_H_
+
+/**
+ * @defgroup SAIHISTORY SAI - Counter history store
+ *
+ * Store keeps samples of counters in memory. Series is single counter
+ * (stat enum value of object type, like sai_port_stat_t or
+ * sai_queue_stat_t) of single object, sample is timestamp and counter
+ * value. Samples of series are appended in time order and compressed into
+ * fixed size blocks: block header holds first sample, following samples are
+ * delta of delta of timestamp and delta of value, both zigzag varint
+ * encoded. Counter polled at regular interval takes two or three bytes per
+ * sample instead of sixteen.
+ *
+ * Range queries decode whole blocks, decode and rates are plain scalar
+ * code. Blocks older than retention are dropped on append. Export writes
+ * samples as text, series are named by object type, object id and stat
+ * enum value name from metadata.
+ *
+ * Functions of store must be called from single thread.
+ *
+ * @{
+ */
+
+/**
+ * @brief Store configuration
+ */
+typedef struct _sai_history_config_t
+{
+    /**
+     * @brief Block size in bytes, 0 for default 256
+     */
+    uint32_t block_size;
+
+    /**
+     * @brief Time samples are kept for in nanoseconds, 0 to keep all
+     */
+    uint64_t retention;
+
+} sai_history_config_t;
+
+/**
+ * @brief Store statistics
+ */
+typedef struct _sai_history_stats_t
+{
+    /**
+     * @brief Number of series
+     */
+    uint64_t series;
+
+    /**
+     * @brief Number of samples kept
+     */
+    uint64_t samples;
+
+    /**
+     * @brief Number of blocks kept
+     */
+    uint64_t blocks;
+
+    /**
+     * @brief Number of bytes of encoded samples
+     */
+    uint64_t bytes;
+
+    /**
+     * @brief Number of samples dropped by retention
+     */
+    uint64_t dropped;
+
+} sai_history_stats_t;
+
+/**
+ * @brief Opaque store
+ */
+typedef struct _sai_history_t sai_history_t;
+
+/**
+ * @brief Create store without series
+ *
+ * @param[in] config Configuration
+ *
+ * @return Store or NULL on error
+ */
+extern sai_history_t* sai_history_open(
+        _In_ const sai_history_config_t *config);
+
+/**
+ * @brief Destroy store
+ *
+ * @param[inout] history Store
+ */
+extern void sai_history_close(
+        _Inout_ sai_history_t *history);
+
+/**
+ * @brief Add series
+ *
+ * @param[inout] history Store
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] stat_id Stat enum value of object type
+ * @param[out] index Series index
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER when
+ * object type has no stats or stat is not its stat enum value, failure status
+ * code on error
+ */
+extern sai_status_t sai_history_add_series(
+        _Inout_ sai_history_t *history,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id,
+        _In_ sai_stat_id_t stat_id,
+        _Out_ size_t *index);
+
+/**
+ * @brief Append sample to series
+ *
+ * @param[inout] history Store
+ * @param[in] index Series index
+ * @param[in] timestamp Sample time in nanoseconds
+ * @param[in] value Counter value
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER for
+ * unknown series or when timestamp is not later than last sample, failure
+ * status code on error
+ */
+extern sai_status_t sai_history_append(
+        _Inout_ sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t timestamp,
+        _In_ uint64_t value);
+
+/**
+ * @brief Append samples taken at the same time to series
+ *
+ * Values of counter read by counter poller are appended at once, with
+ * series of objects in index list.
+ *
+ * @param[inout] history Store
+ * @param[in] count Number of series
+ * @param[in] index_list Series indexes
+ * @param[in] timestamp Sample time in nanoseconds
+ * @param[in] values Counter values
+ *
+ * @return #SAI_STATUS_SUCCESS on success, status of first failed append on
+ * error, following series are still appended
+ */
+extern sai_status_t sai_history_append_list(
+        _Inout_ sai_history_t *history,
+        _In_ uint32_t count,
+        _In_ const size_t *index_list,
+        _In_ uint64_t timestamp,
+        _In_ const uint64_t *values);
+
+/**
+ * @brief Get samples of series in time range
+ *
+ * @param[in] history Store
+ * @param[in] index Series index
+ * @param[in] start Range start in nanoseconds, inclusive
+ * @param[in] end Range end in nanoseconds, inclusive
+ * @param[inout] count Size of output arrays on input, number of samples in
+ * range on output
+ * @param[out] timestamps Sample times
+ * @param[out] values Counter values
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * arrays are too small, #SAI_STATUS_INVALID_PARAMETER for unknown series
+ */
+extern sai_status_t sai_history_query(
+        _In_ const sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t start,
+        _In_ uint64_t end,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ uint64_t *values);
+
+/**
+ * @brief Get rates of series in time range
+ *
+ * Rate is difference of two consecutive samples in range per second, at
+ * time of the later sample.
+ *
+ * @param[in] history Store
+ * @param[in] index Series index
+ * @param[in] start Range start in nanoseconds, inclusive
+ * @param[in] end Range end in nanoseconds, inclusive
+ * @param[inout] count Size of output arrays on input, number of rates in
+ * range on output
+ * @param[out] timestamps Rate times
+ * @param[out] rates Rates per second
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * arrays are too small, #SAI_STATUS_INVALID_PARAMETER for unknown series
+ */
+extern sai_status_t sai_history_query_rates(
+        _In_ const sai_history_t *history,
+        _In_ size_t index,
+        _In_ uint64_t start,
+        _In_ uint64_t end,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ double *rates);
+
+/**
+ * @brief Export samples of all series to text file
+ *
+ * Each series starts with line of object type name, object id and stat
+ * name separated by colon, followed by line of timestamp and value per
+ * sample.
+ *
+ * @param[in] history Store
+ * @param[in] path File path
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_FAILURE when file can't
+ * be written
+ */
+extern sai_status_t sai_history_export(
+        _In_ const sai_history_t *history,
+        _In_ const char *path);
+
+/**
+ * @brief Get store statistics
+ *
+ * @param[in] history Store
+ * @param[out] stats Statistics
+ */
+extern void sai_history_get_stats(
+        _In_ const sai_history_t *history,
+        _Out_ sai_history_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAIHISTORY_H_ */
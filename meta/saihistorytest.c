@@ -0,0 +1,324 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saihistorytest.c
+ *
+ * @brief   This module implements SAI counter history store test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saihistory.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_FILE "saihistorytest.txt"
+
+#define TEST_PORT_ID 0x1000000000000ULL
+
+#define TEST_QUEUE_ID 0x15000000000000ULL
+
+#define TEST_SECOND 1000000000ULL
+
+#define TEST_SAMPLES 10000
+
+static uint64_t test_timestamps[TEST_SAMPLES];
+
+static uint64_t test_values[TEST_SAMPLES];
+
+static uint64_t test_seed = 1;
+
+static uint64_t test_random(void)
+{
+    test_seed = test_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    return test_seed >> 16;
+}
+
+static sai_history_t* test_open(
+        _In_ uint64_t retention)
+{
+    sai_history_config_t config;
+    sai_history_t *history;
+
+    memset(&config, 0, sizeof(config));
+
+    config.retention = retention;
+
+    history = sai_history_open(&config);
+
+    ASSERT_TRUE(history != NULL, "open");
+
+    return history;
+}
+
+static size_t test_add_port_series(
+        _Inout_ sai_history_t *history)
+{
+    size_t index;
+
+    ASSERT_TRUE(sai_history_add_series(history, SAI_OBJECT_TYPE_PORT, TEST_PORT_ID, SAI_PORT_STAT_IF_IN_OCTETS, &index) == SAI_STATUS_SUCCESS, "add series");
+
+    return index;
+}
+
+static void test_compression(void)
+{
+    sai_history_stats_t stats;
+    sai_history_t *history;
+    uint32_t count;
+    size_t index;
+    uint32_t idx;
+
+    history = test_open(0);
+    index = test_add_port_series(history);
+
+    /* regular polling of steady counter */
+
+    for (idx = 0; idx < TEST_SAMPLES; idx++)
+    {
+        uint64_t timestamp = TEST_SECOND * (idx + 1);
+        uint64_t value = 1000 * (uint64_t)idx + idx % 3;
+
+        ASSERT_TRUE(sai_history_append(history, index, timestamp, value) == SAI_STATUS_SUCCESS, "append %u", idx);
+    }
+
+    ASSERT_TRUE(sai_history_append(history, index, TEST_SECOND * TEST_SAMPLES, 0) == SAI_STATUS_INVALID_PARAMETER, "same timestamp");
+
+    sai_history_get_stats(history, &stats);
+
+    ASSERT_TRUE(stats.series == 1 && stats.samples == TEST_SAMPLES, "samples %lu", (unsigned long)stats.samples);
+    ASSERT_TRUE(stats.bytes < TEST_SAMPLES * 4, "bytes %lu", (unsigned long)stats.bytes);
+
+    count = TEST_SAMPLES;
+
+    ASSERT_TRUE(sai_history_query(history, index, 0, UINT64_MAX, &count, test_timestamps, test_values) == SAI_STATUS_SUCCESS, "query all");
+    ASSERT_TRUE(count == TEST_SAMPLES, "count %u", count);
+
+    for (idx = 0; idx < TEST_SAMPLES; idx++)
+    {
+        ASSERT_TRUE(test_timestamps[idx] == TEST_SECOND * (idx + 1), "timestamp %u", idx);
+        ASSERT_TRUE(test_values[idx] == 1000 * (uint64_t)idx + idx % 3, "value %u", idx);
+    }
+
+    count = 10;
+
+    ASSERT_TRUE(sai_history_query(history, index, 0, UINT64_MAX, &count, test_timestamps, test_values) == SAI_STATUS_BUFFER_OVERFLOW, "small list");
+    ASSERT_TRUE(count == TEST_SAMPLES, "required count %u", count);
+    ASSERT_TRUE(test_values[9] == 9000, "partial list");
+
+    count = TEST_SAMPLES;
+
+    ASSERT_TRUE(sai_history_query(history, index, TEST_SECOND * 1000 + 1, TEST_SECOND * 1100, &count, test_timestamps, test_values) == SAI_STATUS_SUCCESS, "query range");
+    ASSERT_TRUE(count == 100, "range count %u", count);
+    ASSERT_TRUE(test_timestamps[0] == TEST_SECOND * 1001 && test_values[99] == 1000 * 1099 + 1099 % 3, "range samples");
+
+    sai_history_close(history);
+}
+
+static void test_random_samples(void)
+{
+    uint64_t timestamp = 0;
+    sai_history_t *history;
+    uint32_t count = TEST_SAMPLES;
+    size_t index;
+    uint32_t idx;
+
+    history = test_open(0);
+    index = test_add_port_series(history);
+
+    /* jitter, counter clear and full width values take long varints */
+
+    for (idx = 0; idx < TEST_SAMPLES; idx++)
+    {
+        uint64_t value = test_random();
+
+        timestamp += 1 + test_random() % (idx % 2 ? TEST_SECOND : 100);
+
+        value = idx % 5 == 0 ? value << 20 : value;
+
+        test_timestamps[idx] = timestamp;
+        test_values[idx] = value;
+
+        ASSERT_TRUE(sai_history_append(history, index, timestamp, value) == SAI_STATUS_SUCCESS, "append %u", idx);
+    }
+
+    memset(test_timestamps, 0, sizeof(test_timestamps));
+    memset(test_values, 0, sizeof(test_values));
+
+    ASSERT_TRUE(sai_history_query(history, index, 0, UINT64_MAX, &count, test_timestamps, test_values) == SAI_STATUS_SUCCESS, "query all");
+    ASSERT_TRUE(count == TEST_SAMPLES, "count %u", count);
+
+    test_seed = 1;
+    timestamp = 0;
+
+    for (idx = 0; idx < TEST_SAMPLES; idx++)
+    {
+        uint64_t value = test_random();
+
+        timestamp += 1 + test_random() % (idx % 2 ? TEST_SECOND : 100);
+
+        value = idx % 5 == 0 ? value << 20 : value;
+
+        ASSERT_TRUE(test_timestamps[idx] == timestamp && test_values[idx] == value, "sample %u", idx);
+    }
+
+    sai_history_close(history);
+}
+
+static void test_rates(void)
+{
+    double rates[TEST_SAMPLES];
+    sai_history_t *history;
+    uint32_t count = TEST_SAMPLES;
+    size_t index;
+    uint32_t idx;
+
+    history = test_open(0);
+    index = test_add_port_series(history);
+
+    /* rate is 1000 per second, sample interval varies */
+
+    for (idx = 0; idx < 1000; idx++)
+    {
+        uint64_t timestamp = TEST_SECOND * idx + (idx % 4) * 1000;
+
+        ASSERT_TRUE(sai_history_append(history, index, timestamp, timestamp / 1000000) == SAI_STATUS_SUCCESS, "append %u", idx);
+    }
+
+    ASSERT_TRUE(sai_history_query_rates(history, index, TEST_SECOND * 10, TEST_SECOND * 900, &count, test_timestamps, rates) == SAI_STATUS_SUCCESS, "rates");
+    ASSERT_TRUE(count == 890, "rate count %u", count);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        ASSERT_TRUE(rates[idx] > 999.99 && rates[idx] < 1000.01, "rate %u: %f", idx, rates[idx]);
+        ASSERT_TRUE(test_timestamps[idx] / TEST_SECOND == idx + 11, "rate time %u", idx);
+    }
+
+    count = 1;
+
+    ASSERT_TRUE(sai_history_query_rates(history, index, 0, UINT64_MAX, &count, test_timestamps, rates) == SAI_STATUS_BUFFER_OVERFLOW, "small list");
+    ASSERT_TRUE(count == 999, "required count %u", count);
+
+    sai_history_close(history);
+}
+
+static void test_retention(void)
+{
+    sai_history_stats_t stats;
+    sai_history_t *history;
+    uint32_t count = TEST_SAMPLES;
+    size_t index;
+    uint32_t idx;
+
+    history = test_open(TEST_SECOND * 100);
+    index = test_add_port_series(history);
+
+    for (idx = 0; idx < 1000; idx++)
+    {
+        ASSERT_TRUE(sai_history_append(history, index, TEST_SECOND * (idx + 1), 7 * (uint64_t)idx) == SAI_STATUS_SUCCESS, "append %u", idx);
+    }
+
+    sai_history_get_stats(history, &stats);
+
+    ASSERT_TRUE(stats.dropped > 0 && stats.samples + stats.dropped == 1000, "dropped %lu", (unsigned long)stats.dropped);
+
+    ASSERT_TRUE(sai_history_query(history, index, 0, UINT64_MAX, &count, test_timestamps, test_values) == SAI_STATUS_SUCCESS, "query all");
+    ASSERT_TRUE(count == stats.samples, "count %u", count);
+    ASSERT_TRUE(test_timestamps[0] > TEST_SECOND && test_timestamps[0] <= TEST_SECOND * 900, "oldest %lu", (unsigned long)test_timestamps[0]);
+    ASSERT_TRUE(test_values[count - 1] == 7 * 999, "newest value");
+
+    sai_history_close(history);
+}
+
+static void test_export(void)
+{
+    sai_history_t *history;
+    uint64_t values[2];
+    size_t indexes[2];
+    char line[256];
+    FILE *file;
+    size_t index;
+
+    history = test_open(0);
+
+    ASSERT_TRUE(sai_history_add_series(history, SAI_OBJECT_TYPE_ROUTE_ENTRY, TEST_PORT_ID, 0, &index) == SAI_STATUS_INVALID_PARAMETER, "no stats");
+    ASSERT_TRUE(sai_history_add_series(history, SAI_OBJECT_TYPE_PORT, TEST_PORT_ID, 0x7fffffff, &index) == SAI_STATUS_INVALID_PARAMETER, "unknown stat");
+
+    indexes[0] = test_add_port_series(history);
+
+    ASSERT_TRUE(sai_history_add_series(history, SAI_OBJECT_TYPE_QUEUE, TEST_QUEUE_ID, SAI_QUEUE_STAT_BYTES, &indexes[1]) == SAI_STATUS_SUCCESS, "queue series");
+
+    values[0] = 10;
+    values[1] = 20;
+
+    ASSERT_TRUE(sai_history_append_list(history, 2, indexes, 100, values) == SAI_STATUS_SUCCESS, "append list");
+
+    values[0] = 15;
+    values[1] = 22;
+
+    ASSERT_TRUE(sai_history_append_list(history, 2, indexes, 200, values) == SAI_STATUS_SUCCESS, "append list");
+
+    ASSERT_TRUE(sai_history_export(history, TEST_FILE) == SAI_STATUS_SUCCESS, "export");
+
+    file = fopen(TEST_FILE, "r");
+
+    ASSERT_TRUE(file != NULL, "open export");
+
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "SAI_OBJECT_TYPE_PORT:oid:0x1000000000000:SAI_PORT_STAT_IF_IN_OCTETS\n") == 0, "port series: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "100 10\n") == 0, "port sample: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "200 15\n") == 0, "port sample: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "SAI_OBJECT_TYPE_QUEUE:oid:0x15000000000000:SAI_QUEUE_STAT_BYTES\n") == 0, "queue series: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "100 20\n") == 0, "queue sample: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) && strcmp(line, "200 22\n") == 0, "queue sample: %s", line);
+    ASSERT_TRUE(fgets(line, sizeof(line), file) == NULL, "end of export");
+
+    fclose(file);
+
+    unlink(TEST_FILE);
+
+    sai_history_close(history);
+}
+
+int main(void)
+{
+    test_compression();
+
+    test_random_samples();
+
+    test_rates();
+
+    test_retention();
+
+    test_export();
+
+    return 0;
+}
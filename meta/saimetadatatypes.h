@@ -918,6 +918,36 @@ typedef struct _sai_attr_capability_metadata_t
 
 } sai_attr_capability_metadata_t;
 
+/**
+ * @brief Defines capabilities of single vendor.
+ *
+ * Capabilities are indexed by object type in order of object type infos
+ * (extension object types start at SAI_OBJECT_TYPE_MAX), then by field index
+ * of object struct, so query does not search attribute metadata.
+ */
+typedef struct _sai_vendor_capability_metadata_t
+{
+    /**
+     * @brief Vendor ID.
+     */
+    uint64_t                                                    vendorid;
+
+    /**
+     * @brief Capabilities by object type and field index.
+     *
+     * Object type entry is NULL when vendor defines no capability for
+     * attributes of that object type, attribute entry is NULL when vendor
+     * defines no capability for that attribute.
+     */
+    const sai_attr_capability_metadata_t* const* const* const   objecttypes;
+
+    /**
+     * @brief Number of object type entries.
+     */
+    const size_t                                                objecttypescount;
+
+} sai_vendor_capability_metadata_t;
+
 /**
  * @brief Defines attribute metadata.
  */
@@ -1536,6 +1566,90 @@ typedef sai_status_t (*sai_generic_get_fn)(
         _In_ uint32_t attr_count,
         _Inout_ sai_attribute_t *attr_list);
 
+/**
+ * @brief Defines field of object struct.
+ *
+ * Object struct holds every attribute of object type as member of its
+ * native type, and presence bitmap. Index of field in fields array is its
+ * bit in presence bitmap. Field bytes are the same as bytes of attribute
+ * value union member, since all union members start at offset zero.
+ */
+typedef struct _sai_object_struct_field_t
+{
+    /**
+     * @brief Attribute metadata of field.
+     */
+    const sai_attr_metadata_t* const                    attrmetadata;
+
+    /**
+     * @brief Field offset from the struct beginning in bytes.
+     */
+    const size_t                                        offset;
+
+    /**
+     * @brief Field size in bytes.
+     */
+    const size_t                                        size;
+
+} sai_object_struct_field_t;
+
+/**
+ * @brief Function definition for getting field index of attribute.
+ *
+ * @param[in] attr_id Attribute id
+ *
+ * @return Field index or -1 if attribute is not field of object struct
+ */
+typedef int (*sai_meta_object_struct_field_index_fn)(
+        _In_ sai_attr_id_t attr_id);
+
+/**
+ * @brief Defines object struct of object type.
+ */
+typedef struct _sai_object_struct_info_t
+{
+    /**
+     * @brief Size of object struct in bytes.
+     */
+    const size_t                                        size;
+
+    /**
+     * @brief Offset of presence bitmap from the struct beginning in bytes.
+     */
+    const size_t                                        presentoffset;
+
+    /**
+     * @brief Fields in order of attribute ids.
+     */
+    const sai_object_struct_field_t* const              fields;
+
+    /**
+     * @brief Number of fields.
+     */
+    const size_t                                        fieldscount;
+
+    /**
+     * @brief Returns field index of attribute in constant time.
+     */
+    const sai_meta_object_struct_field_index_fn         fieldindex;
+
+} sai_object_struct_info_t;
+
+/**
+ * @brief Checks whether field of object struct is present.
+ */
+#define SAI_OBJECT_STRUCT_IS_PRESENT(s,field) ((((s)->present[(field) >> 3]) >> ((field) & 7)) & 1)
+
+/**
+ * @brief Marks field of object struct as present.
+ */
+#define SAI_OBJECT_STRUCT_SET_PRESENT(s,field) ((s)->present[(field) >> 3] = (uint8_t)((s)->present[(field) >> 3] | (1 << ((field) & 7))))
+
+/**
+ * @brief Marks field of object struct as not present.
+ */
+#define SAI_OBJECT_STRUCT_CLEAR_PRESENT(s,field) ((s)->present[(field) >> 3] = (uint8_t)((s)->present[(field) >> 3] & ~(1 << ((field) & 7))))
+
 /**
  * @brief SAI object type information
  */
@@ -1658,6 +1772,12 @@ typedef struct _sai_object_type_info_t
      */
     bool                                            iscustom;
 
+    /**
+     * @brief Object struct of object type, NULL if object type has no
+     * attributes.
+     */
+    const sai_object_struct_info_t* const           structinfo;
+
 } sai_object_type_info_t;
 
 /**
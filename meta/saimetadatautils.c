@@ -22,8 +22,13 @@
  * @brief   This module defines SAI Metadata Utils
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sai.h>
 #include "saimetadatautils.h"
 #include "saimetadata.h"
@@ -366,6 +371,39 @@ bool sai_metadata_is_object_type_valid(
     return sai_metadata_get_object_type_info(object_type) != NULL;
 }
 
+size_t sai_metadata_object_type_index(
+        _In_ sai_object_type_t object_type)
+{
+    if (object_type < SAI_OBJECT_TYPE_MAX)
+    {
+        return (size_t)object_type;
+    }
+
+    if (object_type >= (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START &&
+            object_type < (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END)
+    {
+        return (size_t)SAI_OBJECT_TYPE_MAX + (size_t)(object_type - (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START);
+    }
+
+    return (size_t)SAI_OBJECT_TYPE_NULL;
+}
+
+sai_object_type_t sai_metadata_object_type_from_index(
+        _In_ size_t index)
+{
+    if (index < (size_t)SAI_OBJECT_TYPE_MAX)
+    {
+        return (sai_object_type_t)index;
+    }
+
+    if (index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT)
+    {
+        return (sai_object_type_t)((size_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START + index - (size_t)SAI_OBJECT_TYPE_MAX);
+    }
+
+    return SAI_OBJECT_TYPE_NULL;
+}
+
 static bool sai_metadata_is_condition_value_eq(
         _In_ sai_attr_value_type_t attrvaluetype,
         _In_ const sai_attribute_value_t* cvalue,
@@ -614,3 +652,1464 @@ sai_api_version_t sai_metadata_query_api_version(void)
 {
     return SAI_API_VERSION;
 }
+
+uint32_t sai_metadata_get_attr_value_lists(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *value,
+        _Out_ size_t *offsets,
+        _Out_ size_t *element_sizes)
+{
+#define SAI_METADATA_LIST(member, type) \
+    offsets[n] = offsetof(sai_attribute_value_t, member); \
+    element_sizes[n] = sizeof(type); \
+    n++;
+
+    uint32_t n = 0;
+
+    if (metadata == NULL || value == NULL)
+    {
+        return 0;
+    }
+
+    switch (metadata->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            SAI_METADATA_LIST(objlist, sai_object_id_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            SAI_METADATA_LIST(u8list, uint8_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT8_LIST:
+            SAI_METADATA_LIST(s8list, int8_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            SAI_METADATA_LIST(u16list, uint16_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT16_LIST:
+            SAI_METADATA_LIST(s16list, int16_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            SAI_METADATA_LIST(u32list, uint32_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+            SAI_METADATA_LIST(s32list, int32_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_RANGE_LIST:
+            SAI_METADATA_LIST(u16rangelist, sai_u16_range_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_VLAN_LIST:
+            SAI_METADATA_LIST(vlanlist, sai_vlan_id_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
+            SAI_METADATA_LIST(qosmap, sai_qos_map_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_MAP_LIST:
+            SAI_METADATA_LIST(maplist, sai_map_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+
+            /* disabled field may carry uninitialized list pointers */
+
+            if (value->aclfield.enable)
+            {
+                SAI_METADATA_LIST(aclfield.data.objlist, sai_object_id_t);
+            }
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT8_LIST:
+
+            if (value->aclfield.enable)
+            {
+                SAI_METADATA_LIST(aclfield.mask.u8list, uint8_t);
+                SAI_METADATA_LIST(aclfield.data.u8list, uint8_t);
+            }
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+
+            if (value->aclaction.enable)
+            {
+                SAI_METADATA_LIST(aclaction.parameter.objlist, sai_object_id_t);
+            }
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
+            SAI_METADATA_LIST(aclcapability.action_list, int32_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
+            SAI_METADATA_LIST(aclresource, sai_acl_resource_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_TLV_LIST:
+            SAI_METADATA_LIST(tlvlist, sai_tlv_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SEGMENT_LIST:
+            SAI_METADATA_LIST(segmentlist, sai_ip6_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
+            SAI_METADATA_LIST(ipaddrlist, sai_ip_address_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_EYE_VALUES_LIST:
+            SAI_METADATA_LIST(porteyevalues, sai_port_lane_eye_values_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SYSTEM_PORT_CONFIG_LIST:
+            SAI_METADATA_LIST(sysportconfiglist, sai_system_port_config_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_ERR_STATUS_LIST:
+            SAI_METADATA_LIST(porterror, sai_port_err_status_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_LANE_LATCH_STATUS_LIST:
+            SAI_METADATA_LIST(portlanelatchstatuslist, sai_port_lane_latch_status_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_JSON:
+            SAI_METADATA_LIST(json.json, int8_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
+            SAI_METADATA_LIST(ipprefixlist, sai_ip_prefix_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CHAIN_LIST:
+            SAI_METADATA_LIST(aclchainlist, sai_acl_chain_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_FREQUENCY_OFFSET_PPM_LIST:
+            SAI_METADATA_LIST(portfrequencyoffsetppmlist, sai_port_frequency_offset_ppm_values_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_SNR_LIST:
+            SAI_METADATA_LIST(portsnrlist, sai_port_snr_values_t);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_PAM4_EYE_VALUES_LIST:
+            SAI_METADATA_LIST(portpam4eyevalues, sai_port_pam4_lane_eye_values_t);
+            break;
+
+        default:
+            break;
+    }
+
+    return n;
+
+#undef SAI_METADATA_LIST
+}
+
+static void sai_metadata_copy_ip_address(
+        _Out_ sai_ip_address_t *dst,
+        _In_ const sai_ip_address_t *src)
+{
+    dst->addr_family = src->addr_family;
+
+    if (src->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        dst->addr.ip4 = src->addr.ip4;
+    }
+    else
+    {
+        memcpy(dst->addr.ip6, src->addr.ip6, sizeof(sai_ip6_t));
+    }
+}
+
+void sai_metadata_normalize_object_meta_key(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Out_ sai_object_meta_key_t *key)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key->objecttype);
+    size_t idx;
+
+    memset(key, 0, sizeof(*key));
+
+    key->objecttype = meta_key->objecttype;
+
+    if (info == NULL || !info->isnonobjectid)
+    {
+        key->objectkey.key.object_id = meta_key->objectkey.key.object_id;
+        return;
+    }
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+        const uint8_t *src = (const uint8_t*)&meta_key->objectkey.key + m->offset;
+        uint8_t *dst = (uint8_t*)&key->objectkey.key + m->offset;
+
+        /* members may be unaligned inside packed entry, copy through locals */
+
+        if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_ADDRESS)
+        {
+            sai_ip_address_t s;
+            sai_ip_address_t d;
+
+            memcpy(&s, src, sizeof(s));
+            memset(&d, 0, sizeof(d));
+            sai_metadata_copy_ip_address(&d, &s);
+            memcpy(dst, &d, sizeof(d));
+        }
+        else if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_PREFIX)
+        {
+            sai_ip_prefix_t s;
+            sai_ip_prefix_t d;
+
+            memcpy(&s, src, sizeof(s));
+            memset(&d, 0, sizeof(d));
+
+            d.addr_family = s.addr_family;
+
+            if (s.addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+            {
+                d.addr.ip4 = s.addr.ip4;
+                d.mask.ip4 = s.mask.ip4;
+            }
+            else
+            {
+                memcpy(d.addr.ip6, s.addr.ip6, sizeof(sai_ip6_t));
+                memcpy(d.mask.ip6, s.mask.ip6, sizeof(sai_ip6_t));
+            }
+
+            memcpy(dst, &d, sizeof(d));
+        }
+        else if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_NAT_ENTRY_DATA)
+        {
+            sai_nat_entry_data_t s;
+            sai_nat_entry_data_t d;
+
+            memcpy(&s, src, sizeof(s));
+            memset(&d, 0, sizeof(d));
+
+            d.key.src_ip = s.key.src_ip;
+            d.key.dst_ip = s.key.dst_ip;
+            d.key.proto = s.key.proto;
+            d.key.l4_src_port = s.key.l4_src_port;
+            d.key.l4_dst_port = s.key.l4_dst_port;
+            d.mask.src_ip = s.mask.src_ip;
+            d.mask.dst_ip = s.mask.dst_ip;
+            d.mask.proto = s.mask.proto;
+            d.mask.l4_src_port = s.mask.l4_src_port;
+            d.mask.l4_dst_port = s.mask.l4_dst_port;
+
+            memcpy(dst, &d, sizeof(d));
+        }
+        else
+        {
+            memcpy(dst, src, m->size);
+        }
+    }
+}
+
+size_t sai_metadata_get_object_key_size(
+        _In_ sai_object_type_t object_type)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+    size_t size = 0;
+    size_t idx;
+
+    if (info == NULL || !info->isnonobjectid)
+    {
+        return sizeof(sai_object_id_t);
+    }
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (m->offset + m->size > size)
+        {
+            size = m->offset + m->size;
+        }
+    }
+
+    return size;
+}
+
+uint64_t sai_metadata_hash_mix(
+        _In_ uint64_t hash,
+        _In_ uint64_t word)
+{
+    word *= 0x87c37b91114253d5ULL;
+    word = (word << 31) | (word >> 33);
+    word *= 0x4cf5ad432745937fULL;
+
+    hash ^= word;
+    hash = (hash << 27) | (hash >> 37);
+
+    return hash * 5 + 0x52dce729;
+}
+
+uint64_t sai_metadata_hash_bytes(
+        _In_ uint64_t hash,
+        _In_ const void *data,
+        _In_ size_t size)
+{
+    const uint8_t *ptr = (const uint8_t*)data;
+    uint64_t word;
+
+    for (; size >= sizeof(word); ptr += sizeof(word), size -= sizeof(word))
+    {
+        memcpy(&word, ptr, sizeof(word));
+
+        hash = sai_metadata_hash_mix(hash, word);
+    }
+
+    if (size > 0)
+    {
+        /*
+         * Tail bytes are placed below top byte holding tail length one by
+         * one, memcpy would overwrite the length on big endian host.
+         * Length keeps trailing zero bytes from being lost.
+         */
+
+        word = (uint64_t)size << 56;
+
+        while (size-- > 0)
+        {
+            word |= (uint64_t)ptr[size] << (8 * size);
+        }
+
+        hash = sai_metadata_hash_mix(hash, word);
+    }
+
+    return hash;
+}
+
+uint64_t sai_metadata_hash_finalize(
+        _In_ uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+uint64_t sai_metadata_hash_mac(
+        _In_ uint64_t hash,
+        _In_ const sai_mac_t mac)
+{
+    return sai_metadata_hash_mix(hash,
+            (uint64_t)mac[0] |
+            ((uint64_t)mac[1] << 8) |
+            ((uint64_t)mac[2] << 16) |
+            ((uint64_t)mac[3] << 24) |
+            ((uint64_t)mac[4] << 32) |
+            ((uint64_t)mac[5] << 40));
+}
+
+uint64_t sai_metadata_hash_ip_address(
+        _In_ uint64_t hash,
+        _In_ const sai_ip_address_t *ip_address)
+{
+    if (ip_address->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        return sai_metadata_hash_mix(hash, (uint64_t)ip_address->addr.ip4);
+    }
+
+    hash = sai_metadata_hash_mix(hash, (uint64_t)(uint32_t)ip_address->addr_family << 32);
+
+    return sai_metadata_hash_bytes(hash, ip_address->addr.ip6, sizeof(sai_ip6_t));
+}
+
+uint64_t sai_metadata_hash_ip_prefix(
+        _In_ uint64_t hash,
+        _In_ const sai_ip_prefix_t *ip_prefix)
+{
+    if (ip_prefix->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        return sai_metadata_hash_mix(hash, (uint64_t)ip_prefix->addr.ip4 | ((uint64_t)ip_prefix->mask.ip4 << 32));
+    }
+
+    hash = sai_metadata_hash_mix(hash, (uint64_t)(uint32_t)ip_prefix->addr_family << 32);
+    hash = sai_metadata_hash_bytes(hash, ip_prefix->addr.ip6, sizeof(sai_ip6_t));
+
+    return sai_metadata_hash_bytes(hash, ip_prefix->mask.ip6, sizeof(sai_ip6_t));
+}
+
+uint64_t sai_metadata_hash_nat_entry_data(
+        _In_ uint64_t hash,
+        _In_ const sai_nat_entry_data_t *data)
+{
+    hash = sai_metadata_hash_mix(hash, (uint64_t)data->key.src_ip | ((uint64_t)data->key.dst_ip << 32));
+    hash = sai_metadata_hash_mix(hash,
+            (uint64_t)data->key.proto |
+            ((uint64_t)data->key.l4_src_port << 8) |
+            ((uint64_t)data->key.l4_dst_port << 24) |
+            ((uint64_t)data->mask.proto << 40) |
+            ((uint64_t)data->mask.l4_src_port << 48));
+    hash = sai_metadata_hash_mix(hash, (uint64_t)data->mask.src_ip | ((uint64_t)data->mask.dst_ip << 32));
+
+    return sai_metadata_hash_mix(hash, (uint64_t)data->mask.l4_dst_port);
+}
+
+bool sai_metadata_equal_ip_address(
+        _In_ const sai_ip_address_t *first,
+        _In_ const sai_ip_address_t *second)
+{
+    if (first->addr_family != second->addr_family)
+    {
+        return false;
+    }
+
+    if (first->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        return first->addr.ip4 == second->addr.ip4;
+    }
+
+    return memcmp(first->addr.ip6, second->addr.ip6, sizeof(sai_ip6_t)) == 0;
+}
+
+bool sai_metadata_equal_ip_prefix(
+        _In_ const sai_ip_prefix_t *first,
+        _In_ const sai_ip_prefix_t *second)
+{
+    if (first->addr_family != second->addr_family)
+    {
+        return false;
+    }
+
+    if (first->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        return first->addr.ip4 == second->addr.ip4 && first->mask.ip4 == second->mask.ip4;
+    }
+
+    return memcmp(first->addr.ip6, second->addr.ip6, sizeof(sai_ip6_t)) == 0 &&
+        memcmp(first->mask.ip6, second->mask.ip6, sizeof(sai_ip6_t)) == 0;
+}
+
+bool sai_metadata_equal_nat_entry_data(
+        _In_ const sai_nat_entry_data_t *first,
+        _In_ const sai_nat_entry_data_t *second)
+{
+    return first->key.src_ip == second->key.src_ip &&
+        first->key.dst_ip == second->key.dst_ip &&
+        first->key.proto == second->key.proto &&
+        first->key.l4_src_port == second->key.l4_src_port &&
+        first->key.l4_dst_port == second->key.l4_dst_port &&
+        first->mask.src_ip == second->mask.src_ip &&
+        first->mask.dst_ip == second->mask.dst_ip &&
+        first->mask.proto == second->mask.proto &&
+        first->mask.l4_src_port == second->mask.l4_src_port &&
+        first->mask.l4_dst_port == second->mask.l4_dst_port;
+}
+
+#define SAI_METADATA_COPY_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_METADATA_MAX_VALUE_LISTS 2
+
+typedef struct _sai_metadata_list_t
+{
+    uint32_t count;
+
+    void *list;
+
+} sai_metadata_list_t;
+
+static sai_metadata_list_t sai_metadata_list_get(
+        _In_ const sai_attribute_value_t *value,
+        _In_ size_t offset)
+{
+    sai_metadata_list_t list;
+
+    memcpy(&list, (const uint8_t*)value + offset, sizeof(list));
+
+    return list;
+}
+
+static void sai_metadata_list_set(
+        _Inout_ sai_attribute_value_t *value,
+        _In_ size_t offset,
+        _In_ const sai_metadata_list_t *list)
+{
+    memcpy((uint8_t*)value + offset, list, sizeof(*list));
+}
+
+sai_status_t sai_metadata_get_attribute_value_copy_size(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *value,
+        _Out_ size_t *size)
+{
+    size_t offsets[SAI_METADATA_MAX_VALUE_LISTS];
+    size_t sizes[SAI_METADATA_MAX_VALUE_LISTS];
+    uint32_t count = sai_metadata_get_attr_value_lists(metadata, value, offsets, sizes);
+    uint32_t idx;
+
+    *size = 0;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_metadata_list_t list = sai_metadata_list_get(value, offsets[idx]);
+
+        if (list.count != 0 && list.list == NULL)
+        {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        *size += SAI_METADATA_COPY_ALIGN((size_t)list.count * sizes[idx]);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Copies list contents of value to payload and points lists of value to
+ * the copy, payload is moved past copied contents.
+ */
+
+static sai_status_t sai_metadata_copy_value_lists(
+        _In_ const sai_attr_metadata_t *metadata,
+        _Inout_ sai_attribute_value_t *value,
+        _Inout_ uint8_t **payload)
+{
+    size_t offsets[SAI_METADATA_MAX_VALUE_LISTS];
+    size_t sizes[SAI_METADATA_MAX_VALUE_LISTS];
+    uint32_t count = sai_metadata_get_attr_value_lists(metadata, value, offsets, sizes);
+    uint32_t idx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_metadata_list_t list = sai_metadata_list_get(value, offsets[idx]);
+        size_t bytes = (size_t)list.count * sizes[idx];
+
+        if (list.count != 0 && list.list == NULL)
+        {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        if (bytes != 0)
+        {
+            memcpy(*payload, list.list, bytes);
+        }
+
+        /* empty list never points to source buffer */
+
+        list.list = (bytes != 0) ? *payload : NULL;
+
+        sai_metadata_list_set(value, offsets[idx], &list);
+
+        *payload += SAI_METADATA_COPY_ALIGN(bytes);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_deep_copy_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *src,
+        _Out_ sai_attribute_value_t *dst,
+        _Inout_ void *buffer)
+{
+    sai_attribute_value_t value = *src;
+    sai_status_t status;
+    uint8_t *block = NULL;
+    uint8_t *payload = (uint8_t*)buffer;
+    size_t size;
+
+    /* caller buffer was sized by caller, so size pass is done only here */
+
+    if (payload == NULL)
+    {
+        status = sai_metadata_get_attribute_value_copy_size(metadata, &value, &size);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (size != 0)
+        {
+            block = (uint8_t*)malloc(size);
+
+            if (block == NULL)
+            {
+                return SAI_STATUS_NO_MEMORY;
+            }
+        }
+
+        payload = block;
+    }
+
+    status = sai_metadata_copy_value_lists(metadata, &value, &payload);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        free(block);
+        return status;
+    }
+
+    *dst = value;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_metadata_free_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _Inout_ sai_attribute_value_t *value)
+{
+    size_t offsets[SAI_METADATA_MAX_VALUE_LISTS];
+    size_t sizes[SAI_METADATA_MAX_VALUE_LISTS];
+    void *block = NULL;
+    uint32_t count = sai_metadata_get_attr_value_lists(metadata, value, offsets, sizes);
+    uint32_t idx;
+
+    /* lists of copied value share single block, first non empty list starts it */
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_metadata_list_t list = sai_metadata_list_get(value, offsets[idx]);
+
+        if (block == NULL && list.count != 0)
+        {
+            block = list.list;
+        }
+
+        list.count = 0;
+        list.list = NULL;
+
+        sai_metadata_list_set(value, offsets[idx], &list);
+    }
+
+    free(block);
+}
+
+sai_status_t sai_metadata_get_attr_list_copy_size(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ size_t *size)
+{
+    uint32_t idx;
+
+    *size = SAI_METADATA_COPY_ALIGN(attr_count * sizeof(sai_attribute_t));
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+        size_t value_size;
+
+        if (sai_metadata_get_attribute_value_copy_size(md, &attr_list[idx].value, &value_size) != SAI_STATUS_SUCCESS)
+        {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+
+        *size += value_size;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_deep_copy_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Inout_ void *buffer,
+        _Inout_ sai_attribute_t **copy)
+{
+    sai_attribute_t *attrs = (sai_attribute_t*)buffer;
+    uint8_t *payload;
+    uint32_t idx;
+    size_t size;
+
+    *copy = NULL;
+
+    if (attr_count == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    /* caller buffer was sized by caller, so size pass is done only here */
+
+    if (attrs == NULL)
+    {
+        sai_status_t status = sai_metadata_get_attr_list_copy_size(object_type, attr_count, attr_list, &size);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        attrs = (sai_attribute_t*)malloc(size);
+
+        if (attrs == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+    }
+
+    payload = (uint8_t*)attrs + SAI_METADATA_COPY_ALIGN(attr_count * sizeof(sai_attribute_t));
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        attrs[idx] = attr_list[idx];
+
+        if (sai_metadata_copy_value_lists(md, &attrs[idx].value, &payload) != SAI_STATUS_SUCCESS)
+        {
+            if (attrs != buffer)
+            {
+                free(attrs);
+            }
+
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+    }
+
+    *copy = attrs;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static int sai_metadata_compare_uint64(
+        _In_ uint64_t first,
+        _In_ uint64_t second)
+{
+    return (first < second) ? -1 : (first > second);
+}
+
+static int sai_metadata_compare_int64(
+        _In_ int64_t first,
+        _In_ int64_t second)
+{
+    return (first < second) ? -1 : (first > second);
+}
+
+static int sai_metadata_compare_ip_address(
+        _In_ const sai_ip_address_t *first,
+        _In_ const sai_ip_address_t *second)
+{
+    if (first->addr_family != second->addr_family)
+    {
+        return sai_metadata_compare_int64(first->addr_family, second->addr_family);
+    }
+
+    if (first->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        return memcmp(&first->addr.ip4, &second->addr.ip4, sizeof(sai_ip4_t));
+    }
+
+    return memcmp(first->addr.ip6, second->addr.ip6, sizeof(sai_ip6_t));
+}
+
+static int sai_metadata_compare_ip_prefix(
+        _In_ const sai_ip_prefix_t *first,
+        _In_ const sai_ip_prefix_t *second)
+{
+    int ret;
+
+    if (first->addr_family != second->addr_family)
+    {
+        return sai_metadata_compare_int64(first->addr_family, second->addr_family);
+    }
+
+    if (first->addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        ret = memcmp(&first->addr.ip4, &second->addr.ip4, sizeof(sai_ip4_t));
+
+        return (ret != 0) ? ret : memcmp(&first->mask.ip4, &second->mask.ip4, sizeof(sai_ip4_t));
+    }
+
+    ret = memcmp(first->addr.ip6, second->addr.ip6, sizeof(sai_ip6_t));
+
+    return (ret != 0) ? ret : memcmp(first->mask.ip6, second->mask.ip6, sizeof(sai_ip6_t));
+}
+
+static int sai_metadata_compare_qos_map_params(
+        _In_ const sai_qos_map_params_t *first,
+        _In_ const sai_qos_map_params_t *second)
+{
+    sai_qos_map_params_t p1;
+    sai_qos_map_params_t p2;
+
+    /* copy members into zeroed params, so padding after color is zero */
+
+    memset(&p1, 0, sizeof(p1));
+    memset(&p2, 0, sizeof(p2));
+
+    p1.tc = first->tc;
+    p1.dscp = first->dscp;
+    p1.dot1p = first->dot1p;
+    p1.prio = first->prio;
+    p1.pg = first->pg;
+    p1.queue_index = first->queue_index;
+    p1.color = first->color;
+    p1.mpls_exp = first->mpls_exp;
+    p1.fc = first->fc;
+
+    p2.tc = second->tc;
+    p2.dscp = second->dscp;
+    p2.dot1p = second->dot1p;
+    p2.prio = second->prio;
+    p2.pg = second->pg;
+    p2.queue_index = second->queue_index;
+    p2.color = second->color;
+    p2.mpls_exp = second->mpls_exp;
+    p2.fc = second->fc;
+
+    return memcmp(&p1, &p2, sizeof(p1));
+}
+
+static int sai_metadata_compare_list(
+        _In_ sai_attr_value_type_t value_type,
+        _In_ const sai_metadata_list_t *first,
+        _In_ const sai_metadata_list_t *second,
+        _In_ size_t element_size)
+{
+    uint32_t idx;
+    int ret = 0;
+
+    if (first->count != second->count)
+    {
+        return sai_metadata_compare_uint64(first->count, second->count);
+    }
+
+    if (first->count == 0 || first->list == second->list)
+    {
+        return 0;
+    }
+
+    if (first->list == NULL || second->list == NULL)
+    {
+        return (first->list == NULL) ? -1 : 1;
+    }
+
+    /* elements holding IP addresses or padding are compared member by member */
+
+    for (idx = 0; idx < first->count && ret == 0; idx++)
+    {
+        switch (value_type)
+        {
+            case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
+                ret = sai_metadata_compare_ip_address((const sai_ip_address_t*)first->list + idx,
+                        (const sai_ip_address_t*)second->list + idx);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
+                ret = sai_metadata_compare_ip_prefix((const sai_ip_prefix_t*)first->list + idx,
+                        (const sai_ip_prefix_t*)second->list + idx);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
+                ret = sai_metadata_compare_qos_map_params(&((const sai_qos_map_t*)first->list)[idx].key,
+                        &((const sai_qos_map_t*)second->list)[idx].key);
+
+                if (ret == 0)
+                {
+                    ret = sai_metadata_compare_qos_map_params(&((const sai_qos_map_t*)first->list)[idx].value,
+                            &((const sai_qos_map_t*)second->list)[idx].value);
+                }
+                break;
+
+            default:
+                return memcmp(first->list, second->list, (size_t)first->count * element_size);
+        }
+    }
+
+    return ret;
+}
+
+/*
+ * Compares value members which are not list contents, list counts are
+ * compared together with contents.
+ */
+
+static int sai_metadata_compare_value_members(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *first,
+        _In_ const sai_attribute_value_t *second)
+{
+#define SAI_METADATA_COMPARE_MEMORY(member) \
+    return memcmp(&first->member, &second->member, sizeof(first->member))
+
+    const sai_acl_field_data_t *f1 = &first->aclfield;
+    const sai_acl_field_data_t *f2 = &second->aclfield;
+    const sai_acl_action_data_t *a1 = &first->aclaction;
+    const sai_acl_action_data_t *a2 = &second->aclaction;
+    sai_attr_value_type_t value_type = metadata->attrvaluetype;
+    int ret;
+
+    switch (value_type)
+    {
+        case SAI_ATTR_VALUE_TYPE_BOOL:
+            return sai_metadata_compare_int64(first->booldata, second->booldata);
+
+        case SAI_ATTR_VALUE_TYPE_CHARDATA:
+            return strncmp(first->chardata, second->chardata, sizeof(first->chardata));
+
+        case SAI_ATTR_VALUE_TYPE_UINT8:
+            return sai_metadata_compare_uint64(first->u8, second->u8);
+
+        case SAI_ATTR_VALUE_TYPE_INT8:
+            return sai_metadata_compare_int64(first->s8, second->s8);
+
+        case SAI_ATTR_VALUE_TYPE_UINT16:
+            return sai_metadata_compare_uint64(first->u16, second->u16);
+
+        case SAI_ATTR_VALUE_TYPE_INT16:
+            return sai_metadata_compare_int64(first->s16, second->s16);
+
+        case SAI_ATTR_VALUE_TYPE_UINT32:
+            return sai_metadata_compare_uint64(first->u32, second->u32);
+
+        case SAI_ATTR_VALUE_TYPE_INT32:
+            return sai_metadata_compare_int64(first->s32, second->s32);
+
+        case SAI_ATTR_VALUE_TYPE_UINT64:
+            return sai_metadata_compare_uint64(first->u64, second->u64);
+
+        case SAI_ATTR_VALUE_TYPE_INT64:
+            return sai_metadata_compare_int64(first->s64, second->s64);
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return sai_metadata_compare_uint64(first->oid, second->oid);
+
+        case SAI_ATTR_VALUE_TYPE_POINTER:
+            SAI_METADATA_COMPARE_MEMORY(ptr);
+
+        case SAI_ATTR_VALUE_TYPE_MAC:
+            SAI_METADATA_COMPARE_MEMORY(mac);
+
+        case SAI_ATTR_VALUE_TYPE_IPV4:
+            SAI_METADATA_COMPARE_MEMORY(ip4);
+
+        case SAI_ATTR_VALUE_TYPE_IPV6:
+            SAI_METADATA_COMPARE_MEMORY(ip6);
+
+        case SAI_ATTR_VALUE_TYPE_IP_ADDRESS:
+            return sai_metadata_compare_ip_address(&first->ipaddr, &second->ipaddr);
+
+        case SAI_ATTR_VALUE_TYPE_IP_PREFIX:
+            return sai_metadata_compare_ip_prefix(&first->ipprefix, &second->ipprefix);
+
+        case SAI_ATTR_VALUE_TYPE_PRBS_RX_STATE:
+
+            ret = sai_metadata_compare_int64(first->rx_state.rx_status, second->rx_state.rx_status);
+
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(first->rx_state.error_count, second->rx_state.error_count);
+
+        case SAI_ATTR_VALUE_TYPE_UINT32_RANGE:
+
+            ret = sai_metadata_compare_uint64(first->u32range.min, second->u32range.min);
+
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(first->u32range.max, second->u32range.max);
+
+        case SAI_ATTR_VALUE_TYPE_INT32_RANGE:
+
+            ret = sai_metadata_compare_int64(first->s32range.min, second->s32range.min);
+
+            return (ret != 0) ? ret : sai_metadata_compare_int64(first->s32range.max, second->s32range.max);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
+
+            ret = sai_metadata_compare_int64(first->aclcapability.is_action_list_mandatory,
+                    second->aclcapability.is_action_list_mandatory);
+
+            if (ret == 0)
+            {
+                ret = sai_metadata_compare_int64(first->aclcapability.supported_match_type,
+                        second->aclcapability.supported_match_type);
+            }
+
+            return (ret != 0) ? ret : sai_metadata_compare_int64(first->aclcapability.is_non_contiguous_bits_exact_match_supported,
+                    second->aclcapability.is_non_contiguous_bits_exact_match_supported);
+
+        case SAI_ATTR_VALUE_TYPE_TIMESPEC:
+
+            ret = sai_metadata_compare_uint64(first->timespec.tv_sec, second->timespec.tv_sec);
+
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(first->timespec.tv_nsec, second->timespec.tv_nsec);
+
+        case SAI_ATTR_VALUE_TYPE_ENCRYPT_KEY:
+            SAI_METADATA_COMPARE_MEMORY(encrypt_key);
+
+        case SAI_ATTR_VALUE_TYPE_AUTH_KEY:
+            SAI_METADATA_COMPARE_MEMORY(authkey);
+
+        case SAI_ATTR_VALUE_TYPE_MACSEC_SAK:
+            SAI_METADATA_COMPARE_MEMORY(macsecsak);
+
+        case SAI_ATTR_VALUE_TYPE_MACSEC_AUTH_KEY:
+            SAI_METADATA_COMPARE_MEMORY(macsecauthkey);
+
+        case SAI_ATTR_VALUE_TYPE_MACSEC_SALT:
+            SAI_METADATA_COMPARE_MEMORY(macsecsalt);
+
+        case SAI_ATTR_VALUE_TYPE_SYSTEM_PORT_CONFIG:
+            SAI_METADATA_COMPARE_MEMORY(sysportconfig);
+
+        case SAI_ATTR_VALUE_TYPE_FABRIC_PORT_REACHABILITY:
+
+            ret = sai_metadata_compare_uint64(first->reachability.switch_id, second->reachability.switch_id);
+
+            return (ret != 0) ? ret : sai_metadata_compare_int64(first->reachability.reachable, second->reachability.reachable);
+
+        case SAI_ATTR_VALUE_TYPE_LATCH_STATUS:
+
+            ret = sai_metadata_compare_int64(first->latchstatus.current_status, second->latchstatus.current_status);
+
+            return (ret != 0) ? ret : sai_metadata_compare_int64(first->latchstatus.changed, second->latchstatus.changed);
+
+        case SAI_ATTR_VALUE_TYPE_POE_PORT_POWER_CONSUMPTION:
+            SAI_METADATA_COMPARE_MEMORY(portpowerconsumption);
+
+        default:
+            break;
+    }
+
+    /* disabled ACL field or action carries no data */
+
+    if (metadata->isaclfield)
+    {
+        if (f1->enable != f2->enable || !f1->enable)
+        {
+            return sai_metadata_compare_int64(f1->enable, f2->enable);
+        }
+    }
+    else if (metadata->isaclaction)
+    {
+        if (a1->enable != a2->enable || !a1->enable)
+        {
+            return sai_metadata_compare_int64(a1->enable, a2->enable);
+        }
+    }
+
+    switch (value_type)
+    {
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_BOOL:
+            return sai_metadata_compare_int64(f1->data.booldata, f2->data.booldata);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT8:
+            ret = sai_metadata_compare_uint64(f1->data.u8, f2->data.u8);
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(f1->mask.u8, f2->mask.u8);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_INT8:
+            ret = sai_metadata_compare_int64(f1->data.s8, f2->data.s8);
+            return (ret != 0) ? ret : sai_metadata_compare_int64(f1->mask.s8, f2->mask.s8);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT16:
+            ret = sai_metadata_compare_uint64(f1->data.u16, f2->data.u16);
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(f1->mask.u16, f2->mask.u16);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_INT16:
+            ret = sai_metadata_compare_int64(f1->data.s16, f2->data.s16);
+            return (ret != 0) ? ret : sai_metadata_compare_int64(f1->mask.s16, f2->mask.s16);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT32:
+            ret = sai_metadata_compare_uint64(f1->data.u32, f2->data.u32);
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(f1->mask.u32, f2->mask.u32);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_INT32:
+            ret = sai_metadata_compare_int64(f1->data.s32, f2->data.s32);
+            return (ret != 0) ? ret : sai_metadata_compare_int64(f1->mask.s32, f2->mask.s32);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT64:
+            ret = sai_metadata_compare_uint64(f1->data.u64, f2->data.u64);
+            return (ret != 0) ? ret : sai_metadata_compare_uint64(f1->mask.u64, f2->mask.u64);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_MAC:
+            ret = memcmp(f1->data.mac, f2->data.mac, sizeof(sai_mac_t));
+            return (ret != 0) ? ret : memcmp(f1->mask.mac, f2->mask.mac, sizeof(sai_mac_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_IPV4:
+            ret = memcmp(&f1->data.ip4, &f2->data.ip4, sizeof(sai_ip4_t));
+            return (ret != 0) ? ret : memcmp(&f1->mask.ip4, &f2->mask.ip4, sizeof(sai_ip4_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_IPV6:
+            ret = memcmp(f1->data.ip6, f2->data.ip6, sizeof(sai_ip6_t));
+            return (ret != 0) ? ret : memcmp(f1->mask.ip6, f2->mask.ip6, sizeof(sai_ip6_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            return sai_metadata_compare_uint64(f1->data.oid, f2->data.oid);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_BOOL:
+            return sai_metadata_compare_int64(a1->parameter.booldata, a2->parameter.booldata);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_UINT8:
+            return sai_metadata_compare_uint64(a1->parameter.u8, a2->parameter.u8);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_INT8:
+            return sai_metadata_compare_int64(a1->parameter.s8, a2->parameter.s8);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_UINT16:
+            return sai_metadata_compare_uint64(a1->parameter.u16, a2->parameter.u16);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_INT16:
+            return sai_metadata_compare_int64(a1->parameter.s16, a2->parameter.s16);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_UINT32:
+            return sai_metadata_compare_uint64(a1->parameter.u32, a2->parameter.u32);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_INT32:
+            return sai_metadata_compare_int64(a1->parameter.s32, a2->parameter.s32);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_MAC:
+            return memcmp(a1->parameter.mac, a2->parameter.mac, sizeof(sai_mac_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_IPV4:
+            return memcmp(&a1->parameter.ip4, &a2->parameter.ip4, sizeof(sai_ip4_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_IPV6:
+            return memcmp(a1->parameter.ip6, a2->parameter.ip6, sizeof(sai_ip6_t));
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_IP_ADDRESS:
+            return sai_metadata_compare_ip_address(&a1->parameter.ipaddr, &a2->parameter.ipaddr);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            return sai_metadata_compare_uint64(a1->parameter.oid, a2->parameter.oid);
+
+        default:
+
+            /* list only values, lists are compared by caller */
+
+            return 0;
+    }
+
+#undef SAI_METADATA_COMPARE_MEMORY
+}
+
+int sai_metadata_compare_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *first,
+        _In_ const sai_attribute_value_t *second)
+{
+    size_t offsets[SAI_METADATA_MAX_VALUE_LISTS];
+    size_t sizes[SAI_METADATA_MAX_VALUE_LISTS];
+    uint32_t count;
+    uint32_t idx;
+    int ret;
+
+    if (metadata == NULL)
+    {
+        return memcmp(first, second, sizeof(sai_attribute_value_t));
+    }
+
+    ret = sai_metadata_compare_value_members(metadata, first, second);
+
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    /* members are equal, so both values carry the same lists */
+
+    count = sai_metadata_get_attr_value_lists(metadata, first, offsets, sizes);
+
+    for (idx = 0; idx < count && ret == 0; idx++)
+    {
+        sai_metadata_list_t l1 = sai_metadata_list_get(first, offsets[idx]);
+        sai_metadata_list_t l2 = sai_metadata_list_get(second, offsets[idx]);
+
+        ret = sai_metadata_compare_list(metadata->attrvaluetype, &l1, &l2, sizes[idx]);
+    }
+
+    return ret;
+}
+
+static const sai_object_struct_info_t* sai_metadata_get_object_struct_info(
+        _In_ sai_object_type_t object_type)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+    return (info == NULL) ? NULL : info->structinfo;
+}
+
+static int sai_metadata_object_struct_is_present(
+        _In_ const sai_object_struct_info_t *info,
+        _In_ const uint8_t *object_struct,
+        _In_ size_t index)
+{
+    const uint8_t *present = object_struct + info->presentoffset;
+
+    return (present[index >> 3] >> (index & 7)) & 1;
+}
+
+sai_status_t sai_metadata_object_struct_set_attr(
+        _In_ sai_object_type_t object_type,
+        _Inout_ void *object_struct,
+        _In_ const sai_attribute_t *attr)
+{
+    const sai_object_struct_info_t *info = sai_metadata_get_object_struct_info(object_type);
+    uint8_t *data = (uint8_t*)object_struct;
+    size_t index;
+    int field;
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    field = info->fieldindex(attr->id);
+
+    if (field < 0)
+    {
+        return SAI_STATUS_UNKNOWN_ATTRIBUTE_0;
+    }
+
+    index = (size_t)field;
+
+    memcpy(data + info->fields[index].offset, &attr->value, info->fields[index].size);
+
+    data[info->presentoffset + (index >> 3)] |= (uint8_t)(1 << (index & 7));
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_object_struct_get_attr(
+        _In_ sai_object_type_t object_type,
+        _In_ const void *object_struct,
+        _Inout_ sai_attribute_t *attr)
+{
+    const sai_object_struct_info_t *info = sai_metadata_get_object_struct_info(object_type);
+    const uint8_t *data = (const uint8_t*)object_struct;
+    size_t index;
+    int field;
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    field = info->fieldindex(attr->id);
+
+    if (field < 0)
+    {
+        return SAI_STATUS_UNKNOWN_ATTRIBUTE_0;
+    }
+
+    index = (size_t)field;
+
+    if (!sai_metadata_object_struct_is_present(info, data, index))
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    memset(&attr->value, 0, sizeof(attr->value));
+
+    memcpy(&attr->value, data + info->fields[index].offset, info->fields[index].size);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_object_struct_from_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Inout_ void *object_struct)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        sai_status_t status = sai_metadata_object_struct_set_attr(object_type, object_struct, &attr_list[idx]);
+
+        if (status == SAI_STATUS_UNKNOWN_ATTRIBUTE_0)
+        {
+            return SAI_STATUS_UNKNOWN_ATTRIBUTE_0 + SAI_STATUS_CODE((sai_status_t)idx);
+        }
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_object_struct_to_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ const void *object_struct,
+        _Inout_ uint32_t *attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_struct_info_t *info = sai_metadata_get_object_struct_info(object_type);
+    const uint8_t *data = (const uint8_t*)object_struct;
+    uint32_t count = 0;
+    size_t index;
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    for (index = 0; index < info->fieldscount; index++)
+    {
+        if (!sai_metadata_object_struct_is_present(info, data, index))
+        {
+            continue;
+        }
+
+        if (count < *attr_count)
+        {
+            attr_list[count].id = info->fields[index].attrmetadata->attrid;
+
+            memset(&attr_list[count].value, 0, sizeof(attr_list[count].value));
+
+            memcpy(&attr_list[count].value, data + info->fields[index].offset, info->fields[index].size);
+        }
+
+        count++;
+    }
+
+    if (count > *attr_count)
+    {
+        *attr_count = count;
+
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    *attr_count = count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_attr_capability_metadata_t* sai_metadata_get_attr_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id)
+{
+    const sai_vendor_capability_metadata_t *vc = NULL;
+    const sai_attr_capability_metadata_t* const *caps;
+    const sai_object_type_info_t *info;
+    size_t index;
+    size_t idx;
+    int field;
+
+    /* there are only few vendors */
+
+    for (idx = 0; sai_metadata_vendor_capabilities[idx] != NULL; idx++)
+    {
+        if (sai_metadata_vendor_capabilities[idx]->vendorid == vendor_id)
+        {
+            vc = sai_metadata_vendor_capabilities[idx];
+            break;
+        }
+    }
+
+    if (vc == NULL)
+    {
+        return NULL;
+    }
+
+    if (object_type < SAI_OBJECT_TYPE_MAX)
+    {
+        index = (size_t)object_type;
+    }
+    else if (object_type >= (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START &&
+            object_type < (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END)
+    {
+        index = (size_t)SAI_OBJECT_TYPE_MAX + (size_t)(object_type - (sai_object_type_t)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START);
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (index >= vc->objecttypescount || vc->objecttypes[index] == NULL)
+    {
+        return NULL;
+    }
+
+    caps = vc->objecttypes[index];
+
+    info = sai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL || info->structinfo == NULL)
+    {
+        return NULL;
+    }
+
+    field = info->structinfo->fieldindex(attr_id);
+
+    return (field < 0) ? NULL : caps[field];
+}
+
+sai_status_t sai_metadata_query_attribute_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability)
+{
+    const sai_attr_capability_metadata_t *cap = sai_metadata_get_attr_capability(vendor_id, object_type, attr_id);
+
+    if (attr_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (cap == NULL)
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    *attr_capability = cap->operationcapability;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_query_attribute_enum_values_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability)
+{
+    const sai_attr_capability_metadata_t *cap = sai_metadata_get_attr_capability(vendor_id, object_type, attr_id);
+    uint32_t count;
+
+    if (enum_values_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (cap == NULL || cap->enumvalues == NULL)
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    count = (uint32_t)cap->enumvaluescount;
+
+    if (enum_values_capability->count < count)
+    {
+        enum_values_capability->count = count;
+
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    if (count && enum_values_capability->list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memcpy(enum_values_capability->list, cap->enumvalues, count * sizeof(int32_t));
+
+    enum_values_capability->count = count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+uint64_t sai_metadata_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
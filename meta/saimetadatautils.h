@@ -171,6 +171,35 @@ extern bool sai_metadata_is_object_type_valid(
 extern bool sai_metadata_is_object_type_oid(
         _In_ sai_object_type_t object_type);
 
+/**
+ * @brief Number of object type indexes.
+ *
+ * Object types and extension object types map to dense indexes, so tables
+ * indexed by object type skip the gap before extensions range.
+ */
+#define SAI_METADATA_OBJECT_TYPE_INDEX_COUNT ((size_t)SAI_OBJECT_TYPE_MAX + (size_t)(SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END - SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START))
+
+/**
+ * @brief Get dense index of object type.
+ *
+ * @param[in] object_type Object type.
+ *
+ * @return Index less than #SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, index of
+ * SAI_OBJECT_TYPE_NULL (0) for object type out of range.
+ */
+extern size_t sai_metadata_object_type_index(
+        _In_ sai_object_type_t object_type);
+
+/**
+ * @brief Get object type of dense index.
+ *
+ * @param[in] index Index returned by sai_metadata_object_type_index.
+ *
+ * @return Object type, SAI_OBJECT_TYPE_NULL for index out of range.
+ */
+extern sai_object_type_t sai_metadata_object_type_from_index(
+        _In_ size_t index);
+
 /**
  * @brief Check if condition met.
  *
@@ -229,6 +258,439 @@ extern bool sai_metadata_is_validonly_met(
  */
 extern sai_api_version_t sai_metadata_query_api_version(void);
 
+/**
+ * @brief Get lists carried by attribute value.
+ *
+ * Every list inside attribute value has the same layout, 32 bit count
+ * followed by pointer to elements, so list is described by its offset
+ * inside value and size of single element. ACL field and action lists are
+ * reported only when field or action is enabled, disabled ones may carry
+ * uninitialized pointers.
+ *
+ * @param[in] metadata Attribute metadata.
+ * @param[in] value Attribute value.
+ * @param[out] offsets Offsets of lists inside value, at least 2 items.
+ * @param[out] element_sizes Sizes of list elements, at least 2 items.
+ *
+ * @return Number of lists in value, 0 for value without list or when
+ * metadata is NULL.
+ */
+extern uint32_t sai_metadata_get_attr_value_lists(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *value,
+        _Out_ size_t *offsets,
+        _Out_ size_t *element_sizes);
+
+/**
+ * @brief Normalize object meta key.
+ *
+ * Copies object type and key members into zeroed key, so padding, unused
+ * union bytes and bytes of IP address not belonging to its address family
+ * are zero and normalized keys can be hashed and compared as memory.
+ *
+ * @param[in] meta_key Object meta key.
+ * @param[out] key Normalized object meta key.
+ */
+extern void sai_metadata_normalize_object_meta_key(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Out_ sai_object_meta_key_t *key);
+
+/**
+ * @brief Get object key size.
+ *
+ * @param[in] object_type Object type.
+ *
+ * @return Number of leading bytes of normalized object key which carry key
+ * members, size of object id for object id types and unknown types.
+ */
+extern size_t sai_metadata_get_object_key_size(
+        _In_ sai_object_type_t object_type);
+
+/**
+ * @brief Mix 64 bit word into hash.
+ *
+ * Building block of generated sai_metadata_hash_* functions, which mix key
+ * members one by one, so padding between members never affects the hash.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] word Word to mix in.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_mix(
+        _In_ uint64_t hash,
+        _In_ uint64_t word);
+
+/**
+ * @brief Mix bytes into hash.
+ *
+ * Bytes are mixed in 64 bit words, only for members without padding, like
+ * IPv6 address.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] data Bytes.
+ * @param[in] size Number of bytes.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_bytes(
+        _In_ uint64_t hash,
+        _In_ const void *data,
+        _In_ size_t size);
+
+/**
+ * @brief Finalize hash.
+ *
+ * Spreads every input bit over the whole hash, so low bits can be used as
+ * hash table index.
+ *
+ * @param[in] hash Hash to finalize.
+ *
+ * @return Final hash.
+ */
+extern uint64_t sai_metadata_hash_finalize(
+        _In_ uint64_t hash);
+
+/**
+ * @brief Mix MAC address into hash.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] mac MAC address.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_mac(
+        _In_ uint64_t hash,
+        _In_ const sai_mac_t mac);
+
+/**
+ * @brief Mix IP address into hash.
+ *
+ * Only bytes of address family are used.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] ip_address IP address.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_ip_address(
+        _In_ uint64_t hash,
+        _In_ const sai_ip_address_t *ip_address);
+
+/**
+ * @brief Mix IP prefix into hash.
+ *
+ * Only bytes of address family are used.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] ip_prefix IP prefix.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_ip_prefix(
+        _In_ uint64_t hash,
+        _In_ const sai_ip_prefix_t *ip_prefix);
+
+/**
+ * @brief Mix NAT entry data into hash.
+ *
+ * @param[in] hash Hash so far.
+ * @param[in] data NAT entry data.
+ *
+ * @return New hash, not finalized.
+ */
+extern uint64_t sai_metadata_hash_nat_entry_data(
+        _In_ uint64_t hash,
+        _In_ const sai_nat_entry_data_t *data);
+
+/**
+ * @brief Compare IP addresses.
+ *
+ * @param[in] first IP address.
+ * @param[in] second IP address.
+ *
+ * @return True when address family and its bytes are equal.
+ */
+extern bool sai_metadata_equal_ip_address(
+        _In_ const sai_ip_address_t *first,
+        _In_ const sai_ip_address_t *second);
+
+/**
+ * @brief Compare IP prefixes.
+ *
+ * @param[in] first IP prefix.
+ * @param[in] second IP prefix.
+ *
+ * @return True when address family, address and mask bytes are equal.
+ */
+extern bool sai_metadata_equal_ip_prefix(
+        _In_ const sai_ip_prefix_t *first,
+        _In_ const sai_ip_prefix_t *second);
+
+/**
+ * @brief Compare NAT entry data member by member.
+ *
+ * @param[in] first NAT entry data.
+ * @param[in] second NAT entry data.
+ *
+ * @return True when all members are equal.
+ */
+extern bool sai_metadata_equal_nat_entry_data(
+        _In_ const sai_nat_entry_data_t *first,
+        _In_ const sai_nat_entry_data_t *second);
+
+/**
+ * @brief Get size of attribute value list contents copy.
+ *
+ * @param[in] metadata Attribute metadata.
+ * @param[in] value Attribute value.
+ * @param[out] size Number of bytes needed for list contents of value copy.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER when
+ * list with non zero count has NULL pointer.
+ */
+extern sai_status_t sai_metadata_get_attribute_value_copy_size(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *value,
+        _Out_ size_t *size);
+
+/**
+ * @brief Deep copy attribute value.
+ *
+ * Value is copied with contents of all its lists (object lists, integer
+ * lists, ACL field mask and data, QOS maps...), list elements never hold
+ * pointers. Empty lists of copy are NULL. When buffer is NULL, list
+ * contents are allocated in single block released by
+ * sai_metadata_free_attribute_value, otherwise they are written into 8 byte
+ * aligned buffer (like caller arena) of size returned by successful
+ * sai_metadata_get_attribute_value_copy_size.
+ *
+ * @param[in] metadata Attribute metadata.
+ * @param[in] src Source value.
+ * @param[out] dst Destination value, may be the same as source.
+ * @param[inout] buffer Optional destination of list contents.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error.
+ */
+extern sai_status_t sai_metadata_deep_copy_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *src,
+        _Out_ sai_attribute_value_t *dst,
+        _Inout_ void *buffer);
+
+/**
+ * @brief Free attribute value copied without buffer.
+ *
+ * Lists of value are emptied.
+ *
+ * @param[in] metadata Attribute metadata.
+ * @param[inout] value Value created by sai_metadata_deep_copy_attribute_value.
+ */
+extern void sai_metadata_free_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _Inout_ sai_attribute_value_t *value);
+
+/**
+ * @brief Compare attribute values.
+ *
+ * Only members valid for attribute value type are compared: IP addresses
+ * and prefixes by bytes of address family, ACL field and action data only
+ * when enabled, lists by count and contents. Padding inside list elements
+ * with IP addresses or QOS map parameters is never compared, other list
+ * elements are compared as memory.
+ *
+ * @param[in] metadata Attribute metadata, when NULL values are compared as
+ * memory.
+ * @param[in] first Attribute value.
+ * @param[in] second Attribute value.
+ *
+ * @return Less than, equal to or greater than zero when first value is less
+ * than, equal to or greater than second one, order is stable across calls.
+ */
+extern int sai_metadata_compare_attribute_value(
+        _In_ const sai_attr_metadata_t *metadata,
+        _In_ const sai_attribute_value_t *first,
+        _In_ const sai_attribute_value_t *second);
+
+/**
+ * @brief Get size of attribute list deep copy.
+ *
+ * @param[in] object_type Object type.
+ * @param[in] attr_count Number of attributes.
+ * @param[in] attr_list Attribute list.
+ * @param[out] size Number of bytes needed for attributes and their lists.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_ATTR_VALUE_0
+ * plus index when list with non zero count has NULL pointer.
+ */
+extern sai_status_t sai_metadata_get_attr_list_copy_size(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ size_t *size);
+
+/**
+ * @brief Deep copy attribute list into single block.
+ *
+ * Attributes are followed by contents of their lists. When buffer is NULL
+ * block is allocated and must be released by free(), otherwise copy is
+ * written into 8 byte aligned buffer of size returned by successful
+ * sai_metadata_get_attr_list_copy_size.
+ *
+ * @param[in] object_type Object type.
+ * @param[in] attr_count Number of attributes.
+ * @param[in] attr_list Attribute list.
+ * @param[inout] buffer Optional destination buffer.
+ * @param[out] copy Copied attributes, NULL when attr_count is 0.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error.
+ */
+extern sai_status_t sai_metadata_deep_copy_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Inout_ void *buffer,
+        _Inout_ sai_attribute_t **copy);
+
+/**
+ * @brief Sets field of object struct from attribute.
+ *
+ * Object struct is sai_object_struct_<object type>_t. Field is marked as
+ * present. Lists are copied as they are, so they point to memory of the
+ * attribute.
+ *
+ * @param[in] object_type Object type.
+ * @param[inout] object_struct Object struct.
+ * @param[in] attr Attribute.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_UNKNOWN_ATTRIBUTE_0
+ * when attribute does not belong to object type.
+ */
+extern sai_status_t sai_metadata_object_struct_set_attr(
+        _In_ sai_object_type_t object_type,
+        _Inout_ void *object_struct,
+        _In_ const sai_attribute_t *attr);
+
+/**
+ * @brief Gets attribute value from field of object struct.
+ *
+ * @param[in] object_type Object type.
+ * @param[in] object_struct Object struct.
+ * @param[inout] attr Attribute, id is input.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_NOT_FOUND when
+ * field is not present.
+ */
+extern sai_status_t sai_metadata_object_struct_get_attr(
+        _In_ sai_object_type_t object_type,
+        _In_ const void *object_struct,
+        _Inout_ sai_attribute_t *attr);
+
+/**
+ * @brief Sets fields of object struct from attribute list.
+ *
+ * Fields of attributes not in the list are not changed, so object struct
+ * should be zeroed before the first call.
+ *
+ * @param[in] object_type Object type.
+ * @param[in] attr_count Number of attributes.
+ * @param[in] attr_list Attribute list.
+ * @param[inout] object_struct Object struct.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_UNKNOWN_ATTRIBUTE_0
+ * plus index of attribute which does not belong to object type.
+ */
+extern sai_status_t sai_metadata_object_struct_from_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Inout_ void *object_struct);
+
+/**
+ * @brief Converts present fields of object struct to attribute list.
+ *
+ * Attributes are in order of attribute ids.
+ *
+ * @param[in] object_type Object type.
+ * @param[in] object_struct Object struct.
+ * @param[inout] attr_count Attribute list size on input, number of present
+ * fields on output.
+ * @param[inout] attr_list Attribute list.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * list is too small.
+ */
+extern sai_status_t sai_metadata_object_struct_to_attr_list(
+        _In_ sai_object_type_t object_type,
+        _In_ const void *object_struct,
+        _Inout_ uint32_t *attr_count,
+        _Inout_ sai_attribute_t *attr_list);
+
+/**
+ * @brief Gets capability of attribute from capability files.
+ *
+ * Capability is found by vendor, object type and field index of object
+ * struct, so lookup does not depend on number of attributes.
+ *
+ * @param[in] vendor_id Vendor ID.
+ * @param[in] object_type Object type.
+ * @param[in] attr_id Attribute ID.
+ *
+ * @return Capability or NULL when capability files do not define it.
+ */
+extern const sai_attr_capability_metadata_t* sai_metadata_get_attr_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id);
+
+/**
+ * @brief Query attribute capability from capability files.
+ *
+ * Same as sai_query_attribute_capability, but answered from generated
+ * table. Vendor should be queried only when capability is not found.
+ *
+ * @param[in] vendor_id Vendor ID.
+ * @param[in] object_type Object type.
+ * @param[in] attr_id Attribute ID.
+ * @param[out] attr_capability Capability.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_NOT_FOUND when
+ * capability files do not define capability.
+ */
+extern sai_status_t sai_metadata_query_attribute_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t *attr_capability);
+
+/**
+ * @brief Query attribute enum values capability from capability files.
+ *
+ * Same as sai_query_attribute_enum_values_capability, but answered from
+ * generated table.
+ *
+ * @param[in] vendor_id Vendor ID.
+ * @param[in] object_type Object type.
+ * @param[in] attr_id Attribute ID.
+ * @param[inout] enum_values_capability List of supported enum values.
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * list is too small, #SAI_STATUS_ITEM_NOT_FOUND when capability files do not
+ * define enum values capability.
+ */
+extern sai_status_t sai_metadata_query_attribute_enum_values_capability(
+        _In_ uint64_t vendor_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t *enum_values_capability);
+
+/**
+ * @brief Get monotonic time.
+ *
+ * @return Time in nanoseconds since unspecified point.
+ */
+extern uint64_t sai_metadata_now(void);
+
 /**
  * @}
  */
@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimock.h
+ *
+ * @brief   This module defines SAI mock library
+ */
+
+#ifndef __SAIMOCK_H_
+#define __SAIMOCK_H_
+
+/**
+ * @defgroup SAIMOCK SAI - Mock library
+ *
+ * Library libsai.so built from generated saimock.c serves every method table
+ * from sai_api_query() and keeps created objects and their attributes in
+ * memory, in open addressing table per object type keyed by object id or
+ * entry struct. Object ids encode object type and switch index. Create and
+ * set are validated against attribute metadata (unknown, read only, create
+ * only, repeated and missing mandatory attributes, enum values and object
+ * references) and get returns default value of attribute which was not
+ * set. Switch create also creates objects which real switch creates itself:
+ * CPU port, ports with queues, default virtual router and default VLAN,
+ * returned by read only switch and port attributes, and switch remove
+ * removes all objects of the switch. Each object type has its own lock,
+ * calls on different object types run in parallel. Latency, bulk cost and
+ * failures of calls are injected according to configuration file, so
+ * application batching and retry logic can be exercised without hardware.
+ * Random decisions use single seeded generator, so single threaded sequence
+ * of calls behaves the same on every run.
+ *
+ * Configuration file has one rule per line, '#' starts comment. Later rule
+ * overrides earlier one for the same operation and object type.
+ *
+ *    seed <number>
+ *    latency <op> <target> fixed <time>
+ *    latency <op> <target> uniform <min> <max>
+ *    latency <op> <target> normal <mean> <stddev>
+ *    latency <op> <target> exponential <mean>
+ *    bulk <op> <target> <base time> <time per object>
+ *    fail <op> <target> <probability> [status]
+ *    limit <target> <count>
+ *    ports <count> [queues per port]
+ *
+ * Operation is create, remove, set, get, stats, other or '*'. Target is
+ * object type or API name, full or short and case insensitive (route_entry,
+ * SAI_API_ROUTE), or '*'. Object type wins when name is both. Time is
+ * number with ns, us, ms or s suffix, nanoseconds by default. Bulk call
+ * costs base time plus time per object when bulk rule matches, otherwise
+ * sum of single call latencies. Failure probability applies to each object
+ * of bulk call, default failure status is SAI_STATUS_FAILURE. Create beyond
+ * limit fails with SAI_STATUS_TABLE_FULL. Ports sets number of ports and
+ * queues created with switch, at most 256 queues per port.
+ *
+ * @{
+ */
+
+/**
+ * @brief Environment variable and profile key with configuration file path
+ */
+#define SAI_MOCK_ENV_CONFIG             "SAI_MOCK_CONFIG"
+
+/**
+ * @brief Maximum number of switches
+ */
+#define SAI_MOCK_MAX_SWITCHES           256
+
+/**
+ * @brief Default number of ports created with switch, CPU port excluded
+ */
+#define SAI_MOCK_DEFAULT_PORT_NUMBER    32
+
+/**
+ * @brief Default number of queues created with each port
+ */
+#define SAI_MOCK_DEFAULT_QUEUE_NUMBER   8
+
+/**
+ * @brief Get mock method table
+ *
+ * @param[in] api SAI API
+ * @param[out] api_method_table Method table
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_NOT_SUPPORTED if API
+ * is unknown
+ */
+extern sai_status_t sai_mock_api_query(
+        _In_ sai_api_t api,
+        _Out_ void **api_method_table);
+
+/**
+ * @brief Get API whose method table manages object type
+ *
+ * @param[in] object_type Object type
+ *
+ * @return #SAI_API_UNSPECIFIED when object type has no method table,
+ * otherwise API of the table
+ */
+extern sai_api_t sai_mock_object_type_api(
+        _In_ sai_object_type_t object_type);
+
+/**
+ * @brief Load configuration file, replaces current configuration
+ *
+ * @param[in] path Configuration file path, NULL resets configuration
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_load_config(
+        _In_ const char *path);
+
+/**
+ * @brief Create object
+ *
+ * @param[inout] meta_key Object type and key, object id is set on success
+ * @param[in] switch_id Switch id, ignored for switch and entries
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_create(
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list);
+
+/**
+ * @brief Remove object
+ *
+ * @param[in] meta_key Object type and key
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_remove(
+        _In_ const sai_object_meta_key_t *meta_key);
+
+/**
+ * @brief Set object attribute
+ *
+ * @param[in] meta_key Object type and key
+ * @param[in] attr Attribute
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_set(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr);
+
+/**
+ * @brief Get object attributes
+ *
+ * @param[in] meta_key Object type and key
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_get(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list);
+
+/**
+ * @brief Create objects
+ *
+ * @param[in] switch_id Switch id, ignored for entries
+ * @param[in] object_count Number of objects
+ * @param[inout] meta_key Object types and keys, object ids are set
+ * @param[in] attr_count Number of attributes of each object
+ * @param[in] attr_list Attributes of each object
+ * @param[in] mode Bulk operation error handling mode
+ * @param[out] object_statuses Status of each object
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_mock_bulk_create(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t object_count,
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses);
+
+/**
+ * @brief Remove objects
+ *
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys
+ * @param[in] mode Bulk operation error handling mode
+ * @param[out] object_statuses Status of each object
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_mock_bulk_remove(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses);
+
+/**
+ * @brief Set single attribute of each object
+ *
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys
+ * @param[in] attr_list Attribute of each object
+ * @param[in] mode Bulk operation error handling mode
+ * @param[out] object_statuses Status of each object
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_mock_bulk_set(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses);
+
+/**
+ * @brief Get attributes of each object
+ *
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys
+ * @param[in] attr_count Number of attributes of each object
+ * @param[inout] attr_list Attributes of each object
+ * @param[in] mode Bulk operation error handling mode
+ * @param[out] object_statuses Status of each object
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects succeeded,
+ * #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_mock_bulk_get(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _Inout_ sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses);
+
+/**
+ * @brief Get or clear statistics, all counters are zero
+ *
+ * @param[in] object_type Object type
+ * @param[in] number_of_counters Number of counters, 0 for clear
+ * @param[out] counters Counter values
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_mock_stats(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t number_of_counters,
+        _Out_ uint64_t *counters);
+
+/**
+ * @brief Method without mock implementation
+ *
+ * Latency and failures are injected as for any other call.
+ *
+ * @param[in] object_type Object type or SAI_OBJECT_TYPE_NULL
+ *
+ * @return Injected failure or #SAI_STATUS_NOT_IMPLEMENTED
+ */
+extern sai_status_t sai_mock_other(
+        _In_ sai_object_type_t object_type);
+
+/**
+ * @brief Write number of objects and calls per object type
+ *
+ * @param[inout] file Output stream
+ */
+extern void sai_mock_dump(
+        _Inout_ FILE *file);
+
+/**
+ * @}
+ */
+#endif /** __SAIMOCK_H_ */
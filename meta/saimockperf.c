@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimockperf.c
+ *
+ * @brief   This module defines SAI mock library store benchmark
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saimock.h"
+
+#define PERF_ROUTES 1000000
+
+#define PERF_BULK 1000
+
+/*
+ * Measures cost of store operations without injected latency, route entries
+ * exercise hashing of entry keys and validation of referenced objects.
+ */
+
+static sai_route_api_t *perf_route_api;
+
+static sai_route_entry_t *perf_routes;
+
+static void perf_report(
+        _In_ const char *name,
+        _In_ uint64_t start,
+        _In_ uint32_t failed)
+{
+    uint64_t elapsed = sai_metadata_now() - start;
+
+    printf("%-32s %8.1f ns/op %8.2f Mops/s %8u failed\n",
+            name,
+            (double)elapsed / PERF_ROUTES,
+            (double)PERF_ROUTES * 1000.0 / (double)elapsed,
+            failed);
+}
+
+static void perf_single()
+{
+    sai_attribute_t attr;
+    uint64_t start;
+    uint32_t failed;
+    uint32_t idx;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx++)
+    {
+        failed += (perf_route_api->create_route_entry(&perf_routes[idx], 1, &attr) != SAI_STATUS_SUCCESS);
+    }
+
+    perf_report("create", start, failed);
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx++)
+    {
+        failed += (perf_route_api->get_route_entry_attribute(&perf_routes[idx], 1, &attr) != SAI_STATUS_SUCCESS);
+    }
+
+    perf_report("get", start, failed);
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx++)
+    {
+        failed += (perf_route_api->set_route_entry_attribute(&perf_routes[idx], &attr) != SAI_STATUS_SUCCESS);
+    }
+
+    perf_report("set", start, failed);
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx++)
+    {
+        failed += (perf_route_api->remove_route_entry(&perf_routes[idx]) != SAI_STATUS_SUCCESS);
+    }
+
+    perf_report("remove", start, failed);
+}
+
+static void perf_bulk()
+{
+    static uint32_t attr_count[PERF_BULK];
+    static const sai_attribute_t *attr_list[PERF_BULK];
+    static sai_status_t statuses[PERF_BULK];
+    sai_attribute_t attr;
+    uint64_t start;
+    uint32_t failed;
+    uint32_t idx;
+    uint32_t n;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    for (n = 0; n < PERF_BULK; n++)
+    {
+        attr_count[n] = 1;
+        attr_list[n] = &attr;
+    }
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx += PERF_BULK)
+    {
+        perf_route_api->create_route_entries(PERF_BULK, &perf_routes[idx], attr_count, attr_list,
+                SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, statuses);
+
+        for (n = 0; n < PERF_BULK; n++)
+        {
+            failed += (statuses[n] != SAI_STATUS_SUCCESS);
+        }
+    }
+
+    perf_report("bulk create", start, failed);
+
+    failed = 0;
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_ROUTES; idx += PERF_BULK)
+    {
+        perf_route_api->remove_route_entries(PERF_BULK, &perf_routes[idx], SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, statuses);
+
+        for (n = 0; n < PERF_BULK; n++)
+        {
+            failed += (statuses[n] != SAI_STATUS_SUCCESS);
+        }
+    }
+
+    perf_report("bulk remove", start, failed);
+}
+
+int main()
+{
+    sai_switch_api_t *switch_api;
+    sai_virtual_router_api_t *virtual_router_api;
+    sai_object_id_t switch_id;
+    sai_object_id_t vr_id;
+    sai_attribute_t attr;
+    uint32_t idx;
+
+    if (sai_api_initialize(0, NULL) != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "failed to initialize\n");
+        return 1;
+    }
+
+    sai_api_query(SAI_API_SWITCH, (void**)&switch_api);
+    sai_api_query(SAI_API_VIRTUAL_ROUTER, (void**)&virtual_router_api);
+    sai_api_query(SAI_API_ROUTE, (void**)&perf_route_api);
+
+    attr.id = SAI_SWITCH_ATTR_INIT_SWITCH;
+    attr.value.booldata = true;
+
+    if (switch_api->create_switch(&switch_id, 1, &attr) != SAI_STATUS_SUCCESS ||
+            virtual_router_api->create_virtual_router(&vr_id, switch_id, 0, NULL) != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "failed to create switch\n");
+        return 1;
+    }
+
+    perf_routes = (sai_route_entry_t*)calloc(PERF_ROUTES, sizeof(sai_route_entry_t));
+
+    if (perf_routes == NULL)
+    {
+        fprintf(stderr, "failed to allocate routes\n");
+        return 1;
+    }
+
+    for (idx = 0; idx < PERF_ROUTES; idx++)
+    {
+        perf_routes[idx].switch_id = switch_id;
+        perf_routes[idx].vr_id = vr_id;
+        perf_routes[idx].destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        perf_routes[idx].destination.addr.ip4 = htonl(0x0a000000 | idx);
+        perf_routes[idx].destination.mask.ip4 = htonl(0xffffffff);
+    }
+
+    perf_single();
+
+    perf_bulk();
+
+    free(perf_routes);
+
+    sai_api_uninitialize();
+
+    return 0;
+}
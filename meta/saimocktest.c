@@ -0,0 +1,679 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimocktest.c
+ *
+ * @brief   This module defines SAI Mock Library Test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saimock.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_CONFIG "saimocktest.cfg"
+
+#define TEST_ROUTES 100
+
+#define TEST_THREADS 4
+
+static const char* test_profile_get_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    if (strcmp(variable, SAI_MOCK_ENV_CONFIG) == 0)
+    {
+        return TEST_CONFIG;
+    }
+
+    return NULL;
+}
+
+static int test_profile_get_next_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _Out_ const char **variable,
+        _Out_ const char **value)
+{
+    return -1;
+}
+
+static const sai_service_method_table_t test_services = {
+    test_profile_get_value,
+    test_profile_get_next_value
+};
+
+static void test_init(
+        _In_ const char *config)
+{
+    FILE *file = fopen(TEST_CONFIG, "w");
+
+    ASSERT_TRUE(file != NULL, "failed to create config");
+
+    fputs(config, file);
+    fclose(file);
+
+    ASSERT_TRUE(sai_api_initialize(0, &test_services) == SAI_STATUS_SUCCESS, "initialize failed");
+
+    unlink(TEST_CONFIG);
+}
+
+static sai_object_id_t test_create_switch(
+        _In_ const sai_switch_api_t *switch_api)
+{
+    sai_object_id_t switch_id;
+    sai_attribute_t attr;
+
+    attr.id = SAI_SWITCH_ATTR_INIT_SWITCH;
+    attr.value.booldata = true;
+
+    ASSERT_TRUE(switch_api->create_switch(&switch_id, 1, &attr) == SAI_STATUS_SUCCESS, "create switch failed");
+
+    ASSERT_TRUE(sai_object_type_query(switch_id) == SAI_OBJECT_TYPE_SWITCH, "wrong switch object type");
+
+    return switch_id;
+}
+
+static sai_object_id_t test_create_virtual_router(
+        _In_ sai_object_id_t switch_id)
+{
+    sai_virtual_router_api_t *virtual_router_api;
+    sai_object_id_t vr_id;
+
+    ASSERT_TRUE(sai_api_query(SAI_API_VIRTUAL_ROUTER, (void**)&virtual_router_api) == SAI_STATUS_SUCCESS, "virtual router api");
+
+    ASSERT_TRUE(virtual_router_api->create_virtual_router(&vr_id, switch_id, 0, NULL) == SAI_STATUS_SUCCESS, "create virtual router failed");
+
+    return vr_id;
+}
+
+static sai_object_id_t test_create_port(
+        _In_ const sai_port_api_t *port_api,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t *lanes)
+{
+    sai_object_id_t port_id;
+    sai_attribute_t attrs[2];
+
+    attrs[0].id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attrs[0].value.u32list.count = 4;
+    attrs[0].value.u32list.list = lanes;
+
+    attrs[1].id = SAI_PORT_ATTR_SPEED;
+    attrs[1].value.u32 = 100000;
+
+    ASSERT_TRUE(port_api->create_port(&port_id, switch_id, 2, attrs) == SAI_STATUS_SUCCESS, "create port failed");
+
+    return port_id;
+}
+
+static void test_route(
+        _Out_ sai_route_entry_t *route,
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_id_t vr_id,
+        _In_ uint32_t idx)
+{
+    memset(route, 0, sizeof(*route));
+
+    route->switch_id = switch_id;
+    route->vr_id = vr_id;
+    route->destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    route->destination.addr.ip4 = htonl(0x0a000000 | (idx << 8));
+    route->destination.mask.ip4 = htonl(0xffffff00);
+}
+
+void test_crud()
+{
+    sai_switch_api_t *switch_api;
+    sai_port_api_t *port_api;
+    sai_route_api_t *route_api;
+    sai_object_id_t switch_id;
+    sai_object_id_t port_id;
+    sai_object_id_t vr_id;
+    sai_route_entry_t route;
+    sai_attribute_t attr;
+    uint32_t lanes[4] = { 1, 2, 3, 4 };
+    uint32_t buffer[4];
+    uint32_t count;
+
+    test_init("");
+
+    ASSERT_TRUE(sai_api_query(SAI_API_SWITCH, (void**)&switch_api) == SAI_STATUS_SUCCESS, "switch api");
+    ASSERT_TRUE(sai_api_query(SAI_API_PORT, (void**)&port_api) == SAI_STATUS_SUCCESS, "port api");
+    ASSERT_TRUE(sai_api_query(SAI_API_ROUTE, (void**)&route_api) == SAI_STATUS_SUCCESS, "route api");
+
+    switch_id = test_create_switch(switch_api);
+    vr_id = test_create_virtual_router(switch_id);
+    port_id = test_create_port(port_api, switch_id, lanes);
+
+    ASSERT_TRUE(sai_object_type_query(port_id) == SAI_OBJECT_TYPE_PORT, "wrong port object type");
+    ASSERT_TRUE(sai_switch_id_query(port_id) == switch_id, "wrong port switch");
+
+    /* lanes are copied, caller buffer can change */
+
+    lanes[0] = 100;
+
+    attr.id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attr.value.u32list.count = 2;
+    attr.value.u32list.list = buffer;
+
+    ASSERT_TRUE(port_api->get_port_attribute(port_id, 1, &attr) == SAI_STATUS_BUFFER_OVERFLOW, "overflow expected");
+    ASSERT_TRUE(attr.value.u32list.count == 4, "count %u", attr.value.u32list.count);
+
+    ASSERT_TRUE(port_api->get_port_attribute(port_id, 1, &attr) == SAI_STATUS_SUCCESS, "get port failed");
+    ASSERT_TRUE(attr.value.u32list.list == buffer && buffer[0] == 1 && buffer[3] == 4, "wrong lanes");
+
+    test_route(&route, switch_id, vr_id, 1);
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attr.value.oid = port_id;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, &attr) == SAI_STATUS_SUCCESS, "create route failed");
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, &attr) == SAI_STATUS_ITEM_ALREADY_EXISTS, "duplicate route");
+
+    /* unused bytes of ip address union are not part of key */
+
+    route.destination.addr.ip6[15] = 0xff;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+
+    ASSERT_TRUE(route_api->get_route_entry_attribute(&route, 1, &attr) == SAI_STATUS_SUCCESS, "get route failed");
+    ASSERT_TRUE(attr.value.s32 == SAI_PACKET_ACTION_FORWARD, "default packet action expected");
+
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    ASSERT_TRUE(route_api->set_route_entry_attribute(&route, &attr) == SAI_STATUS_SUCCESS, "set route failed");
+
+    attr.value.s32 = SAI_PACKET_ACTION_FORWARD;
+
+    ASSERT_TRUE(route_api->get_route_entry_attribute(&route, 1, &attr) == SAI_STATUS_SUCCESS, "get route failed");
+    ASSERT_TRUE(attr.value.s32 == SAI_PACKET_ACTION_DROP, "packet action not set");
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_ROUTE_ENTRY, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == 1, "count %u", count);
+
+    ASSERT_TRUE(route_api->remove_route_entry(&route) == SAI_STATUS_SUCCESS, "remove route failed");
+    ASSERT_TRUE(route_api->remove_route_entry(&route) == SAI_STATUS_ITEM_NOT_FOUND, "route removed twice");
+
+    ASSERT_TRUE(port_api->remove_port(port_id) == SAI_STATUS_SUCCESS, "remove port failed");
+    ASSERT_TRUE(port_api->get_port_attribute(port_id, 1, &attr) == SAI_STATUS_INVALID_OBJECT_ID, "port not removed");
+
+    /* index of removed port is reused with new generation */
+
+    ASSERT_TRUE(test_create_port(port_api, switch_id, lanes) != port_id, "stale port id reused");
+    ASSERT_TRUE(port_api->get_port_attribute(port_id, 1, &attr) == SAI_STATUS_INVALID_OBJECT_ID, "stale port id valid");
+
+    sai_api_uninitialize();
+}
+
+static void test_bulk_routes(
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *statuses)
+{
+    sai_switch_api_t *switch_api;
+    sai_route_api_t *route_api;
+    sai_object_id_t switch_id;
+    sai_object_id_t vr_id;
+    sai_route_entry_t routes[TEST_ROUTES];
+    uint32_t attr_count[TEST_ROUTES];
+    const sai_attribute_t *attr_list[TEST_ROUTES];
+    sai_attribute_t attr;
+    uint32_t idx;
+
+    sai_api_query(SAI_API_SWITCH, (void**)&switch_api);
+    sai_api_query(SAI_API_ROUTE, (void**)&route_api);
+
+    switch_id = test_create_switch(switch_api);
+    vr_id = test_create_virtual_router(switch_id);
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    for (idx = 0; idx < TEST_ROUTES; idx++)
+    {
+        test_route(&routes[idx], switch_id, vr_id, idx);
+
+        attr_count[idx] = 1;
+        attr_list[idx] = &attr;
+    }
+
+    route_api->create_route_entries(TEST_ROUTES, routes, attr_count, attr_list, mode, statuses);
+}
+
+void test_limit()
+{
+    sai_status_t statuses[TEST_ROUTES];
+    uint64_t available;
+    uint32_t idx;
+
+    test_init("limit route_entry 50\n");
+
+    test_bulk_routes(SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, statuses);
+
+    for (idx = 0; idx < TEST_ROUTES; idx++)
+    {
+        ASSERT_TRUE(statuses[idx] == ((idx < 50) ? SAI_STATUS_SUCCESS : SAI_STATUS_TABLE_FULL), "route %u status %d", idx, statuses[idx]);
+    }
+
+    ASSERT_TRUE(sai_object_type_get_availability(SAI_NULL_OBJECT_ID, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL, &available) == SAI_STATUS_SUCCESS, "availability failed");
+    ASSERT_TRUE(available == 0, "available %" PRIu64, available);
+
+    sai_api_uninitialize();
+
+    test_init("limit SAI_OBJECT_TYPE_ROUTE_ENTRY 10\n");
+
+    test_bulk_routes(SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR, statuses);
+
+    ASSERT_TRUE(statuses[9] == SAI_STATUS_SUCCESS, "status %d", statuses[9]);
+    ASSERT_TRUE(statuses[10] == SAI_STATUS_TABLE_FULL, "status %d", statuses[10]);
+    ASSERT_TRUE(statuses[11] == SAI_STATUS_NOT_EXECUTED, "status %d", statuses[11]);
+
+    sai_api_uninitialize();
+}
+
+void test_failures()
+{
+    sai_status_t first[TEST_ROUTES];
+    sai_status_t second[TEST_ROUTES];
+    uint32_t failed = 0;
+    uint32_t idx;
+
+    test_init("seed 7\nfail create SAI_API_ROUTE 0.3 TABLE_FULL\n");
+    test_bulk_routes(SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, first);
+    sai_api_uninitialize();
+
+    test_init("seed 7\nfail create SAI_API_ROUTE 0.3 TABLE_FULL\n");
+    test_bulk_routes(SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, second);
+    sai_api_uninitialize();
+
+    for (idx = 0; idx < TEST_ROUTES; idx++)
+    {
+        ASSERT_TRUE(first[idx] == second[idx], "route %u differs between runs", idx);
+
+        failed += (first[idx] == SAI_STATUS_TABLE_FULL);
+    }
+
+    ASSERT_TRUE(failed > 10 && failed < 50, "failed %u routes", failed);
+}
+
+void test_latency()
+{
+    sai_status_t statuses[TEST_ROUTES];
+    uint64_t start;
+    uint64_t elapsed;
+
+    test_init("latency create * fixed 100us\nbulk create route_entry 2ms 10us\n");
+
+    start = sai_metadata_now();
+
+    test_bulk_routes(SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR, statuses);
+
+    elapsed = sai_metadata_now() - start;
+
+    /* switch and virtual router create plus bulk of 100 routes */
+
+    ASSERT_TRUE(elapsed >= 3200000, "elapsed %" PRIu64 " ns", elapsed);
+    ASSERT_TRUE(elapsed < 1000000000, "elapsed %" PRIu64 " ns", elapsed);
+
+    sai_api_uninitialize();
+}
+
+void test_validation()
+{
+    sai_switch_api_t *switch_api;
+    sai_port_api_t *port_api;
+    sai_route_api_t *route_api;
+    sai_object_id_t switch_id;
+    sai_object_id_t port_id;
+    sai_object_id_t vr_id;
+    sai_route_entry_t route;
+    sai_attribute_t attrs[2];
+    uint32_t lanes[4] = { 1, 2, 3, 4 };
+
+    test_init("");
+
+    sai_api_query(SAI_API_SWITCH, (void**)&switch_api);
+    sai_api_query(SAI_API_PORT, (void**)&port_api);
+    sai_api_query(SAI_API_ROUTE, (void**)&route_api);
+
+    switch_id = test_create_switch(switch_api);
+    vr_id = test_create_virtual_router(switch_id);
+
+    attrs[0].id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attrs[0].value.u32list.count = 4;
+    attrs[0].value.u32list.list = lanes;
+
+    ASSERT_TRUE(port_api->create_port(&port_id, switch_id, 1, attrs) == SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, "speed is mandatory");
+
+    attrs[1] = attrs[0];
+
+    ASSERT_TRUE(port_api->create_port(&port_id, switch_id, 2, attrs) == SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE(1), "repeated attribute");
+
+    attrs[1].id = SAI_PORT_ATTR_OPER_STATUS;
+    attrs[1].value.s32 = SAI_PORT_OPER_STATUS_UP;
+
+    ASSERT_TRUE(port_api->create_port(&port_id, switch_id, 2, attrs) == SAI_STATUS_INVALID_ATTRIBUTE_0 + SAI_STATUS_CODE(1), "read only on create");
+
+    port_id = test_create_port(port_api, switch_id, lanes);
+
+    ASSERT_TRUE(port_api->set_port_attribute(port_id, &attrs[0]) == SAI_STATUS_INVALID_ATTRIBUTE_0, "create only on set");
+
+    attrs[0].id = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attrs[0].value.objlist.count = 0;
+    attrs[0].value.objlist.list = NULL;
+
+    ASSERT_TRUE(port_api->get_port_attribute(port_id, 1, attrs) == SAI_STATUS_SUCCESS, "empty list default");
+    ASSERT_TRUE(attrs[0].value.objlist.count == 0, "count %u", attrs[0].value.objlist.count);
+
+    /* entry must reference existing virtual router */
+
+    test_route(&route, switch_id, SAI_NULL_OBJECT_ID, 1);
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 0, NULL) == SAI_STATUS_INVALID_PARAMETER, "null virtual router");
+
+    route.vr_id = port_id;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 0, NULL) == SAI_STATUS_INVALID_PARAMETER, "wrong virtual router type");
+
+    route.vr_id = vr_id;
+
+    attrs[0].id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attrs[0].value.s32 = 1000;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, attrs) == SAI_STATUS_INVALID_ATTR_VALUE_0, "invalid enum value");
+
+    attrs[0].id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attrs[0].value.oid = port_id + 1;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, attrs) == SAI_STATUS_INVALID_ATTR_VALUE_0, "missing next hop");
+
+    attrs[0].value.oid = vr_id;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, attrs) == SAI_STATUS_INVALID_ATTR_VALUE_0, "next hop of wrong type");
+
+    attrs[0].value.oid = SAI_NULL_OBJECT_ID;
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 1, attrs) == SAI_STATUS_SUCCESS, "null next hop allowed");
+
+    attrs[0].value.oid = port_id;
+
+    ASSERT_TRUE(route_api->set_route_entry_attribute(&route, attrs) == SAI_STATUS_SUCCESS, "set next hop");
+
+    sai_api_uninitialize();
+}
+
+void test_bulk_get_attribute()
+{
+    sai_switch_api_t *switch_api;
+    sai_port_api_t *port_api;
+    sai_object_id_t switch_id;
+    sai_object_key_t keys[2];
+    sai_attribute_t attrs[2][4];
+    sai_attribute_t *attr_list[2] = { attrs[0], attrs[1] };
+    sai_status_t statuses[2];
+    uint32_t attr_count[2] = { 4, 1 };
+    uint32_t lanes[4] = { 1, 2, 3, 4 };
+    uint32_t count;
+    uint64_t counters[2 * 2];
+    sai_stat_id_t counter_ids[2] = { SAI_PORT_STAT_IF_IN_OCTETS, SAI_PORT_STAT_IF_OUT_OCTETS };
+
+    test_init("");
+
+    sai_api_query(SAI_API_SWITCH, (void**)&switch_api);
+    sai_api_query(SAI_API_PORT, (void**)&port_api);
+
+    switch_id = test_create_switch(switch_api);
+
+    keys[0].key.object_id = test_create_port(port_api, switch_id, lanes);
+    keys[1].key.object_id = test_create_port(port_api, switch_id, lanes);
+
+    ASSERT_TRUE(sai_get_maximum_attribute_count(switch_id, SAI_OBJECT_TYPE_PORT, &count) == SAI_STATUS_SUCCESS, "max attribute count");
+    ASSERT_TRUE(count >= 2, "count %u", count);
+
+    ASSERT_TRUE(sai_bulk_get_attribute(switch_id, SAI_OBJECT_TYPE_PORT, 2, keys, attr_count, attr_list, statuses) == SAI_STATUS_FAILURE, "second port has small buffer");
+    ASSERT_TRUE(statuses[0] == SAI_STATUS_SUCCESS && attr_count[0] == 2, "status %d count %u", statuses[0], attr_count[0]);
+    ASSERT_TRUE(statuses[1] == SAI_STATUS_BUFFER_OVERFLOW && attr_count[1] == 2, "status %d count %u", statuses[1], attr_count[1]);
+
+    /* lists return only count */
+
+    ASSERT_TRUE(attrs[0][0].id == SAI_PORT_ATTR_HW_LANE_LIST, "id %u", attrs[0][0].id);
+    ASSERT_TRUE(attrs[0][0].value.u32list.count == 4 && attrs[0][0].value.u32list.list == NULL, "lanes not counted");
+    ASSERT_TRUE(attrs[0][1].id == SAI_PORT_ATTR_SPEED && attrs[0][1].value.u32 == 100000, "speed not returned");
+
+    counters[0] = 1;
+
+    ASSERT_TRUE(sai_bulk_object_get_stats(switch_id, SAI_OBJECT_TYPE_PORT, 2, keys, 2, counter_ids,
+                SAI_STATS_MODE_READ, statuses, counters) == SAI_STATUS_SUCCESS, "bulk get stats");
+    ASSERT_TRUE(counters[0] == 0, "counter %" PRIu64, counters[0]);
+
+    port_api->remove_port(keys[1].key.object_id);
+
+    ASSERT_TRUE(sai_bulk_object_clear_stats(switch_id, SAI_OBJECT_TYPE_PORT, 2, keys, 2, counter_ids,
+                SAI_STATS_MODE_READ, statuses) == SAI_STATUS_FAILURE, "removed port");
+    ASSERT_TRUE(statuses[1] == SAI_STATUS_INVALID_OBJECT_ID, "status %d", statuses[1]);
+
+    sai_api_uninitialize();
+}
+
+static sai_status_t test_get(
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    sai_object_meta_key_t meta_key;
+
+    meta_key.objecttype = object_type;
+    meta_key.objectkey.key.object_id = object_id;
+
+    return sai_mock_get(&meta_key, attr_count, attr_list);
+}
+
+void test_switch_objects()
+{
+    sai_switch_api_t *switch_api;
+    sai_route_api_t *route_api;
+    sai_object_id_t switch_id;
+    sai_object_id_t ports[4];
+    sai_object_id_t queues[2];
+    sai_route_entry_t route;
+    sai_attribute_t attrs[4];
+    uint32_t count;
+
+    test_init("ports 4 2\n");
+
+    ASSERT_TRUE(sai_api_query(SAI_API_SWITCH, (void**)&switch_api) == SAI_STATUS_SUCCESS, "switch api");
+    ASSERT_TRUE(sai_api_query(SAI_API_ROUTE, (void**)&route_api) == SAI_STATUS_SUCCESS, "route api");
+
+    switch_id = test_create_switch(switch_api);
+
+    attrs[0].id = SAI_SWITCH_ATTR_CPU_PORT;
+    attrs[1].id = SAI_SWITCH_ATTR_PORT_NUMBER;
+    attrs[2].id = SAI_SWITCH_ATTR_PORT_LIST;
+    attrs[2].value.objlist.count = 4;
+    attrs[2].value.objlist.list = ports;
+    attrs[3].id = SAI_SWITCH_ATTR_DEFAULT_VIRTUAL_ROUTER_ID;
+
+    ASSERT_TRUE(test_get(SAI_OBJECT_TYPE_SWITCH, switch_id, 4, attrs) == SAI_STATUS_SUCCESS, "get switch failed");
+    ASSERT_TRUE(sai_object_type_query(attrs[0].value.oid) == SAI_OBJECT_TYPE_PORT, "cpu port not created");
+    ASSERT_TRUE(attrs[1].value.u32 == 4 && attrs[2].value.objlist.count == 4, "port number %u", attrs[1].value.u32);
+    ASSERT_TRUE(sai_switch_id_query(ports[3]) == switch_id, "wrong port switch");
+
+    /* cpu port is not in port list */
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_PORT, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == 5, "count %u", count);
+
+    /* default virtual router can be used as any other */
+
+    test_route(&route, switch_id, attrs[3].value.oid, 1);
+
+    ASSERT_TRUE(route_api->create_route_entry(&route, 0, NULL) == SAI_STATUS_SUCCESS, "create route failed");
+
+    attrs[0].id = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attrs[0].value.objlist.count = 2;
+    attrs[0].value.objlist.list = queues;
+
+    ASSERT_TRUE(test_get(SAI_OBJECT_TYPE_PORT, ports[0], 1, attrs) == SAI_STATUS_SUCCESS, "get port failed");
+    ASSERT_TRUE(attrs[0].value.objlist.count == 2, "queues %u", attrs[0].value.objlist.count);
+
+    attrs[0].id = SAI_QUEUE_ATTR_PORT;
+
+    ASSERT_TRUE(test_get(SAI_OBJECT_TYPE_QUEUE, queues[1], 1, attrs) == SAI_STATUS_SUCCESS, "get queue failed");
+    ASSERT_TRUE(attrs[0].value.oid == ports[0], "wrong queue port");
+
+    attrs[0].id = SAI_SWITCH_ATTR_DEFAULT_VLAN_ID;
+
+    ASSERT_TRUE(test_get(SAI_OBJECT_TYPE_SWITCH, switch_id, 1, attrs) == SAI_STATUS_SUCCESS, "get switch failed");
+
+    attrs[1].id = SAI_VLAN_ATTR_VLAN_ID;
+
+    ASSERT_TRUE(test_get(SAI_OBJECT_TYPE_VLAN, attrs[0].value.oid, 1, &attrs[1]) == SAI_STATUS_SUCCESS, "get vlan failed");
+    ASSERT_TRUE(attrs[1].value.u16 == 1, "vlan %u", attrs[1].value.u16);
+
+    /* switch attributes created by switch are read only */
+
+    attrs[0].id = SAI_SWITCH_ATTR_PORT_NUMBER;
+    attrs[0].value.u32 = 8;
+
+    ASSERT_TRUE(switch_api->set_switch_attribute(switch_id, attrs) == SAI_STATUS_INVALID_ATTRIBUTE_0, "read only set");
+
+    ASSERT_TRUE(switch_api->remove_switch(switch_id) == SAI_STATUS_SUCCESS, "remove switch failed");
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_PORT, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == 0, "count %u", count);
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_ROUTE_ENTRY, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == 0, "count %u", count);
+
+    sai_api_uninitialize();
+}
+
+typedef struct _test_thread_t
+{
+    sai_object_id_t switch_id;
+    sai_object_id_t vr_id;
+    uint32_t idx;
+
+} test_thread_t;
+
+static void* test_thread(
+        _In_ void *arg)
+{
+    const test_thread_t *t = (const test_thread_t*)arg;
+    sai_virtual_router_api_t *virtual_router_api;
+    sai_route_api_t *route_api;
+    sai_route_entry_t route;
+    sai_object_id_t vr_id;
+    uint32_t idx;
+
+    sai_api_query(SAI_API_VIRTUAL_ROUTER, (void**)&virtual_router_api);
+    sai_api_query(SAI_API_ROUTE, (void**)&route_api);
+
+    for (idx = 0; idx < TEST_ROUTES; idx++)
+    {
+        test_route(&route, t->switch_id, t->vr_id, t->idx * TEST_ROUTES + idx);
+
+        ASSERT_TRUE(route_api->create_route_entry(&route, 0, NULL) == SAI_STATUS_SUCCESS, "create route failed");
+
+        vr_id = test_create_virtual_router(t->switch_id);
+
+        ASSERT_TRUE(virtual_router_api->remove_virtual_router(vr_id) == SAI_STATUS_SUCCESS, "remove virtual router failed");
+    }
+
+    return NULL;
+}
+
+void test_threads()
+{
+    sai_switch_api_t *switch_api;
+    test_thread_t args[TEST_THREADS];
+    pthread_t threads[TEST_THREADS];
+    sai_object_id_t switch_id;
+    sai_object_id_t vr_id;
+    uint32_t count;
+    uint32_t idx;
+
+    test_init("ports 2\n");
+
+    sai_api_query(SAI_API_SWITCH, (void**)&switch_api);
+
+    switch_id = test_create_switch(switch_api);
+    vr_id = test_create_virtual_router(switch_id);
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        args[idx].switch_id = switch_id;
+        args[idx].vr_id = vr_id;
+        args[idx].idx = idx;
+
+        ASSERT_TRUE(pthread_create(&threads[idx], NULL, test_thread, &args[idx]) == 0, "create thread failed");
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+    }
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_ROUTE_ENTRY, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == TEST_THREADS * TEST_ROUTES, "count %u", count);
+
+    /* default and created virtual router */
+
+    ASSERT_TRUE(sai_get_object_count(switch_id, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, &count) == SAI_STATUS_SUCCESS, "count failed");
+    ASSERT_TRUE(count == 2, "count %u", count);
+
+    sai_api_uninitialize();
+}
+
+int main()
+{
+    test_crud();
+
+    test_limit();
+
+    test_failures();
+
+    test_latency();
+
+    test_validation();
+
+    test_bulk_get_attribute();
+
+    test_switch_objects();
+
+    test_threads();
+
+    return 0;
+}
@@ -0,0 +1,2949 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimockutils.c
+ *
+ * @brief   This module implements SAI mock library runtime
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "saimetadata.h"
+#include "saimock.h"
+#include "saioid.h"
+
+#define SAI_MOCK_OP_CREATE 0
+#define SAI_MOCK_OP_REMOVE 1
+#define SAI_MOCK_OP_SET 2
+#define SAI_MOCK_OP_GET 3
+#define SAI_MOCK_OP_STATS 4
+#define SAI_MOCK_OP_OTHER 5
+#define SAI_MOCK_OPS 6
+
+/*
+ * Shorter delays are busy waited, sleep granularity would distort them.
+ */
+
+#define SAI_MOCK_SPIN_NS 50000
+
+#define SAI_MOCK_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_MOCK_MAX_LISTS 2
+
+#define SAI_MOCK_TABLE_MIN_SIZE 64
+
+#define SAI_MOCK_OBJECT_SIZE SAI_MOCK_ALIGN(sizeof(sai_mock_object_t))
+
+#define SAI_MOCK_MAX_LINE 1024
+
+#define SAI_MOCK_PI 3.14159265358979323846
+
+#define SAI_MOCK_SWITCH_INDEX ((size_t)SAI_OBJECT_TYPE_SWITCH)
+
+#define SAI_MOCK_PORT_SPEED 100000
+
+#define SAI_MOCK_DEFAULT_VLAN 1
+
+#define SAI_MOCK_MAX_QUEUES 256
+
+typedef enum _sai_mock_latency_t
+{
+    SAI_MOCK_LATENCY_NONE,
+
+    SAI_MOCK_LATENCY_FIXED,
+
+    SAI_MOCK_LATENCY_UNIFORM,
+
+    SAI_MOCK_LATENCY_NORMAL,
+
+    SAI_MOCK_LATENCY_EXPONENTIAL,
+
+} sai_mock_latency_t;
+
+typedef struct _sai_mock_rule_t
+{
+    sai_mock_latency_t latency;
+
+    double latency_a;
+
+    double latency_b;
+
+    bool bulk;
+
+    double bulk_base;
+
+    double bulk_per_object;
+
+    double fail_probability;
+
+    sai_status_t fail_status;
+
+} sai_mock_rule_t;
+
+typedef struct _sai_mock_counters_t
+{
+    uint64_t calls;
+
+    uint64_t objects;
+
+    uint64_t failures;
+
+    uint64_t latency;
+
+} sai_mock_counters_t;
+
+/*
+ * Object and its attributes are single allocation until attribute with
+ * list is set.
+ */
+
+typedef struct _sai_mock_object_t
+{
+    sai_object_meta_key_t meta_key;
+
+    uint32_t attr_count;
+
+    sai_attribute_t *attr_list;
+
+} sai_mock_object_t;
+
+typedef struct _sai_mock_slot_t
+{
+    uint64_t hash;
+
+    sai_mock_object_t *object;
+
+} sai_mock_slot_t;
+
+/*
+ * Open addressing table of single object type with linear probing, keyed
+ * by object id or by entry struct. Tombstone marks removed slot so probe
+ * sequences stay intact.
+ */
+
+typedef struct _sai_mock_table_t
+{
+    sai_mock_slot_t *slots;
+
+    size_t size;
+
+    size_t used;
+
+    size_t key_size;
+
+} sai_mock_table_t;
+
+/*
+ * Every list in attribute value has the same layout, count followed by
+ * pointer.
+ */
+
+typedef struct _sai_mock_list_t
+{
+    uint32_t count;
+
+    void *list;
+
+} sai_mock_list_t;
+
+/*
+ * Each object type has its own lock and operation holds only the lock of
+ * its object type. Object references are validated before the lock is
+ * taken. Default value taken from switch attribute is the only nested lock,
+ * so switch lock is always taken last.
+ */
+
+static pthread_mutex_t sai_mock_locks[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static pthread_once_t sai_mock_locks_once = PTHREAD_ONCE_INIT;
+
+static int sai_mock_initialized = 0;
+
+static sai_mock_rule_t sai_mock_rules[SAI_MOCK_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static sai_mock_counters_t sai_mock_counters[SAI_MOCK_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static uint64_t sai_mock_limits[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static uint64_t sai_mock_counts[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+/*
+ * Object ids come from lock free allocator, so they are allocated and freed
+ * under lock of their object type only, and stale object id of removed
+ * object is never handed out again with the same generation.
+ */
+
+static sai_oid_allocator_t *sai_mock_oids = NULL;
+
+static uint64_t sai_mock_random_state = 1;
+
+static uint32_t sai_mock_switch_count = 0;
+
+static uint32_t sai_mock_port_count = SAI_MOCK_DEFAULT_PORT_NUMBER;
+
+static uint32_t sai_mock_queue_count = SAI_MOCK_DEFAULT_QUEUE_NUMBER;
+
+static sai_mock_table_t sai_mock_tables[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static sai_mock_object_t sai_mock_tombstone;
+
+static const sai_attribute_value_t sai_mock_empty_value;
+
+static const sai_object_type_t sai_mock_switch_type = SAI_OBJECT_TYPE_SWITCH;
+
+static const char * const sai_mock_op_names[SAI_MOCK_OPS] = {
+    "create", "remove", "set", "get", "stats", "other"
+};
+
+/*
+ * Status of attribute with index idx, like SAI_STATUS_INVALID_ATTRIBUTE_0.
+ */
+
+static sai_status_t sai_mock_attr_status(
+        _In_ sai_status_t status,
+        _In_ uint32_t idx)
+{
+    return status + SAI_STATUS_CODE((sai_status_t)idx);
+}
+
+static void sai_mock_init_locks(void)
+{
+    size_t index;
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        pthread_mutex_init(&sai_mock_locks[index], NULL);
+    }
+}
+
+static void sai_mock_lock(
+        _In_ size_t index)
+{
+    pthread_once(&sai_mock_locks_once, sai_mock_init_locks);
+
+    pthread_mutex_lock(&sai_mock_locks[index]);
+}
+
+static void sai_mock_unlock(
+        _In_ size_t index)
+{
+    pthread_mutex_unlock(&sai_mock_locks[index]);
+}
+
+static void sai_mock_lock_all(void)
+{
+    size_t index;
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        if (index != SAI_MOCK_SWITCH_INDEX)
+        {
+            sai_mock_lock(index);
+        }
+    }
+
+    sai_mock_lock(SAI_MOCK_SWITCH_INDEX);
+}
+
+static void sai_mock_unlock_all(void)
+{
+    size_t index;
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        sai_mock_unlock(index);
+    }
+}
+
+/*
+ * Splitmix64, small state and good enough distribution for injection.
+ * State is advanced atomically as calls of different object types run in
+ * parallel.
+ */
+
+static uint64_t sai_mock_random(void)
+{
+    uint64_t z = __atomic_add_fetch(&sai_mock_random_state, 0x9e3779b97f4a7c15ULL, __ATOMIC_RELAXED);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/*
+ * Uniform double in range (0, 1).
+ */
+
+static double sai_mock_random_double(void)
+{
+    return ((double)(sai_mock_random() >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double sai_mock_sample_latency(
+        _In_ const sai_mock_rule_t *rule)
+{
+    double value;
+
+    switch (rule->latency)
+    {
+        case SAI_MOCK_LATENCY_FIXED:
+            return rule->latency_a;
+
+        case SAI_MOCK_LATENCY_UNIFORM:
+            return rule->latency_a + (rule->latency_b - rule->latency_a) * sai_mock_random_double();
+
+        case SAI_MOCK_LATENCY_NORMAL:
+
+            /* Box-Muller, negative samples are clamped */
+
+            value = rule->latency_a + rule->latency_b *
+                sqrt(-2.0 * log(sai_mock_random_double())) * cos(2.0 * SAI_MOCK_PI * sai_mock_random_double());
+
+            return (value > 0) ? value : 0;
+
+        case SAI_MOCK_LATENCY_EXPONENTIAL:
+            return -rule->latency_a * log(sai_mock_random_double());
+
+        default:
+            return 0;
+    }
+}
+
+static void sai_mock_delay(
+        _In_ uint64_t ns)
+{
+    struct timespec ts;
+    uint64_t deadline;
+
+    if (ns == 0)
+    {
+        return;
+    }
+
+    if (ns < SAI_MOCK_SPIN_NS)
+    {
+        deadline = sai_metadata_now() + ns;
+
+        while (sai_metadata_now() < deadline)
+        {
+        }
+
+        return;
+    }
+
+    ts.tv_sec = (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+/*
+ * Decides injected failures of call with object_count objects (1 for
+ * single call) and returns latency of the call. Statuses are set only for
+ * failed objects. Must be called with lock of object type held.
+ */
+
+static uint64_t sai_mock_inject(
+        _In_ int op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _Inout_ sai_status_t *statuses)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    const sai_mock_rule_t *rule = &sai_mock_rules[op][index];
+    sai_mock_counters_t *counters = &sai_mock_counters[op][index];
+    double latency = 0;
+    uint32_t idx;
+
+    if (rule->bulk && object_count > 1)
+    {
+        latency = rule->bulk_base + rule->bulk_per_object * object_count;
+    }
+    else if (rule->latency != SAI_MOCK_LATENCY_NONE)
+    {
+        for (idx = 0; idx < object_count; idx++)
+        {
+            latency += sai_mock_sample_latency(rule);
+        }
+    }
+
+    if (rule->fail_probability > 0)
+    {
+        for (idx = 0; idx < object_count; idx++)
+        {
+            if (sai_mock_random_double() < rule->fail_probability)
+            {
+                statuses[idx] = rule->fail_status;
+                counters->failures++;
+            }
+        }
+    }
+
+    counters->calls++;
+    counters->objects += object_count;
+    counters->latency += (uint64_t)latency;
+
+    return (uint64_t)latency;
+}
+
+static sai_mock_slot_t* sai_mock_find_slot(
+        _In_ sai_mock_table_t *table,
+        _In_ const sai_object_key_entry_t *key,
+        _In_ uint64_t hash,
+        _Out_ sai_mock_slot_t **free_slot)
+{
+    size_t mask;
+    size_t idx;
+
+    *free_slot = NULL;
+
+    if (table->size == 0)
+    {
+        return NULL;
+    }
+
+    mask = table->size - 1;
+    idx = (size_t)hash & mask;
+
+    while (table->slots[idx].object != NULL)
+    {
+        sai_mock_slot_t *slot = &table->slots[idx];
+
+        if (slot->object == &sai_mock_tombstone)
+        {
+            if (*free_slot == NULL)
+            {
+                *free_slot = slot;
+            }
+        }
+        else if (slot->hash == hash && memcmp(&slot->object->meta_key.objectkey.key, key, table->key_size) == 0)
+        {
+            return slot;
+        }
+
+        idx = (idx + 1) & mask;
+    }
+
+    if (*free_slot == NULL)
+    {
+        *free_slot = &table->slots[idx];
+    }
+
+    return NULL;
+}
+
+static sai_mock_slot_t* sai_mock_lookup(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_mock_table_t *table = &sai_mock_tables[sai_metadata_object_type_index(meta_key->objecttype)];
+    sai_object_meta_key_t key;
+    sai_mock_slot_t *free_slot;
+
+    if (table->size == 0)
+    {
+        return NULL;
+    }
+
+    sai_metadata_normalize_object_meta_key(meta_key, &key);
+
+    return sai_mock_find_slot(table, &key.objectkey.key, sai_metadata_hash_object_meta_key(&key), &free_slot);
+}
+
+static sai_mock_object_t* sai_mock_find(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_mock_slot_t *slot = sai_mock_lookup(meta_key);
+
+    return (slot != NULL) ? slot->object : NULL;
+}
+
+/*
+ * Doubles table, or only drops tombstones when most of used slots are
+ * tombstones.
+ */
+
+static sai_status_t sai_mock_table_grow(
+        _In_ size_t index)
+{
+    sai_mock_table_t *table = &sai_mock_tables[index];
+    sai_mock_slot_t *old = table->slots;
+    size_t old_size = table->size;
+    size_t size = old_size * 2;
+    size_t idx;
+
+    if (old_size == 0)
+    {
+        size = SAI_MOCK_TABLE_MIN_SIZE;
+
+        table->key_size = sai_metadata_get_object_key_size(sai_metadata_object_type_from_index(index));
+    }
+    else if (sai_mock_counts[index] * 4 <= old_size)
+    {
+        size = old_size;
+    }
+
+    table->slots = (sai_mock_slot_t*)calloc(size, sizeof(sai_mock_slot_t));
+
+    if (table->slots == NULL)
+    {
+        table->slots = old;
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    table->size = size;
+    table->used = 0;
+
+    for (idx = 0; idx < old_size; idx++)
+    {
+        sai_mock_slot_t *free_slot;
+
+        if (old[idx].object == NULL || old[idx].object == &sai_mock_tombstone)
+        {
+            continue;
+        }
+
+        sai_mock_find_slot(table, &old[idx].object->meta_key.objectkey.key, old[idx].hash, &free_slot);
+
+        *free_slot = old[idx];
+
+        table->used++;
+    }
+
+    free(old);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void sai_mock_free_object(
+        _In_ sai_mock_object_t *obj)
+{
+    if (sai_metadata_is_object_type_oid(obj->meta_key.objecttype))
+    {
+        sai_oid_free(sai_mock_oids, obj->meta_key.objectkey.key.object_id);
+    }
+
+    if ((uint8_t*)obj->attr_list != (uint8_t*)obj + SAI_MOCK_OBJECT_SIZE)
+    {
+        free(obj->attr_list);
+    }
+
+    free(obj);
+}
+
+/*
+ * Switch of object, SAI_NULL_OBJECT_ID for entry without switch_id member.
+ */
+
+static sai_object_id_t sai_mock_object_switch(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key->objecttype);
+    size_t idx;
+
+    if (info == NULL || !info->isnonobjectid)
+    {
+        return sai_switch_id_query(meta_key->objectkey.key.object_id);
+    }
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (strcmp(m->membername, "switch_id") == 0 && m->getoid != NULL)
+        {
+            return m->getoid(meta_key);
+        }
+    }
+
+    return SAI_NULL_OBJECT_ID;
+}
+
+static sai_mock_list_t sai_mock_list_get(
+        _In_ const sai_attribute_value_t *value,
+        _In_ size_t offset)
+{
+    sai_mock_list_t list;
+
+    memcpy(&list, (const uint8_t*)value + offset, sizeof(list));
+
+    return list;
+}
+
+static void sai_mock_list_set(
+        _Inout_ sai_attribute_value_t *value,
+        _In_ size_t offset,
+        _In_ const sai_mock_list_t *list)
+{
+    memcpy((uint8_t*)value + offset, list, sizeof(*list));
+}
+
+/*
+ * Copies attributes and their lists into single allocation, after prefix
+ * bytes reserved for caller. Block is NULL when there is nothing to copy.
+ */
+
+static sai_status_t sai_mock_copy_attrs(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ size_t prefix,
+        _Out_ void **block)
+{
+    sai_attribute_t *copy;
+    sai_status_t status;
+    size_t size;
+
+    *block = NULL;
+
+    status = sai_metadata_get_attr_list_copy_size(object_type, attr_count, attr_list, &size);
+
+    if (status != SAI_STATUS_SUCCESS || prefix + size == 0)
+    {
+        return status;
+    }
+
+    *block = malloc(prefix + size);
+
+    if (*block == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    status = sai_metadata_deep_copy_attr_list(object_type, attr_count, attr_list, (uint8_t*)*block + prefix, &copy);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        free(*block);
+        *block = NULL;
+    }
+
+    return status;
+}
+
+/*
+ * Copies stored value into caller attribute, lists go to caller buffers.
+ */
+
+static sai_status_t sai_mock_get_value(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t *value,
+        _Inout_ sai_attribute_value_t *out)
+{
+    size_t offsets[SAI_MOCK_MAX_LISTS];
+    size_t sizes[SAI_MOCK_MAX_LISTS];
+    sai_mock_list_t buffers[SAI_MOCK_MAX_LISTS];
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t count;
+    uint32_t n;
+
+    count = sai_metadata_get_attr_value_lists(md, value, offsets, sizes);
+
+    for (n = 0; n < count; n++)
+    {
+        buffers[n] = sai_mock_list_get(out, offsets[n]);
+    }
+
+    *out = *value;
+
+    for (n = 0; n < count; n++)
+    {
+        sai_mock_list_t list = sai_mock_list_get(value, offsets[n]);
+
+        if (buffers[n].count < list.count)
+        {
+            status = SAI_STATUS_BUFFER_OVERFLOW;
+        }
+        else if (list.count != 0)
+        {
+            if (buffers[n].list == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            memcpy(buffers[n].list, list.list, (size_t)list.count * sizes[n]);
+        }
+
+        buffers[n].count = list.count;
+
+        sai_mock_list_set(out, offsets[n], &buffers[n]);
+    }
+
+    return status;
+}
+
+static const sai_attribute_value_t* sai_mock_find_value(
+        _In_ const sai_mock_object_t *obj,
+        _In_ sai_attr_id_t attr_id)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < obj->attr_count; idx++)
+    {
+        if (obj->attr_list[idx].id == attr_id)
+        {
+            return &obj->attr_list[idx].value;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Copies value of attribute which was not set. Default taken from other
+ * attribute is looked up on the same object or on its switch, switch
+ * internal and vendor specific defaults are not known. Returns
+ * SAI_STATUS_ITEM_NOT_FOUND when attribute has no known default.
+ */
+
+static sai_status_t sai_mock_get_default(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_mock_object_t *obj,
+        _Inout_ sai_attribute_value_t *out)
+{
+    const sai_attr_metadata_t *src_md;
+    const sai_attribute_value_t *value = NULL;
+    const sai_mock_object_t *sw_obj;
+    sai_object_meta_key_t sw;
+    sai_status_t status;
+
+    switch (md->defaultvaluetype)
+    {
+        case SAI_DEFAULT_VALUE_TYPE_CONST:
+            return sai_mock_get_value(md, md->defaultvalue, out);
+
+        case SAI_DEFAULT_VALUE_TYPE_EMPTY_LIST:
+            return sai_mock_get_value(md, &sai_mock_empty_value, out);
+
+        case SAI_DEFAULT_VALUE_TYPE_ATTR_VALUE:
+            break;
+
+        default:
+            return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (md->defaultvalueobjecttype == obj->meta_key.objecttype)
+    {
+        value = sai_mock_find_value(obj, md->defaultvalueattrid);
+    }
+    else if (md->defaultvalueobjecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        sw.objecttype = SAI_OBJECT_TYPE_SWITCH;
+        sw.objectkey.key.object_id = sai_mock_object_switch(&obj->meta_key);
+
+        /* value is copied under switch lock, which is taken last */
+
+        sai_mock_lock(SAI_MOCK_SWITCH_INDEX);
+
+        sw_obj = sai_mock_find(&sw);
+
+        status = (sw_obj == NULL) ? SAI_STATUS_ITEM_NOT_FOUND : SAI_STATUS_SUCCESS;
+
+        if (sw_obj != NULL && (value = sai_mock_find_value(sw_obj, md->defaultvalueattrid)) != NULL)
+        {
+            status = sai_mock_get_value(md, value, out);
+        }
+
+        sai_mock_unlock(SAI_MOCK_SWITCH_INDEX);
+
+        if (status != SAI_STATUS_SUCCESS || value != NULL)
+        {
+            return status;
+        }
+    }
+    else
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (value != NULL)
+    {
+        return sai_mock_get_value(md, value, out);
+    }
+
+    src_md = sai_metadata_get_attr_metadata(md->defaultvalueobjecttype, md->defaultvalueattrid);
+
+    if (src_md != NULL && src_md->defaultvaluetype == SAI_DEFAULT_VALUE_TYPE_CONST)
+    {
+        return sai_mock_get_value(md, src_md->defaultvalue, out);
+    }
+
+    return SAI_STATUS_ITEM_NOT_FOUND;
+}
+
+/*
+ * Object id referenced by attribute or entry key must be of allowed type
+ * and must exist. Takes lock of referenced object type, so it is called
+ * without lock held.
+ */
+
+static bool sai_mock_is_valid_reference(
+        _In_ sai_object_id_t oid,
+        _In_ const sai_object_type_t *allowed,
+        _In_ size_t allowed_count,
+        _In_ bool allow_null)
+{
+    sai_object_meta_key_t meta_key;
+    size_t index;
+    size_t idx;
+    bool found;
+
+    if (oid == SAI_NULL_OBJECT_ID)
+    {
+        return allow_null;
+    }
+
+    meta_key.objecttype = sai_object_type_query(oid);
+    meta_key.objectkey.key.object_id = oid;
+
+    for (idx = 0; idx < allowed_count; idx++)
+    {
+        if (allowed[idx] == meta_key.objecttype)
+        {
+            index = sai_metadata_object_type_index(meta_key.objecttype);
+
+            sai_mock_lock(index);
+
+            found = sai_mock_find(&meta_key) != NULL;
+
+            sai_mock_unlock(index);
+
+            return found;
+        }
+    }
+
+    return false;
+}
+
+static bool sai_mock_is_valid_reference_list(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_object_list_t *list)
+{
+    uint32_t idx;
+
+    if (list->count != 0 && list->list == NULL)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < list->count; idx++)
+    {
+        if (!sai_mock_is_valid_reference(list->list[idx], md->allowedobjecttypes, md->allowedobjecttypeslength, false))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Checks enum values and object references of attribute value.
+ */
+
+static bool sai_mock_is_valid_value(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t *value)
+{
+    uint32_t idx;
+
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_INT32:
+            return !md->isenum || sai_metadata_is_allowed_enum_value(md, value->s32);
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+
+            if (!md->isenumlist)
+            {
+                return true;
+            }
+
+            if (value->s32list.count != 0 && value->s32list.list == NULL)
+            {
+                return false;
+            }
+
+            for (idx = 0; idx < value->s32list.count; idx++)
+            {
+                if (!sai_metadata_is_allowed_enum_value(md, value->s32list.list[idx]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return sai_mock_is_valid_reference(value->oid, md->allowedobjecttypes, md->allowedobjecttypeslength, md->allownullobjectid);
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            return sai_mock_is_valid_reference_list(md, &value->objlist);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            return !value->aclfield.enable || sai_mock_is_valid_reference(value->aclfield.data.oid,
+                    md->allowedobjecttypes, md->allowedobjecttypeslength, md->allownullobjectid);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            return !value->aclfield.enable || sai_mock_is_valid_reference_list(md, &value->aclfield.data.objlist);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            return !value->aclaction.enable || sai_mock_is_valid_reference(value->aclaction.parameter.oid,
+                    md->allowedobjecttypes, md->allowedobjecttypeslength, md->allownullobjectid);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            return !value->aclaction.enable || sai_mock_is_valid_reference_list(md, &value->aclaction.parameter.objlist);
+
+        default:
+            return true;
+    }
+}
+
+/*
+ * Validates create attributes against metadata: known, not read only, not
+ * repeated, valid values and all mandatory attributes present.
+ */
+
+static sai_status_t sai_mock_check_create(
+        _In_ const sai_object_type_info_t *info,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+    uint32_t n;
+
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(info->objecttype, attr_list[idx].id);
+
+        if (md == NULL)
+        {
+            return sai_mock_attr_status(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        if (md->isreadonly)
+        {
+            return sai_mock_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        for (n = 0; n < idx; n++)
+        {
+            if (attr_list[n].id == attr_list[idx].id)
+            {
+                return sai_mock_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+            }
+        }
+
+        if (!sai_mock_is_valid_value(md, &attr_list[idx].value))
+        {
+            return sai_mock_attr_status(SAI_STATUS_INVALID_ATTR_VALUE_0, idx);
+        }
+    }
+
+    for (idx = 0; idx < info->attrmetadatalength; idx++)
+    {
+        const sai_attr_metadata_t *md = info->attrmetadata[idx];
+
+        if (!md->ismandatoryoncreate)
+        {
+            continue;
+        }
+
+        if (md->isconditional && !sai_metadata_is_condition_met(md, attr_count, attr_list))
+        {
+            continue;
+        }
+
+        if (sai_metadata_get_attr_by_id(md->attrid, attr_count, attr_list) == NULL)
+        {
+            return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Object ids in entry key must reference existing objects.
+ */
+
+static sai_status_t sai_mock_check_key(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    size_t idx;
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (m->getoid == NULL)
+        {
+            continue;
+        }
+
+        if (!sai_mock_is_valid_reference(m->getoid(meta_key), m->allowedobjecttypes, m->allowedobjecttypeslength, false))
+        {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Validates create against metadata and checks that referenced objects
+ * exist, so it is called before lock of created object type is taken.
+ */
+
+static sai_status_t sai_mock_validate_create(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key->objecttype);
+    sai_status_t status;
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    status = sai_mock_check_create(info, attr_count, attr_list);
+
+    if (status != SAI_STATUS_SUCCESS || meta_key->objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return status;
+    }
+
+    if (info->isnonobjectid)
+    {
+        return sai_mock_check_key(info, meta_key);
+    }
+
+    if (!sai_mock_is_valid_reference(switch_id, &sai_mock_switch_type, 1, false))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_mock_new_oid_locked(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t switch_index,
+        _Out_ sai_object_id_t *object_id)
+{
+    sai_status_t status = sai_oid_allocate(sai_mock_oids, object_type, (uint16_t)switch_index, object_id);
+
+    /* index space of object type is exhausted, not table of switch */
+
+    return (status == SAI_STATUS_TABLE_FULL) ? SAI_STATUS_INSUFFICIENT_RESOURCES : status;
+}
+
+static sai_status_t sai_mock_insert_locked(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_mock_table_t *table = &sai_mock_tables[index];
+    sai_object_meta_key_t key;
+    sai_mock_slot_t *free_slot;
+    sai_mock_object_t *obj;
+    sai_status_t status;
+    uint64_t hash;
+    void *block;
+
+    if ((table->used + 1) * 2 > table->size)
+    {
+        status = sai_mock_table_grow(index);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    sai_metadata_normalize_object_meta_key(meta_key, &key);
+
+    hash = sai_metadata_hash_object_meta_key(&key);
+
+    if (sai_mock_find_slot(table, &key.objectkey.key, hash, &free_slot) != NULL)
+    {
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    status = sai_mock_copy_attrs(meta_key->objecttype, attr_count, attr_list, SAI_MOCK_OBJECT_SIZE, &block);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    obj = (sai_mock_object_t*)block;
+
+    obj->meta_key = key;
+    obj->attr_count = attr_count;
+    obj->attr_list = (sai_attribute_t*)((uint8_t*)block + SAI_MOCK_OBJECT_SIZE);
+
+    if (free_slot->object == NULL)
+    {
+        table->used++;
+    }
+
+    free_slot->hash = hash;
+    free_slot->object = obj;
+
+    sai_mock_counts[index]++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Creates validated object other than switch.
+ */
+
+static sai_status_t sai_mock_create_locked(
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_status_t status;
+
+    if (sai_mock_limits[index] != 0 && sai_mock_counts[index] >= sai_mock_limits[index])
+    {
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    if (sai_metadata_is_object_type_oid(meta_key->objecttype))
+    {
+        status = sai_mock_new_oid_locked(meta_key->objecttype, SAI_OID_SWITCH_INDEX(switch_id), &meta_key->objectkey.key.object_id);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return sai_mock_insert_locked(meta_key, attr_count, attr_list);
+}
+
+/*
+ * Creates object which switch creates itself. Attributes are not validated,
+ * so read only attributes can be set, and limit does not apply. Object id
+ * is allocated unless it is already set.
+ */
+
+static sai_status_t sai_mock_create_internal(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t switch_index,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Inout_ sai_object_id_t *object_id)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    sai_object_meta_key_t meta_key;
+
+    sai_mock_lock(index);
+
+    if (*object_id == SAI_NULL_OBJECT_ID)
+    {
+        status = sai_mock_new_oid_locked(object_type, switch_index, object_id);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        meta_key.objecttype = object_type;
+        meta_key.objectkey.key.object_id = *object_id;
+
+        status = sai_mock_insert_locked(&meta_key, attr_count, attr_list);
+    }
+
+    sai_mock_unlock(index);
+
+    return status;
+}
+
+/*
+ * Creates port with its queues, CPU port has no lanes.
+ */
+
+static sai_status_t sai_mock_create_port(
+        _In_ uint32_t switch_index,
+        _In_ bool cpu,
+        _In_ uint32_t lane,
+        _In_ uint32_t queue_count,
+        _Out_ sai_object_id_t *port_id)
+{
+    sai_attribute_t attrs[5];
+    sai_object_id_t *queues;
+    sai_status_t status;
+    uint32_t count = 0;
+    uint32_t idx;
+
+    *port_id = SAI_NULL_OBJECT_ID;
+
+    queues = (sai_object_id_t*)calloc((size_t)queue_count + 1, sizeof(sai_object_id_t));
+
+    if (queues == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    sai_mock_lock(sai_metadata_object_type_index(SAI_OBJECT_TYPE_PORT));
+
+    status = sai_mock_new_oid_locked(SAI_OBJECT_TYPE_PORT, switch_index, port_id);
+
+    sai_mock_unlock(sai_metadata_object_type_index(SAI_OBJECT_TYPE_PORT));
+
+    for (idx = 0; idx < queue_count && status == SAI_STATUS_SUCCESS; idx++)
+    {
+        attrs[0].id = SAI_QUEUE_ATTR_TYPE;
+        attrs[0].value.s32 = SAI_QUEUE_TYPE_ALL;
+
+        attrs[1].id = SAI_QUEUE_ATTR_PORT;
+        attrs[1].value.oid = *port_id;
+
+        attrs[2].id = SAI_QUEUE_ATTR_INDEX;
+        attrs[2].value.u8 = (uint8_t)idx;
+
+        status = sai_mock_create_internal(SAI_OBJECT_TYPE_QUEUE, switch_index, 3, attrs, &queues[idx]);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        attrs[count].id = SAI_PORT_ATTR_TYPE;
+        attrs[count++].value.s32 = cpu ? SAI_PORT_TYPE_CPU : SAI_PORT_TYPE_LOGICAL;
+
+        attrs[count].id = SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES;
+        attrs[count++].value.u32 = queue_count;
+
+        attrs[count].id = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+        attrs[count].value.objlist.count = queue_count;
+        attrs[count++].value.objlist.list = queues;
+
+        if (!cpu)
+        {
+            attrs[count].id = SAI_PORT_ATTR_HW_LANE_LIST;
+            attrs[count].value.u32list.count = 1;
+            attrs[count++].value.u32list.list = &lane;
+
+            attrs[count].id = SAI_PORT_ATTR_SPEED;
+            attrs[count++].value.u32 = SAI_MOCK_PORT_SPEED;
+        }
+
+        status = sai_mock_create_internal(SAI_OBJECT_TYPE_PORT, switch_index, count, attrs, port_id);
+    }
+
+    free(queues);
+
+    return status;
+}
+
+/*
+ * Removes objects of switch together with the switch, as real switch does.
+ */
+
+static void sai_mock_remove_switch_objects(
+        _In_ sai_object_id_t switch_id)
+{
+    size_t index;
+    size_t idx;
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        sai_mock_table_t *table = &sai_mock_tables[index];
+
+        if (index == SAI_MOCK_SWITCH_INDEX)
+        {
+            continue;
+        }
+
+        sai_mock_lock(index);
+
+        for (idx = 0; idx < table->size; idx++)
+        {
+            sai_mock_object_t *obj = table->slots[idx].object;
+
+            if (obj == NULL || obj == &sai_mock_tombstone || sai_mock_object_switch(&obj->meta_key) != switch_id)
+            {
+                continue;
+            }
+
+            sai_mock_free_object(obj);
+
+            table->slots[idx].object = &sai_mock_tombstone;
+
+            sai_mock_counts[index]--;
+        }
+
+        sai_mock_unlock(index);
+    }
+}
+
+/*
+ * Creates validated switch with objects which real switch creates itself:
+ * CPU port, ports with queues, default virtual router and default VLAN,
+ * returned by read only switch attributes.
+ */
+
+static sai_status_t sai_mock_create_switch(
+        _Out_ sai_object_id_t *switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    sai_object_id_t cpu_port = SAI_NULL_OBJECT_ID;
+    sai_object_id_t vr_id = SAI_NULL_OBJECT_ID;
+    sai_object_id_t vlan_id = SAI_NULL_OBJECT_ID;
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t vlan_attr;
+    sai_object_id_t *ports;
+    sai_attribute_t *attrs;
+    uint32_t switch_index = 0;
+    uint32_t port_count;
+    uint32_t queue_count;
+    uint32_t count;
+    uint32_t idx;
+
+    *switch_id = SAI_NULL_OBJECT_ID;
+
+    sai_mock_lock(SAI_MOCK_SWITCH_INDEX);
+
+    if (sai_mock_limits[SAI_MOCK_SWITCH_INDEX] != 0 && sai_mock_counts[SAI_MOCK_SWITCH_INDEX] >= sai_mock_limits[SAI_MOCK_SWITCH_INDEX])
+    {
+        status = SAI_STATUS_TABLE_FULL;
+    }
+    else if (sai_mock_switch_count >= SAI_MOCK_MAX_SWITCHES)
+    {
+        status = SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+    else
+    {
+        /* switch index is reserved, it is not reused even when create fails */
+
+        switch_index = sai_mock_switch_count++;
+
+        status = sai_mock_new_oid_locked(SAI_OBJECT_TYPE_SWITCH, switch_index, switch_id);
+    }
+
+    port_count = sai_mock_port_count;
+    queue_count = sai_mock_queue_count;
+
+    sai_mock_unlock(SAI_MOCK_SWITCH_INDEX);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    ports = (sai_object_id_t*)calloc((size_t)port_count + 1, sizeof(sai_object_id_t));
+    attrs = (sai_attribute_t*)malloc(((size_t)attr_count + 6) * sizeof(sai_attribute_t));
+
+    if (ports == NULL || attrs == NULL)
+    {
+        status = SAI_STATUS_NO_MEMORY;
+    }
+    else
+    {
+        status = sai_mock_create_port(switch_index, true, 0, queue_count, &cpu_port);
+    }
+
+    for (idx = 0; idx < port_count && status == SAI_STATUS_SUCCESS; idx++)
+    {
+        status = sai_mock_create_port(switch_index, false, idx, queue_count, &ports[idx]);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_mock_create_internal(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, switch_index, 0, NULL, &vr_id);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        vlan_attr.id = SAI_VLAN_ATTR_VLAN_ID;
+        vlan_attr.value.u16 = SAI_MOCK_DEFAULT_VLAN;
+
+        status = sai_mock_create_internal(SAI_OBJECT_TYPE_VLAN, switch_index, 1, &vlan_attr, &vlan_id);
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        count = attr_count;
+
+        if (attr_count != 0)
+        {
+            memcpy(attrs, attr_list, attr_count * sizeof(sai_attribute_t));
+        }
+
+        attrs[count].id = SAI_SWITCH_ATTR_CPU_PORT;
+        attrs[count++].value.oid = cpu_port;
+
+        attrs[count].id = SAI_SWITCH_ATTR_PORT_NUMBER;
+        attrs[count++].value.u32 = port_count;
+
+        attrs[count].id = SAI_SWITCH_ATTR_PORT_LIST;
+        attrs[count].value.objlist.count = port_count;
+        attrs[count++].value.objlist.list = ports;
+
+        attrs[count].id = SAI_SWITCH_ATTR_NUMBER_OF_QUEUES;
+        attrs[count++].value.u32 = queue_count;
+
+        attrs[count].id = SAI_SWITCH_ATTR_DEFAULT_VIRTUAL_ROUTER_ID;
+        attrs[count++].value.oid = vr_id;
+
+        attrs[count].id = SAI_SWITCH_ATTR_DEFAULT_VLAN_ID;
+        attrs[count++].value.oid = vlan_id;
+
+        meta_key.objecttype = SAI_OBJECT_TYPE_SWITCH;
+        meta_key.objectkey.key.object_id = *switch_id;
+
+        sai_mock_lock(SAI_MOCK_SWITCH_INDEX);
+
+        status = sai_mock_insert_locked(&meta_key, count, attrs);
+
+        sai_mock_unlock(SAI_MOCK_SWITCH_INDEX);
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        sai_mock_remove_switch_objects(*switch_id);
+
+        sai_oid_free(sai_mock_oids, *switch_id);
+
+        *switch_id = SAI_NULL_OBJECT_ID;
+    }
+
+    free(ports);
+    free(attrs);
+
+    return status;
+}
+
+static sai_status_t sai_mock_not_found(
+        _In_ sai_object_type_t object_type)
+{
+    return sai_metadata_is_object_type_oid(object_type) ? SAI_STATUS_INVALID_OBJECT_ID : SAI_STATUS_ITEM_NOT_FOUND;
+}
+
+static sai_status_t sai_mock_remove_locked(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_mock_slot_t *slot = sai_mock_lookup(meta_key);
+
+    if (slot == NULL)
+    {
+        return sai_mock_not_found(meta_key->objecttype);
+    }
+
+    sai_mock_free_object(slot->object);
+
+    /* tombstone stays counted as used until next grow */
+
+    slot->object = &sai_mock_tombstone;
+
+    sai_mock_counts[sai_metadata_object_type_index(meta_key->objecttype)]--;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Validates set against metadata and checks that referenced objects exist,
+ * so it is called before lock of object type is taken.
+ */
+
+static sai_status_t sai_mock_validate_set(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key->objecttype, attr->id);
+
+    if (md == NULL)
+    {
+        return SAI_STATUS_UNKNOWN_ATTRIBUTE_0;
+    }
+
+    if (!md->iscreateandset)
+    {
+        return SAI_STATUS_INVALID_ATTRIBUTE_0;
+    }
+
+    if (!sai_mock_is_valid_value(md, &attr->value))
+    {
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Missing object is reported before validation status.
+ */
+
+static sai_status_t sai_mock_set_locked(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr,
+        _In_ sai_status_t validation)
+{
+    size_t offsets[SAI_MOCK_MAX_LISTS];
+    size_t sizes[SAI_MOCK_MAX_LISTS];
+    const sai_attr_metadata_t *md;
+    sai_mock_object_t *obj;
+    sai_attribute_t *attrs;
+    sai_status_t status;
+    uint32_t count;
+    uint32_t idx;
+    void *block;
+
+    obj = sai_mock_find(meta_key);
+
+    if (obj == NULL)
+    {
+        return sai_mock_not_found(meta_key->objecttype);
+    }
+
+    if (validation != SAI_STATUS_SUCCESS)
+    {
+        return validation;
+    }
+
+    md = sai_metadata_get_attr_metadata(meta_key->objecttype, attr->id);
+
+    /* value without lists replacing value without lists is updated in place */
+
+    for (idx = 0; idx < obj->attr_count; idx++)
+    {
+        if (obj->attr_list[idx].id == attr->id)
+        {
+            if (sai_metadata_get_attr_value_lists(md, &attr->value, offsets, sizes) == 0 &&
+                    sai_metadata_get_attr_value_lists(md, &obj->attr_list[idx].value, offsets, sizes) == 0)
+            {
+                obj->attr_list[idx].value = attr->value;
+                return SAI_STATUS_SUCCESS;
+            }
+
+            break;
+        }
+    }
+
+    attrs = (sai_attribute_t*)malloc((obj->attr_count + 1) * sizeof(sai_attribute_t));
+
+    if (attrs == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    count = 0;
+
+    for (idx = 0; idx < obj->attr_count; idx++)
+    {
+        if (obj->attr_list[idx].id != attr->id)
+        {
+            attrs[count++] = obj->attr_list[idx];
+        }
+    }
+
+    attrs[count++] = *attr;
+
+    status = sai_mock_copy_attrs(meta_key->objecttype, count, attrs, 0, &block);
+
+    free(attrs);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if ((uint8_t*)obj->attr_list != (uint8_t*)obj + SAI_MOCK_OBJECT_SIZE)
+    {
+        free(obj->attr_list);
+    }
+
+    obj->attr_list = (sai_attribute_t*)block;
+    obj->attr_count = count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_mock_get_locked(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_mock_object_t *obj;
+    uint32_t idx;
+
+    if (attr_count == 0 || attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    obj = sai_mock_find(meta_key);
+
+    if (obj == NULL)
+    {
+        return sai_mock_not_found(meta_key->objecttype);
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key->objecttype, attr_list[idx].id);
+        const sai_attribute_value_t *value;
+        sai_status_t status;
+
+        if (md == NULL)
+        {
+            return sai_mock_attr_status(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        value = sai_mock_find_value(obj, attr_list[idx].id);
+
+        status = (value != NULL)
+            ? sai_mock_get_value(md, value, &attr_list[idx].value)
+            : sai_mock_get_default(md, obj, &attr_list[idx].value);
+
+        if (status == SAI_STATUS_ITEM_NOT_FOUND)
+        {
+            return sai_mock_attr_status(SAI_STATUS_ATTR_NOT_IMPLEMENTED_0, idx);
+        }
+
+        if (status == SAI_STATUS_BUFFER_OVERFLOW)
+        {
+            result = status;
+        }
+        else if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Single object operations take lock of object type only for the store
+ * access, injection is done by caller.
+ */
+
+static sai_status_t sai_mock_create_object(
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_status_t status;
+
+    status = sai_mock_validate_create(meta_key, switch_id, attr_count, attr_list);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (meta_key->objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return sai_mock_create_switch(&meta_key->objectkey.key.object_id, attr_count, attr_list);
+    }
+
+    sai_mock_lock(index);
+
+    status = sai_mock_create_locked(meta_key, switch_id, attr_count, attr_list);
+
+    sai_mock_unlock(index);
+
+    return status;
+}
+
+static sai_status_t sai_mock_remove_object(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_status_t status;
+
+    sai_mock_lock(index);
+
+    status = sai_mock_remove_locked(meta_key);
+
+    sai_mock_unlock(index);
+
+    if (status == SAI_STATUS_SUCCESS && meta_key->objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        sai_mock_remove_switch_objects(meta_key->objectkey.key.object_id);
+    }
+
+    return status;
+}
+
+static sai_status_t sai_mock_set_object(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_status_t status;
+
+    if (attr == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = sai_mock_validate_set(meta_key, attr);
+
+    sai_mock_lock(index);
+
+    status = sai_mock_set_locked(meta_key, attr, status);
+
+    sai_mock_unlock(index);
+
+    return status;
+}
+
+static sai_status_t sai_mock_get_object(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    size_t index = sai_metadata_object_type_index(meta_key->objecttype);
+    sai_status_t status;
+
+    sai_mock_lock(index);
+
+    status = sai_mock_get_locked(meta_key, attr_count, attr_list);
+
+    sai_mock_unlock(index);
+
+    return status;
+}
+
+static uint64_t sai_mock_inject_call(
+        _In_ int op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _Inout_ sai_status_t *statuses)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    uint64_t latency;
+
+    sai_mock_lock(index);
+
+    latency = sai_mock_inject(op, object_type, object_count, statuses);
+
+    sai_mock_unlock(index);
+
+    return latency;
+}
+
+sai_status_t sai_mock_create(
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_CREATE, meta_key->objecttype, 1, &status);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_mock_create_object(meta_key, switch_id, attr_count, attr_list);
+    }
+
+    sai_mock_delay(latency);
+
+    return status;
+}
+
+sai_status_t sai_mock_remove(
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_REMOVE, meta_key->objecttype, 1, &status);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_mock_remove_object(meta_key);
+    }
+
+    sai_mock_delay(latency);
+
+    return status;
+}
+
+sai_status_t sai_mock_set(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_SET, meta_key->objecttype, 1, &status);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_mock_set_object(meta_key, attr);
+    }
+
+    sai_mock_delay(latency);
+
+    return status;
+}
+
+sai_status_t sai_mock_get(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_GET, meta_key->objecttype, 1, &status);
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_mock_get_object(meta_key, attr_count, attr_list);
+    }
+
+    sai_mock_delay(latency);
+
+    return status;
+}
+
+/*
+ * Runs single operation for each object of bulk call. Objects failed by
+ * injection keep their status, in stop on error mode objects after first
+ * failure are not executed.
+ */
+
+static sai_status_t sai_mock_bulk(
+        _In_ int op,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Inout_ sai_object_meta_key_t *create_meta_key,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t *const *attr_list,
+        _In_ const sai_attribute_t *set_attr_list,
+        _Inout_ sai_attribute_t **get_attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+    uint32_t idx;
+
+    if (meta_key == NULL || object_statuses == NULL || object_count == 0)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if ((op == SAI_MOCK_OP_CREATE || op == SAI_MOCK_OP_GET) && (attr_count == NULL ||
+                (op == SAI_MOCK_OP_CREATE && attr_list == NULL) || (op == SAI_MOCK_OP_GET && get_attr_list == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (op == SAI_MOCK_OP_SET && set_attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_statuses[idx] = SAI_STATUS_SUCCESS;
+    }
+
+    latency = sai_mock_inject_call(op, meta_key[0].objecttype, object_count, object_statuses);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (result != SAI_STATUS_SUCCESS && mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+        {
+            object_statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+            continue;
+        }
+
+        if (object_statuses[idx] == SAI_STATUS_SUCCESS)
+        {
+            switch (op)
+            {
+                case SAI_MOCK_OP_CREATE:
+                    object_statuses[idx] = sai_mock_create_object(&create_meta_key[idx], switch_id, attr_count[idx], attr_list[idx]);
+                    break;
+
+                case SAI_MOCK_OP_REMOVE:
+                    object_statuses[idx] = sai_mock_remove_object(&meta_key[idx]);
+                    break;
+
+                case SAI_MOCK_OP_SET:
+                    object_statuses[idx] = sai_mock_set_object(&meta_key[idx], &set_attr_list[idx]);
+                    break;
+
+                default:
+                    object_statuses[idx] = sai_mock_get_object(&meta_key[idx], attr_count[idx], get_attr_list[idx]);
+                    break;
+            }
+        }
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            result = SAI_STATUS_FAILURE;
+        }
+    }
+
+    sai_mock_delay(latency);
+
+    return result;
+}
+
+sai_status_t sai_mock_bulk_create(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t object_count,
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    return sai_mock_bulk(SAI_MOCK_OP_CREATE, switch_id, object_count, meta_key, meta_key,
+            attr_count, attr_list, NULL, NULL, mode, object_statuses);
+}
+
+sai_status_t sai_mock_bulk_remove(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    return sai_mock_bulk(SAI_MOCK_OP_REMOVE, SAI_NULL_OBJECT_ID, object_count, meta_key, NULL,
+            NULL, NULL, NULL, NULL, mode, object_statuses);
+}
+
+sai_status_t sai_mock_bulk_set(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    return sai_mock_bulk(SAI_MOCK_OP_SET, SAI_NULL_OBJECT_ID, object_count, meta_key, NULL,
+            NULL, NULL, attr_list, NULL, mode, object_statuses);
+}
+
+sai_status_t sai_mock_bulk_get(
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _Inout_ sai_attribute_t **attr_list,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses)
+{
+    return sai_mock_bulk(SAI_MOCK_OP_GET, SAI_NULL_OBJECT_ID, object_count, meta_key, NULL,
+            attr_count, NULL, NULL, attr_list, mode, object_statuses);
+}
+
+sai_status_t sai_mock_stats(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t number_of_counters,
+        _Out_ uint64_t *counters)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint64_t latency;
+
+    if (number_of_counters != 0 && counters == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_STATS, object_type, 1, &status);
+
+    sai_mock_delay(latency);
+
+    if (status == SAI_STATUS_SUCCESS && number_of_counters != 0)
+    {
+        memset(counters, 0, number_of_counters * sizeof(uint64_t));
+    }
+
+    return status;
+}
+
+sai_status_t sai_mock_other(
+        _In_ sai_object_type_t object_type)
+{
+    sai_status_t status = SAI_STATUS_NOT_IMPLEMENTED;
+    uint64_t latency;
+
+    latency = sai_mock_inject_call(SAI_MOCK_OP_OTHER, object_type, 1, &status);
+
+    sai_mock_delay(latency);
+
+    return status;
+}
+
+/* Configuration */
+
+static int sai_mock_parse_enum(
+        _In_ const sai_enum_metadata_t *meta,
+        _In_ const char *token,
+        _Out_ int *value)
+{
+    size_t idx;
+
+    for (idx = 0; idx < meta->valuescount; idx++)
+    {
+        if (strcasecmp(token, meta->valuesnames[idx]) == 0 ||
+                strcasecmp(token, meta->valuesshortnames[idx]) == 0)
+        {
+            *value = meta->values[idx];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int sai_mock_parse_op(
+        _In_ const char *token,
+        _Out_ int *first,
+        _Out_ int *last)
+{
+    int op;
+
+    if (strcmp(token, "*") == 0)
+    {
+        *first = 0;
+        *last = SAI_MOCK_OPS - 1;
+        return 1;
+    }
+
+    for (op = 0; op < SAI_MOCK_OPS; op++)
+    {
+        if (strcasecmp(token, sai_mock_op_names[op]) == 0)
+        {
+            *first = op;
+            *last = op;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Marks object type indexes matched by target.
+ */
+
+static int sai_mock_parse_target(
+        _In_ const char *token,
+        _Out_ bool *match)
+{
+    size_t index;
+    int value;
+
+    memset(match, 0, SAI_METADATA_OBJECT_TYPE_INDEX_COUNT * sizeof(bool));
+
+    if (strcmp(token, "*") == 0)
+    {
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            match[index] = true;
+        }
+
+        return 1;
+    }
+
+    if (sai_mock_parse_enum(&sai_metadata_enum_sai_object_type_t, token, &value))
+    {
+        match[sai_metadata_object_type_index((sai_object_type_t)value)] = true;
+        return 1;
+    }
+
+    if (sai_mock_parse_enum(&sai_metadata_enum_sai_api_t, token, &value))
+    {
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            match[index] = (sai_mock_object_type_api(sai_metadata_object_type_from_index(index)) == (sai_api_t)value);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static int sai_mock_parse_time(
+        _In_ const char *token,
+        _Out_ double *ns)
+{
+    char *end;
+    double value = strtod(token, &end);
+
+    if (end == token || value < 0)
+    {
+        return 0;
+    }
+
+    if (*end == 0 || strcmp(end, "ns") == 0)
+    {
+        *ns = value;
+    }
+    else if (strcmp(end, "us") == 0)
+    {
+        *ns = value * 1e3;
+    }
+    else if (strcmp(end, "ms") == 0)
+    {
+        *ns = value * 1e6;
+    }
+    else if (strcmp(end, "s") == 0)
+    {
+        *ns = value * 1e9;
+    }
+    else
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+static int sai_mock_parse_line(
+        _Inout_ char *line,
+        _Inout_ bool *match)
+{
+    char *tokens[8];
+    char *save = NULL;
+    char kind;
+    char *token;
+    sai_mock_rule_t rule;
+    int count = 0;
+    int first;
+    int last;
+    int value;
+    int op;
+    size_t index;
+
+    for (token = strtok_r(line, " \t\r\n", &save); token != NULL; token = strtok_r(NULL, " \t\r\n", &save))
+    {
+        if (token[0] == '#')
+        {
+            break;
+        }
+
+        if (count == 8)
+        {
+            return 0;
+        }
+
+        tokens[count++] = token;
+    }
+
+    if (count == 0)
+    {
+        return 1;
+    }
+
+    if (strcmp(tokens[0], "seed") == 0 && count == 2)
+    {
+        sai_mock_random_state = strtoull(tokens[1], NULL, 0);
+        return 1;
+    }
+
+    if (strcmp(tokens[0], "limit") == 0 && count == 3)
+    {
+        if (!sai_mock_parse_target(tokens[1], match))
+        {
+            return 0;
+        }
+
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            if (match[index])
+            {
+                sai_mock_limits[index] = strtoull(tokens[2], NULL, 0);
+            }
+        }
+
+        return 1;
+    }
+
+    if (strcmp(tokens[0], "ports") == 0 && (count == 2 || count == 3))
+    {
+        sai_mock_port_count = (uint32_t)strtoul(tokens[1], NULL, 0);
+
+        if (count == 3)
+        {
+            sai_mock_queue_count = (uint32_t)strtoul(tokens[2], NULL, 0);
+        }
+
+        return sai_mock_queue_count <= SAI_MOCK_MAX_QUEUES;
+    }
+
+    if (count < 4 || !sai_mock_parse_op(tokens[1], &first, &last) || !sai_mock_parse_target(tokens[2], match))
+    {
+        return 0;
+    }
+
+    memset(&rule, 0, sizeof(rule));
+
+    kind = tokens[0][0];
+
+    if (strcmp(tokens[0], "latency") == 0)
+    {
+        if (strcmp(tokens[3], "fixed") == 0 && count == 5)
+        {
+            rule.latency = SAI_MOCK_LATENCY_FIXED;
+        }
+        else if (strcmp(tokens[3], "uniform") == 0 && count == 6)
+        {
+            rule.latency = SAI_MOCK_LATENCY_UNIFORM;
+        }
+        else if (strcmp(tokens[3], "normal") == 0 && count == 6)
+        {
+            rule.latency = SAI_MOCK_LATENCY_NORMAL;
+        }
+        else if (strcmp(tokens[3], "exponential") == 0 && count == 5)
+        {
+            rule.latency = SAI_MOCK_LATENCY_EXPONENTIAL;
+        }
+        else
+        {
+            return 0;
+        }
+
+        if (!sai_mock_parse_time(tokens[4], &rule.latency_a) || (count == 6 && !sai_mock_parse_time(tokens[5], &rule.latency_b)))
+        {
+            return 0;
+        }
+    }
+    else if (strcmp(tokens[0], "bulk") == 0 && count == 5)
+    {
+        if (!sai_mock_parse_time(tokens[3], &rule.bulk_base) || !sai_mock_parse_time(tokens[4], &rule.bulk_per_object))
+        {
+            return 0;
+        }
+    }
+    else if (strcmp(tokens[0], "fail") == 0 && (count == 4 || count == 5))
+    {
+        rule.fail_probability = strtod(tokens[3], NULL);
+        rule.fail_status = SAI_STATUS_FAILURE;
+
+        if (count == 5)
+        {
+            if (!sai_mock_parse_enum(&sai_metadata_enum_sai_status_t, tokens[4], &value))
+            {
+                return 0;
+            }
+
+            rule.fail_status = (sai_status_t)value;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    for (op = first; op <= last; op++)
+    {
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            sai_mock_rule_t *r = &sai_mock_rules[op][index];
+
+            if (!match[index])
+            {
+                continue;
+            }
+
+            if (kind == 'l')
+            {
+                r->latency = rule.latency;
+                r->latency_a = rule.latency_a;
+                r->latency_b = rule.latency_b;
+            }
+            else if (kind == 'b')
+            {
+                r->bulk = true;
+                r->bulk_base = rule.bulk_base;
+                r->bulk_per_object = rule.bulk_per_object;
+            }
+            else
+            {
+                r->fail_probability = rule.fail_probability;
+                r->fail_status = rule.fail_status;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void sai_mock_reset_config(void)
+{
+    memset(sai_mock_rules, 0, sizeof(sai_mock_rules));
+    memset(sai_mock_limits, 0, sizeof(sai_mock_limits));
+
+    sai_mock_random_state = 1;
+
+    sai_mock_port_count = SAI_MOCK_DEFAULT_PORT_NUMBER;
+    sai_mock_queue_count = SAI_MOCK_DEFAULT_QUEUE_NUMBER;
+}
+
+sai_status_t sai_mock_load_config(
+        _In_ const char *path)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    char line[SAI_MOCK_MAX_LINE];
+    unsigned int lineno = 0;
+    bool *match;
+    FILE *file;
+
+    sai_mock_lock_all();
+
+    sai_mock_reset_config();
+
+    sai_mock_unlock_all();
+
+    if (path == NULL)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open mock config %s: %s", path, strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    match = (bool*)calloc(SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, sizeof(bool));
+
+    if (match == NULL)
+    {
+        fclose(file);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    sai_mock_lock_all();
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineno++;
+
+        if (!sai_mock_parse_line(line, match))
+        {
+            SAI_META_LOG_ERROR("%s:%u: invalid mock config line", path, lineno);
+
+            status = SAI_STATUS_INVALID_PARAMETER;
+            break;
+        }
+    }
+
+    sai_mock_unlock_all();
+
+    free(match);
+    fclose(file);
+
+    return status;
+}
+
+/* Store */
+
+static void sai_mock_clear(void)
+{
+    size_t index;
+    size_t idx;
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        sai_mock_table_t *table = &sai_mock_tables[index];
+
+        for (idx = 0; idx < table->size; idx++)
+        {
+            sai_mock_object_t *obj = table->slots[idx].object;
+
+            if (obj != NULL && obj != &sai_mock_tombstone)
+            {
+                sai_mock_free_object(obj);
+            }
+        }
+
+        free(table->slots);
+    }
+
+    memset(sai_mock_tables, 0, sizeof(sai_mock_tables));
+
+    sai_oid_allocator_close(sai_mock_oids);
+
+    sai_mock_oids = NULL;
+
+    sai_mock_switch_count = 0;
+
+    memset(sai_mock_counts, 0, sizeof(sai_mock_counts));
+    memset(sai_mock_counters, 0, sizeof(sai_mock_counters));
+}
+
+static void sai_mock_dump_locked(
+        _Inout_ FILE *file)
+{
+    size_t index;
+    int op;
+
+    fprintf(file, "%-48s %12s %12s\n", "object type", "objects", "limit");
+
+    for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        sai_object_type_t ot = sai_metadata_object_type_from_index(index);
+
+        if (sai_mock_counts[index] == 0 && sai_mock_limits[index] == 0)
+        {
+            continue;
+        }
+
+        fprintf(file, "%-48s %12" PRIu64 " %12" PRIu64 "\n",
+                sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t, ot),
+                sai_mock_counts[index], sai_mock_limits[index]);
+    }
+
+    fprintf(file, "\n%-8s %-48s %12s %12s %12s %16s\n", "op", "object type", "calls", "objects", "failures", "latency ns");
+
+    for (op = 0; op < SAI_MOCK_OPS; op++)
+    {
+        for (index = 0; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+        {
+            const sai_mock_counters_t *c = &sai_mock_counters[op][index];
+            const char *name = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t,
+                    sai_metadata_object_type_from_index(index));
+
+            if (c->calls == 0)
+            {
+                continue;
+            }
+
+            fprintf(file, "%-8s %-48s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %16" PRIu64 "\n",
+                    sai_mock_op_names[op], (name != NULL) ? name : "SAI_OBJECT_TYPE_NULL",
+                    c->calls, c->objects, c->failures, c->latency);
+        }
+    }
+}
+
+void sai_mock_dump(
+        _Inout_ FILE *file)
+{
+    sai_mock_lock_all();
+
+    sai_mock_dump_locked(file);
+
+    sai_mock_unlock_all();
+}
+
+/* Global functions */
+
+sai_status_t sai_api_initialize(
+        _In_ uint64_t flags,
+        _In_ const sai_service_method_table_t *services)
+{
+    const char *path = NULL;
+    sai_status_t status;
+
+    if (services != NULL && services->profile_get_value != NULL)
+    {
+        path = services->profile_get_value(0, SAI_MOCK_ENV_CONFIG);
+    }
+
+    if (path == NULL)
+    {
+        path = getenv(SAI_MOCK_ENV_CONFIG);
+    }
+
+    status = sai_mock_load_config(path);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    sai_mock_lock_all();
+
+    sai_mock_clear();
+
+    sai_mock_oids = sai_oid_allocator_open();
+
+    sai_mock_initialized = (sai_mock_oids != NULL);
+
+    sai_mock_unlock_all();
+
+    return (sai_mock_oids != NULL) ? SAI_STATUS_SUCCESS : SAI_STATUS_NO_MEMORY;
+}
+
+sai_status_t sai_api_query(
+        _In_ sai_api_t api,
+        _Out_ void **api_method_table)
+{
+    if (api_method_table == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!sai_mock_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    return sai_mock_api_query(api, api_method_table);
+}
+
+sai_status_t sai_api_uninitialize(void)
+{
+    sai_mock_lock_all();
+
+    sai_mock_clear();
+
+    sai_mock_reset_config();
+
+    sai_mock_initialized = 0;
+
+    sai_mock_unlock_all();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_log_set(
+        _In_ sai_api_t api,
+        _In_ sai_log_level_t log_level)
+{
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_object_type_t sai_object_type_query(
+        _In_ sai_object_id_t object_id)
+{
+    sai_object_type_t object_type;
+
+    if (object_id == SAI_NULL_OBJECT_ID)
+    {
+        return SAI_OBJECT_TYPE_NULL;
+    }
+
+    object_type = sai_oid_object_type(object_id);
+
+    return sai_metadata_is_object_type_oid(object_type) ? object_type : SAI_OBJECT_TYPE_NULL;
+}
+
+sai_object_id_t sai_switch_id_query(
+        _In_ sai_object_id_t object_id)
+{
+    if (sai_object_type_query(object_id) == SAI_OBJECT_TYPE_NULL)
+    {
+        return SAI_NULL_OBJECT_ID;
+    }
+
+    return sai_oid_switch_id(object_id);
+}
+
+sai_status_t sai_query_api_version(
+        _Out_ sai_api_version_t *version)
+{
+    if (version == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *version = SAI_API_VERSION;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_object_type_get_availability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t *count)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+
+    if (count == NULL || sai_metadata_get_object_type_info(object_type) == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    sai_mock_lock(index);
+
+    /* without limit the whole counter space is available */
+
+    *count = (sai_mock_limits[index] != 0)
+        ? (sai_mock_limits[index] > sai_mock_counts[index] ? sai_mock_limits[index] - sai_mock_counts[index] : 0)
+        : SAI_OID_MAX_INDEX - sai_mock_counts[index];
+
+    sai_mock_unlock(index);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Walks whole table of object type, object count and key queries are rare.
+ */
+
+static sai_status_t sai_mock_get_objects(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ uint32_t *object_count,
+        _Out_ sai_object_key_t *object_list)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    const sai_mock_table_t *table = &sai_mock_tables[index];
+    uint32_t count = 0;
+    size_t idx;
+
+    if (object_count == NULL || sai_metadata_get_object_type_info(object_type) == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    sai_mock_lock(index);
+
+    for (idx = 0; idx < table->size; idx++)
+    {
+        const sai_mock_object_t *obj = table->slots[idx].object;
+
+        if (obj == NULL || obj == &sai_mock_tombstone)
+        {
+            continue;
+        }
+
+        if (object_type != SAI_OBJECT_TYPE_SWITCH && sai_mock_object_switch(&obj->meta_key) != switch_id)
+        {
+            continue;
+        }
+
+        if (object_list != NULL && count < *object_count)
+        {
+            object_list[count].key = obj->meta_key.objectkey.key;
+        }
+
+        count++;
+    }
+
+    sai_mock_unlock(index);
+
+    if (object_list != NULL && count > *object_count)
+    {
+        *object_count = count;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    *object_count = count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_get_object_count(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Out_ uint32_t *count)
+{
+    if (count == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_mock_get_objects(switch_id, object_type, count, NULL);
+}
+
+sai_status_t sai_get_object_key(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ uint32_t *object_count,
+        _Inout_ sai_object_key_t *object_list)
+{
+    if (object_count == NULL || object_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_mock_get_objects(switch_id, object_type, object_count, object_list);
+}
+
+sai_status_t sai_get_maximum_attribute_count(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Out_ uint32_t *count)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+    if (count == NULL || info == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *count = (uint32_t)info->attrmetadatalength;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Returns attributes which were set on object, for list attributes only
+ * count is filled as caller does not provide list buffers.
+ */
+
+static sai_status_t sai_mock_get_all_locked(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Inout_ uint32_t *attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    size_t offsets[SAI_MOCK_MAX_LISTS];
+    size_t sizes[SAI_MOCK_MAX_LISTS];
+    const sai_mock_object_t *obj = sai_mock_find(meta_key);
+    uint32_t count;
+    uint32_t idx;
+    uint32_t n;
+
+    if (obj == NULL)
+    {
+        return sai_mock_not_found(meta_key->objecttype);
+    }
+
+    if (*attr_count < obj->attr_count)
+    {
+        *attr_count = obj->attr_count;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    if (obj->attr_count != 0 && attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < obj->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key->objecttype, obj->attr_list[idx].id);
+
+        attr_list[idx] = obj->attr_list[idx];
+
+        count = sai_metadata_get_attr_value_lists(md, &attr_list[idx].value, offsets, sizes);
+
+        for (n = 0; n < count; n++)
+        {
+            sai_mock_list_t list = sai_mock_list_get(&attr_list[idx].value, offsets[n]);
+
+            list.list = NULL;
+
+            sai_mock_list_set(&attr_list[idx].value, offsets[n], &list);
+        }
+    }
+
+    *attr_count = obj->attr_count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_bulk_get_attribute(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _Inout_ uint32_t *attr_count,
+        _Inout_ sai_attribute_t **attr_list,
+        _Inout_ sai_status_t *object_statuses)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_object_meta_key_t meta_key;
+    uint64_t latency;
+    uint32_t idx;
+
+    if (object_count == 0 || object_key == NULL || attr_count == NULL || attr_list == NULL || object_statuses == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_statuses[idx] = SAI_STATUS_SUCCESS;
+    }
+
+    meta_key.objecttype = object_type;
+
+    sai_mock_lock(index);
+
+    latency = sai_mock_inject(SAI_MOCK_OP_GET, object_type, object_count, object_statuses);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (object_statuses[idx] == SAI_STATUS_SUCCESS)
+        {
+            meta_key.objectkey.key = object_key[idx].key;
+
+            object_statuses[idx] = sai_mock_get_all_locked(&meta_key, &attr_count[idx], attr_list[idx]);
+        }
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            result = SAI_STATUS_FAILURE;
+        }
+    }
+
+    sai_mock_unlock(index);
+
+    sai_mock_delay(latency);
+
+    return result;
+}
+
+/*
+ * Counters of existing objects are zero, counters is NULL for clear.
+ */
+
+static sai_status_t sai_mock_bulk_stats(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _Inout_ sai_status_t *object_statuses,
+        _Out_ uint64_t *counters)
+{
+    size_t index = sai_metadata_object_type_index(object_type);
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_object_meta_key_t meta_key;
+    uint64_t latency;
+    uint32_t idx;
+
+    if (object_count == 0 || object_key == NULL || number_of_counters == 0 || counter_ids == NULL || object_statuses == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_statuses[idx] = SAI_STATUS_SUCCESS;
+    }
+
+    meta_key.objecttype = object_type;
+
+    sai_mock_lock(index);
+
+    latency = sai_mock_inject(SAI_MOCK_OP_STATS, object_type, object_count, object_statuses);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        meta_key.objectkey.key = object_key[idx].key;
+
+        if (object_statuses[idx] == SAI_STATUS_SUCCESS && sai_mock_find(&meta_key) == NULL)
+        {
+            object_statuses[idx] = sai_mock_not_found(object_type);
+        }
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            result = SAI_STATUS_FAILURE;
+        }
+        else if (counters != NULL)
+        {
+            memset(&counters[(size_t)idx * number_of_counters], 0, number_of_counters * sizeof(uint64_t));
+        }
+    }
+
+    sai_mock_unlock(index);
+
+    sai_mock_delay(latency);
+
+    return result;
+}
+
+sai_status_t sai_bulk_object_get_stats(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Inout_ sai_status_t *object_statuses,
+        _Out_ uint64_t *counters)
+{
+    if (counters == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_mock_bulk_stats(object_type, object_count, object_key, number_of_counters, counter_ids, object_statuses, counters);
+}
+
+sai_status_t sai_bulk_object_clear_stats(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Inout_ sai_status_t *object_statuses)
+{
+    return sai_mock_bulk_stats(object_type, object_count, object_key, number_of_counters, counter_ids, object_statuses, NULL);
+}
+
+sai_status_t sai_dbg_generate_dump(
+        _In_ const char *dump_file_name)
+{
+    FILE *file;
+
+    if (dump_file_name == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    file = fopen(dump_file_name, "w");
+
+    if (file == NULL)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    sai_mock_dump(file);
+
+    fclose(file);
+
+    return SAI_STATUS_SUCCESS;
+}
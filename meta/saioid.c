@@ -0,0 +1,491 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saioid.c
+ *
+ * @brief   This module implements SAI object id allocator
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saioid.h"
+
+#define SAI_OID_CHUNK_SHIFT 10
+
+#define SAI_OID_CHUNK_SIZE (1U << SAI_OID_CHUNK_SHIFT)
+
+#define SAI_OID_CHUNKS (SAI_OID_MAX_INDEX >> SAI_OID_CHUNK_SHIFT)
+
+#define SAI_OID_GENERATION_MASK 0xffffU
+
+#define SAI_OID_LIVE 0x80000000U
+
+/*
+ * Free list head packs tag (incremented on every change, so head which was
+ * popped and pushed back between load and compare and swap is detected)
+ * and index plus one of first free slot, 0 for empty list.
+ */
+
+#define SAI_OID_HEAD(tag, next) (((uint64_t)(tag) << 32) | (uint64_t)(next))
+#define SAI_OID_HEAD_TAG(head) ((uint32_t)((head) >> 32))
+#define SAI_OID_HEAD_NEXT(head) ((uint32_t)(head))
+
+/*
+ * State is generation with SAI_OID_LIVE bit when allocated, next is index
+ * plus one of next free slot while slot is on free list.
+ */
+
+typedef struct _sai_oid_slot_t
+{
+    uint32_t state;
+
+    uint32_t next;
+
+} sai_oid_slot_t;
+
+/*
+ * Index space of object type. Free list head, fresh index counter and
+ * object count are modified by every allocation, they are kept on separate
+ * cache lines.
+ */
+
+typedef struct _sai_oid_pool_t
+{
+    uint64_t head __attribute__((aligned(64)));
+
+    uint32_t fresh __attribute__((aligned(64)));
+
+    uint64_t count __attribute__((aligned(64)));
+
+    sai_oid_slot_t *chunks[SAI_OID_CHUNKS] __attribute__((aligned(64)));
+
+} sai_oid_pool_t;
+
+struct _sai_oid_allocator_t
+{
+    sai_oid_pool_t *pools[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+    uint64_t switches[SAI_OID_MAX_SWITCHES / 64];
+};
+
+static sai_object_id_t sai_oid_encode(
+        _In_ size_t type_index,
+        _In_ uint16_t switch_index,
+        _In_ uint32_t generation,
+        _In_ uint32_t index)
+{
+    return ((uint64_t)type_index << SAI_OID_TYPE_SHIFT) |
+        ((uint64_t)switch_index << SAI_OID_SWITCH_SHIFT) |
+        ((uint64_t)(generation & SAI_OID_GENERATION_MASK) << SAI_OID_GENERATION_SHIFT) |
+        (uint64_t)index;
+}
+
+sai_object_type_t sai_oid_object_type(
+        _In_ sai_object_id_t object_id)
+{
+    return sai_metadata_object_type_from_index(SAI_OID_TYPE_INDEX(object_id));
+}
+
+sai_object_id_t sai_oid_switch_id(
+        _In_ sai_object_id_t object_id)
+{
+    if (object_id == SAI_NULL_OBJECT_ID || SAI_OID_TYPE_INDEX(object_id) >= SAI_METADATA_OBJECT_TYPE_INDEX_COUNT)
+    {
+        return SAI_NULL_OBJECT_ID;
+    }
+
+    return sai_oid_encode(SAI_OBJECT_TYPE_SWITCH, SAI_OID_SWITCH_INDEX(object_id), 0, 0);
+}
+
+sai_oid_allocator_t* sai_oid_allocator_open(void)
+{
+    return (sai_oid_allocator_t*)calloc(1, sizeof(sai_oid_allocator_t));
+}
+
+void sai_oid_allocator_close(
+        _Inout_ sai_oid_allocator_t *allocator)
+{
+    size_t type;
+    size_t chunk;
+
+    if (allocator == NULL)
+    {
+        return;
+    }
+
+    for (type = 0; type < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; type++)
+    {
+        sai_oid_pool_t *pool = allocator->pools[type];
+
+        if (pool == NULL)
+        {
+            continue;
+        }
+
+        for (chunk = 0; chunk < SAI_OID_CHUNKS; chunk++)
+        {
+            free(pool->chunks[chunk]);
+        }
+
+        free(pool);
+    }
+
+    free(allocator);
+}
+
+/*
+ * Pools and chunks are created on first use. Thread which loses the race
+ * to install its copy frees it and uses the winner.
+ */
+
+static sai_oid_pool_t* sai_oid_get_pool(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ size_t type_index)
+{
+    sai_oid_pool_t *pool = __atomic_load_n(&allocator->pools[type_index], __ATOMIC_ACQUIRE);
+    sai_oid_pool_t *expected = NULL;
+
+    if (pool != NULL)
+    {
+        return pool;
+    }
+
+    if (posix_memalign((void**)&pool, 64, sizeof(sai_oid_pool_t)) != 0)
+    {
+        return NULL;
+    }
+
+    memset(pool, 0, sizeof(sai_oid_pool_t));
+
+    if (!__atomic_compare_exchange_n(&allocator->pools[type_index], &expected, pool, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(pool);
+
+        return expected;
+    }
+
+    return pool;
+}
+
+static sai_oid_slot_t* sai_oid_get_slot(
+        _In_ const sai_oid_pool_t *pool,
+        _In_ uint32_t index)
+{
+    sai_oid_slot_t *chunk = __atomic_load_n(&pool->chunks[index >> SAI_OID_CHUNK_SHIFT], __ATOMIC_ACQUIRE);
+
+    return (chunk == NULL) ? NULL : &chunk[index & (SAI_OID_CHUNK_SIZE - 1)];
+}
+
+static sai_oid_slot_t* sai_oid_create_slot(
+        _Inout_ sai_oid_pool_t *pool,
+        _In_ uint32_t index)
+{
+    sai_oid_slot_t *slot = sai_oid_get_slot(pool, index);
+    sai_oid_slot_t *chunk;
+    sai_oid_slot_t *expected = NULL;
+
+    if (slot != NULL)
+    {
+        return slot;
+    }
+
+    chunk = (sai_oid_slot_t*)calloc(SAI_OID_CHUNK_SIZE, sizeof(sai_oid_slot_t));
+
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+
+    if (!__atomic_compare_exchange_n(&pool->chunks[index >> SAI_OID_CHUNK_SHIFT], &expected, chunk,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(chunk);
+
+        chunk = expected;
+    }
+
+    return &chunk[index & (SAI_OID_CHUNK_SIZE - 1)];
+}
+
+/*
+ * Pops free slot. Next of popped slot may be changed by other thread which
+ * popped it first, then tag of head has changed as well and compare and
+ * swap fails. Slots are never freed while allocator exists, so reading next
+ * of slot popped by other thread is safe.
+ */
+
+static bool sai_oid_pop(
+        _Inout_ sai_oid_pool_t *pool,
+        _Out_ uint32_t *index)
+{
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+
+    while (SAI_OID_HEAD_NEXT(head) != 0)
+    {
+        uint32_t idx = SAI_OID_HEAD_NEXT(head) - 1;
+
+        uint32_t next = __atomic_load_n(&sai_oid_get_slot(pool, idx)->next, __ATOMIC_RELAXED);
+
+        if (__atomic_compare_exchange_n(&pool->head, &head, SAI_OID_HEAD(SAI_OID_HEAD_TAG(head) + 1, next),
+                    true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            *index = idx;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void sai_oid_push(
+        _Inout_ sai_oid_pool_t *pool,
+        _In_ uint32_t index)
+{
+    sai_oid_slot_t *slot = sai_oid_get_slot(pool, index);
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+
+    do
+    {
+        __atomic_store_n(&slot->next, SAI_OID_HEAD_NEXT(head), __ATOMIC_RELAXED);
+    }
+    while (!__atomic_compare_exchange_n(&pool->head, &head, SAI_OID_HEAD(SAI_OID_HEAD_TAG(head) + 1, index + 1),
+                true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static bool sai_oid_fresh(
+        _Inout_ sai_oid_pool_t *pool,
+        _Out_ uint32_t *index)
+{
+    uint32_t fresh = __atomic_load_n(&pool->fresh, __ATOMIC_RELAXED);
+
+    do
+    {
+        if (fresh >= SAI_OID_MAX_INDEX)
+        {
+            return false;
+        }
+    }
+    while (!__atomic_compare_exchange_n(&pool->fresh, &fresh, fresh + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    *index = fresh;
+
+    return true;
+}
+
+static sai_status_t sai_oid_allocate_switch(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ uint16_t switch_index,
+        _Out_ sai_object_id_t *object_id)
+{
+    uint64_t bit = 1ULL << (switch_index % 64);
+
+    if (__atomic_fetch_or(&allocator->switches[switch_index / 64], bit, __ATOMIC_ACQ_REL) & bit)
+    {
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    *object_id = sai_oid_encode(SAI_OBJECT_TYPE_SWITCH, switch_index, 0, 0);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_oid_allocate(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint16_t switch_index,
+        _Out_ sai_object_id_t *object_id)
+{
+    size_t type_index = sai_metadata_object_type_index(object_type);
+    sai_oid_pool_t *pool;
+    sai_oid_slot_t *slot;
+    uint32_t generation;
+    uint32_t index;
+
+    if (allocator == NULL || object_id == NULL || switch_index >= SAI_OID_MAX_SWITCHES || type_index == 0)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (object_type == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return sai_oid_allocate_switch(allocator, switch_index, object_id);
+    }
+
+    pool = __atomic_load_n(&allocator->pools[type_index], __ATOMIC_ACQUIRE);
+
+    if (pool == NULL)
+    {
+        /* object type is validated once, when its pool is created */
+
+        if (!sai_metadata_is_object_type_oid(object_type))
+        {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        pool = sai_oid_get_pool(allocator, type_index);
+
+        if (pool == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+    }
+
+    if (sai_oid_pop(pool, &index))
+    {
+        slot = sai_oid_get_slot(pool, index);
+    }
+    else if (sai_oid_fresh(pool, &index))
+    {
+        slot = sai_oid_create_slot(pool, index);
+
+        if (slot == NULL)
+        {
+            /* index is lost, chunk allocation fails only when out of memory */
+
+            return SAI_STATUS_NO_MEMORY;
+        }
+    }
+    else
+    {
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    /* slot is owned by this thread now, only stale free may read it */
+
+    generation = __atomic_load_n(&slot->state, __ATOMIC_RELAXED) & SAI_OID_GENERATION_MASK;
+
+    __atomic_store_n(&slot->state, generation | SAI_OID_LIVE, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&pool->count, 1, __ATOMIC_RELAXED);
+
+    *object_id = sai_oid_encode(type_index, switch_index, generation, index);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_oid_free(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ sai_object_id_t object_id)
+{
+    size_t type_index = SAI_OID_TYPE_INDEX(object_id);
+    uint32_t index = SAI_OID_INDEX(object_id);
+    uint32_t expected = SAI_OID_GENERATION(object_id) | SAI_OID_LIVE;
+    sai_oid_pool_t *pool;
+    sai_oid_slot_t *slot;
+
+    if (allocator == NULL || type_index == 0 || type_index >= SAI_METADATA_OBJECT_TYPE_INDEX_COUNT)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (type_index == SAI_OBJECT_TYPE_SWITCH)
+    {
+        uint64_t bit = 1ULL << (SAI_OID_SWITCH_INDEX(object_id) % 64);
+
+        if (object_id != sai_oid_switch_id(object_id) ||
+                !(__atomic_fetch_and(&allocator->switches[SAI_OID_SWITCH_INDEX(object_id) / 64], ~bit, __ATOMIC_ACQ_REL) & bit))
+        {
+            return SAI_STATUS_INVALID_OBJECT_ID;
+        }
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    pool = __atomic_load_n(&allocator->pools[type_index], __ATOMIC_ACQUIRE);
+
+    slot = (pool == NULL) ? NULL : sai_oid_get_slot(pool, index);
+
+    /* only one of concurrent frees of the same object id wins */
+
+    if (slot == NULL ||
+            !__atomic_compare_exchange_n(&slot->state, &expected, (expected + 1) & SAI_OID_GENERATION_MASK,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    __atomic_fetch_sub(&pool->count, 1, __ATOMIC_RELAXED);
+
+    sai_oid_push(pool, index);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+bool sai_oid_is_allocated(
+        _In_ const sai_oid_allocator_t *allocator,
+        _In_ sai_object_id_t object_id)
+{
+    size_t type_index = SAI_OID_TYPE_INDEX(object_id);
+    const sai_oid_pool_t *pool;
+    const sai_oid_slot_t *slot;
+
+    if (allocator == NULL || type_index == 0 || type_index >= SAI_METADATA_OBJECT_TYPE_INDEX_COUNT)
+    {
+        return false;
+    }
+
+    if (type_index == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return object_id == sai_oid_switch_id(object_id) &&
+            (__atomic_load_n(&allocator->switches[SAI_OID_SWITCH_INDEX(object_id) / 64], __ATOMIC_ACQUIRE) &
+             (1ULL << (SAI_OID_SWITCH_INDEX(object_id) % 64))) != 0;
+    }
+
+    pool = __atomic_load_n(&allocator->pools[type_index], __ATOMIC_ACQUIRE);
+
+    slot = (pool == NULL) ? NULL : sai_oid_get_slot(pool, SAI_OID_INDEX(object_id));
+
+    return slot != NULL &&
+        __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == (SAI_OID_GENERATION(object_id) | SAI_OID_LIVE);
+}
+
+uint64_t sai_oid_get_count(
+        _In_ const sai_oid_allocator_t *allocator,
+        _In_ sai_object_type_t object_type)
+{
+    size_t type_index = sai_metadata_object_type_index(object_type);
+    const sai_oid_pool_t *pool;
+    uint64_t count = 0;
+    size_t idx;
+
+    if (allocator == NULL || type_index == 0)
+    {
+        return 0;
+    }
+
+    if (object_type == SAI_OBJECT_TYPE_SWITCH)
+    {
+        for (idx = 0; idx < SAI_OID_MAX_SWITCHES / 64; idx++)
+        {
+            count += (uint64_t)__builtin_popcountll(__atomic_load_n(&allocator->switches[idx], __ATOMIC_RELAXED));
+        }
+
+        return count;
+    }
+
+    pool = __atomic_load_n(&allocator->pools[type_index], __ATOMIC_ACQUIRE);
+
+    return (pool == NULL) ? 0 : __atomic_load_n(&pool->count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saioid.h
+ *
+ * @brief   This module defines SAI object id allocator
+ */
+
+#ifndef __SAIOID_H_
+#define __SAIOID_H_
+
+/**
+ * @defgroup SAIOID SAI - Object id allocator
+ *
+ * Object id encodes type index in bits 63..48, switch index in bits 47..40,
+ * generation in bits 39..24 and index of object within its type in bits
+ * 23..0.
+ *
+ * Type index is object type, extension object types follow
+ * SAI_OBJECT_TYPE_MAX, so object type and switch id are decoded from any
+ * object id by bit extraction, without lookup. Null object id has type
+ * index 0 (SAI_OBJECT_TYPE_NULL) and is never allocated.
+ *
+ * Indexes are allocated per object type and shared by all switches. Freed
+ * index goes to lock free free list of its type and its generation is
+ * incremented, so object id of removed object is detected as stale until
+ * the same index is reused 65536 times. Switch object id is not allocated
+ * from index space, it is the object id of switch index with index and
+ * generation 0, see sai_oid_switch_id.
+ *
+ * Allocate, free and is allocated are lock free and may be called from any
+ * thread. Memory of index space grows in chunks and is released only when
+ * allocator is closed.
+ *
+ * @{
+ */
+
+/**
+ * @brief Shift of type index
+ */
+#define SAI_OID_TYPE_SHIFT          48
+
+/**
+ * @brief Shift of switch index
+ */
+#define SAI_OID_SWITCH_SHIFT        40
+
+/**
+ * @brief Shift of generation
+ */
+#define SAI_OID_GENERATION_SHIFT    24
+
+/**
+ * @brief Maximum number of switches
+ */
+#define SAI_OID_MAX_SWITCHES        256
+
+/**
+ * @brief Maximum number of objects of single type
+ */
+#define SAI_OID_MAX_INDEX           (1U << SAI_OID_GENERATION_SHIFT)
+
+/**
+ * @brief Type index of object id
+ */
+#define SAI_OID_TYPE_INDEX(oid)     ((uint32_t)((uint64_t)(oid) >> SAI_OID_TYPE_SHIFT))
+
+/**
+ * @brief Switch index of object id
+ */
+#define SAI_OID_SWITCH_INDEX(oid)   ((uint32_t)((uint64_t)(oid) >> SAI_OID_SWITCH_SHIFT) & 0xff)
+
+/**
+ * @brief Generation of object id
+ */
+#define SAI_OID_GENERATION(oid)     ((uint32_t)((uint64_t)(oid) >> SAI_OID_GENERATION_SHIFT) & 0xffff)
+
+/**
+ * @brief Index of object id
+ */
+#define SAI_OID_INDEX(oid)          ((uint32_t)(oid) & (SAI_OID_MAX_INDEX - 1))
+
+/**
+ * @brief Opaque object id allocator
+ */
+typedef struct _sai_oid_allocator_t sai_oid_allocator_t;
+
+/**
+ * @brief Create allocator
+ *
+ * @return Allocator or NULL on error
+ */
+extern sai_oid_allocator_t* sai_oid_allocator_open(void);
+
+/**
+ * @brief Destroy allocator
+ *
+ * @param[inout] allocator Allocator
+ */
+extern void sai_oid_allocator_close(
+        _Inout_ sai_oid_allocator_t *allocator);
+
+/**
+ * @brief Allocate object id
+ *
+ * @param[inout] allocator Allocator
+ * @param[in] object_type Object type, must be object id type
+ * @param[in] switch_index Switch index, less than SAI_OID_MAX_SWITCHES
+ * @param[out] object_id Allocated object id
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_TABLE_FULL when index
+ * space of object type is exhausted, #SAI_STATUS_ITEM_ALREADY_EXISTS when
+ * switch of switch index is already allocated, failure status code on
+ * error
+ */
+extern sai_status_t sai_oid_allocate(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint16_t switch_index,
+        _Out_ sai_object_id_t *object_id);
+
+/**
+ * @brief Free object id
+ *
+ * @param[inout] allocator Allocator
+ * @param[in] object_id Object id
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_OBJECT_ID when
+ * object id is not allocated (stale or freed twice)
+ */
+extern sai_status_t sai_oid_free(
+        _Inout_ sai_oid_allocator_t *allocator,
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Check whether object id is allocated
+ *
+ * @param[in] allocator Allocator
+ * @param[in] object_id Object id
+ *
+ * @return True when object id is allocated and not freed
+ */
+extern bool sai_oid_is_allocated(
+        _In_ const sai_oid_allocator_t *allocator,
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Get number of allocated object ids of object type
+ *
+ * @param[in] allocator Allocator
+ * @param[in] object_type Object type
+ *
+ * @return Number of allocated object ids
+ */
+extern uint64_t sai_oid_get_count(
+        _In_ const sai_oid_allocator_t *allocator,
+        _In_ sai_object_type_t object_type);
+
+/**
+ * @brief Decode object type of object id
+ *
+ * Same as sai_object_type_query for object ids of this allocator.
+ *
+ * @param[in] object_id Object id
+ *
+ * @return Object type, SAI_OBJECT_TYPE_NULL for null object id or invalid
+ * type index
+ */
+extern sai_object_type_t sai_oid_object_type(
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Decode switch id of object id
+ *
+ * Same as sai_switch_id_query for object ids of this allocator.
+ *
+ * @param[in] object_id Object id
+ *
+ * @return Switch id, SAI_NULL_OBJECT_ID for null object id or invalid type
+ * index
+ */
+extern sai_object_id_t sai_oid_switch_id(
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @}
+ */
+#endif /** __SAIOID_H_ */
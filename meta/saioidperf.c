@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saioidperf.c
+ *
+ * @brief   This module implements SAI object id allocator performance test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saioid.h"
+
+#define PERF_OBJECTS 100000
+
+#define PERF_ROUNDS 10
+
+#define PERF_MAX_THREADS 16
+
+/*
+ * Every thread allocates its objects, then frees and allocates them again
+ * in rounds, all threads use the same object type, so they share free list.
+ * Baseline is the same free list protected by mutex.
+ */
+
+typedef struct _perf_thread_t
+{
+    sai_object_id_t *oids;
+
+    uint32_t failed;
+
+} perf_thread_t;
+
+static perf_thread_t perf_threads[PERF_MAX_THREADS];
+
+static sai_oid_allocator_t *perf_allocator;
+
+static pthread_mutex_t perf_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t *perf_mutex_free;
+
+static uint32_t perf_mutex_free_count;
+
+static uint32_t perf_mutex_fresh;
+
+static pthread_barrier_t perf_barrier;
+
+static sai_object_id_t perf_mutex_allocate(void)
+{
+    uint32_t index;
+
+    pthread_mutex_lock(&perf_mutex);
+
+    index = perf_mutex_free_count ? perf_mutex_free[--perf_mutex_free_count] : perf_mutex_fresh++;
+
+    pthread_mutex_unlock(&perf_mutex);
+
+    return ((uint64_t)SAI_OBJECT_TYPE_NEXT_HOP << SAI_OID_TYPE_SHIFT) | index;
+}
+
+static void perf_mutex_release(
+        _In_ sai_object_id_t oid)
+{
+    pthread_mutex_lock(&perf_mutex);
+
+    perf_mutex_free[perf_mutex_free_count++] = SAI_OID_INDEX(oid);
+
+    pthread_mutex_unlock(&perf_mutex);
+}
+
+static void* perf_lock_free_thread(
+        _In_ void *arg)
+{
+    perf_thread_t *thread = (perf_thread_t*)arg;
+    uint32_t round;
+    uint32_t idx;
+
+    pthread_barrier_wait(&perf_barrier);
+
+    for (idx = 0; idx < PERF_OBJECTS; idx++)
+    {
+        thread->failed += sai_oid_allocate(perf_allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &thread->oids[idx]) != SAI_STATUS_SUCCESS;
+    }
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_OBJECTS; idx++)
+        {
+            thread->failed += sai_oid_free(perf_allocator, thread->oids[idx]) != SAI_STATUS_SUCCESS;
+            thread->failed += sai_oid_allocate(perf_allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &thread->oids[idx]) != SAI_STATUS_SUCCESS;
+        }
+    }
+
+    for (idx = 0; idx < PERF_OBJECTS; idx++)
+    {
+        thread->failed += sai_oid_free(perf_allocator, thread->oids[idx]) != SAI_STATUS_SUCCESS;
+    }
+
+    return NULL;
+}
+
+static void* perf_mutex_thread(
+        _In_ void *arg)
+{
+    perf_thread_t *thread = (perf_thread_t*)arg;
+    uint32_t round;
+    uint32_t idx;
+
+    pthread_barrier_wait(&perf_barrier);
+
+    for (idx = 0; idx < PERF_OBJECTS; idx++)
+    {
+        thread->oids[idx] = perf_mutex_allocate();
+    }
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < PERF_OBJECTS; idx++)
+        {
+            perf_mutex_release(thread->oids[idx]);
+
+            thread->oids[idx] = perf_mutex_allocate();
+        }
+    }
+
+    for (idx = 0; idx < PERF_OBJECTS; idx++)
+    {
+        perf_mutex_release(thread->oids[idx]);
+    }
+
+    return NULL;
+}
+
+static void perf_run(
+        _In_ const char *name,
+        _In_ void* (*fn)(void*),
+        _In_ uint32_t threads)
+{
+    pthread_t tids[PERF_MAX_THREADS];
+    uint64_t ops = (uint64_t)threads * PERF_OBJECTS * (2 * PERF_ROUNDS + 2);
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t failed = 0;
+    uint32_t idx;
+
+    perf_allocator = sai_oid_allocator_open();
+
+    perf_mutex_free_count = 0;
+    perf_mutex_fresh = 0;
+
+    pthread_barrier_init(&perf_barrier, NULL, threads + 1);
+
+    for (idx = 0; idx < threads; idx++)
+    {
+        perf_threads[idx].failed = 0;
+
+        pthread_create(&tids[idx], NULL, fn, &perf_threads[idx]);
+    }
+
+    pthread_barrier_wait(&perf_barrier);
+
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < threads; idx++)
+    {
+        pthread_join(tids[idx], NULL);
+
+        failed += perf_threads[idx].failed;
+    }
+
+    elapsed = sai_metadata_now() - start;
+
+    pthread_barrier_destroy(&perf_barrier);
+
+    sai_oid_allocator_close(perf_allocator);
+
+    printf("%-12s %2u threads %8.1f ns/op %8.2f Mops/s %8u failed\n",
+            name,
+            threads,
+            (double)elapsed * threads / (double)ops,
+            (double)ops * 1000.0 / (double)elapsed,
+            failed);
+}
+
+/*
+ * Decoding is bit extraction, measured over object ids of all threads.
+ */
+
+static void perf_decode(
+        _In_ const sai_object_id_t *oids,
+        _In_ uint32_t count)
+{
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t failed = 0;
+    uint32_t round;
+    uint32_t idx;
+
+    start = sai_metadata_now();
+
+    for (round = 0; round < PERF_ROUNDS; round++)
+    {
+        for (idx = 0; idx < count; idx++)
+        {
+            failed += sai_oid_object_type(oids[idx]) != SAI_OBJECT_TYPE_NEXT_HOP;
+            failed += sai_oid_switch_id(oids[idx]) == SAI_NULL_OBJECT_ID;
+        }
+    }
+
+    elapsed = sai_metadata_now() - start;
+
+    printf("%-12s %2u threads %8.1f ns/op %8.2f Mops/s %8u failed\n",
+            "decode",
+            1,
+            (double)elapsed / ((double)count * PERF_ROUNDS),
+            (double)count * PERF_ROUNDS * 1000.0 / (double)elapsed,
+            failed);
+}
+
+int main()
+{
+    sai_object_id_t *oids;
+    uint32_t threads;
+    uint32_t idx;
+
+    oids = (sai_object_id_t*)calloc((size_t)PERF_MAX_THREADS * PERF_OBJECTS, sizeof(sai_object_id_t));
+    perf_mutex_free = (uint32_t*)calloc((size_t)PERF_MAX_THREADS * PERF_OBJECTS, sizeof(uint32_t));
+
+    if (oids == NULL || perf_mutex_free == NULL)
+    {
+        fprintf(stderr, "failed to allocate object ids\n");
+        return 1;
+    }
+
+    for (idx = 0; idx < PERF_MAX_THREADS; idx++)
+    {
+        perf_threads[idx].oids = &oids[(size_t)idx * PERF_OBJECTS];
+    }
+
+    for (threads = 1; threads <= PERF_MAX_THREADS; threads *= 2)
+    {
+        perf_run("lock free", perf_lock_free_thread, threads);
+
+        perf_run("mutex", perf_mutex_thread, threads);
+    }
+
+    /* object ids of last run are freed already, decoding does not check allocation */
+
+    perf_decode(oids, PERF_MAX_THREADS * PERF_OBJECTS);
+
+    free(perf_mutex_free);
+    free(oids);
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saioidtest.c
+ *
+ * @brief   This module implements SAI object id allocator tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saioid.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_THREADS 8
+
+#define TEST_THREAD_OBJECTS 1000
+
+#define TEST_THREAD_ROUNDS 200
+
+typedef struct _test_thread_t
+{
+    sai_oid_allocator_t *allocator;
+
+    uint32_t seed;
+
+    sai_object_id_t oids[TEST_THREAD_OBJECTS];
+
+    uint32_t failures;
+
+} test_thread_t;
+
+static void test_decode()
+{
+    sai_oid_allocator_t *allocator = sai_oid_allocator_open();
+    sai_object_id_t switch_id;
+    sai_object_id_t oid;
+
+    ASSERT_TRUE(allocator != NULL, "open");
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_SWITCH, 3, &switch_id) == SAI_STATUS_SUCCESS, "switch");
+    ASSERT_TRUE(sai_oid_object_type(switch_id) == SAI_OBJECT_TYPE_SWITCH, "switch type");
+    ASSERT_TRUE(sai_oid_switch_id(switch_id) == switch_id, "switch id of switch");
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_NEXT_HOP, 3, &oid) == SAI_STATUS_SUCCESS, "next hop");
+    ASSERT_TRUE(oid != SAI_NULL_OBJECT_ID, "null");
+    ASSERT_TRUE(sai_oid_object_type(oid) == SAI_OBJECT_TYPE_NEXT_HOP, "next hop type");
+    ASSERT_TRUE(sai_oid_switch_id(oid) == switch_id, "switch id of next hop");
+    ASSERT_TRUE(SAI_OID_SWITCH_INDEX(oid) == 3, "switch index");
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, (sai_object_type_t)SAI_OBJECT_TYPE_TABLE_BITMAP_ROUTER_ENTRY, 0, &oid) == SAI_STATUS_SUCCESS, "extension");
+    ASSERT_TRUE(sai_oid_object_type(oid) == (sai_object_type_t)SAI_OBJECT_TYPE_TABLE_BITMAP_ROUTER_ENTRY, "extension type");
+
+    ASSERT_TRUE(sai_oid_object_type(SAI_NULL_OBJECT_ID) == SAI_OBJECT_TYPE_NULL, "null type");
+    ASSERT_TRUE(sai_oid_switch_id(SAI_NULL_OBJECT_ID) == SAI_NULL_OBJECT_ID, "null switch");
+    ASSERT_TRUE(sai_oid_object_type(0xffff000000000001ULL) == SAI_OBJECT_TYPE_NULL, "invalid type index");
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, &oid) == SAI_STATUS_INVALID_PARAMETER, "entry");
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_NULL, 0, &oid) == SAI_STATUS_INVALID_PARAMETER, "null");
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_PORT, SAI_OID_MAX_SWITCHES, &oid) == SAI_STATUS_INVALID_PARAMETER, "switch index");
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_SWITCH, 3, &oid) == SAI_STATUS_ITEM_ALREADY_EXISTS, "switch twice");
+
+    ASSERT_TRUE(sai_oid_get_count(allocator, SAI_OBJECT_TYPE_SWITCH) == 1, "switch count");
+    ASSERT_TRUE(sai_oid_free(allocator, switch_id) == SAI_STATUS_SUCCESS, "free switch");
+    ASSERT_TRUE(sai_oid_free(allocator, switch_id) == SAI_STATUS_INVALID_OBJECT_ID, "free switch twice");
+    ASSERT_TRUE(!sai_oid_is_allocated(allocator, switch_id), "freed switch");
+
+    sai_oid_allocator_close(allocator);
+}
+
+static void test_stale()
+{
+    sai_oid_allocator_t *allocator = sai_oid_allocator_open();
+    sai_object_id_t first;
+    sai_object_id_t second;
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &first) == SAI_STATUS_SUCCESS, "allocate");
+    ASSERT_TRUE(sai_oid_is_allocated(allocator, first), "allocated");
+    ASSERT_TRUE(sai_oid_get_count(allocator, SAI_OBJECT_TYPE_NEXT_HOP) == 1, "count");
+
+    ASSERT_TRUE(sai_oid_free(allocator, first) == SAI_STATUS_SUCCESS, "free");
+    ASSERT_TRUE(!sai_oid_is_allocated(allocator, first), "freed");
+    ASSERT_TRUE(sai_oid_free(allocator, first) == SAI_STATUS_INVALID_OBJECT_ID, "double free");
+    ASSERT_TRUE(sai_oid_get_count(allocator, SAI_OBJECT_TYPE_NEXT_HOP) == 0, "count");
+
+    /* index is reused with next generation, old object id stays stale */
+
+    ASSERT_TRUE(sai_oid_allocate(allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &second) == SAI_STATUS_SUCCESS, "allocate");
+    ASSERT_TRUE(SAI_OID_INDEX(second) == SAI_OID_INDEX(first), "index reused");
+    ASSERT_TRUE(SAI_OID_GENERATION(second) == SAI_OID_GENERATION(first) + 1, "generation");
+    ASSERT_TRUE(second != first, "same object id");
+    ASSERT_TRUE(!sai_oid_is_allocated(allocator, first), "stale allocated");
+    ASSERT_TRUE(sai_oid_free(allocator, first) == SAI_STATUS_INVALID_OBJECT_ID, "stale free");
+    ASSERT_TRUE(sai_oid_is_allocated(allocator, second), "reused");
+
+    /* never allocated index */
+
+    ASSERT_TRUE(sai_oid_free(allocator, second + 1) == SAI_STATUS_INVALID_OBJECT_ID, "unknown index");
+    ASSERT_TRUE(!sai_oid_is_allocated(allocator, second + 1), "unknown index");
+    ASSERT_TRUE(sai_oid_free(allocator, SAI_NULL_OBJECT_ID) == SAI_STATUS_INVALID_OBJECT_ID, "null");
+
+    sai_oid_allocator_close(allocator);
+}
+
+static uint32_t test_random(
+        _Inout_ uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+
+    return *seed >> 16;
+}
+
+/*
+ * Each thread keeps own objects and randomly frees and allocates them, so
+ * free lists are popped and pushed by all threads at once.
+ */
+
+static void* test_thread(
+        _In_ void *arg)
+{
+    test_thread_t *thread = (test_thread_t*)arg;
+    uint32_t round;
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_THREAD_OBJECTS; idx++)
+    {
+        thread->failures += sai_oid_allocate(thread->allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &thread->oids[idx]) != SAI_STATUS_SUCCESS;
+    }
+
+    for (round = 0; round < TEST_THREAD_ROUNDS; round++)
+    {
+        for (idx = 0; idx < TEST_THREAD_OBJECTS; idx++)
+        {
+            if (test_random(&thread->seed) % 2)
+            {
+                continue;
+            }
+
+            thread->failures += !sai_oid_is_allocated(thread->allocator, thread->oids[idx]);
+            thread->failures += sai_oid_free(thread->allocator, thread->oids[idx]) != SAI_STATUS_SUCCESS;
+            thread->failures += sai_oid_allocate(thread->allocator, SAI_OBJECT_TYPE_NEXT_HOP, 0, &thread->oids[idx]) != SAI_STATUS_SUCCESS;
+        }
+    }
+
+    return NULL;
+}
+
+static int test_compare_oid(
+        _In_ const void *first,
+        _In_ const void *second)
+{
+    sai_object_id_t a = *(const sai_object_id_t*)first;
+    sai_object_id_t b = *(const sai_object_id_t*)second;
+
+    return (a > b) - (a < b);
+}
+
+static void test_threads()
+{
+    static test_thread_t threads[TEST_THREADS];
+    static sai_object_id_t all[TEST_THREADS * TEST_THREAD_OBJECTS];
+    sai_oid_allocator_t *allocator = sai_oid_allocator_open();
+    pthread_t tids[TEST_THREADS];
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        threads[idx].allocator = allocator;
+        threads[idx].seed = idx + 1;
+
+        ASSERT_TRUE(pthread_create(&tids[idx], NULL, test_thread, &threads[idx]) == 0, "create thread");
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(tids[idx], NULL);
+
+        ASSERT_TRUE(threads[idx].failures == 0, "thread %u failures %u", idx, threads[idx].failures);
+
+        memcpy(&all[idx * TEST_THREAD_OBJECTS], threads[idx].oids, sizeof(threads[idx].oids));
+    }
+
+    ASSERT_TRUE(sai_oid_get_count(allocator, SAI_OBJECT_TYPE_NEXT_HOP) == TEST_THREADS * TEST_THREAD_OBJECTS, "count");
+
+    /* no index is allocated twice, and freed indexes were reused */
+
+    qsort(all, TEST_THREADS * TEST_THREAD_OBJECTS, sizeof(sai_object_id_t), test_compare_oid);
+
+    for (idx = 0; idx < TEST_THREADS * TEST_THREAD_OBJECTS; idx++)
+    {
+        ASSERT_TRUE(SAI_OID_INDEX(all[idx]) < 2 * TEST_THREADS * TEST_THREAD_OBJECTS, "index %u not reused", SAI_OID_INDEX(all[idx]));
+
+        ASSERT_TRUE(idx == 0 || SAI_OID_INDEX(all[idx]) != SAI_OID_INDEX(all[idx - 1]), "index %u twice", SAI_OID_INDEX(all[idx]));
+    }
+
+    sai_oid_allocator_close(allocator);
+}
+
+int main()
+{
+    test_decode();
+
+    test_stale();
+
+    test_threads();
+
+    return 0;
+}
@@ -0,0 +1,825 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saipoller.c
+ *
+ * @brief   This module implements SAI counter poller
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "saipoller.h"
+
+#define SAI_POLLER_DEFAULT_BULK_SIZE 256
+
+#define SAI_POLLER_GROUPS_MIN_SIZE 8
+
+#define SAI_POLLER_ALIGN 64
+
+/*
+ * Vendor list query is repeated with list size it asked for, this many
+ * times at most, in case list grows between calls.
+ */
+
+#define SAI_POLLER_LIST_RETRIES 4
+
+#define SAI_POLLER_NS_PER_SEC 1000000000.0
+
+typedef struct _sai_poller_slice_t
+{
+    uint32_t first;
+
+    uint32_t count;
+
+    uint64_t due;
+
+    uint64_t read_at;
+
+    bool primed;
+
+} sai_poller_slice_t;
+
+/*
+ * Values, deltas and rates are arrays of object_count elements per counter,
+ * counter c of object o is at c * object_count + o.
+ */
+
+typedef struct _sai_poller_group_state_t
+{
+    char *name;
+
+    sai_object_type_t object_type;
+
+    const sai_object_type_info_t *info;
+
+    uint32_t object_count;
+
+    sai_object_key_t *object_keys;
+
+    uint32_t number_of_counters;
+
+    sai_stat_id_t *counter_ids;
+
+    uint64_t interval;
+
+    sai_stats_mode_t mode;
+
+    bool bulk;
+
+    uint64_t *values;
+
+    uint64_t *deltas;
+
+    double *rates;
+
+    sai_status_t *statuses;
+
+    sai_poller_slice_t *slices;
+
+    uint32_t slice_count;
+
+} sai_poller_group_state_t;
+
+struct _sai_poller_t
+{
+    sai_poller_config_t config;
+
+    sai_poller_group_state_t **groups;
+
+    size_t count;
+
+    size_t size;
+
+    /* counters of slice as vendor returns them, object by object */
+
+    uint64_t *scratch;
+
+    size_t scratch_size;
+
+    /* single counter of slice, object by object */
+
+    uint64_t *column;
+
+    sai_status_t *object_statuses;
+
+    sai_poller_stats_t stats;
+};
+
+sai_poller_t* sai_poller_open(
+        _In_ const sai_poller_config_t *config)
+{
+    sai_poller_t *poller;
+
+    if (config == NULL)
+    {
+        SAI_META_LOG_ERROR("invalid poller config");
+
+        return NULL;
+    }
+
+    poller = (sai_poller_t*)calloc(1, sizeof(sai_poller_t));
+
+    if (poller == NULL)
+    {
+        return NULL;
+    }
+
+    poller->config = *config;
+
+    if (poller->config.bulk_size == 0)
+    {
+        poller->config.bulk_size = SAI_POLLER_DEFAULT_BULK_SIZE;
+    }
+
+    poller->column = (uint64_t*)calloc(poller->config.bulk_size, sizeof(uint64_t));
+    poller->object_statuses = (sai_status_t*)calloc(poller->config.bulk_size, sizeof(sai_status_t));
+
+    if (poller->column == NULL || poller->object_statuses == NULL)
+    {
+        sai_poller_close(poller);
+        return NULL;
+    }
+
+    return poller;
+}
+
+static void sai_poller_free_group(
+        _In_ sai_poller_group_state_t *group)
+{
+    if (group == NULL)
+    {
+        return;
+    }
+
+    free(group->name);
+    free(group->object_keys);
+    free(group->counter_ids);
+    free(group->values);
+    free(group->deltas);
+    free(group->rates);
+    free(group->statuses);
+    free(group->slices);
+    free(group);
+}
+
+void sai_poller_close(
+        _Inout_ sai_poller_t *poller)
+{
+    size_t idx;
+
+    if (poller == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < poller->count; idx++)
+    {
+        sai_poller_free_group(poller->groups[idx]);
+    }
+
+    free(poller->groups);
+    free(poller->scratch);
+    free(poller->column);
+    free(poller->object_statuses);
+    free(poller);
+}
+
+static sai_stats_mode_t sai_poller_bulk_mode(
+        _In_ sai_stats_mode_t mode)
+{
+    return mode == SAI_STATS_MODE_READ_AND_CLEAR ? SAI_STATS_MODE_BULK_READ_AND_CLEAR : SAI_STATS_MODE_BULK_READ;
+}
+
+/*
+ * Keeps counters supported in group mode and decides whether all of them
+ * can be read in bulk. When capability can't be queried all counters are
+ * kept and bulk read is tried.
+ */
+
+static sai_status_t sai_poller_discover(
+        _In_ const sai_poller_t *poller,
+        _In_ const sai_poller_group_t *group,
+        _Inout_ sai_poller_group_state_t *state)
+{
+    sai_stat_capability_list_t caps;
+    sai_status_t status = SAI_STATUS_NOT_SUPPORTED;
+    uint32_t retry;
+    uint32_t idx;
+
+    memcpy(state->counter_ids, group->counter_ids, group->number_of_counters * sizeof(sai_stat_id_t));
+
+    state->number_of_counters = group->number_of_counters;
+    state->bulk = poller->config.bulk_object_get_stats != NULL;
+
+    if (poller->config.query_stats_capability == NULL)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    caps.count = (state->info->statenum != NULL) ? (uint32_t)state->info->statenum->valuescount : group->number_of_counters;
+    caps.list = NULL;
+
+    for (retry = 0; retry < SAI_POLLER_LIST_RETRIES; retry++)
+    {
+        free(caps.list);
+
+        caps.list = (sai_stat_capability_t*)calloc(caps.count ? caps.count : 1, sizeof(sai_stat_capability_t));
+
+        if (caps.list == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        status = poller->config.query_stats_capability(poller->config.switch_id, group->object_type, &caps);
+
+        if (status != SAI_STATUS_BUFFER_OVERFLOW)
+        {
+            break;
+        }
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        SAI_META_LOG_NOTICE("stats capability of %s not available, polling all counters", group->name);
+
+        free(caps.list);
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    state->number_of_counters = 0;
+
+    for (idx = 0; idx < group->number_of_counters; idx++)
+    {
+        uint32_t modes = 0;
+        uint32_t cap;
+
+        for (cap = 0; cap < caps.count; cap++)
+        {
+            if (caps.list[cap].stat_enum == group->counter_ids[idx])
+            {
+                modes = caps.list[cap].stat_modes;
+                break;
+            }
+        }
+
+        if (!(modes & (uint32_t)group->mode))
+        {
+            SAI_META_LOG_NOTICE("counter %d of %s is not supported", group->counter_ids[idx], group->name);
+            continue;
+        }
+
+        if (!(modes & (uint32_t)sai_poller_bulk_mode(group->mode)))
+        {
+            state->bulk = false;
+        }
+
+        state->counter_ids[state->number_of_counters++] = group->counter_ids[idx];
+    }
+
+    free(caps.list);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void* sai_poller_alloc_array(
+        _In_ size_t count,
+        _In_ size_t size)
+{
+    size_t bytes = count * size;
+    void *array;
+
+    /* arrays are walked by vector loops, keep them on cache line */
+
+    if (posix_memalign(&array, SAI_POLLER_ALIGN, bytes > 0 ? bytes : 1) != 0)
+    {
+        return NULL;
+    }
+
+    memset(array, 0, bytes);
+
+    return array;
+}
+
+static sai_status_t sai_poller_alloc_group(
+        _Inout_ sai_poller_t *poller,
+        _Inout_ sai_poller_group_state_t *state)
+{
+    size_t total = (size_t)state->number_of_counters * state->object_count;
+    size_t scratch = (size_t)state->number_of_counters * poller->config.bulk_size;
+    uint32_t idx;
+
+    state->values = (uint64_t*)sai_poller_alloc_array(total, sizeof(uint64_t));
+    state->deltas = (uint64_t*)sai_poller_alloc_array(total, sizeof(uint64_t));
+    state->rates = (double*)sai_poller_alloc_array(total, sizeof(double));
+    state->statuses = (sai_status_t*)calloc(state->object_count ? state->object_count : 1, sizeof(sai_status_t));
+
+    state->slice_count = (state->object_count + poller->config.bulk_size - 1) / poller->config.bulk_size;
+    state->slices = (sai_poller_slice_t*)calloc(state->slice_count ? state->slice_count : 1, sizeof(sai_poller_slice_t));
+
+    if (state->values == NULL || state->deltas == NULL || state->rates == NULL ||
+            state->statuses == NULL || state->slices == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < state->object_count; idx++)
+    {
+        state->statuses[idx] = SAI_STATUS_UNINITIALIZED;
+    }
+
+    if (scratch > poller->scratch_size)
+    {
+        uint64_t *buffer = (uint64_t*)sai_poller_alloc_array(scratch, sizeof(uint64_t));
+
+        if (buffer == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        free(poller->scratch);
+
+        poller->scratch = buffer;
+        poller->scratch_size = scratch;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_poller_add_group(
+        _Inout_ sai_poller_t *poller,
+        _In_ const sai_poller_group_t *group,
+        _In_ uint64_t now,
+        _Out_ size_t *index)
+{
+    sai_poller_group_state_t *state;
+    sai_status_t status;
+    uint32_t idx;
+
+    if (poller == NULL || group == NULL || index == NULL || group->name == NULL ||
+            (group->object_count && group->object_list == NULL) ||
+            group->number_of_counters == 0 || group->counter_ids == NULL || group->interval == 0 ||
+            (group->mode != SAI_STATS_MODE_READ && group->mode != SAI_STATS_MODE_READ_AND_CLEAR))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!sai_metadata_is_object_type_oid(group->object_type))
+    {
+        SAI_META_LOG_ERROR("group %s object type is not object id type", group->name);
+
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (poller->count == poller->size)
+    {
+        size_t size = poller->size ? poller->size * 2 : SAI_POLLER_GROUPS_MIN_SIZE;
+        sai_poller_group_state_t **groups = (sai_poller_group_state_t**)realloc(poller->groups, size * sizeof(sai_poller_group_state_t*));
+
+        if (groups == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        poller->groups = groups;
+        poller->size = size;
+    }
+
+    state = (sai_poller_group_state_t*)calloc(1, sizeof(sai_poller_group_state_t));
+
+    if (state == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    state->name = strdup(group->name);
+    state->object_type = group->object_type;
+    state->info = sai_metadata_get_object_type_info(group->object_type);
+    state->object_count = group->object_count;
+    state->object_keys = (sai_object_key_t*)calloc(group->object_count ? group->object_count : 1, sizeof(sai_object_key_t));
+    state->counter_ids = (sai_stat_id_t*)calloc(group->number_of_counters, sizeof(sai_stat_id_t));
+    state->interval = group->interval;
+    state->mode = group->mode;
+
+    if (state->name == NULL || state->object_keys == NULL || state->counter_ids == NULL)
+    {
+        sai_poller_free_group(state);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < group->object_count; idx++)
+    {
+        state->object_keys[idx].key.object_id = group->object_list[idx];
+    }
+
+    status = sai_poller_discover(poller, group, state);
+
+    if (status == SAI_STATUS_SUCCESS && state->number_of_counters == 0)
+    {
+        SAI_META_LOG_ERROR("group %s has no supported counter", group->name);
+
+        status = SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (status == SAI_STATUS_SUCCESS && !state->bulk && poller->config.get_stats_ext == NULL && state->info->getstatsext == NULL)
+    {
+        SAI_META_LOG_ERROR("group %s can't be read in bulk nor by object", group->name);
+
+        status = SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        status = sai_poller_alloc_group(poller, state);
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        sai_poller_free_group(state);
+        return status;
+    }
+
+    /* slices are spread evenly over interval */
+
+    for (idx = 0; idx < state->slice_count; idx++)
+    {
+        sai_poller_slice_t *slice = &state->slices[idx];
+
+        slice->first = idx * poller->config.bulk_size;
+        slice->count = state->object_count - slice->first;
+        slice->count = slice->count < poller->config.bulk_size ? slice->count : poller->config.bulk_size;
+        slice->due = now + state->interval / state->slice_count * idx;
+    }
+
+    poller->groups[poller->count] = state;
+
+    *index = poller->count++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Reads slice into scratch, counters of object o at o * number_of_counters.
+ * Status of every object is set, failed object keeps its scratch row
+ * undefined.
+ */
+
+static void sai_poller_read_slice(
+        _Inout_ sai_poller_t *poller,
+        _Inout_ sai_poller_group_state_t *group,
+        _In_ const sai_poller_slice_t *slice)
+{
+    sai_status_t *statuses = poller->object_statuses;
+    uint32_t n = group->number_of_counters;
+    uint32_t idx;
+
+    if (group->bulk)
+    {
+        sai_status_t status;
+
+        /* vendor which fails whole call may leave object statuses alone */
+
+        for (idx = 0; idx < slice->count; idx++)
+        {
+            statuses[idx] = SAI_STATUS_FAILURE;
+        }
+
+        poller->stats.bulk_calls++;
+
+        status = poller->config.bulk_object_get_stats(poller->config.switch_id, group->object_type, slice->count,
+                &group->object_keys[slice->first], n, group->counter_ids, sai_poller_bulk_mode(group->mode),
+                statuses, poller->scratch);
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            for (idx = 0; idx < slice->count; idx++)
+            {
+                statuses[idx] = SAI_STATUS_SUCCESS;
+            }
+
+            return;
+        }
+
+        if (status != SAI_STATUS_NOT_SUPPORTED && status != SAI_STATUS_NOT_IMPLEMENTED)
+        {
+            return;
+        }
+
+        SAI_META_LOG_NOTICE("bulk stats of %s not implemented, reading by object", group->name);
+
+        group->bulk = false;
+    }
+
+    for (idx = 0; idx < slice->count; idx++)
+    {
+        sai_object_meta_key_t meta_key;
+
+        meta_key.objecttype = group->object_type;
+        meta_key.objectkey.key.object_id = group->object_keys[slice->first + idx].key.object_id;
+
+        poller->stats.object_calls++;
+
+        if (poller->config.get_stats_ext != NULL)
+        {
+            statuses[idx] = poller->config.get_stats_ext(&meta_key, n, group->counter_ids, group->mode, &poller->scratch[(size_t)idx * n]);
+        }
+        else
+        {
+            statuses[idx] = group->info->getstatsext(&meta_key, n, group->counter_ids, group->mode, &poller->scratch[(size_t)idx * n]);
+        }
+    }
+}
+
+/*
+ * Kernels below walk contiguous arrays without branches. Delta kernels are
+ * vectorized at -O3, which saipoller.o is built with (-O2 does not version
+ * loops for possible aliasing). Rate kernel converts uint64 to double, it
+ * is vectorized only with AVX-512DQ, plain x86-64 has no packed conversion.
+ */
+
+static void sai_poller_delta_read(
+        _In_ uint32_t count,
+        _In_ const uint64_t *column,
+        _Inout_ uint64_t *values,
+        _Out_ uint64_t *deltas)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        deltas[idx] = column[idx] - values[idx];
+        values[idx] = column[idx];
+    }
+}
+
+static void sai_poller_delta_clear(
+        _In_ uint32_t count,
+        _In_ const uint64_t *column,
+        _Inout_ uint64_t *values,
+        _Out_ uint64_t *deltas)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        deltas[idx] = column[idx];
+        values[idx] += column[idx];
+    }
+}
+
+static void sai_poller_rate(
+        _In_ uint32_t count,
+        _In_ const uint64_t *deltas,
+        _In_ double scale,
+        _Out_ double *rates)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        rates[idx] = (double)deltas[idx] * scale;
+    }
+}
+
+/*
+ * Column of failed object gets value which yields zero delta: its last
+ * value in read mode, zero in read and clear mode.
+ */
+
+static void sai_poller_apply_slice(
+        _Inout_ sai_poller_t *poller,
+        _Inout_ sai_poller_group_state_t *group,
+        _Inout_ sai_poller_slice_t *slice,
+        _In_ uint64_t now)
+{
+    const sai_status_t *statuses = poller->object_statuses;
+    uint32_t n = group->number_of_counters;
+    double scale = 0;
+    uint32_t counter;
+    uint32_t idx;
+
+    if (slice->primed && now > slice->read_at)
+    {
+        scale = SAI_POLLER_NS_PER_SEC / (double)(now - slice->read_at);
+    }
+
+    for (idx = 0; idx < slice->count; idx++)
+    {
+        group->statuses[slice->first + idx] = statuses[idx];
+
+        if (statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            poller->stats.failures++;
+        }
+    }
+
+    for (counter = 0; counter < n; counter++)
+    {
+        size_t base = (size_t)counter * group->object_count + slice->first;
+        uint64_t *values = &group->values[base];
+        uint64_t *deltas = &group->deltas[base];
+
+        for (idx = 0; idx < slice->count; idx++)
+        {
+            if (statuses[idx] == SAI_STATUS_SUCCESS)
+            {
+                poller->column[idx] = poller->scratch[(size_t)idx * n + counter];
+            }
+            else
+            {
+                poller->column[idx] = group->mode == SAI_STATS_MODE_READ ? values[idx] : 0;
+            }
+        }
+
+        if (group->mode == SAI_STATS_MODE_READ)
+        {
+            sai_poller_delta_read(slice->count, poller->column, values, deltas);
+        }
+        else
+        {
+            sai_poller_delta_clear(slice->count, poller->column, values, deltas);
+        }
+
+        if (!slice->primed)
+        {
+            memset(deltas, 0, slice->count * sizeof(uint64_t));
+        }
+
+        sai_poller_rate(slice->count, deltas, scale, &group->rates[base]);
+    }
+
+    slice->primed = true;
+    slice->read_at = now;
+}
+
+uint32_t sai_poller_poll(
+        _Inout_ sai_poller_t *poller,
+        _In_ uint64_t now)
+{
+    uint32_t reads = 0;
+    size_t idx;
+
+    if (poller == NULL)
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < poller->count; idx++)
+    {
+        sai_poller_group_state_t *group = poller->groups[idx];
+        uint32_t s;
+
+        for (s = 0; s < group->slice_count; s++)
+        {
+            sai_poller_slice_t *slice = &group->slices[s];
+
+            if (slice->due > now)
+            {
+                continue;
+            }
+
+            sai_poller_read_slice(poller, group, slice);
+            sai_poller_apply_slice(poller, group, slice, now);
+
+            poller->stats.reads++;
+            reads++;
+
+            /* keep phase of slice, skip missed intervals */
+
+            slice->due += group->interval;
+
+            if (slice->due <= now)
+            {
+                poller->stats.late++;
+
+                slice->due += (now - slice->due) / group->interval * group->interval + group->interval;
+            }
+        }
+    }
+
+    return reads;
+}
+
+uint64_t sai_poller_next_poll(
+        _In_ const sai_poller_t *poller)
+{
+    uint64_t next = UINT64_MAX;
+    size_t idx;
+
+    if (poller == NULL)
+    {
+        return next;
+    }
+
+    for (idx = 0; idx < poller->count; idx++)
+    {
+        const sai_poller_group_state_t *group = poller->groups[idx];
+        uint32_t s;
+
+        for (s = 0; s < group->slice_count; s++)
+        {
+            next = group->slices[s].due < next ? group->slices[s].due : next;
+        }
+    }
+
+    return next;
+}
+
+sai_status_t sai_poller_get_group_counters(
+        _In_ const sai_poller_t *poller,
+        _In_ size_t index,
+        _Inout_ uint32_t *number_of_counters,
+        _Out_ sai_stat_id_t *counter_ids)
+{
+    const sai_poller_group_state_t *group;
+    uint32_t size;
+
+    if (poller == NULL || index >= poller->count || number_of_counters == NULL || counter_ids == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    group = poller->groups[index];
+    size = *number_of_counters;
+
+    *number_of_counters = group->number_of_counters;
+
+    if (size < group->number_of_counters)
+    {
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    memcpy(counter_ids, group->counter_ids, group->number_of_counters * sizeof(sai_stat_id_t));
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_poller_get_counter(
+        _In_ const sai_poller_t *poller,
+        _In_ size_t index,
+        _In_ sai_stat_id_t counter_id,
+        _Out_ sai_poller_counter_t *counter)
+{
+    const sai_poller_group_state_t *group;
+    uint32_t idx;
+
+    if (poller == NULL || index >= poller->count || counter == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    group = poller->groups[index];
+
+    for (idx = 0; idx < group->number_of_counters; idx++)
+    {
+        size_t base = (size_t)idx * group->object_count;
+
+        if (group->counter_ids[idx] != counter_id)
+        {
+            continue;
+        }
+
+        counter->object_count = group->object_count;
+        counter->values = &group->values[base];
+        counter->deltas = &group->deltas[base];
+        counter->rates = &group->rates[base];
+        counter->statuses = group->statuses;
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    return SAI_STATUS_ITEM_NOT_FOUND;
+}
+
+void sai_poller_get_stats(
+        _In_ const sai_poller_t *poller,
+        _Out_ sai_poller_stats_t *stats)
+{
+    if (poller == NULL || stats == NULL)
+    {
+        return;
+    }
+
+    *stats = poller->stats;
+}
@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saipoller.h
+ *
+ * @brief   This module defines SAI counter poller
+ */
+
+#ifndef __SAIPOLLER_H_
+#define __SAIPOLLER_H_
+
+/**
+ * @defgroup SAIPOLLER SAI - Counter poller
+ *
+ * Poller reads counters of groups of objects of single switch. Group is
+ * object type, object ids, counter ids, interval and statistics mode (read
+ * or read and clear). Counters which sai_query_stats_capability reports
+ * unsupported in group mode are dropped when group is added, group is read
+ * with sai_bulk_object_get_stats when all its counters support bulk mode
+ * and vendor implements it, otherwise object by object with get stats ext
+ * of object type info.
+ *
+ * Objects of group are read in slices of at most bulk size objects, slices
+ * are spread evenly over group interval, so large group does not read all
+ * its counters at once. Values, deltas since previous read and rates per
+ * second are kept in preallocated arrays per counter, indexed by object
+ * (structure of arrays), so consumers and delta computation walk contiguous
+ * memory. In read and clear mode value accumulates deltas.
+ *
+ * Groups live until poller is closed. Functions of poller must be called
+ * from single thread.
+ *
+ * @{
+ */
+
+/**
+ * @brief Poller configuration
+ */
+typedef struct _sai_poller_config_t
+{
+    /**
+     * @brief Switch id
+     */
+    sai_object_id_t switch_id;
+
+    /**
+     * @brief Vendor sai_query_stats_capability, NULL when not supported
+     */
+    sai_status_t (*query_stats_capability)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability);
+
+    /**
+     * @brief Vendor sai_bulk_object_get_stats, NULL when not supported
+     */
+    sai_status_t (*bulk_object_get_stats)(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Inout_ sai_status_t *object_statuses,
+        _Out_ uint64_t *counters);
+
+    /**
+     * @brief Get stats ext of single object, NULL for getstatsext of object type info
+     */
+    sai_status_t (*get_stats_ext)(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Out_ uint64_t *counters);
+
+    /**
+     * @brief Maximum number of objects read at once, 0 for default 256
+     */
+    uint32_t bulk_size;
+
+} sai_poller_config_t;
+
+/**
+ * @brief Counter group
+ */
+typedef struct _sai_poller_group_t
+{
+    /**
+     * @brief Group name, copied
+     */
+    const char *name;
+
+    /**
+     * @brief Object type
+     */
+    sai_object_type_t object_type;
+
+    /**
+     * @brief Number of objects
+     */
+    uint32_t object_count;
+
+    /**
+     * @brief Object ids, copied
+     */
+    const sai_object_id_t *object_list;
+
+    /**
+     * @brief Number of counters
+     */
+    uint32_t number_of_counters;
+
+    /**
+     * @brief Counter ids, copied
+     */
+    const sai_stat_id_t *counter_ids;
+
+    /**
+     * @brief Read interval in nanoseconds
+     */
+    uint64_t interval;
+
+    /**
+     * @brief SAI_STATS_MODE_READ or SAI_STATS_MODE_READ_AND_CLEAR
+     */
+    sai_stats_mode_t mode;
+
+} sai_poller_group_t;
+
+/**
+ * @brief Values of single counter of group, arrays are indexed by object
+ */
+typedef struct _sai_poller_counter_t
+{
+    /**
+     * @brief Number of objects
+     */
+    uint32_t object_count;
+
+    /**
+     * @brief Last read values
+     */
+    const uint64_t *values;
+
+    /**
+     * @brief Difference of last two reads, 0 until object was read twice
+     */
+    const uint64_t *deltas;
+
+    /**
+     * @brief Deltas per second
+     */
+    const double *rates;
+
+    /**
+     * @brief Status of last read of objects
+     */
+    const sai_status_t *statuses;
+
+} sai_poller_counter_t;
+
+/**
+ * @brief Poller statistics
+ */
+typedef struct _sai_poller_stats_t
+{
+    /**
+     * @brief Number of slices read
+     */
+    uint64_t reads;
+
+    /**
+     * @brief Number of sai_bulk_object_get_stats calls
+     */
+    uint64_t bulk_calls;
+
+    /**
+     * @brief Number of get stats ext calls
+     */
+    uint64_t object_calls;
+
+    /**
+     * @brief Number of objects whose read failed
+     */
+    uint64_t failures;
+
+    /**
+     * @brief Number of slices read later than one interval after due time
+     */
+    uint64_t late;
+
+} sai_poller_stats_t;
+
+/**
+ * @brief Opaque poller
+ */
+typedef struct _sai_poller_t sai_poller_t;
+
+/**
+ * @brief Create poller without groups
+ *
+ * @param[in] config Configuration
+ *
+ * @return Poller or NULL on error
+ */
+extern sai_poller_t* sai_poller_open(
+        _In_ const sai_poller_config_t *config);
+
+/**
+ * @brief Destroy poller
+ *
+ * @param[inout] poller Poller
+ */
+extern void sai_poller_close(
+        _Inout_ sai_poller_t *poller);
+
+/**
+ * @brief Add counter group
+ *
+ * Queries stats capability, drops unsupported counters and allocates
+ * buffers. First slice of group is due at now.
+ *
+ * @param[inout] poller Poller
+ * @param[in] group Group
+ * @param[in] now Current time in nanoseconds
+ * @param[out] index Group index
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_NOT_SUPPORTED when no
+ * counter is supported or object type can't be read, failure status code on
+ * error
+ */
+extern sai_status_t sai_poller_add_group(
+        _Inout_ sai_poller_t *poller,
+        _In_ const sai_poller_group_t *group,
+        _In_ uint64_t now,
+        _Out_ size_t *index);
+
+/**
+ * @brief Read slices which are due
+ *
+ * @param[inout] poller Poller
+ * @param[in] now Current time in nanoseconds
+ *
+ * @return Number of slices read
+ */
+extern uint32_t sai_poller_poll(
+        _Inout_ sai_poller_t *poller,
+        _In_ uint64_t now);
+
+/**
+ * @brief Get time when next slice is due
+ *
+ * @param[in] poller Poller
+ *
+ * @return Time in nanoseconds, UINT64_MAX when poller has no groups
+ */
+extern uint64_t sai_poller_next_poll(
+        _In_ const sai_poller_t *poller);
+
+/**
+ * @brief Get counters of group which are polled
+ *
+ * @param[in] poller Poller
+ * @param[in] index Group index
+ * @param[inout] number_of_counters Size of counter ids on input, number of
+ * supported counters on output
+ * @param[out] counter_ids Supported counter ids
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * counter ids are too small, #SAI_STATUS_INVALID_PARAMETER for unknown group
+ */
+extern sai_status_t sai_poller_get_group_counters(
+        _In_ const sai_poller_t *poller,
+        _In_ size_t index,
+        _Inout_ uint32_t *number_of_counters,
+        _Out_ sai_stat_id_t *counter_ids);
+
+/**
+ * @brief Get values of counter of group
+ *
+ * Arrays stay at the same place until poller is closed and are updated by
+ * sai_poller_poll.
+ *
+ * @param[in] poller Poller
+ * @param[in] index Group index
+ * @param[in] counter_id Counter id
+ * @param[out] counter Counter values
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_INVALID_PARAMETER for
+ * unknown group, #SAI_STATUS_ITEM_NOT_FOUND when group does not poll counter
+ */
+extern sai_status_t sai_poller_get_counter(
+        _In_ const sai_poller_t *poller,
+        _In_ size_t index,
+        _In_ sai_stat_id_t counter_id,
+        _Out_ sai_poller_counter_t *counter);
+
+/**
+ * @brief Get poller statistics
+ *
+ * @param[in] poller Poller
+ * @param[out] stats Statistics
+ */
+extern void sai_poller_get_stats(
+        _In_ const sai_poller_t *poller,
+        _Out_ sai_poller_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAIPOLLER_H_ */
@@ -0,0 +1,483 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saipollertest.c
+ *
+ * @brief   This module implements SAI counter poller test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saipoller.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_SWITCH_ID 0x21000000000000ULL
+
+#define TEST_PORT_ID 0x1000000000000ULL
+
+#define TEST_OBJECTS 10
+
+#define TEST_COUNTERS 3
+
+#define TEST_INTERVAL 1000
+
+/*
+ * Vendor counters of ports, port index is in low bits of object id.
+ * Octets support bulk read, unicast packets only read by object, errors
+ * are not supported.
+ */
+
+static uint64_t test_counters[TEST_OBJECTS][TEST_COUNTERS];
+
+static bool test_bulk_implemented = true;
+
+static bool test_ucast_bulk = true;
+
+static uint32_t test_failed_object = UINT32_MAX;
+
+static int test_counter_index(
+        _In_ sai_stat_id_t counter_id)
+{
+    switch (counter_id)
+    {
+        case SAI_PORT_STAT_IF_IN_OCTETS:
+            return 0;
+
+        case SAI_PORT_STAT_IF_IN_UCAST_PKTS:
+            return 1;
+
+        default:
+            return -1;
+    }
+}
+
+static sai_status_t test_query_stats_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ sai_stat_capability_list_t *stats_capability)
+{
+    if (object_type != SAI_OBJECT_TYPE_PORT)
+    {
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (stats_capability->count < 2)
+    {
+        stats_capability->count = 2;
+
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    stats_capability->count = 2;
+
+    stats_capability->list[0].stat_enum = SAI_PORT_STAT_IF_IN_OCTETS;
+    stats_capability->list[0].stat_modes = SAI_STATS_MODE_READ | SAI_STATS_MODE_READ_AND_CLEAR |
+        SAI_STATS_MODE_BULK_READ | SAI_STATS_MODE_BULK_READ_AND_CLEAR;
+
+    stats_capability->list[1].stat_enum = SAI_PORT_STAT_IF_IN_UCAST_PKTS;
+    stats_capability->list[1].stat_modes = SAI_STATS_MODE_READ | SAI_STATS_MODE_READ_AND_CLEAR;
+
+    if (test_ucast_bulk)
+    {
+        stats_capability->list[1].stat_modes |= SAI_STATS_MODE_BULK_READ | SAI_STATS_MODE_BULK_READ_AND_CLEAR;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_read_object(
+        _In_ sai_object_id_t object_id,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ bool clear,
+        _Out_ uint64_t *counters)
+{
+    uint32_t object = (uint32_t)(object_id - TEST_PORT_ID);
+    uint32_t idx;
+
+    if (object >= TEST_OBJECTS || object == test_failed_object)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    for (idx = 0; idx < number_of_counters; idx++)
+    {
+        int counter = test_counter_index(counter_ids[idx]);
+
+        if (counter < 0)
+        {
+            return SAI_STATUS_NOT_SUPPORTED;
+        }
+
+        counters[idx] = test_counters[object][counter];
+
+        if (clear)
+        {
+            test_counters[object][counter] = 0;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t test_bulk_object_get_stats(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Inout_ sai_status_t *object_statuses,
+        _Out_ uint64_t *counters)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t idx;
+
+    if (!test_bulk_implemented)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    ASSERT_TRUE(mode == SAI_STATS_MODE_BULK_READ || mode == SAI_STATS_MODE_BULK_READ_AND_CLEAR, "bulk mode %d", mode);
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        object_statuses[idx] = test_read_object(object_key[idx].key.object_id, number_of_counters, counter_ids,
+                mode == SAI_STATS_MODE_BULK_READ_AND_CLEAR, &counters[idx * number_of_counters]);
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+static sai_status_t test_get_stats_ext(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _In_ sai_stats_mode_t mode,
+        _Out_ uint64_t *counters)
+{
+    ASSERT_TRUE(mode == SAI_STATS_MODE_READ || mode == SAI_STATS_MODE_READ_AND_CLEAR, "object mode %d", mode);
+
+    return test_read_object(meta_key->objectkey.key.object_id, number_of_counters, counter_ids,
+            mode == SAI_STATS_MODE_READ_AND_CLEAR, counters);
+}
+
+static void test_reset(void)
+{
+    memset(test_counters, 0, sizeof(test_counters));
+
+    test_bulk_implemented = true;
+    test_ucast_bulk = true;
+    test_failed_object = UINT32_MAX;
+}
+
+static void test_advance(
+        _In_ uint64_t step)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_OBJECTS; idx++)
+    {
+        test_counters[idx][0] += (idx + 1) * step;
+        test_counters[idx][1] += step;
+    }
+}
+
+static sai_poller_t* test_open(void)
+{
+    sai_poller_config_t config;
+    sai_poller_t *poller;
+
+    memset(&config, 0, sizeof(config));
+
+    config.switch_id = TEST_SWITCH_ID;
+    config.query_stats_capability = test_query_stats_capability;
+    config.bulk_object_get_stats = test_bulk_object_get_stats;
+    config.get_stats_ext = test_get_stats_ext;
+    config.bulk_size = 4;
+
+    poller = sai_poller_open(&config);
+
+    ASSERT_TRUE(poller != NULL, "open");
+
+    return poller;
+}
+
+static size_t test_add_group(
+        _Inout_ sai_poller_t *poller,
+        _In_ sai_stats_mode_t mode)
+{
+    sai_object_id_t objects[TEST_OBJECTS];
+    sai_stat_id_t counters[TEST_COUNTERS];
+    sai_poller_group_t group;
+    size_t index;
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_OBJECTS; idx++)
+    {
+        objects[idx] = TEST_PORT_ID + idx;
+    }
+
+    counters[0] = SAI_PORT_STAT_IF_IN_OCTETS;
+    counters[1] = SAI_PORT_STAT_IF_IN_UCAST_PKTS;
+    counters[2] = SAI_PORT_STAT_IF_IN_ERRORS;
+
+    group.name = "port";
+    group.object_type = SAI_OBJECT_TYPE_PORT;
+    group.object_count = TEST_OBJECTS;
+    group.object_list = objects;
+    group.number_of_counters = TEST_COUNTERS;
+    group.counter_ids = counters;
+    group.interval = TEST_INTERVAL;
+    group.mode = mode;
+
+    ASSERT_TRUE(sai_poller_add_group(poller, &group, 0, &index) == SAI_STATUS_SUCCESS, "add group");
+
+    return index;
+}
+
+static void test_spread(void)
+{
+    sai_poller_counter_t counter;
+    sai_poller_stats_t stats;
+    sai_stat_id_t counter_ids[TEST_COUNTERS];
+    uint32_t number_of_counters = 1;
+    sai_poller_t *poller;
+    size_t index;
+    uint32_t idx;
+
+    test_reset();
+
+    poller = test_open();
+
+    ASSERT_TRUE(sai_poller_next_poll(poller) == UINT64_MAX, "no groups");
+
+    index = test_add_group(poller, SAI_STATS_MODE_READ);
+
+    ASSERT_TRUE(sai_poller_get_group_counters(poller, index, &number_of_counters, counter_ids) == SAI_STATUS_BUFFER_OVERFLOW, "small list");
+    ASSERT_TRUE(sai_poller_get_group_counters(poller, index, &number_of_counters, counter_ids) == SAI_STATUS_SUCCESS, "counters");
+    ASSERT_TRUE(number_of_counters == 2, "unsupported counter dropped: %u", number_of_counters);
+    ASSERT_TRUE(counter_ids[0] == SAI_PORT_STAT_IF_IN_OCTETS && counter_ids[1] == SAI_PORT_STAT_IF_IN_UCAST_PKTS, "counter ids");
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_ERRORS, &counter) == SAI_STATUS_ITEM_NOT_FOUND, "errors");
+
+    /* 10 objects by 4 are 3 slices, a third of interval apart */
+
+    ASSERT_TRUE(sai_poller_next_poll(poller) == 0, "first slice due");
+    ASSERT_TRUE(sai_poller_poll(poller, 0) == 1, "first slice");
+    ASSERT_TRUE(sai_poller_next_poll(poller) == TEST_INTERVAL / 3, "second slice due");
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL / 3 - 1) == 0, "second slice not due");
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL / 3) == 1, "second slice");
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL / 3 * 2) == 1, "third slice");
+    ASSERT_TRUE(sai_poller_next_poll(poller) == TEST_INTERVAL, "first slice due again");
+
+    test_advance(10);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL) == 1, "first slice again");
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_OCTETS, &counter) == SAI_STATUS_SUCCESS, "octets");
+    ASSERT_TRUE(counter.object_count == TEST_OBJECTS, "object count");
+
+    for (idx = 0; idx < TEST_OBJECTS; idx++)
+    {
+        uint64_t delta = idx < 4 ? (idx + 1) * 10 : 0;
+
+        ASSERT_TRUE(counter.statuses[idx] == SAI_STATUS_SUCCESS, "status %u", idx);
+        ASSERT_TRUE(counter.values[idx] == (idx < 4 ? delta : 0), "value %u", idx);
+        ASSERT_TRUE(counter.deltas[idx] == delta, "delta %u: %lu", idx, (unsigned long)counter.deltas[idx]);
+        ASSERT_TRUE((uint64_t)counter.rates[idx] == delta * 1000000000 / TEST_INTERVAL, "rate %u", idx);
+    }
+
+    /* late poll reads all slices once and keeps their phase */
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 4) == 3, "late slices");
+    ASSERT_TRUE(sai_poller_next_poll(poller) == TEST_INTERVAL * 4 + TEST_INTERVAL / 3, "late phase");
+
+    sai_poller_get_stats(poller, &stats);
+
+    ASSERT_TRUE(stats.reads == 7, "reads %lu", (unsigned long)stats.reads);
+    ASSERT_TRUE(stats.bulk_calls == 7 && stats.object_calls == 0, "bulk calls");
+    ASSERT_TRUE(stats.late == 3, "late %lu", (unsigned long)stats.late);
+
+    sai_poller_close(poller);
+}
+
+static void test_fallback(void)
+{
+    sai_poller_counter_t counter;
+    sai_poller_stats_t stats;
+    sai_object_id_t object = TEST_PORT_ID;
+    sai_stat_id_t counter_id = SAI_PORT_STAT_IF_IN_ERRORS;
+    sai_poller_group_t group;
+    sai_poller_t *poller;
+    size_t index;
+
+    test_reset();
+
+    /* counter without bulk capability is read by object */
+
+    test_ucast_bulk = false;
+
+    poller = test_open();
+    index = test_add_group(poller, SAI_STATS_MODE_READ);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL) == 3, "all slices");
+
+    sai_poller_get_stats(poller, &stats);
+
+    ASSERT_TRUE(stats.bulk_calls == 0 && stats.object_calls == TEST_OBJECTS, "object calls");
+
+    test_advance(5);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 2) == 3, "all slices again");
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_UCAST_PKTS, &counter) == SAI_STATUS_SUCCESS, "ucast");
+    ASSERT_TRUE(counter.deltas[9] == 5, "ucast delta");
+
+    /* group of unsupported counters is refused */
+
+    group.name = "errors";
+    group.object_type = SAI_OBJECT_TYPE_PORT;
+    group.object_count = 1;
+    group.object_list = &object;
+    group.number_of_counters = 1;
+    group.counter_ids = &counter_id;
+    group.interval = TEST_INTERVAL;
+    group.mode = SAI_STATS_MODE_READ;
+
+    ASSERT_TRUE(sai_poller_add_group(poller, &group, 0, &index) == SAI_STATUS_NOT_SUPPORTED, "no counters");
+
+    sai_poller_close(poller);
+
+    /* vendor without bulk implementation is read by object after first try */
+
+    test_reset();
+
+    test_bulk_implemented = false;
+
+    poller = test_open();
+    index = test_add_group(poller, SAI_STATS_MODE_READ);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL) == 3, "all slices");
+
+    test_advance(7);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 2) == 3, "all slices again");
+
+    sai_poller_get_stats(poller, &stats);
+
+    ASSERT_TRUE(stats.bulk_calls == 1, "bulk calls %lu", (unsigned long)stats.bulk_calls);
+    ASSERT_TRUE(stats.object_calls == TEST_OBJECTS * 2, "object calls %lu", (unsigned long)stats.object_calls);
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_OCTETS, &counter) == SAI_STATUS_SUCCESS, "octets");
+    ASSERT_TRUE(counter.deltas[2] == 21, "octets delta");
+
+    sai_poller_close(poller);
+}
+
+static void test_clear(void)
+{
+    sai_poller_counter_t counter;
+    sai_poller_t *poller;
+    size_t index;
+
+    test_reset();
+
+    poller = test_open();
+    index = test_add_group(poller, SAI_STATS_MODE_READ_AND_CLEAR);
+
+    test_advance(3);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL) == 3, "first read");
+
+    test_advance(4);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 2) == 3, "second read");
+    ASSERT_TRUE(test_counters[5][0] == 0, "vendor counter cleared");
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_OCTETS, &counter) == SAI_STATUS_SUCCESS, "octets");
+    ASSERT_TRUE(counter.values[5] == 6 * 7, "value accumulated: %lu", (unsigned long)counter.values[5]);
+    ASSERT_TRUE(counter.deltas[5] == 6 * 4, "delta read: %lu", (unsigned long)counter.deltas[5]);
+
+    sai_poller_close(poller);
+}
+
+static void test_failure(void)
+{
+    sai_poller_counter_t counter;
+    sai_poller_stats_t stats;
+    sai_poller_t *poller;
+    size_t index;
+
+    test_reset();
+
+    poller = test_open();
+    index = test_add_group(poller, SAI_STATS_MODE_READ);
+
+    test_advance(1);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL) == 3, "first read");
+
+    test_failed_object = 2;
+
+    test_advance(1);
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 2) == 3, "second read");
+    ASSERT_TRUE(sai_poller_get_counter(poller, index, SAI_PORT_STAT_IF_IN_OCTETS, &counter) == SAI_STATUS_SUCCESS, "octets");
+    ASSERT_TRUE(counter.statuses[2] == SAI_STATUS_FAILURE, "failed status");
+    ASSERT_TRUE(counter.values[2] == 3 && counter.deltas[2] == 0, "failed object keeps value");
+    ASSERT_TRUE(counter.statuses[3] == SAI_STATUS_SUCCESS && counter.deltas[3] == 4, "other objects in slice");
+
+    test_failed_object = UINT32_MAX;
+
+    ASSERT_TRUE(sai_poller_poll(poller, TEST_INTERVAL * 3) == 3, "third read");
+    ASSERT_TRUE(counter.statuses[2] == SAI_STATUS_SUCCESS && counter.deltas[2] == 3, "recovered object");
+
+    sai_poller_get_stats(poller, &stats);
+
+    ASSERT_TRUE(stats.failures == 1, "failures %lu", (unsigned long)stats.failures);
+
+    sai_poller_close(poller);
+}
+
+int main(void)
+{
+    test_spread();
+
+    test_fallback();
+
+    test_clear();
+
+    test_failure();
+
+    return 0;
+}
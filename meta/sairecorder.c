@@ -0,0 +1,1001 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairecorder.c
+ *
+ * @brief   This module implements SAI binary call recorder
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "saimetadata.h"
+#include "saiversion.h"
+#include "sairecorder.h"
+
+#define SAI_RECORDER_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+#define SAI_RECORDER_MAX_LISTS 2
+
+#define SAI_RECORDER_MAX_RECORD_SIZE (64 * 1024 * 1024)
+
+#define SAI_RECORDER_DRAIN_INTERVAL_NS 1000000
+
+#define SAI_RECORDER_ADD(var, value) \
+    __atomic_store_n(&(var), __atomic_load_n(&(var), __ATOMIC_RELAXED) + (value), __ATOMIC_RELAXED)
+
+/*
+ * Every list in attribute value has the same layout, count followed by
+ * pointer, so single descriptor (offset of list inside value and size of
+ * element) is enough to copy any of them.
+ */
+
+typedef struct _sai_recorder_list_t
+{
+    uint32_t count;
+
+    void *list;
+
+} sai_recorder_list_t;
+
+typedef struct _sai_recorder_list_desc_t
+{
+    size_t offset;
+
+    size_t element_size;
+
+} sai_recorder_list_desc_t;
+
+/*
+ * Single producer single consumer ring. Producer is owning thread, consumer
+ * is writer thread. Head and tail are free running byte counters, they are
+ * kept on separate cache lines, so producer and consumer do not share line
+ * on every record.
+ */
+
+typedef struct _sai_recorder_ring_t
+{
+    struct _sai_recorder_ring_t *next;
+
+    uint8_t *buffer;
+
+    uint64_t size;
+
+    uint64_t head __attribute__((aligned(64)));
+
+    uint64_t cached_tail;
+
+    uint32_t lost;
+
+    uint64_t recorded;
+
+    uint64_t dropped;
+
+    uint64_t tail __attribute__((aligned(64)));
+
+} sai_recorder_ring_t;
+
+/*
+ * Rings are allocated on first record made by thread and never freed, so
+ * writer can walk them without synchronization with thread exit.
+ */
+
+static sai_recorder_ring_t *sai_recorder_rings = NULL;
+
+static __thread sai_recorder_ring_t *sai_recorder_current_ring = NULL;
+
+static int sai_recorder_running = 0;
+
+static uint64_t sai_recorder_sequence = 0;
+
+static pthread_mutex_t sai_recorder_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t sai_recorder_writer_thread;
+
+static sai_recorder_config_t sai_recorder_config;
+
+static char sai_recorder_path[PATH_MAX];
+
+static uint32_t sai_recorder_ring_size = SAI_RECORDER_DEFAULT_RING_SIZE;
+
+static gzFile sai_recorder_file = NULL;
+
+static uint64_t sai_recorder_file_bytes = 0;
+
+static uint64_t sai_recorder_written = 0;
+
+static uint64_t sai_recorder_bytes = 0;
+
+static int sai_recorder_get_lists(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t *value,
+        _Out_ sai_recorder_list_desc_t *lists)
+{
+    size_t offsets[SAI_RECORDER_MAX_LISTS];
+    size_t element_sizes[SAI_RECORDER_MAX_LISTS];
+    uint32_t count;
+    uint32_t idx;
+
+    count = sai_metadata_get_attr_value_lists(md, value, offsets, element_sizes);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        lists[idx].offset = offsets[idx];
+        lists[idx].element_size = element_sizes[idx];
+    }
+
+    return (int)count;
+}
+
+static sai_recorder_list_t sai_recorder_list_get(
+        _In_ const sai_attribute_value_t *value,
+        _In_ const sai_recorder_list_desc_t *desc)
+{
+    sai_recorder_list_t list;
+
+    memcpy(&list, (const uint8_t*)value + desc->offset, sizeof(list));
+
+    return list;
+}
+
+static void sai_recorder_list_set_pointer(
+        _Inout_ sai_attribute_value_t *value,
+        _In_ const sai_recorder_list_desc_t *desc,
+        _In_ void *pointer)
+{
+    memcpy((uint8_t*)value + desc->offset + offsetof(sai_recorder_list_t, list), &pointer, sizeof(pointer));
+}
+
+static int sai_recorder_has_payload(
+        _In_ const sai_recorder_list_t *list)
+{
+    return list->list != NULL && list->count != 0;
+}
+
+/*
+ * Size of list payloads of single attribute, 0 if attribute has no lists.
+ */
+
+static size_t sai_recorder_attr_payload_size(
+        _In_ sai_object_type_t object_type,
+        _In_ const sai_attribute_t *attr)
+{
+    sai_recorder_list_desc_t lists[SAI_RECORDER_MAX_LISTS];
+    size_t size = 0;
+    int count;
+    int idx;
+
+    count = sai_recorder_get_lists(sai_metadata_get_attr_metadata(object_type, attr->id), &attr->value, lists);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        sai_recorder_list_t list = sai_recorder_list_get(&attr->value, &lists[idx]);
+
+        if (sai_recorder_has_payload(&list))
+        {
+            size += SAI_RECORDER_ALIGN((size_t)list.count * lists[idx].element_size);
+        }
+    }
+
+    return size;
+}
+
+static sai_recorder_ring_t* sai_recorder_get_ring(void)
+{
+    sai_recorder_ring_t *ring = sai_recorder_current_ring;
+
+    if (ring != NULL)
+    {
+        return ring;
+    }
+
+    ring = (sai_recorder_ring_t*)calloc(1, sizeof(sai_recorder_ring_t));
+
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+
+    ring->size = __atomic_load_n(&sai_recorder_ring_size, __ATOMIC_RELAXED);
+
+    ring->buffer = (uint8_t*)malloc(ring->size);
+
+    if (ring->buffer == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    /* lock free push, rings are never removed from the list */
+
+    ring->next = __atomic_load_n(&sai_recorder_rings, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&sai_recorder_rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+
+    sai_recorder_current_ring = ring;
+
+    return ring;
+}
+
+/*
+ * Reserve contiguous space for record, writes padding record when record
+ * does not fit before end of buffer. Returns NULL when ring is full.
+ */
+
+static uint8_t* sai_recorder_ring_reserve(
+        _Inout_ sai_recorder_ring_t *ring,
+        _In_ size_t size,
+        _Out_ uint64_t *total)
+{
+    uint64_t head = ring->head;
+    uint64_t pos = head & (ring->size - 1);
+    uint64_t contiguous = ring->size - pos;
+    uint64_t need = (size > contiguous) ? contiguous + size : size;
+
+    if (size > ring->size)
+    {
+        return NULL;
+    }
+
+    if (ring->size - (head - ring->cached_tail) < need)
+    {
+        ring->cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        if (ring->size - (head - ring->cached_tail) < need)
+        {
+            return NULL;
+        }
+    }
+
+    *total = need;
+
+    if (size > contiguous)
+    {
+        sai_recorder_record_header_t padding;
+
+        padding.size = (uint32_t)contiguous;
+        padding.flags = SAI_RECORDER_FLAG_PADDING;
+
+        /* only size and flags are read by consumer */
+
+        memcpy(ring->buffer + pos, &padding, offsetof(sai_recorder_record_header_t, sequence));
+
+        return ring->buffer;
+    }
+
+    return ring->buffer + pos;
+}
+
+void sai_recorder_record(
+        _In_ sai_common_api_t api,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ sai_status_t status)
+{
+    sai_recorder_ring_t *ring;
+    sai_recorder_record_header_t *header;
+    struct timespec ts;
+    uint8_t *record;
+    uint8_t *payload;
+    uint64_t total = 0;
+    size_t attrs_size;
+    size_t size;
+    uint32_t idx;
+    int lists;
+
+    if (!__atomic_load_n(&sai_recorder_running, __ATOMIC_ACQUIRE) || meta_key == NULL)
+    {
+        return;
+    }
+
+    ring = sai_recorder_get_ring();
+
+    if (ring == NULL)
+    {
+        return;
+    }
+
+    if (attr_list == NULL)
+    {
+        attr_count = 0;
+    }
+
+    /* get fills lists only on success, on failure they are undefined */
+
+    lists = (api != SAI_COMMON_API_GET && api != SAI_COMMON_API_BULK_GET) || status == SAI_STATUS_SUCCESS;
+
+    attrs_size = (size_t)attr_count * sizeof(sai_attribute_t);
+
+    size = sizeof(sai_recorder_record_header_t) + attrs_size;
+
+    for (idx = 0; lists && idx < attr_count; idx++)
+    {
+        size += sai_recorder_attr_payload_size(meta_key->objecttype, &attr_list[idx]);
+    }
+
+    record = (size <= SAI_RECORDER_MAX_RECORD_SIZE) ? sai_recorder_ring_reserve(ring, size, &total) : NULL;
+
+    if (record == NULL)
+    {
+        ring->lost++;
+
+        SAI_RECORDER_ADD(ring->dropped, 1);
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    header = (sai_recorder_record_header_t*)record;
+
+    header->size = (uint32_t)size;
+    header->flags = lists ? SAI_RECORDER_FLAG_LISTS : 0;
+    header->sequence = __atomic_fetch_add(&sai_recorder_sequence, 1, __ATOMIC_RELAXED);
+    header->timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    header->api = (int32_t)api;
+    header->status = (int32_t)status;
+    header->attr_count = attr_count;
+    header->lost = ring->lost;
+    header->switch_id = switch_id;
+
+    memcpy(&header->meta_key, meta_key, sizeof(sai_object_meta_key_t));
+
+    memcpy(record + sizeof(sai_recorder_record_header_t), attr_list, attrs_size);
+
+    payload = record + sizeof(sai_recorder_record_header_t) + attrs_size;
+
+    for (idx = 0; lists && idx < attr_count; idx++)
+    {
+        sai_recorder_list_desc_t descs[SAI_RECORDER_MAX_LISTS];
+        const sai_attribute_t *attr = &attr_list[idx];
+        int count;
+        int n;
+
+        count = sai_recorder_get_lists(sai_metadata_get_attr_metadata(meta_key->objecttype, attr->id), &attr->value, descs);
+
+        for (n = 0; n < count; n++)
+        {
+            sai_recorder_list_t list = sai_recorder_list_get(&attr->value, &descs[n]);
+            size_t bytes;
+
+            if (!sai_recorder_has_payload(&list))
+            {
+                continue;
+            }
+
+            bytes = (size_t)list.count * descs[n].element_size;
+
+            memcpy(payload, list.list, bytes);
+
+            payload += SAI_RECORDER_ALIGN(bytes);
+        }
+    }
+
+    ring->lost = 0;
+
+    SAI_RECORDER_ADD(ring->recorded, 1);
+
+    __atomic_store_n(&ring->head, ring->head + total, __ATOMIC_RELEASE);
+}
+
+static sai_status_t sai_recorder_write(
+        _In_ const void *data,
+        _In_ size_t size)
+{
+    if (size == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (gzwrite(sai_recorder_file, data, (unsigned)size) != (int)size)
+    {
+        SAI_META_LOG_ERROR("failed to write %zu bytes to %s", size, sai_recorder_path);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_recorder_open_file(void)
+{
+    sai_recorder_file_header_t header;
+    char mode[8];
+
+    if (sai_recorder_config.compression == 0)
+    {
+        snprintf(mode, sizeof(mode), "wbT");
+    }
+    else
+    {
+        snprintf(mode, sizeof(mode), "wb%u", sai_recorder_config.compression > 9 ? 9 : sai_recorder_config.compression);
+    }
+
+    sai_recorder_file = gzopen(sai_recorder_path, mode);
+
+    if (sai_recorder_file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", sai_recorder_path, strerror(errno));
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, SAI_RECORDER_MAGIC, sizeof(header.magic));
+
+    header.version = SAI_RECORDER_VERSION;
+    header.attribute_size = (uint32_t)sizeof(sai_attribute_t);
+    header.meta_key_size = (uint32_t)sizeof(sai_object_meta_key_t);
+    header.api_version = SAI_API_VERSION;
+
+    sai_recorder_file_bytes = 0;
+
+    return sai_recorder_write(&header, sizeof(header));
+}
+
+/*
+ * Rotation works like logrotate, path.N-1 is renamed to path.N, and so on,
+ * current file becomes path.1, oldest file is removed.
+ */
+
+static void sai_recorder_rotate(void)
+{
+    char from[PATH_MAX + 16];
+    char to[PATH_MAX + 16];
+    uint32_t idx;
+
+    gzclose(sai_recorder_file);
+
+    sai_recorder_file = NULL;
+
+    if (sai_recorder_config.max_files == 0)
+    {
+        remove(sai_recorder_path);
+    }
+
+    for (idx = sai_recorder_config.max_files; idx > 0; idx--)
+    {
+        if (idx == 1)
+        {
+            snprintf(from, sizeof(from), "%s", sai_recorder_path);
+        }
+        else
+        {
+            snprintf(from, sizeof(from), "%s.%u", sai_recorder_path, idx - 1);
+        }
+
+        snprintf(to, sizeof(to), "%s.%u", sai_recorder_path, idx);
+
+        rename(from, to);
+    }
+
+    sai_recorder_open_file();
+}
+
+/*
+ * Write all complete records of single ring, returns number of records.
+ */
+
+static uint64_t sai_recorder_drain(
+        _Inout_ sai_recorder_ring_t *ring)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->tail;
+    uint64_t count = 0;
+
+    while (tail != head)
+    {
+        const uint8_t *record = ring->buffer + (tail & (ring->size - 1));
+        sai_recorder_record_header_t header;
+
+        memcpy(&header, record, offsetof(sai_recorder_record_header_t, sequence));
+
+        if ((header.flags & SAI_RECORDER_FLAG_PADDING) == 0 && sai_recorder_file != NULL)
+        {
+            if (sai_recorder_write(record, header.size) == SAI_STATUS_SUCCESS)
+            {
+                sai_recorder_file_bytes += header.size;
+
+                SAI_RECORDER_ADD(sai_recorder_written, 1);
+                SAI_RECORDER_ADD(sai_recorder_bytes, header.size);
+            }
+
+            count++;
+
+            if (sai_recorder_config.max_file_size != 0 && sai_recorder_file_bytes >= sai_recorder_config.max_file_size)
+            {
+                sai_recorder_rotate();
+            }
+        }
+
+        tail += header.size;
+
+        /* release space as soon as possible, so producer does not drop */
+
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+static uint64_t sai_recorder_drain_all(void)
+{
+    sai_recorder_ring_t *ring = __atomic_load_n(&sai_recorder_rings, __ATOMIC_ACQUIRE);
+    uint64_t count = 0;
+
+    for (; ring != NULL; ring = ring->next)
+    {
+        count += sai_recorder_drain(ring);
+    }
+
+    return count;
+}
+
+static void* sai_recorder_writer(
+        _In_ void *arg)
+{
+    struct timespec interval = { 0, SAI_RECORDER_DRAIN_INTERVAL_NS };
+
+    while (__atomic_load_n(&sai_recorder_running, __ATOMIC_ACQUIRE))
+    {
+        /*
+         * Writer sleeps even when there was work, draining in batches keeps
+         * it away from cache lines producer is writing right now.
+         */
+
+        sai_recorder_drain_all();
+
+        nanosleep(&interval, NULL);
+    }
+
+    /* records made before stop */
+
+    sai_recorder_drain_all();
+
+    return NULL;
+}
+
+sai_status_t sai_recorder_start(
+        _In_ const sai_recorder_config_t *config)
+{
+    sai_status_t status;
+    uint32_t ring_size = 4096;
+
+    if (config == NULL || config->path == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (strlen(config->path) >= sizeof(sai_recorder_path))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&sai_recorder_mutex);
+
+    if (__atomic_load_n(&sai_recorder_running, __ATOMIC_RELAXED))
+    {
+        pthread_mutex_unlock(&sai_recorder_mutex);
+
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    sai_recorder_config = *config;
+
+    snprintf(sai_recorder_path, sizeof(sai_recorder_path), "%s", config->path);
+
+    sai_recorder_config.path = sai_recorder_path;
+
+    while (ring_size < config->ring_size && ring_size < (1U << 31))
+    {
+        ring_size <<= 1;
+    }
+
+    /* affects only threads which did not record yet */
+
+    __atomic_store_n(&sai_recorder_ring_size, config->ring_size ? ring_size : SAI_RECORDER_DEFAULT_RING_SIZE, __ATOMIC_RELAXED);
+
+    status = sai_recorder_open_file();
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        if (sai_recorder_file != NULL)
+        {
+            gzclose(sai_recorder_file);
+            sai_recorder_file = NULL;
+        }
+
+        pthread_mutex_unlock(&sai_recorder_mutex);
+
+        return status;
+    }
+
+    __atomic_store_n(&sai_recorder_running, 1, __ATOMIC_RELEASE);
+
+    if (pthread_create(&sai_recorder_writer_thread, NULL, sai_recorder_writer, NULL) != 0)
+    {
+        __atomic_store_n(&sai_recorder_running, 0, __ATOMIC_RELEASE);
+
+        gzclose(sai_recorder_file);
+        sai_recorder_file = NULL;
+
+        pthread_mutex_unlock(&sai_recorder_mutex);
+
+        SAI_META_LOG_ERROR("failed to create recorder writer thread");
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    pthread_mutex_unlock(&sai_recorder_mutex);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_recorder_stop(void)
+{
+    pthread_mutex_lock(&sai_recorder_mutex);
+
+    if (!__atomic_load_n(&sai_recorder_running, __ATOMIC_RELAXED))
+    {
+        pthread_mutex_unlock(&sai_recorder_mutex);
+        return;
+    }
+
+    /*
+     * Record racing with stop may stay in ring, it will be written to file
+     * on next start.
+     */
+
+    __atomic_store_n(&sai_recorder_running, 0, __ATOMIC_RELEASE);
+
+    pthread_join(sai_recorder_writer_thread, NULL);
+
+    if (sai_recorder_file != NULL)
+    {
+        gzclose(sai_recorder_file);
+        sai_recorder_file = NULL;
+    }
+
+    pthread_mutex_unlock(&sai_recorder_mutex);
+}
+
+void sai_recorder_get_stats(
+        _Out_ sai_recorder_stats_t *stats)
+{
+    sai_recorder_ring_t *ring = __atomic_load_n(&sai_recorder_rings, __ATOMIC_ACQUIRE);
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (; ring != NULL; ring = ring->next)
+    {
+        stats->recorded += __atomic_load_n(&ring->recorded, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+
+    stats->written = __atomic_load_n(&sai_recorder_written, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&sai_recorder_bytes, __ATOMIC_RELAXED);
+}
+
+struct _sai_recorder_reader_t
+{
+    gzFile file;
+
+    uint8_t *buffer;
+
+    size_t capacity;
+};
+
+sai_recorder_reader_t* sai_recorder_reader_open(
+        _In_ const char *path)
+{
+    sai_recorder_file_header_t header;
+    sai_recorder_reader_t *reader;
+    gzFile file;
+
+    file = gzopen(path, "rb");
+
+    if (file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", path, strerror(errno));
+
+        return NULL;
+    }
+
+    if (gzread(file, &header, sizeof(header)) != (int)sizeof(header) ||
+            memcmp(header.magic, SAI_RECORDER_MAGIC, sizeof(header.magic)) != 0)
+    {
+        SAI_META_LOG_ERROR("%s is not recorder file", path);
+
+        gzclose(file);
+        return NULL;
+    }
+
+    if (header.version != SAI_RECORDER_VERSION ||
+            header.attribute_size != sizeof(sai_attribute_t) ||
+            header.meta_key_size != sizeof(sai_object_meta_key_t))
+    {
+        SAI_META_LOG_ERROR("%s was recorded by incompatible build, version %u, api version %" PRIu64,
+                path, header.version, header.api_version);
+
+        gzclose(file);
+        return NULL;
+    }
+
+    if (header.api_version != SAI_API_VERSION)
+    {
+        SAI_META_LOG_WARN("%s was recorded with api version %" PRIu64 ", attribute ids may differ",
+                path, header.api_version);
+    }
+
+    reader = (sai_recorder_reader_t*)calloc(1, sizeof(sai_recorder_reader_t));
+
+    if (reader == NULL)
+    {
+        gzclose(file);
+        return NULL;
+    }
+
+    reader->file = file;
+
+    return reader;
+}
+
+sai_status_t sai_recorder_reader_next(
+        _Inout_ sai_recorder_reader_t *reader,
+        _Out_ sai_recorder_record_t *record)
+{
+    sai_recorder_record_header_t header;
+    sai_attribute_t *attr_list;
+    uint8_t *payload;
+    uint8_t *end;
+    size_t attrs_size;
+    size_t body;
+    uint32_t idx;
+    int ret;
+
+    ret = gzread(reader->file, &header, sizeof(header));
+
+    if (ret == 0)
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (ret != (int)sizeof(header) || header.size < sizeof(header) || header.size > SAI_RECORDER_MAX_RECORD_SIZE)
+    {
+        SAI_META_LOG_ERROR("truncated or corrupted record");
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    body = header.size - sizeof(header);
+
+    attrs_size = (size_t)header.attr_count * sizeof(sai_attribute_t);
+
+    if (attrs_size > body)
+    {
+        SAI_META_LOG_ERROR("record %" PRIu64 " attributes exceed record size", header.sequence);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    if (body > reader->capacity)
+    {
+        uint8_t *buffer = (uint8_t*)realloc(reader->buffer, body);
+
+        if (buffer == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        reader->buffer = buffer;
+        reader->capacity = body;
+    }
+
+    if (body != 0 && gzread(reader->file, reader->buffer, (unsigned)body) != (int)body)
+    {
+        SAI_META_LOG_ERROR("truncated record %" PRIu64, header.sequence);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    attr_list = (sai_attribute_t*)reader->buffer;
+
+    payload = reader->buffer + attrs_size;
+
+    end = reader->buffer + body;
+
+    /* payloads follow attributes in the same order as they were written */
+
+    for (idx = 0; idx < header.attr_count; idx++)
+    {
+        sai_recorder_list_desc_t descs[SAI_RECORDER_MAX_LISTS];
+        sai_attribute_t *attr = &attr_list[idx];
+        int count;
+        int n;
+
+        count = sai_recorder_get_lists(sai_metadata_get_attr_metadata(header.meta_key.objecttype, attr->id), &attr->value, descs);
+
+        for (n = 0; n < count; n++)
+        {
+            sai_recorder_list_t list = sai_recorder_list_get(&attr->value, &descs[n]);
+            size_t bytes;
+
+            if (!(header.flags & SAI_RECORDER_FLAG_LISTS) || !sai_recorder_has_payload(&list))
+            {
+                sai_recorder_list_set_pointer(&attr->value, &descs[n], NULL);
+                continue;
+            }
+
+            bytes = SAI_RECORDER_ALIGN((size_t)list.count * descs[n].element_size);
+
+            if (bytes > (size_t)(end - payload))
+            {
+                SAI_META_LOG_ERROR("record %" PRIu64 " list payload exceeds record size", header.sequence);
+
+                return SAI_STATUS_FAILURE;
+            }
+
+            sai_recorder_list_set_pointer(&attr->value, &descs[n], payload);
+
+            payload += bytes;
+        }
+    }
+
+    record->header = header;
+    record->attr_list = (header.attr_count != 0) ? attr_list : NULL;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_recorder_reader_close(
+        _Inout_ sai_recorder_reader_t *reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    gzclose(reader->file);
+
+    free(reader->buffer);
+    free(reader);
+}
+
+sai_status_t sai_recorder_record_copy(
+        _In_ const sai_recorder_record_t *record,
+        _Out_ sai_recorder_record_t *copy)
+{
+    sai_object_type_t object_type = record->header.meta_key.objecttype;
+    uint32_t attr_count = (record->attr_list != NULL) ? record->header.attr_count : 0;
+    size_t attrs_size = SAI_RECORDER_ALIGN((size_t)attr_count * sizeof(sai_attribute_t));
+    size_t size = attrs_size;
+    sai_attribute_t *attr_list;
+    uint8_t *payload;
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        size += sai_recorder_attr_payload_size(object_type, &record->attr_list[idx]);
+    }
+
+    copy->header = record->header;
+    copy->header.attr_count = attr_count;
+    copy->attr_list = NULL;
+
+    if (attr_count == 0)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    attr_list = (sai_attribute_t*)malloc(size);
+
+    if (attr_list == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    memcpy(attr_list, record->attr_list, (size_t)attr_count * sizeof(sai_attribute_t));
+
+    payload = (uint8_t*)attr_list + attrs_size;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        sai_recorder_list_desc_t descs[SAI_RECORDER_MAX_LISTS];
+        sai_attribute_t *attr = &attr_list[idx];
+        int count;
+        int n;
+
+        count = sai_recorder_get_lists(sai_metadata_get_attr_metadata(object_type, attr->id), &attr->value, descs);
+
+        for (n = 0; n < count; n++)
+        {
+            sai_recorder_list_t list = sai_recorder_list_get(&attr->value, &descs[n]);
+            size_t bytes;
+
+            if (!sai_recorder_has_payload(&list))
+            {
+                sai_recorder_list_set_pointer(&attr->value, &descs[n], NULL);
+                continue;
+            }
+
+            bytes = (size_t)list.count * descs[n].element_size;
+
+            memcpy(payload, list.list, bytes);
+
+            sai_recorder_list_set_pointer(&attr->value, &descs[n], payload);
+
+            payload += SAI_RECORDER_ALIGN(bytes);
+        }
+    }
+
+    copy->attr_list = attr_list;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_recorder_record_free(
+        _Inout_ sai_recorder_record_t *record)
+{
+    free(record->attr_list);
+
+    record->attr_list = NULL;
+    record->header.attr_count = 0;
+}
+
+void sai_recorder_reset_empty_lists(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        sai_recorder_list_desc_t descs[SAI_RECORDER_MAX_LISTS];
+        sai_attribute_t *attr = &attr_list[idx];
+        uint32_t zero = 0;
+        int count;
+        int n;
+
+        count = sai_recorder_get_lists(sai_metadata_get_attr_metadata(object_type, attr->id), &attr->value, descs);
+
+        for (n = 0; n < count; n++)
+        {
+            sai_recorder_list_t list = sai_recorder_list_get(&attr->value, &descs[n]);
+
+            if (list.list == NULL)
+            {
+                memcpy((uint8_t*)&attr->value + descs[n].offset, &zero, sizeof(zero));
+            }
+        }
+    }
+}
@@ -0,0 +1,368 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairecorder.h
+ *
+ * @brief   This module defines SAI binary call recorder
+ */
+
+#ifndef __SAIRECORDER_H_
+#define __SAIRECORDER_H_
+
+/**
+ * @defgroup SAIRECORDER SAI - Binary call recorder
+ *
+ * Recorder copies arguments of each call into per thread single producer
+ * single consumer ring buffer. Background writer thread drains the rings
+ * into binary file. Caller thread never blocks and never does any I/O, when
+ * ring is full record is dropped and counted.
+ *
+ * File starts with sai_recorder_file_header_t followed by records. Each
+ * record is sai_recorder_record_header_t, followed by attr_count raw
+ * sai_attribute_t and then by list payloads of attributes in attribute
+ * order, each padded to 8 bytes. List pointers stored in attributes are
+ * meaningless in file, reader replaces them with pointers to payload.
+ * Which attribute value members are lists is decided by attribute
+ * metadata value type, so files are only portable between builds using the
+ * same SAI headers.
+ *
+ * Records of single thread are in order, records of different threads may
+ * be interleaved out of order, sequence number gives global order.
+ *
+ * @{
+ */
+
+/**
+ * @brief Recorder file magic
+ */
+#define SAI_RECORDER_MAGIC              "SAIREC\0\0"
+
+/**
+ * @brief Recorder file format version
+ */
+#define SAI_RECORDER_VERSION            1
+
+/**
+ * @brief Default per thread ring buffer size in bytes
+ */
+#define SAI_RECORDER_DEFAULT_RING_SIZE  (4 * 1024 * 1024)
+
+/**
+ * @brief Record flag, list payloads are present
+ */
+#define SAI_RECORDER_FLAG_LISTS         0x1
+
+/**
+ * @brief Record flag, padding at the end of ring buffer, never in file
+ */
+#define SAI_RECORDER_FLAG_PADDING       0x2
+
+/**
+ * @brief Recorder file header
+ */
+typedef struct _sai_recorder_file_header_t
+{
+    /**
+     * @brief File magic SAI_RECORDER_MAGIC
+     */
+    char magic[8];
+
+    /**
+     * @brief Format version SAI_RECORDER_VERSION
+     */
+    uint32_t version;
+
+    /**
+     * @brief Size of sai_attribute_t used by recorder
+     */
+    uint32_t attribute_size;
+
+    /**
+     * @brief Size of sai_object_meta_key_t used by recorder
+     */
+    uint32_t meta_key_size;
+
+    /**
+     * @brief Reserved, zero
+     */
+    uint32_t reserved;
+
+    /**
+     * @brief SAI API version of recorder headers
+     */
+    uint64_t api_version;
+
+} sai_recorder_file_header_t;
+
+/**
+ * @brief Recorded call header
+ */
+typedef struct _sai_recorder_record_header_t
+{
+    /**
+     * @brief Size of whole record in bytes, multiple of 8
+     */
+    uint32_t size;
+
+    /**
+     * @brief Record flags
+     */
+    uint32_t flags;
+
+    /**
+     * @brief Global sequence number
+     */
+    uint64_t sequence;
+
+    /**
+     * @brief Wall clock time of call in nanoseconds
+     */
+    uint64_t timestamp;
+
+    /**
+     * @brief Operation, sai_common_api_t
+     */
+    int32_t api;
+
+    /**
+     * @brief Returned status, sai_status_t
+     */
+    int32_t status;
+
+    /**
+     * @brief Number of attributes
+     */
+    uint32_t attr_count;
+
+    /**
+     * @brief Records dropped by this thread just before this one
+     */
+    uint32_t lost;
+
+    /**
+     * @brief Switch id, valid for create of object with object id
+     */
+    sai_object_id_t switch_id;
+
+    /**
+     * @brief Object type and key, for create key of created object
+     */
+    sai_object_meta_key_t meta_key;
+
+} sai_recorder_record_header_t;
+
+/**
+ * @brief Recorder configuration
+ */
+typedef struct _sai_recorder_config_t
+{
+    /**
+     * @brief Output file, rotated files get .1, .2, ... suffix
+     */
+    const char *path;
+
+    /**
+     * @brief Rotate file after this many record bytes, 0 disables rotation
+     */
+    uint64_t max_file_size;
+
+    /**
+     * @brief Number of rotated files to keep
+     */
+    uint32_t max_files;
+
+    /**
+     * @brief Per thread ring buffer size in bytes, rounded up to power of 2
+     */
+    uint32_t ring_size;
+
+    /**
+     * @brief Compression level 1-9 (gzip), 0 writes uncompressed file
+     */
+    uint32_t compression;
+
+} sai_recorder_config_t;
+
+/**
+ * @brief Recorder statistics
+ */
+typedef struct _sai_recorder_stats_t
+{
+    /**
+     * @brief Number of records put into ring buffers
+     */
+    uint64_t recorded;
+
+    /**
+     * @brief Number of records dropped, because ring buffer was full
+     */
+    uint64_t dropped;
+
+    /**
+     * @brief Number of records written to file
+     */
+    uint64_t written;
+
+    /**
+     * @brief Number of record bytes written to file, before compression
+     */
+    uint64_t bytes;
+
+} sai_recorder_stats_t;
+
+/**
+ * @brief Decoded record
+ */
+typedef struct _sai_recorder_record_t
+{
+    /**
+     * @brief Record header
+     */
+    sai_recorder_record_header_t header;
+
+    /**
+     * @brief Attributes, valid until next sai_recorder_reader_next() call
+     */
+    sai_attribute_t *attr_list;
+
+} sai_recorder_record_t;
+
+/**
+ * @brief Opaque recorder file reader
+ */
+typedef struct _sai_recorder_reader_t sai_recorder_reader_t;
+
+/**
+ * @brief Start recorder and its writer thread
+ *
+ * @param[in] config Recorder configuration
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_recorder_start(
+        _In_ const sai_recorder_config_t *config);
+
+/**
+ * @brief Stop recorder, write pending records and close file
+ */
+extern void sai_recorder_stop(void);
+
+/**
+ * @brief Record single call
+ *
+ * Called after the call returned. Does not block and does no I/O. List
+ * payloads of get are recorded only when get succeeded.
+ *
+ * @param[in] api Operation
+ * @param[in] meta_key Object type and key
+ * @param[in] switch_id Switch id for create, SAI_NULL_OBJECT_ID otherwise
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ * @param[in] status Status returned by the call
+ */
+extern void sai_recorder_record(
+        _In_ sai_common_api_t api,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ sai_status_t status);
+
+/**
+ * @brief Get recorder statistics
+ *
+ * @param[out] stats Statistics
+ */
+extern void sai_recorder_get_stats(
+        _Out_ sai_recorder_stats_t *stats);
+
+/**
+ * @brief Open recorder file, compressed or not
+ *
+ * @param[in] path File path
+ *
+ * @return Reader or NULL on failure
+ */
+extern sai_recorder_reader_t* sai_recorder_reader_open(
+        _In_ const char *path);
+
+/**
+ * @brief Read next record
+ *
+ * @param[inout] reader Reader
+ * @param[out] record Decoded record
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_NOT_FOUND at end
+ * of file, failure status code on error
+ */
+extern sai_status_t sai_recorder_reader_next(
+        _Inout_ sai_recorder_reader_t *reader,
+        _Out_ sai_recorder_record_t *record);
+
+/**
+ * @brief Close recorder file
+ *
+ * @param[inout] reader Reader
+ */
+extern void sai_recorder_reader_close(
+        _Inout_ sai_recorder_reader_t *reader);
+
+/**
+ * @brief Copy record, attributes and lists into single allocation
+ *
+ * Lists which were not recorded stay NULL. Copy is released by
+ * sai_recorder_record_free().
+ *
+ * @param[in] record Source record, like returned by reader
+ * @param[out] copy Record copy
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_recorder_record_copy(
+        _In_ const sai_recorder_record_t *record,
+        _Out_ sai_recorder_record_t *copy);
+
+/**
+ * @brief Release record created by sai_recorder_record_copy()
+ *
+ * @param[inout] record Record copy
+ */
+extern void sai_recorder_record_free(
+        _Inout_ sai_recorder_record_t *record);
+
+/**
+ * @brief Set count of every list without recorded payload to zero
+ *
+ * Lists of failed get are not recorded, reader returns them as NULL with
+ * count reported by failed call. Zero count makes such list valid input
+ * for get again.
+ *
+ * @param[in] object_type Object type of attributes
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ */
+extern void sai_recorder_reset_empty_lists(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list);
+
+/**
+ * @}
+ */
+#endif /** __SAIRECORDER_H_ */
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairecorderperf.c
+ *
+ * @brief   This module defines SAI Binary Call Recorder overhead benchmark
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "sairecorder.h"
+
+#define PERF_FILE "sairecorderperf.rec"
+
+#define PERF_CALLS 1000000
+
+#define PERF_LANES 8
+
+/*
+ * Measures caller side cost of single recorded call, which is what
+ * application thread pays. Writer thread cost is reported as records dropped,
+ * when writer can not keep up with producer. As reference, cost of
+ * serializing the same attributes to text is measured too.
+ */
+
+static void perf_fill(
+        _Out_ sai_object_meta_key_t *meta_key,
+        _Out_ sai_attribute_t *attrs,
+        _In_ uint32_t *lanes)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_PORT;
+    meta_key->objectkey.key.object_id = 0x1000000000001;
+
+    attrs[0].id = SAI_PORT_ATTR_ADMIN_STATE;
+    attrs[0].value.booldata = true;
+
+    attrs[1].id = SAI_PORT_ATTR_SPEED;
+    attrs[1].value.u32 = 100000;
+
+    attrs[2].id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attrs[2].value.u32list.count = PERF_LANES;
+    attrs[2].value.u32list.list = lanes;
+}
+
+static void perf_record(
+        _In_ const char *name,
+        _In_ uint32_t attr_count,
+        _In_ uint32_t compression,
+        _In_ int running)
+{
+    sai_recorder_config_t config;
+    sai_recorder_stats_t before;
+    sai_recorder_stats_t stats;
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attrs[3];
+    uint32_t lanes[PERF_LANES] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint64_t start;
+    uint64_t end;
+    uint32_t idx;
+
+    perf_fill(&meta_key, attrs, lanes);
+
+    config.path = PERF_FILE;
+    config.max_file_size = 0;
+    config.max_files = 0;
+    config.ring_size = 64 * 1024 * 1024;
+    config.compression = compression;
+
+    if (running && sai_recorder_start(&config) != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "failed to start recorder\n");
+        exit(1);
+    }
+
+    sai_recorder_get_stats(&before);
+
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_CALLS; idx++)
+    {
+        meta_key.objectkey.key.object_id = idx;
+
+        sai_recorder_record(SAI_COMMON_API_CREATE, &meta_key, SAI_NULL_OBJECT_ID, attr_count, attrs, SAI_STATUS_SUCCESS);
+    }
+
+    end = sai_metadata_now();
+
+    sai_recorder_stop();
+
+    sai_recorder_get_stats(&stats);
+
+    printf("%-32s %8.1f ns/call %10" PRIu64 " written %10" PRIu64 " dropped %8.1f bytes/record\n",
+            name,
+            (double)(end - start) / PERF_CALLS,
+            stats.written - before.written,
+            stats.dropped - before.dropped,
+            (stats.written == before.written) ? 0.0 :
+            (double)(stats.bytes - before.bytes) / (double)(stats.written - before.written));
+
+    unlink(PERF_FILE);
+}
+
+static void perf_serialize(
+        _In_ const char *name,
+        _In_ uint32_t attr_count)
+{
+    static char buffer[0x10000];
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attrs[3];
+    uint32_t lanes[PERF_LANES] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint64_t start;
+    uint64_t end;
+    uint32_t idx;
+    uint32_t n;
+    size_t total = 0;
+
+    perf_fill(&meta_key, attrs, lanes);
+
+    start = sai_metadata_now();
+
+    for (idx = 0; idx < PERF_CALLS; idx++)
+    {
+        for (n = 0; n < attr_count; n++)
+        {
+            const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key.objecttype, attrs[n].id);
+
+            total += (size_t)sai_serialize_attribute(buffer, md, &attrs[n]);
+        }
+    }
+
+    end = sai_metadata_now();
+
+    printf("%-32s %8.1f ns/call %8.1f bytes/record\n",
+            name,
+            (double)(end - start) / PERF_CALLS,
+            (double)total / PERF_CALLS);
+}
+
+int main()
+{
+    perf_record("record disabled", 3, 0, 0);
+    perf_record("record 1 attr", 1, 0, 1);
+    perf_record("record 3 attrs, list", 3, 0, 1);
+    perf_record("record 3 attrs, list, gzip 1", 3, 1, 1);
+
+    perf_serialize("serialize 1 attr", 1);
+    perf_serialize("serialize 3 attrs, list", 3);
+
+    return 0;
+}
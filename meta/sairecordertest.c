@@ -0,0 +1,296 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairecordertest.c
+ *
+ * @brief   This module defines SAI Binary Call Recorder Test
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "sairecorder.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_FILE "sairecordertest.rec"
+
+#define TEST_THREADS 4
+#define TEST_THREAD_RECORDS 20000
+
+void test_start(
+        _In_ const char *path,
+        _In_ uint64_t max_file_size,
+        _In_ uint32_t max_files,
+        _In_ uint32_t compression)
+{
+    sai_recorder_config_t config;
+
+    config.path = path;
+    config.max_file_size = max_file_size;
+    config.max_files = max_files;
+    config.ring_size = 0;
+    config.compression = compression;
+
+    ASSERT_TRUE(sai_recorder_start(&config) == SAI_STATUS_SUCCESS, "failed to start recorder");
+}
+
+void test_record_port(
+        _In_ sai_common_api_t api,
+        _In_ sai_object_id_t port_id,
+        _In_ uint32_t *lanes,
+        _In_ uint32_t lane_count,
+        _In_ sai_status_t status)
+{
+    sai_object_meta_key_t meta_key;
+    sai_attribute_t attrs[2];
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = SAI_OBJECT_TYPE_PORT;
+    meta_key.objectkey.key.object_id = port_id;
+
+    attrs[0].id = SAI_PORT_ATTR_HW_LANE_LIST;
+    attrs[0].value.u32list.count = lane_count;
+    attrs[0].value.u32list.list = lanes;
+
+    attrs[1].id = SAI_PORT_ATTR_ADMIN_STATE;
+    attrs[1].value.booldata = true;
+
+    sai_recorder_record(api, &meta_key, 0x21000000000000, 2, attrs, status);
+}
+
+void test_roundtrip(
+        _In_ uint32_t compression)
+{
+    sai_object_meta_key_t meta_key;
+    sai_recorder_reader_t *reader;
+    sai_recorder_record_t record;
+    sai_recorder_record_t copy;
+    sai_attribute_t attr;
+    uint32_t lanes[4] = { 1, 2, 3, 4 };
+
+    test_start(TEST_FILE, 0, 0, compression);
+
+    test_record_port(SAI_COMMON_API_CREATE, 0x1000000000001, lanes, 4, SAI_STATUS_SUCCESS);
+
+    /* failed get, list is not recorded */
+
+    test_record_port(SAI_COMMON_API_GET, 0x1000000000001, lanes, 4, SAI_STATUS_BUFFER_OVERFLOW);
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+    meta_key.objectkey.key.route_entry.vr_id = 0x3000000000001;
+    meta_key.objectkey.key.route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    meta_key.objectkey.key.route_entry.destination.addr.ip4 = 0x0a000000;
+    meta_key.objectkey.key.route_entry.destination.mask.ip4 = 0xff000000;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attr.value.oid = 0x4000000000001;
+
+    sai_recorder_record(SAI_COMMON_API_SET, &meta_key, SAI_NULL_OBJECT_ID, 1, &attr, SAI_STATUS_SUCCESS);
+
+    sai_recorder_record(SAI_COMMON_API_REMOVE, &meta_key, SAI_NULL_OBJECT_ID, 0, NULL, SAI_STATUS_FAILURE);
+
+    sai_recorder_stop();
+
+    /* list memory may be reused after record returned */
+
+    memset(lanes, 0, sizeof(lanes));
+
+    reader = sai_recorder_reader_open(TEST_FILE);
+
+    ASSERT_TRUE(reader != NULL, "failed to open %s", TEST_FILE);
+
+    ASSERT_TRUE(sai_recorder_reader_next(reader, &record) == SAI_STATUS_SUCCESS, "expected create record");
+    ASSERT_TRUE(record.header.api == SAI_COMMON_API_CREATE, "wrong api %d", record.header.api);
+    ASSERT_TRUE(record.header.meta_key.objecttype == SAI_OBJECT_TYPE_PORT, "wrong object type");
+    ASSERT_TRUE(record.header.meta_key.objectkey.key.object_id == 0x1000000000001, "wrong object id");
+    ASSERT_TRUE(record.header.switch_id == 0x21000000000000, "wrong switch id");
+    ASSERT_TRUE(record.header.attr_count == 2, "wrong attr count %u", record.header.attr_count);
+    ASSERT_TRUE(record.attr_list[0].value.u32list.count == 4, "wrong lane count");
+    ASSERT_TRUE(record.attr_list[0].value.u32list.list != NULL, "lanes not recorded");
+    ASSERT_TRUE(record.attr_list[0].value.u32list.list[3] == 4, "wrong lane %u", record.attr_list[0].value.u32list.list[3]);
+    ASSERT_TRUE(record.attr_list[1].value.booldata, "wrong admin state");
+
+    /* copy outlives reader buffer */
+
+    ASSERT_TRUE(sai_recorder_record_copy(&record, &copy) == SAI_STATUS_SUCCESS, "failed to copy record");
+
+    ASSERT_TRUE(sai_recorder_reader_next(reader, &record) == SAI_STATUS_SUCCESS, "expected get record");
+    ASSERT_TRUE(record.header.api == SAI_COMMON_API_GET, "wrong api %d", record.header.api);
+    ASSERT_TRUE(record.header.status == SAI_STATUS_BUFFER_OVERFLOW, "wrong status %d", record.header.status);
+    ASSERT_TRUE(record.attr_list[0].value.u32list.count == 4, "wrong lane count");
+    ASSERT_TRUE(record.attr_list[0].value.u32list.list == NULL, "list of failed get recorded");
+
+    sai_recorder_reset_empty_lists(record.header.meta_key.objecttype, record.header.attr_count, record.attr_list);
+
+    ASSERT_TRUE(record.attr_list[0].value.u32list.count == 0, "empty list count not reset");
+
+    ASSERT_TRUE(copy.attr_list != record.attr_list, "copy shares reader buffer");
+    ASSERT_TRUE(copy.header.api == SAI_COMMON_API_CREATE, "wrong api of copy %d", copy.header.api);
+    ASSERT_TRUE(copy.attr_list[0].value.u32list.count == 4, "wrong lane count of copy");
+    ASSERT_TRUE(copy.attr_list[0].value.u32list.list[3] == 4, "wrong lane of copy %u", copy.attr_list[0].value.u32list.list[3]);
+
+    sai_recorder_record_free(&copy);
+
+    ASSERT_TRUE(copy.attr_list == NULL, "copy not released");
+
+    ASSERT_TRUE(sai_recorder_reader_next(reader, &record) == SAI_STATUS_SUCCESS, "expected set record");
+    ASSERT_TRUE(record.header.api == SAI_COMMON_API_SET, "wrong api %d", record.header.api);
+    ASSERT_TRUE(memcmp(&record.header.meta_key, &meta_key, sizeof(meta_key)) == 0, "wrong route entry");
+    ASSERT_TRUE(record.attr_list[0].value.oid == 0x4000000000001, "wrong next hop");
+
+    ASSERT_TRUE(sai_recorder_reader_next(reader, &record) == SAI_STATUS_SUCCESS, "expected remove record");
+    ASSERT_TRUE(record.header.api == SAI_COMMON_API_REMOVE, "wrong api %d", record.header.api);
+    ASSERT_TRUE(record.header.attr_count == 0 && record.attr_list == NULL, "remove has attributes");
+
+    ASSERT_TRUE(sai_recorder_reader_next(reader, &record) == SAI_STATUS_ITEM_NOT_FOUND, "expected end of file");
+
+    sai_recorder_reader_close(reader);
+
+    unlink(TEST_FILE);
+}
+
+void* test_thread(
+        _In_ void *arg)
+{
+    uint32_t lanes[8] = { 0 };
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_THREAD_RECORDS; idx++)
+    {
+        lanes[idx % 8] = idx;
+
+        test_record_port(SAI_COMMON_API_SET, (sai_object_id_t)(uintptr_t)arg, lanes, 1 + idx % 8, SAI_STATUS_SUCCESS);
+    }
+
+    return NULL;
+}
+
+void test_threads_rotation()
+{
+    pthread_t threads[TEST_THREADS];
+    sai_recorder_stats_t before;
+    sai_recorder_stats_t stats;
+    sai_recorder_reader_t *reader;
+    sai_recorder_record_t record;
+    uint64_t last[TEST_THREADS];
+    uint64_t count = 0;
+    char path[64];
+    int file;
+    int idx;
+
+    /* statistics are cumulative over recorder restarts */
+
+    sai_recorder_get_stats(&before);
+
+    /* files are large enough to keep all records */
+
+    test_start(TEST_FILE, 4 * 1024 * 1024, 8, 1);
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        ASSERT_TRUE(pthread_create(&threads[idx], NULL, test_thread, (void*)(uintptr_t)idx) == 0, "failed to create thread");
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+    }
+
+    sai_recorder_stop();
+
+    sai_recorder_get_stats(&stats);
+
+    stats.recorded -= before.recorded;
+    stats.dropped -= before.dropped;
+    stats.written -= before.written;
+
+    ASSERT_TRUE(stats.recorded + stats.dropped == TEST_THREADS * TEST_THREAD_RECORDS, "records missing in stats");
+    ASSERT_TRUE(stats.written == stats.recorded, "recorded %" PRIu64 " written %" PRIu64, stats.recorded, stats.written);
+
+    memset(last, 0, sizeof(last));
+
+    /* oldest file first, records of single thread are ordered */
+
+    for (file = 8; file >= 0; file--)
+    {
+        if (file == 0)
+        {
+            snprintf(path, sizeof(path), "%s", TEST_FILE);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s.%d", TEST_FILE, file);
+        }
+
+        if (access(path, F_OK) != 0)
+        {
+            continue;
+        }
+
+        reader = sai_recorder_reader_open(path);
+
+        ASSERT_TRUE(reader != NULL, "failed to open %s", path);
+
+        while (sai_recorder_reader_next(reader, &record) == SAI_STATUS_SUCCESS)
+        {
+            sai_object_id_t thread = record.header.meta_key.objectkey.key.object_id;
+
+            ASSERT_TRUE(thread < TEST_THREADS, "wrong object id");
+            ASSERT_TRUE(record.header.sequence + 1 > last[thread], "records of thread out of order");
+            ASSERT_TRUE(record.attr_list[0].value.u32list.list != NULL, "lanes not recorded");
+
+            last[thread] = record.header.sequence + 1;
+
+            count++;
+        }
+
+        sai_recorder_reader_close(reader);
+
+        unlink(path);
+    }
+
+    ASSERT_TRUE(count == stats.written, "read %" PRIu64 " records, written %" PRIu64, count, stats.written);
+}
+
+int main()
+{
+    test_roundtrip(0);
+    test_roundtrip(6);
+
+    test_threads_rotation();
+
+    return 0;
+}
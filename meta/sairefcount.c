@@ -0,0 +1,1181 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairefcount.c
+ *
+ * @brief   This module implements SAI object reference counter
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "saimetadata.h"
+#include "sairefcount.h"
+
+#define SAI_REFCOUNT_TABLE_MIN_SIZE 64
+
+#define SAI_REFCOUNT_EDGES_PER_BLOCK 1024
+
+struct _sai_refcount_object_t;
+
+/*
+ * Single reference. Edge is on singly linked list of references held by
+ * referencing object and on doubly linked list of references to object, so
+ * it can be dropped in constant time from both sides.
+ */
+
+typedef struct _sai_refcount_edge_t
+{
+    struct _sai_refcount_object_t *from;
+
+    struct _sai_refcount_object_t *to;
+
+    const sai_attr_metadata_t *attrmetadata;
+
+    const sai_struct_member_info_t *structmember;
+
+    struct _sai_refcount_edge_t *next_out;
+
+    struct _sai_refcount_edge_t *prev_in;
+
+    struct _sai_refcount_edge_t *next_in;
+
+} sai_refcount_edge_t;
+
+typedef struct _sai_refcount_edge_block_t
+{
+    struct _sai_refcount_edge_block_t *next;
+
+    sai_refcount_edge_t edges[SAI_REFCOUNT_EDGES_PER_BLOCK];
+
+} sai_refcount_edge_block_t;
+
+/*
+ * Tracked object. Objects with object id are keyed by object id alone,
+ * object type of implicitly tracked object is not known. Entries are keyed
+ * by normalized meta key.
+ */
+
+typedef struct _sai_refcount_object_t
+{
+    sai_object_meta_key_t meta_key;
+
+    uint64_t hash;
+
+    uint32_t count;
+
+    bool isobjectid;
+
+    bool created;
+
+    sai_refcount_edge_t *in;
+
+    sai_refcount_edge_t *out;
+
+} sai_refcount_object_t;
+
+/*
+ * Attributes and key members of object type which can hold object ids,
+ * collected from reverse dependency graph. Attributes are sorted by id.
+ */
+
+typedef struct _sai_refcount_type_t
+{
+    const sai_attr_metadata_t **attrs;
+
+    uint32_t attr_count;
+
+    const sai_struct_member_info_t **members;
+
+    uint32_t member_count;
+
+} sai_refcount_type_t;
+
+struct _sai_refcount_t
+{
+    sai_refcount_type_t types[SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+    sai_refcount_object_t **slots;
+
+    size_t size;
+
+    size_t used;
+
+    size_t count;
+
+    sai_refcount_edge_block_t *blocks;
+
+    sai_refcount_edge_t *free_edges;
+
+    uint64_t references;
+};
+
+/* marks removed slot, so probe sequences stay intact */
+
+static sai_refcount_object_t sai_refcount_tombstone;
+
+static int sai_refcount_attr_cmp(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    const sai_attr_metadata_t *ma = *(const sai_attr_metadata_t * const *)a;
+    const sai_attr_metadata_t *mb = *(const sai_attr_metadata_t * const *)b;
+
+    return (ma->attrid > mb->attrid) - (ma->attrid < mb->attrid);
+}
+
+static sai_status_t sai_refcount_type_add(
+        _Inout_ sai_refcount_type_t *type,
+        _In_ const sai_rev_graph_member_t *m)
+{
+    uint32_t idx;
+
+    if (m->attrmetadata != NULL)
+    {
+        const sai_attr_metadata_t **attrs;
+
+        for (idx = 0; idx < type->attr_count; idx++)
+        {
+            if (type->attrs[idx] == m->attrmetadata)
+            {
+                return SAI_STATUS_SUCCESS;
+            }
+        }
+
+        attrs = realloc(type->attrs, (type->attr_count + 1) * sizeof(*attrs));
+
+        if (attrs == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        type->attrs = attrs;
+        type->attrs[type->attr_count++] = m->attrmetadata;
+    }
+    else if (m->structmember != NULL)
+    {
+        const sai_struct_member_info_t **members;
+
+        for (idx = 0; idx < type->member_count; idx++)
+        {
+            if (type->members[idx] == m->structmember)
+            {
+                return SAI_STATUS_SUCCESS;
+            }
+        }
+
+        members = realloc(type->members, (type->member_count + 1) * sizeof(*members));
+
+        if (members == NULL)
+        {
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        type->members = members;
+        type->members[type->member_count++] = m->structmember;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_refcount_build_types(
+        _Inout_ sai_refcount_t *refcount)
+{
+    size_t index;
+    size_t idx;
+
+    for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(sai_metadata_object_type_from_index(index));
+
+        if (info == NULL || info->revgraphmembers == NULL)
+        {
+            continue;
+        }
+
+        for (idx = 0; idx < info->revgraphmemberscount; idx++)
+        {
+            const sai_rev_graph_member_t *m = info->revgraphmembers[idx];
+            size_t user;
+
+            if (m == NULL)
+            {
+                continue;
+            }
+
+            user = sai_metadata_object_type_index(m->depobjecttype);
+
+            if (user != 0 && sai_refcount_type_add(&refcount->types[user], m) != SAI_STATUS_SUCCESS)
+            {
+                return SAI_STATUS_NO_MEMORY;
+            }
+        }
+    }
+
+    for (index = 1; index < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; index++)
+    {
+        sai_refcount_type_t *type = &refcount->types[index];
+
+        if (type->attr_count > 1)
+        {
+            qsort(type->attrs, type->attr_count, sizeof(*type->attrs), sai_refcount_attr_cmp);
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static const sai_attr_metadata_t* sai_refcount_find_attr(
+        _In_ const sai_refcount_type_t *type,
+        _In_ sai_attr_id_t attr_id)
+{
+    uint32_t low = 0;
+    uint32_t high = type->attr_count;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+
+        if (type->attrs[mid]->attrid == attr_id)
+        {
+            return type->attrs[mid];
+        }
+
+        if (type->attrs[mid]->attrid < attr_id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Lookup key of object: object id for object id types, normalized meta key
+ * for entries.
+ */
+
+typedef struct _sai_refcount_key_t
+{
+    sai_object_meta_key_t meta_key;
+
+    bool isobjectid;
+
+    size_t size;
+
+    uint64_t hash;
+
+} sai_refcount_key_t;
+
+static void sai_refcount_oid_key(
+        _In_ sai_object_id_t object_id,
+        _Out_ sai_refcount_key_t *key)
+{
+    memset(&key->meta_key, 0, sizeof(key->meta_key));
+
+    key->meta_key.objecttype = SAI_OBJECT_TYPE_NULL;
+    key->meta_key.objectkey.key.object_id = object_id;
+    key->isobjectid = true;
+    key->size = sizeof(sai_object_id_t);
+    key->hash = sai_metadata_hash_object_meta_key(&key->meta_key);
+}
+
+static sai_status_t sai_refcount_meta_key(
+        _In_ const sai_object_meta_key_t *meta_key,
+        _Out_ sai_refcount_key_t *key)
+{
+    const sai_object_type_info_t *info;
+
+    if (meta_key == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = sai_metadata_get_object_type_info(meta_key->objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (info->isobjectid)
+    {
+        sai_refcount_oid_key(meta_key->objectkey.key.object_id, key);
+        key->meta_key.objecttype = meta_key->objecttype;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    sai_metadata_normalize_object_meta_key(meta_key, &key->meta_key);
+
+    key->isobjectid = false;
+    key->size = sai_metadata_get_object_key_size(meta_key->objecttype);
+    key->hash = sai_metadata_hash_object_meta_key(&key->meta_key);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static bool sai_refcount_key_equal(
+        _In_ const sai_refcount_object_t *object,
+        _In_ const sai_refcount_key_t *key)
+{
+    if (object->hash != key->hash || object->isobjectid != key->isobjectid)
+    {
+        return false;
+    }
+
+    if (key->isobjectid)
+    {
+        return object->meta_key.objectkey.key.object_id == key->meta_key.objectkey.key.object_id;
+    }
+
+    return object->meta_key.objecttype == key->meta_key.objecttype &&
+        memcmp(&object->meta_key.objectkey.key, &key->meta_key.objectkey.key, key->size) == 0;
+}
+
+static sai_refcount_object_t** sai_refcount_find_slot(
+        _In_ const sai_refcount_t *refcount,
+        _In_ const sai_refcount_key_t *key,
+        _Out_ sai_refcount_object_t ***free_slot)
+{
+    size_t mask = refcount->size - 1;
+    size_t idx;
+
+    *free_slot = NULL;
+
+    if (refcount->size == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = key->hash & mask; refcount->slots[idx] != NULL; idx = (idx + 1) & mask)
+    {
+        if (refcount->slots[idx] == &sai_refcount_tombstone)
+        {
+            if (*free_slot == NULL)
+            {
+                *free_slot = &refcount->slots[idx];
+            }
+
+            continue;
+        }
+
+        if (sai_refcount_key_equal(refcount->slots[idx], key))
+        {
+            return &refcount->slots[idx];
+        }
+    }
+
+    if (*free_slot == NULL)
+    {
+        *free_slot = &refcount->slots[idx];
+    }
+
+    return NULL;
+}
+
+static sai_refcount_object_t* sai_refcount_lookup(
+        _In_ const sai_refcount_t *refcount,
+        _In_ const sai_refcount_key_t *key)
+{
+    sai_refcount_object_t **free_slot;
+    sai_refcount_object_t **slot = sai_refcount_find_slot(refcount, key, &free_slot);
+
+    return (slot == NULL) ? NULL : *slot;
+}
+
+/*
+ * Makes room for extra objects, growing table also drops tombstones.
+ */
+
+static sai_status_t sai_refcount_reserve(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ size_t extra)
+{
+    sai_refcount_object_t **slots;
+    size_t size = SAI_REFCOUNT_TABLE_MIN_SIZE;
+    size_t idx;
+
+    if ((refcount->used + extra) * 2 <= refcount->size)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    while ((refcount->count + extra) * 2 > size)
+    {
+        size *= 2;
+    }
+
+    slots = calloc(size, sizeof(sai_refcount_object_t*));
+
+    if (slots == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < refcount->size; idx++)
+    {
+        sai_refcount_object_t *object = refcount->slots[idx];
+        size_t pos;
+
+        if (object == NULL || object == &sai_refcount_tombstone)
+        {
+            continue;
+        }
+
+        for (pos = object->hash & (size - 1); slots[pos] != NULL; pos = (pos + 1) & (size - 1))
+        {
+        }
+
+        slots[pos] = object;
+    }
+
+    free(refcount->slots);
+
+    refcount->slots = slots;
+    refcount->size = size;
+    refcount->used = refcount->count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_refcount_object_t* sai_refcount_insert(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_refcount_key_t *key)
+{
+    sai_refcount_object_t **free_slot;
+    sai_refcount_object_t *object;
+
+    if (sai_refcount_reserve(refcount, 1) != SAI_STATUS_SUCCESS)
+    {
+        return NULL;
+    }
+
+    sai_refcount_find_slot(refcount, key, &free_slot);
+
+    object = calloc(1, sizeof(sai_refcount_object_t));
+
+    if (object == NULL)
+    {
+        return NULL;
+    }
+
+    object->meta_key = key->meta_key;
+    object->hash = key->hash;
+    object->isobjectid = key->isobjectid;
+
+    if (*free_slot == NULL)
+    {
+        refcount->used++;
+    }
+
+    *free_slot = object;
+
+    refcount->count++;
+
+    return object;
+}
+
+static void sai_refcount_erase(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *object)
+{
+    sai_refcount_key_t key;
+    sai_refcount_object_t **free_slot;
+    sai_refcount_object_t **slot;
+
+    key.meta_key = object->meta_key;
+    key.isobjectid = object->isobjectid;
+    key.size = object->isobjectid ? sizeof(sai_object_id_t) : sai_metadata_get_object_key_size(object->meta_key.objecttype);
+    key.hash = object->hash;
+
+    slot = sai_refcount_find_slot(refcount, &key, &free_slot);
+
+    if (slot != NULL)
+    {
+        *slot = &sai_refcount_tombstone;
+        refcount->count--;
+    }
+
+    free(object);
+}
+
+/*
+ * Object is freed when it is neither created nor referenced.
+ */
+
+static void sai_refcount_release(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *object)
+{
+    if (!object->created && object->count == 0 && object->out == NULL)
+    {
+        sai_refcount_erase(refcount, object);
+    }
+}
+
+static sai_refcount_edge_t* sai_refcount_alloc_edge(
+        _Inout_ sai_refcount_t *refcount)
+{
+    sai_refcount_edge_t *edge;
+
+    if (refcount->free_edges == NULL)
+    {
+        sai_refcount_edge_block_t *block = malloc(sizeof(sai_refcount_edge_block_t));
+        uint32_t idx;
+
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        block->next = refcount->blocks;
+        refcount->blocks = block;
+
+        for (idx = 0; idx < SAI_REFCOUNT_EDGES_PER_BLOCK; idx++)
+        {
+            block->edges[idx].next_out = refcount->free_edges;
+            refcount->free_edges = &block->edges[idx];
+        }
+    }
+
+    edge = refcount->free_edges;
+    refcount->free_edges = edge->next_out;
+
+    return edge;
+}
+
+static sai_status_t sai_refcount_add_edge(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *from,
+        _In_ sai_object_id_t object_id,
+        _In_ const sai_attr_metadata_t *attrmetadata,
+        _In_ const sai_struct_member_info_t *structmember)
+{
+    sai_refcount_object_t *to;
+    sai_refcount_edge_t *edge;
+    sai_refcount_key_t key;
+
+    if (object_id == SAI_NULL_OBJECT_ID)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    sai_refcount_oid_key(object_id, &key);
+
+    to = sai_refcount_lookup(refcount, &key);
+
+    if (to == NULL && (to = sai_refcount_insert(refcount, &key)) == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    edge = sai_refcount_alloc_edge(refcount);
+
+    if (edge == NULL)
+    {
+        sai_refcount_release(refcount, to);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    edge->from = from;
+    edge->to = to;
+    edge->attrmetadata = attrmetadata;
+    edge->structmember = structmember;
+
+    edge->next_out = from->out;
+    from->out = edge;
+
+    edge->prev_in = NULL;
+    edge->next_in = to->in;
+
+    if (to->in != NULL)
+    {
+        to->in->prev_in = edge;
+    }
+
+    to->in = edge;
+    to->count++;
+
+    refcount->references++;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Removes edge from list of references to its target and returns it to
+ * free list, caller removes it from list of referencing object.
+ */
+
+static void sai_refcount_drop_edge(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_edge_t *edge)
+{
+    sai_refcount_object_t *to = edge->to;
+
+    if (edge->prev_in != NULL)
+    {
+        edge->prev_in->next_in = edge->next_in;
+    }
+    else
+    {
+        to->in = edge->next_in;
+    }
+
+    if (edge->next_in != NULL)
+    {
+        edge->next_in->prev_in = edge->prev_in;
+    }
+
+    to->count--;
+
+    refcount->references--;
+
+    edge->next_out = refcount->free_edges;
+    refcount->free_edges = edge;
+
+    sai_refcount_release(refcount, to);
+}
+
+/*
+ * Drops references held by attribute, or all references of object when
+ * attribute metadata is NULL.
+ */
+
+static void sai_refcount_drop_edges(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *from,
+        _In_ const sai_attr_metadata_t *attrmetadata)
+{
+    sai_refcount_edge_t **link = &from->out;
+
+    while (*link != NULL)
+    {
+        sai_refcount_edge_t *edge = *link;
+
+        if (attrmetadata != NULL && edge->attrmetadata != attrmetadata)
+        {
+            link = &edge->next_out;
+            continue;
+        }
+
+        *link = edge->next_out;
+
+        sai_refcount_drop_edge(refcount, edge);
+    }
+}
+
+static sai_status_t sai_refcount_add_list(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *from,
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_object_list_t *list)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t idx;
+
+    if (list->list == NULL)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < list->count && status == SAI_STATUS_SUCCESS; idx++)
+    {
+        status = sai_refcount_add_edge(refcount, from, list->list[idx], md, NULL);
+    }
+
+    return status;
+}
+
+static sai_status_t sai_refcount_add_attr(
+        _Inout_ sai_refcount_t *refcount,
+        _Inout_ sai_refcount_object_t *from,
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t *value)
+{
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return sai_refcount_add_edge(refcount, from, value->oid, md, NULL);
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            return sai_refcount_add_list(refcount, from, md, &value->objlist);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            return value->aclfield.enable ? sai_refcount_add_edge(refcount, from, value->aclfield.data.oid, md, NULL) : SAI_STATUS_SUCCESS;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            return value->aclfield.enable ? sai_refcount_add_list(refcount, from, md, &value->aclfield.data.objlist) : SAI_STATUS_SUCCESS;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            return value->aclaction.enable ? sai_refcount_add_edge(refcount, from, value->aclaction.parameter.oid, md, NULL) : SAI_STATUS_SUCCESS;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            return value->aclaction.enable ? sai_refcount_add_list(refcount, from, md, &value->aclaction.parameter.objlist) : SAI_STATUS_SUCCESS;
+
+        default:
+            return SAI_STATUS_SUCCESS;
+    }
+}
+
+static sai_status_t sai_refcount_create_one(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_refcount_type_t *type;
+    sai_refcount_object_t *object;
+    sai_refcount_key_t key;
+    sai_status_t status;
+    uint32_t idx;
+
+    status = sai_refcount_meta_key(meta_key, &key);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    object = sai_refcount_lookup(refcount, &key);
+
+    if (object != NULL && object->created)
+    {
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    if (object == NULL && (object = sai_refcount_insert(refcount, &key)) == NULL)
+    {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    /* implicitly tracked object learns its type */
+
+    object->meta_key.objecttype = meta_key->objecttype;
+    object->created = true;
+
+    type = &refcount->types[sai_metadata_object_type_index(meta_key->objecttype)];
+
+    for (idx = 0; idx < type->member_count && status == SAI_STATUS_SUCCESS; idx++)
+    {
+        const sai_struct_member_info_t *m = type->members[idx];
+
+        if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_OBJECT_ID && m->getoid != NULL)
+        {
+            status = sai_refcount_add_edge(refcount, object, m->getoid(meta_key), NULL, m);
+        }
+    }
+
+    for (idx = 0; idx < attr_count && status == SAI_STATUS_SUCCESS; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_refcount_find_attr(type, attr_list[idx].id);
+
+        if (md != NULL)
+        {
+            status = sai_refcount_add_attr(refcount, object, md, &attr_list[idx].value);
+        }
+    }
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        sai_refcount_drop_edges(refcount, object, NULL);
+        object->created = false;
+        sai_refcount_release(refcount, object);
+    }
+
+    return status;
+}
+
+static sai_status_t sai_refcount_remove_one(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    sai_refcount_object_t *object;
+    sai_refcount_key_t key;
+    sai_status_t status;
+
+    status = sai_refcount_meta_key(meta_key, &key);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    object = sai_refcount_lookup(refcount, &key);
+
+    if (object == NULL || !object->created)
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    sai_refcount_drop_edges(refcount, object, NULL);
+
+    object->created = false;
+
+    sai_refcount_release(refcount, object);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_refcount_set_one(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    const sai_attr_metadata_t *md;
+    sai_refcount_object_t *object;
+    sai_refcount_key_t key;
+    sai_status_t status;
+
+    status = sai_refcount_meta_key(meta_key, &key);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (attr == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    object = sai_refcount_lookup(refcount, &key);
+
+    if (object == NULL || !object->created)
+    {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    md = sai_refcount_find_attr(&refcount->types[sai_metadata_object_type_index(meta_key->objecttype)], attr->id);
+
+    if (md == NULL)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    sai_refcount_drop_edges(refcount, object, md);
+
+    status = sai_refcount_add_attr(refcount, object, md, &attr->value);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        sai_refcount_drop_edges(refcount, object, md);
+    }
+
+    return status;
+}
+
+sai_refcount_t* sai_refcount_open(void)
+{
+    sai_refcount_t *refcount = calloc(1, sizeof(sai_refcount_t));
+
+    if (refcount == NULL)
+    {
+        return NULL;
+    }
+
+    if (sai_refcount_build_types(refcount) != SAI_STATUS_SUCCESS)
+    {
+        sai_refcount_close(refcount);
+        return NULL;
+    }
+
+    return refcount;
+}
+
+void sai_refcount_close(
+        _Inout_ sai_refcount_t *refcount)
+{
+    size_t idx;
+
+    if (refcount == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < refcount->size; idx++)
+    {
+        if (refcount->slots[idx] != &sai_refcount_tombstone)
+        {
+            free(refcount->slots[idx]);
+        }
+    }
+
+    while (refcount->blocks != NULL)
+    {
+        sai_refcount_edge_block_t *block = refcount->blocks;
+
+        refcount->blocks = block->next;
+        free(block);
+    }
+
+    for (idx = 0; idx < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; idx++)
+    {
+        free(refcount->types[idx].attrs);
+        free(refcount->types[idx].members);
+    }
+
+    free(refcount->slots);
+    free(refcount);
+}
+
+sai_status_t sai_refcount_create(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    if (refcount == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_refcount_create_one(refcount, meta_key, attr_count, attr_list);
+}
+
+sai_status_t sai_refcount_remove(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key)
+{
+    if (refcount == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_refcount_remove_one(refcount, meta_key);
+}
+
+sai_status_t sai_refcount_set(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    if (refcount == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_refcount_set_one(refcount, meta_key, attr);
+}
+
+sai_status_t sai_refcount_bulk_create(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ const sai_status_t *object_statuses)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_status_t status;
+    uint32_t idx;
+
+    if (refcount == NULL || (object_count != 0 && (meta_key == NULL || attr_count == NULL || attr_list == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    /* table grows once for whole bulk instead of repeated growth */
+
+    status = sai_refcount_reserve(refcount, object_count);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (object_statuses != NULL && object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            continue;
+        }
+
+        status = sai_refcount_create_one(refcount, &meta_key[idx], attr_count[idx], attr_list[idx]);
+
+        if (status != SAI_STATUS_SUCCESS && result == SAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+sai_status_t sai_refcount_bulk_remove(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_status_t *object_statuses)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_status_t status;
+    uint32_t idx;
+
+    if (refcount == NULL || (object_count != 0 && meta_key == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (object_statuses != NULL && object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            continue;
+        }
+
+        status = sai_refcount_remove_one(refcount, &meta_key[idx]);
+
+        if (status != SAI_STATUS_SUCCESS && result == SAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+sai_status_t sai_refcount_bulk_set(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ const sai_status_t *object_statuses)
+{
+    sai_status_t result = SAI_STATUS_SUCCESS;
+    sai_status_t status;
+    uint32_t idx;
+
+    if (refcount == NULL || (object_count != 0 && (meta_key == NULL || attr_list == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < object_count; idx++)
+    {
+        if (object_statuses != NULL && object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            continue;
+        }
+
+        status = sai_refcount_set_one(refcount, &meta_key[idx], &attr_list[idx]);
+
+        if (status != SAI_STATUS_SUCCESS && result == SAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+uint32_t sai_refcount_get_count(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id)
+{
+    const sai_refcount_object_t *object;
+    sai_refcount_key_t key;
+
+    if (refcount == NULL)
+    {
+        return 0;
+    }
+
+    sai_refcount_oid_key(object_id, &key);
+
+    object = sai_refcount_lookup(refcount, &key);
+
+    return (object == NULL) ? 0 : object->count;
+}
+
+bool sai_refcount_is_removable(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id)
+{
+    return sai_refcount_get_count(refcount, object_id) == 0;
+}
+
+sai_status_t sai_refcount_get_references(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id,
+        _Inout_ uint32_t *count,
+        _Out_ sai_refcount_reference_t *list)
+{
+    const sai_refcount_object_t *object;
+    const sai_refcount_edge_t *edge;
+    sai_refcount_key_t key;
+    uint32_t idx = 0;
+
+    if (refcount == NULL || count == NULL || (*count != 0 && list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    sai_refcount_oid_key(object_id, &key);
+
+    object = sai_refcount_lookup(refcount, &key);
+
+    if (object == NULL || object->count == 0)
+    {
+        *count = 0;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (*count < object->count)
+    {
+        *count = object->count;
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    for (edge = object->in; edge != NULL; edge = edge->next_in)
+    {
+        list[idx].meta_key = edge->from->meta_key;
+        list[idx].attrmetadata = edge->attrmetadata;
+        list[idx].structmember = edge->structmember;
+
+        idx++;
+    }
+
+    *count = idx;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void sai_refcount_get_stats(
+        _In_ const sai_refcount_t *refcount,
+        _Out_ sai_refcount_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (refcount != NULL)
+    {
+        stats->objects = refcount->count;
+        stats->references = refcount->references;
+    }
+}
@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairefcount.h
+ *
+ * @brief   This module defines SAI object reference counter
+ */
+
+#ifndef __SAIREFCOUNT_H_
+#define __SAIREFCOUNT_H_
+
+/**
+ * @defgroup SAIREFCOUNT SAI - Object reference counter
+ *
+ * Reference counter observes successful create, set and remove calls and
+ * keeps for each object id the number of references to it and the list of
+ * references (referencing object and its attribute or key member). Which
+ * attributes and key members can hold object ids is taken from reverse
+ * dependency graph of metadata (revgraphmembers), object id values of
+ * attributes (object id, object list and ACL field and action data) and of
+ * entry key members are references, NULL object id is not.
+ *
+ * Reference count of object id and whether it can be removed are answered
+ * in constant time, list of references in time proportional to its length.
+ * Object id referenced before its create was observed (like ports created
+ * by switch) is tracked implicitly. Object removed while still referenced
+ * stays tracked until the last reference is gone.
+ *
+ * Bulk variants take arguments and object statuses of executed bulk call
+ * and apply only objects which succeeded.
+ *
+ * Reference counter is not thread safe.
+ *
+ * @{
+ */
+
+/**
+ * @brief Single reference to object id
+ */
+typedef struct _sai_refcount_reference_t
+{
+    /**
+     * @brief Referencing object
+     */
+    sai_object_meta_key_t meta_key;
+
+    /**
+     * @brief Referencing attribute, NULL for entry key member
+     */
+    const sai_attr_metadata_t *attrmetadata;
+
+    /**
+     * @brief Referencing entry key member, NULL for attribute
+     */
+    const sai_struct_member_info_t *structmember;
+
+} sai_refcount_reference_t;
+
+/**
+ * @brief Reference counter statistics
+ */
+typedef struct _sai_refcount_stats_t
+{
+    /**
+     * @brief Number of tracked objects, including implicit ones
+     */
+    uint64_t objects;
+
+    /**
+     * @brief Number of references
+     */
+    uint64_t references;
+
+} sai_refcount_stats_t;
+
+/**
+ * @brief Opaque reference counter
+ */
+typedef struct _sai_refcount_t sai_refcount_t;
+
+/**
+ * @brief Create reference counter
+ *
+ * @return Reference counter or NULL on error
+ */
+extern sai_refcount_t* sai_refcount_open(void);
+
+/**
+ * @brief Destroy reference counter
+ *
+ * @param[inout] refcount Reference counter
+ */
+extern void sai_refcount_close(
+        _Inout_ sai_refcount_t *refcount);
+
+/**
+ * @brief Observe object create
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] meta_key Object type and key, object id of created object
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_ALREADY_EXISTS
+ * when object is already created, failure status code on error
+ */
+extern sai_status_t sai_refcount_create(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list);
+
+/**
+ * @brief Observe object remove
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] meta_key Object type and key
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_NOT_FOUND when
+ * object was not created
+ */
+extern sai_status_t sai_refcount_remove(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key);
+
+/**
+ * @brief Observe object attribute set
+ *
+ * References held by previous value of attribute are replaced.
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] meta_key Object type and key
+ * @param[in] attr Attribute
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_ITEM_NOT_FOUND when
+ * object was not created
+ */
+extern sai_status_t sai_refcount_set(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr);
+
+/**
+ * @brief Observe bulk create
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys, object ids of created objects
+ * @param[in] attr_count Number of attributes of each object
+ * @param[in] attr_list Attributes of each object
+ * @param[in] object_statuses Status of each object, NULL when all succeeded
+ *
+ * @return #SAI_STATUS_SUCCESS on success, first failure status otherwise
+ */
+extern sai_status_t sai_refcount_bulk_create(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _In_ const sai_status_t *object_statuses);
+
+/**
+ * @brief Observe bulk remove
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys
+ * @param[in] object_statuses Status of each object, NULL when all succeeded
+ *
+ * @return #SAI_STATUS_SUCCESS on success, first failure status otherwise
+ */
+extern sai_status_t sai_refcount_bulk_remove(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_status_t *object_statuses);
+
+/**
+ * @brief Observe bulk attribute set
+ *
+ * @param[inout] refcount Reference counter
+ * @param[in] object_count Number of objects
+ * @param[in] meta_key Object types and keys
+ * @param[in] attr_list Attribute of each object
+ * @param[in] object_statuses Status of each object, NULL when all succeeded
+ *
+ * @return #SAI_STATUS_SUCCESS on success, first failure status otherwise
+ */
+extern sai_status_t sai_refcount_bulk_set(
+        _Inout_ sai_refcount_t *refcount,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ const sai_attribute_t *attr_list,
+        _In_ const sai_status_t *object_statuses);
+
+/**
+ * @brief Get number of references to object id
+ *
+ * @param[in] refcount Reference counter
+ * @param[in] object_id Object id
+ *
+ * @return Number of references, 0 for unknown object id
+ */
+extern uint32_t sai_refcount_get_count(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Check whether object id is not referenced
+ *
+ * @param[in] refcount Reference counter
+ * @param[in] object_id Object id
+ *
+ * @return True when nothing references object id
+ */
+extern bool sai_refcount_is_removable(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Get references to object id
+ *
+ * @param[in] refcount Reference counter
+ * @param[in] object_id Object id
+ * @param[inout] count Size of list on input, number of references on output
+ * @param[out] list References
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_BUFFER_OVERFLOW when
+ * list is too small
+ */
+extern sai_status_t sai_refcount_get_references(
+        _In_ const sai_refcount_t *refcount,
+        _In_ sai_object_id_t object_id,
+        _Inout_ uint32_t *count,
+        _Out_ sai_refcount_reference_t *list);
+
+/**
+ * @brief Get reference counter statistics
+ *
+ * @param[in] refcount Reference counter
+ * @param[out] stats Statistics
+ */
+extern void sai_refcount_get_stats(
+        _In_ const sai_refcount_t *refcount,
+        _Out_ sai_refcount_stats_t *stats);
+
+/**
+ * @}
+ */
+#endif /** __SAIREFCOUNT_H_ */
@@ -0,0 +1,335 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    sairefcounttest.c
+ *
+ * @brief   This module implements SAI reference counter tests
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "sairefcount.h"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+#define TEST_SWITCH_ID          0x21000000000000ULL
+
+#define TEST_VIRTUAL_ROUTER_ID  0x3000000000001ULL
+
+#define TEST_NEXT_HOP_ID        0x4000000000001ULL
+
+#define TEST_MIRROR_SESSION_ID  0xe000000000001ULL
+
+#define TEST_PORT_ID            0x1000000000001ULL
+
+static void test_oid_key(
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t object_id,
+        _Out_ sai_object_meta_key_t *meta_key)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = object_type;
+    meta_key->objectkey.key.object_id = object_id;
+}
+
+static void test_route_key(
+        _In_ uint32_t index,
+        _Out_ sai_object_meta_key_t *meta_key)
+{
+    memset(meta_key, 0, sizeof(*meta_key));
+
+    meta_key->objecttype = SAI_OBJECT_TYPE_ROUTE_ENTRY;
+    meta_key->objectkey.key.route_entry.switch_id = TEST_SWITCH_ID;
+    meta_key->objectkey.key.route_entry.vr_id = TEST_VIRTUAL_ROUTER_ID;
+    meta_key->objectkey.key.route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    meta_key->objectkey.key.route_entry.destination.addr.ip4 = 0x0a000000 | index;
+    meta_key->objectkey.key.route_entry.destination.mask.ip4 = 0xffffffff;
+}
+
+static void test_next_hop_attr(
+        _In_ sai_object_id_t next_hop_id,
+        _Out_ sai_attribute_t *attr)
+{
+    attr->id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attr->value.oid = next_hop_id;
+}
+
+static void test_check_stats(
+        _In_ const sai_refcount_t *refcount,
+        _In_ uint64_t objects,
+        _In_ uint64_t references)
+{
+    sai_refcount_stats_t stats;
+
+    sai_refcount_get_stats(refcount, &stats);
+
+    ASSERT_TRUE(stats.objects == objects, "objects %lu, expected %lu",
+            (unsigned long)stats.objects, (unsigned long)objects);
+    ASSERT_TRUE(stats.references == references, "references %lu, expected %lu",
+            (unsigned long)stats.references, (unsigned long)references);
+}
+
+static void test_create_remove()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_refcount_reference_t refs[2];
+    sai_object_meta_key_t next_hop;
+    sai_object_meta_key_t route;
+    sai_attribute_t attr;
+    uint32_t count;
+
+    ASSERT_TRUE(refcount != NULL, "open");
+
+    test_oid_key(SAI_OBJECT_TYPE_NEXT_HOP, TEST_NEXT_HOP_ID, &next_hop);
+    test_route_key(1, &route);
+    test_next_hop_attr(TEST_NEXT_HOP_ID, &attr);
+
+    ASSERT_TRUE(sai_refcount_create(refcount, &next_hop, 0, NULL) == SAI_STATUS_SUCCESS, "create next hop");
+    ASSERT_TRUE(sai_refcount_create(refcount, &next_hop, 0, NULL) == SAI_STATUS_ITEM_ALREADY_EXISTS, "create twice");
+    ASSERT_TRUE(sai_refcount_is_removable(refcount, TEST_NEXT_HOP_ID), "next hop not referenced");
+
+    ASSERT_TRUE(sai_refcount_create(refcount, &route, 1, &attr) == SAI_STATUS_SUCCESS, "create route");
+
+    /* next hop by attribute, virtual router and switch by key members */
+
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 1, "next hop count");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_VIRTUAL_ROUTER_ID) == 1, "virtual router count");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_SWITCH_ID) == 1, "switch count");
+    ASSERT_TRUE(!sai_refcount_is_removable(refcount, TEST_NEXT_HOP_ID), "next hop referenced");
+
+    test_check_stats(refcount, 4, 3);
+
+    count = 0;
+
+    ASSERT_TRUE(sai_refcount_get_references(refcount, TEST_NEXT_HOP_ID, &count, NULL) == SAI_STATUS_BUFFER_OVERFLOW, "overflow");
+    ASSERT_TRUE(count == 1, "required count %u", count);
+
+    count = 2;
+
+    ASSERT_TRUE(sai_refcount_get_references(refcount, TEST_NEXT_HOP_ID, &count, refs) == SAI_STATUS_SUCCESS, "references");
+    ASSERT_TRUE(count == 1, "count %u", count);
+    ASSERT_TRUE(refs[0].meta_key.objecttype == SAI_OBJECT_TYPE_ROUTE_ENTRY, "referencing object type");
+    ASSERT_TRUE(refs[0].attrmetadata != NULL && refs[0].attrmetadata->attrid == SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID, "referencing attribute");
+    ASSERT_TRUE(refs[0].structmember == NULL, "not key member");
+
+    count = 2;
+
+    ASSERT_TRUE(sai_refcount_get_references(refcount, TEST_SWITCH_ID, &count, refs) == SAI_STATUS_SUCCESS, "switch references");
+    ASSERT_TRUE(count == 1 && refs[0].structmember != NULL && refs[0].attrmetadata == NULL, "switch referenced by key member");
+
+    ASSERT_TRUE(sai_refcount_remove(refcount, &route) == SAI_STATUS_SUCCESS, "remove route");
+    ASSERT_TRUE(sai_refcount_remove(refcount, &route) == SAI_STATUS_ITEM_NOT_FOUND, "remove twice");
+    ASSERT_TRUE(sai_refcount_is_removable(refcount, TEST_NEXT_HOP_ID), "next hop released");
+
+    /* implicitly tracked virtual router and switch are gone */
+
+    test_check_stats(refcount, 1, 0);
+
+    ASSERT_TRUE(sai_refcount_remove(refcount, &next_hop) == SAI_STATUS_SUCCESS, "remove next hop");
+
+    test_check_stats(refcount, 0, 0);
+
+    sai_refcount_close(refcount);
+}
+
+static void test_set()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_object_meta_key_t route;
+    sai_attribute_t attr;
+
+    test_route_key(1, &route);
+    test_next_hop_attr(TEST_NEXT_HOP_ID, &attr);
+
+    ASSERT_TRUE(sai_refcount_set(refcount, &route, &attr) == SAI_STATUS_ITEM_NOT_FOUND, "set before create");
+    ASSERT_TRUE(sai_refcount_create(refcount, &route, 1, &attr) == SAI_STATUS_SUCCESS, "create route");
+
+    test_next_hop_attr(TEST_NEXT_HOP_ID + 1, &attr);
+
+    ASSERT_TRUE(sai_refcount_set(refcount, &route, &attr) == SAI_STATUS_SUCCESS, "set next hop");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 0, "old next hop released");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID + 1) == 1, "new next hop referenced");
+
+    test_next_hop_attr(SAI_NULL_OBJECT_ID, &attr);
+
+    ASSERT_TRUE(sai_refcount_set(refcount, &route, &attr) == SAI_STATUS_SUCCESS, "set null");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID + 1) == 0, "next hop released");
+
+    /* attributes without object ids do not touch references */
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+
+    ASSERT_TRUE(sai_refcount_set(refcount, &route, &attr) == SAI_STATUS_SUCCESS, "set packet action");
+
+    test_check_stats(refcount, 3, 2);
+
+    sai_refcount_close(refcount);
+}
+
+static void test_object_list()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_object_id_t sessions[3] = { TEST_MIRROR_SESSION_ID, TEST_MIRROR_SESSION_ID + 1, TEST_MIRROR_SESSION_ID };
+    sai_object_meta_key_t port;
+    sai_attribute_t attr;
+
+    test_oid_key(SAI_OBJECT_TYPE_PORT, TEST_PORT_ID, &port);
+
+    attr.id = SAI_PORT_ATTR_INGRESS_MIRROR_SESSION;
+    attr.value.objlist.count = 3;
+    attr.value.objlist.list = sessions;
+
+    ASSERT_TRUE(sai_refcount_create(refcount, &port, 1, &attr) == SAI_STATUS_SUCCESS, "create port");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_MIRROR_SESSION_ID) == 2, "every list item is reference");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_MIRROR_SESSION_ID + 1) == 1, "second session");
+
+    attr.value.objlist.count = 1;
+
+    ASSERT_TRUE(sai_refcount_set(refcount, &port, &attr) == SAI_STATUS_SUCCESS, "set list");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_MIRROR_SESSION_ID) == 1, "first session");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_MIRROR_SESSION_ID + 1) == 0, "second session released");
+
+    test_check_stats(refcount, 2, 1);
+
+    sai_refcount_close(refcount);
+}
+
+static void test_remove_referenced()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_object_meta_key_t next_hop;
+    sai_object_meta_key_t route;
+    sai_attribute_t attr;
+
+    test_oid_key(SAI_OBJECT_TYPE_NEXT_HOP, TEST_NEXT_HOP_ID, &next_hop);
+    test_route_key(1, &route);
+    test_next_hop_attr(TEST_NEXT_HOP_ID, &attr);
+
+    /* route referencing next hop which is not yet known */
+
+    ASSERT_TRUE(sai_refcount_create(refcount, &route, 1, &attr) == SAI_STATUS_SUCCESS, "create route");
+    ASSERT_TRUE(sai_refcount_remove(refcount, &next_hop) == SAI_STATUS_ITEM_NOT_FOUND, "implicit object not created");
+    ASSERT_TRUE(sai_refcount_create(refcount, &next_hop, 0, NULL) == SAI_STATUS_SUCCESS, "create next hop");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 1, "count kept");
+
+    ASSERT_TRUE(sai_refcount_remove(refcount, &next_hop) == SAI_STATUS_SUCCESS, "remove next hop");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 1, "still referenced");
+
+    ASSERT_TRUE(sai_refcount_remove(refcount, &route) == SAI_STATUS_SUCCESS, "remove route");
+
+    test_check_stats(refcount, 0, 0);
+
+    sai_refcount_close(refcount);
+}
+
+static void test_bulk()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_object_meta_key_t routes[3];
+    sai_status_t statuses[3] = { SAI_STATUS_SUCCESS, SAI_STATUS_FAILURE, SAI_STATUS_SUCCESS };
+    const sai_attribute_t *attr_list[3];
+    sai_attribute_t attrs[3];
+    uint32_t attr_count[3];
+    uint32_t idx;
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        test_route_key(idx, &routes[idx]);
+        test_next_hop_attr(TEST_NEXT_HOP_ID, &attrs[idx]);
+
+        attr_count[idx] = 1;
+        attr_list[idx] = &attrs[idx];
+    }
+
+    ASSERT_TRUE(sai_refcount_bulk_create(refcount, 3, routes, attr_count, attr_list, statuses) == SAI_STATUS_SUCCESS, "bulk create");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 2, "failed object not applied");
+
+    ASSERT_TRUE(sai_refcount_bulk_create(refcount, 3, routes, attr_count, attr_list, NULL) == SAI_STATUS_ITEM_ALREADY_EXISTS, "first failure");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 3, "all created");
+
+    for (idx = 0; idx < 3; idx++)
+    {
+        test_next_hop_attr(TEST_NEXT_HOP_ID + 1, &attrs[idx]);
+    }
+
+    statuses[1] = SAI_STATUS_SUCCESS;
+    statuses[2] = SAI_STATUS_NOT_EXECUTED;
+
+    ASSERT_TRUE(sai_refcount_bulk_set(refcount, 3, routes, attrs, statuses) == SAI_STATUS_SUCCESS, "bulk set");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 1, "not executed object keeps reference");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID + 1) == 2, "new references");
+
+    ASSERT_TRUE(sai_refcount_bulk_remove(refcount, 3, routes, statuses) == SAI_STATUS_SUCCESS, "bulk remove");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID + 1) == 0, "references released");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, TEST_NEXT_HOP_ID) == 1, "remaining route");
+
+    ASSERT_TRUE(sai_refcount_bulk_remove(refcount, 3, routes, NULL) == SAI_STATUS_ITEM_NOT_FOUND, "first failure");
+
+    test_check_stats(refcount, 0, 0);
+
+    sai_refcount_close(refcount);
+}
+
+static void test_invalid()
+{
+    sai_refcount_t *refcount = sai_refcount_open();
+    sai_object_meta_key_t meta_key;
+    uint32_t count = 1;
+
+    test_oid_key(SAI_OBJECT_TYPE_NULL, 1, &meta_key);
+
+    ASSERT_TRUE(sai_refcount_create(refcount, &meta_key, 0, NULL) == SAI_STATUS_INVALID_OBJECT_TYPE, "null object type");
+    ASSERT_TRUE(sai_refcount_create(refcount, NULL, 0, NULL) == SAI_STATUS_INVALID_PARAMETER, "null meta key");
+    ASSERT_TRUE(sai_refcount_create(NULL, &meta_key, 0, NULL) == SAI_STATUS_INVALID_PARAMETER, "null refcount");
+    ASSERT_TRUE(sai_refcount_get_references(refcount, 1, &count, NULL) == SAI_STATUS_INVALID_PARAMETER, "null list");
+    ASSERT_TRUE(sai_refcount_get_count(refcount, 1) == 0, "unknown object id");
+    ASSERT_TRUE(sai_refcount_is_removable(refcount, 1), "unknown object id removable");
+
+    sai_refcount_close(refcount);
+}
+
+int main()
+{
+    test_create_remove();
+
+    test_set();
+
+    test_object_list();
+
+    test_remove_referenced();
+
+    test_bulk();
+
+    test_invalid();
+
+    return 0;
+}
@@ -0,0 +1,1846 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saireplay.c
+ *
+ * @brief   This module implements SAI recorded call stream replay tool
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "sairecorder.h"
+
+/*
+ * Replayed calls are grouped by operation, bulk variants of recorded calls
+ * are counted as their single object operation.
+ */
+
+#define SAI_REPLAY_OP_CREATE    0
+#define SAI_REPLAY_OP_REMOVE    1
+#define SAI_REPLAY_OP_SET       2
+#define SAI_REPLAY_OP_GET       3
+#define SAI_REPLAY_OPS          4
+
+/*
+ * Same log-linear latency buckets as tracing interposer uses, about 25%
+ * relative precision.
+ */
+
+#define SAI_REPLAY_SUB_BUCKET_BITS 2
+#define SAI_REPLAY_SUB_BUCKETS (1 << SAI_REPLAY_SUB_BUCKET_BITS)
+#define SAI_REPLAY_MAX_EXPONENT 36
+#define SAI_REPLAY_BUCKETS \
+    (SAI_REPLAY_SUB_BUCKETS * (SAI_REPLAY_MAX_EXPONENT - SAI_REPLAY_SUB_BUCKET_BITS + 2))
+
+/*
+ * Serialized attribute is not bounded by serialize functions, buffer must be
+ * large enough for longest list in stream.
+ */
+
+#define SAI_REPLAY_JSON_BUFFER_SIZE (16 * 1024 * 1024)
+
+#define SAI_REPLAY_MAX_PROFILE_VALUES 256
+
+#define SAI_REPLAY_MAX_DIVERGENCES_PRINT 100
+
+/*
+ * Recorded object ids of tombstone entries in object id map, null object id
+ * marks empty entry.
+ */
+
+#define SAI_REPLAY_OID_TOMBSTONE ((sai_object_id_t)-1)
+
+typedef struct _sai_replay_counters_t
+{
+    uint64_t objects;
+    uint64_t divergent;
+    uint64_t calls;
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    uint64_t latency[SAI_REPLAY_BUCKETS];
+    uint64_t bulk_calls;
+    uint64_t bulk_objects;
+
+} sai_replay_counters_t;
+
+typedef struct _sai_replay_oid_entry_t
+{
+    sai_object_id_t recorded;
+
+    sai_object_id_t replayed;
+
+} sai_replay_oid_entry_t;
+
+/*
+ * Open addressing map from recorded to replayed object id, linear probing,
+ * removed entries are kept as tombstones until next resize.
+ */
+
+typedef struct _sai_replay_oid_map_t
+{
+    sai_replay_oid_entry_t *entries;
+
+    size_t capacity;
+
+    size_t used;
+
+    size_t count;
+
+} sai_replay_oid_map_t;
+
+typedef struct _sai_replay_input_t
+{
+    sai_recorder_reader_t *reader;
+
+    gzFile json;
+
+    char *line;
+
+    size_t capacity;
+
+    uint64_t line_number;
+
+    sai_attribute_t *attrs;
+
+    uint32_t attr_count;
+
+    uint32_t attrs_capacity;
+
+    sai_object_type_t object_type;
+
+} sai_replay_input_t;
+
+/*
+ * Consecutive records of the same operation and object type waiting for
+ * single bulk call.
+ */
+
+typedef struct _sai_replay_batch_t
+{
+    int op;
+
+    sai_object_type_t object_type;
+
+    sai_object_id_t switch_id;
+
+    uint32_t count;
+
+    sai_recorder_record_t *records;
+
+    sai_object_meta_key_t *meta_keys;
+
+    uint32_t *attr_counts;
+
+    const sai_attribute_t **attr_lists;
+
+    sai_attribute_t **get_attr_lists;
+
+    sai_attribute_t *set_attrs;
+
+    sai_status_t *statuses;
+
+} sai_replay_batch_t;
+
+static const char *sai_replay_op_names[SAI_REPLAY_OPS] = { "create", "remove", "set", "get" };
+
+static sai_apis_t sai_replay_apis;
+
+static sai_replay_oid_map_t sai_replay_oids;
+
+static sai_replay_counters_t *sai_replay_counters[SAI_REPLAY_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static sai_replay_batch_t sai_replay_batch;
+
+static uint32_t sai_replay_bulk_size = 0;
+
+static sai_bulk_op_error_mode_t sai_replay_bulk_mode = SAI_BULK_OP_ERROR_MODE_IGNORE_ERROR;
+
+static uint8_t sai_replay_bulk_unsupported[SAI_REPLAY_OPS][SAI_METADATA_OBJECT_TYPE_INDEX_COUNT];
+
+static int sai_replay_verbose = 0;
+
+static uint64_t sai_replay_records = 0;
+
+static uint64_t sai_replay_skipped = 0;
+
+static uint64_t sai_replay_lost = 0;
+
+static uint64_t sai_replay_divergences = 0;
+
+static uint64_t sai_replay_unmapped = 0;
+
+static uint64_t sai_replay_learned = 0;
+
+static const char *sai_replay_profile_keys[SAI_REPLAY_MAX_PROFILE_VALUES];
+
+static const char *sai_replay_profile_values[SAI_REPLAY_MAX_PROFILE_VALUES];
+
+static size_t sai_replay_profile_count = 0;
+
+static size_t sai_replay_profile_iterator = 0;
+
+static size_t sai_replay_bucket_index(
+        _In_ uint64_t value)
+{
+    int exp;
+    size_t sub;
+
+    if (value < SAI_REPLAY_SUB_BUCKETS)
+    {
+        return (size_t)value;
+    }
+
+    exp = 63 - __builtin_clzll(value);
+
+    if (exp > SAI_REPLAY_MAX_EXPONENT)
+    {
+        return SAI_REPLAY_BUCKETS - 1;
+    }
+
+    sub = (size_t)(value >> (exp - SAI_REPLAY_SUB_BUCKET_BITS)) & (SAI_REPLAY_SUB_BUCKETS - 1);
+
+    return SAI_REPLAY_SUB_BUCKETS * (size_t)(exp - SAI_REPLAY_SUB_BUCKET_BITS + 1) + sub;
+}
+
+static uint64_t sai_replay_bucket_value(
+        _In_ size_t bucket)
+{
+    int exp;
+    uint64_t sub;
+
+    if (bucket < SAI_REPLAY_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    exp = (int)(bucket / SAI_REPLAY_SUB_BUCKETS) + SAI_REPLAY_SUB_BUCKET_BITS - 1;
+
+    sub = bucket % SAI_REPLAY_SUB_BUCKETS;
+
+    return (SAI_REPLAY_SUB_BUCKETS + sub) << (exp - SAI_REPLAY_SUB_BUCKET_BITS);
+}
+
+static int sai_replay_get_op(
+        _In_ int32_t api)
+{
+    switch (api)
+    {
+        case SAI_COMMON_API_CREATE:
+        case SAI_COMMON_API_BULK_CREATE:
+            return SAI_REPLAY_OP_CREATE;
+
+        case SAI_COMMON_API_REMOVE:
+        case SAI_COMMON_API_BULK_REMOVE:
+            return SAI_REPLAY_OP_REMOVE;
+
+        case SAI_COMMON_API_SET:
+        case SAI_COMMON_API_BULK_SET:
+            return SAI_REPLAY_OP_SET;
+
+        case SAI_COMMON_API_GET:
+        case SAI_COMMON_API_BULK_GET:
+            return SAI_REPLAY_OP_GET;
+
+        default:
+            return -1;
+    }
+}
+
+static const char* sai_replay_status_name(
+        _In_ sai_status_t status)
+{
+    const char *name = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_status_t, status);
+
+    return (name != NULL) ? name : "unknown";
+}
+
+static const char* sai_replay_object_type_name(
+        _In_ sai_object_type_t object_type)
+{
+    const char *name = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t, object_type);
+
+    return (name != NULL) ? name : "unknown";
+}
+
+/* object id map */
+
+static size_t sai_replay_oid_hash(
+        _In_ sai_object_id_t oid)
+{
+    /* object ids differ mostly in low index bits and in type bits */
+
+    oid ^= oid >> 33;
+    oid *= 0xff51afd7ed558ccdULL;
+    oid ^= oid >> 33;
+
+    return (size_t)oid;
+}
+
+static void sai_replay_oid_map_resize(
+        _Inout_ sai_replay_oid_map_t *map,
+        _In_ size_t capacity)
+{
+    sai_replay_oid_entry_t *entries = (sai_replay_oid_entry_t*)calloc(capacity, sizeof(sai_replay_oid_entry_t));
+    size_t idx;
+
+    if (entries == NULL)
+    {
+        fprintf(stderr, "failed to allocate object id map of %zu entries\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+
+    for (idx = 0; idx < map->capacity; idx++)
+    {
+        sai_replay_oid_entry_t *entry = &map->entries[idx];
+        size_t pos;
+
+        if (entry->recorded == SAI_NULL_OBJECT_ID || entry->recorded == SAI_REPLAY_OID_TOMBSTONE)
+        {
+            continue;
+        }
+
+        pos = sai_replay_oid_hash(entry->recorded) & (capacity - 1);
+
+        while (entries[pos].recorded != SAI_NULL_OBJECT_ID)
+        {
+            pos = (pos + 1) & (capacity - 1);
+        }
+
+        entries[pos] = *entry;
+    }
+
+    free(map->entries);
+
+    map->entries = entries;
+    map->capacity = capacity;
+    map->used = map->count;
+}
+
+static sai_replay_oid_entry_t* sai_replay_oid_map_find(
+        _In_ const sai_replay_oid_map_t *map,
+        _In_ sai_object_id_t recorded)
+{
+    size_t pos;
+
+    if (map->capacity == 0)
+    {
+        return NULL;
+    }
+
+    pos = sai_replay_oid_hash(recorded) & (map->capacity - 1);
+
+    while (map->entries[pos].recorded != SAI_NULL_OBJECT_ID)
+    {
+        if (map->entries[pos].recorded == recorded)
+        {
+            return &map->entries[pos];
+        }
+
+        pos = (pos + 1) & (map->capacity - 1);
+    }
+
+    return NULL;
+}
+
+static void sai_replay_oid_map_insert(
+        _Inout_ sai_replay_oid_map_t *map,
+        _In_ sai_object_id_t recorded,
+        _In_ sai_object_id_t replayed)
+{
+    sai_replay_oid_entry_t *entry;
+    size_t pos;
+
+    if (recorded == SAI_NULL_OBJECT_ID || recorded == SAI_REPLAY_OID_TOMBSTONE)
+    {
+        return;
+    }
+
+    entry = sai_replay_oid_map_find(map, recorded);
+
+    if (entry != NULL)
+    {
+        entry->replayed = replayed;
+        return;
+    }
+
+    /* keep load including tombstones below 1/2, probes stay short */
+
+    if (2 * (map->used + 1) > map->capacity)
+    {
+        size_t capacity = (map->capacity == 0) ? 1024 : map->capacity;
+
+        while (2 * (map->count + 1) > capacity / 2)
+        {
+            capacity *= 2;
+        }
+
+        sai_replay_oid_map_resize(map, capacity);
+    }
+
+    pos = sai_replay_oid_hash(recorded) & (map->capacity - 1);
+
+    while (map->entries[pos].recorded != SAI_NULL_OBJECT_ID && map->entries[pos].recorded != SAI_REPLAY_OID_TOMBSTONE)
+    {
+        pos = (pos + 1) & (map->capacity - 1);
+    }
+
+    if (map->entries[pos].recorded == SAI_NULL_OBJECT_ID)
+    {
+        map->used++;
+    }
+
+    map->entries[pos].recorded = recorded;
+    map->entries[pos].replayed = replayed;
+    map->count++;
+}
+
+static void sai_replay_oid_map_remove(
+        _Inout_ sai_replay_oid_map_t *map,
+        _In_ sai_object_id_t recorded)
+{
+    sai_replay_oid_entry_t *entry = sai_replay_oid_map_find(map, recorded);
+
+    if (entry != NULL)
+    {
+        entry->recorded = SAI_REPLAY_OID_TOMBSTONE;
+        map->count--;
+    }
+}
+
+static sai_object_id_t sai_replay_translate_oid(
+        _In_ sai_object_id_t oid)
+{
+    const sai_replay_oid_entry_t *entry;
+
+    if (oid == SAI_NULL_OBJECT_ID)
+    {
+        return oid;
+    }
+
+    entry = sai_replay_oid_map_find(&sai_replay_oids, oid);
+
+    if (entry != NULL)
+    {
+        return entry->replayed;
+    }
+
+    /*
+     * Object was not created nor discovered by get in replayed stream, like
+     * object created before recording started, it is passed unchanged.
+     */
+
+    sai_replay_unmapped++;
+
+    return oid;
+}
+
+static void sai_replay_translate_list(
+        _Inout_ sai_object_list_t *list)
+{
+    uint32_t idx;
+
+    if (list->list == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < list->count; idx++)
+    {
+        list->list[idx] = sai_replay_translate_oid(list->list[idx]);
+    }
+}
+
+static void sai_replay_translate_meta_key(
+        _Inout_ sai_object_meta_key_t *meta_key,
+        _In_ int op)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key->objecttype);
+    size_t idx;
+
+    if (info == NULL)
+    {
+        return;
+    }
+
+    if (!info->isnonobjectid)
+    {
+        /* created object id is output of create */
+
+        if (op != SAI_REPLAY_OP_CREATE)
+        {
+            meta_key->objectkey.key.object_id = sai_replay_translate_oid(meta_key->objectkey.key.object_id);
+        }
+
+        return;
+    }
+
+    for (idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *member = info->structmembers[idx];
+
+        if (member->getoid != NULL && member->setoid != NULL)
+        {
+            member->setoid(meta_key, sai_replay_translate_oid(member->getoid(meta_key)));
+        }
+    }
+}
+
+static void sai_replay_translate_attrs(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+        sai_attribute_value_t *value = &attr_list[idx].value;
+
+        if (md == NULL)
+        {
+            continue;
+        }
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+                value->oid = sai_replay_translate_oid(value->oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+                sai_replay_translate_list(&value->objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+                value->aclfield.data.oid = sai_replay_translate_oid(value->aclfield.data.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+                sai_replay_translate_list(&value->aclfield.data.objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+                value->aclaction.parameter.oid = sai_replay_translate_oid(value->aclaction.parameter.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+                sai_replay_translate_list(&value->aclaction.parameter.objlist);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_POINTER:
+
+                /* recorded pointers belong to recording process */
+
+                value->ptr = NULL;
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ * Collect object ids from attribute values in attribute order, used to pair
+ * recorded get results with replayed ones. Returns number of object ids,
+ * which may be larger than capacity.
+ */
+
+static size_t sai_replay_collect_oids(
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ sai_object_id_t *oids,
+        _In_ size_t capacity)
+{
+    size_t count = 0;
+    uint32_t idx;
+    uint32_t n;
+
+#define SAI_REPLAY_COLLECT(oid) { if (count < capacity) { oids[count] = (oid); } count++; }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+        const sai_attribute_value_t *value = &attr_list[idx].value;
+        const sai_object_list_t *list = NULL;
+
+        if (md == NULL)
+        {
+            continue;
+        }
+
+        switch (md->attrvaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+                SAI_REPLAY_COLLECT(value->oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+                list = &value->objlist;
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+                SAI_REPLAY_COLLECT(value->aclfield.data.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+                list = &value->aclfield.data.objlist;
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+                SAI_REPLAY_COLLECT(value->aclaction.parameter.oid);
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+                list = &value->aclaction.parameter.objlist;
+                break;
+
+            default:
+                break;
+        }
+
+        for (n = 0; list != NULL && list->list != NULL && n < list->count; n++)
+        {
+            SAI_REPLAY_COLLECT(list->list[n]);
+        }
+    }
+
+    return count;
+
+#undef SAI_REPLAY_COLLECT
+}
+
+/* statistics */
+
+static sai_replay_counters_t* sai_replay_get_counters(
+        _In_ int op,
+        _In_ sai_object_type_t object_type)
+{
+    sai_replay_counters_t **counters = &sai_replay_counters[op][sai_metadata_object_type_index(object_type)];
+
+    if (*counters == NULL)
+    {
+        *counters = (sai_replay_counters_t*)calloc(1, sizeof(sai_replay_counters_t));
+
+        if (*counters == NULL)
+        {
+            fprintf(stderr, "failed to allocate counters\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return *counters;
+}
+
+static void sai_replay_account(
+        _In_ int op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ uint64_t latency,
+        _In_ int bulk)
+{
+    sai_replay_counters_t *counters = sai_replay_get_counters(op, object_type);
+    uint64_t per_object = latency / object_count;
+
+    /* latency of bulk call is spread over its objects */
+
+    counters->objects += object_count;
+    counters->calls++;
+    counters->latency_sum += latency;
+    counters->latency[sai_replay_bucket_index(per_object)] += object_count;
+
+    if (per_object > counters->latency_max)
+    {
+        counters->latency_max = per_object;
+    }
+
+    if (bulk)
+    {
+        counters->bulk_calls++;
+        counters->bulk_objects += object_count;
+    }
+}
+
+static void sai_replay_check_status(
+        _In_ int op,
+        _In_ const sai_recorder_record_t *record,
+        _In_ sai_status_t status)
+{
+    if (status == record->header.status)
+    {
+        return;
+    }
+
+    sai_replay_get_counters(op, record->header.meta_key.objecttype)->divergent++;
+
+    if (sai_replay_verbose || sai_replay_divergences < SAI_REPLAY_MAX_DIVERGENCES_PRINT)
+    {
+        fprintf(stderr, "record %" PRIu64 ": %s %s recorded %s, replayed %s\n",
+                record->header.sequence,
+                sai_replay_op_names[op],
+                sai_replay_object_type_name(record->header.meta_key.objecttype),
+                sai_replay_status_name(record->header.status),
+                sai_replay_status_name(status));
+    }
+
+    sai_replay_divergences++;
+}
+
+static uint64_t sai_replay_percentile(
+        _In_ const sai_replay_counters_t *counters,
+        _In_ uint64_t permille)
+{
+    uint64_t rank = counters->objects * permille / 1000;
+    uint64_t seen = 0;
+    size_t i;
+
+    for (i = 0; i < SAI_REPLAY_BUCKETS; i++)
+    {
+        seen += counters->latency[i];
+
+        if (seen > rank)
+        {
+            return sai_replay_bucket_value(i);
+        }
+    }
+
+    return counters->latency_max;
+}
+
+static void sai_replay_print_header(
+        _Inout_ FILE *file,
+        _In_ const char *title)
+{
+    fprintf(file, "\n%-56s %12s %10s %10s %10s %10s %12s %10s %12s\n",
+            title, "objects", "divergent", "avg_ns", "p50_ns", "p99_ns", "max_ns",
+            "bulk_calls", "bulk_objs");
+}
+
+static void sai_replay_print(
+        _Inout_ FILE *file,
+        _In_ const char *name,
+        _In_ const sai_replay_counters_t *counters)
+{
+    if (counters->objects == 0)
+    {
+        return;
+    }
+
+    fprintf(file, "%-56s %12"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %12"PRIu64" %10"PRIu64" %12"PRIu64"\n",
+            name,
+            counters->objects,
+            counters->divergent,
+            counters->latency_sum / counters->objects,
+            sai_replay_percentile(counters, 500),
+            sai_replay_percentile(counters, 990),
+            counters->latency_max,
+            counters->bulk_calls,
+            counters->bulk_objects);
+}
+
+static void sai_replay_merge(
+        _Inout_ sai_replay_counters_t *total,
+        _In_ const sai_replay_counters_t *counters)
+{
+    size_t i;
+
+    total->objects += counters->objects;
+    total->divergent += counters->divergent;
+    total->calls += counters->calls;
+    total->latency_sum += counters->latency_sum;
+    total->bulk_calls += counters->bulk_calls;
+    total->bulk_objects += counters->bulk_objects;
+
+    if (counters->latency_max > total->latency_max)
+    {
+        total->latency_max = counters->latency_max;
+    }
+
+    for (i = 0; i < SAI_REPLAY_BUCKETS; i++)
+    {
+        total->latency[i] += counters->latency[i];
+    }
+}
+
+static void sai_replay_report(
+        _Inout_ FILE *file,
+        _In_ uint64_t elapsed)
+{
+    sai_replay_counters_t total;
+    sai_replay_counters_t api;
+    char name[128];
+    uint64_t calls = 0;
+    size_t i;
+    int op;
+
+    memset(&total, 0, sizeof(total));
+
+    sai_replay_print_header(file, "api");
+
+    for (op = 0; op < SAI_REPLAY_OPS; op++)
+    {
+        memset(&api, 0, sizeof(api));
+
+        for (i = 0; i < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; i++)
+        {
+            if (sai_replay_counters[op][i] != NULL)
+            {
+                sai_replay_merge(&api, sai_replay_counters[op][i]);
+            }
+        }
+
+        sai_replay_print(file, sai_replay_op_names[op], &api);
+
+        sai_replay_merge(&total, &api);
+    }
+
+    sai_replay_print(file, "total", &total);
+
+    sai_replay_print_header(file, "api object type");
+
+    for (op = 0; op < SAI_REPLAY_OPS; op++)
+    {
+        for (i = 0; i < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; i++)
+        {
+            if (sai_replay_counters[op][i] == NULL)
+            {
+                continue;
+            }
+
+            snprintf(name, sizeof(name), "%s %s", sai_replay_op_names[op],
+                    sai_replay_object_type_name(sai_metadata_object_type_from_index(i)));
+
+            sai_replay_print(file, name, sai_replay_counters[op][i]);
+        }
+    }
+
+    calls = total.calls;
+
+    fprintf(file, "\nrecords %" PRIu64 ", replayed objects %" PRIu64 " in %" PRIu64 " calls, skipped %" PRIu64 ", lost while recording %" PRIu64 "\n",
+            sai_replay_records, total.objects, calls, sai_replay_skipped, sai_replay_lost);
+
+    fprintf(file, "elapsed %.3f s, %.0f objects/s, time in SAI %.3f s, %.0f objects/s\n",
+            (double)elapsed / 1e9,
+            (elapsed == 0) ? 0.0 : (double)total.objects * 1e9 / (double)elapsed,
+            (double)total.latency_sum / 1e9,
+            (total.latency_sum == 0) ? 0.0 : (double)total.objects * 1e9 / (double)total.latency_sum);
+
+    fprintf(file, "status divergences %" PRIu64 ", object ids mapped %zu, learned by get %" PRIu64 ", unmapped uses %" PRIu64 "\n",
+            sai_replay_divergences, sai_replay_oids.count, sai_replay_learned, sai_replay_unmapped);
+}
+
+/* replay of single record */
+
+static void sai_replay_after_create(
+        _In_ const sai_recorder_record_t *record,
+        _In_ const sai_object_meta_key_t *meta_key,
+        _In_ sai_status_t status)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key->objecttype);
+
+    if (status == SAI_STATUS_SUCCESS && info != NULL && !info->isnonobjectid)
+    {
+        sai_replay_oid_map_insert(&sai_replay_oids, record->header.meta_key.objectkey.key.object_id, meta_key->objectkey.key.object_id);
+    }
+}
+
+static void sai_replay_after_remove(
+        _In_ const sai_recorder_record_t *record,
+        _In_ sai_status_t status)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(record->header.meta_key.objecttype);
+
+    if (status == SAI_STATUS_SUCCESS && info != NULL && !info->isnonobjectid)
+    {
+        sai_replay_oid_map_remove(&sai_replay_oids, record->header.meta_key.objectkey.key.object_id);
+    }
+}
+
+/*
+ * Get of record with failed recorded get is replayed with empty lists, like
+ * caller asking for list size. Recorded object ids are stashed, since get
+ * overwrites them, and paired with replayed ones afterwards, this maps
+ * objects created implicitly by switch, like ports or default virtual
+ * router.
+ */
+
+static sai_object_id_t* sai_replay_before_get(
+        _Inout_ sai_recorder_record_t *record,
+        _Out_ size_t *count)
+{
+    sai_object_type_t object_type = record->header.meta_key.objecttype;
+    sai_object_id_t *oids;
+
+    *count = 0;
+
+    if (record->header.status != SAI_STATUS_SUCCESS)
+    {
+        sai_recorder_reset_empty_lists(object_type, record->header.attr_count, record->attr_list);
+
+        return NULL;
+    }
+
+    *count = sai_replay_collect_oids(object_type, record->header.attr_count, record->attr_list, NULL, 0);
+
+    if (*count == 0)
+    {
+        return NULL;
+    }
+
+    oids = (sai_object_id_t*)malloc(*count * sizeof(sai_object_id_t));
+
+    if (oids == NULL)
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    sai_replay_collect_oids(object_type, record->header.attr_count, record->attr_list, oids, *count);
+
+    return oids;
+}
+
+static void sai_replay_after_get(
+        _In_ const sai_recorder_record_t *record,
+        _In_ sai_status_t status,
+        _In_ sai_object_id_t *recorded,
+        _In_ size_t count)
+{
+    sai_object_type_t object_type = record->header.meta_key.objecttype;
+    sai_object_id_t *replayed;
+    size_t idx;
+
+    if (recorded == NULL)
+    {
+        return;
+    }
+
+    replayed = (status == SAI_STATUS_SUCCESS) ? (sai_object_id_t*)malloc(count * sizeof(sai_object_id_t)) : NULL;
+
+    /* lists of different length can not be paired */
+
+    if (replayed != NULL && sai_replay_collect_oids(object_type, record->header.attr_count, record->attr_list, replayed, count) == count)
+    {
+        for (idx = 0; idx < count; idx++)
+        {
+            if (recorded[idx] != SAI_NULL_OBJECT_ID && sai_replay_oid_map_find(&sai_replay_oids, recorded[idx]) == NULL)
+            {
+                sai_replay_oid_map_insert(&sai_replay_oids, recorded[idx], replayed[idx]);
+
+                sai_replay_learned++;
+            }
+        }
+    }
+
+    free(replayed);
+    free(recorded);
+}
+
+static void sai_replay_single(
+        _Inout_ sai_recorder_record_t *record,
+        _In_ int translated)
+{
+    sai_object_meta_key_t meta_key = record->header.meta_key;
+    sai_object_id_t switch_id = sai_replay_translate_oid(record->header.switch_id);
+    int op = sai_replay_get_op(record->header.api);
+    sai_status_t status = SAI_STATUS_FAILURE;
+    sai_object_id_t *oids = NULL;
+    size_t oid_count = 0;
+    uint64_t start;
+    uint64_t end;
+
+    sai_replay_translate_meta_key(&meta_key, op);
+
+    if (op == SAI_REPLAY_OP_GET)
+    {
+        oids = sai_replay_before_get(record, &oid_count);
+    }
+    else if (!translated)
+    {
+        sai_replay_translate_attrs(meta_key.objecttype, record->header.attr_count, record->attr_list);
+    }
+
+    start = sai_metadata_now();
+
+    switch (op)
+    {
+        case SAI_REPLAY_OP_CREATE:
+            status = sai_metadata_generic_create(&sai_replay_apis, &meta_key, switch_id, record->header.attr_count, record->attr_list);
+            break;
+
+        case SAI_REPLAY_OP_REMOVE:
+            status = sai_metadata_generic_remove(&sai_replay_apis, &meta_key);
+            break;
+
+        case SAI_REPLAY_OP_SET:
+            status = (record->header.attr_count == 1)
+                ? sai_metadata_generic_set(&sai_replay_apis, &meta_key, record->attr_list)
+                : SAI_STATUS_INVALID_PARAMETER;
+            break;
+
+        case SAI_REPLAY_OP_GET:
+            status = sai_metadata_generic_get(&sai_replay_apis, &meta_key, record->header.attr_count, record->attr_list);
+            break;
+
+        default:
+            break;
+    }
+
+    end = sai_metadata_now();
+
+    sai_replay_account(op, meta_key.objecttype, 1, end - start, 0);
+
+    sai_replay_check_status(op, record, status);
+
+    switch (op)
+    {
+        case SAI_REPLAY_OP_CREATE:
+            sai_replay_after_create(record, &meta_key, status);
+            break;
+
+        case SAI_REPLAY_OP_REMOVE:
+            sai_replay_after_remove(record, status);
+            break;
+
+        case SAI_REPLAY_OP_GET:
+            sai_replay_after_get(record, status, oids, oid_count);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* bulk coalescing */
+
+static void sai_replay_batch_init(
+        _In_ uint32_t size)
+{
+    sai_replay_batch_t *batch = &sai_replay_batch;
+
+    batch->records = (sai_recorder_record_t*)calloc(size, sizeof(sai_recorder_record_t));
+    batch->meta_keys = (sai_object_meta_key_t*)calloc(size, sizeof(sai_object_meta_key_t));
+    batch->attr_counts = (uint32_t*)calloc(size, sizeof(uint32_t));
+    batch->attr_lists = (const sai_attribute_t**)calloc(size, sizeof(sai_attribute_t*));
+    batch->get_attr_lists = (sai_attribute_t**)calloc(size, sizeof(sai_attribute_t*));
+    batch->set_attrs = (sai_attribute_t*)calloc(size, sizeof(sai_attribute_t));
+    batch->statuses = (sai_status_t*)calloc(size, sizeof(sai_status_t));
+
+    if (batch->records == NULL || batch->meta_keys == NULL || batch->attr_counts == NULL ||
+            batch->attr_lists == NULL || batch->get_attr_lists == NULL || batch->set_attrs == NULL ||
+            batch->statuses == NULL)
+    {
+        fprintf(stderr, "failed to allocate bulk of %u objects\n", size);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void sai_replay_batch_release(
+        _Inout_ sai_replay_batch_t *batch)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < batch->count; idx++)
+    {
+        sai_recorder_record_free(&batch->records[idx]);
+    }
+
+    batch->count = 0;
+}
+
+static sai_status_t sai_replay_batch_call(
+        _Inout_ sai_replay_batch_t *batch)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < batch->count; idx++)
+    {
+        sai_recorder_record_t *record = &batch->records[idx];
+
+        batch->meta_keys[idx] = record->header.meta_key;
+
+        sai_replay_translate_meta_key(&batch->meta_keys[idx], batch->op);
+
+        if (batch->op != SAI_REPLAY_OP_GET)
+        {
+            sai_replay_translate_attrs(batch->object_type, record->header.attr_count, record->attr_list);
+        }
+
+        batch->attr_counts[idx] = record->header.attr_count;
+        batch->attr_lists[idx] = record->attr_list;
+        batch->get_attr_lists[idx] = record->attr_list;
+
+        if (batch->op == SAI_REPLAY_OP_SET)
+        {
+            batch->set_attrs[idx] = record->attr_list[0];
+        }
+
+        batch->statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+    }
+
+    switch (batch->op)
+    {
+        case SAI_REPLAY_OP_CREATE:
+            return sai_metadata_generic_bulk_create(&sai_replay_apis, sai_replay_translate_oid(batch->switch_id),
+                    batch->count, batch->meta_keys, batch->attr_counts, batch->attr_lists,
+                    sai_replay_bulk_mode, batch->statuses);
+
+        case SAI_REPLAY_OP_REMOVE:
+            return sai_metadata_generic_bulk_remove(&sai_replay_apis, batch->count, batch->meta_keys,
+                    sai_replay_bulk_mode, batch->statuses);
+
+        case SAI_REPLAY_OP_SET:
+            return sai_metadata_generic_bulk_set(&sai_replay_apis, batch->count, batch->meta_keys,
+                    batch->set_attrs, sai_replay_bulk_mode, batch->statuses);
+
+        case SAI_REPLAY_OP_GET:
+            return sai_metadata_genecic_bulk_get(&sai_replay_apis, batch->count, batch->meta_keys,
+                    batch->attr_counts, batch->get_attr_lists, sai_replay_bulk_mode, batch->statuses);
+
+        default:
+            return SAI_STATUS_NOT_SUPPORTED;
+    }
+}
+
+static void sai_replay_batch_flush()
+{
+    sai_replay_batch_t *batch = &sai_replay_batch;
+    size_t ot = sai_metadata_object_type_index(batch->object_type);
+    sai_object_id_t **oids = NULL;
+    size_t *oid_counts = NULL;
+    sai_status_t status;
+    uint64_t start;
+    uint64_t end;
+    uint32_t idx;
+
+    if (batch->count == 0)
+    {
+        return;
+    }
+
+    if (batch->count == 1 || sai_replay_bulk_unsupported[batch->op][ot])
+    {
+        for (idx = 0; idx < batch->count; idx++)
+        {
+            sai_replay_single(&batch->records[idx], 0);
+        }
+
+        sai_replay_batch_release(batch);
+        return;
+    }
+
+    if (batch->op == SAI_REPLAY_OP_GET)
+    {
+        oids = (sai_object_id_t**)calloc(batch->count, sizeof(sai_object_id_t*));
+        oid_counts = (size_t*)calloc(batch->count, sizeof(size_t));
+
+        for (idx = 0; oids != NULL && oid_counts != NULL && idx < batch->count; idx++)
+        {
+            oids[idx] = sai_replay_before_get(&batch->records[idx], &oid_counts[idx]);
+        }
+    }
+
+    start = sai_metadata_now();
+
+    status = sai_replay_batch_call(batch);
+
+    end = sai_metadata_now();
+
+    for (idx = 0; oids != NULL && idx < batch->count; idx++)
+    {
+        if (status == SAI_STATUS_NOT_SUPPORTED || status == SAI_STATUS_NOT_IMPLEMENTED)
+        {
+            free(oids[idx]);
+            oids[idx] = NULL;
+        }
+    }
+
+    if (status == SAI_STATUS_NOT_SUPPORTED || status == SAI_STATUS_NOT_IMPLEMENTED)
+    {
+        fprintf(stderr, "bulk %s %s not supported, replaying as single calls\n",
+                sai_replay_op_names[batch->op], sai_replay_object_type_name(batch->object_type));
+
+        sai_replay_bulk_unsupported[batch->op][ot] = 1;
+
+        free(oids);
+        free(oid_counts);
+
+        /* attributes were translated in place already */
+
+        for (idx = 0; idx < batch->count; idx++)
+        {
+            sai_replay_single(&batch->records[idx], batch->op != SAI_REPLAY_OP_GET);
+        }
+
+        sai_replay_batch_release(batch);
+        return;
+    }
+
+    sai_replay_account(batch->op, batch->object_type, batch->count, end - start, 1);
+
+    for (idx = 0; idx < batch->count; idx++)
+    {
+        sai_recorder_record_t *record = &batch->records[idx];
+
+        sai_replay_check_status(batch->op, record, batch->statuses[idx]);
+
+        switch (batch->op)
+        {
+            case SAI_REPLAY_OP_CREATE:
+                sai_replay_after_create(record, &batch->meta_keys[idx], batch->statuses[idx]);
+                break;
+
+            case SAI_REPLAY_OP_REMOVE:
+                sai_replay_after_remove(record, batch->statuses[idx]);
+                break;
+
+            case SAI_REPLAY_OP_GET:
+                sai_replay_after_get(record, batch->statuses[idx], (oids != NULL) ? oids[idx] : NULL, (oid_counts != NULL) ? oid_counts[idx] : 0);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    free(oids);
+    free(oid_counts);
+
+    sai_replay_batch_release(batch);
+}
+
+/*
+ * Create can not share bulk with earlier create of the same type it refers
+ * to, like scheduler group and its parent, since referred object id is not
+ * known before bulk returns.
+ */
+
+static int sai_replay_batch_depends(
+        _In_ const sai_replay_batch_t *batch,
+        _In_ const sai_recorder_record_t *record)
+{
+    sai_object_id_t oids[64];
+    size_t count;
+    size_t n;
+    uint32_t idx;
+
+    if (batch->op != SAI_REPLAY_OP_CREATE)
+    {
+        return 0;
+    }
+
+    count = sai_replay_collect_oids(record->header.meta_key.objecttype, record->header.attr_count, record->attr_list, oids, 64);
+
+    if (count > 64)
+    {
+        return 1;
+    }
+
+    for (n = 0; n < count; n++)
+    {
+        for (idx = 0; idx < batch->count; idx++)
+        {
+            if (oids[n] != SAI_NULL_OBJECT_ID && oids[n] == batch->records[idx].header.meta_key.objectkey.key.object_id)
+            {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void sai_replay_record(
+        _In_ const sai_recorder_record_t *record)
+{
+    sai_replay_batch_t *batch = &sai_replay_batch;
+    sai_recorder_record_t copy;
+    int op = sai_replay_get_op(record->header.api);
+
+    sai_replay_records++;
+
+    sai_replay_lost += record->header.lost;
+
+    if (op < 0 || sai_metadata_get_object_type_info(record->header.meta_key.objecttype) == NULL ||
+            (op == SAI_REPLAY_OP_SET && record->header.attr_count != 1))
+    {
+        sai_replay_skipped++;
+        return;
+    }
+
+    /* replay modifies attributes, reader buffer is reused by next record */
+
+    if (sai_recorder_record_copy(record, &copy) != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "failed to copy record %" PRIu64 "\n", record->header.sequence);
+        exit(EXIT_FAILURE);
+    }
+
+    if (sai_replay_bulk_size == 0)
+    {
+        sai_replay_single(&copy, 0);
+
+        sai_recorder_record_free(&copy);
+        return;
+    }
+
+    if (batch->count != 0 && (batch->op != op ||
+                batch->object_type != copy.header.meta_key.objecttype ||
+                (op == SAI_REPLAY_OP_CREATE && batch->switch_id != copy.header.switch_id) ||
+                batch->count == sai_replay_bulk_size ||
+                sai_replay_batch_depends(batch, &copy)))
+    {
+        sai_replay_batch_flush();
+    }
+
+    batch->op = op;
+    batch->object_type = copy.header.meta_key.objecttype;
+    batch->switch_id = copy.header.switch_id;
+    batch->records[batch->count++] = copy;
+}
+
+/* input */
+
+static int sai_replay_input_open(
+        _Out_ sai_replay_input_t *input,
+        _In_ const char *path)
+{
+    gzFile file;
+
+    memset(input, 0, sizeof(sai_replay_input_t));
+
+    file = gzopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    /* json stream is one serialized call per line, compressed or not */
+
+    if (gzgetc(file) == '{')
+    {
+        gzrewind(file);
+
+        input->json = file;
+        return 0;
+    }
+
+    gzclose(file);
+
+    input->reader = sai_recorder_reader_open(path);
+
+    return (input->reader != NULL) ? 0 : -1;
+}
+
+static void sai_replay_input_close(
+        _Inout_ sai_replay_input_t *input)
+{
+    if (input->reader != NULL)
+    {
+        sai_recorder_reader_close(input->reader);
+    }
+
+    if (input->json != NULL)
+    {
+        gzclose(input->json);
+    }
+
+    free(input->line);
+    free(input->attrs);
+}
+
+static char* sai_replay_read_line(
+        _Inout_ sai_replay_input_t *input)
+{
+    size_t len = 0;
+
+    while (1)
+    {
+        if (len + 1 >= input->capacity)
+        {
+            size_t capacity = (input->capacity == 0) ? 4096 : 2 * input->capacity;
+            char *line = (char*)realloc(input->line, capacity);
+
+            if (line == NULL)
+            {
+                return NULL;
+            }
+
+            input->line = line;
+            input->capacity = capacity;
+        }
+
+        if (gzgets(input->json, input->line + len, (int)(input->capacity - len)) == NULL)
+        {
+            return (len != 0) ? input->line : NULL;
+        }
+
+        len += strlen(input->line + len);
+
+        if (len != 0 && input->line[len - 1] == '\n')
+        {
+            input->line[len - 1] = 0;
+            return input->line;
+        }
+
+        if (len + 1 < input->capacity)
+        {
+            /* last line without new line */
+
+            return input->line;
+        }
+    }
+}
+
+static void sai_replay_free_json_attrs(
+        _Inout_ sai_replay_input_t *input,
+        _In_ sai_object_type_t object_type)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < input->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, input->attrs[idx].id);
+
+        if (md != NULL)
+        {
+            sai_free_attribute(md, &input->attrs[idx]);
+        }
+    }
+
+    input->attr_count = 0;
+}
+
+#define SAI_REPLAY_EXPECT(x) { \
+    if (strncmp(buf, x, sizeof(x) - 1) != 0) { return -1; } \
+    buf += sizeof(x) - 1; }
+
+#define SAI_REPLAY_EXPECT_CHECK(expr) { \
+    ret = (expr); \
+    if (ret < 0) { return -1; } \
+    buf += ret; }
+
+/*
+ * Parses line written by sai_replay_write_json, attributes are deserialized
+ * into input attribute array and released by sai_replay_free_json_attrs.
+ */
+
+static int sai_replay_parse_json(
+        _Inout_ sai_replay_input_t *input,
+        _In_ const char *line,
+        _Out_ sai_recorder_record_t *record)
+{
+    sai_recorder_record_header_t *header = &record->header;
+    const char *buf = line;
+    int32_t value;
+    int ret;
+
+    memset(header, 0, sizeof(sai_recorder_record_header_t));
+
+    header->flags = SAI_RECORDER_FLAG_LISTS;
+
+    record->attr_list = NULL;
+
+    SAI_REPLAY_EXPECT("{\"sequence\":");
+    SAI_REPLAY_EXPECT_CHECK(sai_deserialize_uint64(buf, &header->sequence));
+    SAI_REPLAY_EXPECT(",\"api\":\"");
+    SAI_REPLAY_EXPECT_CHECK(sai_deserialize_enum(buf, &sai_metadata_enum_sai_common_api_t, &value));
+    header->api = value;
+    SAI_REPLAY_EXPECT("\",\"status\":\"");
+    SAI_REPLAY_EXPECT_CHECK(sai_deserialize_enum(buf, &sai_metadata_enum_sai_status_t, &value));
+    header->status = value;
+    SAI_REPLAY_EXPECT("\",\"switch_id\":\"");
+    SAI_REPLAY_EXPECT_CHECK(sai_deserialize_object_id(buf, &header->switch_id));
+    SAI_REPLAY_EXPECT("\",\"meta_key\":");
+    SAI_REPLAY_EXPECT_CHECK(sai_deserialize_object_meta_key(buf, &header->meta_key));
+    SAI_REPLAY_EXPECT(",\"attr_list\":[");
+
+    while (*buf != ']')
+    {
+        if (input->attr_count != 0)
+        {
+            SAI_REPLAY_EXPECT(",");
+        }
+
+        if (input->attr_count == input->attrs_capacity)
+        {
+            uint32_t capacity = (input->attrs_capacity == 0) ? 16 : 2 * input->attrs_capacity;
+            sai_attribute_t *attrs = (sai_attribute_t*)realloc(input->attrs, capacity * sizeof(sai_attribute_t));
+
+            if (attrs == NULL)
+            {
+                return -1;
+            }
+
+            input->attrs = attrs;
+            input->attrs_capacity = capacity;
+        }
+
+        SAI_REPLAY_EXPECT_CHECK(sai_deserialize_attribute(buf, &input->attrs[input->attr_count]));
+
+        input->attr_count++;
+    }
+
+    SAI_REPLAY_EXPECT("]}");
+
+    header->attr_count = input->attr_count;
+
+    record->attr_list = (input->attr_count != 0) ? input->attrs : NULL;
+
+    return 0;
+}
+
+#undef SAI_REPLAY_EXPECT
+#undef SAI_REPLAY_EXPECT_CHECK
+
+static sai_status_t sai_replay_input_next(
+        _Inout_ sai_replay_input_t *input,
+        _Out_ sai_recorder_record_t *record)
+{
+    const char *line;
+
+    if (input->reader != NULL)
+    {
+        return sai_recorder_reader_next(input->reader, record);
+    }
+
+    if (input->attr_count != 0)
+    {
+        sai_replay_free_json_attrs(input, input->object_type);
+    }
+
+    do
+    {
+        line = sai_replay_read_line(input);
+
+        if (line == NULL)
+        {
+            return SAI_STATUS_ITEM_NOT_FOUND;
+        }
+
+        input->line_number++;
+    }
+    while (*line == 0);
+
+    if (sai_replay_parse_json(input, line, record) < 0)
+    {
+        fprintf(stderr, "line %" PRIu64 ": failed to parse '%.60s'\n", input->line_number, line);
+
+        sai_replay_free_json_attrs(input, record->header.meta_key.objecttype);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    input->object_type = record->header.meta_key.objecttype;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static int sai_replay_write_json(
+        _Inout_ FILE *file,
+        _In_ const sai_recorder_record_t *record,
+        _Out_ char *buffer)
+{
+    const sai_recorder_record_header_t *header = &record->header;
+    char *buf = buffer;
+    uint32_t idx;
+    int ret;
+
+    buf += sprintf(buf, "{\"sequence\":%" PRIu64 ",\"api\":\"", header->sequence);
+    buf += sai_serialize_enum(buf, &sai_metadata_enum_sai_common_api_t, header->api);
+    buf += sprintf(buf, "\",\"status\":\"");
+    buf += sai_serialize_enum(buf, &sai_metadata_enum_sai_status_t, header->status);
+    buf += sprintf(buf, "\",\"switch_id\":\"");
+    buf += sai_serialize_object_id(buf, header->switch_id);
+    buf += sprintf(buf, "\",\"meta_key\":");
+
+    ret = sai_serialize_object_meta_key(buf, &header->meta_key);
+
+    if (ret < 0)
+    {
+        return -1;
+    }
+
+    buf += ret;
+    buf += sprintf(buf, ",\"attr_list\":[");
+
+    for (idx = 0; record->attr_list != NULL && idx < header->attr_count; idx++)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(header->meta_key.objecttype, record->attr_list[idx].id);
+
+        if (md == NULL)
+        {
+            return -1;
+        }
+
+        buf += sprintf(buf, (idx == 0) ? "" : ",");
+
+        ret = sai_serialize_attribute(buf, md, &record->attr_list[idx]);
+
+        if (ret < 0)
+        {
+            return -1;
+        }
+
+        buf += ret;
+    }
+
+    buf += sprintf(buf, "]}\n");
+
+    fputs(buffer, file);
+
+    return 0;
+}
+
+/* profile services */
+
+static const char* sai_replay_profile_get_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    size_t idx;
+
+    if (variable == NULL)
+    {
+        return NULL;
+    }
+
+    for (idx = 0; idx < sai_replay_profile_count; idx++)
+    {
+        if (strcmp(sai_replay_profile_keys[idx], variable) == 0)
+        {
+            return sai_replay_profile_values[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static int sai_replay_profile_get_next_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _Out_ const char **variable,
+        _Out_ const char **value)
+{
+    if (value == NULL)
+    {
+        sai_replay_profile_iterator = 0;
+        return 0;
+    }
+
+    if (variable == NULL || sai_replay_profile_iterator >= sai_replay_profile_count)
+    {
+        return -1;
+    }
+
+    *variable = sai_replay_profile_keys[sai_replay_profile_iterator];
+    *value = sai_replay_profile_values[sai_replay_profile_iterator];
+
+    sai_replay_profile_iterator++;
+
+    return 0;
+}
+
+static void sai_replay_load_profile(
+        _In_ const char *path)
+{
+    char line[1024];
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "failed to open profile %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL && sai_replay_profile_count < SAI_REPLAY_MAX_PROFILE_VALUES)
+    {
+        char *eq = strchr(line, '=');
+
+        line[strcspn(line, "\r\n")] = 0;
+
+        if (line[0] == '#' || eq == NULL)
+        {
+            continue;
+        }
+
+        *eq = 0;
+
+        sai_replay_profile_keys[sai_replay_profile_count] = strdup(line);
+        sai_replay_profile_values[sai_replay_profile_count] = strdup(eq + 1);
+
+        sai_replay_profile_count++;
+    }
+
+    fclose(file);
+}
+
+static void sai_replay_usage()
+{
+    fprintf(stderr,
+            "usage: saireplay [-b bulk_size] [-s] [-p profile] [-v] file\n"
+            "       saireplay -j output.json file\n"
+            "\n"
+            "Replays recorded SAI calls, binary recorder file or json lines, against libsai.\n"
+            "\n"
+            "  -b bulk_size  coalesce consecutive operations of the same type into bulk calls\n"
+            "  -s            bulk error mode stop on error, default ignore error\n"
+            "  -p profile    key=value file served by profile_get_value\n"
+            "  -v            print every status divergence\n"
+            "  -j output     convert input to json lines and exit\n");
+
+    exit(EXIT_FAILURE);
+}
+
+int main(
+        _In_ int argc,
+        _In_ char **argv)
+{
+    sai_service_method_table_t services;
+    sai_replay_input_t input;
+    sai_recorder_record_t record;
+    const char *json_path = NULL;
+    sai_status_t status;
+    uint64_t start;
+    uint64_t end;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:sp:vj:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                sai_replay_bulk_size = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+
+            case 's':
+                sai_replay_bulk_mode = SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR;
+                break;
+
+            case 'p':
+                sai_replay_load_profile(optarg);
+                break;
+
+            case 'v':
+                sai_replay_verbose = 1;
+                break;
+
+            case 'j':
+                json_path = optarg;
+                break;
+
+            default:
+                sai_replay_usage();
+                break;
+        }
+    }
+
+    if (optind + 1 != argc)
+    {
+        sai_replay_usage();
+    }
+
+    if (sai_replay_input_open(&input, argv[optind]) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (json_path != NULL)
+    {
+        char *buffer = (char*)malloc(SAI_REPLAY_JSON_BUFFER_SIZE);
+        FILE *file = fopen(json_path, "w");
+
+        if (buffer == NULL || file == NULL)
+        {
+            fprintf(stderr, "failed to open %s: %s\n", json_path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        while ((status = sai_replay_input_next(&input, &record)) == SAI_STATUS_SUCCESS)
+        {
+            if (sai_replay_write_json(file, &record, buffer) < 0)
+            {
+                fprintf(stderr, "failed to serialize record %" PRIu64 "\n", record.header.sequence);
+            }
+        }
+
+        fclose(file);
+        free(buffer);
+
+        sai_replay_input_close(&input);
+
+        return (status == SAI_STATUS_ITEM_NOT_FOUND) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    services.profile_get_value = sai_replay_profile_get_value;
+    services.profile_get_next_value = sai_replay_profile_get_next_value;
+
+    status = sai_api_initialize(0, &services);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "sai_api_initialize failed: %s\n", sai_replay_status_name(status));
+        return EXIT_FAILURE;
+    }
+
+    sai_metadata_apis_query(sai_api_query, &sai_replay_apis);
+
+    if (sai_replay_bulk_size != 0)
+    {
+        sai_replay_batch_init(sai_replay_bulk_size);
+    }
+
+    start = sai_metadata_now();
+
+    while ((status = sai_replay_input_next(&input, &record)) == SAI_STATUS_SUCCESS)
+    {
+        sai_replay_record(&record);
+    }
+
+    sai_replay_batch_flush();
+
+    end = sai_metadata_now();
+
+    sai_replay_input_close(&input);
+
+    sai_api_uninitialize();
+
+    sai_replay_report(stdout, end - start);
+
+    if (status != SAI_STATUS_ITEM_NOT_FOUND)
+    {
+        fprintf(stderr, "input ended with error, replay is incomplete\n");
+        return EXIT_FAILURE;
+    }
+
+    return (sai_replay_divergences == 0) ? EXIT_SUCCESS : 2;
+}
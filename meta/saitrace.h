@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saitrace.h
+ *
+ * @brief   This module defines SAI tracing interposer library
+ */
+
+#ifndef __SAITRACE_H_
+#define __SAITRACE_H_
+
+/**
+ * @defgroup SAITRACE SAI - Tracing interposer library
+ *
+ * Library libsaitrace.so exports the same global functions as vendor
+ * libsai.so. Vendor library is loaded with dlopen and each method table
+ * returned by sai_api_query() is replaced by table of generated thunks,
+ * which measure every call and forward it to vendor function.
+ *
+ * @{
+ */
+
+/**
+ * @brief Environment variable with path to vendor SAI library
+ */
+#define SAI_TRACE_ENV_LIBSAI            "SAI_TRACE_LIBSAI"
+
+/**
+ * @brief Environment variable with statistics dump file path
+ */
+#define SAI_TRACE_ENV_DUMP_FILE         "SAI_TRACE_DUMP_FILE"
+
+/**
+ * @brief Environment variable with signal number triggering dump, unset disables
+ */
+#define SAI_TRACE_ENV_DUMP_SIGNAL       "SAI_TRACE_DUMP_SIGNAL"
+
+/**
+ * @brief Environment variable with binary call record file, recording is
+ * disabled when not set
+ */
+#define SAI_TRACE_ENV_RECORD_FILE       "SAI_TRACE_RECORD_FILE"
+
+/**
+ * @brief Environment variable with record file size triggering rotation
+ */
+#define SAI_TRACE_ENV_RECORD_FILE_SIZE  "SAI_TRACE_RECORD_FILE_SIZE"
+
+/**
+ * @brief Environment variable with number of rotated record files to keep
+ */
+#define SAI_TRACE_ENV_RECORD_FILES      "SAI_TRACE_RECORD_FILES"
+
+/**
+ * @brief Environment variable with per thread record ring buffer size
+ */
+#define SAI_TRACE_ENV_RECORD_RING_SIZE  "SAI_TRACE_RECORD_RING_SIZE"
+
+/**
+ * @brief Environment variable with record file gzip compression level
+ */
+#define SAI_TRACE_ENV_RECORD_COMPRESSION "SAI_TRACE_RECORD_COMPRESSION"
+
+/**
+ * @brief Default vendor SAI library
+ */
+#define SAI_TRACE_DEFAULT_LIBSAI        "libsaivendor.so"
+
+/**
+ * @brief Default statistics dump file
+ */
+#define SAI_TRACE_DEFAULT_DUMP_FILE     "/tmp/saitrace.txt"
+
+/**
+ * @brief Traced method description
+ */
+typedef struct _sai_trace_method_t
+{
+    /**
+     * @brief API of method table, SAI_API_UNSPECIFIED for global functions
+     */
+    sai_api_t api;
+
+    /**
+     * @brief Method table member or global function name
+     */
+    const char *name;
+
+} sai_trace_method_t;
+
+/**
+ * @brief All traced methods, indexed by method index, NULL name terminated
+ */
+extern const sai_trace_method_t sai_trace_methods[];
+
+/**
+ * @brief Number of traced methods
+ */
+extern const size_t sai_trace_methods_count;
+
+/**
+ * @brief Global functions of vendor library
+ */
+extern sai_global_apis_t sai_trace_vendor_global_apis;
+
+/**
+ * @brief Non zero when calls are recorded by sai_recorder_record()
+ */
+extern int sai_trace_recording;
+
+/**
+ * @brief Replace vendor method table by tracing method table
+ *
+ * @param[in] api SAI API
+ * @param[in] vendor_method_table Method table returned by vendor library
+ * @param[out] api_method_table Tracing method table
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_NOT_SUPPORTED if API
+ * is unknown
+ */
+extern sai_status_t sai_trace_wrap_api(
+        _In_ sai_api_t api,
+        _In_ const void *vendor_method_table,
+        _Out_ void **api_method_table);
+
+/**
+ * @brief Start measuring single call
+ *
+ * @return Monotonic time stamp in nanoseconds
+ */
+extern uint64_t sai_trace_begin(void);
+
+/**
+ * @brief Record single call
+ *
+ * Counters are kept per thread, this function takes no lock.
+ *
+ * @param[in] method Method index
+ * @param[in] object_type Object type of the call or SAI_OBJECT_TYPE_NULL
+ * @param[in] object_count Number of objects for bulk call, 0 otherwise
+ * @param[in] start Time stamp returned by sai_trace_begin()
+ * @param[in] status Status returned by vendor function
+ */
+extern void sai_trace_end(
+        _In_ size_t method,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ uint64_t start,
+        _In_ sai_status_t status);
+
+/**
+ * @brief Write statistics of all threads
+ *
+ * @param[inout] file Output stream
+ */
+extern void sai_trace_dump(
+        _Inout_ FILE *file);
+
+/**
+ * @brief Write statistics of all threads to file
+ *
+ * @param[in] path File path
+ *
+ * @return #SAI_STATUS_SUCCESS on success, #SAI_STATUS_FAILURE otherwise
+ */
+extern sai_status_t sai_trace_dump_file(
+        _In_ const char *path);
+
+/**
+ * @}
+ */
+#endif /** __SAITRACE_H_ */
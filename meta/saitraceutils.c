@@ -0,0 +1,793 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saitraceutils.c
+ *
+ * @brief   This module implements SAI tracing interposer library runtime
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "saimetadata.h"
+#include "saitrace.h"
+#include "sairecorder.h"
+
+/*
+ * Latency histogram uses log-linear buckets: values below
+ * SAI_TRACE_SUB_BUCKETS nanoseconds have their own bucket, each following
+ * power of two range is split into SAI_TRACE_SUB_BUCKETS equal buckets (about
+ * 25% relative precision), values above 2^36 ns (about a minute) share the
+ * last bucket.
+ */
+
+#define SAI_TRACE_SUB_BUCKET_BITS 2
+#define SAI_TRACE_SUB_BUCKETS (1 << SAI_TRACE_SUB_BUCKET_BITS)
+#define SAI_TRACE_MAX_EXPONENT 36
+#define SAI_TRACE_BUCKETS \
+    (SAI_TRACE_SUB_BUCKETS * (SAI_TRACE_MAX_EXPONENT - SAI_TRACE_SUB_BUCKET_BITS + 2))
+
+/*
+ * Bulk size histogram, bucket N holds sizes in range [2^(N-1), 2^N).
+ */
+
+#define SAI_TRACE_BULK_BUCKETS 33
+
+/*
+ * Counters are updated only by owning thread, so relaxed load and store are
+ * used instead of read-modify-write atomics. Dump from other thread may see
+ * slightly stale values, but never torn ones.
+ */
+
+#define SAI_TRACE_ADD(var, value) \
+    __atomic_store_n(&(var), __atomic_load_n(&(var), __ATOMIC_RELAXED) + (value), __ATOMIC_RELAXED)
+
+#define SAI_TRACE_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+typedef struct _sai_trace_counters_t
+{
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    uint64_t latency[SAI_TRACE_BUCKETS];
+    uint64_t bulk_calls;
+    uint64_t bulk_objects;
+    uint64_t bulk_max;
+    uint64_t bulk_sizes[SAI_TRACE_BULK_BUCKETS];
+
+} sai_trace_counters_t;
+
+/*
+ * Per thread counters, allocated on first call made by thread and never
+ * freed, so dump can walk them without synchronization with thread exit.
+ * Counters of single method or object type are allocated on first use.
+ */
+
+typedef struct _sai_trace_thread_t
+{
+    struct _sai_trace_thread_t *next;
+
+    sai_trace_counters_t **methods;
+
+    sai_trace_counters_t **objecttypes;
+
+} sai_trace_thread_t;
+
+static sai_trace_thread_t *sai_trace_threads = NULL;
+
+static __thread sai_trace_thread_t *sai_trace_current_thread = NULL;
+
+sai_global_apis_t sai_trace_vendor_global_apis;
+
+int sai_trace_recording = 0;
+
+static void *sai_trace_vendor_handle = NULL;
+
+static pthread_once_t sai_trace_load_once = PTHREAD_ONCE_INIT;
+
+static sai_status_t sai_trace_load_status = SAI_STATUS_UNINITIALIZED;
+
+static const char *sai_trace_dump_path = SAI_TRACE_DEFAULT_DUMP_FILE;
+
+static int sai_trace_signal_pipe[2] = { -1, -1 };
+
+static size_t sai_trace_bucket_index(
+        _In_ uint64_t value)
+{
+    int exp;
+    size_t sub;
+
+    if (value < SAI_TRACE_SUB_BUCKETS)
+    {
+        return (size_t)value;
+    }
+
+    exp = 63 - __builtin_clzll(value);
+
+    if (exp > SAI_TRACE_MAX_EXPONENT)
+    {
+        return SAI_TRACE_BUCKETS - 1;
+    }
+
+    sub = (size_t)(value >> (exp - SAI_TRACE_SUB_BUCKET_BITS)) & (SAI_TRACE_SUB_BUCKETS - 1);
+
+    return SAI_TRACE_SUB_BUCKETS * (size_t)(exp - SAI_TRACE_SUB_BUCKET_BITS + 1) + sub;
+}
+
+static uint64_t sai_trace_bucket_value(
+        _In_ size_t bucket)
+{
+    int exp;
+    uint64_t sub;
+
+    if (bucket < SAI_TRACE_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    exp = (int)(bucket / SAI_TRACE_SUB_BUCKETS) + SAI_TRACE_SUB_BUCKET_BITS - 1;
+
+    sub = bucket % SAI_TRACE_SUB_BUCKETS;
+
+    return (SAI_TRACE_SUB_BUCKETS + sub) << (exp - SAI_TRACE_SUB_BUCKET_BITS);
+}
+
+static size_t sai_trace_bulk_bucket(
+        _In_ uint32_t object_count)
+{
+    return (object_count == 0) ? 0 : (size_t)(32 - __builtin_clz(object_count));
+}
+
+static sai_trace_thread_t* sai_trace_get_thread(void)
+{
+    sai_trace_thread_t *thread = sai_trace_current_thread;
+
+    if (thread != NULL)
+    {
+        return thread;
+    }
+
+    thread = (sai_trace_thread_t*)calloc(1, sizeof(sai_trace_thread_t));
+
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+
+    thread->methods = (sai_trace_counters_t**)calloc(sai_trace_methods_count, sizeof(sai_trace_counters_t*));
+    thread->objecttypes = (sai_trace_counters_t**)calloc(SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, sizeof(sai_trace_counters_t*));
+
+    if (thread->methods == NULL || thread->objecttypes == NULL)
+    {
+        free(thread->methods);
+        free(thread->objecttypes);
+        free(thread);
+
+        return NULL;
+    }
+
+    /* lock free push, threads are never removed from the list */
+
+    thread->next = __atomic_load_n(&sai_trace_threads, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&sai_trace_threads, &thread->next, thread, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+
+    sai_trace_current_thread = thread;
+
+    return thread;
+}
+
+static sai_trace_counters_t* sai_trace_get_counters(
+        _Inout_ sai_trace_counters_t **slot)
+{
+    sai_trace_counters_t *counters = *slot;
+
+    if (counters == NULL)
+    {
+        counters = (sai_trace_counters_t*)calloc(1, sizeof(sai_trace_counters_t));
+
+        if (counters != NULL)
+        {
+            __atomic_store_n(slot, counters, __ATOMIC_RELEASE);
+        }
+    }
+
+    return counters;
+}
+
+static void sai_trace_record(
+        _Inout_ sai_trace_counters_t *counters,
+        _In_ uint64_t latency,
+        _In_ uint32_t object_count,
+        _In_ sai_status_t status)
+{
+    SAI_TRACE_ADD(counters->calls, 1);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        SAI_TRACE_ADD(counters->errors, 1);
+    }
+
+    SAI_TRACE_ADD(counters->latency[sai_trace_bucket_index(latency)], 1);
+    SAI_TRACE_ADD(counters->latency_sum, latency);
+
+    if (latency > counters->latency_max)
+    {
+        __atomic_store_n(&counters->latency_max, latency, __ATOMIC_RELAXED);
+    }
+
+    if (object_count == 0)
+    {
+        return;
+    }
+
+    SAI_TRACE_ADD(counters->bulk_calls, 1);
+    SAI_TRACE_ADD(counters->bulk_objects, object_count);
+    SAI_TRACE_ADD(counters->bulk_sizes[sai_trace_bulk_bucket(object_count)], 1);
+
+    if (object_count > counters->bulk_max)
+    {
+        __atomic_store_n(&counters->bulk_max, (uint64_t)object_count, __ATOMIC_RELAXED);
+    }
+}
+
+uint64_t sai_trace_begin(void)
+{
+    return sai_metadata_now();
+}
+
+void sai_trace_end(
+        _In_ size_t method,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ uint64_t start,
+        _In_ sai_status_t status)
+{
+    uint64_t latency = sai_trace_begin() - start;
+
+    sai_trace_thread_t *thread = sai_trace_get_thread();
+
+    sai_trace_counters_t *counters;
+
+    if (thread == NULL || method >= sai_trace_methods_count)
+    {
+        return;
+    }
+
+    counters = sai_trace_get_counters(&thread->methods[method]);
+
+    if (counters != NULL)
+    {
+        sai_trace_record(counters, latency, object_count, status);
+    }
+
+    counters = sai_trace_get_counters(&thread->objecttypes[sai_metadata_object_type_index(object_type)]);
+
+    if (counters != NULL)
+    {
+        sai_trace_record(counters, latency, object_count, status);
+    }
+}
+
+static void sai_trace_merge(
+        _Inout_ sai_trace_counters_t *dst,
+        _In_ sai_trace_counters_t *src)
+{
+    size_t i;
+    uint64_t max;
+
+    dst->calls += SAI_TRACE_LOAD(src->calls);
+    dst->errors += SAI_TRACE_LOAD(src->errors);
+    dst->latency_sum += SAI_TRACE_LOAD(src->latency_sum);
+    dst->bulk_calls += SAI_TRACE_LOAD(src->bulk_calls);
+    dst->bulk_objects += SAI_TRACE_LOAD(src->bulk_objects);
+
+    for (i = 0; i < SAI_TRACE_BUCKETS; i++)
+    {
+        dst->latency[i] += SAI_TRACE_LOAD(src->latency[i]);
+    }
+
+    for (i = 0; i < SAI_TRACE_BULK_BUCKETS; i++)
+    {
+        dst->bulk_sizes[i] += SAI_TRACE_LOAD(src->bulk_sizes[i]);
+    }
+
+    max = SAI_TRACE_LOAD(src->latency_max);
+    dst->latency_max = (max > dst->latency_max) ? max : dst->latency_max;
+
+    max = SAI_TRACE_LOAD(src->bulk_max);
+    dst->bulk_max = (max > dst->bulk_max) ? max : dst->bulk_max;
+}
+
+static uint64_t sai_trace_percentile(
+        _In_ const sai_trace_counters_t *counters,
+        _In_ uint64_t permille)
+{
+    uint64_t rank = counters->calls * permille / 1000;
+    uint64_t seen = 0;
+    size_t i;
+
+    for (i = 0; i < SAI_TRACE_BUCKETS; i++)
+    {
+        seen += counters->latency[i];
+
+        if (seen > rank)
+        {
+            return sai_trace_bucket_value(i);
+        }
+    }
+
+    return counters->latency_max;
+}
+
+static void sai_trace_print_header(
+        _Inout_ FILE *file,
+        _In_ const char *title)
+{
+    fprintf(file, "\n%-48s %12s %10s %10s %10s %10s %12s %10s %12s %8s\n",
+            title, "calls", "errors", "avg_ns", "p50_ns", "p99_ns", "max_ns",
+            "bulk_calls", "bulk_objs", "bulk_max");
+}
+
+static void sai_trace_print(
+        _Inout_ FILE *file,
+        _In_ const char *name,
+        _In_ const sai_trace_counters_t *counters)
+{
+    if (counters->calls == 0)
+    {
+        return;
+    }
+
+    fprintf(file, "%-48s %12"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %10"PRIu64" %12"PRIu64" %10"PRIu64" %12"PRIu64" %8"PRIu64"\n",
+            name,
+            counters->calls,
+            counters->errors,
+            counters->latency_sum / counters->calls,
+            sai_trace_percentile(counters, 500),
+            sai_trace_percentile(counters, 990),
+            counters->latency_max,
+            counters->bulk_calls,
+            counters->bulk_objects,
+            counters->bulk_max);
+}
+
+static void sai_trace_print_bulk_sizes(
+        _Inout_ FILE *file,
+        _In_ const char *name,
+        _In_ const sai_trace_counters_t *counters)
+{
+    size_t i;
+
+    if (counters->bulk_calls == 0)
+    {
+        return;
+    }
+
+    fprintf(file, "%-48s", name);
+
+    for (i = 0; i < SAI_TRACE_BULK_BUCKETS; i++)
+    {
+        if (counters->bulk_sizes[i] == 0)
+        {
+            continue;
+        }
+
+        fprintf(file, " <%"PRIu64":%"PRIu64, (uint64_t)1 << i, counters->bulk_sizes[i]);
+    }
+
+    fprintf(file, "\n");
+}
+
+static const char* sai_trace_api_name(
+        _In_ sai_api_t api)
+{
+    const char *name;
+
+    if (api == SAI_API_UNSPECIFIED)
+    {
+        return "global";
+    }
+
+    name = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_api_t, api);
+
+    return (name != NULL) ? name : "unknown";
+}
+
+void sai_trace_dump(
+        _Inout_ FILE *file)
+{
+    sai_trace_thread_t *head = __atomic_load_n(&sai_trace_threads, __ATOMIC_ACQUIRE);
+    sai_trace_thread_t *thread;
+    sai_trace_counters_t *methods;
+    sai_trace_counters_t *objecttypes;
+    sai_trace_counters_t total;
+    size_t threads = 0;
+    size_t i;
+    char name[256];
+
+    methods = (sai_trace_counters_t*)calloc(sai_trace_methods_count, sizeof(sai_trace_counters_t));
+    objecttypes = (sai_trace_counters_t*)calloc(SAI_METADATA_OBJECT_TYPE_INDEX_COUNT, sizeof(sai_trace_counters_t));
+
+    if (methods == NULL || objecttypes == NULL)
+    {
+        free(methods);
+        free(objecttypes);
+        return;
+    }
+
+    for (thread = head; thread != NULL; thread = thread->next)
+    {
+        threads++;
+
+        for (i = 0; i < sai_trace_methods_count; i++)
+        {
+            sai_trace_counters_t *c = __atomic_load_n(&thread->methods[i], __ATOMIC_ACQUIRE);
+
+            if (c != NULL)
+            {
+                sai_trace_merge(&methods[i], c);
+            }
+        }
+
+        for (i = 0; i < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; i++)
+        {
+            sai_trace_counters_t *c = __atomic_load_n(&thread->objecttypes[i], __ATOMIC_ACQUIRE);
+
+            if (c != NULL)
+            {
+                sai_trace_merge(&objecttypes[i], c);
+            }
+        }
+    }
+
+    fprintf(file, "SAI trace statistics, %zu threads\n", threads);
+
+    sai_trace_print_header(file, "method");
+
+    for (i = 0; i < sai_trace_methods_count; i++)
+    {
+        snprintf(name, sizeof(name), "%s.%s", sai_trace_api_name(sai_trace_methods[i].api), sai_trace_methods[i].name);
+
+        sai_trace_print(file, name, &methods[i]);
+    }
+
+    /* generated methods table keeps methods of single API together */
+
+    sai_trace_print_header(file, "api");
+
+    memset(&total, 0, sizeof(total));
+
+    for (i = 0; i < sai_trace_methods_count; i++)
+    {
+        sai_trace_merge(&total, &methods[i]);
+
+        if (i + 1 == sai_trace_methods_count || sai_trace_methods[i + 1].api != sai_trace_methods[i].api)
+        {
+            sai_trace_print(file, sai_trace_api_name(sai_trace_methods[i].api), &total);
+
+            memset(&total, 0, sizeof(total));
+        }
+    }
+
+    sai_trace_print_header(file, "object type");
+
+    for (i = 0; i < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; i++)
+    {
+        const char *otname = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t, sai_metadata_object_type_from_index(i));
+
+        sai_trace_print(file, (otname != NULL) ? otname : "unknown", &objecttypes[i]);
+    }
+
+    fprintf(file, "\n%-48s <size:calls\n", "bulk sizes");
+
+    for (i = 0; i < SAI_METADATA_OBJECT_TYPE_INDEX_COUNT; i++)
+    {
+        const char *otname = sai_metadata_get_enum_value_name(&sai_metadata_enum_sai_object_type_t, sai_metadata_object_type_from_index(i));
+
+        sai_trace_print_bulk_sizes(file, (otname != NULL) ? otname : "unknown", &objecttypes[i]);
+    }
+
+    free(methods);
+    free(objecttypes);
+}
+
+sai_status_t sai_trace_dump_file(
+        _In_ const char *path)
+{
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", path, strerror(errno));
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    sai_trace_dump(file);
+
+    fclose(file);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void sai_trace_signal_handler(
+        _In_ int signo)
+{
+    int saved = errno;
+    char c = 0;
+
+    /* only async signal safe write here, dump is done by dump thread */
+
+    if (write(sai_trace_signal_pipe[1], &c, 1) < 0)
+    {
+        /* nothing to do, pipe is full and dump is already pending */
+    }
+
+    errno = saved;
+}
+
+static void* sai_trace_dump_thread(
+        _In_ void *arg)
+{
+    char c;
+
+    while (1)
+    {
+        ssize_t n = read(sai_trace_signal_pipe[0], &c, 1);
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            break;
+        }
+
+        sai_trace_dump_file(sai_trace_dump_path);
+    }
+
+    return NULL;
+}
+
+static void sai_trace_start_dump_thread(void)
+{
+    const char *env = getenv(SAI_TRACE_ENV_DUMP_SIGNAL);
+    int signo = (env != NULL) ? atoi(env) : 0;
+    struct sigaction sa;
+    pthread_t thread;
+
+    if (signo <= 0)
+    {
+        return;
+    }
+
+    if (pipe(sai_trace_signal_pipe) != 0)
+    {
+        SAI_META_LOG_ERROR("failed to create signal pipe: %s", strerror(errno));
+        return;
+    }
+
+    if (pthread_create(&thread, NULL, sai_trace_dump_thread, NULL) != 0)
+    {
+        SAI_META_LOG_ERROR("failed to create dump thread");
+        return;
+    }
+
+    pthread_detach(thread);
+
+    memset(&sa, 0, sizeof(sa));
+
+    sa.sa_handler = sai_trace_signal_handler;
+    sa.sa_flags = SA_RESTART;
+
+    sigemptyset(&sa.sa_mask);
+
+    if (sigaction(signo, &sa, NULL) != 0)
+    {
+        SAI_META_LOG_ERROR("failed to install handler for signal %d: %s", signo, strerror(errno));
+    }
+}
+
+static uint64_t sai_trace_getenv_u64(
+        _In_ const char *name,
+        _In_ uint64_t value)
+{
+    const char *env = getenv(name);
+
+    return (env != NULL) ? strtoull(env, NULL, 0) : value;
+}
+
+static void sai_trace_start_recorder(void)
+{
+    sai_recorder_config_t config;
+
+    config.path = getenv(SAI_TRACE_ENV_RECORD_FILE);
+
+    if (config.path == NULL)
+    {
+        return;
+    }
+
+    config.max_file_size = sai_trace_getenv_u64(SAI_TRACE_ENV_RECORD_FILE_SIZE, 0);
+    config.max_files = (uint32_t)sai_trace_getenv_u64(SAI_TRACE_ENV_RECORD_FILES, 0);
+    config.ring_size = (uint32_t)sai_trace_getenv_u64(SAI_TRACE_ENV_RECORD_RING_SIZE, SAI_RECORDER_DEFAULT_RING_SIZE);
+    config.compression = (uint32_t)sai_trace_getenv_u64(SAI_TRACE_ENV_RECORD_COMPRESSION, 0);
+
+    if (sai_recorder_start(&config) != SAI_STATUS_SUCCESS)
+    {
+        SAI_META_LOG_ERROR("failed to start recorder, calls will not be recorded");
+        return;
+    }
+
+    __atomic_store_n(&sai_trace_recording, 1, __ATOMIC_RELAXED);
+}
+
+static void sai_trace_load(void)
+{
+    const char *env = getenv(SAI_TRACE_ENV_LIBSAI);
+    const char *path = (env != NULL) ? env : SAI_TRACE_DEFAULT_LIBSAI;
+
+    env = getenv(SAI_TRACE_ENV_DUMP_FILE);
+
+    if (env != NULL)
+    {
+        sai_trace_dump_path = env;
+    }
+
+    memset(&sai_trace_vendor_global_apis, 0, sizeof(sai_trace_vendor_global_apis));
+
+    /*
+     * RTLD_LOCAL keeps vendor symbols out of global scope, so application
+     * calls keep resolving to this library.
+     */
+
+    sai_trace_vendor_handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+    if (sai_trace_vendor_handle == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to load vendor library %s: %s", path, dlerror());
+
+        sai_trace_load_status = SAI_STATUS_FAILURE;
+        return;
+    }
+
+    sai_metadata_global_apis_query(&sai_trace_vendor_global_apis, sai_trace_vendor_handle, dlsym, dlerror);
+
+    if (sai_trace_vendor_global_apis.api_query == NULL)
+    {
+        SAI_META_LOG_ERROR("vendor library %s does not export sai_api_query", path);
+
+        sai_trace_load_status = SAI_STATUS_FAILURE;
+        return;
+    }
+
+    sai_trace_start_dump_thread();
+
+    sai_trace_start_recorder();
+
+    sai_trace_load_status = SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_api_initialize(
+        _In_ uint64_t flags,
+        _In_ const sai_service_method_table_t *services)
+{
+    pthread_once(&sai_trace_load_once, sai_trace_load);
+
+    if (sai_trace_load_status != SAI_STATUS_SUCCESS)
+    {
+        return sai_trace_load_status;
+    }
+
+    if (sai_trace_vendor_global_apis.api_initialize == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    return sai_trace_vendor_global_apis.api_initialize(flags, services);
+}
+
+sai_status_t sai_api_query(
+        _In_ sai_api_t api,
+        _Out_ void **api_method_table)
+{
+    sai_status_t status;
+
+    pthread_once(&sai_trace_load_once, sai_trace_load);
+
+    if (sai_trace_load_status != SAI_STATUS_SUCCESS)
+    {
+        return sai_trace_load_status;
+    }
+
+    status = sai_trace_vendor_global_apis.api_query(api, api_method_table);
+
+    if (status == SAI_STATUS_SUCCESS && api_method_table != NULL && *api_method_table != NULL)
+    {
+        if (sai_trace_wrap_api(api, *api_method_table, api_method_table) != SAI_STATUS_SUCCESS)
+        {
+            SAI_META_LOG_NOTICE("api %d is not traced", api);
+        }
+    }
+
+    return status;
+}
+
+sai_status_t sai_api_uninitialize(void)
+{
+    sai_status_t status;
+
+    if (sai_trace_vendor_global_apis.api_uninitialize == NULL)
+    {
+        return SAI_STATUS_NOT_IMPLEMENTED;
+    }
+
+    status = sai_trace_vendor_global_apis.api_uninitialize();
+
+    /*
+     * Vendor library stays loaded, application may still hold pointers to
+     * tracing method tables which point into it.
+     */
+
+    sai_trace_dump_file(sai_trace_dump_path);
+
+    __atomic_store_n(&sai_trace_recording, 0, __ATOMIC_RELAXED);
+
+    sai_recorder_stop();
+
+    return status;
+}
+
+sai_status_t sai_dbg_generate_dump(
+        _In_ const char *dump_file_name)
+{
+    sai_status_t status = SAI_STATUS_NOT_IMPLEMENTED;
+    char path[PATH_MAX];
+
+    if (sai_trace_vendor_global_apis.dbg_generate_dump != NULL)
+    {
+        status = sai_trace_vendor_global_apis.dbg_generate_dump(dump_file_name);
+    }
+
+    if (dump_file_name == NULL)
+    {
+        return status;
+    }
+
+    snprintf(path, sizeof(path), "%s.saitrace", dump_file_name);
+
+    sai_trace_dump_file(path);
+
+    return status;
+}
@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2024 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saitraitstest.cpp
+ *
+ * @brief   This module implements SAI C++ attribute traits tests
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "saimetadata.hpp"
+
+#define ASSERT_TRUE(x,fmt,...)                              \
+    if (!(x)){                                              \
+        fprintf(stderr,                                     \
+                "ASSERT TRUE FAILED(%s:%d): %s: " fmt "\n", \
+                __func__, __LINE__, #x, ##__VA_ARGS__);     \
+        exit(1);}
+
+using namespace sai::metadata;
+
+/*
+ * Traits are resolved at compile time, so part of the checks are static.
+ */
+
+static_assert(std::is_same<attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>::type, bool>::value, "bool type");
+static_assert(std::is_same<attr_traits<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>::type, sai_packet_action_t>::value, "enum type");
+static_assert(std::is_same<attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>::type, sai_u32_list_t>::value, "list type");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>::value_type == SAI_ATTR_VALUE_TYPE_BOOL, "value type");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>::object_type == SAI_OBJECT_TYPE_PORT, "object type");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>::default_value() == false, "default value");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>::is_enum, "is enum");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>::default_value() == SAI_PACKET_ACTION_FORWARD, "default enum");
+static_assert(attr_traits<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)>::is_allowed_object_type(SAI_OBJECT_TYPE_NEXT_HOP), "allowed");
+static_assert(!attr_traits<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)>::is_allowed_object_type(SAI_OBJECT_TYPE_ROUTE_ENTRY), "not allowed");
+static_assert(SAI_HAS_FLAG_CREATE_ONLY(attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>::flags), "create only");
+static_assert(SAI_HAS_FLAG_READ_ONLY(attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_OPER_STATUS)>::flags), "read only");
+static_assert(!attr_traits<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>::has_default_value, "no default");
+static_assert(object_traits<SAI_OBJECT_TYPE_PORT>::mandatory_on_create_count == 2, "lanes and speed");
+static_assert(attr_list<SAI_OBJECT_TYPE_ROUTE_ENTRY>::capacity == object_traits<SAI_OBJECT_TYPE_ROUTE_ENTRY>::settable_attr_count, "capacity");
+
+/*
+ * Compares traits of attribute with runtime metadata.
+ */
+
+template <typename traits>
+static void test_default_value(
+        _In_ const sai_attr_metadata_t* md,
+        _In_ std::true_type)
+{
+    ASSERT_TRUE(md->defaultvalue != NULL, "%s", traits::name);
+
+    ASSERT_TRUE(traits::get(*md->defaultvalue) == traits::default_value(), "%s", traits::name);
+}
+
+template <typename traits>
+static void test_default_value(
+        _In_ const sai_attr_metadata_t* md,
+        _In_ std::false_type)
+{
+}
+
+template <typename T, T A>
+static void test_attr_traits()
+{
+    typedef attr_traits<T, A> traits;
+
+    const sai_attr_metadata_t* md = sai_metadata_get_attr_metadata(traits::object_type, traits::id);
+
+    ASSERT_TRUE(md != NULL, "%s", traits::name);
+
+    ASSERT_TRUE(strcmp(md->attridname, traits::name) == 0, "%s", traits::name);
+    ASSERT_TRUE(md->attrvaluetype == traits::value_type, "%s", traits::name);
+    ASSERT_TRUE(md->flags == traits::flags, "%s", traits::name);
+    ASSERT_TRUE(md->defaultvaluetype == traits::default_value_type, "%s", traits::name);
+    ASSERT_TRUE(md->isenum == traits::is_enum, "%s", traits::name);
+    ASSERT_TRUE(md->isenumlist == traits::is_enum_list, "%s", traits::name);
+    ASSERT_TRUE(md->allownullobjectid == traits::allow_null, "%s", traits::name);
+    ASSERT_TRUE(md->isconditional == traits::is_conditional, "%s", traits::name);
+
+    size_t allowed = 0;
+
+    for (size_t i = 0; i < sai_metadata_enum_sai_object_type_t.valuescount; i++)
+    {
+        sai_object_type_t ot = (sai_object_type_t)sai_metadata_enum_sai_object_type_t.values[i];
+
+        if (!traits::is_allowed_object_type(ot))
+        {
+            continue;
+        }
+
+        ASSERT_TRUE(sai_metadata_is_allowed_object_type(md, ot), "%s", traits::name);
+
+        allowed++;
+    }
+
+    ASSERT_TRUE(allowed == md->allowedobjecttypeslength, "%s", traits::name);
+
+    test_default_value<traits>(md, std::integral_constant<bool, traits::has_default_value>());
+}
+
+#define TEST_ATTR_TRAITS(attr) test_attr_traits<SAI_METADATA_ATTR(attr)>();
+
+static void test_every_attr_traits()
+{
+    SAI_METADATA_DECLARE_EVERY_ATTR_TRAITS(TEST_ATTR_TRAITS)
+}
+
+static void test_scalar()
+{
+    sai_attribute_t attr = make<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>(true);
+
+    ASSERT_TRUE(attr.id == SAI_PORT_ATTR_ADMIN_STATE, "id");
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>(attr) == true, "admin state");
+
+    attr = make<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>(SAI_PACKET_ACTION_DROP);
+
+    ASSERT_TRUE(attr.value.s32 == SAI_PACKET_ACTION_DROP, "enum stored in s32");
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>(attr) == SAI_PACKET_ACTION_DROP, "packet action");
+
+    attr = make<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)>(0x4000000000001);
+
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)>(attr) == 0x4000000000001, "next hop");
+}
+
+static void test_array()
+{
+    sai_mac_t mac = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+    sai_attribute_t attr = make<SAI_METADATA_ATTR(SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS)>(mac);
+
+    ASSERT_TRUE(memcmp(get<SAI_METADATA_ATTR(SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS)>(attr), mac, sizeof(mac)) == 0, "mac");
+
+    attr = make<SAI_METADATA_ATTR(SAI_HOSTIF_ATTR_NAME)>("Ethernet0");
+
+    ASSERT_TRUE(strcmp(get<SAI_METADATA_ATTR(SAI_HOSTIF_ATTR_NAME)>(attr), "Ethernet0") == 0, "name");
+}
+
+static void test_list()
+{
+    uint32_t lanes[] = { 1, 2, 3, 4 };
+
+    sai_u32_list_t list = { 4, lanes };
+
+    sai_attribute_t attr = make<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>(list);
+
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>(attr).count == 4, "count");
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>(attr).list == lanes, "list");
+}
+
+static void test_acl_field()
+{
+    sai_acl_field_data_t data = {};
+
+    data.enable = true;
+    data.data.ip4 = 0x0a000001;
+    data.mask.ip4 = 0xffffffff;
+
+    sai_attribute_t attr = make<SAI_METADATA_ATTR(SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP)>(data);
+
+    ASSERT_TRUE(attr.value.aclfield.enable, "enable");
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP)>(attr).data.ip4 == 0x0a000001, "data");
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP)>(attr).mask.ip4 == 0xffffffff, "mask");
+}
+
+static void test_port_state_change(
+        _In_ uint32_t count,
+        _In_ const sai_port_oper_status_notification_t *data)
+{
+}
+
+static void test_pointer()
+{
+    sai_attribute_t attr = make<SAI_METADATA_ATTR(SAI_SWITCH_ATTR_PORT_STATE_CHANGE_NOTIFY)>(&test_port_state_change);
+
+    ASSERT_TRUE(get<SAI_METADATA_ATTR(SAI_SWITCH_ATTR_PORT_STATE_CHANGE_NOTIFY)>(attr) == &test_port_state_change, "pointer");
+}
+
+static void test_attr_list_create()
+{
+    uint32_t lanes[] = { 1, 2, 3, 4 };
+
+    sai_u32_list_t list = { 4, lanes };
+
+    attr_list<SAI_OBJECT_TYPE_PORT> port;
+
+    port.set<SAI_METADATA_ATTR(SAI_PORT_ATTR_HW_LANE_LIST)>(list)
+        .set<SAI_METADATA_ATTR(SAI_PORT_ATTR_SPEED)>(100000)
+        .set<SAI_METADATA_ATTR(SAI_PORT_ATTR_ADMIN_STATE)>(true);
+
+    ASSERT_TRUE(port.count() == 3, "count");
+
+    const sai_attribute_t* attrs = port.create_list();
+
+    ASSERT_TRUE(attrs[0].id == SAI_PORT_ATTR_HW_LANE_LIST, "order");
+    ASSERT_TRUE(attrs[1].id == SAI_PORT_ATTR_SPEED && attrs[1].value.u32 == 100000, "speed");
+    ASSERT_TRUE(attrs[2].id == SAI_PORT_ATTR_ADMIN_STATE && attrs[2].value.booldata, "admin state");
+
+    ASSERT_TRUE(port.find(SAI_PORT_ATTR_SPEED) == &attrs[1], "find");
+    ASSERT_TRUE(port.find(SAI_PORT_ATTR_MTU) == NULL, "find missing");
+}
+
+static void test_attr_list_set()
+{
+    attr_list<SAI_OBJECT_TYPE_ROUTE_ENTRY> route;
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        route.clear();
+
+        route.set<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION)>(SAI_PACKET_ACTION_FORWARD)
+            .set<SAI_METADATA_ATTR(SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID)>(0x4000000000000ULL + i);
+
+        ASSERT_TRUE(route.count() == 2, "count");
+        ASSERT_TRUE(route.set_list()[1].value.oid == 0x4000000000000ULL + i, "next hop");
+        ASSERT_TRUE(route.create_list() == route.data(), "same list");
+    }
+}
+
+int main()
+{
+    test_every_attr_traits();
+
+    test_scalar();
+
+    test_array();
+
+    test_list();
+
+    test_acl_field();
+
+    test_pointer();
+
+    test_attr_list_create();
+
+    test_attr_list_set();
+
+    return 0;
+}
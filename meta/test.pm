@@ -662,6 +662,245 @@ sub CreateStructUnionSizeCheckTest
     WriteTest "}";
 }
 
+sub CreateNonObjectIdHashTest
+{
+    DefineTestName "non_object_id_hash_test";
+
+    WriteTest "{";
+
+    for my $ot (sort keys %main::NON_OBJECT_ID_STRUCTS)
+    {
+        my $rawname = lc($1) if $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        # members are the same, but padding in b is garbage
+
+        WriteTest "    {";
+        WriteTest "        sai_${rawname}_t a;";
+        WriteTest "        sai_${rawname}_t b;";
+        WriteTest "        memset(&a, 0, sizeof(a));";
+        WriteTest "        memset(&b, 0xff, sizeof(b));";
+
+        for my $key (GetStructKeysInOrder($main::NON_OBJECT_ID_STRUCTS{$ot}))
+        {
+            WriteTest "        memcpy(&b.$key, &a.$key, sizeof(b.$key));";
+        }
+
+        WriteTest "        TEST_ASSERT_TRUE(sai_metadata_hash_$rawname(&a) == sai_metadata_hash_$rawname(&b), \"padding changes $rawname hash\");";
+        WriteTest "        TEST_ASSERT_TRUE(sai_metadata_equal_$rawname(&a, &b), \"padding changes $rawname equality\");";
+        WriteTest "        b.switch_id = 1;";
+        WriteTest "        TEST_ASSERT_TRUE(!sai_metadata_equal_$rawname(&a, &b), \"$rawname switch_id is not compared\");";
+        WriteTest "    }";
+    }
+
+    WriteTest "}";
+}
+
+sub CreateAttrValueCopyTest
+{
+    DefineTestName "attr_value_copy_test";
+
+    # deep copy, compare and free over lists, ACL field data, IP address
+    # and QoS map padding, and single block copy of attribute list
+
+    WriteTest "{";
+    WriteTest "    const sai_attr_metadata_t *lanes_md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_HW_LANE_LIST);";
+    WriteTest "    const sai_attr_metadata_t *ip_md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_NEXT_HOP, SAI_NEXT_HOP_ATTR_IP);";
+    WriteTest "    const sai_attr_metadata_t *udf_md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_ACL_ENTRY, SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_GROUP_MIN);";
+    WriteTest "    const sai_attr_metadata_t *qos_md = sai_metadata_get_attr_metadata(SAI_OBJECT_TYPE_QOS_MAP, SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST);";
+    WriteTest "    uint32_t lanes[4] = { 1, 2, 3, 4 };";
+    WriteTest "    uint8_t data[3] = { 1, 2, 3 };";
+    WriteTest "    uint8_t mask[3] = { 0xff, 0xff, 0xff };";
+    WriteTest "    sai_qos_map_t maps[2];";
+    WriteTest "    sai_attribute_value_t a;";
+    WriteTest "    sai_attribute_value_t b;";
+    WriteTest "    sai_attribute_t attrs[3];";
+    WriteTest "    sai_attribute_t *copy;";
+    WriteTest "    size_t size;";
+    WriteTest "    uint8_t buffer[256];";
+    WriteTest "    uint32_t idx;";
+    WriteTest "    TEST_ASSERT_TRUE(lanes_md && ip_md && udf_md && qos_md, \"attributes not found\");";
+    WriteTest "    memset(&a, 0, sizeof(a));";
+    WriteTest "    a.u32list.count = 4;";
+    WriteTest "    a.u32list.list = lanes;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_deep_copy_attribute_value(lanes_md, &a, &b, NULL) == SAI_STATUS_SUCCESS, \"u32 list copy failed\");";
+    WriteTest "    TEST_ASSERT_TRUE(b.u32list.list != lanes, \"u32 list not copied\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(lanes_md, &a, &b) == 0, \"u32 list copy differs\");";
+    WriteTest "    b.u32list.list[3] = 5;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(lanes_md, &a, &b) < 0, \"u32 list order\");";
+    WriteTest "    sai_metadata_free_attribute_value(lanes_md, &b);";
+    WriteTest "    TEST_ASSERT_TRUE(b.u32list.count == 0 && b.u32list.list == NULL, \"u32 list not freed\");";
+    WriteTest "    a.u32list.list = NULL;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_deep_copy_attribute_value(lanes_md, &a, &b, NULL) == SAI_STATUS_INVALID_PARAMETER, \"NULL list copied\");";
+    WriteTest "    memset(&a, 0, sizeof(a));";
+    WriteTest "    memset(&b, 0xff, sizeof(b));";
+    WriteTest "    a.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;";
+    WriteTest "    a.ipaddr.addr.ip4 = 0x0100000a;";
+    WriteTest "    b.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;";
+    WriteTest "    b.ipaddr.addr.ip4 = 0x0100000a;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(ip_md, &a, &b) == 0, \"unused IPv6 bytes compared\");";
+    WriteTest "    memset(&a, 0, sizeof(a));";
+    WriteTest "    memset(&b, 0xff, sizeof(b));";
+    WriteTest "    b.aclfield.enable = false;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(udf_md, &a, &b) == 0, \"disabled ACL field data compared\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_deep_copy_attribute_value(udf_md, &b, &b, NULL) == SAI_STATUS_SUCCESS, \"disabled ACL field copy failed\");";
+    WriteTest "    a.aclfield.enable = true;";
+    WriteTest "    a.aclfield.data.u8list.count = 3;";
+    WriteTest "    a.aclfield.data.u8list.list = data;";
+    WriteTest "    a.aclfield.mask.u8list.count = 3;";
+    WriteTest "    a.aclfield.mask.u8list.list = mask;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_get_attribute_value_copy_size(udf_md, &a, &size) == SAI_STATUS_SUCCESS && size == 16, \"ACL field copy size\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_deep_copy_attribute_value(udf_md, &a, &b, buffer) == SAI_STATUS_SUCCESS, \"ACL field copy failed\");";
+    WriteTest "    TEST_ASSERT_TRUE(b.aclfield.mask.u8list.list == buffer && b.aclfield.data.u8list.list == buffer + 8, \"ACL field lists not in buffer\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(udf_md, &a, &b) == 0, \"ACL field copy differs\");";
+    WriteTest "    b.aclfield.mask.u8list.list[0] = 0;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(udf_md, &a, &b) > 0, \"ACL field mask not compared\");";
+    WriteTest "    memset(&maps[0], 0xff, sizeof(maps[0]));";
+    WriteTest "    memset(&maps[1], 0, sizeof(maps[1]));";
+    WriteTest "    for (idx = 0; idx < 2; idx++)";
+    WriteTest "    {";
+    WriteTest "        maps[idx].key.tc = 1;";
+    WriteTest "        maps[idx].key.dscp = 2;";
+    WriteTest "        maps[idx].key.dot1p = 0;";
+    WriteTest "        maps[idx].key.prio = 0;";
+    WriteTest "        maps[idx].key.pg = 0;";
+    WriteTest "        maps[idx].key.queue_index = 3;";
+    WriteTest "        maps[idx].key.color = SAI_PACKET_COLOR_GREEN;";
+    WriteTest "        maps[idx].key.mpls_exp = 0;";
+    WriteTest "        maps[idx].key.fc = 0;";
+    WriteTest "        maps[idx].value = maps[idx].key;";
+    WriteTest "    }";
+    WriteTest "    memset(&a, 0, sizeof(a));";
+    WriteTest "    memset(&b, 0, sizeof(b));";
+    WriteTest "    a.qosmap.count = 1;";
+    WriteTest "    a.qosmap.list = &maps[0];";
+    WriteTest "    b.qosmap.count = 1;";
+    WriteTest "    b.qosmap.list = &maps[1];";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(qos_md, &a, &b) == 0, \"QoS map padding compared\");";
+    WriteTest "    attrs[0].id = SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_GROUP_MIN;";
+    WriteTest "    memset(&attrs[0].value, 0, sizeof(attrs[0].value));";
+    WriteTest "    attrs[0].value.aclfield.enable = true;";
+    WriteTest "    attrs[0].value.aclfield.data.u8list.count = 3;";
+    WriteTest "    attrs[0].value.aclfield.data.u8list.list = data;";
+    WriteTest "    attrs[0].value.aclfield.mask.u8list.count = 3;";
+    WriteTest "    attrs[0].value.aclfield.mask.u8list.list = mask;";
+    WriteTest "    attrs[1].id = SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPV6;";
+    WriteTest "    memset(&attrs[1].value, 0, sizeof(attrs[1].value));";
+    WriteTest "    attrs[2] = attrs[0];";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_get_attr_list_copy_size(SAI_OBJECT_TYPE_ACL_ENTRY, 3, attrs, &size) == SAI_STATUS_SUCCESS, \"list copy size failed\");";
+    WriteTest "    TEST_ASSERT_TRUE(size == 3 * sizeof(sai_attribute_t) + 32, \"list copy size\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_deep_copy_attr_list(SAI_OBJECT_TYPE_ACL_ENTRY, 3, attrs, NULL, &copy) == SAI_STATUS_SUCCESS, \"list copy failed\");";
+    WriteTest "    TEST_ASSERT_TRUE((uint8_t*)copy[0].value.aclfield.mask.u8list.list == (uint8_t*)copy + 3 * sizeof(sai_attribute_t), \"list copy is not single block\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_compare_attribute_value(udf_md, &attrs[2].value, &copy[2].value) == 0, \"list copy differs\");";
+    WriteTest "    free(copy);";
+    WriteTest "    attrs[2].value.aclfield.data.u8list.list = NULL;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_get_attr_list_copy_size(SAI_OBJECT_TYPE_ACL_ENTRY, 3, attrs, &size) == SAI_STATUS_INVALID_ATTR_VALUE_0 + SAI_STATUS_CODE(2), \"NULL list index\");";
+    WriteTest "}";
+}
+
+sub CreateObjectStructTest
+{
+    DefineTestName "object_struct_test";
+
+    # field index of every attribute, and round trip of port struct
+    # through attribute list
+
+    WriteTest "{";
+    WriteTest "    sai_object_struct_port_t port;";
+    WriteTest "    sai_attribute_t attrs[4];";
+    WriteTest "    uint32_t lanes[4] = { 1, 2, 3, 4 };";
+    WriteTest "    uint32_t count;";
+    WriteTest "    size_t i;";
+    WriteTest "    size_t idx;";
+    WriteTest "    for (i = 0; i < sai_metadata_enum_sai_object_type_t.valuescount; i++)";
+    WriteTest "    {";
+    WriteTest "        const sai_object_type_info_t *oi = sai_metadata_get_object_type_info((sai_object_type_t)sai_metadata_enum_sai_object_type_t.values[i]);";
+    WriteTest "        const sai_object_struct_info_t *info = (oi == NULL) ? NULL : oi->structinfo;";
+    WriteTest "        if (info == NULL)";
+    WriteTest "            continue;";
+    WriteTest "        TEST_ASSERT_TRUE(info->presentoffset + (info->fieldscount + 7) / 8 <= info->size, \"presence bitmap outside of struct\");";
+    WriteTest "        for (idx = 0; idx < info->fieldscount; idx++)";
+    WriteTest "        {";
+    WriteTest "            TEST_ASSERT_TRUE(info->fieldindex(info->fields[idx].attrmetadata->attrid) == (int)idx, \"wrong field index\");";
+    WriteTest "            TEST_ASSERT_TRUE(info->fields[idx].size <= sizeof(sai_attribute_value_t), \"field larger than attribute value\");";
+    WriteTest "            TEST_ASSERT_TRUE(info->fields[idx].offset + info->fields[idx].size <= info->presentoffset, \"field overlaps presence bitmap\");";
+    WriteTest "        }";
+    WriteTest "    }";
+    WriteTest "    memset(&port, 0, sizeof(port));";
+    WriteTest "    attrs[0].id = SAI_PORT_ATTR_HW_LANE_LIST;";
+    WriteTest "    attrs[0].value.u32list.count = 4;";
+    WriteTest "    attrs[0].value.u32list.list = lanes;";
+    WriteTest "    attrs[1].id = SAI_PORT_ATTR_SPEED;";
+    WriteTest "    attrs[1].value.u32 = 100000;";
+    WriteTest "    attrs[2].id = SAI_PORT_ATTR_ADMIN_STATE;";
+    WriteTest "    attrs[2].value.booldata = true;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_from_attr_list(SAI_OBJECT_TYPE_PORT, 3, attrs, &port) == SAI_STATUS_SUCCESS, \"from attr list failed\");";
+    WriteTest "    TEST_ASSERT_TRUE(port.speed == 100000 && port.admin_state && port.hw_lane_list.list == lanes, \"fields not set\");";
+    WriteTest "    TEST_ASSERT_TRUE(SAI_OBJECT_STRUCT_IS_PRESENT(&port, SAI_OBJECT_STRUCT_FIELD_PORT_ATTR_SPEED), \"speed not present\");";
+    WriteTest "    TEST_ASSERT_TRUE(!SAI_OBJECT_STRUCT_IS_PRESENT(&port, SAI_OBJECT_STRUCT_FIELD_PORT_ATTR_MTU), \"mtu present\");";
+    WriteTest "    port.mtu = 9100;";
+    WriteTest "    SAI_OBJECT_STRUCT_SET_PRESENT(&port, SAI_OBJECT_STRUCT_FIELD_PORT_ATTR_MTU);";
+    WriteTest "    SAI_OBJECT_STRUCT_CLEAR_PRESENT(&port, SAI_OBJECT_STRUCT_FIELD_PORT_ATTR_ADMIN_STATE);";
+    WriteTest "    attrs[3].id = SAI_PORT_ATTR_ADMIN_STATE;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_get_attr(SAI_OBJECT_TYPE_PORT, &port, &attrs[3]) == SAI_STATUS_ITEM_NOT_FOUND, \"cleared field found\");";
+    WriteTest "    attrs[3].id = SAI_PORT_ATTR_MTU;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_get_attr(SAI_OBJECT_TYPE_PORT, &port, &attrs[3]) == SAI_STATUS_SUCCESS && attrs[3].value.u32 == 9100, \"mtu get failed\");";
+    WriteTest "    count = 2;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_to_attr_list(SAI_OBJECT_TYPE_PORT, &port, &count, attrs) == SAI_STATUS_BUFFER_OVERFLOW && count == 3, \"to attr list overflow\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_to_attr_list(SAI_OBJECT_TYPE_PORT, &port, &count, attrs) == SAI_STATUS_SUCCESS && count == 3, \"to attr list failed\");";
+    WriteTest "    for (idx = 0; idx < count; idx++)";
+    WriteTest "    {";
+    WriteTest "        TEST_ASSERT_TRUE(idx == 0 || attrs[idx - 1].id < attrs[idx].id, \"attr list not ordered\");";
+    WriteTest "        if (attrs[idx].id == SAI_PORT_ATTR_HW_LANE_LIST)";
+    WriteTest "            TEST_ASSERT_TRUE(attrs[idx].value.u32list.count == 4 && attrs[idx].value.u32list.list == lanes, \"lanes differ\");";
+    WriteTest "        if (attrs[idx].id == SAI_PORT_ATTR_SPEED)";
+    WriteTest "            TEST_ASSERT_TRUE(attrs[idx].value.u32 == 100000, \"speed differs\");";
+    WriteTest "        TEST_ASSERT_TRUE(attrs[idx].id != SAI_PORT_ATTR_ADMIN_STATE, \"cleared field in list\");";
+    WriteTest "    }";
+    WriteTest "    attrs[1].id = SAI_PORT_ATTR_END;";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_object_struct_from_attr_list(SAI_OBJECT_TYPE_PORT, 2, attrs, &port) == SAI_STATUS_UNKNOWN_ATTRIBUTE_0 + SAI_STATUS_CODE(1), \"unknown attribute index\");";
+    WriteTest "}";
+}
+
+sub CreateVendorCapabilityTest
+{
+    DefineTestName "vendor_capability_test";
+
+    # every capability from attribute metadata is found in vendor table
+
+    WriteTest "{";
+    WriteTest "    size_t i;";
+    WriteTest "    size_t idx;";
+    WriteTest "    int32_t values[512];";
+    WriteTest "    sai_s32_list_t list;";
+    WriteTest "    sai_attr_capability_t cap;";
+    WriteTest "    for (i = 0; i < sai_metadata_attr_sorted_by_id_name_count; i++)";
+    WriteTest "    {";
+    WriteTest "        const sai_attr_metadata_t *md = sai_metadata_attr_sorted_by_id_name[i];";
+    WriteTest "        for (idx = 0; idx < md->capabilitylength; idx++)";
+    WriteTest "        {";
+    WriteTest "            const sai_attr_capability_metadata_t *c = md->capability[idx];";
+    WriteTest "            TEST_ASSERT_TRUE(sai_metadata_get_attr_capability(c->vendorid, md->objecttype, md->attrid) == c, md->attridname);";
+    WriteTest "            TEST_ASSERT_TRUE(sai_metadata_query_attribute_capability(c->vendorid, md->objecttype, md->attrid, &cap) == SAI_STATUS_SUCCESS, md->attridname);";
+    WriteTest "            TEST_ASSERT_TRUE(cap.create_implemented == c->operationcapability.create_implemented, md->attridname);";
+    WriteTest "            list.count = 512;";
+    WriteTest "            list.list = values;";
+    WriteTest "            if (c->enumvalues == NULL)";
+    WriteTest "            {";
+    WriteTest "                TEST_ASSERT_TRUE(sai_metadata_query_attribute_enum_values_capability(c->vendorid, md->objecttype, md->attrid, &list) == SAI_STATUS_ITEM_NOT_FOUND, md->attridname);";
+    WriteTest "                continue;";
+    WriteTest "            }";
+    WriteTest "            TEST_ASSERT_TRUE(sai_metadata_query_attribute_enum_values_capability(c->vendorid, md->objecttype, md->attrid, &list) == SAI_STATUS_SUCCESS, md->attridname);";
+    WriteTest "            TEST_ASSERT_TRUE(list.count == c->enumvaluescount && memcmp(values, c->enumvalues, list.count * sizeof(int32_t)) == 0, md->attridname);";
+    WriteTest "            list.count = 0;";
+    WriteTest "            TEST_ASSERT_TRUE(sai_metadata_query_attribute_enum_values_capability(c->vendorid, md->objecttype, md->attrid, &list) == SAI_STATUS_BUFFER_OVERFLOW, md->attridname);";
+    WriteTest "            TEST_ASSERT_TRUE(list.count == c->enumvaluescount, md->attridname);";
+    WriteTest "        }";
+    WriteTest "    }";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_get_attr_capability(0xffffffffffffffffULL, SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_TYPE) == NULL, \"unknown vendor\");";
+    WriteTest "    TEST_ASSERT_TRUE(sai_metadata_query_attribute_capability(0xffffffffffffffffULL, SAI_OBJECT_TYPE_PORT, SAI_PORT_ATTR_TYPE, &cap) == SAI_STATUS_ITEM_NOT_FOUND, \"unknown vendor\");";
+    WriteTest "}";
+}
+
 sub WriteTestHeader
 {
     #
@@ -757,6 +996,14 @@ sub CreateTests
 
     CreateNonObjectIdTest();
 
+    CreateNonObjectIdHashTest();
+
+    CreateAttrValueCopyTest();
+
+    CreateObjectStructTest();
+
+    CreateVendorCapabilityTest();
+
     CreateSwitchIdTest();
 
     CreateCustomRangeTest();
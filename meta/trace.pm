@@ -0,0 +1,512 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2024 Microsoft Open Technologies, Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+#    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+#    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+#    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+#    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+#
+#    See the Apache Version 2.0 License for specific language governing
+#    permissions and limitations under the License.
+#
+#    Microsoft would like to thank the following companies for their review and
+#    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+#    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+#
+# @file    trace.pm
+#
+# @brief   This module defines SAI Metadata Trace Interposer Generator
+#
+
+package trace;
+
+use strict;
+use warnings;
+use diagnostics;
+use Data::Dumper;
+use utils;
+use xmlutils;
+
+require Exporter;
+
+#
+# Global functions implemented by hand in saitraceutils.c, they load vendor
+# library, wrap method tables and dump statistics.
+#
+
+my %TRACE_MANUAL_GLOBAL_APIS = map { $_ => 1 } qw/
+    sai_api_initialize
+    sai_api_query
+    sai_api_uninitialize
+    sai_dbg_generate_dump
+    /;
+
+my @TRACE_METHODS = ();
+
+sub GetTraceArgs
+{
+    my $params = shift;
+
+    $params =~ s/^\s*\(//;
+    $params =~ s/\)\s*$//;
+    $params = Trim($params);
+
+    return () if $params eq "void" or $params eq "";
+
+    my @args = ();
+
+    for my $param (split/,/, $params)
+    {
+        if (not $param =~ /(\w+)\s*(\[\w*\])?\s*$/)
+        {
+            LogError "failed to extract argument name from '$param'";
+            next;
+        }
+
+        push @args, { decl => Trim($param), name => $1 };
+    }
+
+    return @args;
+}
+
+sub WriteTraceFunctionHeader
+{
+    my ($function, @args) = @_;
+
+    if (scalar @args == 0)
+    {
+        WriteTrace "$function(void)";
+        return;
+    }
+
+    WriteTrace "$function(";
+
+    my @decls = map { "    $_->{decl}" } @args;
+
+    WriteTrace "$_," for @decls[0 .. $#decls - 1];
+    WriteTrace "$decls[-1])";
+}
+
+sub GetTraceObjectType
+{
+    my ($name, $params) = @_;
+
+    return "object_type" if $params =~ /\bsai_object_type_t object_type\b/;
+
+    return "SAI_OBJECT_TYPE_NULL" if not $name =~ /^(?:create|remove|set|get|clear)_(\w+?)(?:_attribute|_stats_ext|_stats)?$/;
+
+    my $ot = $1;
+
+    my $single = $ot;
+
+    $single =~ s/ies$/y/;
+
+    my $plural = $ot;
+
+    $plural =~ s/s$//;
+
+    for my $candidate ($ot, $single, $plural)
+    {
+        my $OT = "SAI_OBJECT_TYPE_" . uc($candidate);
+
+        return $OT if defined $main::OBJECT_TYPE_MAP{$OT};
+    }
+
+    return "SAI_OBJECT_TYPE_NULL";
+}
+
+sub GetTraceObjectCount
+{
+    my $params = shift;
+
+    return ($params =~ /\buint32_t object_count\b/) ? "object_count" : "0";
+}
+
+#
+# Returns code recording create/remove/set/get call of method table, for
+# bulk calls each object is recorded separately. Returns empty list when
+# method signature is not recognized.
+#
+
+sub GetTraceRecordCode
+{
+    my ($name, $params, $ot) = @_;
+
+    return () if not $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/ or $ot eq "SAI_OBJECT_TYPE_NULL";
+
+    my $member = lc($1);
+
+    return () if not $name =~ /^(create|remove|set|get)_/ or $name =~ /_stats(_ext)?$/;
+
+    my $op = $1;
+
+    # argument declarations without annotation, like "const sai_attribute_t *attr"
+
+    my @args = map { { name => $_->{name}, decl => ($_->{decl} =~ s/^_\w+_\s+//r) } } GetTraceArgs($params);
+
+    my %args = map { $_->{name} => $_->{decl} } @args;
+
+    my $bulk = (defined $args{object_count} and defined $args{object_statuses});
+
+    my $api = "SAI_COMMON_API_" . ($bulk ? "BULK_" : "") . uc($op);
+
+    my $i = $bulk ? "[idx]" : "";
+
+    my @guard = ();
+
+    my $key;
+    my $switch = "SAI_NULL_OBJECT_ID";
+
+    if (defined $main::NON_OBJECT_ID_STRUCTS{$ot})
+    {
+        my @entries = grep { $_->{decl} =~ /^const sai_${member}_t \*\w+$/ } @args;
+
+        if (scalar @entries != 1)
+        {
+            LogDebug "not recording $name, entry argument not found";
+            return ();
+        }
+
+        my $entry = $entries[0]->{name};
+
+        push @guard, "$entry != NULL";
+
+        $key = "meta_key.objectkey.key.$member = " . ($bulk ? "$entry\[idx\]" : "*$entry") . ";";
+    }
+    elsif ($bulk)
+    {
+        my $decl = $args{object_id} // "";
+
+        if (not $decl =~ /^(const )?sai_object_id_t \*object_id$/)
+        {
+            LogDebug "not recording $name, object_id argument not found";
+            return ();
+        }
+
+        push @guard, "object_id != NULL";
+
+        $key = ($op eq "create")
+            ? "meta_key.objectkey.key.object_id = (object_statuses[idx] == SAI_STATUS_SUCCESS) ? object_id[idx] : SAI_NULL_OBJECT_ID;"
+            : "meta_key.objectkey.key.object_id = object_id[idx];";
+    }
+    else
+    {
+        my $decl = $args[0]->{decl} // "";
+        my $oid = $args[0]->{name} // "";
+
+        if ($op eq "create" and $decl =~ /^sai_object_id_t \*\w+$/)
+        {
+            push @guard, "$oid != NULL";
+
+            $key = "meta_key.objectkey.key.object_id = (status == SAI_STATUS_SUCCESS) ? *$oid : SAI_NULL_OBJECT_ID;";
+        }
+        elsif ($op ne "create" and $decl =~ /^sai_object_id_t \w+$/)
+        {
+            $key = "meta_key.objectkey.key.object_id = $oid;";
+        }
+        else
+        {
+            LogDebug "not recording $name, object id argument not found";
+            return ();
+        }
+    }
+
+    if ($op eq "create" and ($args{switch_id} // "") eq "sai_object_id_t switch_id")
+    {
+        $switch = "switch_id";
+    }
+
+    my $count = "0";
+    my $list = "NULL";
+
+    if ($op eq "set")
+    {
+        my $attr = $bulk ? "attr_list" : "attr";
+
+        if (not defined $args{$attr})
+        {
+            LogDebug "not recording $name, $attr argument not found";
+            return ();
+        }
+
+        push @guard, "$attr != NULL";
+
+        $count = "1";
+        $list = $bulk ? "&attr_list[idx]" : "attr";
+    }
+    elsif ($op ne "remove")
+    {
+        if (not defined $args{attr_count} or not defined $args{attr_list})
+        {
+            LogDebug "not recording $name, attr_count or attr_list argument not found";
+            return ();
+        }
+
+        push @guard, "attr_count != NULL", "attr_list != NULL" if $bulk;
+
+        $count = "attr_count$i";
+        $list = "attr_list$i";
+    }
+
+    push @guard, "object_statuses != NULL" if $bulk;
+
+    my $status = $bulk ? "object_statuses[idx]" : "status";
+
+    my @code = ();
+
+    push @code, "if (" . join(" && ", "__atomic_load_n(&sai_trace_recording, __ATOMIC_RELAXED)", @guard) . ")";
+    push @code, "{";
+    push @code, "sai_object_meta_key_t meta_key;";
+    push @code, "uint32_t idx;" if $bulk;
+    push @code, "";
+    push @code, "for (idx = 0; idx < object_count; idx++)" if $bulk;
+    push @code, "{" if $bulk;
+    push @code, "memset(&meta_key, 0, sizeof(meta_key));";
+    push @code, "meta_key.objecttype = $ot;";
+    push @code, $key;
+    push @code, "sai_recorder_record($api, &meta_key, $switch, $count, $list, $status);";
+    push @code, "}" if $bulk;
+    push @code, "}";
+    push @code, "";
+
+    return @code;
+}
+
+sub CreateTraceThunk
+{
+    my ($fname, $target, $returntype, $params, $method, $static) = @_;
+
+    my @args = GetTraceArgs($params);
+
+    my $ot = GetTraceObjectType($method->{name}, $params);
+
+    my $count = GetTraceObjectCount($params);
+
+    my $index = scalar @TRACE_METHODS;
+
+    push @TRACE_METHODS, $method;
+
+    my $names = join(", ", map { $_->{name} } @args);
+
+    WriteTraceFunctionHeader("${static}$returntype $fname", @args);
+
+    WriteTrace "{";
+
+    if ($returntype eq "sai_status_t")
+    {
+        WriteTrace "uint64_t start = sai_trace_begin();";
+        WriteTrace "sai_status_t status = $target($names);";
+        WriteTrace "sai_trace_end($index, $ot, $count, start, status);";
+        WriteTrace "";
+
+        # global functions take object type as argument, they are not recorded
+
+        if ($method->{api} ne "SAI_API_UNSPECIFIED")
+        {
+            WriteTrace $_ for GetTraceRecordCode($method->{name}, $params, $ot);
+        }
+
+        WriteTrace "return status;";
+    }
+    else
+    {
+        WriteTrace "uint64_t start = sai_trace_begin();";
+        WriteTrace "$returntype result = $target($names);";
+        WriteTrace "sai_trace_end($index, $ot, $count, start, SAI_STATUS_SUCCESS);";
+        WriteTrace "return result;";
+    }
+
+    WriteTrace "}";
+    WriteTrace "";
+}
+
+sub CreateTraceGlobalApis
+{
+    WriteTrace "/* Global functions */";
+    WriteTrace "";
+
+    for my $name (sort keys %main::GLOBAL_APIS)
+    {
+        next if defined $TRACE_MANUAL_GLOBAL_APIS{$name};
+
+        my $short = $1 if $name =~ /^sai_(\w+)/;
+
+        my $type = $main::GLOBAL_APIS{$name}{type};
+        my $args = $main::GLOBAL_APIS{$name}{args};
+
+        my $method = { api => "SAI_API_UNSPECIFIED", name => $name };
+
+        # vendor function is checked in a helper, so missing symbol behaves
+        # like a stub returning not implemented
+
+        my $default = ($type eq "sai_status_t") ? "SAI_STATUS_NOT_IMPLEMENTED" : "($type)0";
+
+        my @args = GetTraceArgs($args);
+
+        my $names = join(", ", map { $_->{name} } @args);
+
+        WriteTraceFunctionHeader("static $type sai_trace_vendor_$short", @args);
+        WriteTrace "{";
+        WriteTrace "if (sai_trace_vendor_global_apis.$short == NULL)";
+        WriteTrace "{";
+        WriteTrace "return $default;";
+        WriteTrace "}";
+        WriteTrace "";
+        WriteTrace "return sai_trace_vendor_global_apis.$short($names);";
+        WriteTrace "}";
+        WriteTrace "";
+
+        CreateTraceThunk($name, "sai_trace_vendor_$short", $type, $args, $method, "");
+    }
+}
+
+sub CreateTraceApis
+{
+    my @apis = @{ $main::SAI_ENUMS{sai_api_t}{values} };
+
+    my @wrapped = ();
+
+    for my $Api (@apis)
+    {
+        next if not $Api =~ /^SAI_API_(\w+)/;
+
+        my $api = lc($1);
+
+        next if $api =~ /unspecified/;
+
+        my $structname = "sai_${api}_api_t";
+
+        my %struct = ExtractStructInfo($structname, "struct_");
+
+        WriteTrace "/* $structname */";
+        WriteTrace "";
+        WriteTrace "static const $structname *sai_trace_vendor_${api}_api = NULL;";
+        WriteTrace "";
+        WriteTrace "static $structname sai_trace_${api}_api;";
+        WriteTrace "";
+
+        my @members = ();
+
+        for my $member (GetStructKeysInOrder(\%struct))
+        {
+            my $type = $struct{$member}{type};
+            my $name = $struct{$member}{name};
+
+            if (not defined $main::FUNCTION_DEF{$type})
+            {
+                LogError "function type $type is not defined for $api.$name";
+                next;
+            }
+
+            my $prototype = $main::FUNCTION_DEF{$type};
+
+            if (not $prototype =~ /^typedef (\S+)\(\* $type\) \((.+)\)$/)
+            {
+                LogError "failed to match function proto type $type is not defined for $api.$name";
+                next;
+            }
+
+            my $returntype = $1;
+            my $params = $2;
+
+            my $method = { api => $Api, name => $name };
+
+            CreateTraceThunk("sai_trace_${api}_$name", "sai_trace_vendor_${api}_api->$name", $returntype, $params, $method, "static ");
+
+            push @members, $name;
+        }
+
+        push @wrapped, { api => $Api, short => $api, struct => $structname, members => \@members };
+    }
+
+    WriteTrace "sai_status_t sai_trace_wrap_api(";
+    WriteTrace "    _In_ sai_api_t api,";
+    WriteTrace "    _In_ const void *vendor_method_table,";
+    WriteTrace "    _Out_ void **api_method_table)";
+    WriteTrace "{";
+    WriteTrace "switch ((int)api)";
+    WriteTrace "{";
+
+    for my $w (@wrapped)
+    {
+        my $api = $w->{short};
+
+        WriteTrace "case $w->{api}:";
+        WriteTrace "    sai_trace_vendor_${api}_api = (const $w->{struct}*)vendor_method_table;";
+
+        for my $name (@{ $w->{members} })
+        {
+            WriteTrace "    sai_trace_${api}_api.$name = sai_trace_vendor_${api}_api->$name ? sai_trace_${api}_$name : NULL;";
+        }
+
+        WriteTrace "    *api_method_table = &sai_trace_${api}_api;";
+        WriteTrace "    return SAI_STATUS_SUCCESS;";
+    }
+
+    WriteTrace "default:";
+    WriteTrace "    return SAI_STATUS_NOT_SUPPORTED;";
+    WriteTrace "}";
+    WriteTrace "}";
+    WriteTrace "";
+}
+
+sub CreateTraceMethodsTable
+{
+    WriteTrace "const sai_trace_method_t sai_trace_methods[] = {";
+
+    my $index = 0;
+
+    for my $method (@TRACE_METHODS)
+    {
+        WriteTrace "{ $method->{api}, \"$method->{name}\" }, /* $index */";
+
+        $index++;
+    }
+
+    WriteTrace "{ SAI_API_UNSPECIFIED, NULL }";
+    WriteTrace "};";
+    WriteTrace "";
+    WriteTrace "const size_t sai_trace_methods_count = $index;";
+}
+
+sub CreateTraceInterposer
+{
+    WriteTrace "/* AUTOGENERATED FILE! DO NOT EDIT */";
+    WriteTrace "";
+    WriteTrace "#include <stdio.h>";
+    WriteTrace "#include <string.h>";
+    WriteTrace "#include \"saimetadata.h\"";
+    WriteTrace "#include \"saitrace.h\"";
+    WriteTrace "#include \"sairecorder.h\"";
+    WriteTrace "";
+    WriteTrace "#pragma GCC diagnostic push";
+    WriteTrace "#pragma GCC diagnostic ignored \"-Wpragmas\"";
+    WriteTrace "#pragma GCC diagnostic ignored \"-Wenum-conversion\"";
+    WriteTrace "";
+
+    @TRACE_METHODS = ();
+
+    CreateTraceGlobalApis();
+
+    CreateTraceApis();
+
+    CreateTraceMethodsTable();
+
+    WriteTrace "";
+    WriteTrace "#pragma GCC diagnostic pop";
+}
+
+BEGIN
+{
+    our @ISA    = qw(Exporter);
+    our @EXPORT = qw/
+    CreateTraceInterposer
+    /;
+}
+
+1;
@@ -0,0 +1,529 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2024 Microsoft Open Technologies, Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+#    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+#    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+#    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+#    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+#
+#    See the Apache Version 2.0 License for specific language governing
+#    permissions and limitations under the License.
+#
+#    Microsoft would like to thank the following companies for their review and
+#    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+#    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+#
+# @file    traits.pm
+#
+# @brief   This module defines SAI Metadata C++ Attribute Traits Generator
+#
+
+package traits;
+
+use strict;
+use warnings;
+use diagnostics;
+use Data::Dumper;
+use utils;
+use xmlutils;
+
+require Exporter;
+
+my @TRAITS_ATTRS = ();
+
+#
+# Returns accessor base class of attribute traits, which defines value type
+# and how it is read from and written to sai_attribute_value_t union.
+#
+
+sub GetTraitsAccessor
+{
+    my ($attr, $type) = @_;
+
+    return "value_accessor<bool, &sai_attribute_value_t::booldata>" if $type eq "bool";
+
+    return "chardata_accessor" if $type eq "char";
+
+    return "pointer_accessor<$1>" if $type =~ /^sai_pointer_t (sai_\w+_fn)$/;
+
+    if ($type =~ /^(sai_acl_field_data_t|sai_acl_field_data_mask_t|sai_acl_action_data_t) /)
+    {
+        return "value_accessor<$1, &sai_attribute_value_t::$main::VALUE_TYPES{$1}>";
+    }
+
+    return "value_accessor<sai_s32_list_t, &sai_attribute_value_t::s32list>" if $type =~ /^sai_s32_list_t sai_\w+_t$/;
+
+    if ($type =~ /^(sai_\w+_t)$/)
+    {
+        return "value_accessor<$1, &sai_attribute_value_t::$main::VALUE_TYPES{$1}>" if defined $main::VALUE_TYPES{$1};
+
+        return "enum_accessor<$1>";
+    }
+
+    LogError "unsupported type '$type' on $attr";
+
+    return "";
+}
+
+#
+# Returns default value expression for constant scalar default values, other
+# default values (lists, addresses, attribute values, vendor specific) are
+# only described by default value type.
+#
+
+sub GetTraitsDefaultValue
+{
+    my ($attr, $default, $type) = @_;
+
+    return undef if not defined $default;
+
+    return $default if $default =~ /^(true|false)$/ and $type eq "bool";
+
+    return $default if $default eq "SAI_NULL_OBJECT_ID" and $type eq "sai_object_id_t";
+
+    return $default if $default =~ /^SAI_\w+$/ and $type =~ /^sai_\w+_t$/ and not defined $main::VALUE_TYPES{$type};
+
+    return $default if $default =~ /^$NUMBER_REGEX$/ and $type =~ /^sai_u?int\d+_t$/;
+
+    return "nullptr" if $default eq "NULL" and $type =~ /^sai_pointer_t sai_\w+_fn$/;
+
+    return undef;
+}
+
+sub GetTraitsAllowedObjectTypes
+{
+    my ($attr, $objects) = @_;
+
+    return "false" if not defined $objects;
+
+    for my $obj (@{ $objects })
+    {
+        next if defined $main::OBJECT_TYPE_MAP{$obj};
+
+        LogError "unknown object type '$obj' on $attr";
+
+        return "false";
+    }
+
+    return join(" || ", map { "ot == (sai_object_type_t)$_" } @{ $objects });
+}
+
+sub CreateTraitsAccessors
+{
+    WriteTraits "/**";
+    WriteTraits " * \@brief Accessor of attribute value union member.";
+    WriteTraits " */";
+    WriteTraits "template <typename T, T sai_attribute_value_t::*M>";
+    WriteTraits "struct value_accessor";
+    WriteTraits "{";
+    WriteTraits "typedef T type;";
+    WriteTraits "";
+    WriteTraits "static constexpr T sai_attribute_value_t::*member = M;";
+    WriteTraits "";
+    WriteTraits "static const type& get(";
+    WriteTraits "        _In_ const sai_attribute_value_t& value)";
+    WriteTraits "{";
+    WriteTraits "return value.*M;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "static void set(";
+    WriteTraits "        _Inout_ sai_attribute_value_t& value,";
+    WriteTraits "        _In_ const type& data)";
+    WriteTraits "{";
+    WriteTraits "std::memcpy(&(value.*M), &data, sizeof(type));";
+    WriteTraits "}";
+    WriteTraits "};";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Accessor of enum attribute, stored in s32 member.";
+    WriteTraits " */";
+    WriteTraits "template <typename E>";
+    WriteTraits "struct enum_accessor";
+    WriteTraits "{";
+    WriteTraits "typedef E type;";
+    WriteTraits "";
+    WriteTraits "static constexpr sai_int32_t sai_attribute_value_t::*member = &sai_attribute_value_t::s32;";
+    WriteTraits "";
+    WriteTraits "static type get(";
+    WriteTraits "        _In_ const sai_attribute_value_t& value)";
+    WriteTraits "{";
+    WriteTraits "return static_cast<type>(value.s32);";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "static void set(";
+    WriteTraits "        _Inout_ sai_attribute_value_t& value,";
+    WriteTraits "        _In_ const type& data)";
+    WriteTraits "{";
+    WriteTraits "value.s32 = static_cast<sai_int32_t>(data);";
+    WriteTraits "}";
+    WriteTraits "};";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Accessor of char data attribute, set truncates string to member size.";
+    WriteTraits " */";
+    WriteTraits "struct chardata_accessor";
+    WriteTraits "{";
+    WriteTraits "typedef const char* type;";
+    WriteTraits "";
+    WriteTraits "static constexpr char (sai_attribute_value_t::*member)[32] = &sai_attribute_value_t::chardata;";
+    WriteTraits "";
+    WriteTraits "static type get(";
+    WriteTraits "        _In_ const sai_attribute_value_t& value)";
+    WriteTraits "{";
+    WriteTraits "return value.chardata;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "static void set(";
+    WriteTraits "        _Inout_ sai_attribute_value_t& value,";
+    WriteTraits "        _In_ const type& data)";
+    WriteTraits "{";
+    WriteTraits "std::strncpy(value.chardata, data, sizeof(value.chardata));";
+    WriteTraits "}";
+    WriteTraits "};";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Accessor of notification pointer attribute, stored in ptr member.";
+    WriteTraits " */";
+    WriteTraits "template <typename F>";
+    WriteTraits "struct pointer_accessor";
+    WriteTraits "{";
+    WriteTraits "typedef F type;";
+    WriteTraits "";
+    WriteTraits "static constexpr sai_pointer_t sai_attribute_value_t::*member = &sai_attribute_value_t::ptr;";
+    WriteTraits "";
+    WriteTraits "static type get(";
+    WriteTraits "        _In_ const sai_attribute_value_t& value)";
+    WriteTraits "{";
+    WriteTraits "return reinterpret_cast<type>(value.ptr);";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "static void set(";
+    WriteTraits "        _Inout_ sai_attribute_value_t& value,";
+    WriteTraits "        _In_ const type& data)";
+    WriteTraits "{";
+    WriteTraits "value.ptr = reinterpret_cast<sai_pointer_t>(data);";
+    WriteTraits "}";
+    WriteTraits "};";
+    WriteTraits "";
+}
+
+sub CreateSingleAttrTraits
+{
+    my ($attr, $ot, $typedef) = @_;
+
+    my %meta = %{ $main::METADATA{$typedef}{$attr} };
+
+    my $type = $meta{type};
+
+    my $accessor = GetTraitsAccessor($attr, $type);
+
+    return if $accessor eq "";
+
+    my $valuetype   = main::ProcessType($attr, $type);
+    my $flags       = main::ProcessFlags($attr, $meta{flags});
+    my $defvaltype  = main::ProcessDefaultValueType($attr, $meta{default});
+    my $isenum      = main::ProcessIsEnum($attr, $type);
+    my $isenumlist  = main::ProcessIsEnumList($attr, $type);
+    my $allownull   = (defined $meta{allownull}) ? $meta{allownull} : "false";
+    my $allowed     = GetTraitsAllowedObjectTypes($attr, $meta{objects});
+    my $defval      = GetTraitsDefaultValue($attr, $meta{default}, $type);
+    my $hasdefval   = (defined $defval) ? "true" : "false";
+    my $otparam     = (defined $meta{objects}) ? "sai_object_type_t ot" : "sai_object_type_t";
+    my $conditional = (defined $meta{condition}) ? "true" : "false";
+
+    WriteTraits "template <>";
+    WriteTraits "struct attr_traits<SAI_METADATA_ATTR($attr)>: $accessor";
+    WriteTraits "{";
+    WriteTraits "static constexpr sai_object_type_t object_type = (sai_object_type_t)$ot;";
+    WriteTraits "static constexpr sai_attr_id_t id = $attr;";
+    WriteTraits "static constexpr const char* name = \"$attr\";";
+    WriteTraits "static constexpr sai_attr_value_type_t value_type = $valuetype;";
+    WriteTraits "static constexpr sai_attr_flags_t flags = $flags;";
+    WriteTraits "static constexpr sai_default_value_type_t default_value_type = $defvaltype;";
+    WriteTraits "static constexpr bool is_enum = $isenum;";
+    WriteTraits "static constexpr bool is_enum_list = $isenumlist;";
+    WriteTraits "static constexpr bool allow_null = $allownull;";
+    WriteTraits "static constexpr bool is_conditional = $conditional;";
+    WriteTraits "static constexpr bool has_default_value = $hasdefval;";
+    WriteTraits "static constexpr type default_value() { return $defval; }" if defined $defval;
+    WriteTraits "static constexpr bool is_allowed_object_type($otparam) { return $allowed; }";
+    WriteTraits "};";
+    WriteTraits "";
+
+    push @TRAITS_ATTRS, $attr;
+}
+
+#
+# Attribute list builder of object type has room for every attribute which
+# can be passed to create or set, since each of them can be added only once.
+#
+
+sub CreateSingleObjectTraits
+{
+    my ($ot, $typedef) = @_;
+
+    my $settable = 0;
+    my $mandatory = 0;
+
+    for my $attr (@{ $main::SAI_ENUMS{$typedef}{values} })
+    {
+        my $meta = $main::METADATA{$typedef}{$attr};
+
+        next if not defined $meta or defined $meta->{ignore};
+
+        my $flags = "@{ $meta->{flags} }";
+
+        next if $flags =~ /READ_ONLY/;
+
+        $settable++;
+
+        $mandatory++ if $flags =~ /MANDATORY_ON_CREATE/ and not defined $meta->{condition};
+    }
+
+    WriteTraits "template <>";
+    WriteTraits "struct object_traits<(sai_object_type_t)$ot>";
+    WriteTraits "{";
+    WriteTraits "static constexpr uint32_t settable_attr_count = $settable;";
+    WriteTraits "static constexpr uint32_t mandatory_on_create_count = $mandatory;";
+    WriteTraits "};";
+    WriteTraits "";
+}
+
+sub CreateAttrTraitsSpecializations
+{
+    my @objects = @{ $main::SAI_ENUMS{sai_object_type_t}{values} };
+
+    for my $ot (@objects)
+    {
+        next if not $ot =~ /^SAI_OBJECT_TYPE_(\w+)$/;
+
+        my $typedef = "sai_" . lc($1) . "_attr_t";
+
+        next if not defined $main::SAI_ENUMS{$typedef};
+
+        for my $attr (@{ $main::SAI_ENUMS{$typedef}{values} })
+        {
+            next if not defined $main::METADATA{$typedef}{$attr};
+
+            next if defined $main::METADATA{$typedef}{$attr}{ignore};
+
+            CreateSingleAttrTraits($attr, $ot, $typedef);
+        }
+
+        CreateSingleObjectTraits($ot, $typedef);
+    }
+}
+
+sub CreateAttrTraitsFunctions
+{
+    WriteTraits "/**";
+    WriteTraits " * \@brief Gets typed value of attribute.";
+    WriteTraits " *";
+    WriteTraits " * Attribute id must match template argument.";
+    WriteTraits " */";
+    WriteTraits "template <typename T, T A>";
+    WriteTraits "auto get(";
+    WriteTraits "        _In_ const sai_attribute_t& attr) -> decltype(attr_traits<T, A>::get(attr.value))";
+    WriteTraits "{";
+    WriteTraits "typedef attr_traits<T, A> traits;";
+    WriteTraits "";
+    WriteTraits "assert(attr.id == traits::id);";
+    WriteTraits "";
+    WriteTraits "return traits::get(attr.value);";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Makes attribute from typed value.";
+    WriteTraits " *";
+    WriteTraits " * Read only attributes can't be passed to create or set, so they are";
+    WriteTraits " * rejected at compile time.";
+    WriteTraits " */";
+    WriteTraits "template <typename T, T A>";
+    WriteTraits "sai_attribute_t make(";
+    WriteTraits "        _In_ const typename attr_traits<T, A>::type& data)";
+    WriteTraits "{";
+    WriteTraits "typedef attr_traits<T, A> traits;";
+    WriteTraits "";
+    WriteTraits "static_assert(!SAI_HAS_FLAG_READ_ONLY(traits::flags), \"read only attribute can't be made\");";
+    WriteTraits "";
+    WriteTraits "sai_attribute_t attr = {};";
+    WriteTraits "";
+    WriteTraits "attr.id = traits::id;";
+    WriteTraits "";
+    WriteTraits "traits::set(attr.value, data);";
+    WriteTraits "";
+    WriteTraits "return attr;";
+    WriteTraits "}";
+    WriteTraits "";
+}
+
+sub CreateAttrListBuilder
+{
+    WriteTraits "/**";
+    WriteTraits " * \@brief Attribute list of object type OT built in place.";
+    WriteTraits " *";
+    WriteTraits " * Capacity is number of attributes of object type which are not read";
+    WriteTraits " * only, so list never allocates and can live on stack. Debug builds";
+    WriteTraits " * assert that attribute is not added twice, that create list has all";
+    WriteTraits " * mandatory on create attributes (except conditional ones) and that set";
+    WriteTraits " * list has no create only attribute.";
+    WriteTraits " */";
+    WriteTraits "template <sai_object_type_t OT>";
+    WriteTraits "class attr_list";
+    WriteTraits "{";
+    WriteTraits "public:";
+    WriteTraits "";
+    WriteTraits "static constexpr uint32_t capacity = object_traits<OT>::settable_attr_count;";
+    WriteTraits "";
+    WriteTraits "template <typename T, T A>";
+    WriteTraits "attr_list& set(";
+    WriteTraits "            _In_ const typename attr_traits<T, A>::type& data)";
+    WriteTraits "{";
+    WriteTraits "typedef attr_traits<T, A> traits;";
+    WriteTraits "";
+    WriteTraits "static_assert(traits::object_type == OT, \"attribute of other object type\");";
+    WriteTraits "";
+    WriteTraits "assert(m_count < capacity && find(traits::id) == nullptr);";
+    WriteTraits "";
+    WriteTraits "m_attrs[m_count++] = make<T, A>(data);";
+    WriteTraits "";
+    WriteTraits "m_mandatory += (SAI_HAS_FLAG_MANDATORY_ON_CREATE(traits::flags) && !traits::is_conditional);";
+    WriteTraits "m_create_only += SAI_HAS_FLAG_CREATE_ONLY(traits::flags);";
+    WriteTraits "";
+    WriteTraits "return *this;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "const sai_attribute_t* find(";
+    WriteTraits "            _In_ sai_attr_id_t id) const";
+    WriteTraits "{";
+    WriteTraits "for (uint32_t i = 0; i < m_count; i++)";
+    WriteTraits "{";
+    WriteTraits "if (m_attrs[i].id == id)";
+    WriteTraits "{";
+    WriteTraits "return &m_attrs[i];";
+    WriteTraits "}";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "return nullptr;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "const sai_attribute_t* create_list() const";
+    WriteTraits "{";
+    WriteTraits "assert(m_mandatory == object_traits<OT>::mandatory_on_create_count);";
+    WriteTraits "";
+    WriteTraits "return m_attrs;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "const sai_attribute_t* set_list() const";
+    WriteTraits "{";
+    WriteTraits "assert(m_create_only == 0);";
+    WriteTraits "";
+    WriteTraits "return m_attrs;";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "const sai_attribute_t* data() const { return m_attrs; }";
+    WriteTraits "";
+    WriteTraits "uint32_t count() const { return m_count; }";
+    WriteTraits "";
+    WriteTraits "void clear() { m_count = m_mandatory = m_create_only = 0; }";
+    WriteTraits "";
+    WriteTraits "private:";
+    WriteTraits "";
+    WriteTraits "sai_attribute_t m_attrs[capacity ? capacity : 1];";
+    WriteTraits "";
+    WriteTraits "uint32_t m_count = 0;";
+    WriteTraits "";
+    WriteTraits "uint32_t m_mandatory = 0;";
+    WriteTraits "";
+    WriteTraits "uint32_t m_create_only = 0;";
+    WriteTraits "};";
+    WriteTraits "";
+}
+
+sub CreateDeclareEveryAttrTraitsMacro
+{
+    WriteTraits "#define SAI_METADATA_DECLARE_EVERY_ATTR_TRAITS(SAI_USER_X_ATTR_MACRO) \\";
+
+    WriteTraits "    SAI_USER_X_ATTR_MACRO($_) \\" for @TRAITS_ATTRS;
+
+    WriteTraits "";
+}
+
+sub CreateAttrTraits
+{
+    WriteTraits "/* AUTOGENERATED FILE! DO NOT EDIT */";
+    WriteTraits "";
+    WriteTraits "#ifndef __SAI_METADATA_HPP__";
+    WriteTraits "#define __SAI_METADATA_HPP__";
+    WriteTraits "";
+    WriteTraits "#if __cplusplus < 201103L";
+    WriteTraits "#error \"saimetadata.hpp requires C++11\"";
+    WriteTraits "#endif";
+    WriteTraits "";
+    WriteTraits "#include <cassert>";
+    WriteTraits "#include <cstring>";
+    WriteTraits "";
+    WriteTraits "extern \"C\" {";
+    WriteTraits "#include \"saimetadata.h\"";
+    WriteTraits "}";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Template arguments of attribute A, its enum type and value.";
+    WriteTraits " *";
+    WriteTraits " * Attribute id enums of object types share values, so enum type is part";
+    WriteTraits " * of the key, like in get<SAI_METADATA_ATTR(SAI_PORT_ATTR_MTU)>(attr).";
+    WriteTraits " */";
+    WriteTraits "#define SAI_METADATA_ATTR(A) decltype(A), A";
+    WriteTraits "";
+    WriteTraits "namespace sai {";
+    WriteTraits "namespace metadata {";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Compile time metadata of attribute A of enum type T.";
+    WriteTraits " *";
+    WriteTraits " * Specialized for every attribute id enum value, so using anything else";
+    WriteTraits " * as template argument does not compile.";
+    WriteTraits " */";
+    WriteTraits "template <typename T, T A>";
+    WriteTraits "struct attr_traits;";
+    WriteTraits "";
+    WriteTraits "/**";
+    WriteTraits " * \@brief Compile time metadata of object type OT.";
+    WriteTraits " */";
+    WriteTraits "template <sai_object_type_t OT>";
+    WriteTraits "struct object_traits;";
+    WriteTraits "";
+
+    @TRAITS_ATTRS = ();
+
+    CreateTraitsAccessors();
+
+    CreateAttrTraitsSpecializations();
+
+    CreateAttrTraitsFunctions();
+
+    CreateAttrListBuilder();
+
+    WriteTraits "}";
+    WriteTraits "}";
+    WriteTraits "";
+
+    CreateDeclareEveryAttrTraitsMacro();
+
+    WriteTraits "#endif /* __SAI_METADATA_HPP__ */";
+}
+
+BEGIN
+{
+    our @ISA    = qw(Exporter);
+    our @EXPORT = qw/
+    CreateAttrTraits
+    /;
+}
+
+1;
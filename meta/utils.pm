@@ -41,6 +41,9 @@ our $HEADER_CONTENT = "";
 our $SOURCE_CONTENT = "";
 our $TEST_CONTENT = "";
 our $SWIG_CONTENT = "";
+our $TRACE_CONTENT = "";
+our $MOCK_CONTENT = "";
+our $TRAITS_CONTENT = "";
 
 my $identLevel = 0;
 
@@ -99,6 +102,45 @@ sub WriteSwig
     $SWIG_CONTENT .= $ident . $content . "\n";
 }
 
+sub WriteTrace
+{
+    my $content = shift;
+
+    my $ident = GetIdent($content);
+
+    my $line = $ident . $content . "\n";
+
+    $line = "\n" if $content eq "";
+
+    $TRACE_CONTENT .= $line;
+}
+
+sub WriteMock
+{
+    my $content = shift;
+
+    my $ident = GetIdent($content);
+
+    my $line = $ident . $content . "\n";
+
+    $line = "\n" if $content eq "";
+
+    $MOCK_CONTENT .= $line;
+}
+
+sub WriteTraits
+{
+    my $content = shift;
+
+    my $ident = GetIdent($content);
+
+    my $line = $ident . $content . "\n";
+
+    $line = "\n" if $content eq "";
+
+    $TRAITS_CONTENT .= $line;
+}
+
 sub WriteSourceSectionComment
 {
     my $content = shift;
@@ -388,6 +430,9 @@ sub WriteMetaDataFiles
     WriteFile("saimetadata.c", $SOURCE_CONTENT);
     WriteFile("saimetadatatest.c", $TEST_CONTENT);
     WriteFile("saiswig.i", $SWIG_CONTENT);
+    WriteFile("saitrace.c", $TRACE_CONTENT);
+    WriteFile("saimock.c", $MOCK_CONTENT);
+    WriteFile("saimetadata.hpp", $TRAITS_CONTENT);
 }
 
 sub GetStructKeysInOrder
@@ -631,7 +676,7 @@ BEGIN
     WriteFile GetHeaderFiles GetMetaHeaderFiles GetExperimentalHeaderFiles GetCustomHeaderFiles GetMetadataSourceFiles ReadHeaderFile GetMetaSourceFiles
     GetNonObjectIdStructNames GetNonObjectIdStructNamesWithBulkApi IsSpecialObject GetStructLists GetStructKeysInOrder
     Trim ExitOnErrors ExitOnErrorsOrWarnings ProcessEnumInitializers
-    WriteHeader WriteSource WriteTest WriteSwig WriteMetaDataFiles WriteSectionComment WriteSourceSectionComment
+    WriteHeader WriteSource WriteTest WriteSwig WriteTrace WriteMock WriteTraits WriteMetaDataFiles WriteSectionComment WriteSourceSectionComment
     $errors $warnings $NUMBER_REGEX
     $HEADER_CONTENT $SOURCE_CONTENT $TEST_CONTENT
     /;
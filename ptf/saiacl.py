@@ -6328,3 +6328,80 @@ class IngressL3AclDscpTest(SaiHelperSimplified):
 
             sai_thrift_remove_acl_entry(self.client, acl_entry_id)
             sai_thrift_remove_acl_table(self.client, acl_table_id)
+
+
+@group("draft")
+class AclBatchGetTest(SaiHelperSimplified):
+    """
+    Verify batch get of ACL entry attribute not supported by thrift
+    conversion fails only that operation, following operations still run
+    """
+    def runTest(self):
+        bind_point_list = [SAI_ACL_BIND_POINT_TYPE_PORT]
+
+        batch = sai_thrift_batch()
+
+        acl_table = batch.create(SAI_OBJECT_TYPE_ACL_TABLE, [
+            sai_thrift_attribute_t(
+                id=SAI_ACL_TABLE_ATTR_ACL_STAGE,
+                value=sai_thrift_attribute_value_t(s32=SAI_ACL_STAGE_INGRESS)),
+            sai_thrift_attribute_t(
+                id=SAI_ACL_TABLE_ATTR_ACL_BIND_POINT_TYPE_LIST,
+                value=sai_thrift_attribute_value_t(
+                    s32list=sai_thrift_s32_list_t(
+                        count=len(bind_point_list),
+                        int32list=bind_point_list))),
+            sai_thrift_attribute_t(
+                id=SAI_ACL_TABLE_ATTR_FIELD_SRC_IP,
+                value=sai_thrift_attribute_value_t(booldata=True))])
+
+        src_ip_t = sai_thrift_acl_field_data_t(
+            enable=True,
+            data=sai_thrift_acl_field_data_data_t(ip4='192.168.0.1'),
+            mask=sai_thrift_acl_field_data_mask_t(ip4='255.255.255.0'))
+
+        acl_entry = batch.create(SAI_OBJECT_TYPE_ACL_ENTRY, [
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_TABLE_ID,
+                value=sai_thrift_attribute_value_t(oid=0)),
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_PRIORITY,
+                value=sai_thrift_attribute_value_t(u32=10)),
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP,
+                value=sai_thrift_attribute_value_t(aclfield=src_ip_t))],
+            refs=[batch.ref(acl_table, attr_index=0)])
+
+        # ACL field data can't be converted back to thrift
+        batch.get(SAI_OBJECT_TYPE_ACL_ENTRY, 0, [
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_PRIORITY,
+                value=sai_thrift_attribute_value_t(u32=0)),
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP,
+                value=sai_thrift_attribute_value_t(
+                    aclfield=sai_thrift_acl_field_data_t()))],
+            refs=[batch.ref(acl_entry)])
+
+        batch.get(SAI_OBJECT_TYPE_ACL_ENTRY, 0, [
+            sai_thrift_attribute_t(
+                id=SAI_ACL_ENTRY_ATTR_PRIORITY,
+                value=sai_thrift_attribute_value_t(u32=0))],
+            refs=[batch.ref(acl_entry)])
+
+        batch.remove(SAI_OBJECT_TYPE_ACL_ENTRY, 0,
+                     refs=[batch.ref(acl_entry)])
+        batch.remove(SAI_OBJECT_TYPE_ACL_TABLE, 0,
+                     refs=[batch.ref(acl_table)])
+
+        results = batch.execute(self.client, stop_on_error=False)
+
+        self.assertEqual(len(results), 6)
+        self.assertEqual(results[0].status, SAI_STATUS_SUCCESS)
+        self.assertEqual(results[1].status, SAI_STATUS_SUCCESS)
+        self.assertEqual(results[2].status, SAI_STATUS_NOT_SUPPORTED)
+        self.assertEqual(len(results[2].attr_list), 0)
+        self.assertEqual(results[3].status, SAI_STATUS_SUCCESS)
+        self.assertEqual(results[3].attr_list[0].value.u32, 10)
+        self.assertEqual(results[4].status, SAI_STATUS_SUCCESS)
+        self.assertEqual(results[5].status, SAI_STATUS_SUCCESS)
@@ -246,7 +246,12 @@ class ThriftInterface(BaseTest):
         else:
             server = 'localhost'
 
-        self.transport = TSocket.TSocket(server, THRIFT_PORT)
+        if 'thrift_unix_socket' in self.test_params:
+            # RPC server started with --unix-socket on the same host
+            self.transport = TSocket.TSocket(
+                unix_socket=self.test_params['thrift_unix_socket'])
+        else:
+            self.transport = TSocket.TSocket(server, THRIFT_PORT)
         self.transport = TTransport.TBufferedTransport(self.transport)
         self.protocol = TBinaryProtocol.TBinaryProtocol(self.transport)
         self.client = sai_rpc.Client(self.protocol)
@@ -22,6 +22,8 @@
 #include <arpa/inet.h>
 #include "switch_sai_rpc.h"
 #include "switch_sai_rpc_server.h"
+#include "switch_sai_notification_queue.h"
+#include "switch_sai_fdb_table.h"
 
 #define UNREFERENCED_PARAMETER(P)   (P)
 
@@ -38,103 +40,85 @@ sai_switch_api_t* sai_switch_api;
 std::map<std::string, std::string> gProfileMap;
 std::map<std::set<int>, std::string> gPortMap;
 
-extern std::vector<std::pair<sai_fdb_entry_t, sai_object_id_t>> gFdbMap;
-
 sai_object_id_t gSwitchId; ///< SAI switch global object ID.
 
 void on_switch_state_change(_In_ sai_object_id_t switch_id,
                             _In_ sai_switch_oper_status_t switch_oper_status)//
 {
+    gNotificationQueue.push(SWITCH_SAI_NOTIFICATION_SWITCH_STATE_CHANGE,
+                            switch_oper_status, switch_id, NULL);
 }
 
 void on_fdb_event(_In_ uint32_t count,
                   _In_ sai_fdb_event_notification_data_t *data)
 {
-    sai_fdb_event_t event_type;
-    sai_fdb_entry_t fdb_entry;
-    uint32_t attr_count;
-    sai_attribute_t *attr;
-    sai_object_id_t bv_id;
-    sai_object_id_t bport_id;
-    
-    attr = data->attr;
-    event_type = data->event_type;
-    fdb_entry = data->fdb_entry;
-    bv_id = fdb_entry.bv_id;
-    attr_count = data ->attr_count;
-    
-    for (uint32_t i = 0; i < attr_count; i++)
+    for (uint32_t idx = 0; idx < count; idx++)
     {
-        if (attr[i].id == SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID)
-            bport_id = attr[i].value.oid;
-    }
-           
-    sai_fdb_entry_t fdb_m;
-    sai_object_id_t b_id;
-      
-    switch (event_type)
-    {   
-        case SAI_FDB_EVENT_LEARNED:
-            gFdbMap.emplace_back(std::pair<sai_fdb_entry_t, sai_object_id_t>(fdb_entry,bport_id));
-            break;
-        case SAI_FDB_EVENT_FLUSHED: 
-            if (bv_id == 0 && bport_id == 0)
-                gFdbMap.clear();
-            else
-            {
-                for (auto it = gFdbMap.begin(); it != gFdbMap.end(); )
-                {
-                    fdb_m = it->first;
-                    b_id = it->second; 				
-	            
-                    if (bport_id == 0 && bv_id == fdb_m.bv_id)
-                        it = gFdbMap.erase(it);
-                    else if (bv_id == 0 && bport_id == b_id)
-                        it = gFdbMap.erase(it);
-                    else if (bv_id == fdb_m.bv_id && bport_id == b_id)
-                        it = gFdbMap.erase(it);
-                    else
-                        it++;
-                }
-            }
-            break;
-        case SAI_FDB_EVENT_MOVE:
-            for (auto it = gFdbMap.begin(); it != gFdbMap.end(); it++)
-            {
-                fdb_m = it->first;
-                b_id = it->second; 
-                int n = memcmp ( fdb_entry.mac_address, fdb_m.mac_address, 6);
-		    
-                if (n == 0 && bv_id == fdb_m.bv_id)
-                    it->second = bport_id;
-            }
-            break;  
-        case SAI_FDB_EVENT_AGED:
-            for (auto it = gFdbMap.begin(); it != gFdbMap.end(); )
-            {
-                fdb_m = it->first;
-                b_id = it->second; 
-                int n = memcmp ( fdb_entry.mac_address, fdb_m.mac_address, 6);  
-                
-                if (n == 0 && bv_id == fdb_m.bv_id)
-                    it = gFdbMap.erase(it);   
-                else
-                    it++; 	
-            }
-            break;
-        default:
-            printf("unknown event");
-            break;
+        sai_fdb_event_t event_type;
+        sai_fdb_entry_t fdb_entry;
+        uint32_t attr_count;
+        sai_attribute_t *attr;
+        sai_object_id_t bv_id;
+        sai_object_id_t bport_id = SAI_NULL_OBJECT_ID;
+
+        attr = data[idx].attr;
+        event_type = data[idx].event_type;
+        fdb_entry = data[idx].fdb_entry;
+        bv_id = fdb_entry.bv_id;
+        attr_count = data[idx].attr_count;
+
+        for (uint32_t i = 0; i < attr_count; i++)
+        {
+            if (attr[i].id == SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID)
+                bport_id = attr[i].value.oid;
+        }
+
+        switch (event_type)
+        {
+            case SAI_FDB_EVENT_LEARNED:
+                gFdbTable.learn(fdb_entry, bport_id);
+                break;
+            case SAI_FDB_EVENT_FLUSHED:
+                gFdbTable.flush(bv_id, bport_id);
+                break;
+            case SAI_FDB_EVENT_MOVE:
+                gFdbTable.move(fdb_entry, bport_id);
+                break;
+            case SAI_FDB_EVENT_AGED:
+                gFdbTable.age(fdb_entry);
+                break;
+            default:
+                printf("unknown event");
+                continue;
+        }
+
+        gNotificationQueue.push(SWITCH_SAI_NOTIFICATION_FDB_EVENT, event_type, bport_id, &fdb_entry);
     }
-}     
+}
 
 void on_port_state_change(_In_ uint32_t count,
                           _In_ sai_port_oper_status_notification_t *data)
 {
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        gNotificationQueue.push(SWITCH_SAI_NOTIFICATION_PORT_STATE_CHANGE,
+                                data[idx].port_state, data[idx].port_id, NULL);
+    }
+}
+
+void on_bfd_session_state_change(_In_ uint32_t count,
+                                 _In_ const sai_bfd_session_state_notification_t *data)
+{
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        gNotificationQueue.push(SWITCH_SAI_NOTIFICATION_BFD_SESSION_STATE,
+                                data[idx].session_state, data[idx].bfd_session_id, NULL);
+    }
 }
 
 void on_shutdown_request(_In_ sai_object_id_t switch_id)//
 {
+    gNotificationQueue.push(SWITCH_SAI_NOTIFICATION_SWITCH_SHUTDOWN, 0, switch_id, NULL);
 }
 
 void on_packet_event(_In_ sai_object_id_t switch_id,
@@ -241,6 +225,7 @@ struct cmdOptions
     std::string profileMapFile;
     std::string portMapFile;
     std::string initScript;
+    std::string unixSocket;
 };
 
 cmdOptions handleCmdLine(int argc, char **argv)
@@ -255,12 +240,13 @@ cmdOptions handleCmdLine(int argc, char **argv)
             { "profile",          required_argument, 0, 'p' },
             { "portmap",          required_argument, 0, 'f' },
             { "init-script",      required_argument, 0, 'S' },
+            { "unix-socket",      required_argument, 0, 'u' },
             { 0,                  0,                 0,  0  }
         };
 
         int option_index = 0;
 
-        int c = getopt_long(argc, argv, "p:f:S:", long_options, &option_index);
+        int c = getopt_long(argc, argv, "p:f:S:u:", long_options, &option_index);
 
         if (c == -1)
             break;
@@ -282,6 +268,11 @@ cmdOptions handleCmdLine(int argc, char **argv)
                 options.initScript = std::string(optarg);
                 break;
 
+            case 'u':
+                printf("rpc unix socket: %s\n", optarg);
+                options.unixSocket = std::string(optarg);
+                break;
+
             default:
                 printf("getopt_long failure\n");
                 exit(EXIT_FAILURE);
@@ -452,6 +443,15 @@ main(int argc, char* argv[])
         printf("Warn: Failed to set_switch_attribute SAI_SWITCH_ATTR_PACKET_EVENT_NOTIFY : %d \n", status);
     }
 
+    sai_attribute_t attr_bfd;
+    attr_bfd.id = SAI_SWITCH_ATTR_BFD_SESSION_STATE_CHANGE_NOTIFY;
+    attr_bfd.value.ptr = reinterpret_cast<sai_pointer_t>(&on_bfd_session_state_change);
+    status = sai_switch_api->set_switch_attribute(gSwitchId, &attr_bfd);
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        printf("Warn: Failed to set_switch_attribute SAI_SWITCH_ATTR_BFD_SESSION_STATE_CHANGE_NOTIFY : %d \n", status);
+    }
+
     handleInitScript(options.initScript);
 
 #ifdef BRCMSAI
@@ -459,7 +459,14 @@ main(int argc, char* argv[])
     bcm_diag_shell_thread.detach();
 #endif
 
-    start_sai_thrift_rpc_server(SWITCH_SAI_THRIFT_RPC_SERVER_PORT);
+    if (options.unixSocket.size())
+    {
+        start_sai_thrift_rpc_server_unix(options.unixSocket.c_str());
+    }
+    else
+    {
+        start_sai_thrift_rpc_server(SWITCH_SAI_THRIFT_RPC_SERVER_PORT);
+    }
 
     const sai_log_level_t log_level = SAI_LOG_LEVEL_NOTICE;
 
@@ -218,6 +218,26 @@ struct sai_thrift_result_t {
     2: sai_thrift_status_t status;
 }
 
+const i32 SAI_THRIFT_NOTIFICATION_FDB_EVENT = 1
+const i32 SAI_THRIFT_NOTIFICATION_PORT_STATE_CHANGE = 2
+const i32 SAI_THRIFT_NOTIFICATION_SWITCH_STATE_CHANGE = 3
+const i32 SAI_THRIFT_NOTIFICATION_SWITCH_SHUTDOWN = 4
+const i32 SAI_THRIFT_NOTIFICATION_BFD_SESSION_STATE = 5
+
+struct sai_thrift_notification_t {
+    1: i64 seq;
+    2: i32 type;
+    3: i32 event;
+    4: sai_thrift_object_id_t oid;
+    5: sai_thrift_fdb_entry_t fdb_entry;
+}
+
+struct sai_thrift_notification_batch_t {
+    1: list<sai_thrift_notification_t> notifications;
+    2: i64 last_seq;    // sequence number to pass on next call
+    3: i64 lost;        // notifications dropped since requested seq, client must resync
+}
+
 service switch_sai_rpc {
     //port API
     sai_thrift_status_t sai_thrift_set_port_attribute(1: sai_thrift_object_id_t port_id, 2: sai_thrift_attribute_t thrift_attr);
@@ -234,6 +254,9 @@ service switch_sai_rpc {
     sai_thrift_status_t sai_thrift_flush_fdb_entries(1: list <sai_thrift_attribute_t> thrift_attr_list);
     sai_thrift_attribute_list_t sai_thrift_get_fdb_entries();
 
+    //notification API
+    sai_thrift_notification_batch_t sai_thrift_get_notifications(1: i64 last_seq, 2: i32 max_count, 3: i32 timeout_ms);
+
     //vlan API
     sai_thrift_object_id_t sai_thrift_create_vlan(1: list<sai_thrift_attribute_t> thrift_attr_list);
     sai_thrift_status_t sai_thrift_remove_vlan(1: sai_thrift_object_id_t vlan_oid);
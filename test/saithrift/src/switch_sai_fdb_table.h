@@ -0,0 +1,313 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __SWITCH_SAI_FDB_TABLE_H_
+#define __SWITCH_SAI_FDB_TABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+extern "C" {
+#include "sai.h"
+}
+
+/*
+ * Primary key of the shadow FDB table. Only one switch is managed by the
+ * server, so switch_id of the FDB entry is not part of the key.
+ */
+struct switch_sai_fdb_key_t
+{
+    sai_mac_t mac_address;
+    sai_object_id_t bv_id;
+
+    bool operator==(const switch_sai_fdb_key_t &other) const
+    {
+        return bv_id == other.bv_id &&
+               memcmp(mac_address, other.mac_address, sizeof(sai_mac_t)) == 0;
+    }
+};
+
+struct switch_sai_fdb_key_hash_t
+{
+    size_t operator()(const switch_sai_fdb_key_t &key) const
+    {
+        uint64_t mac = 0;
+
+        memcpy(&mac, key.mac_address, sizeof(sai_mac_t));
+
+        // mix MAC and bv_id, bv_id object ids differ mostly in low bits
+        uint64_t h = (mac ^ (key.bv_id * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+/*
+ * Learned FDB entry. Besides being stored in the primary hash, every entry
+ * is linked into two intrusive lists: entries of the same bridge port and
+ * entries of the same bv_id (VLAN or bridge). Flush by port or by bv_id
+ * then visits only the matching entries.
+ */
+struct switch_sai_fdb_node_t
+{
+    sai_fdb_entry_t fdb_entry;
+    sai_object_id_t bport_id;
+
+    switch_sai_fdb_node_t *bport_prev;
+    switch_sai_fdb_node_t *bport_next;
+    switch_sai_fdb_node_t *bv_prev;
+    switch_sai_fdb_node_t *bv_next;
+};
+
+/*
+ * Shadow of the learned FDB table, updated from on_fdb_event() (SAI
+ * notification thread) and read by sai_thrift_get_fdb_entries() (RPC
+ * thread).
+ *
+ * Learn, move and age are O(1), flush is O(matching entries). Nodes live
+ * inside the unordered_map, whose element addresses are stable across
+ * rehashing, so the intrusive links stay valid.
+ */
+class switch_sai_fdb_table_t
+{
+public:
+
+    /*
+     * Add learned entry, or update its bridge port if already present.
+     */
+    void learn(
+            _In_ const sai_fdb_entry_t &fdb_entry,
+            _In_ sai_object_id_t bport_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto res = m_entries.emplace(make_key(fdb_entry), switch_sai_fdb_node_t());
+
+        switch_sai_fdb_node_t &node = res.first->second;
+
+        if (!res.second)
+        {
+            set_bport(node, bport_id);
+            return;
+        }
+
+        node.fdb_entry = fdb_entry;
+        node.bport_id = bport_id;
+
+        link(m_bport_heads[bport_id], node, &switch_sai_fdb_node_t::bport_prev, &switch_sai_fdb_node_t::bport_next);
+        link(m_bv_heads[fdb_entry.bv_id], node, &switch_sai_fdb_node_t::bv_prev, &switch_sai_fdb_node_t::bv_next);
+    }
+
+    /*
+     * Entry moved to another bridge port, unknown entry is learned.
+     */
+    void move(
+            _In_ const sai_fdb_entry_t &fdb_entry,
+            _In_ sai_object_id_t bport_id)
+    {
+        learn(fdb_entry, bport_id);
+    }
+
+    void age(
+            _In_ const sai_fdb_entry_t &fdb_entry)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_entries.find(make_key(fdb_entry));
+
+        if (it != m_entries.end())
+        {
+            erase(it);
+        }
+    }
+
+    /*
+     * Flush entries matching bv_id and/or bridge port, NULL object id
+     * matches any value. Returns number of removed entries.
+     */
+    size_t flush(
+            _In_ sai_object_id_t bv_id,
+            _In_ sai_object_id_t bport_id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        size_t count = m_entries.size();
+
+        if (bv_id == SAI_NULL_OBJECT_ID && bport_id == SAI_NULL_OBJECT_ID)
+        {
+            m_entries.clear();
+            m_bport_heads.clear();
+            m_bv_heads.clear();
+
+            return count;
+        }
+
+        // walk the list selected by the more specific key
+        bool by_bport = (bport_id != SAI_NULL_OBJECT_ID);
+
+        auto &heads = by_bport ? m_bport_heads : m_bv_heads;
+
+        auto head = heads.find(by_bport ? bport_id : bv_id);
+
+        if (head == heads.end())
+        {
+            return 0;
+        }
+
+        switch_sai_fdb_node_t *node = head->second;
+
+        while (node)
+        {
+            switch_sai_fdb_node_t *next = by_bport ? node->bport_next : node->bv_next;
+
+            if (bv_id == SAI_NULL_OBJECT_ID || node->fdb_entry.bv_id == bv_id)
+            {
+                // may invalidate 'head', but 'next' stays valid
+                erase(m_entries.find(make_key(node->fdb_entry)));
+            }
+
+            node = next;
+        }
+
+        return count - m_entries.size();
+    }
+
+    /*
+     * Call visitor(fdb_entry, bport_id) for every entry, in place and under
+     * the table lock, so visitor must not call back into the table.
+     */
+    template <typename Visitor>
+    void for_each(
+            _In_ Visitor visitor)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto &it: m_entries)
+        {
+            visitor(it.second.fdb_entry, it.second.bport_id);
+        }
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_entries.size();
+    }
+
+private:
+
+    typedef std::unordered_map<switch_sai_fdb_key_t, switch_sai_fdb_node_t, switch_sai_fdb_key_hash_t> entries_t;
+
+    typedef std::unordered_map<sai_object_id_t, switch_sai_fdb_node_t *> heads_t;
+
+    typedef switch_sai_fdb_node_t *switch_sai_fdb_node_t::*link_t;
+
+    static switch_sai_fdb_key_t make_key(
+            _In_ const sai_fdb_entry_t &fdb_entry)
+    {
+        switch_sai_fdb_key_t key;
+
+        memcpy(key.mac_address, fdb_entry.mac_address, sizeof(sai_mac_t));
+        key.bv_id = fdb_entry.bv_id;
+
+        return key;
+    }
+
+    static void link(
+            _Inout_ switch_sai_fdb_node_t *&head,
+            _Inout_ switch_sai_fdb_node_t &node,
+            _In_ link_t prev,
+            _In_ link_t next)
+    {
+        node.*prev = nullptr;
+        node.*next = head;
+
+        if (head)
+        {
+            head->*prev = &node;
+        }
+
+        head = &node;
+    }
+
+    static void unlink(
+            _Inout_ heads_t &heads,
+            _In_ sai_object_id_t key,
+            _Inout_ switch_sai_fdb_node_t &node,
+            _In_ link_t prev,
+            _In_ link_t next)
+    {
+        if (node.*prev)
+        {
+            node.*prev->*next = node.*next;
+        }
+        else if (node.*next)
+        {
+            heads[key] = node.*next;
+        }
+        else
+        {
+            heads.erase(key);
+        }
+
+        if (node.*next)
+        {
+            node.*next->*prev = node.*prev;
+        }
+    }
+
+    void set_bport(
+            _Inout_ switch_sai_fdb_node_t &node,
+            _In_ sai_object_id_t bport_id)
+    {
+        if (node.bport_id == bport_id)
+        {
+            return;
+        }
+
+        unlink(m_bport_heads, node.bport_id, node, &switch_sai_fdb_node_t::bport_prev, &switch_sai_fdb_node_t::bport_next);
+
+        node.bport_id = bport_id;
+
+        link(m_bport_heads[bport_id], node, &switch_sai_fdb_node_t::bport_prev, &switch_sai_fdb_node_t::bport_next);
+    }
+
+    void erase(
+            _In_ entries_t::iterator it)
+    {
+        switch_sai_fdb_node_t &node = it->second;
+
+        unlink(m_bport_heads, node.bport_id, node, &switch_sai_fdb_node_t::bport_prev, &switch_sai_fdb_node_t::bport_next);
+        unlink(m_bv_heads, node.fdb_entry.bv_id, node, &switch_sai_fdb_node_t::bv_prev, &switch_sai_fdb_node_t::bv_next);
+
+        m_entries.erase(it);
+    }
+
+    entries_t m_entries;
+
+    heads_t m_bport_heads;
+
+    heads_t m_bv_heads;
+
+    std::mutex m_mutex;
+};
+
+extern switch_sai_fdb_table_t gFdbTable;
+
+#endif // __SWITCH_SAI_FDB_TABLE_H_
@@ -0,0 +1,151 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef __SWITCH_SAI_NOTIFICATION_QUEUE_H_
+#define __SWITCH_SAI_NOTIFICATION_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+}
+
+/*
+ * Notification kinds carried by the stream, must be kept in sync with
+ * SAI_THRIFT_NOTIFICATION_* constants in switch_sai.thrift.
+ */
+enum switch_sai_notification_type_t
+{
+    SWITCH_SAI_NOTIFICATION_FDB_EVENT           = 1,
+    SWITCH_SAI_NOTIFICATION_PORT_STATE_CHANGE   = 2,
+    SWITCH_SAI_NOTIFICATION_SWITCH_STATE_CHANGE = 3,
+    SWITCH_SAI_NOTIFICATION_SWITCH_SHUTDOWN     = 4,
+    SWITCH_SAI_NOTIFICATION_BFD_SESSION_STATE   = 5,
+};
+
+/*
+ * Single decoded notification. SAI callbacks hand over pointers which are
+ * only valid during the callback, so everything needed by the client is
+ * copied here by value.
+ */
+struct switch_sai_notification_t
+{
+    uint64_t seq;
+    switch_sai_notification_type_t type;
+    int32_t event;                  // fdb event / port, switch or bfd state
+    sai_object_id_t oid;            // port, switch, bfd session or bridge port
+    sai_fdb_entry_t fdb_entry;      // valid for FDB events only
+};
+
+/*
+ * Bounded notification log shared between SAI callback threads (producers)
+ * and the RPC server thread (consumer).
+ *
+ * Every notification gets a monotonically increasing sequence number.
+ * Entries are not removed when read, so any number of clients can follow
+ * the stream by remembering the last sequence number they have seen. When
+ * the log is full the oldest entry is overwritten; a client which falls
+ * behind detects the gap from the first returned sequence number and should
+ * resynchronize from a full snapshot (e.g. sai_thrift_get_fdb_entries).
+ *
+ * Producers never block on a consumer, the lock is held only for the copy.
+ */
+class switch_sai_notification_queue_t
+{
+public:
+
+    explicit switch_sai_notification_queue_t(size_t capacity) :
+        m_ring(capacity),
+        m_next_seq(1)
+    {
+    }
+
+    void push(
+            _In_ switch_sai_notification_type_t type,
+            _In_ int32_t event,
+            _In_ sai_object_id_t oid,
+            _In_ const sai_fdb_entry_t *fdb_entry)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            switch_sai_notification_t &n = m_ring[m_next_seq % m_ring.size()];
+
+            n.seq = m_next_seq++;
+            n.type = type;
+            n.event = event;
+            n.oid = oid;
+
+            if (fdb_entry)
+                n.fdb_entry = *fdb_entry;
+            else
+                memset(&n.fdb_entry, 0, sizeof(n.fdb_entry));
+        }
+
+        m_cv.notify_all();
+    }
+
+    /*
+     * Copy up to max_count notifications with sequence number greater than
+     * last_seq into out. If nothing is available, wait up to timeout_ms for
+     * new notifications. Returns sequence number of the oldest notification
+     * still held by the log, so the caller can tell whether it lost any.
+     */
+    uint64_t read(
+            _In_ uint64_t last_seq,
+            _In_ size_t max_count,
+            _In_ int32_t timeout_ms,
+            _Out_ std::vector<switch_sai_notification_t> &out)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (timeout_ms > 0 && last_seq + 1 >= m_next_seq)
+        {
+            m_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                    [&]{ return last_seq + 1 < m_next_seq; });
+        }
+
+        uint64_t oldest = (m_next_seq > m_ring.size()) ? m_next_seq - m_ring.size() : 1;
+
+        uint64_t seq = (last_seq + 1 > oldest) ? last_seq + 1 : oldest;
+
+        for (; seq < m_next_seq && out.size() < max_count; seq++)
+        {
+            out.push_back(m_ring[seq % m_ring.size()]);
+        }
+
+        return oldest;
+    }
+
+private:
+
+    std::vector<switch_sai_notification_t> m_ring;
+
+    uint64_t m_next_seq;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_cv;
+};
+
+extern switch_sai_notification_queue_t gNotificationQueue;
+
+#endif // __SWITCH_SAI_NOTIFICATION_QUEUE_H_
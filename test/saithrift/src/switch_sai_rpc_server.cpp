@@ -30,15 +30,19 @@ limitations under the License.
 #include <vector>
 
 #include <iomanip>
+#include <algorithm>
 
 #include <iostream>
 #include <string>
 #include "switch_sai_rpc.h"
+#include "switch_sai_notification_queue.h"
+#include "switch_sai_fdb_table.h"
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/server/TSimpleServer.h>
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <arpa/inet.h>
+#include <unistd.h>
 
 #include <inttypes.h>
 
@@ -87,7 +91,15 @@ extern sai_object_id_t gSwitchId;
 
 typedef std::vector<sai_thrift_attribute_t> std_sai_thrift_attr_vctr_t;
 
-std::vector<std::pair<sai_fdb_entry_t, sai_object_id_t>>gFdbMap;
+switch_sai_fdb_table_t gFdbTable;
+
+#define SAI_THRIFT_NOTIFICATION_QUEUE_SIZE 65536
+#define SAI_THRIFT_NOTIFICATION_MAX_BATCH 4096
+
+// server is single threaded, a waiting client blocks every other client
+#define SAI_THRIFT_NOTIFICATION_MAX_TIMEOUT_MS 200
+
+switch_sai_notification_queue_t gNotificationQueue(SAI_THRIFT_NOTIFICATION_QUEUE_SIZE);
 
 class switch_sai_rpcHandler : virtual public switch_sai_rpcIf {
 public:
@@ -128,7 +140,7 @@ public:
       return (j == 12);
   }
 
-  const std::string mac_to_sai_thrift_string(uint8_t m[6]){
+  const std::string mac_to_sai_thrift_string(const uint8_t m[6]){
       char macstr[32];
       sprintf(macstr, "%02x:%02x:%02x:%02x:%02x:%02x", m[0], m[1], m[2], m[3], m[4], m[5]);
       return(macstr);
@@ -769,32 +781,53 @@ public:
   }
 //listing all the fdb entries from map
   void sai_thrift_get_fdb_entries (sai_thrift_attribute_list_t& thrift_attr_list){
-      sai_mac_t mac_address;
-      sai_object_id_t bv_id;
-      sai_object_id_t bport_id;
-      sai_fdb_entry_t fdb_entry;
+      thrift_attr_list.attr_list.reserve(gFdbTable.size());
 
-      thrift_attr_list.attr_count = gFdbMap.size();
+      gFdbTable.for_each([&](const sai_fdb_entry_t &fdb_entry, sai_object_id_t bport_id) {
+          sai_thrift_attribute_t thrift_fdb_attributes;
+          thrift_fdb_attributes.id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
+          thrift_fdb_attributes.value.fdb_values.bport_id = bport_id;
+          thrift_fdb_attributes.value.fdb_values.thrift_fdb_entry.bv_id = fdb_entry.bv_id;
+          thrift_fdb_attributes.value.fdb_values.thrift_fdb_entry.mac_address = mac_to_sai_thrift_string(fdb_entry.mac_address);
 
-      sai_fdb_entry_t fdb_m;
-      sai_object_id_t b_id;
+          thrift_attr_list.attr_list.push_back(thrift_fdb_attributes);
+      });
 
-      for (auto it = gFdbMap.begin(); it != gFdbMap.end(); it++){
-          fdb_m = it->first;
-          b_id = it->second;
+      thrift_attr_list.attr_count = thrift_attr_list.attr_list.size();
+      return;
+  }
 
-          sai_thrift_fdb_values_t fdb_value;
-          fdb_value.bport_id=b_id;
-          fdb_value.thrift_fdb_entry.bv_id=fdb_m.bv_id;
-          fdb_value.thrift_fdb_entry.mac_address=mac_to_sai_thrift_string(fdb_m.mac_address);
+//streaming notifications collected by the SAI callbacks, see switch_sai_notification_queue.h
+  void sai_thrift_get_notifications(sai_thrift_notification_batch_t& batch, const int64_t last_seq, const int32_t max_count, const int32_t timeout_ms) {
+      std::vector<switch_sai_notification_t> notifications;
 
-          sai_thrift_attribute_t thrift_fdb_attributes;
-          thrift_fdb_attributes.id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
-          thrift_fdb_attributes.value.fdb_values = fdb_value;
+      size_t count = (max_count <= 0 || max_count > SAI_THRIFT_NOTIFICATION_MAX_BATCH) ?
+                     SAI_THRIFT_NOTIFICATION_MAX_BATCH : (size_t)max_count;
 
-          thrift_attr_list.attr_list.push_back(thrift_fdb_attributes);
+      int32_t timeout = std::min(timeout_ms, (int32_t)SAI_THRIFT_NOTIFICATION_MAX_TIMEOUT_MS);
+
+      uint64_t requested = (last_seq < 0) ? 0 : (uint64_t)last_seq;
+
+      uint64_t oldest = gNotificationQueue.read(requested, count, timeout, notifications);
+
+      batch.lost = (oldest > requested + 1) ? (int64_t)(oldest - requested - 1) : 0;
+      batch.last_seq = notifications.empty() ? (int64_t)std::max(requested, oldest - 1) : (int64_t)notifications.back().seq;
+
+      for (auto it = notifications.begin(); it != notifications.end(); it++){
+          sai_thrift_notification_t thrift_notification;
+
+          thrift_notification.seq = it->seq;
+          thrift_notification.type = it->type;
+          thrift_notification.event = it->event;
+          thrift_notification.oid = it->oid;
+
+          if (it->type == SWITCH_SAI_NOTIFICATION_FDB_EVENT) {
+              thrift_notification.fdb_entry.bv_id = it->fdb_entry.bv_id;
+              thrift_notification.fdb_entry.mac_address = mac_to_sai_thrift_string(it->fdb_entry.mac_address);
+          }
+
+          batch.notifications.push_back(thrift_notification);
       }
-      return;
   }
 
   void sai_thrift_parse_vlan_attributes(const std_sai_thrift_attr_vctr_t &thrift_attr_list, sai_attribute_t *attr_list) {
@@ -4371,11 +4404,28 @@ public:
     }
 };
 
+/*
+ * RPC server listens either on TCP port or, if unix_socket is set, on
+ * AF_UNIX socket at that path (avoids TCP loopback for local clients).
+ */
+struct switch_sai_thrift_rpc_server_param_t {
+  int port;
+  std::string unix_socket;
+};
+
 static void * switch_sai_thrift_rpc_server_thread(void *arg) {
-  int port = *(int *) arg;
+  switch_sai_thrift_rpc_server_param_t *param = (switch_sai_thrift_rpc_server_param_t *) arg;
+  shared_ptr<TServerSocket> socket;
+  if (param->unix_socket.empty()) {
+    socket.reset(new TServerSocket(param->port));
+  } else {
+    // remove stale socket left by previous server instance
+    unlink(param->unix_socket.c_str());
+    socket.reset(new TServerSocket(param->unix_socket));
+  }
   shared_ptr<switch_sai_rpcHandler> handler(new switch_sai_rpcHandler());
   shared_ptr<TProcessor> processor(new switch_sai_rpcProcessor(handler));
-  shared_ptr<TServerTransport> serverTransport(new TServerSocket(port));
+  shared_ptr<TServerTransport> serverTransport(socket);
   shared_ptr<TTransportFactory> transportFactory(new TBufferedTransportFactory());
   shared_ptr<TProtocolFactory> protocolFactory(new TBinaryProtocolFactory());
 
@@ -4388,13 +4438,9 @@ static pthread_t switch_sai_thrift_rpc_thread;
 
 extern "C" {
 
-int start_sai_thrift_rpc_server(int port)
+static int switch_sai_thrift_rpc_server_start(switch_sai_thrift_rpc_server_param_t *param)
 {
-    static int param = port;
-
-    std::cerr << "Starting SAI RPC server on port " << port << std::endl;
-
-    int rc = pthread_create(&switch_sai_thrift_rpc_thread, NULL, switch_sai_thrift_rpc_server_thread, &param);
+    int rc = pthread_create(&switch_sai_thrift_rpc_thread, NULL, switch_sai_thrift_rpc_server_thread, param);
     std::cerr << "create pthread switch_sai_thrift_rpc_server_thread result " << rc << std::endl;
 
     rc = pthread_detach(switch_sai_thrift_rpc_thread);
@@ -4402,4 +4448,27 @@ int start_sai_thrift_rpc_server(int port)
 
     return rc;
 }
+
+int start_sai_thrift_rpc_server(int port)
+{
+    static switch_sai_thrift_rpc_server_param_t param;
+
+    param.port = port;
+
+    std::cerr << "Starting SAI RPC server on port " << port << std::endl;
+
+    return switch_sai_thrift_rpc_server_start(&param);
+}
+
+int start_sai_thrift_rpc_server_unix(const char *path)
+{
+    static switch_sai_thrift_rpc_server_param_t param;
+
+    param.port = 0;
+    param.unix_socket = path;
+
+    std::cerr << "Starting SAI RPC server on unix socket " << path << std::endl;
+
+    return switch_sai_thrift_rpc_server_start(&param);
+}
 }
@@ -1,3 +1,4 @@
 extern "C" {
 int start_sai_thrift_rpc_server(int port);
+int start_sai_thrift_rpc_server_unix(const char *path);
 }
@@ -64,7 +64,11 @@ class ThriftInterface(BaseTest):
         else:
             server = 'localhost'
         
-        self.transport = TSocket.TSocket(server, 9092)
+        if self.test_params.has_key("unix_socket"):
+            # RPC server started with --unix-socket on the same host
+            self.transport = TSocket.TSocket(unix_socket=self.test_params['unix_socket'])
+        else:
+            self.transport = TSocket.TSocket(server, 9092)
         self.transport = TTransport.TBufferedTransport(self.transport)
         self.protocol = TBinaryProtocol.TBinaryProtocol(self.transport)
 
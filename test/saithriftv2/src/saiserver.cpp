@@ -119,6 +119,9 @@ struct cmdOptions
     std::string profileMapFile;
     std::string portMapFile;
     std::string initScript;
+    std::string unixSocket;
+    std::string rpcStatsFile;
+    int rpcStatsInterval;
 };
 
 cmdOptions handleCmdLine(int argc, char **argv)
@@ -126,6 +129,8 @@ cmdOptions handleCmdLine(int argc, char **argv)
 
     cmdOptions options = {};
 
+    options.rpcStatsInterval = 10;
+
     while(true)
     {
         static struct option long_options[] =
@@ -133,12 +138,15 @@ cmdOptions handleCmdLine(int argc, char **argv)
             { "profile",          required_argument, 0, 'p' },
             { "portmap",          required_argument, 0, 'f' },
             { "init-script",      required_argument, 0, 'S' },
+            { "unix-socket",      required_argument, 0, 'u' },
+            { "rpc-stats-file",   required_argument, 0, 'r' },
+            { "rpc-stats-interval", required_argument, 0, 'i' },
             { 0,                  0,                 0,  0  }
         };
 
         int option_index = 0;
 
-        int c = getopt_long(argc, argv, "p:f:S:", long_options, &option_index);
+        int c = getopt_long(argc, argv, "p:f:S:u:r:i:", long_options, &option_index);
 
         if (c == -1)
             break;
@@ -160,6 +168,21 @@ cmdOptions handleCmdLine(int argc, char **argv)
                 options.initScript = std::string(optarg);
                 break;
 
+            case 'u':
+                printf("rpc unix socket: %s\n", optarg);
+                options.unixSocket = std::string(optarg);
+                break;
+
+            case 'r':
+                printf("rpc stats file: %s\n", optarg);
+                options.rpcStatsFile = std::string(optarg);
+                break;
+
+            case 'i':
+                printf("rpc stats interval: %s\n", optarg);
+                options.rpcStatsInterval = atoi(optarg);
+                break;
+
             default:
                 printf("getopt_long failure\n");
                 exit(EXIT_FAILURE);
@@ -294,7 +317,19 @@ main(int argc, char* argv[])
 
     handleInitScript(options.initScript);
 
-    start_sai_thrift_rpc_server(SWITCH_SAI_THRIFT_RPC_SERVER_PORT);
+    if (options.unixSocket.size())
+    {
+        start_sai_thrift_rpc_server_unix(options.unixSocket.c_str());
+    }
+    else
+    {
+        start_sai_thrift_rpc_server(SWITCH_SAI_THRIFT_RPC_SERVER_PORT);
+    }
+
+    if (options.rpcStatsFile.size())
+    {
+        start_sai_rpc_stats_dump(options.rpcStatsFile.c_str(), options.rpcStatsInterval);
+    }
 
     const sai_log_level_t log_level = SAI_LOG_LEVEL_NOTICE;
 
@@ -1,4 +1,6 @@
 extern "C" {
 int start_p4_sai_thrift_rpc_server(char *port);
 int start_sai_thrift_rpc_server(int port);
+int start_sai_thrift_rpc_server_unix(const char *path);
+int start_sai_rpc_stats_dump(const char *path, int interval_sec);
 }